@@ -52,6 +52,7 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 
 #include "GridLib.h"
 #include "GridGraphLib.h"
+#include "nll_scat.h"
 
 //#define GMT_VER_5        // define this macro to generate GMT 5.x compatible script
 
@@ -2506,17 +2507,19 @@ int GenMapFileName(char *fname_xy, char *fname_xz, char *fname_zy,
 int Scat2GMT(char* fnroot_in, char* orientation, int ilonglat, char* fnscat_out) {
 
     char fnscat_in[FILENAME_MAX];
-    FILE *fp_scat_in, *fp_scat_out;
-    int npt, tot_npoints;
-    float fdata[4];
+    FILE *fp_scat_out;
+    int npt, nsamples_block;
+    float *fdata;
     double fdata0, fdata1;
     int or_xy, or_xz, or_yz, or_zy;
 
-    double hypox, hypoy;
+    // 20261018 AJL - scatter samples read and converted in blocks, compressed scatter containers (.scatz) supported
+    ScatterReader *scat_reader;
+    static float fblock[4 * SCAT_BLOCK_NSAMPLES];
+    static double dlat[SCAT_BLOCK_NSAMPLES], dlong[SCAT_BLOCK_NSAMPLES];
 
 
-    sprintf(fnscat_in, "%s.scat", fnroot_in);
-    if ((fp_scat_in = fopen(fnscat_in, "r")) == NULL) {
+    if ((scat_reader = OpenEventScatterReader(fnroot_in, fnscat_in)) == NULL) {
         fprintf(stderr, "ERROR: Cannot open scatter file `%s'.\n",
                 fnscat_in);
         return (-1);
@@ -2531,6 +2534,7 @@ int Scat2GMT(char* fnroot_in, char* orientation, int ilonglat, char* fnscat_out)
         fprintf(stderr,
                 "ERROR: Cannot open scatter output file `%s'.\n",
                 fnscat_out);
+        CloseScatterReader(scat_reader);
         return (-1);
     }
 
@@ -2544,35 +2548,33 @@ int Scat2GMT(char* fnroot_in, char* orientation, int ilonglat, char* fnscat_out)
     else if (strcmp(orientation, "ZY") == 0)
         or_zy = 1;
 
-    /* read header information */
-    fseek(fp_scat_in, 0, SEEK_SET);
-    fread(&tot_npoints, sizeof (int), 1, fp_scat_in);
-
-    /* skip header record */
-    fseek(fp_scat_in, 4 * sizeof (float), SEEK_SET);
-    for (npt = 0; npt < tot_npoints; npt++) {
-        fread(fdata, sizeof (float), 4, fp_scat_in);
-        convertCoordsRect(proj_index_input, proj_index_output,
-                fdata[0], fdata[1], &hypox, &hypoy);
-        fdata[0] = hypox;
-        fdata[1] = hypoy;
-        if (ilonglat) {
-            rect2latlon(proj_index_output, fdata[0], fdata[1], &fdata1, &fdata0);
-        } else {
-            fdata0 = (double) fdata[0];
-            fdata1 = (double) fdata[1];
+    while ((nsamples_block = ReadScatterBlock(scat_reader, fblock)) > 0) {
+        ScatterConvertCoordsRect(proj_index_input, proj_index_output, fblock, nsamples_block);
+        if (ilonglat)
+            ScatterRect2LatLon(proj_index_output, fblock, nsamples_block, dlat, dlong);
+        for (npt = 0; npt < nsamples_block; npt++) {
+            fdata = fblock + 4 * npt;
+            if (ilonglat) {
+                fdata1 = dlat[npt];
+                fdata0 = dlong[npt];
+            } else {
+                fdata0 = (double) fdata[0];
+                fdata1 = (double) fdata[1];
+            }
+            if (or_xy)
+                fprintf(fp_scat_out, "%f %f\n", fdata0, fdata1);
+            else if (or_xz)
+                fprintf(fp_scat_out, "%f %f\n", fdata0, fdata[2]);
+            else if (or_yz)
+                fprintf(fp_scat_out, "%f %f\n", fdata1, fdata[2]);
+            else if (or_zy)
+                fprintf(fp_scat_out, "%f %f\n", fdata[2], fdata1);
         }
-        if (or_xy)
-            fprintf(fp_scat_out, "%f %f\n", fdata0, fdata1);
-        else if (or_xz)
-            fprintf(fp_scat_out, "%f %f\n", fdata0, fdata[2]);
-        else if (or_yz)
-            fprintf(fp_scat_out, "%f %f\n", fdata1, fdata[2]);
-        else if (or_zy)
-            fprintf(fp_scat_out, "%f %f\n", fdata[2], fdata1);
     }
+    if (nsamples_block < 0)
+        fprintf(stderr, "ERROR: reading scatter file `%s'.\n", fnscat_in);
 
-    fclose(fp_scat_in);
+    CloseScatterReader(scat_reader);
     fclose(fp_scat_out);
 
     return (0);
@@ -63,6 +63,9 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 int grid_mode; /* grid mode - GRID_TIME, GRID_TIME_2D */
 
 int angle_mode; /* angle mode - ANGLE_MODE_NO, ANGLE_MODE_YES */
+int angle_fused; /* 20261018 AJL - 1 = angles calculated by sheet and streamed to disk, no angle grid in memory */
+
+#define ANGLE_FUSED_NUM_SHEETS 16 /* number of ix sheets calculated together for fused angles */
 
 
 
@@ -210,9 +213,15 @@ int get_grid_mode(char*);
 int get_gt_plfd(char*);
 int GenTimeGrid(GridDesc*, SourceDesc*, int, GridDesc*, char*);
 int GenAngleGrid(GridDesc*, SourceDesc*, GridDesc*, int);
+int GenAngleGridFused(GridDesc*, SourceDesc*, GridDesc*, int, char*, char*);
+void InitAngleGrid(GridDesc*, GridDesc*, char*);
 void InitTimeGrid(GridDesc*, GridDesc*);
 int RunGreen3d(GridDesc*, SourceDesc*, GridDesc*, char*);
 int ReadLineSensorPoints(char* fn_gt_linesrce);
+int GetCentroidSource(char* in_line);
+
+// event centroid sources (GTSRCE_CENTROID)
+#define MAX_NUM_CENTROID_HYP_FILES  10000
 
 
 
@@ -304,14 +313,14 @@ int main(int argc, char *argv[]) {
 
     if (angle_mode == ANGLE_MODE_YES) {
         if (grid_mode == GRID_TIME_2D)
-            DuplicateGrid(&angle_grid, &time_grid, "ANGLE2D");
+            InitAngleGrid(&angle_grid, &time_grid, "ANGLE2D");
         else
-            DuplicateGrid(&angle_grid, &time_grid, "ANGLE");
+            InitAngleGrid(&angle_grid, &time_grid, "ANGLE");
     } else if (angle_mode == ANGLE_MODE_INCLINATION) {
         if (grid_mode == GRID_TIME_2D)
-            DuplicateGrid(&angle_grid, &time_grid, "INCLINATION2D");
+            InitAngleGrid(&angle_grid, &time_grid, "INCLINATION2D");
         else
-            DuplicateGrid(&angle_grid, &time_grid, "INCLINATION");
+            InitAngleGrid(&angle_grid, &time_grid, "INCLINATION");
     }
 
     /* allocate model grids */
@@ -1116,6 +1125,82 @@ int GetNextLineSource(char* in_line) {
 
 }
 
+/** function to read event centroid source params from input line
+ *
+ * 20261018 AJL - added to support reciprocity location (NLLoc LOCRECIP): travel-time grids are
+ *    generated for a small set of event or cluster centroids instead of for each station,
+ *    NLLoc then reads station times from these source-side grids.
+ *
+ * GTSRCE_CENTROID <label> <hyp file list>
+ *    the centroid is the mean lat, long and depth of the located (not ABORTED or REJECTED)
+ *    hypocenters in all NLLoc .hyp files matching <hyp file list>
+ */
+
+int GetCentroidSource(char* in_line) {
+
+    int istat, nfile, num_files, num_hypo;
+    char label[MAXLINE], fn_hyp_in[FILENAME_MAX], srce_line[MAXLINE_LONG];
+    static char fn_hyp_list[MAX_NUM_CENTROID_HYP_FILES][FILENAME_MAX];
+    double dlat_sum = 0.0, dlong_sum = 0.0, depth_sum = 0.0;
+    FILE *fp_hyp;
+    HypoDesc hypo;
+
+
+    if ((istat = sscanf(in_line, "%s %s", label, fn_hyp_in)) != 2)
+        return (-1);
+
+    // check number of sources
+    if (NumSources >= MAX_NUM_SOURCES) {
+        nll_puterr2("ERROR: to many sources, ignoring source", label);
+        return (0);
+    }
+
+    if ((num_files = ExpandWildCards(fn_hyp_in, fn_hyp_list, MAX_NUM_CENTROID_HYP_FILES)) < 1) {
+        nll_puterr2("ERROR: no matching .hyp files found for centroid", fn_hyp_in);
+        return (-1);
+    }
+
+    num_hypo = 0;
+    for (nfile = 0; nfile < num_files; nfile++) {
+        if ((fp_hyp = fopen(fn_hyp_list[nfile], "r")) == NULL) {
+            nll_puterr2("ERROR: opening hypocenter file, ignoring file", fn_hyp_list[nfile]);
+            continue;
+        }
+        // loop over events in file
+        while ((istat = GetHypLoc(fp_hyp, NULL, &hypo, NULL, NULL, 0, NULL, 0)) != EOF) {
+            if (istat < 0) {
+                nll_puterr2("ERROR: reading hypocenter file, ignoring remainder of file", fn_hyp_list[nfile]);
+                break;
+            }
+            if (strcmp(hypo.locStat, "ABORTED") == 0 || strcmp(hypo.locStat, "REJECTED") == 0)
+                continue;
+            dlat_sum += hypo.dlat;
+            dlong_sum += hypo.dlong;
+            depth_sum += hypo.depth;
+            num_hypo++;
+        }
+        fclose(fp_hyp);
+    }
+
+    if (num_hypo < 1) {
+        nll_puterr2("ERROR: no located hypocenters found for centroid", fn_hyp_in);
+        return (-1);
+    }
+
+    // add centroid as standard LATLON source
+    snprintf(srce_line, sizeof (srce_line), "%s LATLON %lf %lf %lf 0.0", label,
+            dlat_sum / (double) num_hypo, dlong_sum / (double) num_hypo, depth_sum / (double) num_hypo);
+
+    sprintf(MsgStr,
+            "Grid2Time GTSRCE_CENTROID:  %d hypocenters in %d files: %s", num_hypo, num_files, srce_line);
+    nll_putmsg(2, MsgStr);
+
+    istat = GetNextSource(srce_line);
+
+    return (istat);
+
+}
+
 /*** function to read input file */
 
 int ReadGrid2TimeInput(FILE* fp_input) {
@@ -1218,6 +1303,20 @@ int ReadGrid2TimeInput(FILE* fp_input) {
         }
 
 
+        /* read event centroid source params */
+
+        if (strcmp(param, "GTSRCE_CENTROID") == 0) {
+            if ((istat = GetCentroidSource(strchr(line, ' '))) < 0) {
+                nll_puterr("ERROR: reading event centroid source params:");
+                nll_puterr(line);
+            } else {
+                flag_source = 1;
+                // flag as non-line sensor
+                IsLineSensor[NumSources - 1] = 0;
+            }
+        }
+
+
         if (strcmp(param, "GTGRID") == 0) {
             if ((istat = get_grid(strchr(line, ' '))) < 0)
                 fprintf(stderr,
@@ -1290,7 +1389,7 @@ int ReadGrid2TimeInput(FILE* fp_input) {
     if (!flag_grid_mode)
         nll_puterr("ERROR: no grid mode (GTMODE) params read.");
     if (!flag_source)
-        nll_puterr("ERROR: no source (GTSRCE or GTLINESRCE) params read.");
+        nll_puterr("ERROR: no source (GTSRCE, GTLINESRCE or GTSRCE_CENTROID) params read.");
     if (!flag_plfd && !flag_wavefront && !flag_fteik3d)
         nll_puterr(
             "ERROR: no Travel Time method (GT_PLFD, GT_WAVEFRONT_RAY, GT_FTEIK) params read.");
@@ -1338,12 +1437,13 @@ int get_gt_files(char* line1) {
 int get_grid_mode(char* line1) {
     char str_grid_mode[MAXLINE];
     char str_angle_mode[MAXLINE];
+    char str_fused[MAXLINE] = "";
 
 
-    sscanf(line1, "%s %s", str_grid_mode, str_angle_mode);
+    sscanf(line1, "%s %s %s", str_grid_mode, str_angle_mode, str_fused);
 
-    sprintf(MsgStr, "Grid2Time GTMODE:  %s  %s",
-            str_grid_mode, str_angle_mode);
+    sprintf(MsgStr, "Grid2Time GTMODE:  %s  %s  %s",
+            str_grid_mode, str_angle_mode, str_fused);
     nll_putmsg(3, MsgStr);
 
     if (strcmp(str_grid_mode, "GRID3D") == 0)
@@ -1368,6 +1468,15 @@ int get_grid_mode(char* line1) {
         return (-1);
     }
 
+    // 20261018 AJL - added optional fused angle mode
+    angle_fused = 0;
+    if (strcmp(str_fused, "ANGLES_FUSED") == 0)
+        angle_fused = 1;
+    else if (strlen(str_fused) > 0) {
+        nll_puterr2("ERROR: unrecognized GTMODE option", str_fused);
+        return (-1);
+    }
+
     return (0);
 
 }
@@ -1520,6 +1629,13 @@ int GenAngleGrid(GridDesc* ptgrid, SourceDesc* psource, GridDesc* pagrid, int an
             return (-1);
         }
 
+        /* fused, calculate angles by sheet and write directly to disk */
+        if (angle_fused) {
+            snprintf(filename, sizeof (filename), "%s.%s", fn_gt_output, psource->label);
+            return (GenAngleGridFused(ptgrid, psource, pagrid, angle_mode, filename,
+                    angle_mode == ANGLE_MODE_YES ? "angle" : "inclination"));
+        }
+
         /* run gradient take-off angle algorithm */
         if ((istat = CalcAnglesGradient(ptgrid, pagrid, angle_mode, grid_mode)) < 0)
             return (-1);
@@ -1557,6 +1673,106 @@ int GenAngleGrid(GridDesc* ptgrid, SourceDesc* psource, GridDesc* pagrid, int an
 
 }
 
+/*** function to generate take-off angle grid by ix sheet and write sheets directly to disk
+ *
+ *  the angle grid is not held in memory, blocks of ANGLE_FUSED_NUM_SHEETS sheets are calculated
+ *      (in parallel if OpenMP available) from the travel time grid in memory and appended to the buffer file
+ *  output files are identical to those written by GenAngleGrid() without GTMODE ANGLES_FUSED
+ *
+ * 20261018 AJL - added
+ */
+
+int GenAngleGridFused(GridDesc* ptgrid, SourceDesc* psource, GridDesc* pagrid, int angle_mode,
+        char* filename, char* file_type) {
+
+    int ix, ix0, nsheets, istat = 0, itemp;
+    long nyz;
+    char fname[FILENAME_MAX];
+    FILE *fpio;
+    GRID_FLOAT_TYPE *sheets;
+
+
+    sprintf(MsgStr, "Generating take-off angle grid (fused)...");
+    nll_putmsg(1, MsgStr);
+
+    nyz = (long) ptgrid->numy * (long) ptgrid->numz;
+    if ((sheets = (GRID_FLOAT_TYPE *) malloc(ANGLE_FUSED_NUM_SHEETS * nyz * sizeof (GRID_FLOAT_TYPE))) == NULL) {
+        nll_puterr("ERROR: allocating memory for take-off angle sheets.");
+        return (-1);
+    }
+
+    snprintf(fname, sizeof (fname), "%s.%s.buf", filename, file_type);
+    if ((fpio = fopen(fname, "w")) == NULL) {
+        nll_puterr2("ERROR: opening take-off angles buffer output file", fname);
+        free(sheets);
+        return (-1);
+    }
+    NumFilesOpen++;
+
+    /* all sheets are written, as for WriteGrid3dBuf(), 2D grids have values in ix = 0 sheet only */
+    for (ix0 = 0; ix0 < ptgrid->numx && istat == 0; ix0 += ANGLE_FUSED_NUM_SHEETS) {
+        nsheets = ptgrid->numx - ix0;
+        if (nsheets > ANGLE_FUSED_NUM_SHEETS)
+            nsheets = ANGLE_FUSED_NUM_SHEETS;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(min:istat)
+#endif
+        for (ix = 0; ix < nsheets; ix++) {
+            if (CalcAnglesGradientSheet(ptgrid, sheets + (long) ix * nyz, ix0 + ix, angle_mode, grid_mode) < 0)
+                istat = -1;
+        }
+        if (istat == 0 && fwrite((char *) sheets, nsheets * nyz * sizeof (GRID_FLOAT_TYPE), 1, fpio) != 1) {
+            nll_puterr2("ERROR: writing take-off angles buffer output file", fname);
+            istat = -1;
+        }
+    }
+
+    fclose(fpio);
+    NumFilesOpen--;
+    free(sheets);
+
+    if (istat < 0) {
+        nll_puterr("ERROR: calculating take-off angles.");
+        return (-1);
+    }
+
+    sprintf(MsgStr,
+            "Finished calculation, take-off angles grid output files: %s.*",
+            filename);
+    nll_putmsg(1, MsgStr);
+
+    /* need only ix=0 sheet for 2D grids */
+    itemp = pagrid->numx;
+    if (grid_mode == GRID_TIME_2D)
+        pagrid->numx = 1;
+    istat = WriteGrid3dHdr(pagrid, psource, filename, file_type);
+    pagrid->numx = itemp;
+    if (istat < 0) {
+        nll_puterr("ERROR: writing take-off angles grid header to disk.");
+        return (-1);
+    }
+
+    return (0);
+
+}
+
+/*** function to initialize take-off angle grid description, grid memory is allocated only if angles not fused */
+
+void InitAngleGrid(GridDesc* pagrid, GridDesc* ptgrid, char* chr_type) {
+
+    if (!angle_fused) {
+        DuplicateGrid(pagrid, ptgrid, chr_type);
+        return;
+    }
+
+    *pagrid = *ptgrid;
+    strcpy(pagrid->chr_type, chr_type);
+    convert_grid_type(pagrid, 1);
+    pagrid->buffer = NULL;
+    pagrid->array = NULL;
+
+}
+
 /*------------------------------------------------------------/ */
 /* Anthony Lomax           | email: lomax@faille.unice.fr     / */
 /* UMR Geosciences Azur    | web: www-geoazur.unice.fr/~lomax / */
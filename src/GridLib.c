@@ -46,6 +46,22 @@ e-mail: anthony@alomax.net  web: http://www.alomax.net
 
 
 #include "GridLib.h"
+#include "nll_prof.h"
+#include "nll_gridcache.h"
+
+#include <stdint.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// 20261018 AJL - SSE/AVX byte swapping, selected at run time, does not require compiling for a specific instruction set
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GRID_SWAP_BYTES_X86
+#endif
+
+#define GRID_READ_CHUNK_SIZE (16L * 1024L * 1024L)  // bytes read and byte-swapped in one pass, multiple of page size
 
 // define globals
 
@@ -951,6 +967,7 @@ void setCascadingGrid(GridDesc* pgrid) {
     // flag dynamic arrays as uninitialized
     pgrid->gridDesc_Cascading.xyz_scale = NULL;
     pgrid->gridDesc_Cascading.zindex = NULL;
+    pgrid->gridDesc_Cascading.zlevel = NULL;
 
 }
 
@@ -1054,6 +1071,59 @@ int WriteGrid3dHdr(GridDesc* pgrid, SourceDesc* psrce,
 
 //#define DEBUG_CASC
 
+/** function to set interpolation parameters for each regular grid z index of Cascading 3D grid
+ *
+ * 20261018 AJL - added, moves z index scans and rescale index limits out of ReadGrid3dValue_Cascading_Interp()
+ */
+int SetCascadingZLevels(GridDesc* pgrid) {
+
+    int *zindex = pgrid->gridDesc_Cascading.zindex;
+    int *xyz_scale = pgrid->gridDesc_Cascading.xyz_scale;
+    CascadingZLevel *pzlevel;
+    int iz, iz_test;
+
+    pgrid->gridDesc_Cascading.zlevel = (CascadingZLevel *) malloc((size_t) (pgrid->numz * sizeof (CascadingZLevel)));
+    if (pgrid->gridDesc_Cascading.zlevel == NULL)
+        return (-1);
+    NumAllocations++;
+
+    for (iz = 0; iz < pgrid->numz; iz++) {
+        pzlevel = pgrid->gridDesc_Cascading.zlevel + iz;
+        pzlevel->xyz_scale = xyz_scale[iz];
+        pzlevel->iz0_casc = zindex[iz];
+        // check if scale changes in next cascading grid level
+        pzlevel->irescale = 0;
+        if (iz < pgrid->numz - 2) {
+            // find first regular z index in next cascading grid level
+            iz_test = iz + 1;
+            while (iz_test < pgrid->numz - 1 && zindex[iz_test] == pzlevel->iz0_casc) {
+                iz_test++;
+            }
+            pzlevel->irescale = xyz_scale[iz_test] > pzlevel->xyz_scale;
+        }
+        pzlevel->xy_scale_use = pzlevel->irescale ? 2 * pzlevel->xyz_scale : pzlevel->xyz_scale;
+        // includes fractional final casc grid node if xyz_scale != 1
+        pzlevel->ixmax_up = (pgrid->numx - 1) / pzlevel->xyz_scale + ((pgrid->numx - 1) % pzlevel->xyz_scale == 0 ? 0 : 1);
+        pzlevel->iymax_up = (pgrid->numy - 1) / pzlevel->xyz_scale + ((pgrid->numy - 1) % pzlevel->xyz_scale == 0 ? 0 : 1);
+        pzlevel->ixmax_dn = (pgrid->numx - 1) / pzlevel->xy_scale_use + ((pgrid->numx - 1) % pzlevel->xy_scale_use == 0 ? 0 : 1);
+        pzlevel->iymax_dn = (pgrid->numy - 1) / pzlevel->xy_scale_use + ((pgrid->numy - 1) % pzlevel->xy_scale_use == 0 ? 0 : 1);
+        pzlevel->iz1_casc = pzlevel->iz0_casc + 1;
+        if (pzlevel->iz1_casc > zindex[pgrid->numz - 1]) {
+            pzlevel->iz1_casc = zindex[pgrid->numz - 1];
+        }
+        pzlevel->lastx = ((pgrid->numx - 1) / pzlevel->xy_scale_use) * pzlevel->xy_scale_use;
+        pzlevel->lasty = ((pgrid->numy - 1) / pzlevel->xy_scale_use) * pzlevel->xy_scale_use;
+        // find regular grid z steps to reach upper limit
+        iz_test = iz;
+        while (iz_test > 0 && zindex[iz_test - 1] == pzlevel->iz0_casc) {
+            iz_test--;
+        }
+        pzlevel->iz_top = iz_test;
+    }
+
+    return (0);
+}
+
 /** function to allocate buffer for Cascading 3D grid
  *
  * 20161019 AJL - added
@@ -1131,6 +1201,9 @@ void* AllocateGrid_Cascading(GridDesc* pgrid, int allocate_buffer) {
         merge_factor *= 2; // creates a new cascade level
     }
     //pgrid->gridDesc_Cascading.num_z_cascading = pgrid->gridDesc_Cascading.zindex[pgrid->numz - 1];
+    if (SetCascadingZLevels(pgrid) < 0) {
+        nll_puterr("ERROR: AllocateGrid_Cascading: allocating cascading grid z level array.");
+    }
     pgrid->buffer_size = (size_t) (size_casc_grid * sizeof (GRID_FLOAT_TYPE));
     // DEBUG pgrid->buffer_size -= 128  * sizeof (GRID_FLOAT_TYPE);
     if (allocate_buffer) {
@@ -1266,6 +1339,11 @@ void FreeGrid_Cascading(GridDesc * pgrid) {
         NumAllocations--;
     }
     pgrid->gridDesc_Cascading.xyz_scale = NULL;
+    if (pgrid->gridDesc_Cascading.zlevel != NULL) {
+        free(pgrid->gridDesc_Cascading.zlevel);
+        pgrid->gridDesc_Cascading.zlevel = NULL;
+        NumAllocations--;
+    }
 }
 
 /** function to free buffer for 3D grid ***/
@@ -2074,64 +2152,245 @@ int ConvertOctTree2Grid(Tree3D* tree, double dx, double dy, double dz, char *gri
 
 }
 
+/** function to reverse byte order of 4-byte words */
+
+static void swap_bytes_scalar(GRID_FLOAT_TYPE *buffer, long nwords) {
+
+    long n;
+    uint32_t word;
+
+    for (n = 0; n < nwords; n++) {
+        memcpy(&word, buffer + n, sizeof (word));
+        word = (word >> 24) | ((word >> 8) & 0x0000ff00u) | ((word << 8) & 0x00ff0000u) | (word << 24);
+        memcpy(buffer + n, &word, sizeof (word));
+    }
+
+}
+
+#ifdef GRID_SWAP_BYTES_X86
+
+/** function to reverse byte order of 4-byte words using SSSE3 shuffles, returns number of words swapped */
+
+__attribute__((target("ssse3")))
+static long swap_bytes_ssse3(GRID_FLOAT_TYPE *buffer, long nwords) {
+
+    long n;
+    __m128i shuffle, words;
+
+    shuffle = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    for (n = 0; n + 4 <= nwords; n += 4) {
+        words = _mm_loadu_si128((__m128i *) (buffer + n));
+        _mm_storeu_si128((__m128i *) (buffer + n), _mm_shuffle_epi8(words, shuffle));
+    }
+
+    return (n);
+
+}
+
+/** function to reverse byte order of 4-byte words using AVX2 shuffles, returns number of words swapped */
+
+__attribute__((target("avx2")))
+static long swap_bytes_avx2(GRID_FLOAT_TYPE *buffer, long nwords) {
+
+    long n;
+    __m256i shuffle, words0, words1;
+
+    shuffle = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+            12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    for (n = 0; n + 16 <= nwords; n += 16) {
+        words0 = _mm256_loadu_si256((__m256i *) (buffer + n));
+        words1 = _mm256_loadu_si256((__m256i *) (buffer + n + 8));
+        _mm256_storeu_si256((__m256i *) (buffer + n), _mm256_shuffle_epi8(words0, shuffle));
+        _mm256_storeu_si256((__m256i *) (buffer + n + 8), _mm256_shuffle_epi8(words1, shuffle));
+    }
+
+    return (n);
+
+}
+
+#endif
+
 /** function to swap bytes in grid buffer ***/
 
+// 20261018 AJL - swap whole 4-byte words, with SSSE3 or AVX2 shuffles if supported by cpu
+
 int swapBytes(GRID_FLOAT_TYPE *buffer, long bufsize) {
 
-    GRID_FLOAT_TYPE *bufpos;
-    char ctmp;
-    unsigned short itmp;
+    long nswapped = 0;
 
-    union {
-        char cval[4];
-        unsigned short ival[2];
-        float fval;
-    }
-    bufval;
+#ifdef GRID_SWAP_BYTES_X86
+    if (__builtin_cpu_supports("avx2"))
+        nswapped = swap_bytes_avx2(buffer, bufsize);
+    else if (__builtin_cpu_supports("ssse3"))
+        nswapped = swap_bytes_ssse3(buffer, bufsize);
+#endif
+    swap_bytes_scalar(buffer + nswapped, bufsize - nswapped);
+
+    return (0);
+}
+
+/** function to read grid buffer from file in chunks, swapping bytes of each chunk after it is read
+ *
+ *  large buffers of regular files are read with pread() by several threads, the file position is then set
+ *  to the end of the buffer as for a single fread()
+ */
 
+static int read_grid_buf_chunks(char *buffer, long readsize, FILE *fpio, int iSwapBytes) {
 
-    bufpos = buffer;
-    while (bufpos < buffer + bufsize) {
+    long offset, chunksize;
+
+#ifndef _WIN32
+    int fd, nchunk, nchunks, nerror;
+    off_t base;
+    ssize_t nread;
+    long ndone;
+
+    fd = fileno(fpio);
+    if (readsize > GRID_READ_CHUNK_SIZE && fd >= 0 && (base = ftello(fpio)) >= 0) {
+        nchunks = (int) ((readsize + GRID_READ_CHUNK_SIZE - 1) / GRID_READ_CHUNK_SIZE);
+        nerror = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) private(offset, chunksize, ndone, nread) reduction(+:nerror)
+#endif
+        for (nchunk = 0; nchunk < nchunks; nchunk++) {
+            offset = (long) nchunk * GRID_READ_CHUNK_SIZE;
+            chunksize = readsize - offset < GRID_READ_CHUNK_SIZE ? readsize - offset : GRID_READ_CHUNK_SIZE;
+            for (ndone = 0; ndone < chunksize; ndone += nread) {
+                if ((nread = pread(fd, buffer + offset + ndone, chunksize - ndone, base + offset + ndone)) <= 0)
+                    break;
+            }
+            if (ndone < chunksize)
+                nerror++;
+            else if (iSwapBytes)
+                swapBytes((GRID_FLOAT_TYPE *) (buffer + offset), chunksize / sizeof (GRID_FLOAT_TYPE));
+        }
+        if (nerror > 0)
+            return (-1);
+        fseeko(fpio, base + readsize, SEEK_SET);
+        return (0);
+    }
+#endif
 
-        bufval.fval = *bufpos;
-        ctmp = bufval.cval[0];
-        bufval.cval[0] = bufval.cval[1];
-        bufval.cval[1] = ctmp;
-        ctmp = bufval.cval[2];
-        bufval.cval[2] = bufval.cval[3];
-        bufval.cval[3] = ctmp;
-        itmp = bufval.ival[0];
-        bufval.ival[0] = bufval.ival[1];
-        bufval.ival[1] = itmp;
-        *bufpos = bufval.fval;
-        bufpos++;
+    for (offset = 0; offset < readsize; offset += chunksize) {
+        chunksize = readsize - offset < GRID_READ_CHUNK_SIZE ? readsize - offset : GRID_READ_CHUNK_SIZE;
+        if (fread(buffer + offset, chunksize, 1, fpio) != 1)
+            return (-1);
+        if (iSwapBytes)
+            swapBytes((GRID_FLOAT_TYPE *) (buffer + offset), chunksize / sizeof (GRID_FLOAT_TYPE));
     }
 
     return (0);
+
+}
+
+/** function to get name of native byte order copy of a byte-swapped grid buffer file
+ *
+ *  returns 1 if the copy exists and is up to date, 0 if not, -1 if the grid buffer file is unknown
+ */
+
+static int native_grid_copy(GridDesc* pgrid, long readsize, char *fn_native) {
+
+    char fn_grid[FILENAME_MAX];
+    struct stat stat_grid, stat_native;
+
+    snprintf(fn_grid, sizeof (fn_grid), "%s.buf", pgrid->title);
+    if (stat(fn_grid, &stat_grid) != 0 || (long) stat_grid.st_size < readsize)
+        return (-1);
+    snprintf(fn_native, FILENAME_MAX, "%s.native.buf", pgrid->title);
+    if (stat(fn_native, &stat_native) != 0 || (long) stat_native.st_size != readsize
+            || stat_native.st_mtime < stat_grid.st_mtime)
+        return (0);
+
+    return (1);
+
+}
+
+/** function to write native byte order copy of grid buffer, written to temporary file then renamed */
+
+static void write_native_grid_copy(GridDesc* pgrid, long readsize, char *fn_native) {
+
+    char fn_tmp[FILENAME_MAX];
+    FILE *fp_tmp;
+    int istat;
+
+#ifndef _WIN32
+    snprintf(fn_tmp, sizeof (fn_tmp), "%s.%ld.tmp", fn_native, (long) getpid());
+#else
+    snprintf(fn_tmp, sizeof (fn_tmp), "%s.tmp", fn_native);
+#endif
+    if ((fp_tmp = fopen(fn_tmp, "w")) == NULL) {
+        sprintf(MsgStr, "WARNING: cannot open native byte order grid copy file: %s", fn_tmp);
+        nll_putmsg(2, MsgStr);
+        return;
+    }
+    istat = fwrite(pgrid->buffer, readsize, 1, fp_tmp) == 1;
+    istat = fclose(fp_tmp) == 0 && istat;
+    if (!istat || rename(fn_tmp, fn_native) != 0) {
+        sprintf(MsgStr, "WARNING: cannot write native byte order grid copy file: %s", fn_native);
+        nll_putmsg(2, MsgStr);
+        remove(fn_tmp);
+        return;
+    }
+    if (message_flag >= 2) {
+        sprintf(MsgStr, "INFO: native byte order grid copy written: %s", fn_native);
+        nll_putmsg(2, MsgStr);
+    }
+
 }
 
 /** function to read entire grid buffer from disk ***/
 
+// 20261018 AJL - grid read in chunks, each chunk byte-swapped after it is read
+//    if iSwapBytes == 2 a native byte order copy of the grid buffer file (<root>.native.buf) is read if up to date,
+//    otherwise written after the grid is read and byte-swapped
+
 int ReadGrid3dBuf(GridDesc* pgrid, FILE * fpio) {
 
     long readsize;
+    int native_copy = -1;
+    char fn_native[FILENAME_MAX];
+    FILE *fp_native;
 
 
 
     // 20161021 AJL  readsize = pgrid->numx * pgrid->numy * pgrid->numz * sizeof (GRID_FLOAT_TYPE);
     readsize = pgrid->buffer_size;
 
+    NLL_PROF_START(t_prof);
+
+    /* read native byte order copy of grid buffer */
+
+    if (pgrid->iSwapBytes == 2 && (native_copy = native_grid_copy(pgrid, readsize, fn_native)) == 1) {
+        if ((fp_native = fopen(fn_native, "r")) != NULL) {
+            if (read_grid_buf_chunks((char *) pgrid->buffer, readsize, fp_native, 0) == 0) {
+                fclose(fp_native);
+                fseek(fpio, readsize, SEEK_CUR);
+                if (message_flag >= 3) {
+                    sprintf(MsgStr, "INFO: native byte order grid copy read: %s", fn_native);
+                    nll_putmsg(3, MsgStr);
+                }
+                NLL_PROF_STOP(PROF_T_GRID_READ, t_prof);
+                NLL_PROF_COUNT(PROF_C_BYTES_READ, readsize);
+                return (0);
+            }
+            fclose(fp_native);
+        }
+        native_copy = 0;
+    }
+
     /* read from grid file to buffer */
 
-    int ireturn;
-    if ((ireturn = fread((char *) pgrid->buffer, readsize, 1, fpio)) != 1) {
-        printf("DEBUG: pgrid->buffer %ld, readsize %ld, fpio %ld, ireturn %d\n", (long) pgrid->buffer, readsize, (long) fpio, ireturn);
+    if (read_grid_buf_chunks((char *) pgrid->buffer, readsize, fpio, pgrid->iSwapBytes) < 0) {
+        printf("DEBUG: pgrid->buffer %ld, readsize %ld, fpio %ld\n", (long) pgrid->buffer, readsize, (long) fpio);
         nll_puterr2("ERROR: reading grid file", pgrid->title);
         return (-1);
     }
 
-    if (pgrid->iSwapBytes)
-        swapBytes(pgrid->buffer, readsize / sizeof (float));
+    if (native_copy == 0)
+        write_native_grid_copy(pgrid, readsize, fn_native);
+
+    NLL_PROF_STOP(PROF_T_GRID_READ, t_prof);
+    NLL_PROF_COUNT(PROF_C_BYTES_READ, readsize);
 
     return (0);
 }
@@ -2172,6 +2431,7 @@ int ReadGrid3dBufSheet(GRID_FLOAT_TYPE* sheetbuf, GridDesc* pgrid_disk,
         nll_puterr("ERROR: reading x-sheet grid file.");
         return (-1);
     }
+    NLL_PROF_COUNT(PROF_C_BYTES_READ, readsize);
 
     if (pgrid_disk->iSwapBytes)
         swapBytes(sheetbuf, readsize / sizeof (GRID_FLOAT_TYPE));
@@ -2300,6 +2560,8 @@ int OpenGrid3dFile(char *fname, FILE **fp_grid, FILE **fp_hdr,
 
     char fn_grid[FILENAME_MAX], fn_hdr[FILENAME_MAX];
 
+    NLL_PROF_START(t_prof); // only successful opens are timed
+
     /* open grid file and header file */
 
     sprintf(fn_grid, "%s.buf", fname);
@@ -2377,23 +2639,17 @@ int OpenGrid3dFile(char *fname, FILE **fp_grid, FILE **fp_hdr,
     char line[MAXLINE_LONG];
     char tag[MAXLINE_LONG];
 
-    // check for map projection
+    // check for map projection and if cascading grid
+    // 20261018 AJL - single pass over header lines
     strcpy(pgrid->mapProjStr, "");
-    rewind(*fp_hdr);
-    while (fgets(line, MAXLINE_LONG, *fp_hdr) != NULL) {
-        int istat = sscanf(line, "%s", tag);
-        if (istat == 1 && strcmp(tag, "TRANSFORM") == 0) {
-            strcpy(pgrid->mapProjStr, line);
-        }
-    }
-
-    // check if cascading grid
     pgrid->flagGridCascading = IS_NOT_CASCADING;
     int num_z_merge_depths;
     rewind(*fp_hdr);
     while (fgets(line, MAXLINE_LONG, *fp_hdr) != NULL) {
         int istat = sscanf(line, "%s %d", tag, &num_z_merge_depths);
-        if (istat == 2 && strcmp(tag, "CASCADING_GRID") == 0) {
+        if (istat >= 1 && strcmp(tag, "TRANSFORM") == 0) {
+            strcpy(pgrid->mapProjStr, line);
+        } else if (istat == 2 && strcmp(tag, "CASCADING_GRID") == 0) {
             setCascadingGrid(pgrid);
             pgrid->gridDesc_Cascading.num_z_merge_depths = num_z_merge_depths;
             if (pgrid->gridDesc_Cascading.num_z_merge_depths > MAX_NUM_Z_MERGE_DEPTHS) {
@@ -2417,7 +2673,7 @@ int OpenGrid3dFile(char *fname, FILE **fp_grid, FILE **fp_hdr,
         }
     }
 
-
+    NLL_PROF_STOP(PROF_T_GRID_OPEN, t_prof);
 
     return (0);
 
@@ -2471,10 +2727,9 @@ GRID_FLOAT_TYPE * ReadGridFile
         int iSwapBytes, // flag to indicate if hi and low bytes of input velocity grid file should be swapped (1=swap, 0=no swap)
         SourceDesc* psrceIn // station source to use instead of srce in grid file (use only for station=DEFAULT 2D grids, use NULL otherwise)
         ) {
-    int istat, i;
-    FILE *fp_grid, *fp_hdr;
+    int i;
+    GridFileHandle *phandle;
     GridDesc gdesc;
-    SourceDesc srce;
     SourceDesc* psrce_use;
     double yval_grid;
 
@@ -2484,8 +2739,9 @@ GRID_FLOAT_TYPE * ReadGridFile
         values[i] = -VERY_LARGE_FLOAT;
 
 
-    // open grid file
-    if ((istat = OpenGrid3dFile(fname, &fp_grid, &fp_hdr, &gdesc, file_type, &srce, iSwapBytes)) < 0) {
+    // get grid file from cache
+    // 20261018 AJL - use cached grid file handle, header read and file opened once per grid file
+    if ((phandle = OpenCachedGrid3dFile(fname, file_type, iSwapBytes)) == NULL) {
         if (message_flag >= 3) {
             sprintf(MsgStr, "WARNING: cannot open grid file: %s", fname);
             nll_putmsg(3, MsgStr);
@@ -2493,9 +2749,11 @@ GRID_FLOAT_TYPE * ReadGridFile
         return (values);
     }
 
+    LockCachedGrid3dFile(phandle);
+    gdesc = phandle->grid;
     if (gdesc.type == GRID_TIME_2D || gdesc.type == GRID_ANGLE_2D) {
         // 2D grid (1D model)
-        psrce_use = &srce;
+        psrce_use = &phandle->srce;
         if (psrceIn != NULL) {
             psrce_use = psrceIn;
         }
@@ -2508,20 +2766,22 @@ GRID_FLOAT_TYPE * ReadGridFile
             yval_grid = GetEpiDist(psrce_use, xloc[i], yloc[i]);
             if (GeometryMode == MODE_GLOBAL)
                 yval_grid *= KM2DEG;
-            values[i] = ReadAbsInterpGrid2d(fp_grid, &gdesc, yval_grid, zloc[i]);
+            values[i] = ReadAbsInterpGrid2d(phandle->fp_grid, &gdesc, yval_grid, zloc[i]);
             //            printf("DEBUG: yval_grid=%f xloc[i]=%f yloc[i]=%f zloc[i]=%f values[i]=%f\n", yval_grid, xloc[i], yloc[i], zloc[i], values[i]);
         }
     } else {
         // 3D grid
         for (i = 0; i < nvalues; i++) {
             // get GRID_FLOAT_TYPE value on grid
-            values[i] = ReadAbsInterpGrid3d(fp_grid, &gdesc, xloc[i], yloc[i], zloc[i], 0);
+            values[i] = ReadAbsInterpGrid3d(phandle->fp_grid, &gdesc, xloc[i], yloc[i], zloc[i], 0);
         }
     }
 
 
-    // close grid file
-    CloseGrid3dFile(&gdesc, &fp_grid, &fp_hdr);
+    UnlockCachedGrid3dFile(phandle);
+
+    // release grid file
+    CloseCachedGrid3dFile(phandle);
 
     return (values);
 
@@ -2558,6 +2818,7 @@ GRID_FLOAT_TYPE ReadCascadingGrid3dValue(FILE *fpgrid, int ix_casc, int iy_casc,
         }
         if (pgrid->iSwapBytes)
             swapBytes(&fvalue, 1);
+        NLL_PROF_COUNT(PROF_C_BYTES_READ, sizeof (GRID_FLOAT_TYPE));
     } else {
         fvalue = ((GRID_FLOAT_TYPE ***) pgrid->array)[ix_casc][iy_casc][iz_casc];
     }
@@ -2565,6 +2826,125 @@ GRID_FLOAT_TYPE ReadCascadingGrid3dValue(FILE *fpgrid, int ix_casc, int iy_casc,
     return (fvalue);
 }
 
+/** function to read cascading grid data from disk or array at interpolated point corresponding to regular grid index location
+ *  using precomputed z level interpolation parameters
+ *
+ * 20261018 AJL - added, same result as ReadGrid3dValue_Cascading_Interp() without z index scans, requires pgrid->array and
+ *      pgrid->gridDesc_Cascading.zlevel
+ *
+ *  ix_dbl, iy_dbl, iz_dbl are indices in virtual, regular grid equivalent to this cascading grid, must be in range
+ */
+
+GRID_FLOAT_TYPE ReadGrid3dValue_Cascading_ZLevel(FILE *fpgrid, double ix_dbl, double iy_dbl, double iz_dbl, GridDesc * pgrid) {
+
+    int ix = (int) ix_dbl;
+    int iy = (int) iy_dbl;
+    int iz = (int) iz_dbl;
+
+    CascadingZLevel *pzlevel = pgrid->gridDesc_Cascading.zlevel + iz;
+    int xyz_scale = pzlevel->xyz_scale;
+    int xy_scale_use = pzlevel->xy_scale_use;
+
+    // set upper x,y,z indices in cascading grid
+    int iz0_casc = pzlevel->iz0_casc;
+    int iz1_casc = pzlevel->iz1_casc;
+    int ix0_casc = ix / xyz_scale;
+    int iy0_casc = iy / xyz_scale;
+
+    int ix0_casc_up, iy0_casc_up, ix0_casc_dn, iy0_casc_dn;
+    int ix1_casc_up, iy1_casc_up, ix1_casc_dn, iy1_casc_dn;
+    if (pzlevel->irescale) { // change of grid size
+        // x
+        ix0_casc_up = 2 * (ix0_casc / 2);
+        ix1_casc_up = ix0_casc_up + 2;
+        if (ix1_casc_up > pzlevel->ixmax_up) {
+            ix1_casc_up = pzlevel->ixmax_up;
+        }
+        ix0_casc_dn = ix0_casc_up / 2;
+        ix1_casc_dn = ix0_casc_dn + 1;
+        if (ix1_casc_dn > pzlevel->ixmax_dn) {
+            ix1_casc_dn = pzlevel->ixmax_dn;
+        }
+        // y
+        iy0_casc_up = 2 * (iy0_casc / 2);
+        iy1_casc_up = iy0_casc_up + 2;
+        if (iy1_casc_up > pzlevel->iymax_up) {
+            iy1_casc_up = pzlevel->iymax_up;
+        }
+        iy0_casc_dn = iy0_casc_up / 2;
+        iy1_casc_dn = iy0_casc_dn + 1;
+        if (iy1_casc_dn > pzlevel->iymax_dn) {
+            iy1_casc_dn = pzlevel->iymax_dn;
+        }
+    } else {
+        // x
+        ix0_casc_up = ix0_casc_dn = ix0_casc;
+        ix1_casc_up = ix0_casc + 1;
+        if (ix1_casc_up >= pgrid->numx) {
+            ix1_casc_up = pgrid->numx - 1;
+        }
+        ix1_casc_dn = ix1_casc_up;
+        // y
+        iy0_casc_up = iy0_casc_dn = iy0_casc;
+        iy1_casc_up = iy0_casc + 1;
+        if (iy1_casc_up >= pgrid->numy) {
+            iy1_casc_up = pgrid->numy - 1;
+        }
+        iy1_casc_dn = iy1_casc_up;
+    }
+
+    DOUBLE xdiff, ydiff, zdiff;
+    if (ix > pzlevel->lastx) { // casc grid cell is truncated in x relative to cell of size xy_scale_use reg grid cells
+        xdiff = (ix_dbl - (DOUBLE) pzlevel->lastx) / (DOUBLE) (pgrid->numx - 1 - pzlevel->lastx);
+    } else {
+        xdiff = fmod(ix_dbl, (DOUBLE) xy_scale_use) / (DOUBLE) xy_scale_use;
+    }
+    if (iy > pzlevel->lasty) { // casc grid cell is truncated in y relative to cell of size xy_scale_use reg grid cells
+        ydiff = (iy_dbl - (DOUBLE) pzlevel->lasty) / (DOUBLE) (pgrid->numy - 1 - pzlevel->lasty);
+    } else {
+        ydiff = fmod(iy_dbl, (DOUBLE) xy_scale_use) / (DOUBLE) xy_scale_use;
+    }
+    zdiff = (iz_dbl - (DOUBLE) pzlevel->iz_top) / (DOUBLE) xyz_scale;
+
+    if (xdiff < 0.0 || xdiff > 1.0 || ydiff < 0.0 || ydiff > 1.0 || zdiff < 0.0 || zdiff > 1.0) {
+        return (-VERY_LARGE_FLOAT);
+    }
+
+    DOUBLE vval000, vval001, vval010, vval011, vval100, vval101, vval110, vval111;
+    if (fpgrid != NULL) {
+        vval000 = ReadCascadingGrid3dValue(fpgrid, ix0_casc_up, iy0_casc_up, iz0_casc, pgrid);
+        vval001 = ReadCascadingGrid3dValue(fpgrid, ix0_casc_dn, iy0_casc_dn, iz1_casc, pgrid);
+        vval010 = ReadCascadingGrid3dValue(fpgrid, ix0_casc_up, iy1_casc_up, iz0_casc, pgrid);
+        vval011 = ReadCascadingGrid3dValue(fpgrid, ix0_casc_dn, iy1_casc_dn, iz1_casc, pgrid);
+        vval100 = ReadCascadingGrid3dValue(fpgrid, ix1_casc_up, iy0_casc_up, iz0_casc, pgrid);
+        vval101 = ReadCascadingGrid3dValue(fpgrid, ix1_casc_dn, iy0_casc_dn, iz1_casc, pgrid);
+        vval110 = ReadCascadingGrid3dValue(fpgrid, ix1_casc_up, iy1_casc_up, iz0_casc, pgrid);
+        vval111 = ReadCascadingGrid3dValue(fpgrid, ix1_casc_dn, iy1_casc_dn, iz1_casc, pgrid);
+    } else {
+        GRID_FLOAT_TYPE ***array = (GRID_FLOAT_TYPE ***) pgrid->array;
+        vval000 = array[ix0_casc_up][iy0_casc_up][iz0_casc];
+        vval001 = array[ix0_casc_dn][iy0_casc_dn][iz1_casc];
+        vval010 = array[ix0_casc_up][iy1_casc_up][iz0_casc];
+        vval011 = array[ix0_casc_dn][iy1_casc_dn][iz1_casc];
+        vval100 = array[ix1_casc_up][iy0_casc_up][iz0_casc];
+        vval101 = array[ix1_casc_dn][iy0_casc_dn][iz1_casc];
+        vval110 = array[ix1_casc_up][iy1_casc_up][iz0_casc];
+        vval111 = array[ix1_casc_dn][iy1_casc_dn][iz1_casc];
+    }
+
+    // check for invalid / mask nodes
+    if (pgrid->type != GRID_SSST_TIMECORR) {
+        if (vval000 < 0.0 || vval010 < 0.0 || vval100 < 0.0 || vval110 < 0.0
+                || vval001 < 0.0 || vval011 < 0.0 || vval101 < 0.0 || vval111 < 0.0) {
+            return (-VERY_LARGE_FLOAT);
+        }
+    }
+
+    return (InterpCubeLagrange(xdiff, ydiff, zdiff,
+            vval000, vval001, vval010, vval011,
+            vval100, vval101, vval110, vval111));
+}
+
 /** function to read cascading grid data from disk or array at interpolated point corresponding to regular grid index location
  *
  * 20161021 AJL - added
@@ -2585,6 +2965,11 @@ GRID_FLOAT_TYPE ReadGrid3dValue_Cascading_Interp(FILE *fpgrid, double ix_dbl, do
         return (-VERY_LARGE_FLOAT);
     }
 
+    // 20261018 AJL - use precomputed z level interpolation parameters if grid array available
+    if (pgrid->array != NULL && pgrid->gridDesc_Cascading.zlevel != NULL) {
+        return (ReadGrid3dValue_Cascading_ZLevel(fpgrid, ix_dbl, iy_dbl, iz_dbl, pgrid));
+    }
+
     // need grid array to find offset
     int created_grid_array_cascading = 0;
     int allocated_grid_cascading = 0;
@@ -2850,6 +3235,7 @@ GRID_FLOAT_TYPE ReadGrid3dValue(FILE *fpgrid, int ix, int iy, int iz, GridDesc *
         }
         if (pgrid->iSwapBytes)
             swapBytes(&fvalue, 1);
+        NLL_PROF_COUNT(PROF_C_BYTES_READ, sizeof (GRID_FLOAT_TYPE));
     } else {
 
         fvalue = ((GRID_FLOAT_TYPE ***) pgrid->array)[ix][iy][iz];
@@ -3037,6 +3423,8 @@ float InterpCubeAngles(DOUBLE xdiff, DOUBLE ydiff, DOUBLE zdiff,
 
 GRID_FLOAT_TYPE ReadAbsInterpGrid3d(FILE *fpgrid, GridDesc* pgrid, double xloc, double yloc, double zloc, int clean_casc_allocs) {
 
+    NLL_PROF_COUNT(PROF_C_INTERP, 1);
+
     DOUBLE xoff, yoff, zoff;
     xoff = (xloc - pgrid->origx) / pgrid->dx;
     yoff = (yloc - pgrid->origy) / pgrid->dy;
@@ -3175,51 +3563,160 @@ GRID_FLOAT_TYPE ReadAbsInterpGrid3d(FILE *fpgrid, GridDesc* pgrid, double xloc,
 }
 
 
-/** function to read grid data from disk or buffer at absolute location with interpolation ***/
+/** function to get x indexes of y-z sheets needed by ReadAbsInterpGrid3d() / ReadAbsInterpGrid3dSheets() at x location ***/
 
-/* 2D version - ix assumed = 0 */
+// 20261018 AJL - added
 
-/* read from file if fpgrid != NULL, otherwise read from grid buffer */
+void GetInterpGrid3dSheetIndex(GridDesc* pgrid, double xloc, int *pix0, int *pix1) {
 
-DOUBLE ReadAbsInterpGrid2d(FILE *fpgrid, GridDesc* pgrid, double yloc, double zloc) {
+    DOUBLE xoff;
 
-    int ix0, iy0, iy1, iz0, iz1;
-    DOUBLE value;
-    DOUBLE vval00, vval01, vval10, vval11;
+    xoff = (xloc - pgrid->origx) / pgrid->dx;
+    *pix0 = (int) (xoff - VERY_SMALL_DOUBLE);
+    *pix1 = (*pix0 < pgrid->numx - 1) ? *pix0 + 1 : *pix0;
 
-    DOUBLE yoff, zoff;
-    DOUBLE ydiff, zdiff;
+}
 
-    /* calculate grid locations on edge of solid containing point */
 
-    ix0 = 0;
+/** function to read value from y-z sheet in memory, same range checks as ReadGrid3dValue() ***/
+
+static GRID_FLOAT_TYPE ReadGrid3dSheetValue(GRID_FLOAT_TYPE *sheet, int iy, int iz, GridDesc * pgrid) {
+
+    if (sheet == NULL || iy < 0 || iy >= pgrid->numy || iz < 0 || iz >= pgrid->numz)
+        return (-VERY_LARGE_FLOAT);
+
+    return (*(sheet + iy * pgrid->numz + iz));
+
+}
+
+
+/** function to read grid data from dual y-z sheets in memory at absolute location with interpolation ***/
+
+/* sheet0 and sheet1 hold x sheets ix0 and ix1 of grid returned by GetInterpGrid3dSheetIndex() for xloc,
+ * or NULL if sheet index is out of range.
+ * Returns same value as ReadAbsInterpGrid3d() reading from disk, cascading grids not supported. */
+
+// 20261018 AJL - added for grid search with sheets read ahead of evaluation
+
+GRID_FLOAT_TYPE ReadAbsInterpGrid3dSheets(GRID_FLOAT_TYPE *sheet0, GRID_FLOAT_TYPE *sheet1, GridDesc* pgrid,
+        double xloc, double yloc, double zloc) {
+
+    NLL_PROF_COUNT(PROF_C_INTERP, 1);
+
+    DOUBLE xoff, yoff, zoff;
+    xoff = (xloc - pgrid->origx) / pgrid->dx;
     yoff = (yloc - pgrid->origy) / pgrid->dy;
-    iy0 = (int) (yoff - VERY_SMALL_DOUBLE);
     zoff = (zloc - pgrid->origz) / pgrid->dz;
+
+    int ix0, iy0, iy1, iz0, iz1;
+    GRID_FLOAT_TYPE value;
+    DOUBLE vval000, vval001, vval010, vval011, vval100, vval101, vval110, vval111;
+    DOUBLE xdiff, ydiff, zdiff;
+
+    ix0 = (int) (xoff - VERY_SMALL_DOUBLE);
+    iy0 = (int) (yoff - VERY_SMALL_DOUBLE);
     iz0 = (int) (zoff - VERY_SMALL_DOUBLE);
 
     iy1 = (iy0 < pgrid->numy - 1) ? iy0 + 1 : iy0;
     iz1 = (iz0 < pgrid->numz - 1) ? iz0 + 1 : iz0;
 
-
+    xdiff = xoff - (DOUBLE) ix0;
     ydiff = yoff - (DOUBLE) iy0;
     zdiff = zoff - (DOUBLE) iz0;
 
-    // DEBUG
-    /*
-    printf("%d %d %d  %lf %lf %lf  %lf %lf %lf %s\n",
-            pgrid->numx, pgrid->numy, pgrid->numz,
-            pgrid->origx, pgrid->origy, pgrid->origz,
-            pgrid->dx, pgrid->dy, pgrid->dz, pgrid->chr_type);
-    if (iy0 < 0 || iy1 >= pgrid->numy )
-            printf("ERROR: ReadAbsInterpGrid2d: (iy0 < 0 || iy1 >= pgrid->numy )\n");
-    if (iz0 < 0 || iz1 >= pgrid->numz )
-            printf("ERROR: ReadAbsInterpGrid2d: (iz0 < 0 || iz1 >= pgrid->numz )\n");
+    if (xdiff < 0.0 || xdiff > 1.0)
+        return (-VERY_LARGE_FLOAT);
     if (ydiff < 0.0 || ydiff > 1.0)
-            printf("ERROR: ReadAbsInterpGrid2d: (ydiff < 0.0 || ydiff > 1.0 )\n");
+        return (-VERY_LARGE_FLOAT);
     if (zdiff < 0.0 || zdiff > 1.0)
-            printf("ERROR: ReadAbsInterpGrid2d: (zdiff < 0.0 || zdiff > 1.0 )\n");
-     */
+        return (-VERY_LARGE_FLOAT);
+
+    /* location at grid node */
+
+    if (xdiff + ydiff + zdiff < SMALL_FLOAT)
+        return (ReadGrid3dSheetValue(sheet0, iy0, iz0, pgrid));
+
+    /* read vertex values from sheets */
+
+    vval000 = ReadGrid3dSheetValue(sheet0, iy0, iz0, pgrid);
+    vval001 = ReadGrid3dSheetValue(sheet0, iy0, iz1, pgrid);
+    vval010 = ReadGrid3dSheetValue(sheet0, iy1, iz0, pgrid);
+    vval011 = ReadGrid3dSheetValue(sheet0, iy1, iz1, pgrid);
+    vval100 = ReadGrid3dSheetValue(sheet1, iy0, iz0, pgrid);
+    vval101 = ReadGrid3dSheetValue(sheet1, iy0, iz1, pgrid);
+    vval110 = ReadGrid3dSheetValue(sheet1, iy1, iz0, pgrid);
+    vval111 = ReadGrid3dSheetValue(sheet1, iy1, iz1, pgrid);
+
+    /* interpolate values */
+
+    if (pgrid->type == GRID_ANGLE || pgrid->type == GRID_ANGLE_2D) {
+        value = InterpCubeAngles(xdiff, ydiff, zdiff,
+                vval000, vval001, vval010, vval011,
+                vval100, vval101, vval110, vval111);
+    } else {
+        if (pgrid->type != GRID_SSST_TIMECORR) {
+            if (vval000 < 0.0 || vval010 < 0.0 || vval100 < 0.0 || vval110 < 0.0
+                    || vval001 < 0.0 || vval011 < 0.0 || vval101 < 0.0 || vval111 < 0.0) {
+                return (-VERY_LARGE_FLOAT);
+            }
+        }
+        value = InterpCubeLagrange(xdiff, ydiff, zdiff,
+                vval000, vval001, vval010, vval011,
+                vval100, vval101, vval110, vval111);
+    }
+
+
+    return (value);
+}
+
+
+/** function to read grid data from disk or buffer at absolute location with interpolation ***/
+
+/* 2D version - ix assumed = 0 */
+
+/* read from file if fpgrid != NULL, otherwise read from grid buffer */
+
+DOUBLE ReadAbsInterpGrid2d(FILE *fpgrid, GridDesc* pgrid, double yloc, double zloc) {
+
+    int ix0, iy0, iy1, iz0, iz1;
+    DOUBLE value;
+    DOUBLE vval00, vval01, vval10, vval11;
+
+    DOUBLE yoff, zoff;
+    DOUBLE ydiff, zdiff;
+
+    NLL_PROF_COUNT(PROF_C_INTERP, 1);
+
+    /* calculate grid locations on edge of solid containing point */
+
+    ix0 = 0;
+    yoff = (yloc - pgrid->origy) / pgrid->dy;
+    iy0 = (int) (yoff - VERY_SMALL_DOUBLE);
+    zoff = (zloc - pgrid->origz) / pgrid->dz;
+    iz0 = (int) (zoff - VERY_SMALL_DOUBLE);
+
+    iy1 = (iy0 < pgrid->numy - 1) ? iy0 + 1 : iy0;
+    iz1 = (iz0 < pgrid->numz - 1) ? iz0 + 1 : iz0;
+
+
+    ydiff = yoff - (DOUBLE) iy0;
+    zdiff = zoff - (DOUBLE) iz0;
+
+    // DEBUG
+    /*
+    printf("%d %d %d  %lf %lf %lf  %lf %lf %lf %s\n",
+            pgrid->numx, pgrid->numy, pgrid->numz,
+            pgrid->origx, pgrid->origy, pgrid->origz,
+            pgrid->dx, pgrid->dy, pgrid->dz, pgrid->chr_type);
+    if (iy0 < 0 || iy1 >= pgrid->numy )
+            printf("ERROR: ReadAbsInterpGrid2d: (iy0 < 0 || iy1 >= pgrid->numy )\n");
+    if (iz0 < 0 || iz1 >= pgrid->numz )
+            printf("ERROR: ReadAbsInterpGrid2d: (iz0 < 0 || iz1 >= pgrid->numz )\n");
+    if (ydiff < 0.0 || ydiff > 1.0)
+            printf("ERROR: ReadAbsInterpGrid2d: (ydiff < 0.0 || ydiff > 1.0 )\n");
+    if (zdiff < 0.0 || zdiff > 1.0)
+            printf("ERROR: ReadAbsInterpGrid2d: (zdiff < 0.0 || zdiff > 1.0 )\n");
+     */
     // End - DEBUG
 
     //INGV
@@ -4014,6 +4511,132 @@ eof_exit:
 
 
 
+/** function to find whitespace separated token in line, returns pointer to token or NULL if no more tokens */
+
+static char *next_obs_token(char *pchr, int *plen) {
+
+    char *pstart;
+
+    while (isspace((unsigned char) *pchr))
+        pchr++;
+    if (*pchr == '\0')
+        return (NULL);
+    pstart = pchr;
+    while (*pchr != '\0' && !isspace((unsigned char) *pchr))
+        pchr++;
+    *plen = pchr - pstart;
+
+    return (pstart);
+
+}
+
+/** function to convert token containing only an integer, returns 0 if token is not [sign]digits */
+
+static int obs_token_long(char *ptoken, int len, long *plval) {
+
+    int n = 0, isign = 1;
+    long lval = 0;
+
+    if (ptoken[0] == '-' || ptoken[0] == '+') {
+        isign = ptoken[0] == '-' ? -1 : 1;
+        n++;
+    }
+    if (n >= len || len - n > 18)
+        return (0);
+    for (; n < len; n++) {
+        if (ptoken[n] < '0' || ptoken[n] > '9')
+            return (0);
+        lval = 10 * lval + (ptoken[n] - '0');
+    }
+    *plval = isign * lval;
+
+    return (1);
+
+}
+
+/** function to read observation part of well-formed phase line in place
+ *
+ *  fields are converted only if each field is a complete token of the expected type, so that values are identical to sscanf
+ *  returns 14, or -1 if line must be read with sscanf
+ *  *pistat2 is 1 if a priori weight was read, 0 if not present, -1 if a priori weight must be read with sscanf
+ */
+
+static int read_arrival_obs_in_place(char* line, char* label, ArrivalDesc* parr, long int *pidate, long int *pihrmin,
+        double *papriori_weight, int *pistat2) {
+
+    int n, len[15];
+    char *ptoken[15], *pchr, *pend;
+    char *string_field[6];
+    int string_size[6];
+    double dval[5];
+    static const int idouble_field[5] = {8, 10, 11, 12, 13};
+
+    string_field[0] = label;
+    string_size[0] = ARRIVAL_LABEL_LEN;
+    string_field[1] = parr->inst;
+    string_size[1] = sizeof (parr->inst);
+    string_field[2] = parr->comp;
+    string_size[2] = sizeof (parr->comp);
+    string_field[3] = parr->onset;
+    string_size[3] = sizeof (parr->onset);
+    string_field[4] = parr->phase;
+    string_size[4] = sizeof (parr->phase);
+    string_field[5] = parr->first_mot;
+    string_size[5] = sizeof (parr->first_mot);
+
+    /* find tokens */
+    pchr = line;
+    for (n = 0; n < 15; n++) {
+        if ((ptoken[n] = next_obs_token(pchr, len + n)) == NULL)
+            break;
+        pchr = ptoken[n] + len[n];
+    }
+    if (n < 14)
+        return (-1);
+
+    /* check string fields */
+    for (n = 0; n < 6; n++)
+        if (len[n] >= string_size[n])
+            return (-1);
+    if (len[9] >= (int) sizeof (parr->error_type))
+        return (-1);
+
+    /* convert numeric fields */
+    if (!obs_token_long(ptoken[6], len[6], pidate) || !obs_token_long(ptoken[7], len[7], pihrmin))
+        return (-1);
+    for (n = 0; n < 5; n++) {
+        dval[n] = strtod(ptoken[idouble_field[n]], &pend);
+        if (pend != ptoken[idouble_field[n]] + len[idouble_field[n]])
+            return (-1);
+    }
+
+    /* a priori weight (NLL PHASE_2 format) */
+    *pistat2 = 0;
+    if (ptoken[14] != NULL) {
+        *papriori_weight = strtod(ptoken[14], &pend);
+        if (pend == ptoken[14] + len[14])
+            *pistat2 = 1;
+        else if (pend != ptoken[14])
+            *pistat2 = -1;
+    }
+
+    /* set fields */
+    for (n = 0; n < 6; n++) {
+        memcpy(string_field[n], ptoken[n], len[n]);
+        string_field[n][len[n]] = '\0';
+    }
+    memcpy(parr->error_type, ptoken[9], len[9]);
+    parr->error_type[len[9]] = '\0';
+    parr->sec = dval[0];
+    parr->error = dval[1];
+    parr->coda_dur = dval[2];
+    parr->amplitude = dval[3];
+    parr->period = dval[4];
+
+    return (14);
+
+}
+
 /** function to read arrival */
 
 /* returns:	1    if only observation part of phase read
@@ -4043,24 +4666,27 @@ int ReadArrival(char* line, ArrivalDesc* parr, int iReadType) {
 
     /* read observation part of phase line */
 
-    istat = sscanf(line, "%s %s %s %s %s %s %ld %ld %lf %s %lf %lf %lf %lf",
-            label,
-            parr->inst,
-            parr->comp,
-            parr->onset,
-            parr->phase,
-            parr->first_mot,
-            /*&parr->quality, */
-            &idate, &ihrmin,
-            &(parr->sec),
-            parr->error_type,
-            // AJL 2000628 bug fix - replaced following line
-            //&parr->error,
-            &(parr->error),
-            &(parr->coda_dur),
-            &(parr->amplitude),
-            &(parr->period)
-            );
+    // 20261018 AJL - added: well-formed phase lines are read in place, other lines with sscanf
+    istat2 = -1;
+    if ((istat = read_arrival_obs_in_place(line, label, parr, &idate, &ihrmin, &apriori_weight, &istat2)) < 0)
+        istat = sscanf(line, "%s %s %s %s %s %s %ld %ld %lf %s %lf %lf %lf %lf",
+                label,
+                parr->inst,
+                parr->comp,
+                parr->onset,
+                parr->phase,
+                parr->first_mot,
+                /*&parr->quality, */
+                &idate, &ihrmin,
+                &(parr->sec),
+                parr->error_type,
+                // AJL 2000628 bug fix - replaced following line
+                //&parr->error,
+                &(parr->error),
+                &(parr->coda_dur),
+                &(parr->amplitude),
+                &(parr->period)
+                );
 
     // check for QUAL error type and convert to GAU error using LOCQUAL2ERR
     // 20160727 AJL - added
@@ -4105,9 +4731,10 @@ int ReadArrival(char* line, ArrivalDesc* parr, int iReadType) {
 
     // test input of new values
 
-    istat2 = sscanf(line, "%*s %*s %*s %*s %*s %*s %*d %*d %*f %*s %*f %*f %*f %*f %lf",
-            &apriori_weight
-            );
+    if (istat2 < 0)
+        istat2 = sscanf(line, "%*s %*s %*s %*s %*s %*s %*d %*d %*f %*s %*f %*f %*f %*f %lf",
+                &apriori_weight
+                );
     if (istat2 == 1) {
         parr->apriori_weight = apriori_weight;
     } else {
@@ -5026,6 +5653,87 @@ int ExpandWildCards(char* fileFilter, char fileList[][FILENAME_MAX], int maxNumF
 
 }
 
+/** function to check for and expand wild card characters in filenames
+        and to return an allocated list of equivalent files, sorted by name, with no limit on number of files
+
+    returns number of files, or -1 on error, *pfileList to be freed with FreeWildCardsList()
+
+    20261018 AJL - added to avoid fixed size file name arrays
+ */
+
+int ExpandWildCardsList(char* fileFilter, char ***pfileList) {
+
+    char *pchr;
+    char **fileList;
+
+    *pfileList = NULL;
+
+    /* check for no '*' or '?' character */
+
+    if (strchr(fileFilter, '*') == NULL && strchr(fileFilter, '?') == NULL) {
+        if ((fileList = malloc(sizeof (char *))) == NULL || (fileList[0] = strdup(fileFilter)) == NULL) {
+            free(fileList);
+            return (-1);
+        }
+        *pfileList = fileList;
+        return (1);
+    }
+
+    // get directory and filename
+    char directory[FILENAME_MAX];
+    if ((pchr = strrchr(fileFilter, '/')) != NULL) {
+        strncpy(directory, fileFilter, pchr - fileFilter);
+        directory[pchr - fileFilter] = '\0';
+        strcpy(ExpandWildCards_pattern, pchr + 1);
+    } else {
+        strcpy(directory, ".");
+        strcpy(ExpandWildCards_pattern, fileFilter);
+    }
+
+    /* expand wildcard file names into list of files */
+
+    struct dirent **namelist;
+    int n, nfiles;
+    if ((nfiles = scandir(directory, &namelist, fnmatch_wrapper, alphasort)) <= 0) {
+        nll_puterr2("ERROR: expanding wildcard filenames in: ", fileFilter);
+        return (-1);
+    }
+    if ((fileList = calloc(nfiles, sizeof (char *))) == NULL) {
+        for (n = 0; n < nfiles; n++)
+            free(namelist[n]);
+        free(namelist);
+        return (-1);
+    }
+    for (n = 0; n < nfiles; n++) {
+        if ((fileList[n] = malloc(strlen(directory) + strlen(namelist[n]->d_name) + 2)) != NULL)
+            sprintf(fileList[n], "%s/%s", directory, namelist[n]->d_name);
+        free(namelist[n]);
+    }
+    free(namelist);
+    for (n = 0; n < nfiles; n++) {
+        if (fileList[n] == NULL) {
+            FreeWildCardsList(fileList, nfiles);
+            return (-1);
+        }
+    }
+
+    *pfileList = fileList;
+    return (nfiles);
+
+}
+
+/** function to free list of files allocated by ExpandWildCardsList() */
+
+void FreeWildCardsList(char **fileList, int nfiles) {
+
+    if (fileList == NULL)
+        return;
+    for (int n = 0; n < nfiles; n++)
+        free(fileList[n]);
+    free(fileList);
+
+}
+
 /** function to wrap fnmatch */
 
 int fnmatch_wrapper(const struct dirent * entry) {
@@ -5227,16 +5935,16 @@ int GetTakeOffAngles(TakeOffAngles *pangles, double *pazim, double *pdip, int *p
 
 int ReadTakeOffAnglesFile(char *fname, double xloc, double yloc, double zloc,
         double *pazim, double *pdip, int *piqual, double sta_azim, int iSwapBytes) {
-    int istat;
-    FILE *fp_grid, *fp_hdr;
+    GridFileHandle *phandle;
     float fvalue;
     GridDesc gdesc;
     TakeOffAngles angles;
 
     //printf("DEBUG: ReadTakeOffAnglesFile: fname %s\n", fname);
 
-    /* open angle grid file */
-    if ((istat = OpenGrid3dFile(fname, &fp_grid, &fp_hdr, &gdesc, "angle", NULL, iSwapBytes)) < 0) {
+    /* get angle grid file from cache */
+    // 20261018 AJL - use cached grid file handle, header read and file opened once per grid file
+    if ((phandle = OpenCachedGrid3dFile(fname, "angle", iSwapBytes)) == NULL) {
         if (message_flag >= 3) {
             sprintf(MsgStr, "WARNING: cannot open angle grid file, ignoring angles: %s", fname);
             nll_putmsg(3, MsgStr);
@@ -5248,7 +5956,10 @@ int ReadTakeOffAnglesFile(char *fname, double xloc, double yloc, double zloc,
     }
 
     /* get angles float value on grid */
-    fvalue = ReadAbsInterpGrid3d(fp_grid, &gdesc, xloc, yloc, zloc, 0);
+    LockCachedGrid3dFile(phandle);
+    gdesc = phandle->grid;
+    fvalue = ReadAbsInterpGrid3d(phandle->fp_grid, &gdesc, xloc, yloc, zloc, 0);
+    UnlockCachedGrid3dFile(phandle);
 
     /* get angles */
     SetAnglesFloat(&angles, fvalue);
@@ -5269,14 +5980,207 @@ int ReadTakeOffAnglesFile(char *fname, double xloc, double yloc, double zloc,
         }
     }
 
-    /* close angle grid file */
-    CloseGrid3dFile(&gdesc, &fp_grid, &fp_hdr);
+    /* release angle grid file */
+    CloseCachedGrid3dFile(phandle);
 
     return (0);
 
 
 }
 
+/** block of time grid node values around an interpolation cube, nodes are read once */
+
+typedef struct {
+    int ix0, iy0, iz0; // grid indexes of block[0][0][0]
+    GRID_FLOAT_TYPE value[4][4][4];
+    char is_read[4][4][4];
+}
+TimeNodeBlock;
+
+/** function to read time grid node value through node block */
+
+static GRID_FLOAT_TYPE read_time_node(FILE *fpgrid, GridDesc* ptgrid, TimeNodeBlock *pblock, int ix, int iy, int iz) {
+
+    int jx, jy, jz;
+
+    jx = ix - pblock->ix0;
+    jy = iy - pblock->iy0;
+    jz = iz - pblock->iz0;
+    if (!pblock->is_read[jx][jy][jz]) {
+        if (fpgrid != NULL)
+            pblock->value[jx][jy][jz] = ReadGrid3dValue(fpgrid, ix, iy, iz, ptgrid, 0);
+        else
+            pblock->value[jx][jy][jz] = ((GRID_FLOAT_TYPE *) ptgrid->buffer)
+                [(long) ix * (long) ptgrid->numy * (long) ptgrid->numz + (long) iy * (long) ptgrid->numz + iz];
+        pblock->is_read[jx][jy][jz] = 1;
+    }
+
+    return (pblock->value[jx][jy][jz]);
+
+}
+
+/** function to get take-off angles float value at a time grid node,
+ *      same value as the corresponding angle grid node generated by CalcAnglesGradient() */
+
+static GRID_FLOAT_TYPE gradient_angles_node(FILE *fpgrid, GridDesc* ptgrid, TimeNodeBlock *pblock,
+        int ix, int iy, int iz, int iflag2D) {
+
+    double xlow = 0.0, xhigh = 0.0, azim, dip;
+    int iqual;
+    TakeOffAngles angles;
+
+
+    /* node outside grid, same as ReadGrid3dValue() */
+    if (ix < 0 || ix >= ptgrid->numx || iy < 0 || iy >= ptgrid->numy || iz < 0 || iz >= ptgrid->numz)
+        return (-VERY_LARGE_FLOAT);
+
+    /* no calculation for edges of grid, 2D grids, angles in ix = 0 sheet */
+    if ((iflag2D && ix >= 1) || (!iflag2D && (ix == 0 || ix == ptgrid->numx - 1))
+            || iy == 0 || iy == ptgrid->numy - 1 || iz == 0 || iz == ptgrid->numz - 1)
+        return (AnglesNULL.fval);
+
+    if (!iflag2D) {
+        xlow = read_time_node(fpgrid, ptgrid, pblock, ix - 1, iy, iz);
+        xhigh = read_time_node(fpgrid, ptgrid, pblock, ix + 1, iy, iz);
+    }
+    angles = GetGradientAngles(
+            read_time_node(fpgrid, ptgrid, pblock, ix, iy, iz),
+            xlow,
+            xhigh,
+            read_time_node(fpgrid, ptgrid, pblock, ix, iy - 1, iz),
+            read_time_node(fpgrid, ptgrid, pblock, ix, iy + 1, iz),
+            /* intentional reversal of z signs to get pos = up */
+            read_time_node(fpgrid, ptgrid, pblock, ix, iy, iz + 1),
+            read_time_node(fpgrid, ptgrid, pblock, ix, iy, iz - 1),
+            ptgrid->dx, ptgrid->dy, ptgrid->dz, iflag2D,
+            &azim, &dip, &iqual);
+
+    return (angles.fval);
+
+}
+
+/** function to get take-off angles float value at absolute location from travel time grid on disk or in buffer
+ *
+ *  the angles at the vertices of the grid cell containing the location are calculated from local travel time
+ *      gradients as in CalcAnglesGradient() and interpolated as in ReadAbsInterpGrid3d(),
+ *      returns same value as ReadAbsInterpGrid3d() on the angle grid generated from the time grid
+ *  cascading grids not supported
+ *
+ * 20261018 AJL - added
+ */
+
+GRID_FLOAT_TYPE ReadAbsInterpGridAngles(FILE *fpgrid, GridDesc* ptgrid, double xloc, double yloc, double zloc) {
+
+    int ix0, ix1, iy0, iy1, iz0, iz1, iflag2D;
+    DOUBLE xoff, yoff, zoff, xdiff, ydiff, zdiff;
+    GRID_FLOAT_TYPE vval000, vval001, vval010, vval011, vval100, vval101, vval110, vval111;
+    TimeNodeBlock block;
+
+
+    iflag2D = ptgrid->type == GRID_TIME_2D;
+
+    xoff = (xloc - ptgrid->origx) / ptgrid->dx;
+    yoff = (yloc - ptgrid->origy) / ptgrid->dy;
+    zoff = (zloc - ptgrid->origz) / ptgrid->dz;
+
+    /* calculate grid locations on edge of solid containing point */
+
+    ix0 = (int) (xoff - VERY_SMALL_DOUBLE);
+    iy0 = (int) (yoff - VERY_SMALL_DOUBLE);
+    iz0 = (int) (zoff - VERY_SMALL_DOUBLE);
+
+    ix1 = (ix0 < ptgrid->numx - 1) ? ix0 + 1 : ix0;
+    iy1 = (iy0 < ptgrid->numy - 1) ? iy0 + 1 : iy0;
+    iz1 = (iz0 < ptgrid->numz - 1) ? iz0 + 1 : iz0;
+
+    xdiff = xoff - (DOUBLE) ix0;
+    ydiff = yoff - (DOUBLE) iy0;
+    zdiff = zoff - (DOUBLE) iz0;
+
+    if (xdiff < 0.0 || xdiff > 1.0 || ydiff < 0.0 || ydiff > 1.0 || zdiff < 0.0 || zdiff > 1.0)
+        return (-VERY_LARGE_FLOAT);
+
+    /* nodes of cell and their neighbours */
+    memset(block.is_read, 0, sizeof (block.is_read));
+    block.ix0 = ix0 - 1;
+    block.iy0 = iy0 - 1;
+    block.iz0 = iz0 - 1;
+
+    /* location at grid node */
+
+    if (xdiff + ydiff + zdiff < SMALL_FLOAT)
+        return (gradient_angles_node(fpgrid, ptgrid, &block, ix0, iy0, iz0, iflag2D));
+
+    /* angles at vertices */
+
+    vval000 = gradient_angles_node(fpgrid, ptgrid, &block, ix0, iy0, iz0, iflag2D);
+    vval001 = gradient_angles_node(fpgrid, ptgrid, &block, ix0, iy0, iz1, iflag2D);
+    vval010 = gradient_angles_node(fpgrid, ptgrid, &block, ix0, iy1, iz0, iflag2D);
+    vval011 = gradient_angles_node(fpgrid, ptgrid, &block, ix0, iy1, iz1, iflag2D);
+    vval100 = gradient_angles_node(fpgrid, ptgrid, &block, ix1, iy0, iz0, iflag2D);
+    vval101 = gradient_angles_node(fpgrid, ptgrid, &block, ix1, iy0, iz1, iflag2D);
+    vval110 = gradient_angles_node(fpgrid, ptgrid, &block, ix1, iy1, iz0, iflag2D);
+    vval111 = gradient_angles_node(fpgrid, ptgrid, &block, ix1, iy1, iz1, iflag2D);
+
+    return (InterpCubeAngles(xdiff, ydiff, zdiff,
+            vval000, vval001, vval010, vval011,
+            vval100, vval101, vval110, vval111));
+
+}
+
+/** function to read take-off angles from gradient of travel time grid file,
+ *      angle grid file not needed, see ReadTakeOffAnglesFile()
+ *
+ * 20261018 AJL - added
+ */
+
+int ReadTakeOffAnglesTimeGrid(char *fname, double xloc, double yloc, double zloc,
+        double *pazim, double *pdip, int *piqual, double sta_azim, int iSwapBytes) {
+    GridFileHandle *phandle;
+    float fvalue;
+    GridDesc gdesc;
+    TakeOffAngles angles;
+
+
+    /* get time grid file from cache */
+    if ((phandle = OpenCachedGrid3dFile(fname, "time", iSwapBytes)) == NULL
+            || isCascadingGrid(&phandle->grid) || (phandle->fp_grid == NULL && phandle->grid.buffer == NULL)) {
+        if (message_flag >= 3) {
+            sprintf(MsgStr, "WARNING: cannot read take-off angles from time grid file, ignoring angles: %s", fname);
+            nll_putmsg(3, MsgStr);
+        }
+        CloseCachedGrid3dFile(phandle);
+        angles = SetTakeOffAngles(0.0, 0.0, 0);
+        GetTakeOffAngles(&angles, pazim, pdip, piqual);
+        return (-1);
+    }
+
+    /* get angles float value from time grid */
+    LockCachedGrid3dFile(phandle);
+    gdesc = phandle->grid;
+    fvalue = ReadAbsInterpGridAngles(phandle->fp_grid, &gdesc, xloc, yloc, zloc);
+    UnlockCachedGrid3dFile(phandle);
+    CloseCachedGrid3dFile(phandle);
+
+    /* get angles */
+    SetAnglesFloat(&angles, fvalue);
+    GetTakeOffAngles(&angles, pazim, pdip, piqual);
+
+    /* determine azimuth (2D grids) */
+    if (gdesc.type == GRID_TIME_2D) {
+        if (*pazim <= ANGLES_DIP_MAX)
+            *pazim = sta_azim;
+        else { // reverse azimuth
+            *pazim = sta_azim - 180.0;
+            if (*pazim < 0.0)
+                *pazim += 360.0;
+        }
+    }
+
+    return (0);
+
+}
+
 /** function to generate normally distributed deviate with zero mean and unit variance */
 
 double normal_dist_deviate() {
@@ -5870,17 +6774,15 @@ int LineIsBlank(char *line) {
 /** function to read FORTRAN character format fields */
 
 int ReadFortranString(char* line, int istart, int ilen, char* string_in) {
-    char chrtmp[MAXLINE], *chrpos;
-
 
     /* check for null char before end of read */
-    chrpos = strchr(line, '\0');
-    if (chrpos - line < istart + ilen - 1)
+    // 20261018 AJL - line is not scanned beyond end of field, field is copied directly
+    if (strnlen(line, istart + ilen - 1) < (size_t) (istart + ilen - 1))
         return (-1);
 
-    /* copy field to temp string */
-    strncpy(chrtmp, line + (istart - 1), ilen);
-    chrtmp[ilen] = '\0';
+    /* copy field */
+    memcpy(string_in, line + (istart - 1), ilen);
+    string_in[ilen] = '\0';
 
     /* check for blank field */
     /*	for (n = 0; n < ilen; n++) {
@@ -5894,8 +6796,44 @@ int ReadFortranString(char* line, int istart, int ilen, char* string_in) {
             }
      */
 
-    strncpy(string_in, chrtmp, ilen);
-    string_in[ilen] = '\0';
+    return (1);
+
+}
+
+/** function to convert FORTRAN numeric field in place
+ *
+ *  converts fields [blanks][sign]digits[.digits][blanks or other non-exponent characters] with at most 15 digits,
+ *  the result is exact (Clinger fast path) and identical to sscanf
+ *  returns 1 if converted, 0 if field must be read with sscanf
+ */
+
+static int read_fortran_number_in_place(char* pfield, int ilen, int allow_fraction, double* pdblval) {
+
+    static const double pow10_exact[16] = {1.0e0, 1.0e1, 1.0e2, 1.0e3, 1.0e4, 1.0e5, 1.0e6, 1.0e7,
+        1.0e8, 1.0e9, 1.0e10, 1.0e11, 1.0e12, 1.0e13, 1.0e14, 1.0e15};
+    int n = 0, ndigits = 0, nfrac = 0, isign = 1;
+    long long mantissa = 0;
+
+    while (n < ilen && pfield[n] == ' ')
+        n++;
+    if (n < ilen && (pfield[n] == '-' || pfield[n] == '+')) {
+        isign = pfield[n] == '-' ? -1 : 1;
+        n++;
+    }
+    for (; n < ilen && pfield[n] >= '0' && pfield[n] <= '9'; n++, ndigits++)
+        mantissa = 10 * mantissa + (pfield[n] - '0');
+    if (allow_fraction && n < ilen && pfield[n] == '.') {
+        for (n++; n < ilen && pfield[n] >= '0' && pfield[n] <= '9'; n++, ndigits++, nfrac++)
+            mantissa = 10 * mantissa + (pfield[n] - '0');
+    }
+    if (ndigits == 0 || ndigits > 15)
+        return (0);
+    // characters after number that may continue number for sscanf
+    if (n < ilen && (pfield[n] == 'e' || pfield[n] == 'E' || pfield[n] == 'x' || pfield[n] == 'X'
+            || pfield[n] == 'p' || pfield[n] == 'P' || pfield[n] == '.'))
+        return (0);
+
+    *pdblval = isign * ((double) mantissa / pow10_exact[nfrac]);
 
     return (1);
 
@@ -5904,22 +6842,18 @@ int ReadFortranString(char* line, int istart, int ilen, char* string_in) {
 /** function to read FORTRAN integer format fields */
 
 int ReadFortranInt(char* line, int istart, int ilen, int* pintval) {
-    char chrtmp[MAXLINE], *chrpos;
+    char chrtmp[MAXLINE];
     int istat, n;
+    double dblval;
 
 
     /* check for null char before end of read */
-    chrpos = strchr(line, '\0');
-    if (chrpos - line < istart + ilen - 1)
+    if (strnlen(line, istart + ilen - 1) < (size_t) (istart + ilen - 1))
         return (-1);
 
-    /* copy field to temp string */
-    strncpy(chrtmp, line + (istart - 1), ilen);
-    chrtmp[ilen] = '\0';
-
     /* check for blank field */
     for (n = 0; n < ilen; n++) {
-        if (chrtmp[n] != ' ')
+        if (line[istart - 1 + n] != ' ')
             break;
     }
     if (n == ilen) {
@@ -5927,6 +6861,15 @@ int ReadFortranInt(char* line, int istart, int ilen, int* pintval) {
         return (1);
     }
 
+    // 20261018 AJL - added: convert field in place
+    if (ilen < 10 && read_fortran_number_in_place(line + (istart - 1), ilen, 0, &dblval)) {
+        *pintval = (int) dblval;
+        return (1);
+    }
+
+    /* copy field to temp string */
+    strncpy(chrtmp, line + (istart - 1), ilen);
+    chrtmp[ilen] = '\0';
 
     istat = sscanf(chrtmp, "%d", pintval);
 
@@ -5937,22 +6880,17 @@ int ReadFortranInt(char* line, int istart, int ilen, int* pintval) {
 /** function to read FORTRAN real format fields */
 
 int ReadFortranReal(char* line, int istart, int ilen, double* pdblval) {
-    char chrtmp[MAXLINE], *chrpos;
+    char chrtmp[MAXLINE];
     int istat, n;
 
 
     /* check for null char before end of read */
-    chrpos = strchr(line, '\0');
-    if (chrpos - line < istart + ilen - 1)
+    if (strnlen(line, istart + ilen - 1) < (size_t) (istart + ilen - 1))
         return (-1);
 
-    /* copy field to temp string */
-    strncpy(chrtmp, line + (istart - 1), ilen);
-    chrtmp[ilen] = '\0';
-
     /* check for blank field */
     for (n = 0; n < ilen; n++) {
-        if (chrtmp[n] != ' ')
+        if (line[istart - 1 + n] != ' ')
             break;
     }
     if (n == ilen) {
@@ -5960,6 +6898,13 @@ int ReadFortranReal(char* line, int istart, int ilen, double* pdblval) {
         return (1);
     }
 
+    // 20261018 AJL - added: convert field in place
+    if (read_fortran_number_in_place(line + (istart - 1), ilen, 1, pdblval))
+        return (1);
+
+    /* copy field to temp string */
+    strncpy(chrtmp, line + (istart - 1), ilen);
+    chrtmp[ilen] = '\0';
 
     istat = sscanf(chrtmp, "%lf", pdblval);
 
@@ -6083,16 +7028,116 @@ int IsPhaseID(char *phase_in, char *phase_check) {
 /** function to evaluate phase ID from phase ID lists */
 // 20161004 AJL - moved here from NLLocLib.c
 
-int EvalPhaseID(char *phase_out, char *phase_in) {
+static int eval_phase_id(char *phase_out, char *phase_in) {
     int npha_id;
 
     for (npha_id = 0; npha_id < NumPhaseID; npha_id++) {
         if (IsPhaseID(phase_in, PhaseID[npha_id].phase)) {
             if (phase_out != NULL)
                 strcpy(phase_out, PhaseID[npha_id].phase);
-            return (1);
+            return (npha_id);
+        }
+    }
+
+    if (phase_out != NULL)
+        strcpy(phase_out, phase_in);
+
+    return (-1); // returned unchanged
+}
+
+// 20261018 AJL - added: phase names without white space are interned with the result of evaluating their phase ID,
+//    cache is cleared by ClearPhaseIDCache() when phase ID lists change
+
+#define PHASE_ID_CACHE_SIZE 512 // power of 2
+#define PHASE_ID_CACHE_MAX_ENTRIES (3 * PHASE_ID_CACHE_SIZE / 4)
+
+typedef struct {
+    char phase_in[PHASE_LABEL_LEN]; // phase name
+    int npha_id; // index of phase ID for phase name, -1 if phase name not in phase ID lists
+    int used;
+} PhaseIDCacheEntry;
+
+static PhaseIDCacheEntry PhaseIDCache[PHASE_ID_CACHE_SIZE];
+static int PhaseIDCacheNumEntries = 0;
+static int PhaseIDCacheNumPhaseID = -1; // number of phase IDs when cache entries were added
+
+/** function to clear phase ID cache, must be called when phase ID lists are changed or reset (NumPhaseID = 0) */
+
+void ClearPhaseIDCache() {
+
+#ifdef _OPENMP
+#pragma omp critical(nll_phase_id_cache)
+#endif
+    {
+        memset(PhaseIDCache, 0, sizeof (PhaseIDCache));
+        PhaseIDCacheNumEntries = 0;
+        PhaseIDCacheNumPhaseID = NumPhaseID;
+    }
+
+}
+
+/** function to find phase name in phase ID cache, returns pointer to entry or to free entry */
+
+static PhaseIDCacheEntry *find_phase_id_cache_entry(char *phase_in) {
+
+    unsigned int hash = 2166136261u;
+    unsigned char *pchr;
+    PhaseIDCacheEntry *pentry;
+
+    for (pchr = (unsigned char *) phase_in; *pchr != '\0'; pchr++)
+        hash = (hash ^ *pchr) * 16777619u;
+    while (1) {
+        pentry = PhaseIDCache + (hash & (PHASE_ID_CACHE_SIZE - 1));
+        if (!pentry->used || strcmp(pentry->phase_in, phase_in) == 0)
+            return (pentry);
+        hash++;
+    }
+
+}
+
+int EvalPhaseID(char *phase_out, char *phase_in) {
+
+    int npha_id, len, cached = 0;
+    char *pchr;
+    PhaseIDCacheEntry *pentry = NULL;
+
+    // phase ID of phase names with white space depends on IsPhaseID() removing white space, not cached
+    for (pchr = phase_in, len = 0; *pchr != '\0'; pchr++, len++)
+        if (isspace((unsigned char) *pchr))
+            return (eval_phase_id(phase_out, phase_in) >= 0);
+    if (len >= PHASE_LABEL_LEN)
+        return (eval_phase_id(phase_out, phase_in) >= 0);
+
+#ifdef _OPENMP
+#pragma omp critical(nll_phase_id_cache)
+#endif
+    {
+        if (PhaseIDCacheNumPhaseID != NumPhaseID) {
+            memset(PhaseIDCache, 0, sizeof (PhaseIDCache));
+            PhaseIDCacheNumEntries = 0;
+            PhaseIDCacheNumPhaseID = NumPhaseID;
+        }
+        pentry = find_phase_id_cache_entry(phase_in);
+        if (pentry->used) {
+            npha_id = pentry->npha_id;
+            cached = 1;
+        } else if (PhaseIDCacheNumEntries < PHASE_ID_CACHE_MAX_ENTRIES) {
+            pentry->npha_id = eval_phase_id(NULL, phase_in);
+            strcpy(pentry->phase_in, phase_in);
+            pentry->used = 1;
+            PhaseIDCacheNumEntries++;
+            npha_id = pentry->npha_id;
+            cached = 1;
         }
     }
+    if (!cached)
+        return (eval_phase_id(phase_out, phase_in) >= 0);
+
+    if (npha_id >= 0) {
+        if (phase_out != NULL)
+            strcpy(phase_out, PhaseID[npha_id].phase);
+        return (1);
+    }
 
     if (phase_out != NULL)
         strcpy(phase_out, phase_in);
@@ -6130,7 +7175,7 @@ int ReadFpfitSum(FILE *fp_in, HypoDesc * phypo) {
     double mag, dtemp;
 
     double deg, dmin;
-    char strNS[2], strMagType[2];
+    char strNS[2] = "", strMagType[2] = "";
 
     static char line[MAXLINE_LONG];
 
@@ -6450,84 +7495,157 @@ int WriteDiffArrival(FILE* fpio, HypoDesc* hypos, ArrivalDesc* parr, int iWriteT
 }
 
 /** function to generate take-off angles from travel time grid
-                                using a numerical gradient algorithm */
+                                using a numerical gradient algorithm
+ *
+ * 20261018 AJL - ix sheets calculated independently by CalcAnglesGradientSheet(), in parallel if OpenMP available
+ */
 
 int CalcAnglesGradient(GridDesc* ptgrid, GridDesc* pagrid, int angle_mode, int grid_mode) {
 
-    int ix, iy, iz, edge_flagx = 0, edge_flagy = 0, iflag2D = 0;
-    double dx, dy, dz;
-    double xlow = 0.0, xhigh = 0.0;
-    double azim, dip;
-    int iqual;
-
-    TakeOffAngles angles = AnglesNULL;
+    int ix, istat = 0;
+    long nyz;
 
 
     /* write message */
     sprintf(MsgStr, "Generating take-off angle grid...");
     nll_putmsg(1, MsgStr);
 
+    nyz = (long) pagrid->numy * (long) pagrid->numz;
+
+    /* estimate take-off angles from numerical gradients */
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(min:istat)
+#endif
+    for (ix = 0; ix < pagrid->numx; ix++) {
+        if (CalcAnglesGradientSheet(ptgrid, (GRID_FLOAT_TYPE *) pagrid->buffer + (long) ix * nyz,
+                ix, angle_mode, grid_mode) < 0)
+            istat = -1;
+    }
+
+
+    return (istat);
+
+}
+
+/** function to generate take-off angles for the ix sheet of a travel time grid
+ *
+ *  angle values are written to sheet[iy * numz + iz], sheet must hold numy * numz values
+ *  results are identical to GetGradientAngles() applied node by node,
+ *      gradients and qualities for each z row are calculated first in a loop without calls
+ *      on contiguous buffer memory, then angles and dips are calculated and encoded
+ *
+ * 20261018 AJL - added
+ */
+
+int CalcAnglesGradientSheet(GridDesc* ptgrid, GRID_FLOAT_TYPE* sheet, int ix, int angle_mode, int grid_mode) {
+
+    int iy, iz, numy, numz, iflag2D = 0, iqualx, iqualy, iqualz;
+    long nyz;
+    double dx, dy, dz, vcent, grad_low, grad_high, azim, dip;
+    double *gradx, *grady, *gradz, *qual, *work;
+    GRID_FLOAT_TYPE *tcent, *txlow = NULL, *txhigh = NULL, *tylow, *tyhigh, *sheet_row;
+    TakeOffAngles angles = AnglesNULL;
+
 
-    if (grid_mode == GRID_TIME_2D) {
+    if (grid_mode == GRID_TIME_2D)
         iflag2D = 1;
-        xlow = xhigh = 0.0;
+
+    numy = ptgrid->numy;
+    numz = ptgrid->numz;
+    nyz = (long) numy * (long) numz;
+
+    /* no calculation for edges of grid, 2D grids, store angles in ix = 0 sheet */
+    if ((iflag2D && ix >= 1) || (!iflag2D && (ix == 0 || ix == ptgrid->numx - 1)) || numy < 3 || numz < 3) {
+        for (iz = 0; iz < nyz; iz++)
+            sheet[iz] = AnglesNULL.fval;
+        return (0);
     }
 
-    /* estimate take-off angles from numerical gradients */
+    if ((work = (double *) malloc(4 * (size_t) numz * sizeof (double))) == NULL) {
+        nll_puterr("ERROR: allocating memory for take-off angle calculation.");
+        return (-1);
+    }
+    gradx = work;
+    grady = work + numz;
+    gradz = work + 2 * numz;
+    qual = work + 3 * numz;
 
-    dx = pagrid->dx;
-    dy = pagrid->dy;
-    dz = pagrid->dz;
+    dx = ptgrid->dx;
+    dy = ptgrid->dy;
+    dz = ptgrid->dz;
 
-    for (ix = 0; ix < pagrid->numx; ix++) {
-        /* 2D grids, store angles in ix = 0 sheet */
-        if (ix == 1 && iflag2D)
-            edge_flagx = 1;
-        if ((ix == 0 || ix == pagrid->numx - 1)
-                && grid_mode == GRID_TIME)
-            edge_flagx = 1;
-        for (iy = 0; iy < pagrid->numy; iy++) {
-            if (iy == 0 || iy == pagrid->numy - 1)
-                edge_flagy = 1;
-            for (iz = 0; iz < pagrid->numz; iz++) {
-
-                /* no calculation for edges of grid */
-                if (edge_flagx || edge_flagy
-                        || iz == 0 || iz == pagrid->numz - 1) {
-                    ((GRID_FLOAT_TYPE ***) pagrid->array)[ix][iy][iz] = AnglesNULL.fval;
-                    continue;
-                }
+    for (iz = 0; iz < numz; iz++) {
+        sheet[iz] = AnglesNULL.fval;
+        sheet[nyz - numz + iz] = AnglesNULL.fval;
+    }
 
-                if (!iflag2D) {
-                    xlow = ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix - 1][iy][iz];
-                    xhigh = ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix + 1][iy][iz];
-                }
-                angles = GetGradientAngles(
-                        ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix][iy][iz],
-                        xlow,
-                        xhigh,
-                        ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix][iy - 1][iz],
-                        ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix][iy + 1][iz],
-                        /* intentional reversal of z
-                                signs to get pos = up */
-                        ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix][iy][iz + 1],
-                        ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix][iy][iz - 1],
-                        dx, dy, dz, iflag2D,
-                        &azim, &dip, &iqual);
-                if (angle_mode == ANGLE_MODE_YES) {
-                    ((GRID_FLOAT_TYPE ***) pagrid->array)[ix][iy][iz] = angles.fval;
-                } else if (angle_mode == ANGLE_MODE_INCLINATION) {
-                    ((
+    for (iy = 1; iy < numy - 1; iy++) {
 
-                            GRID_FLOAT_TYPE ***) pagrid->array)[ix][iy][iz] = dip;
-                }
+        tcent = (GRID_FLOAT_TYPE *) ptgrid->buffer + (long) ix * nyz + (long) iy * numz;
+        tylow = tcent - numz;
+        tyhigh = tcent + numz;
+        if (!iflag2D) {
+            txlow = tcent - nyz;
+            txhigh = tcent + nyz;
+        }
+        sheet_row = sheet + (long) iy * numz;
+        sheet_row[0] = sheet_row[numz - 1] = AnglesNULL.fval;
+
+        /* gradients of travel time and quality, see GetGradientAngles() */
+        for (iz = 1; iz < numz - 1; iz++) {
+            vcent = tcent[iz];
+            /* intentional reversal of z signs to get pos = up */
+            grad_low = (vcent - tcent[iz + 1]) / dz;
+            grad_high = (tcent[iz - 1] - vcent) / dz;
+            iqualz = CalcAnglesQuality(grad_low, grad_high);
+            gradz[iz] = -((grad_low + grad_high) / 2.0);
+            grad_low = (vcent - tylow[iz]) / dy;
+            grad_high = (tyhigh[iz] - vcent) / dy;
+            iqualy = CalcAnglesQuality(grad_low, grad_high);
+            grady[iz] = -((grad_low + grad_high) / 2.0);
+            if (iflag2D) {
+                gradx[iz] = 0.0;
+                qual[iz] = (fabs(grady[iz]) * (double) iqualy
+                        + fabs(gradz[iz]) * (double) iqualz)
+                        / (fabs(grady[iz]) + fabs(gradz[iz]));
+            } else {
+                grad_low = (vcent - txlow[iz]) / dx;
+                grad_high = (txhigh[iz] - vcent) / dx;
+                iqualx = CalcAnglesQuality(grad_low, grad_high);
+                gradx[iz] = -((grad_low + grad_high) / 2.0);
+                qual[iz] = (fabs(gradx[iz]) * (double) iqualx
+                        + fabs(grady[iz]) * (double) iqualy
+                        + fabs(gradz[iz]) * (double) iqualz)
+                        / (fabs(gradx[iz]) + fabs(grady[iz]) + fabs(gradz[iz]));
+            }
+        }
+
+        if (angle_mode != ANGLE_MODE_YES && angle_mode != ANGLE_MODE_INCLINATION)
+            continue;
 
+        /* angles, see GetGradientAngles() */
+        for (iz = 1; iz < numz - 1; iz++) {
+            if (iflag2D) {
+                dip = atan2(fabs(grady[iz]), -gradz[iz]) / cRPD;
+                azim = grady[iz] > 0.0 ? -1.0 : 1.0;
+            } else {
+                dip = atan2(sqrt(gradx[iz] * gradx[iz] + grady[iz] * grady[iz]), -gradz[iz]) / cRPD;
+                azim = atan2(gradx[iz], grady[iz]) / cRPD;
+                if (azim < 0.0)
+                    azim += 360.0;
+            }
+            if (angle_mode == ANGLE_MODE_YES) {
+                angles = SetTakeOffAngles(azim, dip, (int) qual[iz]);
+                sheet_row[iz] = angles.fval;
+            } else {
+                sheet_row[iz] = dip;
             }
-            edge_flagy = 0;
         }
-        edge_flagx = 0;
+
     }
 
+    free(work);
 
     return (0);
 
@@ -6934,6 +8052,7 @@ int GetPhaseID(char* line1) {
     nll_putmsg(3, MsgStr);
 
     NumPhaseID++;
+    ClearPhaseIDCache();
 
     return (0);
 }
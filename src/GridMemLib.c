@@ -36,6 +36,7 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 #include "GridLib.h"
 //#include "ran1.h"
 #include "GridMemLib.h"
+#include "nll_prof.h"
 
 // define globals
 
@@ -70,10 +71,12 @@ void* NLL_AllocateGrid(GridDesc* pgrid) {
                     //printf("XXX: Already in list: NumAllocations %d->%d\n", XX_last, NumAllocations);
             pGridMemStruct->active = 1;
             fptr = pGridMemStruct->buffer;
+            NLL_PROF_COUNT(PROF_C_GRIDMEM_HIT, 1);
             if (message_flag >= GRIDMEM_MESSAGE)
                 printf("GridMemManager: Grid exists in mem (%d/%d): %s\n", index, GridMemListNumElements, pGridMemStruct->pgrid->title);
             return (fptr);
         } else {
+            NLL_PROF_COUNT(PROF_C_GRIDMEM_MISS, 1);
             // check number of active grids in list
             nactive = 0;
             ngrid_read = 0;
@@ -193,6 +196,7 @@ void*** NLL_CreateGridArray(GridDesc* pgrid) {
             }
             pgrid->gridDesc_Cascading.xyz_scale = pGridMemStruct->pgrid->gridDesc_Cascading.xyz_scale;
             pgrid->gridDesc_Cascading.zindex = pGridMemStruct->pgrid->gridDesc_Cascading.zindex;
+            pgrid->gridDesc_Cascading.zlevel = pGridMemStruct->pgrid->gridDesc_Cascading.zlevel;
         }
     } else {
         fptr = CreateGridArray(pgrid);
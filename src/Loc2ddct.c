@@ -85,6 +85,9 @@ int main(int argc, char *argv[]) {
 
     SetConstants();
 
+    // 20261018 AJL - Arrival array holds arrivals of one event, catalog arrivals stored in ConvertLocToCT(),
+    //    array allocated by SetConstants() is sufficient
+    /*
     // re-allocate arrivals arrays
     // allocate arrivals array
     MAX_NUM_STATIONS = X_MAX_NUM_STATIONS_DIFF;
@@ -95,6 +98,7 @@ int main(int argc, char *argv[]) {
         nll_puterr("ERROR: re-allocating Arrival array.");
         return (EXIT_ERROR_MEMORY);
     }
+     */
 
     message_flag = 1;
     DispProgInfo();
@@ -112,21 +116,234 @@ int main(int argc, char *argv[]) {
 }
 
 
-// 20210511 AJL - Bug fix: following gives errors on older(?) or some compilers: "relocation truncated to fit: R_X86_64_PC32 against symbol"
-// https://stackoverflow.com/questions/57331990/c-compiling-relocation-truncated-to-fit-r-x86-64-pc32-against-symbol
-// https://github.com/alomax/NonLinLoc/issues/7
-// 20210922: Debian 11, with gcc-9: max value is 78546
-//#define  MAX_NUM_DIFF_HYPOCENTERS 100000
-#define  MAX_NUM_DIFF_HYPOCENTERS 50000
-HypoDesc diffHypos[MAX_NUM_DIFF_HYPOCENTERS];
+// 20261018 AJL - arrivals grouped by interned (station, phase) key and candidate event pairs found through a
+//    spatial cell index of epicenters, replaces comparison of all pairs of arrivals;
+//    events and arrivals stored in compact, dynamically grown arrays, replaces static HypoDesc diffHypos[MAX_NUM_DIFF_HYPOCENTERS]
+
+typedef struct {
+    char label[ARRIVAL_LABEL_LEN]; /* station label */
+    char phase[PHASE_LABEL_LEN]; /* phase id */
+} DDKey;
+
+typedef struct {
+    int key; /* index of (station, phase) key in ddKey */
+    int event; /* index of event in ddEvent */
+    double time; /* observed travel time */
+    double weight; /* normalized weight */
+} DDArrival;
+
+typedef struct {
+    double x, y; /* epicenter for event distance */
+    double dlat, dlong, depth; /* hypocenter for xyz output */
+    int arr_start, num_arr; /* range of event arrivals in ddArrival and ddArrivalByKey */
+    long cell[3]; /* spatial index cell */
+} DDEvent;
+
+static DDKey *ddKey = NULL;
+static int numDDKey = 0, maxDDKey = 0;
+static int *ddKeyHash = NULL;
+static int sizeDDKeyHash = 0;
+
+static DDArrival *ddArrival = NULL;
+static int numDDArrival = 0, maxDDArrival = 0;
+static int *ddArrivalByKey = NULL; // indices of arrivals of each event, sorted by key
+static int maxDDArrivalByKey = 0;
+
+static DDEvent *ddEvent = NULL;
+static int numDDEvent = 0, maxDDEvent = 0;
+static int *ddEventByCell = NULL; // indices of events sorted by spatial index cell
+
+
+/** function to ensure array has space for at least nrequired elements, doubles size as needed */
+
+static int growArray(void **parray, int *pmax, int nrequired, size_t size) {
+
+    int nmax;
+    void *ptmp;
+
+    if (nrequired <= *pmax)
+        return (0);
+
+    nmax = *pmax > 0 ? *pmax : 1024;
+    while (nmax < nrequired)
+        nmax *= 2;
+    if ((ptmp = realloc(*parray, (size_t) nmax * size)) == NULL)
+        return (-1);
+    *parray = ptmp;
+    *pmax = nmax;
+
+    return (0);
+
+}
+
+static unsigned long hashDDKey(char *label, char *phase) {
+
+    unsigned long hash = 2166136261UL;
+    char *pchr;
+
+    for (pchr = label; *pchr != '\0'; pchr++)
+        hash = (hash ^ (unsigned char) *pchr) * 16777619UL;
+    hash = (hash ^ (unsigned char) ' ') * 16777619UL;
+    for (pchr = phase; *pchr != '\0'; pchr++)
+        hash = (hash ^ (unsigned char) *pchr) * 16777619UL;
+
+    return (hash);
+
+}
+
+/** function to return index of (label, phase) key in ddKey, adds key if not present, returns -1 on memory error */
+
+static int internDDKey(char *label, char *phase) {
+
+    int n, nsize, *ptmp;
+    unsigned long slot, mask;
+
+    // re-hash if table would become more than half full
+    if (2 * (numDDKey + 1) > sizeDDKeyHash) {
+        nsize = sizeDDKeyHash > 0 ? 2 * sizeDDKeyHash : 1024;
+        if ((ptmp = (int *) malloc(nsize * sizeof (int))) == NULL)
+            return (-1);
+        for (n = 0; n < nsize; n++)
+            ptmp[n] = -1;
+        mask = (unsigned long) nsize - 1;
+        for (n = 0; n < numDDKey; n++) {
+            slot = hashDDKey(ddKey[n].label, ddKey[n].phase) & mask;
+            while (ptmp[slot] >= 0)
+                slot = (slot + 1) & mask;
+            ptmp[slot] = n;
+        }
+        free(ddKeyHash);
+        ddKeyHash = ptmp;
+        sizeDDKeyHash = nsize;
+    }
+
+    mask = (unsigned long) sizeDDKeyHash - 1;
+    slot = hashDDKey(label, phase) & mask;
+    while ((n = ddKeyHash[slot]) >= 0) {
+        if (strcmp(ddKey[n].label, label) == 0 && strcmp(ddKey[n].phase, phase) == 0)
+            return (n);
+        slot = (slot + 1) & mask;
+    }
+
+    if (growArray((void **) &ddKey, &maxDDKey, numDDKey + 1, sizeof (DDKey)) < 0)
+        return (-1);
+    strcpy(ddKey[numDDKey].label, label);
+    strcpy(ddKey[numDDKey].phase, phase);
+    ddKeyHash[slot] = numDDKey;
+
+    return (numDDKey++);
+
+}
+
+static int compareArrivalByKey(const void *p1, const void *p2) {
+
+    int n1 = *(const int *) p1, n2 = *(const int *) p2;
+
+    if (ddArrival[n1].key != ddArrival[n2].key)
+        return (ddArrival[n1].key < ddArrival[n2].key ? -1 : 1);
+    return (n1 < n2 ? -1 : (n1 > n2 ? 1 : 0));
+
+}
+
+static int compareCell(const long *cell1, const long *cell2) {
+
+    int n;
+
+    for (n = 0; n < 3; n++)
+        if (cell1[n] != cell2[n])
+            return (cell1[n] < cell2[n] ? -1 : 1);
+    return (0);
+
+}
+
+static int compareEventByCell(const void *p1, const void *p2) {
+
+    int n1 = *(const int *) p1, n2 = *(const int *) p2;
+    int icomp;
+
+    if ((icomp = compareCell(ddEvent[n1].cell, ddEvent[n2].cell)) != 0)
+        return (icomp);
+    return (n1 < n2 ? -1 : (n1 > n2 ? 1 : 0));
+
+}
+
+static int compareInt(const void *p1, const void *p2) {
+
+    int n1 = *(const int *) p1, n2 = *(const int *) p2;
+
+    return (n1 < n2 ? -1 : (n1 > n2 ? 1 : 0));
+
+}
+
+/** function to set spatial index cell of event
+ *
+ * cells are cubes in x/y (z = 0), or on unit sphere for global mode, with side larger than
+ * maximum event distance, so that all events within maximum distance are in the 27 neighboring cells
+ */
+
+static void setEventCell(DDEvent *pevent, double cell_size) {
+
+    double pos[3], coslat;
+    int n;
+
+    if (GeometryMode == MODE_GLOBAL) {
+        coslat = cos(pevent->y * DE2RA);
+        pos[0] = coslat * cos(pevent->x * DE2RA);
+        pos[1] = coslat * sin(pevent->x * DE2RA);
+        pos[2] = sin(pevent->y * DE2RA);
+    } else {
+        pos[0] = pevent->x;
+        pos[1] = pevent->y;
+        pos[2] = 0.0;
+    }
+    for (n = 0; n < 3; n++)
+        pevent->cell[n] = (long) floor(pos[n] / cell_size);
+
+}
+
+/** function to return position of first event in ddEventByCell with cell >= cell */
+
+static int findFirstEventInCell(long *cell) {
+
+    int npos, nlow = 0, nhigh = numDDEvent;
+
+    while (nlow < nhigh) {
+        npos = (nlow + nhigh) / 2;
+        if (compareCell(ddEvent[ddEventByCell[npos]].cell, cell) < 0)
+            nlow = npos + 1;
+        else
+            nhigh = npos;
+    }
+
+    return (nlow);
+
+}
+
+/** function to return position of first arrival in ddArrivalByKey for event with key >= key */
+
+static int findFirstArrivalWithKey(DDEvent *pevent, int key) {
+
+    int npos, nlow = pevent->arr_start, nhigh = pevent->arr_start + pevent->num_arr;
+
+    while (nlow < nhigh) {
+        npos = (nlow + nhigh) / 2;
+        if (ddArrival[ddArrivalByKey[npos]].key < key)
+            nlow = npos + 1;
+        else
+            nhigh = npos;
+    }
+
+    return (nlow);
+
+}
 
 int ConvertLocToCT(int argc, char *argv[]) {
 
     int istat, i;
 
-    int nArrivals_read;
+    int nArrivals_read, nArrivals_total;
 
-    double event_dist_max, epi_dist;
+    double event_dist_max, epi_dist, cell_size;
 
     char fn_hyp_in[FILENAME_MAX], fn_root_out[FILENAME_MAX];
     char fn_hyp_out[FILENAME_MAX], fn_diff_out[FILENAME_MAX], fn_xyz_out[FILENAME_MAX];
@@ -136,12 +353,16 @@ int ConvertLocToCT(int argc, char *argv[]) {
     char test_str[10];
 
     GridDesc locgrid;
-    HypoDesc *phyp1, *phyp2;
+    static HypoDesc diffHypo;
 
     double weight, weight_min;
 
-    int nwritten, narr1, narr2;
-    ArrivalDesc *parr1, *parr2;
+    int nwritten, narr1, npos, npos_end, key;
+    int nevent1, nevent2, ncell[3], ncand, use_index;
+    int *candidate = NULL, numCandidate, maxCandidate = 0;
+    long cell[3];
+    DDEvent *pevent, *pevent1, *pevent2;
+    DDArrival *parr, *parr1, *parr2;
     long dd_event_id_1, dd_event_id_2;
 
     strcpy(test_str, ".hyp");
@@ -191,6 +412,7 @@ int ConvertLocToCT(int argc, char *argv[]) {
 
     nLocWritten = 0;
     nLocAccepted = 0;
+    nArrivals_total = 0;
     for (nHypo = 0; nHypo < numFiles; nHypo++) {
 
         // open hypocenter file
@@ -206,7 +428,8 @@ int ConvertLocToCT(int argc, char *argv[]) {
 
         while (1) {
 
-            istat = GetHypLoc(fp_hyp_in, fn_hyp_in_list[nHypo], diffHypos + nLocWritten, Arrival + NumArrivals,
+            // 20261018 AJL - arrivals of each event read into start of Arrival array
+            istat = GetHypLoc(fp_hyp_in, fn_hyp_in_list[nHypo], &diffHypo, Arrival,
                     &nArrivals_read, 1, &locgrid, 0);
             if (istat == EOF) {
                 fclose(fp_hyp_in);
@@ -218,42 +441,72 @@ int ConvertLocToCT(int argc, char *argv[]) {
                 GeometryMode = MODE_GLOBAL;
             }
 
-            if (strcmp(diffHypos[nLocWritten].locStat, "ABORTED") == 0) {
+            if (strcmp(diffHypo.locStat, "ABORTED") == 0) {
                 //nll_puterr("WARNING: location ABORTED, ignoring event");
-                if (VERBOSE > 0) fprintf(stdout, "Skip: diffHypos[nLocWritten].locStat, \"ABORTED\" %d\n", nLocWritten);
+                if (VERBOSE > 0) fprintf(stdout, "Skip: diffHypo.locStat, \"ABORTED\" %d\n", nLocWritten);
                 continue;
-            } else if (strcmp(diffHypos[nLocWritten].locStat, "REJECTED") == 0) {
+            } else if (strcmp(diffHypo.locStat, "REJECTED") == 0) {
                 //nll_puterr("WARNING: location REJECTED, ignoring event");
-                if (VERBOSE > 0) fprintf(stdout, "Skip: diffHypos[nLocWritten].locStat, \"REJECTED\" %d\n", nLocWritten);
+                if (VERBOSE > 0) fprintf(stdout, "Skip: diffHypo.locStat, \"REJECTED\" %d\n", nLocWritten);
                 continue;
             }
             nLocAccepted++;
 
 
-            diffHypos[nLocWritten].event_id = nLocWritten;
+            diffHypo.event_id = nLocWritten;
             weight = 0.0;
-            for (i = NumArrivals; i < NumArrivals + nArrivals_read; i++) {
+            for (i = 0; i < nArrivals_read; i++) {
                 Arrival[i].dd_event_id_1 = nLocWritten;
                 weight = Arrival[i].weight > weight ? Arrival[i].weight : weight;
             }
             // normalize weight
-            for (i = NumArrivals; i < NumArrivals + nArrivals_read; i++)
+            for (i = 0; i < nArrivals_read; i++)
                 Arrival[i].weight /= weight;
 
-            WriteLocation(fp_hyp_out, diffHypos + nLocWritten,
+            WriteLocation(fp_hyp_out, &diffHypo,
                     Arrival, nArrivals_read, fn_hyp_out, 0, 0, 0, &locgrid, 0);
-            nLocWritten++;
 
             // write end line and blank line
             fprintf(fp_hyp_out, "END_NLLOC\n\n");
 
-            NumArrivals += nArrivals_read;
-
-            if (nLocWritten >= MAX_NUM_DIFF_HYPOCENTERS) {
-                sprintf(MsgStr, "WARNING: maximum number of input hypocenters read, only first %d will be processed.", MAX_NUM_DIFF_HYPOCENTERS);
-                nll_puterr(MsgStr);
-                break;
+            // store event and arrivals that may be differenced
+            if (growArray((void **) &ddEvent, &maxDDEvent, numDDEvent + 1, sizeof (DDEvent)) < 0
+                    || growArray((void **) &ddArrival, &maxDDArrival, numDDArrival + nArrivals_read, sizeof (DDArrival)) < 0
+                    || growArray((void **) &ddArrivalByKey, &maxDDArrivalByKey, numDDArrival + nArrivals_read, sizeof (int)) < 0) {
+                nll_puterr("ERROR: allocating event or arrival arrays.");
+                return (-1);
             }
+            pevent = ddEvent + numDDEvent;
+            pevent->x = diffHypo.x;
+            pevent->y = diffHypo.y;
+            pevent->dlat = diffHypo.dlat;
+            pevent->dlong = diffHypo.dlong;
+            pevent->depth = diffHypo.depth;
+            pevent->arr_start = numDDArrival;
+            for (i = 0; i < nArrivals_read; i++) {
+                if (Arrival[i].weight < SMALL_DOUBLE)
+                    continue; // not used for location
+                if (Arrival[i].weight < weight_min)
+                    continue;
+                if (station_dist_max > 0.0 && Arrival[i].dist * DEG2KM > station_dist_max)
+                    continue;
+                parr = ddArrival + numDDArrival;
+                if ((parr->key = internDDKey(Arrival[i].label, Arrival[i].phase)) < 0) {
+                    nll_puterr("ERROR: allocating station and phase key arrays.");
+                    return (-1);
+                }
+                parr->event = numDDEvent;
+                parr->time = Arrival[i].pred_travel_time + Arrival[i].residual;
+                parr->weight = Arrival[i].weight;
+                ddArrivalByKey[numDDArrival] = numDDArrival;
+                numDDArrival++;
+            }
+            pevent->num_arr = numDDArrival - pevent->arr_start;
+            qsort(ddArrivalByKey + pevent->arr_start, pevent->num_arr, sizeof (int), compareArrivalByKey);
+            numDDEvent++;
+
+            nLocWritten++;
+            nArrivals_total += nArrivals_read;
 
         }
 
@@ -267,6 +520,32 @@ int ConvertLocToCT(int argc, char *argv[]) {
             "%d location files read, %d events accepted.\n", numFiles, nLocAccepted);
     fprintf(stdout, "%d locations written to ascii sumfile <%s>\n", nLocWritten, fn_hyp_out);
 
+    // index events in cells with side larger than event_dist_max
+    use_index = 0;
+    cell_size = 0.0;
+    if (event_dist_max > 0.0) {
+        if (GeometryMode == MODE_GLOBAL) {
+            // chord length on unit sphere
+            if (event_dist_max / AVG_ERAD < 0.9 * cPI)
+                cell_size = 2.0 * sin(0.5 * event_dist_max / AVG_ERAD);
+        } else {
+            cell_size = event_dist_max;
+        }
+        use_index = cell_size > 0.0;
+        cell_size *= 1.001; // margin for rounding
+    }
+    if (use_index) {
+        if ((ddEventByCell = (int *) malloc((numDDEvent > 0 ? numDDEvent : 1) * sizeof (int))) == NULL) {
+            nll_puterr("ERROR: allocating event index array.");
+            return (-1);
+        }
+        for (nevent1 = 0; nevent1 < numDDEvent; nevent1++) {
+            setEventCell(ddEvent + nevent1, cell_size);
+            ddEventByCell[nevent1] = nevent1;
+        }
+        qsort(ddEventByCell, numDDEvent, sizeof (int), compareEventByCell);
+    }
+
     // difference and write arrivals
 
     /* example:
@@ -277,102 +556,108 @@ int ConvertLocToCT(int argc, char *argv[]) {
     NCCAI     3.440   3.420 1.0000 P
      */
 
+    // pairs are written in order of first event, first event arrival, second event, second event arrival
+
     dd_event_id_1 = dd_event_id_2 = -1;
     nwritten = 0;
 
-    for (narr1 = 0; narr1 < NumArrivals; narr1++) {
+    for (nevent1 = 0; nevent1 < numDDEvent; nevent1++) {
 
-        fprintf(stdout, "Arr: %d/%d        \r", narr1, NumArrivals);
-        if (VERBOSE > 1) fprintf(stdout, "\n");
+        pevent1 = ddEvent + nevent1;
+        if (pevent1->num_arr < 1)
+            continue;
 
-        parr1 = Arrival + narr1;
+        fprintf(stdout, "Event: %d/%d        \r", nevent1, numDDEvent);
+        if (VERBOSE > 1) fprintf(stdout, "\n");
 
-        if (parr1->weight < SMALL_DOUBLE) {
-            if (VERBOSE > 1) fprintf(stdout, "Skip: parr1->weight < SMALL_DOUBLE %d %f\n", narr1, parr1->weight);
-            continue; // not used for location
+        // find later events within event_dist_max
+        numCandidate = 0;
+        if (use_index) {
+            for (ncell[0] = -1; ncell[0] <= 1; ncell[0]++) {
+                for (ncell[1] = -1; ncell[1] <= 1; ncell[1]++) {
+                    for (ncell[2] = -1; ncell[2] <= 1; ncell[2]++) {
+                        for (i = 0; i < 3; i++)
+                            cell[i] = pevent1->cell[i] + ncell[i];
+                        for (npos = findFirstEventInCell(cell); npos < numDDEvent; npos++) {
+                            nevent2 = ddEventByCell[npos];
+                            if (compareCell(ddEvent[nevent2].cell, cell) != 0)
+                                break;
+                            if (nevent2 <= nevent1 || ddEvent[nevent2].num_arr < 1)
+                                continue;
+                            if (growArray((void **) &candidate, &maxCandidate, numCandidate + 1, sizeof (int)) < 0) {
+                                nll_puterr("ERROR: allocating candidate event array.");
+                                return (-1);
+                            }
+                            candidate[numCandidate++] = nevent2;
+                        }
+                    }
+                }
+            }
+            qsort(candidate, numCandidate, sizeof (int), compareInt);
+        } else {
+            if (growArray((void **) &candidate, &maxCandidate, numDDEvent, sizeof (int)) < 0) {
+                nll_puterr("ERROR: allocating candidate event array.");
+                return (-1);
+            }
+            for (nevent2 = nevent1 + 1; nevent2 < numDDEvent; nevent2++)
+                if (ddEvent[nevent2].num_arr > 0)
+                    candidate[numCandidate++] = nevent2;
+        }
+        // check distance between events
+        if (event_dist_max > 0.0) {
+            for (ncand = 0, i = 0; ncand < numCandidate; ncand++) {
+                pevent2 = ddEvent + candidate[ncand];
+                // 20180612 AJL  epi_dist = Dist3D(phyp1->x, phyp2->x, phyp1->y, phyp2->y, 0.0, 0.0); // epi
+                epi_dist = Dist2D(pevent1->x, pevent2->x, pevent1->y, pevent2->y); // epi
+                if (epi_dist > event_dist_max) {
+                    if (VERBOSE > 1) fprintf(stdout, "Skip: epi_dist > event_dist_max %d %d\n", nevent1, candidate[ncand]);
+                    continue;
+                }
+                candidate[i++] = candidate[ncand];
+            }
+            numCandidate = i;
         }
 
-        for (narr2 = narr1 + 1; narr2 < NumArrivals; narr2++) {
+        for (narr1 = pevent1->arr_start; narr1 < pevent1->arr_start + pevent1->num_arr; narr1++) {
 
-            parr2 = Arrival + narr2;
+            parr1 = ddArrival + narr1;
+            key = parr1->key;
 
-            if (parr2->weight < SMALL_DOUBLE) {
-                if (VERBOSE > 1) fprintf(stdout, "Skip: narr2->weight < SMALL_DOUBLE %d %f\n", narr2, parr2->weight);
-                continue; // not used for location
-            }
+            for (ncand = 0; ncand < numCandidate; ncand++) {
 
-            if (parr1->dd_event_id_1 == parr2->dd_event_id_1) {
-                if (VERBOSE > 1) fprintf(stdout, "Skip: parr1->dd_event_id_1 == parr2->dd_event_id_1 %d %d\n", narr1, narr2);
-                continue; // same event
-            }
+                pevent2 = ddEvent + candidate[ncand];
 
-            if (strcmp(parr1->label, parr2->label)) {
-                if (VERBOSE > 1) fprintf(stdout, "Skip: strcmp(parr1->label, parr2->label) %d %d\n", narr1, narr2);
-                continue; // not same station
-            }
+                // arrivals of second event with same station and phase
+                npos_end = pevent2->arr_start + pevent2->num_arr;
+                for (npos = findFirstArrivalWithKey(pevent2, key);
+                        npos < npos_end && ddArrival[ddArrivalByKey[npos]].key == key; npos++) {
 
-            if (strcmp(parr1->phase, parr2->phase)) {
-                if (VERBOSE > 1) fprintf(stdout, "Skip: strcmp(parr1->phase, parr2->phase) %d %d\n", narr1, narr2);
-                continue; // not same phase
-            }
+                    parr2 = ddArrival + ddArrivalByKey[npos];
 
-            phyp1 = &(diffHypos[parr1->dd_event_id_1]);
-            phyp2 = &(diffHypos[parr2->dd_event_id_1]);
+                    weight = parr1->weight < parr2->weight ? parr1->weight : parr2->weight;
+                    if (VERBOSE > 1) fprintf(stdout, "Accept: %d w %f  %d w %f\n", narr1, parr1->weight, ddArrivalByKey[npos], parr2->weight);
 
-            // check distance between events
-            if (event_dist_max > 0.0) {
-                // 20180612 AJL  epi_dist = Dist3D(phyp1->x, phyp2->x, phyp1->y, phyp2->y, 0.0, 0.0); // epi
-                epi_dist = Dist2D(phyp1->x, phyp2->x, phyp1->y, phyp2->y); // epi
-                //phyp1->z, phyp2->z);  // hypo
-                if (epi_dist > event_dist_max) {
-                    if (VERBOSE > 1) fprintf(stdout, "Skip: epi_dist > event_dist_max %d %d\n", narr1, narr2);
-                    continue;
-                }
-            }
+                    // write event line if needed
+                    if (!(parr1->event == dd_event_id_1
+                            && parr2->event == dd_event_id_2)) {
+                        dd_event_id_1 = parr1->event;
+                        dd_event_id_2 = parr2->event;
+                        fprintf(fp_diff_out, "# %8ld %8ld\n", dd_event_id_1, dd_event_id_2);
+                    }
 
-            // check distance between station and events
-            if (station_dist_max > 0.0) {
-                if (parr1->dist * DEG2KM > station_dist_max) {
-                    if (VERBOSE > 1) fprintf(stdout, "Skip: parr1->dist > station_dist_max %d\n", narr1);
-                    continue;
-                }
-                if (parr2->dist * DEG2KM > station_dist_max) {
-                    if (VERBOSE > 1) fprintf(stdout, "Skip: parr1->dist > station_dist_max %d\n", narr2);
-                    continue;
-                }
-            }
+                    // write phase line
+                    fprintf(fp_diff_out, "%-7s %7.3lf %7.3lf %6.4lf %4s\n",
+                            ddKey[key].label, parr1->time, parr2->time, weight, ddKey[key].phase);
 
-            // check weight
-            //printf("%d/%d  parr1->weight %f  parr2->weight %f -> ", narr1, narr2, parr1->weight, parr2->weight);
-            weight = parr1->weight < parr2->weight ? parr1->weight : parr2->weight;
-            if (weight < weight_min) {
-                //printf("REJECT\n");
-                if (VERBOSE > 1) fprintf(stdout, "Skip: weight < weight_min %d %f %d %f\n", narr1, parr1->weight, narr2, parr2->weight);
-                continue;
-            }
-            //printf("Accept\n");
-            if (VERBOSE > 1) fprintf(stdout, "Accept: %d w %f  %d w %f\n", narr1, parr1->weight, narr2, parr2->weight);
-
-            // write event line if needed
-            if (!(parr1->dd_event_id_1 == dd_event_id_1
-                    && parr2->dd_event_id_1 == dd_event_id_2)) {
-                dd_event_id_1 = parr1->dd_event_id_1;
-                dd_event_id_2 = parr2->dd_event_id_1;
-                fprintf(fp_diff_out, "# %8ld %8ld\n", dd_event_id_1, dd_event_id_2);
-            }
+                    fprintf(fp_xyz_out, "> GMT_LATLONDEPTH\n");
+                    fprintf(fp_xyz_out, "%lf %lf %lf\n", pevent1->dlat, pevent1->dlong, pevent1->depth);
+                    fprintf(fp_xyz_out, "%lf %lf %lf\n", pevent2->dlat, pevent2->dlong, pevent2->depth);
 
-            // write phase line
-            fprintf(fp_diff_out, "%-7s %7.3lf %7.3lf %6.4lf %4s\n",
-                    parr1->label,
-                    parr1->pred_travel_time + parr1->residual,
-                    parr2->pred_travel_time + parr2->residual,
-                    weight, parr1->phase);
+                    nwritten++;
 
-            fprintf(fp_xyz_out, "> GMT_LATLONDEPTH\n");
-            fprintf(fp_xyz_out, "%lf %lf %lf\n", phyp1->dlat, phyp1->dlong, phyp1->depth);
-            fprintf(fp_xyz_out, "%lf %lf %lf\n", phyp2->dlat, phyp2->dlong, phyp2->depth);
+                }
 
-            nwritten++;
+            }
 
         }
 
@@ -384,11 +669,16 @@ int ConvertLocToCT(int argc, char *argv[]) {
     fclose(fp_diff_out);
 
     fprintf(stdout, "%d arrivals differenced, %d dd written to ct file <%s>\n",
-            NumArrivals, nwritten, fn_diff_out);
+            nArrivals_total, nwritten, fn_diff_out);
+
+    free(candidate);
+    free(ddEventByCell);
+    free(ddArrivalByKey);
+    free(ddArrival);
+    free(ddEvent);
+    free(ddKeyHash);
+    free(ddKey);
 
     return (0);
 
 }
-
-
-
@@ -79,9 +79,15 @@ GridDesc ssst_time_grid_template;
 // LocNode array
 int NumLocNodes;
 LocNode *LocNodeArray[MAX_NUM_INPUT_FILES];
-// PhsNode array
-int NumPhsNodes;
-PhsNode *PhsNodeArray[MAX_NUM_ARRIVALS_LOC2SSST];
+// 20261018 AJL - station/phase arrivals snapshot, replaces PhsNode list and array, read only during grid calculation
+typedef struct {
+    double x, y, z; // event location (long, lat, z for global mode)
+    double corr; // arrival residual + delay
+}
+SSSTObs;
+int NumSSSTObs;
+int MaxSSSTObs;
+SSSTObs *SSSTObsArray;
 
 // station list input line can be very long
 #define MAX_LEN_STATION_LINE 64000
@@ -119,8 +125,7 @@ int iSwapBytesOnInput;
 int GenSSST(int argc, char** argv);
 int ReadLoc2ssstInput(FILE*);
 int DoLoc2ssst();
-double get_ssst_value(double xval, double yval, double zval,
-        PhsNode **phs_node_array, int num_phs_nodes, LocNode **loc_node_array, int num_loc_nodes, LS_Params *pparams);
+double get_ssst_value(double xval, double yval, double zval, SSSTObs *ssst_obs_array, int num_ssst_obs, LS_Params *pparams);
 int open_traveltime_grid(ArrivalDesc* parr, char *fn_time_grid_input, char *stacode, char *phasecode, double vp_vs_ratio, double *ptfact);
 int add_ssst_to_traveltime_grid(char *phasecode, char *stacode, GridDesc *pssst_grid, GridDesc *ptraveltime_grid, GridDesc *pssst_time_grid, SourceDesc* psrce, double tfact);
 int GenAngleGrid(GridDesc* ptgrid, SourceDesc* psource, char *filename, GridDesc* pagrid, int angle_mode);
@@ -131,6 +136,9 @@ int GenAngleGrid(GridDesc* ptgrid, SourceDesc* psource, char *filename, GridDesc
 #define PNAME  "Loc2ssst"
 #define NARGS 2
 
+// 20261019 AJL - main() omitted if LOC2SSST_NO_MAIN defined, used by bench/bench_ssst.c to time get_ssst_value()
+#ifndef LOC2SSST_NO_MAIN
+
 int main(int argc, char** argv) {
 
     int istat;
@@ -189,6 +197,8 @@ int main(int argc, char** argv) {
 
 }
 
+#endif
+
 /*** function to read input file name ***/
 
 int get_ls_inpfile(char* line1) {
@@ -637,7 +647,6 @@ int DoLoc2ssst() {
     int nHypos;
 
     LocNode *loc_list_head = NULL; // root node of location list
-    PhsNode *phs_list_head = NULL; // root node of station/phase arrivals list
 
     char arrival_phase[PHASE_LABEL_LEN];
 
@@ -814,6 +823,25 @@ int DoLoc2ssst() {
     // convert source location coordinates
     istat = ConvertSourceLoc(0, StationPhaseList, NumStationPhases, 1, 1);
 
+    // put locations in array for efficiency
+    // 20261018 AJL - array filled once in a single pass over location list, was re-built by id search for each station/phase
+    LocNode* locNode = NULL;
+    NumLocNodes = 0;
+    if (loc_list_head != NULL) {
+        locNode = loc_list_head;
+        do {
+            if (locNode->id < 0 || locNode->id >= MAX_NUM_INPUT_FILES) {
+                snprintf(MsgStr, sizeof (MsgStr), "ERROR: size LocNodeArray exceeded, only first phases %d will be processed.", MAX_NUM_INPUT_FILES);
+                nll_puterr(MsgStr);
+                continue;
+            }
+            LocNodeArray[locNode->id] = locNode;
+            if (locNode->id >= NumLocNodes)
+                NumLocNodes = locNode->id + 1;
+        } while ((locNode = locNode->next) != loc_list_head);
+    }
+    int latlon = GeometryMode == MODE_GLOBAL;
+
     SourceDesc *station_phase;
     char stacode[SOURCE_LABEL_LEN];
     char phasecode[SOURCE_LABEL_LEN];
@@ -860,12 +888,13 @@ int DoLoc2ssst() {
         } else if (IsPhaseID(phasecode, "S")) {
             residualmax = PhsStat.SResidualMax;
         }
-        LocNode* locNode = NULL;
-        int loc_id = 0;
-        int phs_id = 0;
-        while ((locNode = getLocationFromLocList(loc_list_head, loc_id)) != NULL) {
-            ArrivalDesc* parrivals = locNode->plocation->parrivals;
-            int narrivals = locNode->plocation->narrivals;
+        // 20261018 AJL - arrivals for this station/phase copied to snapshot array of event locations and corrections,
+        //    in location id and arrival order, replaces PhsNode list
+        NumSSSTObs = 0;
+        for (int loc_id = 0; loc_id < NumLocNodes; loc_id++) {
+            HypoDesc* phypo = LocNodeArray[loc_id]->plocation->phypo;
+            ArrivalDesc* parrivals = LocNodeArray[loc_id]->plocation->parrivals;
+            int narrivals = LocNodeArray[loc_id]->plocation->narrivals;
             // loop over arrivals, look for arrival for this stacode and phasecode
             ArrivalDesc* parr;
             for (int narr = 0; narr < narrivals; narr++) {
@@ -874,65 +903,82 @@ int DoLoc2ssst() {
                     //nll_puterr("WARNING: residual is greater than residualmax, ignoring arrival");
                     continue;
                 }
-                int addDuplicates = 1;
-                PhsNode *phsNode = addArrivalToPhaseList(&phs_list_head, parr, phs_id, addDuplicates);
-                addRemoveLocationInAssocLocationsList(phsNode, loc_id, 1);
-                //printf("DEBUG: addRemoveLocationInAssocLocationsList phs_id %d loc_id%d\n", phs_id, phsNode->passoc_locations[0]);
-                phs_id++;
-            }
-            loc_id++;
-        }
-        // put locations in array for efficiency
-        NumLocNodes = 0;
-        while ((locNode = getLocationFromLocList(loc_list_head, NumLocNodes)) != NULL) {
-            if (NumLocNodes >= MAX_NUM_INPUT_FILES) {
-                snprintf(MsgStr, sizeof (MsgStr), "ERROR: size LocNodeArray exceeded, only first phases %d will be processed.", MAX_NUM_INPUT_FILES);
-                nll_puterr(MsgStr);
-                break;
-            }
-            LocNodeArray[NumLocNodes++] = locNode;
-        }
-        // put phases in array for efficiency
-        PhsNode *phsNode;
-        NumPhsNodes = 0;
-        while ((phsNode = getPhsNodeFromPhaseList(phs_list_head, NumPhsNodes)) != NULL) {
-            if (NumPhsNodes >= MAX_NUM_ARRIVALS_LOC2SSST) {
-                snprintf(MsgStr, sizeof (MsgStr), "ERROR: size PhsNodeArray exceeded, only first %d phases will be processed.", MAX_NUM_ARRIVALS_LOC2SSST);
-                nll_puterr(MsgStr);
-                break;
+                if (NumSSSTObs >= MaxSSSTObs) {
+                    int max_new = MaxSSSTObs > 0 ? 2 * MaxSSSTObs : 1024;
+                    SSSTObs *ptmp = (SSSTObs *) realloc(SSSTObsArray, max_new * sizeof (SSSTObs));
+                    if (ptmp == NULL) {
+                        nll_puterr("ERROR: allocating station/phase arrivals array.");
+                        return (-1);
+                    }
+                    SSSTObsArray = ptmp;
+                    MaxSSSTObs = max_new;
+                }
+                SSSTObs *pobs = SSSTObsArray + NumSSSTObs++;
+                if (latlon) {
+                    pobs->x = phypo->dlong;
+                    pobs->y = phypo->dlat;
+                } else {
+                    pobs->x = phypo->x;
+                    pobs->y = phypo->y;
+                }
+                pobs->z = phypo->z;
+                pobs->corr = parr->residual + parr->delay;
             }
-            PhsNodeArray[NumPhsNodes++] = phsNode;
         }
-        // clean up
-        // 20201104 AJL - Buf fix: moved this free to end of block, PhsNodeArray points to allocations made in addArrivalToPhaseList()
-        //freePhaseList(phs_list_head, 0);
-        //phs_list_head = NULL;
 
         //display_grid_param(pssst_grid);
 
         // get ssst corrections for this station/phase
+        // 20261018 AJL - ix sheets calculated in parallel if compiled with OpenMP
         int ix, iy, iz;
         GRID_FLOAT_TYPE xval, yval, zval, ssstval = 0.0, ssstval_sum = 0.0;
+        GRID_FLOAT_TYPE *xval_array = (GRID_FLOAT_TYPE *) malloc(pssst_grid->numx * sizeof (GRID_FLOAT_TYPE));
+        if (xval_array == NULL) {
+            nll_puterr("ERROR: allocating SSST grid x coordinates array.");
+            return (-1);
+        }
         xval = pssst_grid->origx;
         for (ix = 0; ix < pssst_grid->numx; ix++) {
-            fprintf(stdout, "\r%d%%  ", (int) (0.5 + 100.0 * ((float) ix / (pssst_grid->numx - 1))));
-            fflush(stdout);
+            xval_array[ix] = xval;
+            xval += pssst_grid->dx;
+        }
+        int nsheets_done = 0;
+#ifdef _OPENMP
+#pragma omp parallel for private(ix, iy, iz, yval, zval, ssstval) schedule(dynamic, 1)
+#endif
+        for (ix = 0; ix < pssst_grid->numx; ix++) {
             yval = pssst_grid->origy;
             for (iy = 0; iy < pssst_grid->numy; iy++) {
                 //fprintf(stdout, "\rx%d%% y%d%%  ", (int) (0.5 + 100.0 * ((float) ix / pssst_grid->numx)), (int) (0.5 + 100.0 * ((float) iy / pssst_grid->numy)));
                 //fflush(stdout);
                 zval = pssst_grid->origz;
                 for (iz = 0; iz < pssst_grid->numz; iz++) {
-                    ssstval = (GRID_FLOAT_TYPE) get_ssst_value(xval, yval, zval, PhsNodeArray, NumPhsNodes, LocNodeArray, NumLocNodes, &Params);
+                    ssstval = (GRID_FLOAT_TYPE) get_ssst_value(xval_array[ix], yval, zval, SSSTObsArray, NumSSSTObs, &Params);
                     if (ssstval > -LARGE_FLOAT) {
                         ((GRID_FLOAT_TYPE ***) pssst_grid->array)[ix][iy][iz] = ssstval;
                     }
-                    ssstval_sum += ssstval;
                     zval += pssst_grid->dz;
                 }
                 yval += pssst_grid->dy;
             }
-            xval += pssst_grid->dx;
+#ifdef _OPENMP
+#pragma omp critical (ssst_progress)
+#endif
+            {
+                fprintf(stdout, "\r%d%%  ", (int) (0.5 + 100.0 * ((float) nsheets_done / (pssst_grid->numx - 1))));
+                fflush(stdout);
+                nsheets_done++;
+            }
+        }
+        free(xval_array);
+        // sum in node order after parallel calculation, get_ssst_value() always returns a valid value
+        for (ix = 0; ix < pssst_grid->numx; ix++) {
+            for (iy = 0; iy < pssst_grid->numy; iy++) {
+                for (iz = 0; iz < pssst_grid->numz; iz++) {
+                    ssstval = ((GRID_FLOAT_TYPE ***) pssst_grid->array)[ix][iy][iz];
+                    ssstval_sum += ssstval;
+                }
+            }
         }
         fprintf(stdout, "ssstval: mean: %f last: %f\n", ssstval_sum / (double) (pssst_grid->numx * pssst_grid->numy * pssst_grid->numz), ssstval);
 
@@ -1044,11 +1090,6 @@ int DoLoc2ssst() {
         sprintf(MsgStr, "Grid2GMT cpt file written to: %s", "Grid2GMT_SSST.cpt");
         nll_putmsg(1, MsgStr);
 
-        // clean up
-        // 20201104 AJL - Buf fix: moved this free from above
-        freePhaseList(phs_list_head, 0);
-        phs_list_head = NULL;
-
     }
 
     return (0);
@@ -1057,8 +1098,7 @@ int DoLoc2ssst() {
 
 /** function to calculate ssst correction value at an xyz point for a specified station and phase */
 
-double get_ssst_value(double xval, double yval, double zval,
-        PhsNode **phs_node_array, int num_phs_nodes, LocNode **loc_node_array, int num_loc_nodes, LS_Params *pparams) {
+double get_ssst_value(double xval, double yval, double zval, SSSTObs *ssst_obs_array, int num_ssst_obs, LS_Params *pparams) {
 
     double char_dist2 = pparams->char_dist * pparams->char_dist;
     double weight_floor = pparams->weight_floor;
@@ -1067,29 +1107,16 @@ double get_ssst_value(double xval, double yval, double zval,
     double ssst_wt_sum = 0.0;
     int nssst_corr = 0;
 
-    // loop over phase node arrivals, look for arrival for this stacode and phasecode
+    // loop over station/phase arrivals
 
-    double xloc, yloc, zloc;
     int latlon = GeometryMode == MODE_GLOBAL;
-    LocNode *locNode = NULL;
-    PhsNode *phsNode = NULL;
-    for (int nphs = 0; nphs < num_phs_nodes; nphs++) {
-
-        phsNode = *(phs_node_array + nphs);
-
-        //printf("\nDEBUG: phsNode %d ->passoc_locations[0] %d\n", phs_id, phsNode->passoc_locations[0]);
-        locNode = *(loc_node_array + phsNode->passoc_locations[0]);
-        if (latlon) {
-            xloc = locNode->plocation->phypo->dlong;
-            yloc = locNode->plocation->phypo->dlat;
-            zloc = locNode->plocation->phypo->z;
-        } else {
-            xloc = locNode->plocation->phypo->x;
-            yloc = locNode->plocation->phypo->y;
-            zloc = locNode->plocation->phypo->z;
-        }
+    SSSTObs *pobs = NULL;
+    for (int nobs = 0; nobs < num_ssst_obs; nobs++) {
+
+        pobs = ssst_obs_array + nobs;
+
         // get distance from event to center of node
-        double event_node_dist2 = Dist3D2_Loc2ssst(xloc, xval, yloc, yval, zloc, zval, latlon);
+        double event_node_dist2 = Dist3D2_Loc2ssst(pobs->x, xval, pobs->y, yval, pobs->z, zval, latlon);
         //event_node_dist = Dist2D(xloc, xval, yloc, yval); // TEST ONLY!
         // get weight
         double weight = exp(-(event_node_dist2 / char_dist2));
@@ -1097,13 +1124,12 @@ double get_ssst_value(double xval, double yval, double zval,
         //if (weight < weight_floor) {
         //    weight = weight_floor;
         //}
-        ArrivalDesc* parr = phsNode->parrival;
-        ssst_corr_sum += (parr->residual + parr->delay) * weight;
+        ssst_corr_sum += pobs->corr * weight;
         ssst_wt_sum += weight;
         nssst_corr++;
         //if (fabs(xval - 0.0) < 0.01 && fabs(yval - 0.0) < 0.01 && fabs(zval - 5.0) < 0.01) {
         //if (fabs(xval - -103.5) < 0.05 && fabs(yval - 31.4) < 0.01 && fabs(zval - 5.0) < 0.05) {
-        //printf("\nDEBUG: phs_id %d xval %f yval %f zval %f xloc %f yloc %f zloc %f parr->residual %f parr->delay %f dist %f weight %f ssst_corr_sum %f \n", nphs, xval, yval, zval, xloc, yloc, zloc, parr->residual, parr->delay, sqrt(event_node_dist2), weight, ssst_corr_sum);
+        //printf("\nDEBUG: nobs %d xval %f yval %f zval %f xloc %f yloc %f zloc %f corr %f dist %f weight %f ssst_corr_sum %f \n", nobs, xval, yval, zval, pobs->x, pobs->y, pobs->z, pobs->corr, sqrt(event_node_dist2), weight, ssst_corr_sum);
         //}
 
     }
@@ -1269,11 +1295,32 @@ int add_ssst_to_traveltime_grid(char *phasecode, char *stacode, GridDesc *pssst_
         is3D = 1;
     }
 
+    // 20261018 AJL - ix sheets calculated in parallel if compiled with OpenMP and grids are not cascading
+    //    or cascading grids use precomputed z level interpolation (no allocations in ReadGrid3dValue_Cascading_Interp)
+    int parallel = (!isCascadingGrid(ptraveltime_grid)
+            || (ptraveltime_grid->array != NULL && ptraveltime_grid->gridDesc_Cascading.zlevel != NULL))
+            && (!isCascadingGrid(pssst_grid)
+            || (pssst_grid->array != NULL && pssst_grid->gridDesc_Cascading.zlevel != NULL));
     int debug_count = 0;
     int ix, iy, iz;
-    double xval, yval, zval, ttval, arrival_dist = -1.0, ssst_corr;
+    double xval, yval, zval;
+    double *xval_array = (double *) malloc(pssst_time_grid->numx * sizeof (double));
+    if (xval_array == NULL) {
+        nll_puterr("ERROR: allocating SSST time grid x coordinates array.");
+        return (-1);
+    }
     xval = pssst_time_grid->origx;
     for (ix = 0; ix < pssst_time_grid->numx; ix++) {
+        xval_array[ix] = xval;
+        xval += pssst_time_grid->dx;
+    }
+#ifdef _OPENMP
+#pragma omp parallel for private(ix, iy, iz, xval, yval, zval) schedule(dynamic, 1) if(parallel)
+#endif
+    for (ix = 0; ix < pssst_time_grid->numx; ix++) {
+        double ttval, arrival_dist = -1.0, ssst_corr;
+        int ndebug;
+        xval = xval_array[ix];
         yval = pssst_time_grid->origy;
         for (iy = 0; iy < pssst_time_grid->numy; iy++) {
             //fprintf(stdout, "\rx%d/%d y%d/%d  ", ix, pssst_time_grid->numx, iy, pssst_time_grid->numy);
@@ -1288,7 +1335,11 @@ int add_ssst_to_traveltime_grid(char *phasecode, char *stacode, GridDesc *pssst_
                             GeometryMode == MODE_GLOBAL ? arrival_dist * KM2DEG : arrival_dist, zval);
                 }
                 if (ttval < -LARGE_FLOAT) {
-                    if (debug_count++ < 10) {
+#ifdef _OPENMP
+#pragma omp atomic capture
+#endif
+                    ndebug = debug_count++;
+                    if (ndebug < 10) {
                         printf("DEBUG ERROR: ttval < -LARGE_FLOAT: %s %s  is3D %d, xval %f, yval %f, zval %f, ttval %f, arrival_dist %f\n",
                                 phasecode, stacode, is3D, xval, yval, zval, ttval, arrival_dist);
                     }
@@ -1297,7 +1348,11 @@ int add_ssst_to_traveltime_grid(char *phasecode, char *stacode, GridDesc *pssst_
                 } else {
                     ssst_corr = ReadAbsInterpGrid3d(NULL, pssst_grid, xval, yval, zval, 1);
                     if (ssst_corr < -LARGE_FLOAT) {
-                        if (debug_count++ < 10) {
+#ifdef _OPENMP
+#pragma omp atomic capture
+#endif
+                        ndebug = debug_count++;
+                        if (ndebug < 10) {
                             printf("DEBUG ERROR: ssst_corr < -LARGE_FLOAT: %s %s  is3D %d, xval %f, yval %f, zval %f\n",
                                     phasecode, stacode, is3D, xval, yval, zval);
                         }
@@ -1305,7 +1360,11 @@ int add_ssst_to_traveltime_grid(char *phasecode, char *stacode, GridDesc *pssst_
                     }
                 }
                 if (fabs(ttval * tfact + ssst_corr) < SMALL_FLOAT) {
-                    if (debug_count++ < 10) {
+#ifdef _OPENMP
+#pragma omp atomic capture
+#endif
+                    ndebug = debug_count++;
+                    if (ndebug < 10) {
                         printf("DEBUG ERROR: fabs(ttval * tfact + ssst_corr) < SMALL_FLOAT: %s %s  is3D %d, xval %f, yval %f, zval %f\n",
                                 phasecode, stacode, is3D, xval, yval, zval);
                     }
@@ -1315,8 +1374,8 @@ int add_ssst_to_traveltime_grid(char *phasecode, char *stacode, GridDesc *pssst_
             }
             yval += pssst_time_grid->dy;
         }
-        xval += pssst_time_grid->dx;
     }
+    free(xval_array);
     if (debug_count > 0) {
         printf("DEBUG ERROR: %d total errors\n", debug_count);
     }
@@ -39,6 +39,9 @@
                         // make fn_hyp_in_list static to avoid stack overflow problem (F Tilmann) - previously //
                         // Add fclose(fp_hypo) to for loop over all events as otherwise run out of file pointers after about
                             1000 events
+                   20261018 AJL Streaming summation: no limit on number of input files (MAX_NUM_INPUT_FILES no longer used),
+                        scatter samples of a window of accepted events read, decimated and formatted in parallel (OpenMP),
+                        output written in event order, memory independent of number of events
 
 .........1.........2.........3.........4.........5.........6.........7.........8
 
@@ -47,6 +50,11 @@
 
 
 #include "GridLib.h"
+#include "nll_scat.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 /* defines */
@@ -63,16 +71,67 @@ also: (gcc (GCC) 4.4.4 20100630 (Red Hat 4.4.4-10)   Kernel: 2.6.32.26-175.fc12.
  Frederik Tilmann */
 //#define MAX_NUM_INPUT_FILES 32000
 // 20170210 AJL - reset to 50k
-#define MAX_NUM_INPUT_FILES 50000
+//#define MAX_NUM_INPUT_FILES 50000
+// 20261018 AJL - no longer used, no limit on number of input files
+
+
+// 20261018 AJL - number of accepted events per thread whose scatter samples are processed together
+#define SUM_WINDOW_EVENTS_PER_THREAD 4
+
+// size of output file buffers
+#define SUM_OUTPUT_BUFFER_SIZE (1024 * 1024)
 
 
 /* globals */
 
 
 
+/* typedefs */
+
+/* accepted event waiting to be written */
+typedef struct {
+    HypoDesc hypo;
+    GridDesc locgrid;
+    ArrivalDesc *arrivals;
+    int narrivals;
+    char map_proj_str[2 * MAXLINE]; // TRANSFORM of event, MapProjStr is overwritten by GetHypLoc()
+    char fn_scatter_root[FILENAME_MAX];
+    // scatter samples, set by ReadEventScatter()
+    int scat_status; // 0 = ok, -1 = error opening, -2 = error reading, -3 = memory allocation error
+    char fn_scatter[FILENAME_MAX];
+    int compressed;
+    int npoints; // samples in input scatter file
+    int npoints_read; // samples read from input scatter file
+    int nsamples; // decimated samples
+    float *samples; // decimated samples, not set if compressed blocks are copied
+    ScatterBlockList blocks; // encoded input blocks, set only if compressed blocks are copied
+    double quantum; // quantum for re-encoded samples, from input container or geometry of event
+    float probmax; // maximum value of decimated samples
+    char *text; // decimated samples as ascii text lines
+    size_t text_len, text_size;
+}
+SumEvent;
+
+/* summation output files and totals */
+typedef struct {
+    FILE *fp_hyp_scat_out;
+    char *fn_hyp_scat_out;
+    FILE *fp_scat_out; // raw scatter output, or NULL if scat_writer
+    ScatterWriter *scat_writer; // compressed scatter output
+    char *fn_scat_out;
+    int num_decim;
+    float probmax;
+    long num_points_tot, num_points_read, num_points_written;
+}
+SumOutput;
+
+
 /* functions */
 
 int SumLocations(int argc, char** argv);
+void ReadEventScatter(SumEvent *pevent, int num_decim, int copy_blocks);
+void WriteSumEvent(SumOutput *pout, SumEvent *pevent, int copy_blocks);
+void ProcessSumWindow(SumOutput *pout, SumEvent *window, int nwindow, int copy_blocks);
 
 
 
@@ -143,8 +202,6 @@ int SumLocations(int argc, char** argv) {
 
     int istat;
     int num_decim;
-    int npt, npoints;
-    long num_points_tot = 0L, num_points_read = 0L, num_points_written = 0L;
 
     char *pchr;
     char sys_string[FILENAME_MAX];
@@ -156,13 +213,15 @@ int SumLocations(int argc, char** argv) {
     char fn_root_out[FILENAME_MAX], fn_hypos_in[FILENAME_MAX],
             fn_scat_out[FILENAME_MAX];
     FILE *fp_hypo, *fp_dummy, *fp_hyp_sum_out, *fp_hyp_scat_out, *fp_scat_out,
-            *fp_scat_in, *fp_grid, *fp_hdr;
-    float fdata[4], probmax = -VERY_LARGE_FLOAT;
+            *fp_grid, *fp_hdr;
+    float fdata[4];
+    // 20261018 AJL - scatter samples read and written in blocks, compressed scatter containers (.scatz) supported
+    ScatterReader *scat_reader;
+    ScatterWriter *scat_writer = NULL;
 
     int nFile, numFiles, nLocWritten, nLocAccepted;
-    //char fn_hyp_in_list[MAX_NUM_INPUT_FILES][FILENAME_MAX];
-    // make fn_hyp_in_list static to avoid stack overflow problem (F Tilmann) //
-    static char fn_hyp_in_list[MAX_NUM_INPUT_FILES][FILENAME_MAX];
+    // 20261018 AJL - input file list allocated, no limit on number of files
+    char **fn_hyp_in_list;
     char test_str[10];
 
     double Len3Max, ProbMin, RMSMax;
@@ -185,9 +244,8 @@ int SumLocations(int argc, char** argv) {
     int CUT_RADIUS_YX = 3;
     int CUT_RADIUS_LATLON = 4;
 
-    GridDesc Grid, locgrid;
+    GridDesc Grid;
     SourceDesc* Srce = NULL;
-    HypoDesc Hypo;
 
 
     strcpy(test_str, ".hyp");
@@ -290,6 +348,8 @@ int SumLocations(int argc, char** argv) {
         nll_puterr("ERROR: opening hypocenter sum output file.");
         return (-1);
     }
+    // 20261018 AJL - large output buffers, set before any other operation on stream
+    setvbuf(fp_hyp_sum_out, NULL, _IOFBF, SUM_OUTPUT_BUFFER_SIZE);
 
     /* open ascii hypocenter/scatter file */
 
@@ -298,31 +358,66 @@ int SumLocations(int argc, char** argv) {
         nll_puterr("ERROR: opening hypocenter/scatter ascii output file.");
         return (-1);
     }
-
-    /* open scatter file */
-
-    snprintf(fn_scat_out, sizeof(fn_scat_out), "%s.scat", fn_root_out);
-    if ((fp_scat_out = fopen(fn_scat_out, "w")) == NULL) {
-        nll_puterr("ERROR: opening scatter output file.");
-        return (-1);
-    }
-    /* skip header record */
-    fseek(fp_scat_out, 4 * sizeof (float), SEEK_SET);
-
+    setvbuf(fp_hyp_scat_out, NULL, _IOFBF, SUM_OUTPUT_BUFFER_SIZE);
 
     /* sum requested grid files into output grid */
 
     /* check for wildcards in input file name */
     strcat(fn_hypos_in, test_str);
-    if ((numFiles = ExpandWildCards(fn_hypos_in, fn_hyp_in_list, MAX_NUM_INPUT_FILES)) < 1) {
+    if ((numFiles = ExpandWildCardsList(fn_hypos_in, &fn_hyp_in_list)) < 1) {
         nll_puterr("ERROR: no matching .hyp files found.");
         return (-1);
     }
-    if (numFiles >= MAX_NUM_INPUT_FILES) {
-        sprintf(MsgStr, "WARNING: maximum number of event files exceeded, only first %d will be processed.", MAX_NUM_INPUT_FILES);
-        nll_puterr(MsgStr);
-    }
 
+    /* open scatter file */
+
+    // 20261018 AJL - write compressed scatter container if first input event scatter file is compressed
+    strcpy(fn_scatter, fn_hyp_in_list[0]);
+    pchr = strstr(fn_scatter, test_str);
+    if (pchr != NULL)
+        *pchr = '\0';
+    scat_reader = OpenEventScatterReader(fn_scatter, filename);
+    if (scat_reader != NULL && scat_reader->compressed) {
+        snprintf(fn_scat_out, sizeof(fn_scat_out), "%s.scatz", fn_root_out);
+        if ((scat_writer = OpenScatterWriter(fn_scat_out, 0.0, 0.0, 0.0, SCATZ_QUANTUM_KM)) == NULL) {
+            nll_puterr("ERROR: opening scatter output file.");
+            return (-1);
+        }
+        fp_scat_out = NULL;
+    } else {
+        snprintf(fn_scat_out, sizeof(fn_scat_out), "%s.scat", fn_root_out);
+        if ((fp_scat_out = fopen(fn_scat_out, "w")) == NULL) {
+            nll_puterr("ERROR: opening scatter output file.");
+            return (-1);
+        }
+        setvbuf(fp_scat_out, NULL, _IOFBF, SUM_OUTPUT_BUFFER_SIZE);
+        /* skip header record */
+        fseek(fp_scat_out, 4 * sizeof (float), SEEK_SET);
+    }
+    CloseScatterReader(scat_reader);
+
+    SumOutput sum_out;
+    sum_out.fp_hyp_scat_out = fp_hyp_scat_out;
+    sum_out.fn_hyp_scat_out = fn_hyp_scat_out;
+    sum_out.fp_scat_out = fp_scat_out;
+    sum_out.scat_writer = scat_writer;
+    sum_out.fn_scat_out = fn_scat_out;
+    sum_out.num_decim = num_decim;
+    sum_out.probmax = -VERY_LARGE_FLOAT;
+    sum_out.num_points_tot = sum_out.num_points_read = sum_out.num_points_written = 0L;
+    int copy_blocks = scat_writer != NULL && num_decim == 1;
+
+    // 20261018 AJL - window of accepted events, scatter samples processed in parallel, then events written in order
+    int num_window = SUM_WINDOW_EVENTS_PER_THREAD;
+#ifdef _OPENMP
+    num_window *= omp_get_max_threads();
+#endif
+    int nwindow = 0;
+    SumEvent *window;
+    if ((window = calloc(num_window, sizeof (SumEvent))) == NULL) {
+        nll_puterr("ERROR: allocating event window.");
+        return (-1);
+    }
 
     nLocWritten = 0;
     nLocAccepted = 0;
@@ -342,7 +437,9 @@ int SumLocations(int argc, char** argv) {
 
         while (1) {
 
-            istat = GetHypLoc(fp_hypo, NULL, &Hypo, Arrival, &NumArrivals, 1, &locgrid, 0);
+            SumEvent *pevent = window + nwindow;
+
+            istat = GetHypLoc(fp_hypo, NULL, &pevent->hypo, Arrival, &NumArrivals, 1, &pevent->locgrid, 0);
             if (istat == EOF) {
                 break;
             }
@@ -351,58 +448,59 @@ int SumLocations(int argc, char** argv) {
                         fn_hyp_in_list[nFile]);
                 break;
             }
+            HypoDesc *phypo = &pevent->hypo;
 
-            if (strcmp(Hypo.locStat, "ABORTED") == 0) {
+            if (strcmp(phypo->locStat, "ABORTED") == 0) {
                 //nll_puterr("WARNING: location ABORTED, ignoring event");
                 continue;
             } else if (
-                    locgrid.numz != 2  // 20200812 AJL - Added so that location will be accepted when depth fixed (i.e. numz = 2)
-                    && strcmp(Hypo.locStat, "REJECTED") == 0) {
+                    pevent->locgrid.numz != 2  // 20200812 AJL - Added so that location will be accepted when depth fixed (i.e. numz = 2)
+                    && strcmp(phypo->locStat, "REJECTED") == 0) {
                 //nll_puterr("WARNING: location REJECTED, ignoring event");
                 continue;
             }
             nLocAccepted++;
-            Len3Mean += Hypo.ellipsoid.len3;
-            ProbMean += Hypo.probmax;
-            RMSMean += Hypo.rms;
-            NRdgsMean += (double) Hypo.nreadings;
-            GapMean += Hypo.gap;
+            Len3Mean += phypo->ellipsoid.len3;
+            ProbMean += phypo->probmax;
+            RMSMean += phypo->rms;
+            NRdgsMean += (double) phypo->nreadings;
+            GapMean += phypo->gap;
             iReject = 0;
-            if (Hypo.ellipsoid.len3 > Len3Max) {
+            if (phypo->ellipsoid.len3 > Len3Max) {
                 //nll_puterr("WARNING: location ellipsoid Len3 is greater than Len3Max, ignoring event");
                 Len3Reject++;
                 iReject = 1;
             }
-            if (Hypo.probmax < ProbMin) {
+            if (phypo->probmax < ProbMin) {
                 //nll_puterr("WARNING: location Prob max is less than ProbMin, ignoring event");
                 ProbReject++;
                 iReject = 1;
             }
-            if (Hypo.rms > RMSMax) {
+            if (phypo->rms > RMSMax) {
                 //nll_puterr("WARNING: location RMS is Greater than RMSMax, ignoring event");
                 RMSReject++;
                 iReject = 1;
             }
-            if (Hypo.nreadings < NRdgsMin) {
+            if (phypo->nreadings < NRdgsMin) {
                 //nll_puterr("WARNING: location num readings is less than NRdgsMin, ignoring event");
                 NRdgsReject++;
                 iReject = 1;
             }
-            if (Hypo.gap > GapMax) {
+            if (phypo->gap > GapMax) {
                 //nll_puterr("WARNING: location gap is greater than GapMax, ignoring event");
                 GapReject++;
                 iReject = 1;
             }
-            if (icut == CUT_LATLON && (Hypo.dlat < latMin || Hypo.dlat > latMax || Hypo.dlong < longMin || Hypo.dlong > longMax)) {
+            if (icut == CUT_LATLON && (phypo->dlat < latMin || phypo->dlat > latMax || phypo->dlong < longMin || phypo->dlong > longMax)) {
                 CutReject++;
                 iReject = 1;
-            } else if (icut == CUT_YX && (Hypo.y < latMin || Hypo.y > latMax || Hypo.x < longMin || Hypo.x > longMax)) {
+            } else if (icut == CUT_YX && (phypo->y < latMin || phypo->y > latMax || phypo->x < longMin || phypo->x > longMax)) {
                 CutReject++;
                 iReject = 1;
-            } else if (icut == CUT_RADIUS_LATLON && (Dist2D_LocSum(Hypo.dlong, longRad, Hypo.dlat, latRad, 1) > radius)) {
+            } else if (icut == CUT_RADIUS_LATLON && (Dist2D_LocSum(phypo->dlong, longRad, phypo->dlat, latRad, 1) > radius)) {
                 CutReject++;
                 iReject = 1;
-            } else if (icut == CUT_RADIUS_YX && (Dist2D_LocSum(Hypo.x, longRad, Hypo.y, latRad, 0) > radius)) {
+            } else if (icut == CUT_RADIUS_YX && (Dist2D_LocSum(phypo->x, longRad, phypo->y, latRad, 0) > radius)) {
                 CutReject++;
                 iReject = 1;
             }
@@ -412,98 +510,51 @@ int SumLocations(int argc, char** argv) {
 
 
             PhaseFormat = FORMAT_PHASE_2; // 20110105 AJL - to allow long station names
-            WriteLocation(fp_hyp_scat_out, &Hypo, Arrival, NumArrivals, fn_hyp_scat_out, 1, 0, 0, &locgrid, 0);
-            WriteLocation(fp_hyp_sum_out, &Hypo, Arrival, NumArrivals, fn_hyp_sum_out, 0, 1, 0, &locgrid, 0); // 20181017 AJL - added
+            WriteLocation(fp_hyp_sum_out, phypo, Arrival, NumArrivals, fn_hyp_sum_out, 0, 1, 0, &pevent->locgrid, 0); // 20181017 AJL - added
 
             nLocWritten++;
 
-            if (num_decim > 0) {
-
-                /* open scatter file */
-                strcpy(fn_scatter, fn_hyp_in_list[nFile]);
-                pchr = strstr(fn_scatter, test_str);
-                if (pchr != NULL)
-                    *pchr = '\0';
-                strcat(fn_scatter, ".scat\0");
-                if ((fp_scat_in = fopen(fn_scatter, "r")) == NULL) {
-                    nll_puterr2("ERROR: opening scatter file", fn_scatter);
-                    fprintf(fp_hyp_scat_out, "SCATTER Nsamples %d\n", 0);
-                    fprintf(fp_hyp_scat_out, "END_SCATTER\n\n");
-                    continue;
-                }
-
-
-                /* read header record */
-                fseek(fp_scat_in, 0, SEEK_SET);
-                fread(&npoints, sizeof (int), 1, fp_scat_in);
-
-                fprintf(fp_hyp_scat_out, "SCATTER Nsamples %d\n", npoints / num_decim);
-
-                /* skip header record */
-                fseek(fp_scat_in, 4 * sizeof (float), SEEK_SET);
-
-                /* copy date records */
-                /*fprintf(stdout, "  Summing %d samples...\n", npoints);*/
-                for (npt = 0; npt < npoints; npt += num_decim) {
-
-                    if ((istat = fread(fdata, sizeof (float), 4, fp_scat_in)) != 4) {
-                        sprintf(MsgStr, "ERROR: freed = %d != 4!!! (%d/%d)",
-                                istat, npt, npoints);
-                        nll_puterr(MsgStr);
-                    }
-                    num_points_read++;
-                    fseek(fp_scat_in, (num_decim - 1) * 4 * sizeof (float),
-                            SEEK_CUR);
-
-                    /* clip - check that sample is within grid */
-                    /*if (fdata[0] < xmin || fdata[0] > xmax
-                            || fdata[1] < ymin || fdata[1] > ymax
-                            || fdata[2] < zmin || fdata[2] > zmax)
-                            continue;*/
-
-                    fwrite(fdata, sizeof (float), 4, fp_scat_out);
-                    num_points_written++;
-
-                    if (fdata[3] > probmax)
-                        probmax = fdata[3];
-
-                    fprintf(fp_hyp_scat_out, "%9.4lf %9.4lf %9.4lf %9.2le\n",
-                            fdata[0], fdata[1], fdata[2], fdata[3]);
-
-                    // DEBUG check of scatter data
-                    //printf("x %f  y %f  z %f  value %le\n", fdata[0], fdata[1], fdata[2], fdata[3]);
-
-                }
-
-                num_points_tot += npoints;
-
-                fprintf(fp_hyp_scat_out, "END_SCATTER\n");
-
-                fclose(fp_scat_in);
+            // keep event for writing to hypocenter/scatter file after scatter samples processed
+            if ((pevent->arrivals = malloc((NumArrivals > 0 ? NumArrivals : 1) * sizeof (ArrivalDesc))) == NULL) {
+                nll_puterr("ERROR: allocating event arrivals.");
+                return (-1);
+            }
+            memcpy(pevent->arrivals, Arrival, NumArrivals * sizeof (ArrivalDesc));
+            pevent->narrivals = NumArrivals;
+            strcpy(pevent->map_proj_str, MapProjStr[0]);
+            strcpy(pevent->fn_scatter_root, fn_hyp_in_list[nFile]);
+            pchr = strstr(pevent->fn_scatter_root, test_str);
+            if (pchr != NULL)
+                *pchr = '\0';
+            pevent->scat_status = 0;
+            pevent->samples = NULL;
+            pevent->text = NULL;
+            if (++nwindow == num_window) {
+                ProcessSumWindow(&sum_out, window, nwindow, copy_blocks);
+                nwindow = 0;
             }
-
-
-            /* write end line and blank line */
-            fprintf(fp_hyp_scat_out, "END_NLLOC\n\n");
-
-
-
         }
         fclose(fp_hypo);
 
     }
+    ProcessSumWindow(&sum_out, window, nwindow, copy_blocks);
     fprintf(OUT_LEVEL_1, "\n");
 
 
     /* write header information */
-    fseek(fp_scat_out, 0, SEEK_SET);
-    fwrite(&num_points_written, sizeof (int), 1, fp_scat_out);
-    fdata[0] = (float) probmax;
-    fwrite(fdata, sizeof (float), 1, fp_scat_out);
-
-    fclose(fp_scat_out);
+    if (fp_scat_out != NULL) {
+        fseek(fp_scat_out, 0, SEEK_SET);
+        fwrite(&sum_out.num_points_written, sizeof (int), 1, fp_scat_out);
+        fdata[0] = (float) sum_out.probmax;
+        fwrite(fdata, sizeof (float), 1, fp_scat_out);
+        fclose(fp_scat_out);
+    } else if (CloseScatterWriter(scat_writer, sum_out.probmax) < 0) {
+        nll_puterr2("ERROR: writing scatter output file", fn_scat_out);
+    }
     fclose(fp_hyp_scat_out);
     fclose(fp_hyp_sum_out);
+    free(window);
+    FreeWildCardsList(fn_hyp_in_list, numFiles);
 
     /* write message */
     fprintf(stdout,
@@ -527,14 +578,14 @@ int SumLocations(int argc, char** argv) {
     fprintf(stdout,
             "Cut Reject %d\n", CutReject);
     fprintf(stdout,
-            "%ld samples total in input scatter files.\n", num_points_tot);
+            "%ld samples total in input scatter files.\n", sum_out.num_points_tot);
     fprintf(stdout,
-            "%ld decimated samples read.\n", num_points_read);
+            "%ld decimated samples read.\n", sum_out.num_points_read);
     fprintf(stdout, "%ld samples written to binary sumfile <%s>\n",
-            num_points_written, fn_scat_out);
+            sum_out.num_points_written, fn_scat_out);
     fprintf(stdout,
             "%ld samples and %d locations written to ascii sumfile <%s>\n",
-            num_points_written, nLocWritten, fn_hyp_scat_out);
+            sum_out.num_points_written, nLocWritten, fn_hyp_scat_out);
 
 
     return (0);
@@ -543,3 +594,172 @@ int SumLocations(int argc, char** argv) {
 
 
 
+/** function to read, decimate and format as text the scatter samples of an event
+ *
+ *  20261018 AJL - added, may be called in parallel for different events, no output or messages
+ */
+
+void ReadEventScatter(SumEvent *pevent, int num_decim, int copy_blocks) {
+
+    ScatterReader *scat_reader;
+    float *fblock, *fdata;
+    int nsamples_block, nblock;
+
+    pevent->nsamples = 0;
+    pevent->npoints = pevent->npoints_read = 0;
+    pevent->probmax = -VERY_LARGE_FLOAT;
+    pevent->text_len = pevent->text_size = 0;
+    memset(&pevent->blocks, 0, sizeof (ScatterBlockList));
+    // samples of raw scatter input re-encoded with default quantum for event geometry
+    pevent->quantum = strstr(pevent->map_proj_str, "GLOBAL") != NULL ? SCATZ_QUANTUM_DEG : SCATZ_QUANTUM_KM;
+
+    if ((scat_reader = OpenEventScatterReader(pevent->fn_scatter_root, pevent->fn_scatter)) == NULL) {
+        pevent->scat_status = -1;
+        return;
+    }
+    pevent->compressed = scat_reader->compressed;
+    pevent->npoints = scat_reader->nsamples;
+
+    int nsamples_max = (pevent->npoints + num_decim - 1) / num_decim;
+    fblock = malloc(4 * SCAT_BLOCK_NSAMPLES * sizeof (float));
+    // decimated samples kept for writing, except if compressed blocks are copied
+    if (!(copy_blocks && pevent->compressed))
+        pevent->samples = malloc(((size_t) nsamples_max + 1) * 4 * sizeof (float));
+    pevent->text_size = ((size_t) nsamples_max + 1) * 48;
+    pevent->text = malloc(pevent->text_size);
+    if (fblock == NULL || pevent->text == NULL || (pevent->samples == NULL && !(copy_blocks && pevent->compressed))) {
+        free(fblock);
+        CloseScatterReader(scat_reader);
+        pevent->scat_status = -3;
+        return;
+    }
+
+    /* copy date records, every num_decim'th sample */
+    while ((nsamples_block = ReadScatterBlock(scat_reader, fblock)) > 0) {
+        if (pevent->compressed) {
+            // keep quantum of input, keep encoded block if blocks are copied, so file is read only once
+            if (pevent->npoints_read == 0)
+                pevent->quantum = scat_reader->block_quantum;
+            if (copy_blocks && SaveScatterBlock(&pevent->blocks, scat_reader) < 0) {
+                pevent->scat_status = -3;
+                break;
+            }
+        }
+        for (nblock = (num_decim - pevent->npoints_read % num_decim) % num_decim; nblock < nsamples_block; nblock += num_decim) {
+            fdata = fblock + 4 * nblock;
+            if (pevent->samples != NULL)
+                memcpy(pevent->samples + 4 * pevent->nsamples, fdata, 4 * sizeof (float));
+            pevent->nsamples++;
+            if (fdata[3] > pevent->probmax)
+                pevent->probmax = fdata[3];
+            if (pevent->text_size - pevent->text_len < 256) {
+                char *text = realloc(pevent->text, 2 * pevent->text_size);
+                if (text == NULL) {
+                    pevent->scat_status = -3;
+                    break;
+                }
+                pevent->text = text;
+                pevent->text_size *= 2;
+            }
+            pevent->text_len += snprintf(pevent->text + pevent->text_len, pevent->text_size - pevent->text_len,
+                    "%9.4lf %9.4lf %9.4lf %9.2le\n", fdata[0], fdata[1], fdata[2], fdata[3]);
+        }
+        pevent->npoints_read += nsamples_block;
+        if (pevent->scat_status < 0)
+            break;
+    }
+    if (nsamples_block < 0)
+        pevent->scat_status = -2;
+
+    free(fblock);
+    CloseScatterReader(scat_reader);
+
+}
+
+/** function to write accepted event and its scatter samples to output files
+ *
+ *  20261018 AJL - added
+ */
+
+void WriteSumEvent(SumOutput *pout, SumEvent *pevent, int copy_blocks) {
+
+    PhaseFormat = FORMAT_PHASE_2; // 20110105 AJL - to allow long station names
+    strcpy(MapProjStr[0], pevent->map_proj_str);
+    WriteLocation(pout->fp_hyp_scat_out, &pevent->hypo, pevent->arrivals, pevent->narrivals, pout->fn_hyp_scat_out, 1, 0, 0, &pevent->locgrid, 0);
+    free(pevent->arrivals);
+    pevent->arrivals = NULL;
+
+    if (pout->num_decim > 0) {
+
+        if (pevent->scat_status == -1) {
+            nll_puterr2("ERROR: opening scatter file", pevent->fn_scatter);
+            fprintf(pout->fp_hyp_scat_out, "SCATTER Nsamples %d\n", 0);
+            fprintf(pout->fp_hyp_scat_out, "END_SCATTER\n\n");
+            return;
+        }
+        if (pevent->scat_status == -3)
+            nll_puterr2("ERROR: allocating memory for scatter samples, file", pevent->fn_scatter);
+
+        fprintf(pout->fp_hyp_scat_out, "SCATTER Nsamples %d\n", pevent->npoints / pout->num_decim);
+        fwrite(pevent->text, 1, pevent->text_len, pout->fp_hyp_scat_out);
+
+        if (pevent->scat_status == -2) {
+            sprintf(MsgStr, "ERROR: reading scatter file: %s (%d/%d)", pevent->fn_scatter, pevent->npoints_read, pevent->npoints);
+            nll_puterr(MsgStr);
+        }
+
+        if (pout->fp_scat_out != NULL) {
+            fwrite(pevent->samples, 4 * sizeof (float), pevent->nsamples, pout->fp_scat_out);
+        } else if (copy_blocks && pevent->compressed) {
+            // compressed blocks kept when read are copied without decoding and re-encoding
+            if (CopyScatterBlocks(pout->scat_writer, &pevent->blocks) < 0)
+                nll_puterr2("ERROR: writing scatter output file", pout->fn_scat_out);
+        } else {
+            // samples that are re-encoded are quantized relative to event hypocenter
+            if (SetScatterWriterRef(pout->scat_writer, pevent->hypo.x, pevent->hypo.y, pevent->hypo.z, pevent->quantum) < 0
+                    || WriteScatterSamples(pout->scat_writer, pevent->samples, pevent->nsamples) < 0)
+                nll_puterr2("ERROR: writing scatter output file", pout->fn_scat_out);
+        }
+
+        pout->num_points_read += pevent->nsamples;
+        pout->num_points_written += pevent->nsamples;
+        if (pevent->probmax > pout->probmax)
+            pout->probmax = pevent->probmax;
+        pout->num_points_tot += pevent->npoints;
+
+        fprintf(pout->fp_hyp_scat_out, "END_SCATTER\n");
+
+        free(pevent->samples);
+        pevent->samples = NULL;
+        FreeScatterBlockList(&pevent->blocks);
+        free(pevent->text);
+        pevent->text = NULL;
+    }
+
+
+    /* write end line and blank line */
+    fprintf(pout->fp_hyp_scat_out, "END_NLLOC\n\n");
+
+}
+
+/** function to process scatter samples of a window of accepted events in parallel, then write events in order
+ *
+ *  20261018 AJL - added
+ */
+
+void ProcessSumWindow(SumOutput *pout, SumEvent *window, int nwindow, int copy_blocks) {
+
+    int n;
+
+    if (pout->num_decim > 0) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (n = 0; n < nwindow; n++)
+            ReadEventScatter(window + n, pout->num_decim, copy_blocks);
+    }
+
+    for (n = 0; n < nwindow; n++)
+        WriteSumEvent(pout, window + n, copy_blocks);
+
+}
@@ -35,6 +35,7 @@ e-mail: anthony@alomax.net  web: http://www.alomax.net
 
         ver 01    27JUL2004  AJL  Original version
         ver 01    15MAY2014  AJL  Added L1 norm
+        ver 01    18OCT2026  AJL  Clusters of linked hypocenters located independently, in parallel
 
 
 .........1.........2.........3.........4.........5.........6.........7.........8
@@ -114,6 +115,41 @@ DiffHypoDataDesc DiffHypoData[MAX_NUM_DIFF_HYPOCENTERS];
 
 #endif
 
+#define HUGE_MISFIT 1.0e30
+#define SMALLEST_LIKELIHOOD 1.0e-300
+
+// 20261018 AJL - added: cluster of hypocenters connected by differential time links
+
+typedef struct {
+    int num_hypos;
+    int *hypo_index; // indices of hypocenters in DiffHypocenters, in index order
+    int num_arrivals;
+    int *arrival_index; // indices of differential time arrivals linking hypocenters of cluster, in index order
+} DiffLocCluster;
+
+// 20261018 AJL - added: cache of travel times from each hypocenter to the station-phases of its differential time links
+//    a station-phase is identified by the arrival holding the time grid (the companion arrival, if any)
+//    each hypocenter has two banks of travel times: for the current hypocenter location (used by linked hypocenters)
+//    and for the test location of the hypocenter; a bank is valid for one location, slot values are valid if the
+//    slot stamp equals the bank stamp.  Banks of a hypocenter are used only by the thread locating its cluster.
+
+typedef struct {
+    Vect3D pos[2]; // hypocenter location of travel times in each bank
+    long stamp[2]; // stamp of each bank, 0 = bank not valid
+    long stamp_count;
+    int ibank_current; // bank for current hypocenter location, other bank is for test locations
+} DiffTravelTimeCacheHypo;
+
+typedef struct {
+    int num_slots; // number of hypocenter station-phase slots
+    int *arrival_slot; // slot of hypocenter 1 and hypocenter 2 of each arrival, -1 if not cached
+    double *travel_time; // travel time of each slot in each bank
+    long *slot_stamp; // stamp of each slot in each bank
+    DiffTravelTimeCacheHypo *hypo;
+} DiffTravelTimeCache;
+
+DiffTravelTimeCache DiffTTCache;
+
 /*------------------------------------------------------------*/
 /* function declarations  */
 int ReadNLDiffLoc_Input(FILE* fp_input);
@@ -121,30 +157,40 @@ int GetNLDiffLoc_HypFile(char* line1);
 int GetNLDiffLoc_SearchType(char* line1);
 int GetHypocenters(char* fn_hypos, char* ftype_hypos, HypoDesc* Hypos, int max_num_hypos);
 int AssignEventIndexes(int num_hypos, HypoDesc* hypos, int num_arrivals, ArrivalDesc *arrival, double *, int *pnumberP, int *pnumberS, int *pnumberOther);
+int FindDiffClusters(int num_hypos, HypoDesc* hypos, int num_arrivals, ArrivalDesc *arrival, DiffLocCluster** pclusters);
+void FreeDiffClusters(DiffLocCluster* clusters, int num_clusters);
+int InitDiffTravelTimeCache(int num_hypos, int num_arrivals, ArrivalDesc *arrival);
+void FreeDiffTravelTimeCache(void);
+int hasCascadingGrids(int num_arrivals, ArrivalDesc *arrival);
 int LocateDiff(char* fn_obs, char* fn_path_output, int numArrivalsReject);
-int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
+int isFixedDiffHypocenter(int nHypo);
+double DiffLocInitHypocenter(int nHypo, int num_arr_loc, ArrivalDesc *arrival, int *arrival_index,
+        GaussLocParams* gauss_par, int iGridType);
+int DiffLocMetropolis(DiffLocCluster* pcluster, int num_arr_total, int num_arr_loc,
         ArrivalDesc *arrival,
         GridDesc* ptgrid, GaussLocParams* gauss_par,
-        WalkParams* pMetrop, float* fdata);
+        WalkParams* pMetrop, RandStream* pstream, float* fdata, long int iFdataOffset);
+int DiffLocSaveClusterScatter(DiffLocCluster* pcluster, float* fdata, long int iFdataOffset);
+int DiffLocSaveScatterHeader(HypoDesc* phypo);
 int clip(double *px, double *py, double *pz,
         double xmin, double xmax, double ymin, double ymax, double zmin, double zmax);
 int DiffLocGetNextMetropolisSample(WalkParams* pMetrop, double dx, double xmin, double xmax,
         double ymin, double ymax, double zmin, double zmax,
-        double* pxval, double* pyval, double* pzval, double* ptval);
+        double* pxval, double* pyval, double* pzval, double* ptval, RandStream* pstream);
 double DiffLocCalcSolutionQuality(
         Vect3D hypo_test, double dtime,
         int nHypo, int num_hypos, HypoDesc* hypos,
-        int num_arrivals, ArrivalDesc* arrival,
+        int num_arrivals, ArrivalDesc* arrival, int *arrival_index,
         GaussLocParams* gauss_par, int itype, double temperature, double* pmisfit, double* potime, int* pnReject, int);
 double DiffLocCalcSolutionQuality_LN_NORM(double norm,
         Vect3D hypo_test, double dtime,
         int nHypo, int num_hypos, HypoDesc* hypos,
-        int num_arrivals, ArrivalDesc* arrival,
+        int num_arrivals, ArrivalDesc* arrival, int *arrival_index,
         GaussLocParams* gauss_par, int itype, double temperature, double* pmisfit, double* potime, int* pnReject, int);
-double getTravelTimeDiff(ArrivalDesc* arrival, int narr, Vect3D hypo1, Vect3D hypo2);
+double getTravelTimeDiff(ArrivalDesc* arrival, int narr, Vect3D hypo1, Vect3D hypo2, int nHypoTest);
 int DiffLocSaveBestLocation(int num_arr_total, int num_arr_loc, ArrivalDesc *arrival,
         GridDesc* ptgrid, GaussLocParams* gauss_par, int nHypo, int iGridType);
-int DiffLocMetropolisTest(double value_last, double value_new, double exp_last, double exp_new, int reverse_comparison);
+int DiffLocMetropolisTest(double value_last, double value_new, double exp_last, double exp_new, int reverse_comparison, RandStream* pstream);
 int SaveDiffTimeLinks(int num_hypos, HypoDesc* hypos, int num_arrivals, ArrivalDesc* arrival, FILE * fp_out);
 int SaveHypoDDRes(int num_hypos, HypoDesc* hypos, int num_arrivals, ArrivalDesc* arrival, FILE* fp_out);
 
@@ -253,6 +299,7 @@ int main(int argc, char *argv[]) {
     NumLocExclude = NumLocInclude = 0;
     NumTimeDelays = 0;
     NumPhaseID = 0;
+    ClearPhaseIDCache(); // 20261019 AJL - added
     DistStaGridMax = 0.0;
     MinNumArrLoc = 0;
     MinNumSArrLoc = 0;
@@ -293,6 +340,11 @@ int main(int argc, char *argv[]) {
         nll_puterr("FATAL ERROR: reading control file.");
         exit(EXIT_ERROR_FILEIO);
     }
+    // 20261018 AJL - reciprocity centroid grids not supported in NLDiffLoc
+    if (NumRecipCentroids > 0) {
+        nll_putmsg(1, "WARNING: reciprocity (LOCRECIP) not supported by NLDiffLoc, ignoring.");
+        NumRecipCentroids = 0;
+    }
     rewind(fp_control);
     /* read NLDiffLoc control statements from control file */
     if ((istat = ReadNLDiffLoc_Input(fp_control)) < 0) {
@@ -396,6 +448,7 @@ int main(int argc, char *argv[]) {
             continue;
         } else {
             NumFilesOpen++;
+            setvbuf(fp_obs, NULL, _IOFBF, OBS_FILE_BUFFER_SIZE); // 20261018 AJL - added
         }
 
         /* extract info from filename */
@@ -611,8 +664,13 @@ int main(int argc, char *argv[]) {
             NumFilesOpen, NumGridBufFilesOpen, NumGridHdrFilesOpen, NumAllocations, Num3DGridReadToMemory, GridMemListSize, GridMemListTotalNumElementsAdded);
     nll_putmsg(1, MsgStr);
 
+    // 20261018 AJL - added: travel times from hypocenters to station-phases are cached during location
+    InitDiffTravelTimeCache(NumHypocenters, NumArrivalsLocation, Arrival);
+
     //ngrid = 0;
-    if ((NumLocationsCompleted = LocateDiff(fn_loc_obs[nObsFile], fn_path_output, numArrivalsReject)) < 0) {
+    NumLocationsCompleted = LocateDiff(fn_loc_obs[nObsFile], fn_path_output, numArrivalsReject);
+    FreeDiffTravelTimeCache();
+    if (NumLocationsCompleted < 0) {
         if (istat == GRID_NOT_INSIDE)
             //break;
             goto cleanup;
@@ -1027,15 +1085,17 @@ int LocateDiff(char* fn_obs, char* fn_path_output, int numArrivalsReject) {
     int istat, n;
     int nLocationsCompleted;
 
-    FILE *fpio;
     char fname[2*FILENAME_MAX];
     char fn_root_out[FILENAME_MAX];
-    int nSamplesTotal = -1;
-    float *fdata, ftemp;
-    long int iFdataOffset, iSizeOfFdata;
+    int nSamplesTotal = 0;
+    long int iFdataOffset;
 
     HypoDesc *phypo;
 
+    DiffLocCluster *clusters = NULL;
+    int numClusters, nCluster, maxClusterSize, iParallel;
+    int istat_clusters = 0;
+
 
 
 
@@ -1047,14 +1107,8 @@ int LocateDiff(char* fn_obs, char* fn_path_output, int numArrivalsReject) {
     if (message_flag >= 3)
         display_grid_param(LocGrid);
 
-    /* allocate scatter array for saved samples */
+    /* size of scatter array for saved samples for each hypocenter */
     iFdataOffset = (1 + MetUse / MetSkip) * 4;
-    iSizeOfFdata = NumHypocenters * iFdataOffset * sizeof (float);
-    if ((fdata = (float *) malloc(iSizeOfFdata)) == NULL) {
-        nll_puterr("ERROR: allocating scatter sample array.");
-        return (EXIT_ERROR_LOCATE);
-    }
-    NumAllocations++;
 
 
     /* open summary output file for initial hypocenters */
@@ -1076,7 +1130,7 @@ int LocateDiff(char* fn_obs, char* fn_path_output, int numArrivalsReject) {
         /* set time (differential time from otime */
         phypo->time = 0.0L;
         phypo->nSamples = 0;
-        phypo->ipos = n * iFdataOffset;
+        phypo->ipos = 0;
         phypo->nScatterSaved = 0;
         /* set output name */
         sprintf(fn_root_out, "%s.%4.4d%2.2d%2.2d.%2.2d%2.2d%2.2d",
@@ -1143,15 +1197,93 @@ int LocateDiff(char* fn_obs, char* fn_path_output, int numArrivalsReject) {
             }
      */
 
+    /* find clusters of hypocenters connected by differential times, clusters are located independently */
+
+    if ((numClusters = FindDiffClusters(NumHypocenters, DiffHypocenters, NumArrivalsLocation, Arrival, &clusters)) < 0) {
+        nll_puterr("ERROR: finding clusters of hypocenters.");
+        return (EXIT_ERROR_LOCATE);
+    }
+    maxClusterSize = 0;
+    for (nCluster = 0; nCluster < numClusters; nCluster++)
+        if (clusters[nCluster].num_hypos > maxClusterSize)
+            maxClusterSize = clusters[nCluster].num_hypos;
+    // cascading grids read from memory use shared work arrays, locate clusters serially
+    iParallel = numClusters > 1 && !hasCascadingGrids(NumArrivalsLocation, Arrival);
+    sprintf(MsgStr, "DiffLoc: %d hypocenter clusters, largest cluster %d hypocenters, located %s.",
+            numClusters, maxClusterSize, iParallel ? "in parallel" : "serially");
+    nll_putmsg(1, MsgStr);
+
+    /* calculate initial location quality */
+
+    nll_putmsg(3, "");
+    nll_putmsg(3, "Calculating solution along Metropolis walk...");
+
+    for (n = 0; n < NumHypocenters; n++) {
+        phypo = DiffHypocenters + n;
+        if (phypo->flag_ignore)
+            continue;
+        DiffLocInitHypocenter(n, NumArrivalsLocation, Arrival, NULL, &Gauss, LocGrid[0].type);
+        printf("< nHypo %d (%4.4d%2.2d%2.2d %2.2d%2.2d%2.2d x%f y%f z%f)  mf_init %f like_init %e step %g",
+                n, phypo->year, phypo->month, phypo->day,
+                phypo->hour, phypo->min, (int) phypo->sec,
+                phypo->x, phypo->y, phypo->z,
+                phypo->misfit, (double) phypo->probmax, 2.0 * Metrop.dx);
+        if (isFixedDiffHypocenter(n))
+            printf("  FIXED\n");
+        else
+            printf("\n");
+        // check for best
+        if (phypo->probmax > hypo_likelyhood_best) {
+            hypo_likelyhood_best = phypo->probmax;
+            hypo_misfit_best = phypo->misfit;
+            iHypo_hypo_likelyhood_best = n;
+        }
+    }
+    printf("<<  like_init_best %e  nHypo %d\n", hypo_likelyhood_best, iHypo_hypo_likelyhood_best);
+
     /* do search */
 
-    /* Metropolis location (random walk) */
-    if ((nSamplesTotal =
-            DiffLocMetropolis(NumArrivals, NumArrivalsLocation,
-            Arrival, LocGrid,
-            &Gauss, &Metrop, fdata)) < 0) {
+    /* Metropolis location (random walk) of each cluster, scatter samples are saved to disk and released after each cluster
+     * a single cluster uses the global random number generator, otherwise each cluster uses its own random number stream
+     *  so that locations do not depend on the number of threads */
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+:nSamplesTotal) reduction(min:istat_clusters) if(iParallel)
+#endif
+    for (nCluster = 0; nCluster < numClusters; nCluster++) {
+        DiffLocCluster *pcluster = clusters + nCluster;
+        WalkParams metrop = Metrop;
+        RandStream stream;
+        float *fdata;
+        int nSamples;
+        if ((fdata = (float *) malloc(pcluster->num_hypos * iFdataOffset * sizeof (float))) == NULL) {
+            istat_clusters = EXIT_ERROR_MEMORY;
+            continue;
+        }
+        rand_stream_init(&stream, RandomNumSeed, nCluster);
+        if ((nSamples = DiffLocMetropolis(pcluster, NumArrivals, NumArrivalsLocation,
+                Arrival, LocGrid,
+                &Gauss, &metrop, numClusters > 1 ? &stream : NULL, fdata, iFdataOffset)) < 0) {
+            istat_clusters = EXIT_ERROR_LOCATE;
+        } else {
+            nSamplesTotal += nSamples;
+            int istat_save = DiffLocSaveClusterScatter(pcluster, fdata, iFdataOffset);
+            if (istat_save < 0)
+                istat_clusters = istat_save;
+        }
+        free(fdata);
+    }
+
+    FreeDiffClusters(clusters, numClusters);
+
+    if (istat_clusters == EXIT_ERROR_MEMORY) {
+        nll_puterr("ERROR: allocating scatter sample array.");
+        return (EXIT_ERROR_LOCATE);
+    } else if (istat_clusters == EXIT_ERROR_LOCATE) {
         nll_puterr("ERROR: in Metropolis location.");
         return (EXIT_ERROR_LOCATE);
+    } else if (istat_clusters < 0) {
+        return (istat_clusters);
     }
 
 
@@ -1196,9 +1328,14 @@ int LocateDiff(char* fn_obs, char* fn_path_output, int numArrivalsReject) {
         nLocationsCompleted++;
 
         /* re-calculate solution and arrival statistics for best location */
+        // 20261019 AJL - arrival statistics are shared by linked hypocenters, must be set just before saving location
 
         DiffLocSaveBestLocation(NumArrivals, NumArrivalsLocation, Arrival, LocGrid, NULL, n, LocGrid[0].type);
 
+        // scatter samples and "traditional" statistics set in DiffLocSaveClusterScatter()
+        if ((istat = DiffLocSaveScatterHeader(phypo)) < 0)
+            return (istat);
+
         if (!phypo->flag_ignore) {
             printf("> nHypo %d (%4.4d%2.2d%2.2d %2.2d%2.2d%2.2d x%f y%f z%f)  mf_min %f like_max %e  %s",
                     n, phypo->year, phypo->month, phypo->day,
@@ -1213,35 +1350,6 @@ int LocateDiff(char* fn_obs, char* fn_path_output, int numArrivalsReject) {
                 printf("\n");
             }
         }
-        // write scatter file
-        sprintf(fname, "%s.loc.scat", phypo->fileroot);
-        if ((fpio = fopen(fname, "w")) != NULL) {
-            // write scatter file header informaion
-            fseek(fpio, 0, SEEK_SET);
-            fwrite(&(phypo->nScatterSaved), sizeof (int), 1, fpio);
-            ftemp = (float) phypo->probmax;
-            fwrite(&ftemp, sizeof (float), 1, fpio);
-            // skip header record
-            fseek(fpio, 4 * sizeof (float), SEEK_SET);
-            // write scatter samples
-            fwrite(fdata + n * iFdataOffset, 4 * sizeof (float), phypo->nScatterSaved, fpio);
-            fclose(fpio);
-        } else {
-            nll_puterr("ERROR: opening scatter output file.");
-            return (EXIT_ERROR_IO);
-        }
-
-        // calculate "traditional" statistics
-        phypo->expect =
-                CalcExpectationSamples(fdata + n * iFdataOffset, phypo->nScatterSaved);
-        istat = rect2latlon(0, phypo->expect.x, phypo->expect.y,
-                &(phypo->expect_dlat), &(phypo->expect_dlong));
-        phypo->cov = CalcCovarianceSamples(fdata + n * iFdataOffset, phypo->nScatterSaved,
-                &phypo->expect);
-        if (phypo->nScatterSaved) {
-            phypo->ellipsoid = CalcErrorEllipsoid(&phypo->cov, DELTA_CHI_SQR_68_3);
-            phypo->ellipse = CalcHorizontalErrorEllipse(&Hypocenter.cov, DELTA_CHI_SQR_68_2); // 20190101 AJL - added
-        }
 
 
         // search type dependent results saving
@@ -1324,13 +1432,6 @@ int LocateDiff(char* fn_obs, char* fn_path_output, int numArrivalsReject) {
     // search type dependent cleanup
 
 
-    // free saved samples memory
-    free(fdata);
-    fdata = NULL;
-    NumAllocations--;
-
-
-
     /* re-sort to get location arrivals in time order */
     /*DD
             if ((istat =
@@ -1360,14 +1461,74 @@ int LocateDiff(char* fn_obs, char* fn_path_output, int numArrivalsReject) {
 
 
 
+}
+
+/*** function to get random double from random number stream, or from global generator if stream is NULL */
+
+static double rand_double(RandStream* pstream, double xmin, double xmax) {
+
+    if (pstream != NULL)
+        return (rand_stream_double(pstream, xmin, xmax));
+
+    return (get_rand_double(xmin, xmax));
+
+}
+
+/*** function to check if hypocenter is fixed (DLOC_HYPFILE) */
+
+int isFixedDiffHypocenter(int nHypo) {
+
+    if (NumHypocenterFix >= 0 && nHypo == NumHypocenterFix)
+        return (1);
+    if (NumHypocenterFree >= 0 && nHypo != NumHypocenterFree)
+        return (1);
+
+    return (0);
+
+}
+
+/*** function to calculate solution quality at current hypocenter location and initialize misfit and likelihood
+ *
+ *  returns ln(prob density) or misfit
+ */
+
+double DiffLocInitHypocenter(int nHypo, int num_arr_loc, ArrivalDesc *arrival, int *arrival_index,
+        GaussLocParams* gauss_par, int iGridType) {
+
+    int nReject;
+    double value, misfit;
+    Vect3D hyp_xyz;
+    HypoDesc *phypo;
+
+    phypo = DiffHypocenters + nHypo;
+    hyp_xyz.x = phypo->x;
+    hyp_xyz.y = phypo->y;
+    hyp_xyz.z = phypo->z;
+    value = DiffLocCalcSolutionQuality(hyp_xyz, phypo->dotime,
+            nHypo, NumHypocenters, DiffHypocenters,
+            num_arr_loc, arrival, arrival_index, gauss_par,
+            iGridType, 1.0, &misfit, NULL, &nReject, 0);
+    if (nReject) {
+        phypo->misfit = HUGE_MISFIT;
+        phypo->probmax = 0.0;
+    } else {
+        phypo->misfit = misfit;
+        phypo->probmax = exp(value);
+    }
+    phypo->grid_misfit_max = phypo->misfit;
+
+    return (value);
+
 }
 
 /*** function to update solution for single hypocenter
+ *
+ *  iHypo is index of hypocenter in cluster working arrays
  */
 
 void DiffLocUpdateAfterAccept(double misfit, double value, double dlike, int reverse_comparison, double xval, double yval, double zval, double tval,
         HypoDesc* phypo, Vect3D *hyp_xyz, double *hyp_dt,
-        int nHypo,
+        int iHypo,
         double *hyp_value, double *hyp_dlike, double *hyp_dlike_sum, int *hyp_dlike_num_mean,
         int *pnSamplesTotal, float* fdata) {
 
@@ -1386,10 +1547,13 @@ void DiffLocUpdateAfterAccept(double misfit, double value, double dlike, int rev
         phypo->probmax = dlike;
         phypo->misfit = misfit;
         // check for best
+#ifdef _OPENMP
+#pragma omp critical(nll_diffloc_best)
+#endif
         if (phypo->probmax > hypo_likelyhood_best) {
             hypo_likelyhood_best = phypo->probmax;
             hypo_misfit_best = phypo->misfit;
-            iHypo_hypo_likelyhood_best = nHypo;
+            iHypo_hypo_likelyhood_best = phypo - DiffHypocenters;
         }
         if (!reverse_comparison) {
             phypo->x = xval;
@@ -1408,28 +1572,28 @@ void DiffLocUpdateAfterAccept(double misfit, double value, double dlike, int rev
 
     // update sample location
     if (!reverse_comparison) {
-        hyp_xyz[nHypo].x = xval;
-        hyp_xyz[nHypo].y = yval;
-        hyp_xyz[nHypo].z = zval;
-        hyp_dt[nHypo] = tval;
+        hyp_xyz[iHypo].x = xval;
+        hyp_xyz[iHypo].y = yval;
+        hyp_xyz[iHypo].z = zval;
+        hyp_dt[iHypo] = tval;
     } else {
-        hyp_xyz[nHypo].x = phypo->x;
-        hyp_xyz[nHypo].y = phypo->y;
-        hyp_xyz[nHypo].z = phypo->z;
-        hyp_dt[nHypo] = phypo->dotime;
+        hyp_xyz[iHypo].x = phypo->x;
+        hyp_xyz[iHypo].y = phypo->y;
+        hyp_xyz[iHypo].z = phypo->z;
+        hyp_dt[iHypo] = phypo->dotime;
     }
-    hyp_value[nHypo] = value;
-    hyp_dlike[nHypo] = dlike;
-    hyp_dlike_sum[nHypo] += dlike;
-    hyp_dlike_num_mean[nHypo]++;
+    hyp_value[iHypo] = value;
+    hyp_dlike[iHypo] = dlike;
+    hyp_dlike_sum[iHypo] += dlike;
+    hyp_dlike_num_mean[iHypo]++;
 
     /* if saving samples */
     if (phypo->nSamples > MetStartSave && phypo->nSamples % MetSkip == 0) {
         // save sample to scatter file
 
-        fdata[(phypo->ipos)] = hyp_xyz[nHypo].x;
-        fdata[++(phypo->ipos)] = hyp_xyz[nHypo].y;
-        fdata[++(phypo->ipos)] = hyp_xyz[nHypo].z;
+        fdata[(phypo->ipos)] = hyp_xyz[iHypo].x;
+        fdata[++(phypo->ipos)] = hyp_xyz[iHypo].y;
+        fdata[++(phypo->ipos)] = hyp_xyz[iHypo].z;
         fdata[++(phypo->ipos)] = dlike;
         ++(phypo->ipos);
         ++(phypo->nScatterSaved);
@@ -1444,13 +1608,14 @@ void DiffLocUpdateAfterAccept(double misfit, double value, double dlike, int rev
 
 int DiffLocTestHypo(int reverse_comparison, double xval, double yval, double zval, double tval,
         HypoDesc* phypo, Vect3D *hyp_xyz, double *hyp_dt,
-        int nHypo, int ntry, int maxNumTries, int nAcceptMax, int num_hypos, HypoDesc* hypos, int num_arrivals, ArrivalDesc* arrival,
+        int nHypo, int iHypo, int ntry, int maxNumTries, int nAcceptMax, int num_hypos, HypoDesc* hypos,
+        int num_arrivals, ArrivalDesc* arrival, int *arrival_index,
         double *hyp_value, double *hyp_dlike, double *hyp_dlike_sum, int *hyp_dlike_num_mean,
         GaussLocParams* gauss_par, int itype, double temperature, double* potime, int isave,
-        int *pnSamplesTotal, float* fdata) {
+        RandStream* pstream, int *pnSamplesTotal, float* fdata) {
 
     double misfit;
-    static Vect3D hypo_test;
+    Vect3D hypo_test;
 
     // calc new misfit or prob density
     hypo_test.x = xval;
@@ -1459,7 +1624,7 @@ int DiffLocTestHypo(int reverse_comparison, double xval, double yval, double zva
     int nReject;
     double value = DiffLocCalcSolutionQuality(hypo_test, tval,
             nHypo, num_hypos, hypos,
-            num_arrivals, arrival, gauss_par,
+            num_arrivals, arrival, arrival_index, gauss_par,
             itype, temperature, &misfit, potime, &nReject, isave);
     //if (fabs(value) > 1.0)
     //printf("TP 3 - nHypo  %d value %lf\n", nHypo, value);
@@ -1471,8 +1636,8 @@ int DiffLocTestHypo(int reverse_comparison, double xval, double yval, double zva
     double dlike = exp(value);
 
     // apply Metropolis test
-    //iAccept = MetropolisTest(hyp_dlike[nHypo], dlike);
-    int iAccept = DiffLocMetropolisTest(hyp_value[nHypo], value, hyp_dlike[nHypo], dlike, reverse_comparison);
+    //iAccept = MetropolisTest(hyp_dlike[iHypo], dlike);
+    int iAccept = DiffLocMetropolisTest(hyp_value[iHypo], value, hyp_dlike[iHypo], dlike, reverse_comparison, pstream);
 
 #ifdef TEST_WIEGHT_LIKE_BY_MISFIT
     if (!iAccept && ntry == maxNumTries && phypo->nSamples < nAcceptMax / 10) {
@@ -1498,7 +1663,7 @@ int DiffLocTestHypo(int reverse_comparison, double xval, double yval, double zva
     if (iAccept) {
         DiffLocUpdateAfterAccept(misfit, value, dlike, reverse_comparison, xval, yval, zval, tval,
                 phypo, hyp_xyz, hyp_dt,
-                nHypo,
+                iHypo,
                 hyp_value, hyp_dlike, hyp_dlike_sum, hyp_dlike_num_mean,
                 pnSamplesTotal, fdata);
 
@@ -1521,17 +1686,20 @@ int DiffLocTestHypo(int reverse_comparison, double xval, double yval, double zva
 }
 
 
-/*** function to perform Metropolis location */
+/*** function to perform Metropolis location of a cluster of hypocenters
+ *
+ *  hypocenters in cluster are linked only to other hypocenters in cluster, scatter samples are saved in fdata,
+ *  iFdataOffset floats for each hypocenter of cluster
+ *  uses random number stream pstream, or global generator if pstream is NULL
+ */
 
-#define HUGE_MISFIT 1.0e30
-#define SMALLEST_LIKELIHOOD 1.0e-300
 #define TARGET_NUM_MET_TRIES 4
 #define MAX_NUM_MET_TRIES (2*TARGET_NUM_MET_TRIES-1);
 
-int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
+int DiffLocMetropolis(DiffLocCluster* pcluster, int num_arr_total, int num_arr_loc,
         ArrivalDesc *arrival,
         GridDesc* ptgrid, GaussLocParams* gauss_par,
-        WalkParams* pMetrop, float* fdata) {
+        WalkParams* pMetrop, RandStream* pstream, float* fdata, long int iFdataOffset) {
 
     int itest;
     int ntryTotal, nSamplesTotal, nAcceptMax, nAcceptMin;
@@ -1556,30 +1724,32 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
 
     // DD
     HypoDesc * phypo;
-    int nHypo;
+    int nHypo, iHypo;
     //	char locStatComm[2 * MAXLINE];
     int imessage_modulo;
-    // working arrays
-    double hyp_value[NumHypocenters];
-    double hyp_dlike[NumHypocenters];
-    double hyp_dlike_sum[NumHypocenters];
-    int hyp_dlike_num_mean[NumHypocenters];
-    Vect3D hyp_test_xyz[NumHypocenters];
-    double hyp_test_dt[NumHypocenters];
-    int hyp_fixed[NumHypocenters];
-    int hyp_abort[NumHypocenters];
-    int ntry[NumHypocenters];
-    double metrop_dx[NumHypocenters];
+    // cluster
+    int num_hypos = pcluster->num_hypos;
+    int *hypo_index = pcluster->hypo_index;
+    int num_arr_cluster = pcluster->num_arrivals;
+    int *arrival_index = pcluster->arrival_index;
+    // working arrays, indexed by hypocenter index in cluster
+    double hyp_value[num_hypos];
+    double hyp_dlike[num_hypos];
+    double hyp_dlike_sum[num_hypos];
+    int hyp_dlike_num_mean[num_hypos];
+    Vect3D hyp_test_xyz[num_hypos];
+    double hyp_test_dt[num_hypos];
+    int hyp_fixed[num_hypos];
+    int hyp_abort[num_hypos];
+    int ntry[num_hypos];
+    double metrop_dx[num_hypos];
 
     char status_msg[MAXLINE_LONG] = "";
-    int nLowAcc, iHypo;
+    int nLowAcc, jHypo;
     int nHypoActive;
 
     // get solution quality at each sample on random walk
 
-    nll_putmsg(3, "");
-    nll_putmsg(3, "Calculating solution along Metropolis walk...");
-
     iGridType = ptgrid[0].type;
 
     // 20110725 AJL - added temperature
@@ -1589,67 +1759,29 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
 
     // initialize hypocenter working arrays
     nHypoActive = 0;
-    for (nHypo = 0; nHypo < NumHypocenters; nHypo++) {
+    for (iHypo = 0; iHypo < num_hypos; iHypo++) {
+        nHypo = hypo_index[iHypo];
         phypo = DiffHypocenters + nHypo;
-        if (phypo->flag_ignore)
-            continue;
-        hyp_test_xyz[nHypo].x = phypo->x;
-        hyp_test_xyz[nHypo].y = phypo->y;
-        hyp_test_xyz[nHypo].z = phypo->z;
-        hyp_test_dt[nHypo] = phypo->dotime;
+        phypo->ipos = iHypo * iFdataOffset;
+        hyp_test_xyz[iHypo].x = phypo->x;
+        hyp_test_xyz[iHypo].y = phypo->y;
+        hyp_test_xyz[iHypo].z = phypo->z;
+        hyp_test_dt[iHypo] = phypo->dotime;
         // init likelihood
-        value = DiffLocCalcSolutionQuality(hyp_test_xyz[nHypo], hyp_test_dt[nHypo],
-                nHypo, NumHypocenters, DiffHypocenters,
-                num_arr_loc, arrival, gauss_par,
-                iGridType, temperature, &misfit, NULL, &nReject, 0);
-        if (nReject) {
-            phypo->misfit = HUGE_MISFIT;
-            phypo->probmax = 0.0;
-        } else {
-            phypo->misfit = misfit;
-            phypo->probmax = exp(value);
-        }
-        hyp_value[nHypo] = value;
-        hyp_dlike[nHypo] = phypo->probmax;
-        hyp_dlike_sum[nHypo] = phypo->probmax;
-        hyp_dlike_num_mean[nHypo] = 1;
-        phypo->grid_misfit_max = phypo->misfit;
-        metrop_dx[nHypo] = dx_init = 2.0 * pMetrop->dx;
-        ntry[nHypo] = TARGET_NUM_MET_TRIES;
-        printf("< nHypo %d (%4.4d%2.2d%2.2d %2.2d%2.2d%2.2d x%f y%f z%f)  mf_init %f like_init %e step %g",
-                nHypo, phypo->year, phypo->month, phypo->day,
-                phypo->hour, phypo->min, (int) phypo->sec,
-                phypo->x, phypo->y, phypo->z,
-                phypo->misfit, (double) phypo->probmax, metrop_dx[nHypo]);
-        hyp_fixed[nHypo] = 0;
-        if (NumHypocenterFix >= 0 && nHypo == NumHypocenterFix) {
-            hyp_fixed[nHypo] = 1;
-        } else if (NumHypocenterFree >= 0 && nHypo != NumHypocenterFree) {
-            hyp_fixed[nHypo] = 1;
-        }
-        if (hyp_fixed[nHypo])
-            printf("  FIXED\n");
-        else
-            printf("\n");
-        hyp_abort[nHypo] = 0;
+        value = DiffLocInitHypocenter(nHypo, num_arr_cluster, arrival, arrival_index, gauss_par, iGridType);
+        hyp_value[iHypo] = value;
+        hyp_dlike[iHypo] = phypo->probmax;
+        hyp_dlike_sum[iHypo] = phypo->probmax;
+        hyp_dlike_num_mean[iHypo] = 1;
+        metrop_dx[iHypo] = dx_init = 2.0 * pMetrop->dx;
+        ntry[iHypo] = TARGET_NUM_MET_TRIES;
+        hyp_fixed[iHypo] = isFixedDiffHypocenter(nHypo);
+        hyp_abort[iHypo] = 0;
         // count active
-        if (!hyp_fixed[nHypo] && !phypo->flag_ignore)
+        if (!hyp_fixed[iHypo])
             nHypoActive++;
     }
 
-    // check for best
-    for (nHypo = 0; nHypo < NumHypocenters; nHypo++) {
-        phypo = DiffHypocenters + nHypo;
-        if (phypo->flag_ignore)
-            continue;
-        if (phypo->probmax > hypo_likelyhood_best) {
-            hypo_likelyhood_best = phypo->probmax;
-            hypo_misfit_best = phypo->misfit;
-            iHypo_hypo_likelyhood_best = nHypo;
-        }
-    }
-    printf("<<  like_init_best %e  nHypo %d\n", hypo_likelyhood_best, iHypo_hypo_likelyhood_best);
-
     // set walk limits equal to grid limits
     xmin = ptgrid->origx;
     xmax = xmin + (double) (ptgrid->numx - 1) * ptgrid->dx;
@@ -1666,37 +1798,47 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
 
     ntryTotal = 0;
     nSamplesTotal = 0;
-    nHypo = 0;
+    iHypo = 0;
+    nHypo = hypo_index[iHypo];
+    phypo = DiffHypocenters + nHypo;
     nGenerated = 0;
     nAcceptMax = 0;
     nAcceptMin = 0;
-    imessage_modulo = (200001 * NumHypocenters / num_arr_loc);
+    imessage_modulo = num_arr_cluster > 0 ? (200001 * num_hypos / num_arr_cluster) : 1;
+    if (imessage_modulo < 1)
+        imessage_modulo = 1;
 
     // 20180615 AJL - add common move for all hypocenters
-    double probCommonMoveAllHypos = -1.0 / (double) NumHypocenters;
-    //double probCommonMoveAllHypos = 0.01 / (double) NumHypocenters;
+    double probCommonMoveAllHypos = -1.0 / (double) num_hypos;
+    //double probCommonMoveAllHypos = 0.01 / (double) num_hypos;
     if (probCommonMoveAllHypos > 0.0) {
-        sprintf(MsgStr, "WARNING: common move for all hypocenters is active - new, non-standard procedure!!!!!!");
-        nll_putmsg(1, MsgStr);
+#ifdef _OPENMP
+#pragma omp critical(nll_diffloc_msg)
+#endif
+        {
+            sprintf(MsgStr, "WARNING: common move for all hypocenters is active - new, non-standard procedure!!!!!!");
+            nll_putmsg(1, MsgStr);
+        }
     }
     int isCommonMoveAllHypos = 0;
     double xCommonMove, yCommonMove, zCommonMove, tCommonMove;
-    double misfits[NumHypocenters];
-    double values[NumHypocenters];
+    double misfits[num_hypos];
+    double values[num_hypos];
 
 
     while (!requested_terminate) {
 
         // set next hypocenter
         itest = 0;
-        while (itest < NumHypocenters) {
-            nHypo++;
-            if (nHypo >= NumHypocenters) {
-                nHypo = 0;
+        while (itest < num_hypos) {
+            iHypo++;
+            if (iHypo >= num_hypos) {
+                iHypo = 0;
                 nAcceptMin = nAcceptMax; // nAcceptMin will be approximate
             }
+            nHypo = hypo_index[iHypo];
             phypo = DiffHypocenters + nHypo;
-            if (!hyp_fixed[nHypo] && !phypo->flag_ignore && !hyp_abort[nHypo] && phypo->nSamples < MetNumSamples) {
+            if (!hyp_fixed[iHypo] && !hyp_abort[iHypo] && phypo->nSamples < MetNumSamples) {
                 if (phypo->nSamples < nAcceptMin)
                     nAcceptMin = phypo->nSamples;
                 break;
@@ -1705,8 +1847,8 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
             //			if (phypo->nSamples >= MetNumSamples)
             //				iFinishedSome = 1;
         }
-        // check if all non-ignored hypos have reached MetNumSamples
-        if (itest >= NumHypocenters)
+        // check if all hypos in cluster have reached MetNumSamples
+        if (itest >= num_hypos)
             break;
         //printf("TP 1 - nHypo %d\n", nHypo);
 
@@ -1714,59 +1856,69 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
         // test for common move for all hypocenters if temperature has reached 1.0
         if (probCommonMoveAllHypos > 0.0) {
             //if (temperature < 1.00001)          // test only if temperature has reached 1.0
-            isCommonMoveAllHypos = get_rand_double(0.0, 1.0) < probCommonMoveAllHypos;
+            isCommonMoveAllHypos = rand_double(pstream, 0.0, 1.0) < probCommonMoveAllHypos;
         }
 
         // set met params
-        pMetrop->x = hyp_test_xyz[nHypo].x;
-        pMetrop->y = hyp_test_xyz[nHypo].y;
-        pMetrop->z = hyp_test_xyz[nHypo].z;
-        pMetrop->dt = hyp_test_dt[nHypo];
+        pMetrop->x = hyp_test_xyz[iHypo].x;
+        pMetrop->y = hyp_test_xyz[iHypo].y;
+        pMetrop->z = hyp_test_xyz[iHypo].z;
+        pMetrop->dt = hyp_test_dt[iHypo];
 
         // adjust met step as a function of last ntry for this hypo
-        if (ntry[nHypo] <= TARGET_NUM_MET_TRIES && metrop_dx[nHypo] < MetStepMax) {
-            metrop_dx[nHypo] *= 1.01; // increase step slowly
-            //printf("DEBUG: INCREASE: metrop_dx[nHypo] %f\n", metrop_dx[nHypo]);
-        } else if (ntry[nHypo] > TARGET_NUM_MET_TRIES) {
-            //metrop_dx[nHypo] = pMetrop->dx; 	// decrease step immediately
-            metrop_dx[nHypo] /= 1.1; // decrease step quickly
+        if (ntry[iHypo] <= TARGET_NUM_MET_TRIES && metrop_dx[iHypo] < MetStepMax) {
+            metrop_dx[iHypo] *= 1.01; // increase step slowly
+            //printf("DEBUG: INCREASE: metrop_dx[iHypo] %f\n", metrop_dx[iHypo]);
+        } else if (ntry[iHypo] > TARGET_NUM_MET_TRIES) {
+            //metrop_dx[iHypo] = pMetrop->dx; 	// decrease step immediately
+            metrop_dx[iHypo] /= 1.1; // decrease step quickly
             /* 20170221 AJL - modified to include temperature in test, to keep step size large at beginning of search
-            if (metrop_dx[nHypo] < pMetrop->dx)
-                metrop_dx[nHypo] = pMetrop->dx;
+            if (metrop_dx[iHypo] < pMetrop->dx)
+                metrop_dx[iHypo] = pMetrop->dx;
              */
-            if (metrop_dx[nHypo] < temperature * pMetrop->dx)
-                metrop_dx[nHypo] = temperature * pMetrop->dx;
-            //printf("DEBUG: DECREASE: metrop_dx[nHypo] %f\n", metrop_dx[nHypo]);
+            if (metrop_dx[iHypo] < temperature * pMetrop->dx)
+                metrop_dx[iHypo] = temperature * pMetrop->dx;
+            //printf("DEBUG: DECREASE: metrop_dx[iHypo] %f\n", metrop_dx[iHypo]);
         }
 
-        ntry[nHypo] = 0;
+        ntry[iHypo] = 0;
         while (1) {
 
             // check abort search conditions
 
             // failure to accept sample after maxNumTries
-            if (ntry[nHypo] >= maxNumTries) {
+            if (ntry[iHypo] >= maxNumTries) {
                 if (iFinishedSome) {
                     // 20180516 AJL  if (phypo->nSamples < (MetNumSamples * 9 / 10)) {
                     if (phypo->nSamples < ((MetNumSamples * 6) / 10)) {
-                        if (message_flag > 0)
-                            fprintf(stdout, "\n");
-                        sprintf(MsgStr,
-                                "WARNING: acceptance rate low %d/%d, stopping search for hypocenter %d.", phypo->nSamples, nAcceptMax, nHypo);
-                        nll_puterr(MsgStr);
-                        hyp_abort[nHypo] = 1;
+#ifdef _OPENMP
+#pragma omp critical(nll_diffloc_msg)
+#endif
+                        {
+                            if (message_flag > 0)
+                                fprintf(stdout, "\n");
+                            sprintf(MsgStr,
+                                    "WARNING: acceptance rate low %d/%d, stopping search for hypocenter %d.", phypo->nSamples, nAcceptMax, nHypo);
+                            nll_puterr(MsgStr);
+                            snprintf(phypo->locStatComm, sizeof(phypo->locStatComm), "%s", MsgStr);
+                        }
+                        hyp_abort[iHypo] = 1;
                         nHypoActive--;
                         sprintf(phypo->locStat, "ABORTED");
-                        snprintf(phypo->locStatComm, sizeof(phypo->locStatComm), "%s", MsgStr);
                     } else if (phypo->probmax < SMALLEST_LIKELIHOOD) {
-                        if (message_flag > 0)
-                            fprintf(stdout, "\n");
-                        sprintf(MsgStr,
-                                "WARNING: likeAve too low %.2e, stopping search for hypocenter %d.", (double) phypo->probmax, nHypo);
-                        nll_puterr(MsgStr);
-                        hyp_abort[nHypo] = 1;
+#ifdef _OPENMP
+#pragma omp critical(nll_diffloc_msg)
+#endif
+                        {
+                            if (message_flag > 0)
+                                fprintf(stdout, "\n");
+                            sprintf(MsgStr,
+                                    "WARNING: likeAve too low %.2e, stopping search for hypocenter %d.", (double) phypo->probmax, nHypo);
+                            nll_puterr(MsgStr);
+                            snprintf(phypo->locStatComm, sizeof(phypo->locStatComm), "%s", MsgStr);
+                        }
+                        hyp_abort[iHypo] = 1;
                         sprintf(phypo->locStat, "ABORTED");
-                        snprintf(phypo->locStatComm, sizeof(phypo->locStatComm), "%s", MsgStr);
                     }
                 }
                 break;
@@ -1774,14 +1926,14 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
 
             // increment sample
 
-            ntry[nHypo]++;
+            ntry[iHypo]++;
             nGenerated++;
 
             if (message_flag > 0 && nGenerated % imessage_modulo == 0/* || ntry >= maxNumTries*/) {
                 // check how many hypos have low rate of acceptance
                 nLowAcc = 0;
-                for (iHypo = 0; iHypo < NumHypocenters; iHypo++) {
-                    if (ntry[iHypo] >= maxNumTries || (DiffHypocenters + iHypo)->nSamples < nAcceptMax / 10)
+                for (jHypo = 0; jHypo < num_hypos; jHypo++) {
+                    if (ntry[jHypo] >= maxNumTries || (DiffHypocenters + hypo_index[jHypo])->nSamples < nAcceptMax / 10)
                         nLowAcc++;
                 }
                 sprintf(status_msg,
@@ -1789,9 +1941,9 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
                         nHypoActive, nLowAcc,
                         nSamplesTotal, (int) nGenerated, nAcceptMin, nAcceptMax,
                         (double) ntryTotal / (double) nSamplesTotal,
-                        nHypo, metrop_dx[nHypo], ntry[nHypo], phypo->nSamples, MetNumSamples,
+                        nHypo, metrop_dx[iHypo], ntry[iHypo], phypo->nSamples, MetNumSamples,
                         phypo->misfit, (double) phypo->probmax,
-                        hyp_dlike_sum[nHypo] / (double) hyp_dlike_num_mean[nHypo]
+                        hyp_dlike_sum[iHypo] / (double) hyp_dlike_num_mean[iHypo]
                         );
                 fprintf(stdout, "%s", status_msg);
                 fflush(stdout);
@@ -1804,13 +1956,13 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
                 temperature = 1.0;
 
 
-            double step = temperature * metrop_dx[nHypo];
+            double step = temperature * metrop_dx[iHypo];
             //if (isCommonMoveAllHypos) {
-            //    step = metrop_dx[nHypo];
+            //    step = metrop_dx[iHypo];
             //}
             int iClip = DiffLocGetNextMetropolisSample(pMetrop, step,
                     xmin, xmax, ymin, ymax,
-                    zmin, zmax, &xval, &yval, &zval, &tval);
+                    zmin, zmax, &xval, &yval, &zval, &tval, pstream);
             if (iClip > 0) {
                 phypo->numClipped += iClip;
                 numClipped += iClip;
@@ -1820,37 +1972,38 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
 
             // re-calculate misfit for current sample, since other events may have moved
             /* seems to make little difference in hypoDD_example1 test,  but takes 2x time
-            hyp_value[nHypo] = DiffLocCalcSolutionQuality(hyp_xyz[nHypo], hyp_dt[nHypo],
+            hyp_value[iHypo] = DiffLocCalcSolutionQuality(hyp_xyz[iHypo], hyp_dt[iHypo],
                             nHypo, NumHypocenters, DiffHypocenters,
-                            num_arr_loc, arrival, gauss_par,
+                            num_arr_cluster, arrival, arrival_index, gauss_par,
                             iGridType, temperature, &misfit, NULL, &nReject, 0);
-            hyp_dlike[nHypo] = exp(hyp_value[nHypo]);
+            hyp_dlike[iHypo] = exp(hyp_value[iHypo]);
              */
 
             int iAccept = 0;
 
             if (isCommonMoveAllHypos) {
                 // determine common move from set hypocenter move
-                xCommonMove = xval - hyp_test_xyz[nHypo].x;
-                yCommonMove = yval - hyp_test_xyz[nHypo].y;
-                zCommonMove = zval - hyp_test_xyz[nHypo].z;
-                tCommonMove = tval - hyp_test_dt[nHypo];
+                xCommonMove = xval - hyp_test_xyz[iHypo].x;
+                yCommonMove = yval - hyp_test_xyz[iHypo].y;
+                zCommonMove = zval - hyp_test_xyz[iHypo].z;
+                tCommonMove = tval - hyp_test_dt[iHypo];
                 // get solution quality before shift and provisional shift of all hypocenters
                 double like_total_before_shift = 0.0;
                 double like_total_after_shift = 0.0;
                 int iclipped = 0;
-                for (int nhyp = 0; nhyp < NumHypocenters; nhyp++) {
+                for (int ihyp = 0; ihyp < num_hypos; ihyp++) {
+                    int nhyp = hypo_index[ihyp];
                     HypoDesc* phyp_check = DiffHypocenters + nhyp;
-                    if (hyp_fixed[nhyp] || phyp_check->flag_ignore || hyp_abort[nhyp] || phyp_check->nSamples > MetNumSamples) {
+                    if (hyp_fixed[ihyp] || hyp_abort[ihyp] || phyp_check->nSamples > MetNumSamples) {
                         continue;
                     }
-                    hyp_test_xyz[nhyp].x = phyp_check->x;
-                    hyp_test_xyz[nhyp].y = phyp_check->y;
-                    hyp_test_xyz[nhyp].z = phyp_check->z;
-                    hyp_test_dt[nhyp] = phyp_check->dotime;
-                    value = DiffLocCalcSolutionQuality(hyp_test_xyz[nhyp], hyp_test_dt[nhyp],
+                    hyp_test_xyz[ihyp].x = phyp_check->x;
+                    hyp_test_xyz[ihyp].y = phyp_check->y;
+                    hyp_test_xyz[ihyp].z = phyp_check->z;
+                    hyp_test_dt[ihyp] = phyp_check->dotime;
+                    value = DiffLocCalcSolutionQuality(hyp_test_xyz[ihyp], hyp_test_dt[ihyp],
                             nhyp, NumHypocenters, DiffHypocenters,
-                            num_arr_loc, arrival, gauss_par,
+                            num_arr_cluster, arrival, arrival_index, gauss_par,
                             iGridType, temperature, &misfit, NULL, &nReject, 0);
                     like_total_before_shift += exp(value);
                     double x = phyp_check->x + xCommonMove;
@@ -1864,17 +2017,17 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
                     phyp_check->y = y;
                     phyp_check->z = z;
                     phyp_check->dotime += tCommonMove;
-                    hyp_test_xyz[nhyp].x = phyp_check->x;
-                    hyp_test_xyz[nhyp].y = phyp_check->y;
-                    hyp_test_xyz[nhyp].z = phyp_check->z;
-                    hyp_test_dt[nhyp] = phyp_check->dotime;
+                    hyp_test_xyz[ihyp].x = phyp_check->x;
+                    hyp_test_xyz[ihyp].y = phyp_check->y;
+                    hyp_test_xyz[ihyp].z = phyp_check->z;
+                    hyp_test_dt[ihyp] = phyp_check->dotime;
                     if (!iclipped) {
-                        values[nhyp] = DiffLocCalcSolutionQuality(hyp_test_xyz[nhyp], hyp_test_dt[nhyp],
+                        values[ihyp] = DiffLocCalcSolutionQuality(hyp_test_xyz[ihyp], hyp_test_dt[ihyp],
                                 nhyp, NumHypocenters, DiffHypocenters,
-                                num_arr_loc, arrival, gauss_par,
+                                num_arr_cluster, arrival, arrival_index, gauss_par,
                                 iGridType, temperature, &misfit, NULL, &nReject, 0);
-                        misfits[nhyp] = misfit;
-                        like_total_after_shift += exp(values[nhyp]);
+                        misfits[ihyp] = misfit;
+                        like_total_after_shift += exp(values[ihyp]);
                     }
                 }
                 int iAccept;
@@ -1883,19 +2036,19 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
                     iAccept = 0;
                 } else {
                     iAccept = DiffLocMetropolisTest(like_total_before_shift, like_total_after_shift,
-                            like_total_before_shift, like_total_after_shift, 0);
+                            like_total_before_shift, like_total_after_shift, 0, pstream);
                 }
                 if (iAccept) {
                     double dlike = 0.0;
-                    for (int nhyp = 0; nhyp < NumHypocenters; nhyp++) {
-                        HypoDesc* phyp_check = DiffHypocenters + nhyp;
-                        if (hyp_fixed[nhyp] || phyp_check->flag_ignore || hyp_abort[nhyp] || phyp_check->nSamples > MetNumSamples) {
+                    for (int ihyp = 0; ihyp < num_hypos; ihyp++) {
+                        HypoDesc* phyp_check = DiffHypocenters + hypo_index[ihyp];
+                        if (hyp_fixed[ihyp] || hyp_abort[ihyp] || phyp_check->nSamples > MetNumSamples) {
                             continue;
                         }
-                        DiffLocUpdateAfterAccept(misfits[nhyp], values[nhyp], dlike, 0,
+                        DiffLocUpdateAfterAccept(misfits[ihyp], values[ihyp], dlike, 0,
                                 phyp_check->x, phyp_check->y, phyp_check->z, phyp_check->dotime,
                                 phyp_check, hyp_test_xyz, hyp_test_dt,
-                                nhyp,
+                                ihyp,
                                 hyp_value, hyp_dlike, hyp_dlike_sum, hyp_dlike_num_mean,
                                 &nSamplesTotal, fdata);
                         if (phyp_check->nSamples == MetNumSamples) {
@@ -1908,9 +2061,9 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
                     }
                 } else { // rejected
                     // undo provisional shift of all hypocenters for rejected
-                    for (int nhyp = 0; nhyp < NumHypocenters; nhyp++) {
-                        HypoDesc* phyp_check = DiffHypocenters + nhyp;
-                        if (hyp_fixed[nhyp] || phyp_check->flag_ignore || hyp_abort[nhyp] || phyp_check->nSamples > MetNumSamples) {
+                    for (int ihyp = 0; ihyp < num_hypos; ihyp++) {
+                        HypoDesc* phyp_check = DiffHypocenters + hypo_index[ihyp];
+                        if (hyp_fixed[ihyp] || hyp_abort[ihyp] || phyp_check->nSamples > MetNumSamples) {
                             continue;
                         }
                         phyp_check->x -= xCommonMove;
@@ -1926,10 +2079,11 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
             } else {
                 iAccept = DiffLocTestHypo(0, xval, yval, zval, tval,
                         phypo, hyp_test_xyz, hyp_test_dt,
-                        nHypo, ntry[nHypo], maxNumTries, nAcceptMax, NumHypocenters, DiffHypocenters, num_arr_loc, arrival,
+                        nHypo, iHypo, ntry[iHypo], maxNumTries, nAcceptMax, NumHypocenters, DiffHypocenters,
+                        num_arr_cluster, arrival, arrival_index,
                         hyp_value, hyp_dlike, hyp_dlike_sum, hyp_dlike_num_mean,
                         gauss_par, iGridType, temperature, NULL, 0,
-                        &nSamplesTotal, fdata);
+                        pstream, &nSamplesTotal, fdata);
                 if (iAccept > 0) { // accepted
                     if (phypo->nSamples == MetNumSamples) {
                         iFinishedSome = 1;
@@ -1955,58 +2109,65 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
 
         }
 
-        ntryTotal += ntry[nHypo];
+        ntryTotal += ntry[iHypo];
 
     }
 
 
 
-    if (message_flag > 0)
-        fprintf(stdout, "\n");
+#ifdef _OPENMP
+#pragma omp critical(nll_diffloc_msg)
+#endif
+    {
 
-    // give warning if sample points clipped
+        if (message_flag > 0)
+            fprintf(stdout, "\n");
 
-    if (numClipped > 0) {
-        sprintf(MsgStr,
-                "WARNING: %d Metropolis samples clipped at search grid boundary.", numClipped);
-        nll_putmsg(1, MsgStr);
-    }
+        // give warning if sample points clipped
+
+        if (numClipped > 0) {
+            sprintf(MsgStr,
+                    "WARNING: %d Metropolis samples clipped at search grid boundary.", numClipped);
+            nll_putmsg(1, MsgStr);
+        }
 
 
-    // give warning if grid points rejected
+        // give warning if grid points rejected
 
-    if (numGridReject > 0) {
-        sprintf(MsgStr,
-                "WARNING: %d Metropolis samples rejected; travel times for %d hypocenter test locations were not valid.",
-                numGridReject, numGridReject);
-        nll_putmsg(1, MsgStr);
-    }
+        if (numGridReject > 0) {
+            sprintf(MsgStr,
+                    "WARNING: %d Metropolis samples rejected; travel times for %d hypocenter test locations were not valid.",
+                    numGridReject, numGridReject);
+            nll_putmsg(1, MsgStr);
+        }
 
-    for (nHypo = 0; nHypo < NumHypocenters; nHypo++) {
+        for (iHypo = 0; iHypo < num_hypos; iHypo++) {
 
-        phypo = DiffHypocenters + nHypo;
+            phypo = DiffHypocenters + hypo_index[iHypo];
 
-        // check reject location conditions
+            // check reject location conditions
 
-        // maximum like hypo on edge of grid
-        if ((iBoundary = isOnGridBoundary(phypo->x, phypo->y, phypo->z,
-                ptgrid, pMetrop->dx, pMetrop->dx, 0))) {
+            // maximum like hypo on edge of grid
+            if ((iBoundary = isOnGridBoundary(phypo->x, phypo->y, phypo->z,
+                    ptgrid, pMetrop->dx, pMetrop->dx, 0))) {
 
-            sprintf(MsgStr,
-                    "WARNING: max prob location on grid boundary %d, rejecting location.", iBoundary);
-            nll_putmsg(1, MsgStr);
-            snprintf(phypo->locStatComm, sizeof(phypo->locStatComm), "%s", MsgStr);
-            sprintf(phypo->locStat, "REJECTED");
-        }
+                sprintf(MsgStr,
+                        "WARNING: max prob location on grid boundary %d, rejecting location.", iBoundary);
+                nll_putmsg(1, MsgStr);
+                snprintf(phypo->locStatComm, sizeof(phypo->locStatComm), "%s", MsgStr);
+                sprintf(phypo->locStat, "REJECTED");
+            }
+
+            // construct search information string
+            sprintf(phypo->searchInfo,
+                    "METROPOLIS nSamp %ld nAcc %d nSave %d nClip %d Dstep0 %lf Dstep %lf",
+                    nGenerated, phypo->nSamples, phypo->nScatterSaved, phypo->numClipped,
+                    dx_init, metrop_dx[iHypo]);
+            // write message
+            nll_putmsg(3, phypo->searchInfo);
 
-        // construct search information string
-        sprintf(phypo->searchInfo,
-                "METROPOLIS nSamp %ld nAcc %d nSave %d nClip %d Dstep0 %lf Dstep %lf",
-                nGenerated, phypo->nSamples, phypo->nScatterSaved, phypo->numClipped,
-                dx_init, metrop_dx[nHypo]);
-        // write message
-        nll_putmsg(3, phypo->searchInfo);
 
+        }
 
     }
 
@@ -2015,6 +2176,90 @@ int DiffLocMetropolis(int num_arr_total, int num_arr_loc,
 
 }
 
+/*** function to save scatter samples and sample statistics of hypocenters in a cluster
+ *
+ *  scatter samples in fdata are written to scatter file of each hypocenter and may be released after return
+ *  scatter file header probmax is written with best location in LocateDiff(), see DiffLocSaveScatterHeader()
+ */
+
+int DiffLocSaveClusterScatter(DiffLocCluster* pcluster, float* fdata, long int iFdataOffset) {
+
+    int iHypo, nHypo;
+    char fname[2*FILENAME_MAX];
+    FILE *fpio;
+    float ftemp;
+    HypoDesc *phypo;
+
+    for (iHypo = 0; iHypo < pcluster->num_hypos; iHypo++) {
+
+        nHypo = pcluster->hypo_index[iHypo];
+        phypo = DiffHypocenters + nHypo;
+
+        // write scatter file
+        snprintf(fname, sizeof (fname), "%s.loc.scat", phypo->fileroot);
+        if ((fpio = fopen(fname, "w")) != NULL) {
+            // write scatter file header informaion, probmax set with best location
+            fseek(fpio, 0, SEEK_SET);
+            fwrite(&(phypo->nScatterSaved), sizeof (int), 1, fpio);
+            ftemp = 0.0;
+            fwrite(&ftemp, sizeof (float), 1, fpio);
+            // skip header record
+            fseek(fpio, 4 * sizeof (float), SEEK_SET);
+            // write scatter samples
+            fwrite(fdata + iHypo * iFdataOffset, 4 * sizeof (float), phypo->nScatterSaved, fpio);
+            fclose(fpio);
+        } else {
+#ifdef _OPENMP
+#pragma omp critical(nll_diffloc_msg)
+#endif
+            nll_puterr("ERROR: opening scatter output file.");
+            return (EXIT_ERROR_IO);
+        }
+
+        // calculate "traditional" statistics
+        phypo->expect =
+                CalcExpectationSamples(fdata + iHypo * iFdataOffset, phypo->nScatterSaved);
+        rect2latlon(0, phypo->expect.x, phypo->expect.y,
+                &(phypo->expect_dlat), &(phypo->expect_dlong));
+        phypo->cov = CalcCovarianceSamples(fdata + iHypo * iFdataOffset, phypo->nScatterSaved,
+                &phypo->expect);
+        if (phypo->nScatterSaved) {
+            phypo->ellipsoid = CalcErrorEllipsoid(&phypo->cov, DELTA_CHI_SQR_68_3);
+            phypo->ellipse = CalcHorizontalErrorEllipse(&Hypocenter.cov, DELTA_CHI_SQR_68_2); // 20190101 AJL - added
+        }
+
+    }
+
+    return (0);
+
+}
+
+
+
+
+/*** function to write scatter file header of hypocenter after best location is saved */
+
+int DiffLocSaveScatterHeader(HypoDesc* phypo) {
+
+    char fname[2*FILENAME_MAX];
+    FILE *fpio;
+    float ftemp;
+
+    snprintf(fname, sizeof (fname), "%s.loc.scat", phypo->fileroot);
+    if ((fpio = fopen(fname, "r+")) == NULL) {
+        nll_puterr("ERROR: opening scatter output file.");
+        return (EXIT_ERROR_IO);
+    }
+    fseek(fpio, 0, SEEK_SET);
+    fwrite(&(phypo->nScatterSaved), sizeof (int), 1, fpio);
+    ftemp = (float) phypo->probmax;
+    fwrite(&ftemp, sizeof (float), 1, fpio);
+    fclose(fpio);
+
+    return (0);
+
+}
+
 
 
 
@@ -2065,7 +2310,7 @@ int clip(double *px, double *py, double *pz,
 
 int DiffLocGetNextMetropolisSample(WalkParams* pMetrop, double dx, double xmin, double xmax,
         double ymin, double ymax, double zmin, double zmax,
-        double* pxval, double* pyval, double* pzval, double* ptval) {
+        double* pxval, double* pyval, double* pzval, double* ptval, RandStream* pstream) {
 
     int iClip = 0;
     double valx, valy, valz, valt, valsum, norm;
@@ -2075,10 +2320,10 @@ int DiffLocGetNextMetropolisSample(WalkParams* pMetrop, double dx, double xmin,
     /* get unit vector in random direction */
 
     do {
-        valx = get_rand_double(-1.0, 1.0);
-        valy = get_rand_double(-1.0, 1.0);
-        valz = get_rand_double(-1.0, 1.0);
-        valt = get_rand_double(-1.0, 1.0);
+        valx = rand_double(pstream, -1.0, 1.0);
+        valy = rand_double(pstream, -1.0, 1.0);
+        valz = rand_double(pstream, -1.0, 1.0);
+        valt = rand_double(pstream, -1.0, 1.0);
         valsum = valx * valx + valy * valy + valz * valz + valt * valt;
     } while (valsum < SMALL_DOUBLE);
 
@@ -2122,7 +2367,7 @@ int DiffLocGetNextMetropolisSample(WalkParams* pMetrop, double dx, double xmin,
 
 /*** function to test new metropolis string */
 
-int DiffLocMetropolisTest(double value_last, double value_new, double exp_last, double exp_new, int reverse_comparison) {
+int DiffLocMetropolisTest(double value_last, double value_new, double exp_last, double exp_new, int reverse_comparison, RandStream* pstream) {
 
     if (reverse_comparison) {
         double temp = value_last;
@@ -2150,7 +2395,7 @@ int DiffLocMetropolisTest(double value_last, double value_new, double exp_last,
     if (value_new > value_last)
         return (1);
 
-    if ((prob = get_rand_double(0.0, 1.0)) < exp_new / exp_last)
+    if ((prob = rand_double(pstream, 0.0, 1.0)) < exp_new / exp_last)
         return (1);
 
     else
@@ -2164,18 +2409,18 @@ int DiffLocMetropolisTest(double value_last, double value_new, double exp_last,
 double DiffLocCalcSolutionQuality(
         Vect3D hypo_test, double dtime,
         int nHypo, int num_hypos, HypoDesc* hypos,
-        int num_arrivals, ArrivalDesc* arrival,
+        int num_arrivals, ArrivalDesc* arrival, int *arrival_index,
         GaussLocParams* gauss_par, int itype, double temperature, double* pmisfit, double* potime, int* pnReject, int isave) {
 
     if (LocMethod == METH_GAU_ANALYTIC) {
         double norm = 2.0;
         return (DiffLocCalcSolutionQuality_LN_NORM(norm,
-                hypo_test, dtime, nHypo, num_hypos, hypos, num_arrivals, arrival,
+                hypo_test, dtime, nHypo, num_hypos, hypos, num_arrivals, arrival, arrival_index,
                 gauss_par, itype, temperature, pmisfit, potime, pnReject, isave));
     } else if (LocMethod == METH_L1_NORM) {
         double norm = 1.0;
         return (DiffLocCalcSolutionQuality_LN_NORM(norm,
-                hypo_test, dtime, nHypo, num_hypos, hypos, num_arrivals, arrival,
+                hypo_test, dtime, nHypo, num_hypos, hypos, num_arrivals, arrival, arrival_index,
                 gauss_par, itype, temperature, pmisfit, potime, pnReject, isave));
     } else {
 
@@ -2194,10 +2439,10 @@ double DiffLocCalcSolutionQuality(
 double DiffLocCalcSolutionQuality_LN_NORM(double norm,
         Vect3D hypo_test, double dtime,
         int nHypo, int num_hypos, HypoDesc* hypos,
-        int num_arrivals, ArrivalDesc* arrival,
+        int num_arrivals, ArrivalDesc* arrival, int *arrival_index,
         GaussLocParams* gauss_par, int itype, double temperature, double* pmisfit, double* potime, int* pnReject, int isave) {
 
-    int narr;
+    int n, narr;
 
     double weight, weight_sum;
     double misfit_sum, misfit_like;
@@ -2212,7 +2457,7 @@ double DiffLocCalcSolutionQuality_LN_NORM(double norm,
 
     // isave
     int n_compan;
-    static char filename[2*FILENAME_MAX];
+    char filename[2*FILENAME_MAX];
     HypoDesc* phypo = NULL;
     HypoDesc* phypoOther = NULL;
 
@@ -2237,8 +2482,10 @@ double DiffLocCalcSolutionQuality_LN_NORM(double norm,
     //hypoDD misfit_ave = 0.0;
     misfit_like = 0.0;
     weight_sum = 0.0;
-    for (narr = 0; narr < num_arrivals; narr++) {
+    for (n = 0; n < num_arrivals; n++) {
 
+        // 20261018 AJL - added: arrivals may be restricted to arrivals linking hypocenters of a cluster
+        narr = arrival_index == NULL ? n : arrival_index[n];
         parr = arrival + narr;
 
         if (parr->flag_ignore)
@@ -2282,7 +2529,7 @@ double DiffLocCalcSolutionQuality_LN_NORM(double norm,
         //printf("FOUND!!!\n");
 
         // get travel time difference
-        travel_time_diff = getTravelTimeDiff(arrival, narr, hypo1, hypo2);
+        travel_time_diff = getTravelTimeDiff(arrival, narr, hypo1, hypo2, nHypo);
         //printf("nHypo %d  travel_time_diff %lf\n", nHypo, travel_time_diff);
         if (travel_time_diff < -LARGE_DOUBLE) {
             if (isave) {
@@ -2341,22 +2588,23 @@ double DiffLocCalcSolutionQuality_LN_NORM(double norm,
                         &(arrival[narr].station), phypo->x, phypo->y);
             }
             // read angles
-            if (angleMode == ANGLE_MODE_YES) {
+            // 20261018 AJL - added ANGLE_MODE_TIME, angles from time grid gradient
+            if (angleMode == ANGLE_MODE_YES || angleMode == ANGLE_MODE_TIME) {
                 n_compan = arrival[narr].n_companion;
                 if (n_compan >= 0)
-                    sprintf(filename, "%s.angle", arrival[n_compan].fileroot);
+                    sprintf(filename, angleMode == ANGLE_MODE_TIME ? "%s.time" : "%s.angle", arrival[n_compan].fileroot);
                 else
-                    sprintf(filename, "%s.angle", arrival[narr].fileroot);
+                    sprintf(filename, angleMode == ANGLE_MODE_TIME ? "%s.time" : "%s.angle", arrival[narr].fileroot);
                 if (arrival[narr].gdesc.type == GRID_TIME) {
                     // 3D grid
-                    ReadTakeOffAnglesFile(filename,
+                    ReadTakeOffAngles(filename,
                             phypo->x, phypo->y, phypo->z,
                             &(arrival[narr].ray_azim),
                             &(arrival[narr].ray_dip),
                             &(arrival[narr].ray_qual), -1.0, iSwapBytesOnInput);
                 } else {
                     // 2D grid (1D model)
-                    ReadTakeOffAnglesFile(filename,
+                    ReadTakeOffAngles(filename,
                             0.0, arrival[narr].dist, phypo->z,
                             &(arrival[narr].ray_azim),
                             &(arrival[narr].ray_dip),
@@ -2401,14 +2649,49 @@ double DiffLocCalcSolutionQuality_LN_NORM(double norm,
 
 }
 
-/** function to get difference in travel times for one arrival for two events (T1 - T2) */
+/** function to read travel time from 3D time grid, reads from disk are serialized between threads */
+
+static double read_travel_time_3d(FILE* fp_grid, GridDesc* ptgrid, Vect3D hypo) {
+
+    double travel_time;
+
+    if (fp_grid == NULL)
+        return ((double) ReadAbsInterpGrid3d(NULL, ptgrid, hypo.x, hypo.y, hypo.z, 0));
+
+#ifdef _OPENMP
+#pragma omp critical(nll_diffloc_grid_read)
+#endif
+    travel_time = (double) ReadAbsInterpGrid3d(fp_grid, ptgrid, hypo.x, hypo.y, hypo.z, 0);
+
+    return (travel_time);
+
+}
+
+/** function to read travel time from 2D time grid, reads from disk are serialized between threads */
 
-double getTravelTimeDiff(ArrivalDesc* arrival, int narr, Vect3D hypo1, Vect3D hypo2) {
+static double read_travel_time_2d(FILE* fp_grid, GridDesc* ptgrid, double yval_grid, double zval) {
+
+    double travel_time;
+
+    if (fp_grid == NULL)
+        return (ReadAbsInterpGrid2d(NULL, ptgrid, yval_grid, zval));
+
+#ifdef _OPENMP
+#pragma omp critical(nll_diffloc_grid_read)
+#endif
+    travel_time = ReadAbsInterpGrid2d(fp_grid, ptgrid, yval_grid, zval);
+
+    return (travel_time);
+
+}
+
+/** function to read travel time from time grid of arrival or of its companion arrival */
+
+static double read_travel_time(ArrivalDesc* arrival, int narr, Vect3D hypo) {
 
     int n_compan;
     FILE* fp_grid;
     double yval_grid;
-    double travel_time1, travel_time2;
     GridDesc* ptgrid;
     ArrivalDesc* arr;
 
@@ -2419,8 +2702,6 @@ double getTravelTimeDiff(ArrivalDesc* arrival, int narr, Vect3D hypo1, Vect3D hy
         arr = arrival + n_compan;
     }
 
-    /* get times for 2 events */
-
     if (arr->gdesc.type == GRID_TIME) {
         /* 3D grid */
         if (arr->gdesc.buffer == NULL) {
@@ -2430,48 +2711,86 @@ double getTravelTimeDiff(ArrivalDesc* arrival, int narr, Vect3D hypo1, Vect3D hy
             /* read time grid from memory buffer */
             fp_grid = NULL;
         }
-        // hypo1
-        travel_time1 = (double) ReadAbsInterpGrid3d(fp_grid, &(arr->gdesc), hypo1.x, hypo1.y, hypo1.z, 0);
-        if (travel_time1 < 0.0)
-            return (-LARGE_DOUBLE * 2.0);
-        // hypo2
-        travel_time2 = (double) ReadAbsInterpGrid3d(fp_grid, &(arr->gdesc), hypo2.x, hypo2.y, hypo2.z, 0);
-        if (travel_time2 < 0.0)
-            return (-LARGE_DOUBLE * 2.0);
+        return (read_travel_time_3d(fp_grid, &(arr->gdesc), hypo));
+    }
+
+    /* 2D grid (1D model) */
+    if (arr->sheetdesc.buffer == NULL) {
+        /* read time grid from disk */
+        fp_grid = arr->fpgrid;
+        ptgrid = &(arr->gdesc);
     } else {
-        /* 2D grid (1D model) */
-        if (arr->sheetdesc.buffer == NULL) {
-            /* read time grid from disk */
-            fp_grid = arr->fpgrid;
-            ptgrid = &(arr->gdesc);
+        /* read time grid from memory buffer */
+        fp_grid = NULL;
+        ptgrid = &(arr->sheetdesc);
+    }
+    yval_grid = GetEpiDist(&(arr->station), hypo.x, hypo.y);
+    if (GeometryMode == MODE_GLOBAL)
+        yval_grid *= KM2DEG;
+
+    return (read_travel_time_2d(fp_grid, ptgrid, yval_grid, hypo.z));
+
+}
+
+/** function to get travel time from hypocenter 1 (iside = 0) or hypocenter 2 (iside = 1) of arrival to station-phase of arrival
+ *
+ *  travel time is taken from travel time cache if hypocenter has not moved since travel time was read,
+ *  is_test = 1 if hypo is test location of hypocenter, 0 if hypo is current location of hypocenter
+ */
+
+static double get_travel_time(ArrivalDesc* arrival, int narr, int iside, Vect3D hypo, int is_test) {
+
+    int nslot, ibank;
+    DiffTravelTimeCacheHypo* pcache;
+
+    if (DiffTTCache.arrival_slot == NULL || (nslot = DiffTTCache.arrival_slot[2 * narr + iside]) < 0)
+        return (read_travel_time(arrival, narr, hypo));
+
+    pcache = DiffTTCache.hypo + (iside == 0 ? arrival[narr].dd_event_index_1 : arrival[narr].dd_event_index_2);
+    ibank = is_test ? 1 - pcache->ibank_current : pcache->ibank_current;
+    if (pcache->stamp[ibank] == 0 || pcache->pos[ibank].x != hypo.x || pcache->pos[ibank].y != hypo.y
+            || pcache->pos[ibank].z != hypo.z) {
+        if (!is_test && pcache->stamp[1 - ibank] != 0 && pcache->pos[1 - ibank].x == hypo.x
+                && pcache->pos[1 - ibank].y == hypo.y && pcache->pos[1 - ibank].z == hypo.z) {
+            // hypocenter moved to last test location, test bank becomes current bank
+            pcache->ibank_current = ibank = 1 - ibank;
         } else {
-            /* read time grid from memory buffer */
-            fp_grid = NULL;
-            ptgrid = &(arr->sheetdesc);
-        }
-        // hypo1
-        yval_grid = GetEpiDist(&(arr->station), hypo1.x, hypo1.y);
-        if (GeometryMode == MODE_GLOBAL)
-            yval_grid *= KM2DEG;
-        travel_time1 = ReadAbsInterpGrid2d(fp_grid, ptgrid, yval_grid, hypo1.z);
-        if (travel_time1 < 0.0) {
-            //printf("narr %d  travel_time1 %lf  yval_grid %lf  hypo1.z %lf  (arrival + narr)->tfact %f  ptgrid %s\n",
-            //narr, travel_time2,  yval_grid, hypo1.z, (arrival + narr)->tfact, ptgrid->title);
-            return (-LARGE_DOUBLE * 2.0);
-        }
-        // hypo2
-        yval_grid = GetEpiDist(&(arr->station), hypo2.x, hypo2.y);
-        if (GeometryMode == MODE_GLOBAL)
-            yval_grid *= KM2DEG;
-        travel_time2 = ReadAbsInterpGrid2d(fp_grid, ptgrid, yval_grid, hypo2.z);
-        if (travel_time2 < 0.0) {
-            //printf("narr %d  travel_time2 %lf  yval_grid %lf  hypo2.z %lf  (arrival + narr)->tfact %f  ptgrid %s\n",
-            //narr, travel_time2,  yval_grid, hypo2.z, (arrival + narr)->tfact, ptgrid->title);
-
-            return (-LARGE_DOUBLE * 2.0);
+            // hypocenter moved, invalidate bank
+            pcache->pos[ibank] = hypo;
+            pcache->stamp[ibank] = ++(pcache->stamp_count);
         }
     }
 
+    nslot = 2 * nslot + ibank;
+    if (DiffTTCache.slot_stamp[nslot] != pcache->stamp[ibank]) {
+        DiffTTCache.travel_time[nslot] = read_travel_time(arrival, narr, hypo);
+        DiffTTCache.slot_stamp[nslot] = pcache->stamp[ibank];
+    }
+
+    return (DiffTTCache.travel_time[nslot]);
+
+}
+
+/** function to get difference in travel times for one arrival for two events (T1 - T2)
+ *
+ *  nHypoTest is index of hypocenter at test location, if any
+ */
+
+double getTravelTimeDiff(ArrivalDesc* arrival, int narr, Vect3D hypo1, Vect3D hypo2, int nHypoTest) {
+
+    double travel_time1, travel_time2;
+
+    /* get times for 2 events */
+
+    // hypo1
+    travel_time1 = get_travel_time(arrival, narr, 0, hypo1, arrival[narr].dd_event_index_1 == nHypoTest);
+    if (travel_time1 < 0.0)
+        return (-LARGE_DOUBLE * 2.0);
+    // hypo2
+    travel_time2 = get_travel_time(arrival, narr, 1, hypo2, arrival[narr].dd_event_index_2 == nHypoTest);
+    if (travel_time2 < 0.0)
+        return (-LARGE_DOUBLE * 2.0);
+
     return ((travel_time1 - travel_time2) * (arrival + narr)->tfact);
 
 }
@@ -2505,7 +2824,7 @@ int DiffLocSaveBestLocation(int num_arr_total, int num_arr_loc, ArrivalDesc *arr
     // re-calculate solution
     value = DiffLocCalcSolutionQuality(hyp_xyz, phypo->dotime,
             nHypo, NumHypocenters, DiffHypocenters,
-            num_arr_loc, arrival, gauss_par,
+            num_arr_loc, arrival, NULL, gauss_par,
             iGridType, temperature, &misfit, NULL, &nReject, 1);
     if (nReject) {
         phypo->misfit = HUGE_MISFIT;
@@ -2624,6 +2943,267 @@ int AssignEventIndexes(
 
 }
 
+/*** function to find root of hypocenter in cluster tree */
+
+static int find_cluster_root(int *parent, int nhyp) {
+
+    while (parent[nhyp] != nhyp) {
+        parent[nhyp] = parent[parent[nhyp]];
+        nhyp = parent[nhyp];
+    }
+
+    return (nhyp);
+
+}
+
+/*** function to find clusters of hypocenters connected by differential time links
+ *
+ *  hypocenters in different clusters do not affect each other and may be located independently
+ *  clusters are ordered by first hypocenter index, each non-ignored hypocenter is in one cluster
+ *  returns number of clusters, or -1 on error
+ */
+
+int FindDiffClusters(int num_hypos, HypoDesc* hypos, int num_arrivals, ArrivalDesc *arrival, DiffLocCluster** pclusters) {
+
+    int narr, nhyp, ncluster, num_clusters, root1, root2;
+    int *parent, *cluster_id, *hypo_index, *arrival_index;
+    DiffLocCluster *clusters, *pcluster;
+    ArrivalDesc* parr;
+
+    *pclusters = NULL;
+
+    parent = (int *) malloc(num_hypos * sizeof (int));
+    cluster_id = (int *) malloc(num_hypos * sizeof (int));
+    hypo_index = (int *) malloc((num_hypos > 0 ? num_hypos : 1) * sizeof (int));
+    arrival_index = (int *) malloc((num_arrivals > 0 ? num_arrivals : 1) * sizeof (int));
+    clusters = (DiffLocCluster *) calloc(num_hypos > 0 ? num_hypos : 1, sizeof (DiffLocCluster));
+    if (parent == NULL || cluster_id == NULL || hypo_index == NULL || arrival_index == NULL || clusters == NULL) {
+        nll_puterr("ERROR: allocating memory for hypocenter clusters.");
+        free(parent);
+        free(cluster_id);
+        free(hypo_index);
+        free(arrival_index);
+        free(clusters);
+        return (-1);
+    }
+
+    /* join hypocenters linked by differential times */
+
+    for (nhyp = 0; nhyp < num_hypos; nhyp++)
+        parent[nhyp] = nhyp;
+    for (narr = 0; narr < num_arrivals; narr++) {
+        parr = arrival + narr;
+        if (parr->flag_ignore)
+            continue;
+        root1 = find_cluster_root(parent, parr->dd_event_index_1);
+        root2 = find_cluster_root(parent, parr->dd_event_index_2);
+        if (root1 < root2)
+            parent[root2] = root1;
+        else if (root2 < root1)
+            parent[root1] = root2;
+    }
+
+    /* number clusters and count hypocenters and arrivals of each cluster */
+
+    num_clusters = 0;
+    for (nhyp = 0; nhyp < num_hypos; nhyp++) {
+        cluster_id[nhyp] = -1;
+        if (hypos[nhyp].flag_ignore)
+            continue;
+        root1 = find_cluster_root(parent, nhyp);
+        if (root1 == nhyp)
+            cluster_id[nhyp] = num_clusters++;
+        else
+            cluster_id[nhyp] = cluster_id[root1];
+        clusters[cluster_id[nhyp]].num_hypos++;
+    }
+    for (narr = 0; narr < num_arrivals; narr++) {
+        parr = arrival + narr;
+        if (!parr->flag_ignore)
+            clusters[cluster_id[parr->dd_event_index_1]].num_arrivals++;
+    }
+
+    /* fill index lists, hypocenter and arrival lists of all clusters share one allocation */
+
+    hypo_index[0] = arrival_index[0] = 0;
+    for (ncluster = 0; ncluster < num_clusters; ncluster++) {
+        pcluster = clusters + ncluster;
+        pcluster->hypo_index = ncluster == 0 ? hypo_index : (pcluster - 1)->hypo_index + (pcluster - 1)->num_hypos;
+        pcluster->arrival_index = ncluster == 0 ? arrival_index : (pcluster - 1)->arrival_index + (pcluster - 1)->num_arrivals;
+    }
+    for (ncluster = 0; ncluster < num_clusters; ncluster++)
+        clusters[ncluster].num_hypos = clusters[ncluster].num_arrivals = 0;
+    for (nhyp = 0; nhyp < num_hypos; nhyp++) {
+        if (cluster_id[nhyp] >= 0) {
+            pcluster = clusters + cluster_id[nhyp];
+            pcluster->hypo_index[pcluster->num_hypos++] = nhyp;
+        }
+    }
+    for (narr = 0; narr < num_arrivals; narr++) {
+        parr = arrival + narr;
+        if (!parr->flag_ignore) {
+            pcluster = clusters + cluster_id[parr->dd_event_index_1];
+            pcluster->arrival_index[pcluster->num_arrivals++] = narr;
+        }
+    }
+
+    free(parent);
+    free(cluster_id);
+    if (num_clusters < 1) {
+        free(hypo_index);
+        free(arrival_index);
+        free(clusters);
+        return (0);
+    }
+
+    *pclusters = clusters;
+
+    return (num_clusters);
+
+}
+
+/*** function to free hypocenter clusters */
+
+void FreeDiffClusters(DiffLocCluster* clusters, int num_clusters) {
+
+    if (clusters == NULL || num_clusters < 1)
+        return;
+
+    // index lists of all clusters start at index lists of first cluster
+    free(clusters[0].hypo_index);
+    free(clusters[0].arrival_index);
+    free(clusters);
+
+}
+
+/*** function to check if any arrival time grid is a cascading grid */
+
+int hasCascadingGrids(int num_arrivals, ArrivalDesc *arrival) {
+
+    int narr;
+    ArrivalDesc* parr;
+
+    for (narr = 0; narr < num_arrivals; narr++) {
+        parr = arrival + narr;
+        if (parr->flag_ignore)
+            continue;
+        if (parr->n_companion >= 0)
+            parr = arrival + parr->n_companion;
+        if (parr->gdesc.type == GRID_TIME && isCascadingGrid(&(parr->gdesc)))
+            return (1);
+    }
+
+    return (0);
+
+}
+
+/*** travel time cache slot reference, for sorting */
+
+typedef struct {
+    int nhyp; // hypocenter index
+    int ngrid; // index of arrival holding time grid
+    int nref; // 2 * arrival index + 0 for hypocenter 1 or 1 for hypocenter 2
+} DiffTravelTimeSlotRef;
+
+static int compare_slot_ref(const void *p1, const void *p2) {
+
+    const DiffTravelTimeSlotRef *pref1 = (const DiffTravelTimeSlotRef *) p1;
+    const DiffTravelTimeSlotRef *pref2 = (const DiffTravelTimeSlotRef *) p2;
+
+    if (pref1->nhyp != pref2->nhyp)
+        return (pref1->nhyp < pref2->nhyp ? -1 : 1);
+    if (pref1->ngrid != pref2->ngrid)
+        return (pref1->ngrid < pref2->ngrid ? -1 : 1);
+
+    return (0);
+
+}
+
+/*** function to initialize cache of travel times from hypocenters to station-phases of differential time arrivals
+ *
+ *  one slot for each hypocenter and station-phase, shared by all arrivals of hypocenter with the station-phase
+ *  if cache cannot be allocated, travel times are read from time grids for each arrival
+ *  returns number of slots, or -1 on error
+ */
+
+int InitDiffTravelTimeCache(int num_hypos, int num_arrivals, ArrivalDesc *arrival) {
+
+    int narr, nref, num_refs, nslot;
+    DiffTravelTimeSlotRef *refs;
+    ArrivalDesc* parr;
+
+    FreeDiffTravelTimeCache();
+
+    if ((refs = (DiffTravelTimeSlotRef *) malloc((2 * num_arrivals > 0 ? 2 * num_arrivals : 1) * sizeof (DiffTravelTimeSlotRef))) == NULL
+            || (DiffTTCache.arrival_slot = (int *) malloc((2 * num_arrivals > 0 ? 2 * num_arrivals : 1) * sizeof (int))) == NULL
+            || (DiffTTCache.hypo = (DiffTravelTimeCacheHypo *) calloc(num_hypos > 0 ? num_hypos : 1, sizeof (DiffTravelTimeCacheHypo))) == NULL) {
+        free(refs);
+        FreeDiffTravelTimeCache();
+        nll_puterr("WARNING: allocating memory for travel time cache, travel times will not be cached.");
+        return (-1);
+    }
+
+    /* collect hypocenter station-phase of each arrival and sort to find arrivals sharing a station-phase */
+
+    num_refs = 0;
+    for (narr = 0; narr < num_arrivals; narr++) {
+        parr = arrival + narr;
+        DiffTTCache.arrival_slot[2 * narr] = DiffTTCache.arrival_slot[2 * narr + 1] = -1;
+        if (parr->flag_ignore || parr->dd_event_index_1 < 0 || parr->dd_event_index_2 < 0)
+            continue;
+        refs[num_refs].nhyp = parr->dd_event_index_1;
+        refs[num_refs].ngrid = parr->n_companion >= 0 ? parr->n_companion : narr;
+        refs[num_refs].nref = 2 * narr;
+        num_refs++;
+        refs[num_refs].nhyp = parr->dd_event_index_2;
+        refs[num_refs].ngrid = refs[num_refs - 1].ngrid;
+        refs[num_refs].nref = 2 * narr + 1;
+        num_refs++;
+    }
+    qsort(refs, num_refs, sizeof (DiffTravelTimeSlotRef), compare_slot_ref);
+
+    nslot = -1;
+    for (nref = 0; nref < num_refs; nref++) {
+        if (nref == 0 || compare_slot_ref(refs + nref, refs + nref - 1) != 0)
+            nslot++;
+        DiffTTCache.arrival_slot[refs[nref].nref] = nslot;
+    }
+    DiffTTCache.num_slots = nslot + 1;
+    free(refs);
+
+    /* two banks for each slot, slot stamps of 0 are never valid */
+
+    if ((DiffTTCache.travel_time = (double *) malloc((2 * DiffTTCache.num_slots > 0 ? 2 * DiffTTCache.num_slots : 1) * sizeof (double))) == NULL
+            || (DiffTTCache.slot_stamp = (long *) calloc(2 * DiffTTCache.num_slots > 0 ? 2 * DiffTTCache.num_slots : 1, sizeof (long))) == NULL) {
+        FreeDiffTravelTimeCache();
+        nll_puterr("WARNING: allocating memory for travel time cache, travel times will not be cached.");
+        return (-1);
+    }
+
+    sprintf(MsgStr, "DiffLoc: travel time cache: %d hypocenter station-phases for %d differential time arrivals.",
+            DiffTTCache.num_slots, num_refs / 2);
+    nll_putmsg(2, MsgStr);
+
+    return (DiffTTCache.num_slots);
+
+}
+
+/*** function to free cache of travel times */
+
+void FreeDiffTravelTimeCache() {
+
+    free(DiffTTCache.arrival_slot);
+    free(DiffTTCache.travel_time);
+    free(DiffTTCache.slot_stamp);
+    free(DiffTTCache.hypo);
+    DiffTTCache.arrival_slot = NULL;
+    DiffTTCache.travel_time = NULL;
+    DiffTTCache.slot_stamp = NULL;
+    DiffTTCache.hypo = NULL;
+    DiffTTCache.num_slots = 0;
+
+}
+
 /*** function to write differential time event links in GMT graphics xyz format */
 
 int SaveDiffTimeLinks(int num_hypos, HypoDesc* hypos, int num_arrivals, ArrivalDesc* arrival, FILE * fp_out) {
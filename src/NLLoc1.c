@@ -69,6 +69,8 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 #include "phaseloclist.h"
 #include "otime_limit.h"
 #include "NLLocLib.h"
+#include "nll_prof.h"
+#include "nll_gridcache.h"
 
 #include "json_io.h"
 
@@ -133,6 +135,7 @@ int NLLoc
     NumLocExclude = NumLocInclude = 0;
     NumTimeDelays = 0;
     NumPhaseID = 0;
+    ClearPhaseIDCache(); // 20261019 AJL - added
     DistStaGridMax = 0.0;
     MinNumArrLoc = 0;
     MinNumSArrLoc = 0;
@@ -173,6 +176,10 @@ int NLLoc
     OtimeLimitList = NULL;
     NumOtimeLimit = 0;
 
+    // reciprocity
+    NumRecipCentroids = 0;
+    NumRecipPhases = 0;
+
     // GLOBAL
     NumSources = 0;
     NumStationPhases = 0;
@@ -190,6 +197,11 @@ int NLLoc
     iSaveNLLocExpectation = 0;
     // 20220131 AJL - added
     iSaveNLLocEvent_JSON = 0;
+    // 20261018 AJL - added
+    iSaveNLLocProf = iSaveNLLocProfJSON = 0;
+    iSaveNLLocBatch = 0;
+    iSaveNLLocScatCompressed = 0;
+    iSaveLast = SAVE_LAST_COPY;
 
     // GNU C library extensions to support memory streams (function open_memstream).
     char *bp_memory_stream = NULL;
@@ -402,6 +414,7 @@ int NLLoc
                 continue;
             } else {
                 NumFilesOpen++;
+                setvbuf(fp_obs, NULL, _IOFBF, OBS_FILE_BUFFER_SIZE); // 20261018 AJL - added
             }
             /* extract info from filename */
             if ((istat = ExtractFilenameInfo(fn_loc_obs[nObsFile], ftype_obs)) < 0)
@@ -420,6 +433,13 @@ int NLLoc
             if (i_end_of_input)
                 break;
 
+            // 20261018 AJL - per event profile, compiled with NLL_PROFILE
+            NLL_PROF_RESET();
+            NLL_PROF_START(t_prof_event);
+
+            // 20261019 AJL - cached grid files checked for changes on disk once per event
+            RecheckGridFileCache();
+
             if (NumArrivals != OBS_FILE_SKIP_INPUT_LINE) {
                 nll_putmsg(2, "");
                 sprintf(MsgStr,
@@ -573,6 +593,9 @@ int NLLoc
                 NumLocationsCompleted++;
             iLocated = 1;
 
+            NLL_PROF_STOP(PROF_T_EVENT, t_prof_event);
+            WriteProfile(fn_root_out);
+
 cleanup:
             ;
 
@@ -588,7 +611,7 @@ cleanup:
                 // check has opened time grid
                 //if (Arrival[narr].n_time_grid < 0) {
                 //if (Arrival[narr].n_time_grid < 0 && !Arrival[narr].flag_ignore) { // 20160925 AJL - bug fix, ignored arrivals should already have grids freed
-                if (Arrival[narr].n_companion < 0 && Arrival[narr].n_time_grid < 0 && !Arrival[narr].flag_ignore) { // 20170207 AJL - bug fix
+                if (Arrival[narr].n_companion < 0 && Arrival[narr].n_time_grid < 0 && Arrival[narr].n_recip < 0 && !Arrival[narr].flag_ignore) { // 20170207 AJL - bug fix
                     DestroyGridArray(&(Arrival[narr].sheetdesc));
                     FreeGrid(&(Arrival[narr].sheetdesc));
                     NLL_DestroyGridArray(&(Arrival[narr].gdesc));
@@ -735,6 +758,8 @@ cleanup_return:
 
     //  20141219 AJL - bug? fix, moved here from inside events/obs loop!
     NLL_FreeGridMemory();
+    FreeRecipGrids();
+    FreeGridFileCache();
 
     if (!iSaveNone)
         CloseSummaryFiles();
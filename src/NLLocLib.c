@@ -113,6 +113,24 @@ e-mail: anthony@alomax.net  web: http://www.alomax.net
 #include "otime_limit.h"
 #include "NLLocLib.h"
 #include "json_io.h"
+#include "nll_prof.h"
+#include "nll_writer.h"
+#include "nll_scat.h"
+#include "nll_gridcache.h"
+#include "nll_staindex.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// 20261018 AJL - memory streams (open_memstream) needed for batched output (LOCHYPOUT SAVE_NLLOC_BATCH)
+#if defined(_GNU_SOURCE) || (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L)
+#define NLL_HAVE_MEMSTREAM
+#endif
 
 #ifdef CUSTOM_ETH
 #include "custom_eth/eth_functions.h"
@@ -170,11 +188,18 @@ iSaveHypoInvSum, iSaveHypoInvY2KArc, iSaveAlberto4Sum, iSaveFmamp,
 iSaveSnapSum, iCalcSedOrigin, iSaveDecSec, iSavePublicID, iSaveNone;
 int iSaveNLLocExpectation;
 int iSaveNLLocEvent_JSON;
+int iSaveNLLocProf, iSaveNLLocProfJSON; // 20261018 AJL - added
+int iSaveNLLocBatch; // 20261018 AJL - added
+int iSaveNLLocScatCompressed; // 20261018 AJL - added
+int iSaveLast; // 20261018 AJL - added
 int iUseArrivalPriorWeights;
 int iSetStationDistributionWeights;
 double stationDistributionWeightCutoff;
 double AveInterStationDistance;
 int NumForceOctTreeStaDenWt;
+// 20261018 AJL - per-event state of OctTree station density weight, was static in getOctTreeStationDensityWeight()
+static StationIndex OctTreeStationIndex; // stations used for current event
+static double MeanRootNodeHorizDs;
 int iRejectDuplicateArrivals;
 EventTimeExtract EventTime;
 long int EventID;
@@ -190,6 +215,11 @@ ExcludeDesc LocInclude[MAX_NUM_LOC_INCLUDE];
 int NumLocInclude;
 TimeDelayDesc TimeDelay[MAX_NUM_STA_DELAYS];
 int NumTimeDelays;
+char RecipGridRoot[FILENAME_MAX];
+char RecipCentroidLabel[MAX_NUM_RECIP_CENTROIDS][ARRIVAL_LABEL_LEN];
+int NumRecipCentroids;
+RecipPhaseDesc RecipPhase[MAX_NUM_RECIP_PHASES];
+int NumRecipPhases;
 char TimeDelaySurfacePhase[MAX_SURFACES][PHASE_LABEL_LEN];
 double TimeDelaySurfaceMultiplier[MAX_SURFACES];
 int NumTimeDelaySurface;
@@ -221,7 +251,7 @@ OcttreeParams octtreeParams; /* Octtree parameters */
 Tree3D* octTree; /* Octtree */
 ResultTreeNode* resultTreeRoot; /* Octtree likelihood*volume results tree root node */
 //ResultTreeNode* resultTreeLikelihoodRoot;	/* Octtree likelihood results tree root node */
-int angleMode; /* angle mode - ANGLE_MODE_NO, ANGLE_MODE_YES */
+int angleMode; /* angle mode - ANGLE_MODE_NO, ANGLE_MODE_YES, ANGLE_MODE_TIME */
 int iAngleQualityMin; /* minimum quality for angles to be used */
 OtimeLimit** OtimeLimitList;
 int NumOtimeLimit;
@@ -244,6 +274,14 @@ FILE *pSumFileHypoInv[MAX_NUM_LOCATION_GRIDS];
 FILE *pSumFileHypoInvY2K[MAX_NUM_LOCATION_GRIDS];
 FILE *pSumFileAlberto4[MAX_NUM_LOCATION_GRIDS];
 FILE *pSumFileFmamp[MAX_NUM_LOCATION_GRIDS];
+FILE *pSumFileProf, *pSumFileProfJSON; // 20261018 AJL - added
+// 20261018 AJL - batched event output, per run hyp, scatter and index streams written by background writer
+FILE *pBatchFileHyp[MAX_NUM_LOCATION_GRIDS];
+FILE *pBatchFileScat[MAX_NUM_LOCATION_GRIDS];
+FILE *pBatchFileIndex[MAX_NUM_LOCATION_GRIDS];
+static long BatchHypBytes[MAX_NUM_LOCATION_GRIDS], BatchScatBytes[MAX_NUM_LOCATION_GRIDS];
+static long BatchScatOffsetEvent[MAX_NUM_LOCATION_GRIDS], BatchScatSizeEvent[MAX_NUM_LOCATION_GRIDS];
+static NllWriter *BatchWriter;
 
 
 // AJL - 20080710 (valgrind)
@@ -256,6 +294,23 @@ int clean_memory(int istat);
 double *ot_ml_arrival = NULL; // array of ot estimate for each arrival
 double *ot_ml_arrival_edt_sum = NULL; // array of weight of ot estimate for each arrival
 int isize_ot_ml_array = 0;
+// 20261018 AJL - ot estimates sorted by time for maximum likelihood origin time search
+typedef struct {
+    double ot; // ot estimate for arrival
+    double sigma2; // edtmtx diagonal element for arrival
+    double sqrt_sigma2;
+    double edt_weight; // pot_ml_arrival_edt_sum for arrival, or 1.0 if not used
+    double apriori_weight; // arrival apriori_weight, or 1.0 if not used
+    int narr;
+}
+OtMLEstimate;
+OtMLEstimate *ot_ml_sorted = NULL;
+int isize_ot_ml_sorted = 0;
+#ifdef _OPENMP
+// 20261018 AJL - EDT_OT_WT_ML work arrays are per thread, solution quality is evaluated in parallel in LocGridSearch()
+#pragma omp threadprivate(ot_ml_arrival, ot_ml_arrival_edt_sum, isize_ot_ml_array, ot_ml_sorted, isize_ot_ml_sorted)
+#endif
+static void free_ot_ml_arrays();
 
 // ConstWeightMatrix() allocations
 MatrixDouble wt_matrix = NULL;
@@ -399,6 +454,9 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
                 nll_puterr("ERROR: cannot apply OctTree Station Density Weight: Ave Station Distance is zero!");
             }
             NumForceOctTreeStaDenWt = 0;
+            MeanRootNodeHorizDs = -VERY_LARGE_DOUBLE;
+            if (BuildStationIndex(&OctTreeStationIndex, StationPhaseList, NumStationPhases) < 0)
+                return (clean_memory(EXIT_ERROR_LOCATE));
         }
 
         // initialize memory/arrays for regular, initial oct-tree search grid
@@ -449,6 +507,9 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
     }
 
 
+    // 20261018 AJL - set per event station geometry used to evaluate travel times at search nodes
+    setArrivalTravelTimeGeometry(Arrival, NumArrivalsLocation);
+
     /* do search */
 
     if (SearchType == SEARCH_GRID) {
@@ -561,7 +622,22 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
         }
 
         /* write scatter file */
-        if (iSaveNLLocEvent) {
+        if (iSaveNLLocEvent && iSaveNLLocBatch) {
+            // 20261018 AJL - append to batch scatter stream
+            if (SaveScatterBatch(ngrid, &Hypocenter, fdata) < 0) {
+                nll_puterr("ERROR: writing scatter samples to batch output file.");
+                return (clean_memory(EXIT_ERROR_IO));
+            }
+        } else if (iSaveNLLocEvent && iSaveNLLocScatCompressed) {
+            // 20261018 AJL - compressed scatter container, coordinates quantized relative to hypocenter
+            sprintf(fname, "%s.loc.scatz", fnout);
+            if (WriteScatterCompressed(fname, fdata, Hypocenter.nScatterSaved, (float) Hypocenter.probmax,
+                    Hypocenter.x, Hypocenter.y, Hypocenter.z,
+                    GeometryMode == MODE_GLOBAL ? SCATZ_QUANTUM_DEG : SCATZ_QUANTUM_KM) < 0) {
+                nll_puterr("ERROR: writing compressed scatter output file.");
+                return (clean_memory(EXIT_ERROR_IO));
+            }
+        } else if (iSaveNLLocEvent) {
             sprintf(fname, "%s.loc.scat", fnout);
             if ((fpio = fopen(fname, "w")) != NULL) {
                 /* write scatter file header information */
@@ -767,7 +843,8 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
 
         /* save location grid header to disk */
 
-        if (!iSaveNone && LocGridSave[ngrid])
+        // 20261018 AJL - batch output header written once per run in OpenSummaryFiles()
+        if (!iSaveNone && LocGridSave[ngrid] && !iSaveNLLocBatch)
             if ((istat = WriteGrid3dHdr(LocGrid + ngrid, NULL, fnout, "loc")) < 0) {
                 nll_puterr("ERROR: writing grid header to disk.");
                 return (clean_memory(EXIT_ERROR_IO));
@@ -793,10 +870,12 @@ int Locate(int ngrid, char* fn_loc_obs, char* fn_root_out, int numArrivalsReject
         /* calculate estimated VpVs ratio */
         CalculateVpVsEstimate(&Hypocenter, Arrival, NumArrivals);
         /* save location */
+        NLL_PROF_START(t_prof_save);
         if ((istat = SaveLocation(&Hypocenter, ngrid, fn_loc_obs, fnout, numArrivalsReject, "grid", 1, &Gauss)) < 0) {
             nll_puterr("ERROR: saving location.");
             return (clean_memory(istat));
         }
+        NLL_PROF_STOP(PROF_T_SAVE_LOCATION, t_prof_save);
         /* add location to loclist */
         if (return_locations) {
             ploc_list_node = newLocation(
@@ -969,6 +1048,17 @@ int clean_memory(int istat) {
 
     // AJL - 20080710 (valgrind)
     // free EDT_OT_WT memory
+    free_ot_ml_arrays();
+    FreeStationIndex(&OctTreeStationIndex);
+
+    return (istat);
+
+}
+
+/** function to free EDT_OT_WT work arrays of calling thread */
+
+static void free_ot_ml_arrays() {
+
     if (ot_ml_arrival != NULL)
         free(ot_ml_arrival);
     ot_ml_arrival = NULL;
@@ -976,8 +1066,27 @@ int clean_memory(int istat) {
         free(ot_ml_arrival_edt_sum);
     ot_ml_arrival_edt_sum = NULL;
     isize_ot_ml_array = 0;
+    if (ot_ml_sorted != NULL)
+        free(ot_ml_sorted);
+    ot_ml_sorted = NULL;
+    isize_ot_ml_sorted = 0;
 
-    return (istat);
+}
+
+/** function to activate EDT origin time weight and write message once, may be called from parallel grid search */
+
+static void set_edt_otime_weight_active(char *message) {
+
+#ifdef _OPENMP
+#pragma omp critical(nll_edt_otime_weight)
+#endif
+    {
+        if (!EDT_otime_weight_active) {
+            EDT_otime_weight_active = 1;
+            sprintf(MsgStr, "%s", message);
+            nll_putmsg(2, MsgStr);
+        }
+    }
 
 }
 
@@ -1052,6 +1161,129 @@ static int save_location_count = 0;
 
 /** function to display and save minimum misfit location to file */
 
+/** function to copy or symbolically link an event output file to a last.* file in the output directory
+ *
+ * 20261018 AJL - added
+ */
+
+void SaveLastFile(char *fname, char *lastname) {
+
+    char targetfname[2 * FILENAME_MAX];
+
+    if (iSaveLast == SAVE_LAST_NONE)
+        return;
+
+    sprintf(targetfname, "%s%s", f_outpath, lastname);
+#ifndef _WIN32
+    if (iSaveLast == SAVE_LAST_SYMLINK) {
+        // event file and last.* are in the same directory, link to event file name only
+        char *pchr = strrchr(fname, '/');
+        pchr = pchr == NULL ? fname : pchr + 1;
+        unlink(targetfname);
+        if (symlink(pchr, targetfname) != 0)
+            nll_puterr2("WARNING: creating symbolic link", targetfname);
+        return;
+    }
+#endif
+    copy_file(fname, targetfname);
+
+}
+
+/** function to write NLLoc hypocenter-phase text to a new memory buffer
+ *
+ * returns malloc'ed buffer and sets *psize, or returns NULL on error
+ *
+ * 20261018 AJL - added
+ */
+
+char *WriteLocationToBuffer(HypoDesc* hypo, ArrivalDesc* parrivals, int narrivals, char *filename, int isave_phases,
+        int ngrid, size_t *psize) {
+
+#ifdef NLL_HAVE_MEMSTREAM
+    char *buf = NULL;
+    FILE *fp_memory_stream = open_memstream(&buf, psize);
+    if (fp_memory_stream == NULL)
+        return (NULL);
+    int istat = WriteLocation(fp_memory_stream, hypo, parrivals, narrivals, filename, isave_phases, 1, 0, LocGrid + ngrid, 0);
+    fclose(fp_memory_stream);
+    if (istat < 0) {
+        free(buf);
+        return (NULL);
+    }
+    return (buf);
+#else
+    nll_puterr("ERROR: writing location to memory buffer: memory streams (function open_memstream()) not available.");
+    return (NULL);
+#endif
+
+}
+
+/** function to append event scatter samples to batch scatter stream
+ *
+ *  record is identical to contents of event .scat file:
+ *      int nScatterSaved, float probmax, 2 floats unused, nScatterSaved * (float x, y, z, prob)
+ *
+ * 20261018 AJL - added
+ */
+
+int SaveScatterBatch(int ngrid, HypoDesc* phypo, float *fdata) {
+
+    int nsamples = phypo->nScatterSaved > 0 ? phypo->nScatterSaved : 0;
+    size_t size = (size_t) (1 + nsamples) * 4 * sizeof (float);
+    char *buf;
+
+    if ((buf = calloc(1, size)) == NULL)
+        return (-1);
+    memcpy(buf, &(phypo->nScatterSaved), sizeof (int));
+    float ftemp = (float) phypo->probmax;
+    memcpy(buf + sizeof (int), &ftemp, sizeof (float));
+    if (nsamples > 0)
+        memcpy(buf + 4 * sizeof (float), fdata, (size_t) nsamples * 4 * sizeof (float));
+
+    BatchScatOffsetEvent[ngrid] = BatchScatBytes[ngrid];
+    BatchScatSizeEvent[ngrid] = (long) size;
+    BatchScatBytes[ngrid] += (long) size;
+
+    return (NllWriter_write(BatchWriter, pBatchFileScat[ngrid], buf, size));
+
+}
+
+/** function to append NLLoc hypocenter-phase event to batch hyp stream and add event to batch index
+ *
+ *  index line: <event root name> <hyp offset> <hyp bytes> <scatter offset> <scatter bytes>
+ *
+ * 20261018 AJL - added
+ */
+
+int SaveLocationBatch(HypoDesc* hypo, int ngrid, char *fname, char *fnout, int numArrivalsReject, int isave_phases) {
+
+    char *buf;
+    size_t size;
+    long hyp_offset;
+
+    if ((buf = WriteLocationToBuffer(hypo, Arrival, NumArrivals + numArrivalsReject, fname, isave_phases, ngrid, &size)) == NULL)
+        return (-1);
+    hyp_offset = BatchHypBytes[ngrid];
+    BatchHypBytes[ngrid] += (long) size;
+    if (NllWriter_write(BatchWriter, pBatchFileHyp[ngrid], buf, size) < 0)
+        return (-1);
+
+    // scatter record of this event written in Locate(), if any
+    if (BatchScatSizeEvent[ngrid] == 0)
+        BatchScatOffsetEvent[ngrid] = BatchScatBytes[ngrid];
+    size = strlen(fnout) + 4 * 24;
+    if ((buf = malloc(size)) == NULL)
+        return (-1);
+    size = sprintf(buf, "%s %ld %ld %ld %ld\n", fnout, hyp_offset, BatchHypBytes[ngrid] - hyp_offset,
+            BatchScatOffsetEvent[ngrid], BatchScatSizeEvent[ngrid]);
+    BatchScatSizeEvent[ngrid] = 0;
+
+    return (NllWriter_write(BatchWriter, pBatchFileIndex[ngrid], buf, size));
+
+}
+
+/** function to save location results to event and summary files */
+
 int SaveLocation(HypoDesc* hypo, int ngrid, char* fnobs, char *fnout, int numArrivalsReject,
         char* loctypename, int isave_phases, GaussLocParams * gauss_par) {
     int istat;
@@ -1084,7 +1316,14 @@ int SaveLocation(HypoDesc* hypo, int ngrid, char* fnobs, char *fnout, int numArr
     }
 #endif
 
-    if (iSaveNLLocEvent) {
+    if (iSaveNLLocEvent && iSaveNLLocBatch) {
+        /* append NLLoc hypocenter to batch hyp stream and index, no event files or last.* files */
+        sprintf(fname, "%s.loc.hyp", fnout);
+        if ((istat = SaveLocationBatch(hypo, ngrid, fname, fnout, numArrivalsReject, isave_phases)) < 0) {
+            nll_puterr("ERROR: writing location to batch output file.");
+            return (EXIT_ERROR_IO);
+        }
+    } else if (iSaveNLLocEvent) {
         /* write NLLoc hypocenter to event file */
         sprintf(frootname, "%s.loc", fnout);
         sprintf(fname, "%s.hyp", frootname);
@@ -1099,27 +1338,30 @@ int SaveLocation(HypoDesc* hypo, int ngrid, char* fnobs, char *fnout, int numArr
         sprintf(sys_command, "cp %s %slast.hyp", fname, f_outpath);
         system(sys_command);
          */
-        sprintf(targetfname, "%slast.hyp", f_outpath);
-        copy_file(fname, targetfname);
+        // 20261018 AJL - last.* copy, symbolic link or none (LOCHYPOUT LAST_COPY, LAST_SYMLINK, LAST_NONE)
+        SaveLastFile(fname, "last.hyp");
         /**/
         sprintf(fname, "%s.hdr", frootname);
         /* Modified Jan Wiszniowski 2022-02-02
         sprintf(sys_command, "cp %s %slast.hdr", fname, f_outpath);
         system(sys_command);
          */
-        sprintf(targetfname, "%slast.hdr", f_outpath);
-        copy_file(fname, targetfname);
+        SaveLastFile(fname, "last.hdr");
         /**/ sprintf(fname, "%s.scat", frootname);
-        if ((fp_tmp = fopen(fname, "rb")) != NULL) {
+        if (iSaveLast != SAVE_LAST_NONE && (fp_tmp = fopen(fname, "rb")) != NULL) {
             fclose(fp_tmp);
             /* Modified Jan Wiszniowski 2022-02-02
             sprintf(sys_command, "cp %s %slast.scat", fname, f_outpath);
             system(sys_command);
              */
-            sprintf(targetfname, "%slast.scat", f_outpath);
-            copy_file(fname, targetfname);
+            SaveLastFile(fname, "last.scat");
             /**/
         }
+        sprintf(fname, "%s.scatz", frootname);
+        if (iSaveLast != SAVE_LAST_NONE && (fp_tmp = fopen(fname, "rb")) != NULL) {
+            fclose(fp_tmp);
+            SaveLastFile(fname, "last.scatz");
+        }
     }
 
 
@@ -1175,7 +1417,16 @@ int SaveLocation(HypoDesc* hypo, int ngrid, char* fnobs, char *fnout, int numArr
 
     }
 
-    if (iSaveNLLocSum) {
+    if (iSaveNLLocSum && iSaveNLLocBatch) {
+        /* write NLLoc hypocenter to summary file through batch writer, summary header written in OpenSummaryFiles() */
+        char *buf;
+        size_t size;
+        if ((buf = WriteLocationToBuffer(hypo, Arrival, NumArrivals, fnout, 0, ngrid, &size)) == NULL
+                || NllWriter_write(BatchWriter, pSumFileHypNLLoc[ngrid], buf, size) < 0) {
+            nll_puterr("ERROR: writing location to summary file.");
+            return (EXIT_ERROR_IO);
+        }
+    } else if (iSaveNLLocSum) {
         /* write NLLoc hypocenter to summary file */
         if ((istat = WriteLocation(pSumFileHypNLLoc[ngrid],
                 hypo,
@@ -1198,6 +1449,27 @@ int SaveLocation(HypoDesc* hypo, int ngrid, char* fnobs, char *fnout, int numArr
         /**/
     }
 
+#ifdef NLL_HAVE_MEMSTREAM
+    if (iSaveNLLocSumCSV && iSaveNLLocBatch) {
+        /* write NLLoc hypocenter to CSV summary file through batch writer */
+        char *buf = NULL;
+        size_t size;
+        FILE *fp_memory_stream = open_memstream(&buf, &size);
+        istat = -1;
+        if (fp_memory_stream != NULL) {
+            istat = WriteLocationCSV(fp_memory_stream, hypo, fnout);
+            fclose(fp_memory_stream);
+            if (istat >= 0)
+                istat = NllWriter_write(BatchWriter, pSumFileHypNLLocCSV[ngrid], buf, size);
+            else
+                free(buf);
+        }
+        if (istat < 0) {
+            nll_puterr("ERROR: writing location CSV to summary file.");
+            return (EXIT_ERROR_IO);
+        }
+    } else
+#endif
     if (iSaveNLLocSumCSV) {
         /* write NLLoc hypocenter to CSV summary file */
         if ((istat = WriteLocationCSV(pSumFileHypNLLocCSV[ngrid], hypo, fnout)) < 0) {
@@ -1233,7 +1505,7 @@ int SaveLocation(HypoDesc* hypo, int ngrid, char* fnobs, char *fnout, int numArr
                 fnout, 0, 1, gauss_par->arrivalWeightMax);
         /* also write to last.hypo_inv */
         sprintf(fname, "%slast.hypo_inv", f_outpath);
-        if ((fp_tmp = fopen(fname, "w")) != NULL) {
+        if (iSaveLast != SAVE_LAST_NONE && (fp_tmp = fopen(fname, "w")) != NULL) {
             WriteHypoInverseArchive(fp_tmp, hypo, Arrival, NumArrivals,
                     fnout, 0, 1, gauss_par->arrivalWeightMax);
             fclose(fp_tmp);
@@ -1246,7 +1518,7 @@ int SaveLocation(HypoDesc* hypo, int ngrid, char* fnobs, char *fnout, int numArr
                 fnout, 1, 1, gauss_par->arrivalWeightMax);
         /* also write to last.arc */
         sprintf(fname, "%slast.arc", f_outpath);
-        if ((fp_tmp = fopen(fname, "w")) != NULL) {
+        if (iSaveLast != SAVE_LAST_NONE && (fp_tmp = fopen(fname, "w")) != NULL) {
             WriteHypoInverseArchive(fp_tmp, hypo, Arrival, NumArrivals,
                     fnout, 1, 1, gauss_par->arrivalWeightMax);
             fclose(fp_tmp);
@@ -1364,12 +1636,13 @@ int WriteHypoFmampSearchPosterior(SearchPdfGridDesc *searchPdfGrid, FILE *fpio,
         // set take-off angles at search posterior hypocenter
         // try to open time grid file using original phase ID
         EvaluateArrivalAlias(pfmarr);
-        sprintf(fileroot, "%s.%s.%s.angle", fn_loc_grids, pfmarr->phase, pfmarr->time_grid_label);
+        // 20261018 AJL - angles from time grid for ANGLE_MODE_TIME
+        sprintf(fileroot, angleMode == ANGLE_MODE_TIME ? "%s.%s.%s.time" : "%s.%s.%s.angle", fn_loc_grids, pfmarr->phase, pfmarr->time_grid_label);
         int iavailable;
         // need to get grid type from file on disk  TODO: this could be integrated into ReadTakeOffAnglesFile function
-        FILE *fp_grid, *fp_hdr;
-        GridDesc gdesc;
-        if (OpenGrid3dFile(fileroot, &fp_grid, &fp_hdr, &gdesc, "angle", NULL, iSwapBytesOnInput) < 0) {
+        // 20261018 AJL - grid type from cached grid file header
+        GridFileHandle *phandle;
+        if ((phandle = OpenCachedGrid3dFile(fileroot, angleMode == ANGLE_MODE_TIME ? "time" : "angle", iSwapBytesOnInput)) == NULL) {
             if (message_flag >= 3) {
                 sprintf(MsgStr, "WARNING: cannot open angle grid file, ignoring angles: %s", fileroot);
                 nll_putmsg(3, MsgStr);
@@ -1378,19 +1651,19 @@ int WriteHypoFmampSearchPosterior(SearchPdfGridDesc *searchPdfGrid, FILE *fpio,
             //GetTakeOffAngles(&angles, &(pfmarr->ray_azim), &(pfmarr->ray_dip), &(pfmarr->ray_qual));
             iavailable = -1;
         } else {
-            //printf("DEBUG: pfmarr->gdesc.type %d  GRID_ANGLE %d\n", gdesc.type, GRID_ANGLE);
-            int gdesc_type = gdesc.type;
-            CloseGrid3dFile(&gdesc, &fp_grid, &fp_hdr);
-            if (gdesc_type == GRID_ANGLE) {
+            //printf("DEBUG: pfmarr->gdesc.type %d  GRID_ANGLE %d\n", phandle->grid.type, GRID_ANGLE);
+            int gdesc_type = phandle->grid.type;
+            CloseCachedGrid3dFile(phandle);
+            if (gdesc_type == GRID_ANGLE || gdesc_type == GRID_TIME) {
                 // 3D grid
-                iavailable = ReadTakeOffAnglesFile(fileroot,
+                iavailable = ReadTakeOffAngles(fileroot,
                         phypo->x, phypo->y, phypo->z,
                         &(pfmarr->ray_azim),
                         &(pfmarr->ray_dip),
                         &(pfmarr->ray_qual), -1.0, iSwapBytesOnInput);
             } else {
                 // 2D grid (1D model)
-                iavailable = ReadTakeOffAnglesFile(fileroot,
+                iavailable = ReadTakeOffAngles(fileroot,
                         0.0,
                         GeometryMode == MODE_GLOBAL ? pfmarr->dist * KM2DEG : pfmarr->dist,
                         phypo->z,
@@ -1727,6 +2000,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
         strcpy(arrival[nobs].fileroot, "\0");
         arrival[nobs].n_companion = -1;
         arrival[nobs].n_time_grid = -1;
+        arrival[nobs].n_recip = -1;
         arrival[nobs].tfact = 1.0;
 
         /* if Vp/Vs > 0, check for companion phase, its time grid will be used for times */
@@ -1770,8 +2044,38 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
             }
         }
 
-        /* no previously initialized companion phase */
-        if (arrival[nobs].n_companion < 0) {
+        /* reciprocity, no previously initialized companion phase */
+        // 20261018 AJL - added, station times read from source-side (event centroid) time grids
+        if (arrival[nobs].n_companion < 0 && NumRecipCentroids > 0) {
+
+            if (SetupRecipArrival(arrival + nobs, arrival_phase) < 0) {
+                sprintf(MsgStr,
+                        "WARNING: cannot get reciprocity (LOCRECIP) travel times: rejecting observation: %s %s",
+                        arrival[nobs].label, arrival[nobs].phase);
+                nll_putmsg(2, MsgStr);
+                strcpy(arrival[nobs].fileroot, "\0");
+                goto RejectArrival;
+            }
+            i_need_elev_corr = 1;
+
+            if (IsDistStaGridOK(LocGrid + 0,
+                    &(arrival[nobs].station),
+                    DistStaGridMin, DistStaGridMax,
+                    LocGrid[0].origx + (LocGrid[0].dx
+                    * (double) (LocGrid[0].numx - 1)) / 2.0,
+                    LocGrid[0].origy + (LocGrid[0].dy
+                    * (double) (LocGrid[0].numy - 1)) / 2.0)
+                    == -2) {
+                sprintf(MsgStr,
+                        "WARNING: distance from grid center to station \n\texceeds maximum station distance, ignoring observation in misfit calculation: %s %s",
+                        arrival[nobs].label, arrival[nobs].phase);
+                nll_putmsg(2, MsgStr);
+                arrival[nobs].flag_ignore = 1;
+                goto IgnoreArrival;
+            }
+
+            /* no previously initialized companion phase */
+        } else if (arrival[nobs].n_companion < 0) {
 
             // try to open time grid file using original phase ID
             sprintf(arrival[nobs].fileroot, "%s.%s.%s", fn_grids,
@@ -2042,7 +2346,7 @@ int GetObservations(FILE* fp_obs, char* ftype_obs, char* fn_grids,
         /** arrival to be used for location */
 
         /* no further processing for arrivals with companion time grids */
-        if (arrival[nobs].n_companion >= 0 || arrival[nobs].n_time_grid >= 0)
+        if (arrival[nobs].n_companion >= 0 || arrival[nobs].n_time_grid >= 0 || arrival[nobs].n_recip >= 0)
             goto AcceptArrival;
 
         /** prepare time grids access in memory or on disk */
@@ -2225,6 +2529,7 @@ void InitializeArrivalFields(ArrivalDesc * arrival) {
     arrival->gdesc.buffer = NULL;
     arrival->gdesc.iSwapBytes = iSwapBytesOnInput;
     arrival->sheetdesc.buffer = NULL;
+    arrival->n_recip = -1;
 
     arrival->station_weight = 1.0;
 
@@ -2338,6 +2643,9 @@ double CalcSimpleElevCorr(ArrivalDesc *arrival, int narr, double pvel, double sv
         elev_corr = -arrival[narr].station.depth / pvel;
     } else if (svel > 0.0 && lastLegType(arrival + narr) == 'S') {
         elev_corr = -arrival[narr].station.depth / svel;
+        // reciprocity centroid grids, no station time grid
+    } else if (arrival[narr].n_recip >= 0) {
+        return (0.0);
         // else check grid type
     } else {
         if (arrival[narr].gdesc.type == GRID_TIME) {
@@ -2800,12 +3108,13 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
 
         // check for event public_id (assume listed before arrivals, e.g. in NLL Hypocenter-Phase file)
         // 20190823 AJL - added
-        if (sscanf(line, "PUBLIC_ID %s", phypo->public_id) == 1) {
+        // 20261018 AJL - keyword lines are checked by prefix before scanning, most lines are arrivals
+        if (line[0] == 'P' && strncmp(line, "PUBLIC_ID", 9) == 0 && sscanf(line, "PUBLIC_ID %s", phypo->public_id) == 1) {
             return (OBS_FILE_SKIP_INPUT_LINE);
         }
         // check for event QUALITY (assume listed before arrivals, e.g. in NLL Hypocenter-Phase file)
         // 20191019 AJL - added
-        if (sscanf(line,
+        if (line[0] == 'Q' && strncmp(line, "QUALITY", 7) == 0 && sscanf(line,
                 "QUALITY %*s %Lf %*s %lf %*s %lf %*s %lf %*s %d %*s %lf %*s %lf %*s %lf %d %*s %lf %d",
                 &phypo->probmax, &phypo->misfit,
                 &phypo->grid_misfit_max,
@@ -2820,7 +3129,7 @@ int GetNextObs(HypoDesc* phypo, FILE* fp_obs, ArrivalDesc *arrival, char* ftype_
         // 20200218 AJL - added
         /* FOCALMECH */
         /* Hyp dlat dlong depth Mech dipDir dipAng rake mf misfit nObs nObs */
-        if (sscanf(line,
+        if (line[0] == 'F' && strncmp(line, "FOCALMECH", 9) == 0 && sscanf(line,
                 "FOCALMECH %*s %lf %lf %lf %*s %lf %lf %lf %*s %lf %*s %d",
                 &phypo->focMech.dlat, &phypo->focMech.dlong,
                 &phypo->focMech.depth,
@@ -6851,25 +7160,24 @@ int reset_hypodatetime(long double phypo_time, HypoDesc *phypo) {
         int int_sec_offset = (int) hypo_sec + 1;
         double dec_sec_corr = (double) int_sec_offset - hypo_sec;
 
-        struct tm hypo_time;
-        hypo_time.tm_year = phypo->year - 1900;
-        hypo_time.tm_mon = phypo->month - 1;
-        hypo_time.tm_mday = phypo->day;
-        hypo_time.tm_hour = phypo->hour;
-        hypo_time.tm_min = phypo->min;
-        hypo_time.tm_sec = 0;
-
-        time_t time_seconds = mktime(&hypo_time);
-        time_seconds += 3600 - int_sec_offset;
-
-        struct tm *new_hypo_time = gmtime(&time_seconds);
-
-        phypo->year = new_hypo_time->tm_year + 1900;
-        phypo->month = new_hypo_time->tm_mon + 1;
-        phypo->day = new_hypo_time->tm_mday;
-        phypo->hour = new_hypo_time->tm_hour;
-        phypo->min = new_hypo_time->tm_min;
-        phypo->sec = (double) new_hypo_time->tm_sec + dec_sec_corr;
+        // 20261019 AJL - bug fix, date and time shifted by whole days without time zone,
+        //    replaces mktime()/localtime() which use local time and may be off by one hour near DST transitions
+        long tod_sec = (long) phypo->hour * 3600L + (long) phypo->min * 60L - (long) int_sec_offset;
+        long nday = tod_sec >= 0 ? tod_sec / 86400L : -((-tod_sec + 86399L) / 86400L);
+        tod_sec -= nday * 86400L;
+        int doy = DayOfYear(phypo->year, phypo->month, phypo->day) + (int) nday;
+        while (doy < 1) {
+            phypo->year--;
+            doy += DayOfYear(phypo->year, 12, 31);
+        }
+        while (doy > DayOfYear(phypo->year, 12, 31)) {
+            doy -= DayOfYear(phypo->year, 12, 31);
+            phypo->year++;
+        }
+        MonthDay(phypo->year, doy, &phypo->month, &phypo->day);
+        phypo->hour = (int) (tod_sec / 3600L);
+        phypo->min = (int) ((tod_sec % 3600L) / 60L);
+        phypo->sec = (double) (tod_sec % 60L) + dec_sec_corr;
 
         printf("DEBUG: reset_hypodatetime: phypo time out: %4.4d-%2.2d-%2.2dT%2.2d:%2.2d:%lf\n", phypo->year, phypo->month, phypo->day, phypo->hour, phypo->min, phypo->sec);
 
@@ -7022,194 +7330,546 @@ int FindDuplicateTimeGrid(ArrivalDesc *arrival, int num_arrivals, int ntest) {
 
 }
 
-/** function to perform grid search location */
-
-int LocGridSearch(int ngrid, int num_arr_total, int num_arr_loc,
-        ArrivalDesc *arrival,
-        GridDesc* ptgrid, GaussLocParams* gauss_par, HypoDesc * phypo) {
-
-    int istat;
-    int ix = -1, iy = -1, iz = -1, narr;
-    int iGridType;
-    int nReject, numGridReject = 0, numStaReject = 0;
-    double xval, yval, zval;
-    /*double travel_time;*/
-    double value;
-    double misfit;
-    double misfit_min = VERY_LARGE_DOUBLE, misfit_max = -VERY_LARGE_DOUBLE;
-    double dlike;
+/** y-z sheets of 3D time grid of arrival for grid search */
 
+// 20261018 AJL - sheets for next x are read while sheets for current x are evaluated
 
+#define NUM_ARRIVAL_SHEET_BUF 4
 
-    /* get solution quality at each grid point */
-
-    if (message_flag >= 4) {
-        nll_putmsg(4, "");
-        nll_putmsg(4, "Calculating solution over grid...");
-    }
+typedef struct {
+    int use_sheets; // 1 if travel times are read from sheets
+    GRID_FLOAT_TYPE *buf[NUM_ARRIVAL_SHEET_BUF]; // sheet buffers, buf[0] and buf[1] are in arrival sheetdesc buffer
+    int ixbuf[NUM_ARRIVAL_SHEET_BUF]; // grid x index of sheet in buffer, or -1
+    GRID_FLOAT_TYPE *sheet0, *sheet1; // buffers holding sheets needed at current x, NULL if x index out of range
+}
+ArrivalSheets;
 
-    iGridType = ptgrid->type;
+static int getTravelTimesSheets(ArrivalDesc *arrival, int num_arr_loc, double xval, double yval, double zval, ArrivalSheets *psheets);
 
-    xval = ptgrid->origx;
+#define GRID_SEARCH_BLOCK_VALUES 4194304 // maximum number of node values stored for one block of grid search rows
 
-    /* loop over grid points */
 
-    for (ix = 0; ix < ptgrid->numx; ix++) {
+/** function to allocate y-z sheet buffers for arrivals with 3D time grids on disk */
 
-        /* read y-z sheets for arrival travel-times (3D grids) */
-        if ((istat = ReadArrivalSheets(num_arr_loc, arrival, xval)) < 0)
-            nll_puterr("ERROR: reading arrival travel time sheets.");
+static ArrivalSheets *AllocateArrivalSheets(int num_arrivals, ArrivalDesc *arrival) {
 
-        yval = ptgrid->origy;
-        for (iy = 0; iy < ptgrid->numy; iy++) {
-            zval = ptgrid->origz;
-            for (iz = 0; iz < ptgrid->numz; iz++) {
+    int narr, nbuf;
+    long numyz;
+    ArrivalSheets *sheets;
 
+    if ((sheets = (ArrivalSheets *) calloc(num_arrivals, sizeof (ArrivalSheets))) == NULL) {
+        nll_puterr("ERROR: allocating arrival sheets, travel times will be read from disk.");
+        return (NULL);
+    }
 
-                // get travel times for observed arrivals
+    for (narr = 0; narr < num_arrivals; narr++) {
+        for (nbuf = 0; nbuf < NUM_ARRIVAL_SHEET_BUF; nbuf++)
+            sheets[narr].ixbuf[nbuf] = -1;
+        if (arrival[narr].n_companion >= 0 || arrival[narr].n_recip >= 0 || arrival[narr].n_time_grid >= 0
+                || arrival[narr].gdesc.type != GRID_TIME || arrival[narr].gdesc.buffer != NULL
+                || arrival[narr].fpgrid == NULL || arrival[narr].sheetdesc.buffer == NULL
+                || isCascadingGrid(&(arrival[narr].gdesc)))
+            continue;
+        numyz = (long) arrival[narr].gdesc.numy * (long) arrival[narr].gdesc.numz;
+        sheets[narr].buf[0] = (GRID_FLOAT_TYPE *) arrival[narr].sheetdesc.buffer;
+        sheets[narr].buf[1] = sheets[narr].buf[0] + numyz;
+        if ((sheets[narr].buf[2] = (GRID_FLOAT_TYPE *) malloc(2 * numyz * sizeof (GRID_FLOAT_TYPE))) == NULL) {
+            nll_puterr("ERROR: allocating arrival sheet buffer, travel times will be read from disk.");
+            continue;
+        }
+        sheets[narr].buf[3] = sheets[narr].buf[2] + numyz;
+        sheets[narr].use_sheets = 1;
+    }
 
-                if (isAboveTopo(xval, yval, zval)) {
+    return (sheets);
 
-                    misfit = -1.0;
-                    value = 0.0;
-                    if (iGridType == GRID_MISFIT)
-                        value = -1.0;
-                    else if (iGridType == GRID_PROB_DENSITY)
-                        value = -LARGE_FLOAT;
-                    ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix][iy][iz] = value;
+}
 
-                } else {
+/** function to free y-z sheet buffers */
 
-                    nReject = getTravelTimes(arrival, num_arr_loc, xval, yval, zval);
+static void FreeArrivalSheets(int num_arrivals, ArrivalSheets *sheets) {
 
-                    if (nReject) {
+    int narr;
 
-                        numGridReject++;
-                        numStaReject += nReject;
-                        misfit = -1.0;
-                        value = 0.0;
-                        if (iGridType == GRID_MISFIT)
-                            value = -1.0;
-                        else if (iGridType == GRID_PROB_DENSITY)
-                            value = -LARGE_FLOAT;
-                        ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix][iy][iz] = value;
+    if (sheets == NULL)
+        return;
+    for (narr = 0; narr < num_arrivals; narr++) {
+        if (sheets[narr].buf[2] != NULL)
+            free(sheets[narr].buf[2]);
+    }
+    free(sheets);
 
-                    } else {
+}
 
-                        /* calc misfit or prob density */
+/** function to get buffer holding y-z sheet ixsheet, reads sheet into a buffer not holding a sheet in ixkeep if needed
+ *
+ *  returns NULL if ixsheet out of range or sheet cannot be read
+ */
 
-                        double log_prior;
-                        value = CalcSolutionQuality(xval, yval, zval, NULL, num_arr_loc,
-                                arrival, gauss_par,
-                                iGridType, &misfit, NULL, NULL, 0.0, 0.0, 0.0, NULL, NULL, &log_prior);
-                        if (iGridType == GRID_MISFIT) {
-                            ptgrid->sum += value;
-                        } else if (iGridType == GRID_PROB_DENSITY) {
-                            value += log_prior; // 20190513 AJL
-                            dlike = exp(value);
-                            ptgrid->sum += dlike;
-                            /* update  probabilistic residuals */
-                            UpdateProbabilisticResiduals(num_arr_loc, arrival, dlike);
-                        }
-                        ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix][iy][iz] = value;
+static GRID_FLOAT_TYPE *GetArrivalSheet(ArrivalDesc *parrival, ArrivalSheets *psheets, int ixsheet, int *ixkeep, int nkeep) {
 
-                        /* check for minimum misfit */
-                        if (misfit < misfit_min) {
-                            misfit_min = misfit;
-                            phypo->misfit = misfit;
-                            phypo->ix = ix;
-                            phypo->iy = iy;
-                            phypo->iz = iz;
-                            phypo->x = xval;
-                            phypo->y = yval;
-                            phypo->z = zval;
-                            for (narr = 0; narr < num_arr_loc; narr++)
-                                arrival[narr].pred_travel_time_best =
-                                    arrival[narr].pred_travel_time;
-                        }
-                        if (misfit > misfit_max)
-                            misfit_max = misfit;
+    int nbuf, nfree = -1, nk, istat;
 
-                    }
-                }
+    if (ixsheet < 0 || ixsheet >= parrival->gdesc.numx)
+        return (NULL);
 
-                zval += ptgrid->dz;
+    for (nbuf = 0; nbuf < NUM_ARRIVAL_SHEET_BUF; nbuf++) {
+        if (psheets->ixbuf[nbuf] == ixsheet)
+            return (psheets->buf[nbuf]);
+        if (nfree < 0) {
+            for (nk = 0; nk < nkeep; nk++) {
+                if (psheets->ixbuf[nbuf] >= 0 && psheets->ixbuf[nbuf] == ixkeep[nk])
+                    break;
             }
-            yval += ptgrid->dy;
+            if (nk == nkeep)
+                nfree = nbuf;
         }
-        xval += ptgrid->dx;
     }
+    if (nfree < 0) // cannot happen with NUM_ARRIVAL_SHEET_BUF >= nkeep
+        return (NULL);
 
-
-    /* give warning if grid points rejected */
-
-    if (numGridReject > 0) {
-        sprintf(MsgStr, "WARNING: %d grid locations rejected; travel times for an average of %.2lf arrival observations were not valid.",
-                numGridReject, (double) numStaReject / numGridReject);
-        nll_putmsg(1, MsgStr);
+    /* read sheet from disk */
+#ifdef _OPENMP
+#pragma omp critical(nll_grid_search_read)
+#endif
+    istat = ReadGrid3dBufSheet(psheets->buf[nfree], &(parrival->gdesc), parrival->fpgrid, ixsheet);
+    if (istat < 0) {
+        nll_puterr("ERROR: reading arrival travel time sheet.");
+        psheets->ixbuf[nfree] = -1;
+        return (NULL);
     }
+    psheets->ixbuf[nfree] = ixsheet;
 
+    return (psheets->buf[nfree]);
 
-    /* construct search information string */
-    sprintf(phypo->searchInfo, "GRID nPts %d%c", ix * iy *iz, '\0');
-    /* write message */
-    /*nll_putmsg(2, phypo->searchInfo);*/
+}
 
+/** function to set y-z sheets needed for each arrival at x location xsheet, reads sheets not already in memory */
 
-    /* re-calculate solution and arrival statistics for best location */
+static void SetArrivalSheets(int num_arrivals, ArrivalDesc *arrival, ArrivalSheets *sheets, double xsheet) {
 
-    double cell_diagonal_time_var_best = 0.0; // TODO: add to Grid Search ?
-    double cell_diagonal_best = 0.0; // TODO: add to Grid Search ?
-    double cell_volume_best = 0.0; // TODO: add to Grid Search ?
-    SaveBestLocation(NULL, num_arr_total, num_arr_loc, arrival, ptgrid, gauss_par, phypo, misfit_max,
-            iGridType, 0, cell_diagonal_time_var_best, cell_diagonal_best, cell_volume_best);
+    int narr, ixkeep[2];
 
-    return (0);
+    for (narr = 0; narr < num_arrivals; narr++) {
+        if (!sheets[narr].use_sheets)
+            continue;
+        GetInterpGrid3dSheetIndex(&(arrival[narr].gdesc), xsheet, ixkeep, ixkeep + 1);
+        sheets[narr].sheet0 = GetArrivalSheet(arrival + narr, sheets + narr, ixkeep[0], ixkeep, 2);
+        sheets[narr].sheet1 = GetArrivalSheet(arrival + narr, sheets + narr, ixkeep[1], ixkeep, 2);
+    }
 
 }
 
+/** function to read ahead y-z sheets needed for each arrival at x location xnext, keeping sheets needed at x location xsheet */
 
+static void PrefetchArrivalSheets(int num_arrivals, ArrivalDesc *arrival, ArrivalSheets *sheets, double xsheet, double xnext) {
 
-/** function to perform Metropolis location */
+    int narr, ixkeep[4];
 
-#define MAX_NUM_MET_TRIES 1000
+    for (narr = 0; narr < num_arrivals; narr++) {
+        if (!sheets[narr].use_sheets)
+            continue;
+        GetInterpGrid3dSheetIndex(&(arrival[narr].gdesc), xsheet, ixkeep, ixkeep + 1);
+        GetInterpGrid3dSheetIndex(&(arrival[narr].gdesc), xnext, ixkeep + 2, ixkeep + 3);
+        GetArrivalSheet(arrival + narr, sheets + narr, ixkeep[2], ixkeep, 4);
+        GetArrivalSheet(arrival + narr, sheets + narr, ixkeep[3], ixkeep, 4);
+    }
 
-int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
+}
+
+/** function to perform grid search location */
+
+// 20261018 AJL - rows of each x slab of the grid are evaluated in parallel (OpenMP) with per-thread copies of arrivals,
+//    y-z sheets of 3D time grids for the next x are read on one thread while the current slab is evaluated,
+//    node values are then reduced and written to the location grid in grid order, so results do not depend on number of threads
+
+int LocGridSearch(int ngrid, int num_arr_total, int num_arr_loc,
         ArrivalDesc *arrival,
-        GridDesc* ptgrid, GaussLocParams* gauss_par, HypoDesc* phypo,
-        WalkParams* pMetrop, float* fdata) {
+        GridDesc* ptgrid, GaussLocParams* gauss_par, HypoDesc * phypo) {
 
-    int istat;
-    int ntry, nSamples, nSampStat, narr, ipos;
-    long int ngenerated;
-    int maxNumTries;
-    int writeMessage = 0;
+    int ix, iy, iz, narr, k;
     int iGridType;
-    int nReject, numClipped = 0, numGridReject = 0, numStaReject = 0;
-    int iAbort = 0, iReject = 0;
-    int iBoundary = 0;
-    int iAccept, numAcceptDeepMinima = 0;
+    int nReject, numGridReject = 0, numStaReject = 0;
     double xval, yval, zval;
-    double currentMetStepFact;
-
-    double value, dlike, dlike_max = -VERY_LARGE_DOUBLE;
-
+    double value;
     double misfit;
     double misfit_min = VERY_LARGE_DOUBLE, misfit_max = -VERY_LARGE_DOUBLE;
+    double dlike;
 
-    double xmin, xmax, ymin, ymax, zmin, zmax;
-    double dx_init, dx_test;
-
-    int nScatterSaved;
-
-    double xmean_sum = 0.0, ymean_sum = 0.0, zmean_sum = 0.0;
-    double xvar_sum = 0.0, yvar_sum = 0.0, zvar_sum = 0.0;
-    double xvar = 0.0, yvar = 0.0, zvar = 0.0;
-    double dsamp = 0.0, dsamp2;
+    int numx = ptgrid->numx, numy = ptgrid->numy, numz = ptgrid->numz;
+    int iy_start, iy_end, nrow_block, num_node_values;
+    int iy_best = -1, iz_best = -1;
+    int nthreads = 1, nthread;
+    double *xvals = NULL, *yvals = NULL, *zvals = NULL;
+    double *node_value = NULL, *node_misfit = NULL, *node_resid = NULL;
+    int *node_reject = NULL;
+    ArrivalDesc **thread_arrival = NULL;
+    GaussLocParams *thread_gauss_par = NULL;
+    ArrivalSheets *sheets = NULL;
+    int istat = -1;
 
 
 
-    /* get solution quality at each sample on random walk */
+    /* get solution quality at each grid point */
+
+    if (message_flag >= 4) {
+        nll_putmsg(4, "");
+        nll_putmsg(4, "Calculating solution over grid...");
+    }
+
+    iGridType = ptgrid->type;
+
+
+    /* grid node coordinates, accumulated as for serial loop over grid points */
+
+    xvals = (double *) malloc(numx * sizeof (double));
+    yvals = (double *) malloc(numy * sizeof (double));
+    zvals = (double *) malloc(numz * sizeof (double));
+    if (xvals == NULL || yvals == NULL || zvals == NULL) {
+        nll_puterr("ERROR: allocating grid search node coordinates.");
+        goto cleanup;
+    }
+    xval = ptgrid->origx;
+    for (ix = 0; ix < numx; ix++) {
+        xvals[ix] = xval;
+        xval += ptgrid->dx;
+    }
+    yval = ptgrid->origy;
+    for (iy = 0; iy < numy; iy++) {
+        yvals[iy] = yval;
+        yval += ptgrid->dy;
+    }
+    zval = ptgrid->origz;
+    for (iz = 0; iz < numz; iz++) {
+        zvals[iz] = zval;
+        zval += ptgrid->dz;
+    }
+
+
+    /* read 2D time grids, 3D time grids are read as y-z sheets during search */
+
+    for (narr = 0; narr < num_arr_loc; narr++) {
+        if (arrival[narr].gdesc.type == GRID_TIME_2D && ReadArrivalSheets(1, arrival + narr, 0.0) < 0)
+            nll_puterr("ERROR: reading arrival travel time sheets.");
+    }
+    sheets = AllocateArrivalSheets(num_arr_loc, arrival);
+
+
+    /* number of threads */
+
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+    // travel times or solution quality use shared state
+    if (LocMethod == METH_OT_STACK
+            || (iUseSearchPrior && SearchPrior.gridType == PDF_GRID_GRID && isCascadingGrid(&(SearchPrior.grid)))
+            || (iUseSearchPosterior && SearchPosterior.gridType == PDF_GRID_GRID && isCascadingGrid(&(SearchPosterior.grid))))
+        nthreads = 1;
+    for (narr = 0; narr < num_arr_loc; narr++) {
+        if (arrival[narr].gdesc.type == GRID_TIME && isCascadingGrid(&(arrival[narr].gdesc)))
+            nthreads = 1;
+    }
+#endif
+    thread_arrival = (ArrivalDesc **) calloc(nthreads, sizeof (ArrivalDesc *));
+    thread_gauss_par = (GaussLocParams *) calloc(nthreads, sizeof (GaussLocParams));
+    if (thread_arrival == NULL || thread_gauss_par == NULL) {
+        nll_puterr("ERROR: allocating grid search thread arrivals.");
+        goto cleanup;
+    }
+    thread_arrival[0] = arrival;
+    thread_gauss_par[0] = *gauss_par;
+    for (nthread = 1; nthread < nthreads; nthread++) {
+        if ((thread_arrival[nthread] = (ArrivalDesc *) malloc(num_arr_loc * sizeof (ArrivalDesc))) == NULL) {
+            nthreads = nthread;
+            break;
+        }
+        memcpy(thread_arrival[nthread], arrival, num_arr_loc * sizeof (ArrivalDesc));
+        thread_gauss_par[nthread] = *gauss_par;
+        // EDT matrix diagonal is set for each node with LOCGAU2
+        if (iUseGauss2 && gauss_par->EDTMtrx != NULL) {
+            if ((thread_gauss_par[nthread].EDTMtrx = matrix_double(num_arr_loc, num_arr_loc)) == NULL) {
+                free(thread_arrival[nthread]);
+                thread_arrival[nthread] = NULL;
+                nthreads = nthread;
+                break;
+            }
+            for (narr = 0; narr < num_arr_loc; narr++)
+                memcpy(thread_gauss_par[nthread].EDTMtrx[narr], gauss_par->EDTMtrx[narr], num_arr_loc * sizeof (double));
+        }
+    }
+
+
+    /* node values for block of rows */
+
+    num_node_values = 2 + (iGridType == GRID_PROB_DENSITY ? num_arr_loc : 0);
+    nrow_block = GRID_SEARCH_BLOCK_VALUES / (numz * num_node_values);
+    if (nrow_block < 1)
+        nrow_block = 1;
+    if (nrow_block > numy)
+        nrow_block = numy;
+    node_reject = (int *) malloc(nrow_block * numz * sizeof (int));
+    node_value = (double *) malloc(nrow_block * numz * sizeof (double));
+    node_misfit = (double *) malloc(nrow_block * numz * sizeof (double));
+    if (iGridType == GRID_PROB_DENSITY)
+        node_resid = (double *) malloc((long) nrow_block * numz * num_arr_loc * sizeof (double));
+    if (node_reject == NULL || node_value == NULL || node_misfit == NULL
+            || (iGridType == GRID_PROB_DENSITY && node_resid == NULL)) {
+        nll_puterr("ERROR: allocating grid search node values.");
+        goto cleanup;
+    }
+
+
+    /* loop over grid points */
+
+    for (ix = 0; ix < numx; ix++) {
+
+        /* y-z sheets for arrival travel-times (3D grids) */
+        if (sheets != NULL)
+            SetArrivalSheets(num_arr_loc, arrival, sheets, xvals[ix]);
+
+        for (iy_start = 0; iy_start < numy; iy_start += nrow_block) {
+
+            iy_end = iy_start + nrow_block < numy ? iy_start + nrow_block : numy;
+            int iprefetch = sheets != NULL && iy_start == 0 && ix + 1 < numx;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1)
+#endif
+            {
+                int iyt, izt, kt, nrej, narrt;
+                double value_node, misfit_node, log_prior;
+                int ithread = 0;
+#ifdef _OPENMP
+                ithread = omp_get_thread_num();
+#endif
+                ArrivalDesc *parrival = thread_arrival[ithread];
+                GaussLocParams *pgauss_par = ithread > 0 ? thread_gauss_par + ithread : gauss_par;
+
+                /* read ahead sheets for next x slab */
+                if (iprefetch) {
+#ifdef _OPENMP
+#pragma omp single nowait
+#endif
+                    PrefetchArrivalSheets(num_arr_loc, arrival, sheets, xvals[ix], xvals[ix + 1]);
+                }
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+                for (iyt = iy_start; iyt < iy_end; iyt++) {
+                    for (izt = 0; izt < numz; izt++) {
+
+                        kt = (iyt - iy_start) * numz + izt;
+                        misfit_node = -1.0;
+
+                        // get travel times for observed arrivals
+
+                        if (isAboveTopo(xvals[ix], yvals[iyt], zvals[izt])) {
+
+                            nrej = -1;
+
+                        } else {
+
+                            NLL_PROF_START(t_prof_tt);
+                            nrej = getTravelTimesSheets(parrival, num_arr_loc, xvals[ix], yvals[iyt], zvals[izt], sheets);
+                            NLL_PROF_STOP(PROF_T_TRAVEL_TIME, t_prof_tt);
+                            NLL_PROF_COUNT(PROF_C_SEARCH_NODES, 1);
+
+                        }
+
+                        if (nrej) {
+
+                            value_node = 0.0;
+                            if (iGridType == GRID_MISFIT)
+                                value_node = -1.0;
+                            else if (iGridType == GRID_PROB_DENSITY)
+                                value_node = -LARGE_FLOAT;
+
+                        } else {
+
+                            /* calc misfit or prob density */
+
+                            NLL_PROF_START(t_prof_like);
+                            value_node = CalcSolutionQuality(xvals[ix], yvals[iyt], zvals[izt], NULL, num_arr_loc,
+                                    parrival, pgauss_par,
+                                    iGridType, &misfit_node, NULL, NULL, 0.0, 0.0, 0.0, NULL, NULL, &log_prior);
+                            NLL_PROF_STOP(PROF_T_LIKELIHOOD, t_prof_like);
+                            if (iGridType == GRID_PROB_DENSITY) {
+                                value_node += log_prior; // 20190513 AJL
+                                for (narrt = 0; narrt < num_arr_loc; narrt++)
+                                    node_resid[(long) kt * num_arr_loc + narrt] = parrival[narrt].cent_resid;
+                            }
+
+                        }
+
+                        node_reject[kt] = nrej;
+                        node_value[kt] = value_node;
+                        node_misfit[kt] = misfit_node;
+
+                    }
+                }
+
+                // EDT_OT_WT work arrays of other threads
+                if (ithread > 0)
+                    free_ot_ml_arrays();
+
+            }
+
+
+            /* reduce node values in grid order and write to location grid */
+
+            int ibest = 0;
+            for (iy = iy_start; iy < iy_end; iy++) {
+                for (iz = 0; iz < numz; iz++) {
+
+                    k = (iy - iy_start) * numz + iz;
+                    nReject = node_reject[k];
+                    value = node_value[k];
+
+                    if (nReject > 0) {
+                        numGridReject++;
+                        numStaReject += nReject;
+                    } else if (nReject == 0) {
+                        misfit = node_misfit[k];
+                        if (iGridType == GRID_MISFIT) {
+                            ptgrid->sum += value;
+                        } else if (iGridType == GRID_PROB_DENSITY) {
+                            dlike = exp(value);
+                            ptgrid->sum += dlike;
+                            /* update  probabilistic residuals, as UpdateProbabilisticResiduals() */
+                            for (narr = 0; narr < num_arr_loc; narr++) {
+                                arrival[narr].pdf_residual_sum += dlike * node_resid[(long) k * num_arr_loc + narr];
+                                arrival[narr].pdf_weight_sum += dlike;
+                            }
+                        }
+
+                        /* check for minimum misfit */
+                        if (misfit < misfit_min) {
+                            misfit_min = misfit;
+                            phypo->misfit = misfit;
+                            phypo->ix = ix;
+                            phypo->iy = iy;
+                            phypo->iz = iz;
+                            phypo->x = xvals[ix];
+                            phypo->y = yvals[iy];
+                            phypo->z = zvals[iz];
+                            iy_best = iy;
+                            iz_best = iz;
+                            ibest = 1;
+                        }
+                        if (misfit > misfit_max)
+                            misfit_max = misfit;
+                    }
+
+                    ((GRID_FLOAT_TYPE ***) ptgrid->array)[ix][iy][iz] = value;
+
+                }
+            }
+
+            /* travel times at new minimum misfit node, sheets for this x still in memory */
+            if (ibest) {
+                getTravelTimesSheets(arrival, num_arr_loc, xvals[ix], yvals[iy_best], zvals[iz_best], sheets);
+                for (narr = 0; narr < num_arr_loc; narr++)
+                    arrival[narr].pred_travel_time_best = arrival[narr].pred_travel_time;
+            }
+
+        }
+
+    }
+
+
+    /* give warning if grid points rejected */
+
+    if (numGridReject > 0) {
+        sprintf(MsgStr, "WARNING: %d grid locations rejected; travel times for an average of %.2lf arrival observations were not valid.",
+                numGridReject, (double) numStaReject / numGridReject);
+        nll_putmsg(1, MsgStr);
+    }
+
+
+    /* construct search information string */
+    sprintf(phypo->searchInfo, "GRID nPts %d%c", numx * numy * numz, '\0');
+    /* write message */
+    /*nll_putmsg(2, phypo->searchInfo);*/
+
+
+    /* re-calculate solution and arrival statistics for best location */
+
+    double cell_diagonal_time_var_best = 0.0; // TODO: add to Grid Search ?
+    double cell_diagonal_best = 0.0; // TODO: add to Grid Search ?
+    double cell_volume_best = 0.0; // TODO: add to Grid Search ?
+    SaveBestLocation(NULL, num_arr_total, num_arr_loc, arrival, ptgrid, gauss_par, phypo, misfit_max,
+            iGridType, 0, cell_diagonal_time_var_best, cell_diagonal_best, cell_volume_best);
+
+    istat = 0;
+
+cleanup:
+    FreeArrivalSheets(num_arr_loc, sheets);
+    if (thread_arrival != NULL) {
+        for (nthread = 1; nthread < nthreads; nthread++)
+            free(thread_arrival[nthread]);
+        free(thread_arrival);
+    }
+    if (thread_gauss_par != NULL) {
+        for (nthread = 1; nthread < nthreads; nthread++) {
+            if (thread_gauss_par[nthread].EDTMtrx != gauss_par->EDTMtrx)
+                free_matrix_double(thread_gauss_par[nthread].EDTMtrx, num_arr_loc, num_arr_loc);
+        }
+        free(thread_gauss_par);
+    }
+    free(node_reject);
+    free(node_value);
+    free(node_misfit);
+    free(node_resid);
+    free(xvals);
+    free(yvals);
+    free(zvals);
+
+    return (istat);
+
+}
+
+
+
+/** function to perform Metropolis location */
+
+#define MAX_NUM_MET_TRIES 1000
+
+int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
+        ArrivalDesc *arrival,
+        GridDesc* ptgrid, GaussLocParams* gauss_par, HypoDesc* phypo,
+        WalkParams* pMetrop, float* fdata) {
+
+    int istat;
+    int ntry, nSamples, nSampStat, narr, ipos;
+    long int ngenerated;
+    int maxNumTries;
+    int writeMessage = 0;
+    int iGridType;
+    int nReject, numClipped = 0, numGridReject = 0, numStaReject = 0;
+    int iAbort = 0, iReject = 0;
+    int iBoundary = 0;
+    int iAccept, numAcceptDeepMinima = 0;
+    double xval, yval, zval;
+    double currentMetStepFact;
+
+    double value, dlike, dlike_max = -VERY_LARGE_DOUBLE;
+
+    double misfit;
+    double misfit_min = VERY_LARGE_DOUBLE, misfit_max = -VERY_LARGE_DOUBLE;
+
+    double xmin, xmax, ymin, ymax, zmin, zmax;
+    double dx_init, dx_test;
+
+    int nScatterSaved;
+
+    double xmean_sum = 0.0, ymean_sum = 0.0, zmean_sum = 0.0;
+    double xvar_sum = 0.0, yvar_sum = 0.0, zvar_sum = 0.0;
+    double xvar = 0.0, yvar = 0.0, zvar = 0.0;
+    double dsamp = 0.0, dsamp2;
+
+
+
+    /* get solution quality at each sample on random walk */
 
     if (message_flag >= 4) {
         nll_putmsg(4, "");
@@ -7260,7 +7920,10 @@ int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
 
         } else {
 
+            NLL_PROF_START(t_prof_tt);
             nReject = getTravelTimes(arrival, num_arr_loc, xval, yval, zval);
+            NLL_PROF_STOP(PROF_T_TRAVEL_TIME, t_prof_tt);
+            NLL_PROF_COUNT(PROF_C_SEARCH_NODES, 1);
 
             if (nReject) {
                 numGridReject++;
@@ -7271,8 +7934,10 @@ int LocMetropolis(int ngrid, int num_arr_total, int num_arr_loc,
 
                 /* calc misfit or prob density */
                 double log_prior;
+                NLL_PROF_START(t_prof_like);
                 value = CalcSolutionQuality(xval, yval, zval, NULL, num_arr_loc, arrival, gauss_par,
                         iGridType, &misfit, NULL, NULL, 0.0, 0.0, 0.0, NULL, NULL, &log_prior);
+                NLL_PROF_STOP(PROF_T_LIKELIHOOD, t_prof_like);
                 value += log_prior; // 20190513 AJL
                 dlike = gauss_par->WtMtrxSum * exp(value);
 
@@ -7591,10 +8256,10 @@ int SaveBestLocation(OctNode* poct_node, int num_arr_total, int num_arr_loc, Arr
         double misfit_max, int iGridType, int ignore_pred_travel_time_best,
         double cell_diagonal_time_var_best, double cell_diagonal_best, double cell_volume_best) {
 
-    int istat, narr, n_compan;
+    int narr, n_compan;
     char filename[2 * FILENAME_MAX];
 
-    SourceDesc station;
+    GridFileHandle *phandle;
 
     //printf("SaveBestLocation num_arr_total %d num_arr_loc %d\n", num_arr_total, num_arr_loc);
 
@@ -7668,10 +8333,16 @@ int SaveBestLocation(OctNode* poct_node, int num_arr_total, int num_arr_loc, Arr
             arrival[narr].pred_travel_time =
                     arrival[n_compan].pred_travel_time_best;
             arrival[narr].pred_travel_time *= arrival[narr].tfact;
+            /* reciprocity centroid grids */
+        } else if (arrival[narr].n_recip >= 0) {
+            if ((arrival[narr].pred_travel_time = RecipTravelTime(arrival + narr, phypo->x, phypo->y, phypo->z)) < 0.0)
+                arrival[narr].pred_travel_time = 0.0;
+            arrival[narr].pred_travel_time *= arrival[narr].tfact;
+            if (ApplyElevCorrFlag && arrival[narr].pred_travel_time > 0.0)
+                arrival[narr].pred_travel_time += arrival[narr].elev_corr;
         } else {
-            // temporarily open time grid file and read time for ignored arrivals
-            // save station information (will be overwritten in OpenGrid3dFile()
-            station = arrival[narr].station;
+            // read time for ignored arrivals from cached time grid file
+            // 20261018 AJL - use cached grid file handle, header read and file opened once per grid file
             sprintf(filename, "%s.time", arrival[narr].fileroot);
             // 20250215 AJL - Bug fix, check if need to open companion time grid file
             if (n_compan >= 0)
@@ -7679,36 +8350,38 @@ int SaveBestLocation(OctNode* poct_node, int num_arr_total, int num_arr_loc, Arr
             else
                 snprintf(filename, sizeof (filename), "%s.time", arrival[narr].fileroot);
 
-            if ((istat = OpenGrid3dFile(filename,
-                    &(arrival[narr].fpgrid),
-                    &(arrival[narr].fphdr),
-                    &(arrival[narr].gdesc), "time",
-                    &(arrival[narr].station),
-                    iSwapBytesOnInput)) < 0)
+            if ((phandle = OpenCachedGrid3dFile(filename, "time", iSwapBytesOnInput)) == NULL)
                 continue;
-            arrival[narr].station = station;
-            //iopened = 1;
+            LockCachedGrid3dFile(phandle);
+            arrival[narr].gdesc = phandle->grid;
             /* check grid type, read travel time */
             if (arrival[narr].gdesc.type == GRID_TIME) {
                 /* 3D grid */
-                if (arrival[narr].fpgrid != NULL)
+                if (phandle->fp_grid != NULL)
                     arrival[narr].pred_travel_time = (double) ReadAbsInterpGrid3d(
-                        arrival[narr].fpgrid, &(arrival[narr].gdesc),
+                        phandle->fp_grid, &(arrival[narr].gdesc),
                         phypo->x, phypo->y, phypo->z, 1);
                 if (arrival[narr].pred_travel_time < -LARGE_DOUBLE)
                     arrival[narr].pred_travel_time = 0.0;
             } else {
                 /* 2D grid (1D model) */
                 // AJL 20060602 dist stored as km, KM2DEG added
-                if (arrival[narr].fpgrid != NULL)
+                if (phandle->fp_grid != NULL)
                     arrival[narr].pred_travel_time =
                         ReadAbsInterpGrid2d(
-                        arrival[narr].fpgrid, &(arrival[narr].gdesc),
+                        phandle->fp_grid, &(arrival[narr].gdesc),
                         GeometryMode == MODE_GLOBAL ? arrival[narr].dist * KM2DEG : arrival[narr].dist,
                         phypo->z);
                 if (arrival[narr].pred_travel_time < -LARGE_DOUBLE)
                     arrival[narr].pred_travel_time = 0.0;
             }
+            UnlockCachedGrid3dFile(phandle);
+            // grid memory belongs to cached grid file handle
+            arrival[narr].gdesc.array = NULL;
+            arrival[narr].gdesc.gridDesc_Cascading.zindex = NULL;
+            arrival[narr].gdesc.gridDesc_Cascading.xyz_scale = NULL;
+            arrival[narr].gdesc.gridDesc_Cascading.zlevel = NULL;
+            CloseCachedGrid3dFile(phandle);
             arrival[narr].pred_travel_time *= arrival[narr].tfact;
             // apply crustal correction
             if (ApplyCrustElevCorrFlag && GeometryMode == MODE_GLOBAL
@@ -7720,20 +8393,20 @@ int SaveBestLocation(OctNode* poct_node, int num_arr_total, int num_arr_loc, Arr
                 if (arrival[narr].pred_travel_time > 0.0) // ignore arrivals with no pred tt
                     arrival[narr].pred_travel_time += arrival[narr].elev_corr;
             }
-            CloseGrid3dFile(&(arrival[narr].gdesc), &(arrival[narr].fpgrid), &(arrival[narr].fphdr));
 
         }
 
         /* read angles */
-        /* angle grid file name */
+        /* angle grid file name, or time grid file name for angles from time grid gradient */
+        // 20261018 AJL - added ANGLE_MODE_TIME
         if (n_compan >= 0)
-            snprintf(filename, sizeof (filename), "%s.angle", arrival[n_compan].fileroot);
+            snprintf(filename, sizeof (filename), angleMode == ANGLE_MODE_TIME ? "%s.time" : "%s.angle", arrival[n_compan].fileroot);
         else
-            snprintf(filename, sizeof (filename), "%s.angle", arrival[narr].fileroot);
-        if (angleMode == ANGLE_MODE_YES) {
+            snprintf(filename, sizeof (filename), angleMode == ANGLE_MODE_TIME ? "%s.time" : "%s.angle", arrival[narr].fileroot);
+        if (angleMode == ANGLE_MODE_YES || angleMode == ANGLE_MODE_TIME) {
             if (arrival[narr].gdesc.type == GRID_TIME) {
                 /* 3D grid */
-                ReadTakeOffAnglesFile(filename,
+                ReadTakeOffAngles(filename,
                         phypo->x, phypo->y, phypo->z,
                         &(arrival[narr].ray_azim),
                         &(arrival[narr].ray_dip),
@@ -7741,7 +8414,7 @@ int SaveBestLocation(OctNode* poct_node, int num_arr_total, int num_arr_loc, Arr
             } else {
                 /* 2D grid (1D model) */
                 // AJL 20060828 dist stored as km, KM2DEG added
-                ReadTakeOffAnglesFile(filename,
+                ReadTakeOffAngles(filename,
                         0.0,
                         GeometryMode == MODE_GLOBAL ? arrival[narr].dist * KM2DEG : arrival[narr].dist,
                         phypo->z,
@@ -7789,7 +8462,7 @@ int SaveBestLocation(OctNode* poct_node, int num_arr_total, int num_arr_loc, Arr
 
     /* set misc hypo fields */
     phypo->grid_misfit_max = misfit_max;
-    istat = rect2latlon(0, phypo->x, phypo->y, &(phypo->dlat), &(phypo->dlong));
+    rect2latlon(0, phypo->x, phypo->y, &(phypo->dlat), &(phypo->dlong));
     phypo->depth = phypo->z;
     phypo->nreadings = num_arr_loc;
 
@@ -7810,8 +8483,8 @@ int ReadArrivalSheets(int num_arrivals, ArrivalDesc *arrival, double xsheet) {
 
     for (narr = 0; narr < num_arrivals; narr++) {
 
-        /* skip sheet read if arrival has companion */
-        if (arrival[narr].n_companion >= 0)
+        /* skip sheet read if arrival has companion or uses reciprocity centroid grids */
+        if (arrival[narr].n_companion >= 0 || arrival[narr].n_recip >= 0)
             continue;
 
         /* skip sheet read or set xsheet to zero for 2D grid */
@@ -8804,11 +9477,8 @@ double CalcSolutionQuality_EDT(int num_arrivals, ArrivalDesc *arrival,
         }
         ot_var_weight = -ot_ml_var / (ot_error_2 / (long double) num_otime_error);
         if (ot_var_weight > EDT_OT_WT_FLOOR) {
-            if (!EDT_otime_weight_active) {
-                EDT_otime_weight_active = 1;
-                sprintf(MsgStr, "INFO: EDT_otime_weight activated, OT_WT exceeds EDT_OT_WT_FLOOR.");
-                nll_putmsg(2, MsgStr);
-            }
+            if (!EDT_otime_weight_active)
+                set_edt_otime_weight_active("INFO: EDT_otime_weight activated, OT_WT exceeds EDT_OT_WT_FLOOR.");
         } else {
             ot_var_weight = EDT_OT_WT_FLOOR;
         }
@@ -8821,11 +9491,8 @@ double CalcSolutionQuality_EDT(int num_arrivals, ArrivalDesc *arrival,
         }
         ot_var_weight = -ot_var / (ot_error_2 / (long double) num_otime_error);
         if (ot_var_weight > EDT_OT_WT_FLOOR) {
-            if (!EDT_otime_weight_active) {
-                EDT_otime_weight_active = 1;
-                sprintf(MsgStr, "INFO: EDT_otime_weight activated, OT_WT exceeds EDT_OT_WT_FLOOR.");
-                nll_putmsg(2, MsgStr);
-            }
+            if (!EDT_otime_weight_active)
+                set_edt_otime_weight_active("INFO: EDT_otime_weight activated, OT_WT exceeds EDT_OT_WT_FLOOR.");
         } else {
             ot_var_weight = EDT_OT_WT_FLOOR;
         }
@@ -9441,11 +10108,8 @@ double CalcSolutionQuality_ML_OT(int num_arrivals, ArrivalDesc *arrival,
         ot_var_weight = -ot_ml_var / (ot_error_2 / (long double) num_otime_error);
         ot_var_weight = log(ot_prob_max);
         if (1 || ot_var_weight > ML_OT_WT_FLOOR) {
-            if (!EDT_otime_weight_active) {
-                EDT_otime_weight_active = 1;
-                sprintf(MsgStr, "EDT_otime_weight activated, OT_WT exceeds ML_OT_WT_FLOOR.");
-                nll_putmsg(2, MsgStr);
-            }
+            if (!EDT_otime_weight_active)
+                set_edt_otime_weight_active("EDT_otime_weight activated, OT_WT exceeds ML_OT_WT_FLOOR.");
         } else {
             ot_var_weight = ML_OT_WT_FLOOR;
         }
@@ -9458,11 +10122,8 @@ double CalcSolutionQuality_ML_OT(int num_arrivals, ArrivalDesc *arrival,
         }
         ot_var_weight = -ot_var / (ot_error_2 / (long double) num_otime_error);
         if (1 || ot_var_weight > ML_OT_WT_FLOOR) {
-            if (!EDT_otime_weight_active) {
-                EDT_otime_weight_active = 1;
-                sprintf(MsgStr, "EDT_otime_weight activated, OT_WT exceeds ML_OT_WT_FLOOR.");
-                nll_putmsg(2, MsgStr);
-            }
+            if (!EDT_otime_weight_active)
+                set_edt_otime_weight_active("EDT_otime_weight activated, OT_WT exceeds ML_OT_WT_FLOOR.");
         } else {
             ot_var_weight = ML_OT_WT_FLOOR;
         }
@@ -9532,36 +10193,164 @@ double CalcSolutionQuality_ML_OT(int num_arrivals, ArrivalDesc *arrival,
 
 }
 
-/** function to calculate origin time based on grid search for maximum likelihood peak of a set of ot estimates */
+/** function to compare ot estimates by time for qsort */
+
+static int compare_ot_ml_estimate(const void *pval1, const void *pval2) {
+
+    double ot1 = ((const OtMLEstimate *) pval1)->ot;
+    double ot2 = ((const OtMLEstimate *) pval2)->ot;
+
+    if (ot1 < ot2)
+        return (-1);
+    if (ot1 > ot2)
+        return (1);
+    return (((const OtMLEstimate *) pval1)->narr - ((const OtMLEstimate *) pval2)->narr);
+
+}
+
+/** function to find first of sorted ot estimates with ot >= time */
+
+static int lower_bound_ot_ml(OtMLEstimate *pest, int nest, double time) {
+
+    int nlow = 0, nhigh = nest, nmid;
+
+    while (nlow < nhigh) {
+        nmid = (nlow + nhigh) / 2;
+        if (pest[nmid].ot < time)
+            nlow = nmid + 1;
+        else
+            nhigh = nmid;
+    }
+
+    return (nlow);
+
+}
+
+/** function to calculate origin time likelihood and its first and second time derivatives at given time
+ *
+ *  sums over sorted ot estimates in [nstart, nend), terms are same as in calc_likelihood_ot()
+ */
+
+static double calc_likelihood_ot_window(OtMLEstimate *pest, int nstart, int nend, double time, double *pderiv1, double *pderiv2) {
+
+    int nest;
+    double prob, prob_arr1, temp, deriv1, deriv2;
+
+    prob = deriv1 = deriv2 = 0.0;
+    for (nest = nstart; nest < nend; nest++) {
+        temp = pest[nest].ot - time;
+        if (temp > -1.0e8 && temp < 1.0e8) {
+            prob_arr1 = exp(-0.5 * temp * temp / pest[nest].sigma2) / pest[nest].sqrt_sigma2;
+            prob_arr1 *= pest[nest].edt_weight;
+            prob_arr1 *= pest[nest].apriori_weight;
+            prob += prob_arr1;
+            if (pderiv1 != NULL) {
+                deriv1 += prob_arr1 * temp / pest[nest].sigma2;
+                deriv2 += prob_arr1 * (temp * temp / pest[nest].sigma2 - 1.0) / pest[nest].sigma2;
+            }
+        }
+    }
+
+    if (pderiv1 != NULL) {
+        *pderiv1 = deriv1;
+        *pderiv2 = deriv2;
+    }
+
+    return (prob);
+
+}
+
+/** function to calculate origin time likelihood at given time using only ot estimates with non-zero kernel values */
+
+static double calc_likelihood_ot_sorted(OtMLEstimate *pest, int nest, double window, double time, double *pderiv1, double *pderiv2) {
+
+    int nstart, nend;
+
+    nstart = lower_bound_ot_ml(pest, nest, time - window);
+    nend = nstart;
+    while (nend < nest && pest[nend].ot <= time + window)
+        nend++;
+
+    return (calc_likelihood_ot_window(pest, nstart, nend, time, pderiv1, pderiv2));
+
+}
+
+/** function to calculate origin time based on search for maximum likelihood peak of a set of ot estimates
+ *
+ *  20261018 AJL - ot estimates sorted by time, Gaussian kernel sums restricted to sliding window of estimates
+ *      with non-zero kernel values, peak refined by bracketed Newton iteration on derivative of likelihood
+ *      instead of search in steps of rms / 100.  Previously O(N^2) likelihood evaluations.
+ */
 
 double calc_maximum_likelihood_ot(double *pot_ml_arrival, double *pot_ml_arrival_edt_sum,
         int num_arrivals, ArrivalDesc *arrival, MatrixDouble edtmtx, double *pot_ml_var, int iwrite_errors,
         double *pprob_max) {
 
-    int narr;
+    int narr, nest, num_est, nstart, nend, niter;
     double arr_prob_max, prob;
     double ot_arr, ot_arr_prob_max = 0.0;
     double range, step, time, tlimit, prob_max, ot_max_like;
     double edt_matrix_rms_error, edt_matrix_diagonal_sum;
+    double sigma2_max, window, deriv1, deriv2, direction, tlow, thigh, tnext, tolerance;
+    OtMLEstimate *pest;
+
+
+    // check size of sorted ot estimate array
+    if (isize_ot_ml_sorted < num_arrivals) {
+        free(ot_ml_sorted);
+        isize_ot_ml_sorted = num_arrivals;
+        if ((ot_ml_sorted = (OtMLEstimate *) malloc((size_t) isize_ot_ml_sorted * sizeof (OtMLEstimate))) == NULL) {
+            nll_puterr("ERROR: allocating OtMLEstimate storage array for EDT_OT_WT_ML ot_ml_sorted.");
+            isize_ot_ml_sorted = 0;
+            *pprob_max = -1.0;
+            *pot_ml_var = 0.0;
+            return (0.0);
+        }
+    }
 
-
-    // coarse search: find ot estimate with largest likelihood over set of ot's for each arrival
-    arr_prob_max = -1.0;
+    // collect ot estimates of non-ignored arrivals
+    pest = ot_ml_sorted;
+    num_est = 0;
+    sigma2_max = 0.0;
     edt_matrix_diagonal_sum = 0.0;
     for (narr = 0; narr < num_arrivals; narr++) {
         if (pot_ml_arrival_edt_sum[narr] < 0.0) // skip ignored arrivals
             continue;
-        ot_arr = pot_ml_arrival[narr];
-        prob = calc_likelihood_ot(ot_ml_arrival, pot_ml_arrival_edt_sum, num_arrivals, arrival, edtmtx, ot_arr);
-        //printf("DEBUG: calc_likelihood_ot arr: narr %d, ot_ml_arrival %f, prob %f, edtmtx[narr][narr] %f ", narr, ot_arr, prob, edtmtx[narr][narr]);
+        pest[num_est].ot = pot_ml_arrival[narr];
+        pest[num_est].sigma2 = edtmtx[narr][narr];
+        pest[num_est].sqrt_sigma2 = sqrt(edtmtx[narr][narr]);
+        // weight by edt_prob for arrival
+        pest[num_est].edt_weight = num_arrivals > 1 ? pot_ml_arrival_edt_sum[narr] : 1.0;
+        // 20130627 AJL - add prior weighting
+        pest[num_est].apriori_weight = (iUseArrivalPriorWeights && arrival[narr].apriori_weight >= -VERY_SMALL_DOUBLE)
+                ? arrival[narr].apriori_weight : 1.0;
+        pest[num_est].narr = narr;
+        if (pest[num_est].sigma2 > sigma2_max)
+            sigma2_max = pest[num_est].sigma2;
+        edt_matrix_diagonal_sum += edtmtx[narr][narr];
+        num_est++;
+    }
+    qsort(pest, num_est, sizeof (OtMLEstimate), compare_ot_ml_estimate);
+
+    // kernel values exp(-0.5 * temp * temp / sigma2) underflow to zero for temp * temp > 1492 * sigma2
+    window = sqrt(1492.0 * sigma2_max);
+
+
+    // coarse search: find ot estimate with largest likelihood over set of ot's for each arrival
+    arr_prob_max = -1.0;
+    nstart = nend = 0;
+    for (nest = 0; nest < num_est; nest++) {
+        ot_arr = pest[nest].ot;
+        while (pest[nstart].ot < ot_arr - window)
+            nstart++;
+        while (nend < num_est && pest[nend].ot <= ot_arr + window)
+            nend++;
+        prob = calc_likelihood_ot_window(pest, nstart, nend, ot_arr, NULL, NULL);
         // store if largest cumulative ot likelihood
         if (prob > arr_prob_max) {
             arr_prob_max = prob;
             ot_arr_prob_max = ot_arr;
-            //printf("---------> max");
         }
-        //printf("\n");
-        edt_matrix_diagonal_sum += edtmtx[narr][narr];
     }
     if (iwrite_errors && arr_prob_max < 0.0)
         nll_puterr("ERROR: calc_maximum_likelihood_ot: failed to find arr_prob_max.");
@@ -9572,40 +10361,65 @@ double calc_maximum_likelihood_ot(double *pot_ml_arrival, double *pot_ml_arrival
     // search numerically for precise ot likelihood peak
     range = 3.0 * edt_matrix_rms_error;
     step = edt_matrix_rms_error / 100.0;
+    tolerance = step / 100.0;
     prob_max = arr_prob_max;
     ot_max_like = ot_arr_prob_max;
-    // search increasing time
-    time = ot_arr_prob_max;
-    tlimit = ot_arr_prob_max + range;
-    while ((time = time + step) < tlimit) {
-        prob = calc_likelihood_ot(ot_ml_arrival, pot_ml_arrival_edt_sum, num_arrivals, arrival, edtmtx, time);
-        //printf("DEBUG: calc_likelihood_ot: inc time: time %f, prob %f\n", time, prob);
-        if (prob < prob_max)
-            break;
-        prob_max = prob;
-        ot_max_like = time;
-        //printf("DEBUG: calc_likelihood_ot 1: ot_max_like %f\n", ot_max_like);
-    }
-    if (iwrite_errors && time >= tlimit) {
-        sprintf(MsgStr, "ot_arr_prob_max: %f, range %f, tlimit %f", ot_arr_prob_max, range, tlimit);
-        nll_puterr2("ERROR: calc_maximum_likelihood_ot: reached end of increasing-time search limit:", MsgStr);
-    }
-
-    // search decreasing time
-    time = ot_arr_prob_max;
-    tlimit = ot_arr_prob_max - range;
-    while ((time = time - step) > tlimit) {
-        prob = calc_likelihood_ot(ot_ml_arrival, pot_ml_arrival_edt_sum, num_arrivals, arrival, edtmtx, time);
-        //printf("DEBUG: calc_likelihood_ot: dec time: time %f, prob %f\n", time, prob);
-        if (prob < prob_max)
-            break;
-        prob_max = prob;
-        ot_max_like = time;
-        //printf("DEBUG: calc_likelihood_ot 2: ot_max_like %f\n", ot_max_like);
-    }
-    if (iwrite_errors && time <= tlimit) {
-        sprintf(MsgStr, "ot_arr_prob_max: %f, range %f, tlimit %f", ot_arr_prob_max, range, tlimit);
-        nll_puterr2("ERROR: calc_maximum_likelihood_ot: reached end of decreasing-time search limit:", MsgStr);
+    if (num_est > 0 && step > 0.0) {
+        calc_likelihood_ot_sorted(pest, num_est, window, ot_arr_prob_max, &deriv1, &deriv2);
+        if (deriv1 != 0.0) {
+            // bracket peak, search in direction of increasing likelihood with doubling steps
+            direction = deriv1 > 0.0 ? 1.0 : -1.0;
+            tlimit = ot_arr_prob_max + direction * range;
+            tlow = ot_arr_prob_max;
+            thigh = tlimit;
+            for (time = step; ; time *= 2.0) {
+                if (time >= range) {
+                    calc_likelihood_ot_sorted(pest, num_est, window, tlimit, &deriv1, &deriv2);
+                    if (direction * deriv1 > 0.0) {
+                        if (iwrite_errors) {
+                            sprintf(MsgStr, "ot_arr_prob_max: %f, range %f, tlimit %f", ot_arr_prob_max, range, tlimit);
+                            nll_puterr2(direction > 0.0 ?
+                                    "ERROR: calc_maximum_likelihood_ot: reached end of increasing-time search limit:" :
+                                    "ERROR: calc_maximum_likelihood_ot: reached end of decreasing-time search limit:", MsgStr);
+                        }
+                        tlow = thigh = tlimit;
+                    }
+                    break;
+                }
+                calc_likelihood_ot_sorted(pest, num_est, window, ot_arr_prob_max + direction * time, &deriv1, &deriv2);
+                if (direction * deriv1 <= 0.0) {
+                    thigh = ot_arr_prob_max + direction * time;
+                    break;
+                }
+                tlow = ot_arr_prob_max + direction * time;
+            }
+            // refine peak, Newton iteration on derivative of likelihood, bisection if Newton step leaves bracket
+            time = tlow;
+            for (niter = 0; niter < 100 && fabs(thigh - tlow) > tolerance; niter++) {
+                calc_likelihood_ot_sorted(pest, num_est, window, time, &deriv1, &deriv2);
+                if (direction * deriv1 > 0.0)
+                    tlow = time;
+                else if (deriv1 != 0.0)
+                    thigh = time;
+                else
+                    break;
+                tnext = deriv2 < 0.0 ? time - deriv1 / deriv2 : 0.5 * (tlow + thigh);
+                if (direction * (tnext - tlow) <= 0.0 || direction * (thigh - tnext) <= 0.0)
+                    tnext = 0.5 * (tlow + thigh);
+                if (fabs(tnext - time) < tolerance) {
+                    time = tnext;
+                    break;
+                }
+                time = tnext;
+            }
+            if (tlow == thigh)
+                time = tlow;
+            prob = calc_likelihood_ot_sorted(pest, num_est, window, time, NULL, NULL);
+            if (prob > prob_max) {
+                prob_max = prob;
+                ot_max_like = time;
+            }
+        }
     }
 
 
@@ -9613,9 +10427,7 @@ double calc_maximum_likelihood_ot(double *pot_ml_arrival, double *pot_ml_arrival
     *pprob_max = prob_max;
 
     // get variance
-    *pot_ml_var = calc_variance_ot(ot_ml_arrival, pot_ml_arrival_edt_sum, num_arrivals, arrival, edtmtx, ot_max_like);
-
-    //printf("DEBUG: calc_likelihood_ot 3: ot_max_like %f\n", ot_max_like);
+    *pot_ml_var = calc_variance_ot(pot_ml_arrival, pot_ml_arrival_edt_sum, num_arrivals, arrival, edtmtx, ot_max_like);
 
     return (ot_max_like);
 
@@ -10284,7 +11096,7 @@ int ReadNLLoc_Input(FILE* fp_input, char** param_line_array, int n_param_lines)
             flag_phstat = 0, flag_phase_id = 0, flag_sta_wt = 0, flag_qual2err = 0,
             flag_mag = 0, flag_alias = 0, flag_exclude = 0, flag_include = 0, flag_time_delay = 0,
             flag_topo_surface = 0, flag_time_delay_surface = 0, flag_elev_corr = 0,
-            flag_otime = 0, flag_angles = 0, flag_source = 0;
+            flag_otime = 0, flag_angles = 0, flag_source = 0, flag_recip = 0;
     int flag_include_file = 1;
 
     int ok_search_pdf = 1;
@@ -10680,6 +11492,16 @@ patch below fixes this problem.
         }
 
 
+        /* read reciprocity (source-side time grids) params */
+
+        if (strcmp(param, "LOCRECIP") == 0) {
+            if ((istat = GetNLLoc_Recip(strchr(line, ' '))) < 0)
+                nll_puterr("ERROR: reading reciprocity (LOCRECIP) params.");
+            else
+                flag_recip = 1;
+        }
+
+
 
         /* unrecognized input */
 
@@ -10846,6 +11668,12 @@ patch below fixes this problem.
         sprintf(MsgStr, "INFO: no Station (LOCSRCE or GTSRCE) params read.");
         nll_putmsg(2, MsgStr);
     }
+    if (!flag_recip) {
+        sprintf(MsgStr, "INFO: no Reciprocity (LOCRECIP) params read.");
+        nll_putmsg(2, MsgStr);
+    } else if (!flag_source) {
+        nll_puterr("ERROR: reciprocity (LOCRECIP) requires station coordinates (LOCSRCE).");
+    }
 
 
 
@@ -11428,6 +12256,30 @@ int GetNLLoc_HypOutTypes(char* line1) {
             iSaveNLLocOctree = 1;
         else if (strcmp(hyp_type, "SAVE_NLLOC_JSON") == 0) // 20220131 AJL - added to support JSON output of location results
             iSaveNLLocEvent_JSON = 1;
+        else if (strcmp(hyp_type, "SAVE_NLLOC_BATCH") == 0) { // 20261018 AJL - added
+#ifdef NLL_HAVE_MEMSTREAM
+            iSaveNLLocEvent = iSaveNLLocBatch = 1;
+#else
+            nll_puterr2("WARNING: LOCHYPOUT: memory streams (function open_memstream()) not available, ignoring", hyp_type);
+#endif
+        } else if (strcmp(hyp_type, "SAVE_SCATTER_COMPRESSED") == 0) // 20261018 AJL - added
+            iSaveNLLocScatCompressed = 1;
+        else if (strcmp(hyp_type, "LAST_COPY") == 0) // 20261018 AJL - added
+            iSaveLast = SAVE_LAST_COPY;
+        else if (strcmp(hyp_type, "LAST_SYMLINK") == 0) // 20261018 AJL - added
+            iSaveLast = SAVE_LAST_SYMLINK;
+        else if (strcmp(hyp_type, "LAST_NONE") == 0) // 20261018 AJL - added
+            iSaveLast = SAVE_LAST_NONE;
+        else if (strcmp(hyp_type, "SAVE_NLLOC_PROF") == 0 || strcmp(hyp_type, "SAVE_NLLOC_PROF_JSON") == 0) { // 20261018 AJL - added
+#ifdef NLL_PROFILE
+            if (strcmp(hyp_type, "SAVE_NLLOC_PROF") == 0)
+                iSaveNLLocProf = 1;
+            else
+                iSaveNLLocProfJSON = 1;
+#else
+            nll_puterr2("WARNING: LOCHYPOUT: program not compiled with NLL_PROFILE (cmake -DNLL_PROFILE=ON), ignoring", hyp_type);
+#endif
+        }
         else if (strcmp(hyp_type, "SAVE_HYPO71_ALL") == 0)
             iSaveHypo71Event = iSaveHypo71Sum = 1;
         else if (strcmp(hyp_type, "SAVE_HYPO71_SUM") == 0)
@@ -11467,6 +12319,8 @@ int GetNLLoc_HypOutTypes(char* line1) {
                     iSaveAlberto4Sum = iSaveFmamp = iSaveSnapSum = iCalcSedOrigin = iSaveDecSec = iSavePublicID = 0;
             iSaveNLLocExpectation = 0; // 20170811 AJL - added
             iSaveNLLocSumCSV = 0; // 20240826 AJL - added
+            iSaveNLLocBatch = 0; // 20261018 AJL - added
+            iSaveNLLocScatCompressed = 0; // 20261018 AJL - added
         } else
             return (-1);
 
@@ -11831,6 +12685,8 @@ int GetNLLoc_Angles(char* line1) {
 
     if (strcmp(strAngleMode, "ANGLES_YES") == 0)
         angleMode = ANGLE_MODE_YES;
+    else if (strcmp(strAngleMode, "ANGLES_TIME") == 0) // 20261018 AJL - added
+        angleMode = ANGLE_MODE_TIME;
     else if (strcmp(strAngleMode, "ANGLES_NO") == 0)
         angleMode = ANGLE_MODE_NO;
     else {
@@ -11844,6 +12700,24 @@ int GetNLLoc_Angles(char* line1) {
 
 }
 
+/** function to read take-off angles at location from angle grid file (ANGLE_MODE_YES)
+ *      or from gradient of travel time grid file (ANGLE_MODE_TIME)
+ *
+ *  fname is angle grid file root (.angle) or time grid file root (.time) for ANGLE_MODE_TIME
+ *
+ * 20261018 AJL - added
+ */
+
+int ReadTakeOffAngles(char *fname, double xloc, double yloc, double zloc,
+        double *pazim, double *pdip, int *piqual, double sta_azim, int iSwapBytes) {
+
+    if (angleMode == ANGLE_MODE_TIME)
+        return (ReadTakeOffAnglesTimeGrid(fname, xloc, yloc, zloc, pazim, pdip, piqual, sta_azim, iSwapBytes));
+
+    return (ReadTakeOffAnglesFile(fname, xloc, yloc, zloc, pazim, pdip, piqual, sta_azim, iSwapBytes));
+
+}
+
 /** function to read component description ***/
 
 int GetCompDesc(char* line1) {
@@ -12103,8 +12977,53 @@ int GetElevCorr(char* line1) {
     //nll_putmsg(3, MsgStr);
     nll_putmsg(1, MsgStr);
 
-    if (istat != 3)
+    if (istat != 3)
+
+        return (-1);
+
+    return (0);
+}
+
+/** function to read reciprocity (source-side time grids) params
+ *
+ * 20261018 AJL - added
+ *
+ * LOCRECIP <grid_root> <centroid_label> [<centroid_label> ...]
+ *    station travel times are read from the time grids <grid_root>.PHASE.<centroid_label>.time
+ *    generated by Grid2Time for event or cluster centroids (GTSRCE_CENTROID or GTSRCE),
+ *    instead of from station time grids.  May be repeated to add centroid labels.
+ *    Station coordinates must be given with LOCSRCE.
+ ***/
+
+int GetNLLoc_Recip(char* line1) {
+
+    int nchar;
+    char grid_root[FILENAME_MAX], label[MAXLINE];
+
+    if (sscanf(line1, "%s%n", grid_root, &nchar) != 1)
+        return (-1);
+    line1 += nchar;
+
+    if (NumRecipCentroids > 0 && strcmp(grid_root, RecipGridRoot) != 0) {
+        nll_puterr2("ERROR: LOCRECIP grid root differs from that of previous LOCRECIP", grid_root);
+        return (-1);
+    }
+    strcpy(RecipGridRoot, grid_root);
+
+    while (sscanf(line1, "%s%n", label, &nchar) == 1) {
+        line1 += nchar;
+        if (NumRecipCentroids >= MAX_NUM_RECIP_CENTROIDS) {
+            nll_puterr2("ERROR: too many LOCRECIP centroids, ignoring centroid", label);
+            continue;
+        }
+        snprintf(RecipCentroidLabel[NumRecipCentroids], ARRIVAL_LABEL_LEN, "%s", label);
+        NumRecipCentroids++;
+    }
+
+    sprintf(MsgStr, "LOCRECIP:  GridRoot: %s  NumCentroids: %d", RecipGridRoot, NumRecipCentroids);
+    nll_putmsg(2, MsgStr);
 
+    if (NumRecipCentroids < 1)
         return (-1);
 
     return (0);
@@ -12118,12 +13037,78 @@ int OpenSummaryFiles(char *path_output, char* loctypename) {
     char fname[FILENAME_MAX];
 
 
+    // 20261018 AJL - per event profile, one line or JSON record per event
+    pSumFileProf = NULL;
+    if (iSaveNLLocProf) {
+        sprintf(fname, "%s.sum.prof", path_output);
+        if ((pSumFileProf = fopen(fname, "w")) == NULL) {
+            nll_puterr2("ERROR: opening profile summary output file", fname);
+            return (-1);
+        } else {
+            NumFilesOpen++;
+        }
+    }
+    pSumFileProfJSON = NULL;
+    if (iSaveNLLocProfJSON) {
+        sprintf(fname, "%s.sum.prof.json", path_output);
+        if ((pSumFileProfJSON = fopen(fname, "w")) == NULL) {
+            nll_puterr2("ERROR: opening profile JSON summary output file", fname);
+            return (-1);
+        } else {
+            NumFilesOpen++;
+        }
+    }
+
+    // 20261018 AJL - batched event output, all batch and NLLoc summary writes go through background writer
+    BatchWriter = NULL;
+    if (iSaveNLLocBatch) {
+        if ((BatchWriter = new_NllWriter(0)) == NULL) {
+            nll_puterr("ERROR: creating batch output writer.");
+            return (-1);
+        }
+    }
 
     for (ngrid = 0; ngrid < NumLocGrids; ngrid++) {
 
         if (!LocGridSave[ngrid])
             continue;
 
+        /* Batch event output: hyp, scatter and index streams, grid header */
+
+        pBatchFileHyp[ngrid] = pBatchFileScat[ngrid] = pBatchFileIndex[ngrid] = NULL;
+        BatchHypBytes[ngrid] = BatchScatBytes[ngrid] = 0;
+        BatchScatOffsetEvent[ngrid] = BatchScatSizeEvent[ngrid] = 0;
+        if (iSaveNLLocBatch) {
+            sprintf(fname, "%s.batch.%s%d.loc.hyp", path_output, loctypename, ngrid);
+            if ((pBatchFileHyp[ngrid] = fopen(fname, "w")) == NULL) {
+                nll_puterr2("ERROR: opening batch hyp output file", fname);
+                return (-1);
+            }
+            NumFilesOpen++;
+            sprintf(fname, "%s.batch.%s%d.loc.scat", path_output, loctypename, ngrid);
+            if ((pBatchFileScat[ngrid] = fopen(fname, "wb")) == NULL) {
+                nll_puterr2("ERROR: opening batch scatter output file", fname);
+                return (-1);
+            }
+            NumFilesOpen++;
+            sprintf(fname, "%s.batch.%s%d.loc.index", path_output, loctypename, ngrid);
+            if ((pBatchFileIndex[ngrid] = fopen(fname, "w")) == NULL) {
+                nll_puterr2("ERROR: opening batch index output file", fname);
+                return (-1);
+            }
+            NumFilesOpen++;
+            fprintf(pBatchFileIndex[ngrid], "# event hyp_offset hyp_bytes scat_offset scat_bytes\n");
+            // location grid header is the same for all events
+            sprintf(fname, "%s.batch.%s%d", path_output, loctypename, ngrid);
+            if (WriteGrid3dHdr(LocGrid + ngrid, NULL, fname, "loc") < 0)
+                return (-1);
+            if (iSaveNLLocSum) {
+                sprintf(fname, "%s.sum.%s%d", path_output, loctypename, ngrid);
+                if (WriteGrid3dHdr(LocGrid + ngrid, NULL, fname, "loc") < 0)
+                    return (-1);
+            }
+        }
+
         /* Grid Hyp format */
 
         pSumFileHypNLLoc[ngrid] = NULL;
@@ -12260,6 +13245,13 @@ int OpenSummaryFiles(char *path_output, char* loctypename) {
 int CloseSummaryFiles() {
     int ngrid;
 
+    // 20261018 AJL - write all queued batch output before closing files
+    if (BatchWriter != NULL) {
+        if (free_NllWriter(BatchWriter) < 0)
+            nll_puterr("ERROR: writing batch output files.");
+        BatchWriter = NULL;
+    }
+
 
     for (ngrid = 0; ngrid < NumLocGrids; ngrid++) {
 
@@ -12326,10 +13318,61 @@ int CloseSummaryFiles() {
 
     }
 
+    // 20261018 AJL - batched event output
+    for (ngrid = 0; ngrid < NumLocGrids; ngrid++) {
+        if (pBatchFileHyp[ngrid] != NULL) {
+            fclose(pBatchFileHyp[ngrid]);
+            pBatchFileHyp[ngrid] = NULL;
+            NumFilesOpen--;
+        }
+        if (pBatchFileScat[ngrid] != NULL) {
+            fclose(pBatchFileScat[ngrid]);
+            pBatchFileScat[ngrid] = NULL;
+            NumFilesOpen--;
+        }
+        if (pBatchFileIndex[ngrid] != NULL) {
+            fclose(pBatchFileIndex[ngrid]);
+            pBatchFileIndex[ngrid] = NULL;
+            NumFilesOpen--;
+        }
+    }
+
+    // 20261018 AJL - per event profile
+    if (pSumFileProf != NULL) {
+        fclose(pSumFileProf);
+        pSumFileProf = NULL;
+        NumFilesOpen--;
+    }
+    if (pSumFileProfJSON != NULL) {
+        fclose(pSumFileProfJSON);
+        pSumFileProfJSON = NULL;
+        NumFilesOpen--;
+    }
+
     return (0);
 
 }
 
+/** function to write timing and counter profile of current event to profile summary files
+ *
+ *  profile is accumulated only if compiled with NLL_PROFILE, see nll_prof.h
+ */
+
+void WriteProfile(char *fnout) {
+
+#ifdef NLL_PROFILE
+    if (pSumFileProf != NULL) {
+        nll_prof_write(pSumFileProf, fnout);
+        fflush(pSumFileProf);
+    }
+    if (pSumFileProfJSON != NULL) {
+        nll_prof_write_json(pSumFileProfJSON, fnout);
+        fflush(pSumFileProfJSON);
+    }
+#endif
+
+}
+
 /** function to write hypocenter and arrivals to file (Alberto 4 SIMULPS) */
 
 int WriteHypoAlberto4(FILE *fpio, HypoDesc* phypo, ArrivalDesc* parrivals, int narrivals, char* filename) {
@@ -13143,7 +14186,7 @@ int WriteHypoInverseArchive(FILE *fpio, HypoDesc *phypo, ArrivalDesc *parrivals,
 
             // 20060619 AJL
             /* no first motion for phases with take-off angle quality < min qual */
-            if (angleMode == ANGLE_MODE_YES && parr->ray_qual < iAngleQualityMin)
+            if ((angleMode == ANGLE_MODE_YES || angleMode == ANGLE_MODE_TIME) && parr->ray_qual < iAngleQualityMin)
                 first_mot = ' ';
             else if (strpbrk(parr->first_mot, "cCuU+"))
                 first_mot = 'U';
@@ -14139,11 +15182,13 @@ void UpdateStaStat(int ntable, ArrivalDesc *arrival, int num_arrivals,
 
 int setStationDistributionWeights(SourceDesc *stations, int numStations, ArrivalDesc *arrival, int nArrivals) {
 
-    int i, nsta, m, nError = 0;
+    int i, nsta, m, k, nfound, nError = 0;
+    int *nsta_found;
     double x, y, dist, station_weight, weight;
     double dist_ave, cutoff2;
     double station_weight_sum;
     ArrivalDesc *arr;
+    StationIndex station_index = {0, 0, NULL};
 
 
     // get cutoff distance
@@ -14161,6 +15206,15 @@ int setStationDistributionWeights(SourceDesc *stations, int numStations, Arrival
         cutoff2 = dist_ave * dist_ave;
     }
 
+    // 20261018 AJL - use spatial index of stations, only stations within distance sqrt(746 * cutoff2) have weight > 0.0
+    //    (exp(-746) underflows to 0.0), weights of these stations are summed in station list order as before
+    if (BuildStationIndex(&station_index, stations, numStations) < 0)
+        return (-1);
+    if ((nsta_found = (int *) malloc((size_t) (station_index.num_nodes + 1) * sizeof (int))) == NULL) {
+        nll_puterr("ERROR: allocating memory for station distribution weights.");
+        FreeStationIndex(&station_index);
+        return (-1);
+    }
 
 
     // calculate station weights
@@ -14174,9 +15228,9 @@ int setStationDistributionWeights(SourceDesc *stations, int numStations, Arrival
         y = arr->station.y;
         if (x == 0.0 && y == 0.0) // station location not known
             continue;
-        for (m = 0; m < numStations; m++) {
-            if ((stations + m)->ignored)
-                continue;
+        nfound = FindStationsInRadius(&station_index, x, y, sqrt(746.0 * cutoff2), nsta_found);
+        for (k = 0; k < nfound; k++) {
+            m = nsta_found[k];
             // 20240207 AJL - Bug fix: skip stations without coordinates
             if ((stations + m)->x < -1.0e6)
                 continue;
@@ -14207,22 +15261,406 @@ int setStationDistributionWeights(SourceDesc *stations, int numStations, Arrival
         }
     }
 
+    free(nsta_found);
+    FreeStationIndex(&station_index);
 
     return (nError);
 
 
 }
 
+/** function to free centroid grid descriptions and station arrays of reciprocity phase, phase remains flagged as tried */
+
+static void free_recip_phase_arrays(RecipPhaseDesc *prp) {
+
+    free(prp->gdesc);
+    prp->gdesc = NULL;
+    free(prp->centroid);
+    prp->centroid = NULL;
+    free(prp->sta_done);
+    prp->sta_done = NULL;
+    free(prp->sta_time);
+    prp->sta_time = NULL;
+    free(prp->sta_grad);
+    prp->sta_grad = NULL;
+
+}
+
+/** function to open and read into memory the reciprocity centroid time grids for a phase
+ *
+ * returns index in RecipPhase, or -1 if grids for this phase are not available
+ */
+
+int GetRecipPhase(char *phase) {
+
+    int nphs, ncent, istat;
+    char filename[FILENAME_MAX];
+    FILE *fp_grid, *fp_hdr;
+    RecipPhaseDesc *prp;
+
+    // check if phase already opened or tried
+    for (nphs = 0; nphs < NumRecipPhases; nphs++) {
+        if (strcmp(RecipPhase[nphs].phase, phase) == 0)
+            return (RecipPhase[nphs].num_centroid > 0 ? nphs : -1);
+    }
+
+    if (NumRecipPhases >= MAX_NUM_RECIP_PHASES) {
+        nll_puterr2("ERROR: too many LOCRECIP phases, ignoring phase", phase);
+        return (-1);
+    }
+
+    prp = RecipPhase + NumRecipPhases++;
+    strcpy(prp->phase, phase);
+    prp->num_centroid = 0;
+    prp->gdesc = (GridDesc *) calloc(NumRecipCentroids, sizeof (GridDesc));
+    prp->centroid = (SourceDesc *) calloc(NumRecipCentroids, sizeof (SourceDesc));
+    prp->sta_done = (char *) calloc(NumSources > 0 ? NumSources : 1, sizeof (char));
+    prp->sta_time = (double *) malloc((size_t) (NumSources > 0 ? NumSources : 1) * NumRecipCentroids * sizeof (double));
+    prp->sta_grad = (double *) malloc((size_t) (NumSources > 0 ? NumSources : 1) * NumRecipCentroids * 3 * sizeof (double));
+    if (prp->gdesc == NULL || prp->centroid == NULL || prp->sta_done == NULL
+            || prp->sta_time == NULL || prp->sta_grad == NULL) {
+        nll_puterr("ERROR: allocating memory for LOCRECIP centroid grids.");
+        free_recip_phase_arrays(prp);
+        return (-1);
+    }
+
+    for (ncent = 0; ncent < NumRecipCentroids; ncent++) {
+        snprintf(filename, sizeof (filename), "%s.%s.%s.time", RecipGridRoot, phase, RecipCentroidLabel[ncent]);
+        if ((istat = OpenGrid3dFile(filename, &fp_grid, &fp_hdr, prp->gdesc + ncent, "time",
+                prp->centroid + ncent, iSwapBytesOnInput)) < 0) {
+            CloseGrid3dFile(prp->gdesc + ncent, &fp_grid, &fp_hdr);
+            break;
+        }
+        if (prp->gdesc[ncent].type != GRID_TIME) {
+            nll_puterr2("ERROR: LOCRECIP centroid time grid must be 3D (GTMODE GRID3D)", filename);
+            CloseGrid3dFile(prp->gdesc + ncent, &fp_grid, &fp_hdr);
+            break;
+        }
+        if (AllocateGrid(prp->gdesc + ncent) == NULL
+                || CreateGridArray(prp->gdesc + ncent) == NULL
+                || ReadGrid3dBuf(prp->gdesc + ncent, fp_grid) < 0) {
+            nll_puterr2("ERROR: reading LOCRECIP centroid time grid", filename);
+            CloseGrid3dFile(prp->gdesc + ncent, &fp_grid, &fp_hdr);
+            break;
+        }
+        CloseGrid3dFile(prp->gdesc + ncent, &fp_grid, &fp_hdr);
+        prp->num_centroid++;
+    }
+
+    if (prp->num_centroid < NumRecipCentroids) {
+        if (message_flag >= 2) {
+            sprintf(MsgStr, "WARNING: cannot open LOCRECIP centroid time grid: %s: no reciprocity travel times for phase %s",
+                    filename, phase);
+            nll_putmsg(2, MsgStr);
+        }
+        for (ncent = 0; ncent < prp->num_centroid; ncent++) {
+            DestroyGridArray(prp->gdesc + ncent);
+            FreeGrid(prp->gdesc + ncent);
+        }
+        prp->num_centroid = 0;
+        free_recip_phase_arrays(prp);
+        return (-1);
+    }
+
+    memset(prp->sta_done, 0, (size_t) (NumSources > 0 ? NumSources : 1) * sizeof (char));
+
+    if (message_flag >= 2) {
+        sprintf(MsgStr, "LOCRECIP:  %d centroid time grids read for phase %s", prp->num_centroid, phase);
+        nll_putmsg(2, MsgStr);
+    }
+
+    return (nphs);
+
+}
+
+/** function to calculate travel time from a centroid to a station and the gradient at the centroid of
+ *   the travel time to the station
+ *
+ * By reciprocity the gradient at the centroid of the time to the station is -s * d, where s is the
+ * slowness at the centroid and d the ray take-off direction at the centroid towards the station.
+ * d is found by tracing the steepest descent path of the centroid time field from the station
+ * back to the centroid neighbourhood.
+ *
+ * returns 0 if OK, -1 if station is outside centroid time grid (*ptime set to -1.0)
+ */
+
+int CalcRecipStationTerms(GridDesc *pgrid, SourceDesc *centroid, SourceDesc *station, double *ptime, double *pgrad) {
+
+    int nstep, max_num_steps;
+    double step, radius_stop, dist, time, tx, ty, tz, gmag;
+    double x, y, z;
+
+    pgrad[0] = pgrad[1] = pgrad[2] = 0.0;
+
+    if ((*ptime = (double) ReadAbsInterpGrid3d(NULL, pgrid, station->x, station->y, station->z, 0)) < 0.0) {
+        *ptime = -1.0;
+        return (-1);
+    }
+
+    step = pgrid->dx;
+    if (pgrid->dy < step)
+        step = pgrid->dy;
+    if (pgrid->dz < step)
+        step = pgrid->dz;
+    radius_stop = 2.0 * step;
+    max_num_steps = 4 * (pgrid->numx + pgrid->numy + pgrid->numz);
+
+    // trace steepest descent path from station towards centroid
+    x = station->x;
+    y = station->y;
+    z = station->z;
+    for (nstep = 0; nstep < max_num_steps; nstep++) {
+        dist = sqrt((x - centroid->x) * (x - centroid->x) + (y - centroid->y) * (y - centroid->y)
+                + (z - centroid->z) * (z - centroid->z));
+        if (dist <= radius_stop)
+            break;
+        tx = (double) ReadAbsInterpGrid3d(NULL, pgrid, x + step / 2.0, y, z, 0)
+                - (double) ReadAbsInterpGrid3d(NULL, pgrid, x - step / 2.0, y, z, 0);
+        ty = (double) ReadAbsInterpGrid3d(NULL, pgrid, x, y + step / 2.0, z, 0)
+                - (double) ReadAbsInterpGrid3d(NULL, pgrid, x, y - step / 2.0, z, 0);
+        tz = (double) ReadAbsInterpGrid3d(NULL, pgrid, x, y, z + step / 2.0, 0)
+                - (double) ReadAbsInterpGrid3d(NULL, pgrid, x, y, z - step / 2.0, 0);
+        gmag = sqrt(tx * tx + ty * ty + tz * tz);
+        // path reached grid edge or undefined gradient, use straight path direction from centroid
+        if (gmag < VERY_SMALL_DOUBLE || gmag > LARGE_DOUBLE) {
+            x = station->x;
+            y = station->y;
+            z = station->z;
+            break;
+        }
+        x -= step * tx / gmag;
+        y -= step * ty / gmag;
+        z -= step * tz / gmag;
+    }
+
+    dist = sqrt((x - centroid->x) * (x - centroid->x) + (y - centroid->y) * (y - centroid->y)
+            + (z - centroid->z) * (z - centroid->z));
+    if (dist < VERY_SMALL_DOUBLE)
+        return (0);
+    // mean slowness near centroid
+    if ((time = (double) ReadAbsInterpGrid3d(NULL, pgrid, x, y, z, 0)) < 0.0)
+        time = *ptime;
+    time /= dist;
+
+    pgrad[0] = -time * (x - centroid->x) / dist;
+    pgrad[1] = -time * (y - centroid->y) / dist;
+    pgrad[2] = -time * (z - centroid->z) / dist;
+
+    return (0);
+
+}
+
+/** function to set up an arrival to use reciprocity (LOCRECIP) travel times
+ *
+ * 20261018 AJL - added
+ *
+ * returns 0 if OK, -1 if no reciprocity travel times are available for this arrival
+ */
+
+int SetupRecipArrival(ArrivalDesc *arrival, char *arrival_phase) {
+
+    int n_recip, nsta, ncent;
+    char eval_phase[PHASE_LABEL_LEN];
+    SourceDesc *pstation;
+    RecipPhaseDesc *prp;
+
+    // station coordinates
+    if ((pstation = FindSource(arrival->time_grid_label)) == NULL) {
+        if (message_flag >= 2) {
+            sprintf(MsgStr, "WARNING: LOCRECIP: station not found in LOCSRCE list: %s", arrival->time_grid_label);
+            nll_putmsg(2, MsgStr);
+        }
+        return (-1);
+    }
+    nsta = pstation - Source;
+
+    // centroid time grids, try original phase ID, LOCPHASEID mapped phase ID, then P for S
+    arrival->tfact = 1.0;
+    if ((n_recip = GetRecipPhase(arrival_phase)) < 0) {
+        EvalPhaseID(eval_phase, arrival_phase);
+        if ((n_recip = GetRecipPhase(eval_phase)) < 0 && VpVsRatio > 0.0 && IsPhaseID(arrival_phase, "S")) {
+            if ((n_recip = GetRecipPhase("P")) >= 0)
+                arrival->tfact = VpVsRatio;
+        }
+    }
+    if (n_recip < 0)
+        return (-1);
+    prp = RecipPhase + n_recip;
+
+    // station terms for all centroids, calculated once per station and phase
+    if (!prp->sta_done[nsta]) {
+        for (ncent = 0; ncent < prp->num_centroid; ncent++)
+            CalcRecipStationTerms(prp->gdesc + ncent, prp->centroid + ncent, pstation,
+                prp->sta_time + nsta * prp->num_centroid + ncent,
+                prp->sta_grad + 3 * (nsta * prp->num_centroid + ncent));
+        prp->sta_done[nsta] = 1;
+    }
+
+    arrival->station = *pstation;
+    arrival->n_recip = n_recip;
+    arrival->n_recip_sta = nsta;
+    arrival->fpgrid = NULL;
+    arrival->fphdr = NULL;
+    arrival->gdesc.type = GRID_TIME;
+    arrival->gdesc.buffer = NULL;
+    arrival->gdesc.array = NULL;
+    arrival->sheetdesc.buffer = NULL;
+    arrival->sheetdesc.array = NULL;
+    snprintf(arrival->gdesc.title, sizeof (arrival->gdesc.title), "%s.%s.LOCRECIP", RecipGridRoot, prp->phase);
+
+    if (message_flag >= 3) {
+        sprintf(MsgStr, "INFO: %s %s using LOCRECIP centroid time grids for phase %s (tfact=%f).",
+                arrival->label, arrival->phase, prp->phase, arrival->tfact);
+        nll_putmsg(3, MsgStr);
+    }
+
+    return (0);
+
+}
+
+/** function to get reciprocity (LOCRECIP) travel time for an arrival
+ *
+ * 20261018 AJL - added
+ *
+ * The time is taken from the time grid of the centroid nearest to the hypocenter, read at the station,
+ * with a first-order (plane-wave) correction for the offset of the hypocenter from the centroid.
+ * Accuracy thus decreases with distance from the nearest centroid, centroids should be spaced
+ * closely relative to the ray curvature near the sources.
+ *
+ * returns travel time, or -1.0 if undefined
+ */
+
+double RecipTravelTime(ArrivalDesc *arrival, double xval, double yval, double zval) {
+
+    int ncent, ncent_nearest, index;
+    double dist2, dist2_min;
+    double *pgrad;
+    SourceDesc *pcent;
+    RecipPhaseDesc *prp;
+
+    prp = RecipPhase + arrival->n_recip;
+
+    // nearest centroid
+    ncent_nearest = 0;
+    dist2_min = VERY_LARGE_DOUBLE;
+    for (ncent = 0; ncent < prp->num_centroid; ncent++) {
+        pcent = prp->centroid + ncent;
+        dist2 = (xval - pcent->x) * (xval - pcent->x) + (yval - pcent->y) * (yval - pcent->y)
+                + (zval - pcent->z) * (zval - pcent->z);
+        if (dist2 < dist2_min) {
+            dist2_min = dist2;
+            ncent_nearest = ncent;
+        }
+    }
+
+    index = arrival->n_recip_sta * prp->num_centroid + ncent_nearest;
+    if (prp->sta_time[index] < 0.0)
+        return (-1.0);
+
+    pcent = prp->centroid + ncent_nearest;
+    pgrad = prp->sta_grad + 3 * index;
+
+    return (prp->sta_time[index]
+            + pgrad[0] * (xval - pcent->x) + pgrad[1] * (yval - pcent->y) + pgrad[2] * (zval - pcent->z));
+
+}
+
+/** function to free reciprocity (LOCRECIP) centroid time grids */
+
+void FreeRecipGrids() {
+
+    int nphs, ncent;
+
+    for (nphs = 0; nphs < NumRecipPhases; nphs++) {
+        for (ncent = 0; ncent < RecipPhase[nphs].num_centroid; ncent++) {
+            DestroyGridArray(RecipPhase[nphs].gdesc + ncent);
+            FreeGrid(RecipPhase[nphs].gdesc + ncent);
+        }
+        free(RecipPhase[nphs].gdesc);
+        free(RecipPhase[nphs].centroid);
+        free(RecipPhase[nphs].sta_done);
+        free(RecipPhase[nphs].sta_time);
+        free(RecipPhase[nphs].sta_grad);
+        RecipPhase[nphs].num_centroid = 0;
+    }
+    NumRecipPhases = 0;
+
+}
+
+/** function to set per event station trig, receiver crustal corrections and shared 2D grid distances used by getTravelTimes() */
+
+void setArrivalTravelTimeGeometry(ArrivalDesc *arrival, int num_arr_loc) {
+
+    int narr, ndup;
+    double dtdd = 0.0;
+
+    for (narr = 0; narr < num_arr_loc; narr++) {
+        if (GeometryMode == MODE_GLOBAL) {
+            arrival[narr].sta_sin_lat = sin(arrival[narr].station.y * DE2RA);
+            arrival[narr].sta_cos_lat = cos(arrival[narr].station.y * DE2RA);
+            arrival[narr].sta_lon_rad = arrival[narr].station.x * DE2RA;
+        }
+        // receiver crustal correction, see applyCrustElevCorrection()
+        arrival[narr].crust_corr_phase = '\0';
+        arrival[narr].crust_corr_sta = 0.0;
+        if (ApplyCrustElevCorrFlag && GeometryMode == MODE_GLOBAL) {
+            if (IsPhaseID(arrival[narr].phase, "P"))
+                arrival[narr].crust_corr_phase = 'P';
+            else if (IsPhaseID(arrival[narr].phase, "S"))
+                arrival[narr].crust_corr_phase = 'S';
+            if (arrival[narr].crust_corr_phase != '\0')
+                arrival[narr].crust_corr_sta = calc_crust_corr(arrival[narr].crust_corr_phase, arrival[narr].station.dlat,
+                    arrival[narr].station.dlong, 0.0, -1000.0 * arrival[narr].station.depth, dtdd);
+        }
+        // find previous arrival with same 2D time grid and station location
+        arrival[narr].n_dist_dup = -1;
+        if (arrival[narr].n_companion >= 0 || arrival[narr].n_recip >= 0 || arrival[narr].gdesc.type == GRID_TIME
+                || arrival[narr].sheetdesc.buffer == NULL)
+            continue;
+        for (ndup = 0; ndup < narr; ndup++) {
+            if (arrival[ndup].n_companion < 0 && arrival[ndup].n_recip < 0 && arrival[ndup].gdesc.type != GRID_TIME
+                    && arrival[ndup].sheetdesc.buffer == arrival[narr].sheetdesc.buffer
+                    && arrival[ndup].station.x == arrival[narr].station.x
+                    && arrival[ndup].station.y == arrival[narr].station.y) {
+                arrival[narr].n_dist_dup = ndup;
+                break;
+            }
+        }
+    }
+
+}
+
 /** function to get travel times for all observed arrivals */
 
 int getTravelTimes(ArrivalDesc *arrival, int num_arr_loc, double xval, double yval, double zval) {
 
+    return (getTravelTimesSheets(arrival, num_arr_loc, xval, yval, zval, NULL));
+
+}
+
+/** function to get travel times for observed arrivals, 3D time grids read from y-z sheets in memory if psheets != NULL */
+
+// 20261018 AJL - added psheets for parallel grid search
+
+static int getTravelTimesSheets(ArrivalDesc *arrival, int num_arr_loc, double xval, double yval, double zval, ArrivalSheets *psheets) {
+
     int nReject;
-    int narr, n_compan;
+    int narr, n_compan, n_dup;
     FILE* fp_grid;
     double yval_grid = 0.0;
     GridDesc* ptgrid;
 
+    // 20261018 AJL - node latitude trig evaluated once for all arrivals, source crustal corrections evaluated once per phase type
+    double sin_lat = 0.0, cos_lat = 0.0, lon_rad = 0.0;
+    if (GeometryMode == MODE_GLOBAL) {
+        sin_lat = sin(yval * DE2RA);
+        cos_lat = cos(yval * DE2RA);
+        lon_rad = xval * DE2RA;
+    }
+    double crust_corr_src_P = 0.0, crust_corr_src_S = 0.0;
+    int have_crust_corr_src_P = 0, have_crust_corr_src_S = 0;
+    double crust_corr;
+
     // 20101005 AJL - added calculation of mean slowness
     double slowness_P = -1.0;
     double slowness_S = -1.0;
@@ -14276,33 +15714,62 @@ int getTravelTimes(ArrivalDesc *arrival, int num_arr_loc, double xval, double yv
             arrival[narr].pred_travel_time *= arrival[narr].tfact;
             /* else check grid type */
         } else {
-            if (arrival[narr].gdesc.type == GRID_TIME) {
+            if (arrival[narr].n_recip >= 0) {
+                /* reciprocity, centroid time grids */
+                if ((arrival[narr].pred_travel_time = RecipTravelTime(arrival + narr, xval, yval, zval)) < 0.0)
+                    nReject++;
+            } else if (arrival[narr].gdesc.type == GRID_TIME) {
                 /* 3D grid */
-                if (arrival[narr].gdesc.buffer == NULL) {
+                if (psheets != NULL && psheets[narr].use_sheets) {
+                    /* read time grid from y-z sheets in memory */
+                    arrival[narr].pred_travel_time = (double) ReadAbsInterpGrid3dSheets(psheets[narr].sheet0, psheets[narr].sheet1,
+                            &(arrival[narr].gdesc), xval, yval, zval);
+                } else if (arrival[narr].gdesc.buffer == NULL) {
                     /* read time grid from disk */
                     fp_grid = arrival[narr].fpgrid;
+#ifdef _OPENMP
+#pragma omp critical(nll_grid_search_read)
+#endif
+                    arrival[narr].pred_travel_time = (double) ReadAbsInterpGrid3d(fp_grid, &(arrival[narr].gdesc),
+                            xval, yval, zval, 0);
                 } else {
                     /* read time grid from memory buffer */
-                    fp_grid = NULL;
+                    arrival[narr].pred_travel_time = (double) ReadAbsInterpGrid3d(NULL, &(arrival[narr].gdesc),
+                            xval, yval, zval, 0);
                 }
-                if ((arrival[narr].pred_travel_time = (double) ReadAbsInterpGrid3d(fp_grid, &(arrival[narr].gdesc),
-                        xval, yval, zval, 0)) < 0.0)
+                if (arrival[narr].pred_travel_time < 0.0)
                     nReject++;
             } else {
                 /* 2D grid (1D model) */
-                yval_grid = GetEpiDist(&(arrival[narr].station), xval, yval);
-                if (GeometryMode == MODE_GLOBAL)
-                    yval_grid *= KM2DEG;
-                if (arrival[narr].sheetdesc.buffer == NULL) {
-                    /* read time grid from disk */
-                    fp_grid = arrival[narr].fpgrid;
-                    ptgrid = &(arrival[narr].gdesc);
+                if ((n_dup = arrival[narr].n_dist_dup) >= 0) {
+                    // same 2D time grid and station location as previous arrival
+                    yval_grid = arrival[n_dup].dist_grid;
+                    arrival[narr].tt_grid = arrival[n_dup].tt_grid;
                 } else {
-                    /* read time grid from memory buffer */
-                    fp_grid = NULL;
-                    ptgrid = &(arrival[narr].sheetdesc);
+                    if (GeometryMode == MODE_GLOBAL) {
+                        // same as GetEpiDist()
+                        if (yval == arrival[narr].station.y && xval == arrival[narr].station.x)
+                            yval_grid = 0.0;
+                        else
+                            yval_grid = GCDistanceSinCos(sin_lat, cos_lat, lon_rad,
+                                arrival[narr].sta_sin_lat, arrival[narr].sta_cos_lat, arrival[narr].sta_lon_rad);
+                        yval_grid *= KM2DEG;
+                    } else {
+                        yval_grid = GetEpiDist(&(arrival[narr].station), xval, yval);
+                    }
+                    if (arrival[narr].sheetdesc.buffer == NULL) {
+                        /* read time grid from disk */
+                        fp_grid = arrival[narr].fpgrid;
+                        ptgrid = &(arrival[narr].gdesc);
+                    } else {
+                        /* read time grid from memory buffer */
+                        fp_grid = NULL;
+                        ptgrid = &(arrival[narr].sheetdesc);
+                    }
+                    arrival[narr].tt_grid = ReadAbsInterpGrid2d(fp_grid, ptgrid, yval_grid, zval);
+                    arrival[narr].dist_grid = yval_grid;
                 }
-                if ((arrival[narr].pred_travel_time = ReadAbsInterpGrid2d(fp_grid, ptgrid, yval_grid, zval)) < 0.0)
+                if ((arrival[narr].pred_travel_time = arrival[narr].tt_grid) < 0.0)
                     nReject++;
                 //printf("DEBUG: getTT:  xval %lf yval %lf yval_grid %lf zval %lf t %lf \n", xval, yval, yval_grid, zval, arrival[narr].pred_travel_time);
                 //display_grid_param(&(arrival[narr].sheetdesc));
@@ -14312,8 +15779,27 @@ int getTravelTimes(ArrivalDesc *arrival, int num_arr_loc, double xval, double yv
             if (ApplyCrustElevCorrFlag && GeometryMode == MODE_GLOBAL
                     && arrival[narr].pred_travel_time > 0.0) {
                 //printf("arrival[narr].pred_travel_time before: %f", arrival[narr].pred_travel_time);
-                if (yval_grid > MinDistCrustElevCorr)
-                    arrival[narr].pred_travel_time += applyCrustElevCorrection(arrival + narr, xval, yval, zval);
+                if (yval_grid > MinDistCrustElevCorr) {
+                    // same as applyCrustElevCorrection()
+                    if (arrival[narr].crust_corr_phase == 'P') {
+                        if (!have_crust_corr_src_P) {
+                            crust_corr_src_P = calc_crust_corr('P', yval, xval, zval, VERY_LARGE_DOUBLE, 0.0);
+                            have_crust_corr_src_P = 1;
+                        }
+                        crust_corr = crust_corr_src_P;
+                    } else if (arrival[narr].crust_corr_phase == 'S') {
+                        if (!have_crust_corr_src_S) {
+                            crust_corr_src_S = calc_crust_corr('S', yval, xval, zval, VERY_LARGE_DOUBLE, 0.0);
+                            have_crust_corr_src_S = 1;
+                        }
+                        crust_corr = crust_corr_src_S;
+                    } else {
+                        crust_corr = 0.0;
+                    }
+                    if (arrival[narr].crust_corr_phase != '\0')
+                        crust_corr += arrival[narr].crust_corr_sta;
+                    arrival[narr].pred_travel_time += crust_corr;
+                }
                 //printf(" -> after: %f\n", arrival[narr].pred_travel_time);
             } else if (ApplyElevCorrFlag) {
 
@@ -14572,11 +16058,13 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
 
     while (nSamples < pParams->max_num_nodes) {
 
+        NLL_PROF_START(t_prof_oct);
         if (pParams->stop_on_min_node_size)
             presult_node = getHighestLeafValue(resultTreeRoot);
         else
             presult_node = getHighestLeafValueMinSize(resultTreeRoot,
                 min_node_size_x, min_node_size_y, min_node_size_z);
+        NLL_PROF_STOP(PROF_T_OCTTREE, t_prof_oct);
         // check if null node
         if (presult_node == NULL) {
             if (message_flag >= 1)
@@ -14634,7 +16122,9 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
                 }
 
                 // find neighbor node
+                NLL_PROF_START(t_prof_oct_neigh);
                 neighbor_node = getLeafNodeContaining(pOctTree, coords);
+                NLL_PROF_STOP(PROF_T_OCTTREE, t_prof_oct_neigh);
                 // outside of octTree volume
                 if (neighbor_node == NULL)
                     continue;
@@ -14645,7 +16135,9 @@ int LocOctree(int ngrid, int num_arr_total, int num_arr_loc,
 
 
             // subdivide node and evaluate solution at each child
+            NLL_PROF_START(t_prof_oct_sub);
             subdivide(neighbor_node, OCTREE_UNDEF_VALUE, NULL);
+            NLL_PROF_STOP(PROF_T_OCTTREE, t_prof_oct_sub);
 
             for (ix = 0; ix < 2; ix++) {
                 for (iy = 0; iy < 2; iy++) {
@@ -14849,8 +16341,11 @@ long double LocOctree_core(int ngrid, double xval, double yval, double zval,
 
     /* get travel times for observed arrivals */
     iAboveTopo = isAboveTopo(xval, yval, zval);
+    NLL_PROF_COUNT(PROF_C_SEARCH_NODES, 1);
     if (!iAboveTopo) {
+        NLL_PROF_START(t_prof_tt);
         nReject = getTravelTimes(arrival, num_arr_loc, xval, yval, zval);
+        NLL_PROF_STOP(PROF_T_TRAVEL_TIME, t_prof_tt);
         if (message_flag > 3 && nReject && GeometryMode != MODE_GLOBAL) {
             sprintf(MsgStr,
                     "WARNING: oct-tree sample at (%lf,%lf,%lf) is outside of %d travel time grids.",
@@ -14899,8 +16394,10 @@ long double LocOctree_core(int ngrid, double xval, double yval, double zval,
     double ot_variance_factor = 0.0;
     if (!iAboveTopo) { // not above topo
         double log_prior;
+        NLL_PROF_START(t_prof_like);
         value = CalcSolutionQuality(xval, yval, zval, poct_node, num_arr_loc, arrival, gauss_par, iGridType, misfit, NULL, NULL,
                 *cell_half_diagonal_time_range, *pdiagonal, volume, &effective_cell_size, &ot_variance_factor, &log_prior);
+        NLL_PROF_STOP(PROF_T_LIKELIHOOD, t_prof_like);
         /*        if (LocMethod == METH_OT_STACK) {
                     if (poct_node->parent != NULL) {
                         //value += (poct_node->parent->value - logWtMtrxSum);
@@ -14929,7 +16426,9 @@ long double LocOctree_core(int ngrid, double xval, double yval, double zval,
     log_value_volume += logStationDensityWeight;
     poct_node->value += logStationDensityWeight;
 
+    NLL_PROF_START(t_prof_oct);
     resultTreeRoot = addResult(resultTreeRoot, log_value_volume, volume, poct_node);
+    NLL_PROF_STOP(PROF_T_OCTTREE, t_prof_oct);
 
     /*static int icount_value = 0;
                                                                                                                                                                     if (icount_value < 10 && poct_node->value < -1.0e50) {
@@ -15064,30 +16563,31 @@ double getOctTreeStationDensityWeight_OLD2(OctNode* poct_node, SourceDesc *stati
 
 double getOctTreeStationDensityWeight(OctNode* poct_node, SourceDesc *stations, int numStations, GridDesc *ptgrid, int iOctLevelMax) {
 
-    int node_level, n, numStations_this_event;
+    int node_level;
     double log_station_density_weight, return_weight;
-    SourceDesc *station;
-    double epi_dist, depth_diff, hypo_dist, hypo_dist_min, cut_off_dist;
+    double hypo_dist_min, cut_off_dist;
     double x_node_cent, y_node_cent, z_node_cent, mean_node_horiz_ds;
     OctNode* pnode;
 
-    static double mean_root_node_horiz_ds = -VERY_LARGE_DOUBLE;
-    // !!! shoud be initialized for each event????
-
 
+    // get level of this node in tree
+    node_level = 0;
+    pnode = poct_node;
+    while (pnode->parent != NULL) {
+        pnode = pnode->parent;
+        node_level++;
+    }
 
-    if (mean_root_node_horiz_ds == -VERY_LARGE_DOUBLE) {
-        pnode = poct_node;
-        while (pnode->parent != NULL)
-            pnode = pnode->parent;
-        mean_root_node_horiz_ds = (pnode->ds.x + pnode->ds.y);
+    // 20261018 AJL - mean root node horizontal size is now set once for each event
+    if (MeanRootNodeHorizDs == -VERY_LARGE_DOUBLE) {
+        MeanRootNodeHorizDs = (pnode->ds.x + pnode->ds.y);
         if (GeometryMode == MODE_GLOBAL)
-            mean_root_node_horiz_ds *= DEG2KM;
-        sprintf(MsgStr, "Station Density Weight:  Mean Root Node Horiz dS: %lf", mean_root_node_horiz_ds);
+            MeanRootNodeHorizDs *= DEG2KM;
+        sprintf(MsgStr, "Station Density Weight:  Mean Root Node Horiz dS: %lf", MeanRootNodeHorizDs);
         nll_putmsg(1, MsgStr);
-    }
-    if (mean_root_node_horiz_ds < SMALL_DOUBLE) { // should not get here
-        nll_puterr("ERROR: cannot apply OctTree Station Density Weight: Mean Root Node Horiz dS is zero!");
+        if (MeanRootNodeHorizDs < SMALL_DOUBLE) { // should not get here
+            nll_puterr("ERROR: cannot apply OctTree Station Density Weight: Mean Root Node Horiz dS is zero!");
+        }
     }
 
 
@@ -15095,14 +16595,6 @@ double getOctTreeStationDensityWeight(OctNode* poct_node, SourceDesc *stations,
     log_station_density_weight = 0.0;
     return_weight = log_station_density_weight;
 
-    // get level of this node in tree
-    node_level = 0;
-    pnode = poct_node;
-    while (pnode->parent != NULL) {
-        pnode = pnode->parent;
-        node_level++;
-    }
-
 
     // node level dependent calculation
     if (node_level >= iOctLevelMax) {
@@ -15120,24 +16612,8 @@ double getOctTreeStationDensityWeight(OctNode* poct_node, SourceDesc *stations,
         x_node_cent = poct_node->center.x;
         y_node_cent = poct_node->center.y;
         z_node_cent = poct_node->center.z;
-        numStations_this_event = 0;
-        hypo_dist_min = VERY_LARGE_DOUBLE;
-        for (n = 0; n < numStations; n++) {
-            station = stations + n;
-            // check if station has ignored reading for this event
-            if (station->ignored)
-                continue;
-            numStations_this_event++;
-            // check if station location is unknown
-            if (station->x <= -LARGE_DOUBLE)
-                continue;
-            // get distance from station to center of node
-            epi_dist = GetEpiDist(station, x_node_cent, y_node_cent);
-            depth_diff = z_node_cent - station->z;
-            hypo_dist = sqrt(epi_dist * epi_dist + depth_diff * depth_diff);
-            hypo_dist_min = hypo_dist < hypo_dist_min ? hypo_dist : hypo_dist_min;
-            //printf("n %d  node %f %f %f  stations %f %f %f  ptgrid->origz %f\n", n, poct_node->center.x, poct_node->center.y, poct_node->center.z, station->x, station->y, station->z, ptgrid->origz);
-        }
+        // 20261018 AJL - nearest station search in spatial index of stations used for this event
+        hypo_dist_min = GetMinStationHypoDist(&OctTreeStationIndex, stations, x_node_cent, y_node_cent, z_node_cent);
         //if (ndist == 0) {	// should not get here
         //	nll_puterr("ERROR: no stations found for OctTree Station Density Weight calculation!");
         //}
@@ -29,7 +29,9 @@
         history:
 
         ver 01    12Dec2003  AJL  Original version
-
+                  20261018 AJL  Time grid lists for each station expanded once and time grids opened once for all events,
+                        small grids kept in memory; window of events associated in parallel (OpenMP),
+                        messages and output written in event order
 
 .........1.........2.........3.........4.........5.........6.........7.........8
 
@@ -38,23 +40,126 @@
 
 
 #include "GridLib.h"
+#include "nll_gridcache.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-/* defines */
+// 20261018 AJL - memory streams (open_memstream) needed to buffer messages of events associated in parallel
+#if defined(_GNU_SOURCE) || (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L)
+#define NLL_HAVE_MEMSTREAM
+#endif
 
-#define MAX_NUM_INPUT_FILES 4096
+
+/* defines */
 
 #define VERY_LARGE_RESIDUAL 999999.9
 
+// 20261018 AJL - number of events per thread associated together
+#define ASSOC_WINDOW_EVENTS_PER_THREAD 4
+
+// time grids up to this size are read into memory, values of larger grids are read from file
+#define ASSOC_GRID_MAX_RESIDENT_BYTES (16L * 1024L * 1024L)
+// maximum total size of time grids in memory, grids not used by the last window of events are freed above half this size
+#define ASSOC_GRID_MAX_TOTAL_RESIDENT_BYTES (1024L * 1024L * 1024L)
+
 
 /* globals */
 
 
 
+/* typedefs */
+
+/* time grid, header read once, grid values in memory if resident */
+typedef struct {
+    char fileroot[FILENAME_MAX]; // grid file root (no .buf/.hdr)
+    char phase_id[PHASE_LABEL_LEN]; // phase from grid file name
+    GridDesc grid;
+    int status; // 0 = not open, 1 = header read, 2 = resident in memory, -1 = cannot be opened
+    int iSwapBytes;
+    long resident_bytes;
+    int window; // last event window using this grid
+}
+AssocTimeGrid;
+
+/* list of candidate time grids */
+typedef struct {
+    int ngrids;
+    AssocTimeGrid *grids;
+}
+AssocGridList;
+
+/* candidate time grid list for a station label */
+typedef struct {
+    char label[ARRIVAL_LABEL_LEN];
+    AssocGridList *plist; // station list, or default list if no station grids
+}
+AssocStation;
+
+/* time grid cache for all events */
+typedef struct {
+    char fn_loc_grids[FILENAME_MAX]; // time grid root
+    int iTryStationGrids;
+    int iSwapBytes;
+    AssocGridList *default_list; // DEFAULT time grids, NULL if not yet expanded
+    AssocGridList **lists; // all lists, owned by cache
+    int nlists;
+    AssocStation *stations; // sorted by label
+    int nstations, max_stations;
+    long resident_bytes;
+    int window; // current event window
+}
+AssocGridCache;
+
+/* association parameters */
+typedef struct {
+    double residual_max;
+    int i_shift_obs_time;
+    double max_time_shift_res;
+    int iWriteAll;
+}
+AssocParams;
+
+/* event waiting to be associated and written */
+typedef struct {
+    char fn_hyp[FILENAME_MAX];
+    HypoDesc hypo;
+    GridDesc locgrid;
+    ArrivalDesc *arrivals;
+    int narrivals;
+    char map_proj_str[2 * MAXLINE]; // TRANSFORM of event, MapProjStr is overwritten by GetHypLoc()
+    AssocGridList **grid_lists; // candidate time grids for each arrival, NULL if arrival is not associated
+    int associate; // 0 if observations rejected
+    int nPhaseIDChanged, nZeroWeight, nTimeShifted;
+    FILE *fp_msg; // event messages, written to stdout in event order
+    char *msg;
+    size_t msg_size;
+}
+AssocEvent;
+
+/* totals over all events */
+typedef struct {
+    int nEventsChanged;
+    int nPhaseIDChanged_total;
+    int nTimeShifted_total;
+}
+AssocTotals;
+
+
 /* functions */
 
 int AssociatePhases(int argc, char** argv);
-int CalcObsTravelTimes(ArrivalDesc *arrival, int num_arrivals, HypoDesc* phypo);
+int CalcObsTravelTimes(FILE *fp_msg, ArrivalDesc *arrival, int num_arrivals, HypoDesc* phypo);
+AssocGridList *GetAssocGridList(AssocGridCache *pcache, char *label);
+int PrepareAssocGrid(AssocGridCache *pcache, AssocTimeGrid *ptgrid);
+void ReleaseAssocGrid(AssocGridCache *pcache, AssocTimeGrid *ptgrid);
+void EvictAssocGrids(AssocGridCache *pcache);
+void FreeAssocGridCache(AssocGridCache *pcache);
+double ReadAssocTravelTime(AssocTimeGrid *ptgrid, ArrivalDesc *parrival, HypoDesc *phypo);
+void AssociateEvent(AssocEvent *pevent, AssocParams *pparams);
+void WriteAssocEvent(AssocEvent *pevent, AssocParams *pparams, AssocTotals *ptotals);
+void ProcessAssocWindow(AssocGridCache *pcache, AssocEvent *window, int nwindow, AssocParams *pparams, AssocTotals *ptotals);
 
 
 /*** program to sum event scatter files */
@@ -113,93 +218,83 @@ int main(int argc, char** argv) {
 
 int AssociatePhases(int argc, char** argv) {
 
-    int narg;
-
-    int iTryStationGrids, iWriteAll;
-    double residual_max;
+    int narg, nArr;
 
     int istat;
-    int nArr, nTimeGrid;
-    int nPhaseIDChanged, nPhaseIDChanged_total, nZeroWeight;
-    int nEventsRead, nEventsChanged, nEventsOutside;
-    int numFiles1, numFiles2;
+    int narrivals;
+    int nEventsRead, nEventsOutside;
 
     char fn_hyp[FILENAME_MAX];
-    char fn_loc_grids[FILENAME_MAX], fn_loc_grids1[FILENAME_MAX], fn_loc_grids2[FILENAME_MAX];
-    char fn_hyp_out[FILENAME_MAX];
-
-    char fn_loc_grids_list[MAX_NUM_INPUT_FILES][FILENAME_MAX];
-
-    char *pchr0, *pchr1;
-    char tmp_str[FILENAME_MAX];
-    char best_phase_id[PHASE_LABEL_LEN];
-    char strtmp[PHASE_LABEL_LEN];
-    char arrival_phase_id[PHASE_LABEL_LEN];
-    char original_arrival_phase_id[PHASE_LABEL_LEN];
-    char eval_phase[PHASE_LABEL_LEN];
-    char prev_phase_id[PHASE_LABEL_LEN];
-
-    FILE *fp_hyp_out;
-    FILE *fp_grid, *fp_hdr;
-
-    double obs_travel_time, pred_travel_time, best_pred_travel_time;
-    double residual, orig_residual, best_residual;
-    double yval_grid;
+    char map_proj_str[2 * MAXLINE];
+    char *pchr0;
 
-    // 20160930 AJL - support for "correcting" observed time by multiples of 60s, etc.
-    int i_shift_obs_time, i_same_phase;
-    double max_time_shift_res;
-    double best_time_shift, time_shift;
-    double sign_residual;
-    int nTimeShifted_total, nTimeShifted;
-    char time_grid_phase_id[PHASE_LABEL_LEN];
-
-    GridDesc Grid, locgrid;
-    SourceDesc Srce;
+    GridDesc locgrid;
     HypoDesc Hypo;
 
+    AssocParams params;
+    AssocTotals totals;
+    AssocGridCache cache;
+    AssocEvent *pevent;
+
 
     // get command line parameters
 
     narg = 1;
 
-    residual_max = VERY_LARGE_RESIDUAL;
-    sscanf(argv[narg], "%lf", &residual_max);
+    params.residual_max = VERY_LARGE_RESIDUAL;
+    sscanf(argv[narg], "%lf", &params.residual_max);
     narg++;
 
-    i_shift_obs_time = 0;
-    sscanf(argv[narg], "%d", &i_shift_obs_time);
+    params.i_shift_obs_time = 0;
+    sscanf(argv[narg], "%d", &params.i_shift_obs_time);
     narg++;
 
-    max_time_shift_res = 0.0;
-    sscanf(argv[narg], "%lf", &max_time_shift_res);
+    params.max_time_shift_res = 0.0;
+    sscanf(argv[narg], "%lf", &params.max_time_shift_res);
     narg++;
 
-    Grid.iSwapBytes = 0;
-    sscanf(argv[narg], "%d", &(Grid.iSwapBytes));
+    memset(&cache, 0, sizeof (AssocGridCache));
+    cache.iSwapBytes = 0;
+    sscanf(argv[narg], "%d", &cache.iSwapBytes);
     narg++;
 
-    iTryStationGrids = 1;
-    sscanf(argv[narg], "%d", &iTryStationGrids);
+    cache.iTryStationGrids = 1;
+    sscanf(argv[narg], "%d", &cache.iTryStationGrids);
     narg++;
 
-    iWriteAll = 1;
-    sscanf(argv[narg], "%d", &iWriteAll);
+    params.iWriteAll = 1;
+    sscanf(argv[narg], "%d", &params.iWriteAll);
     narg++;
 
-    strcpy(fn_loc_grids, argv[narg]);
+    strcpy(cache.fn_loc_grids, argv[narg]);
     narg++;
 
 
     PhaseFormat = FORMAT_PHASE_2; // 20160922 AJL - to allow long station names
 
+    // 20261018 AJL - window of events, arrivals associated in parallel, then events written in order
+    //    without memory streams messages cannot be buffered, events are processed one at a time
+    int num_window = 1;
+#ifdef NLL_HAVE_MEMSTREAM
+    num_window = ASSOC_WINDOW_EVENTS_PER_THREAD;
+#ifdef _OPENMP
+    num_window *= omp_get_max_threads();
+#endif
+#endif
+    int nwindow = 0;
+    AssocEvent *window;
+    if ((window = calloc(num_window, sizeof (AssocEvent))) == NULL) {
+        nll_puterr("ERROR: allocating event window.");
+        return (-1);
+    }
+
     // associate each NLL hypo file
 
     nEventsRead = 0;
-    nPhaseIDChanged_total = 0;
-    nTimeShifted_total = 0;
-    nEventsChanged = 0;
     nEventsOutside = 0;
+    totals.nEventsChanged = 0;
+    totals.nPhaseIDChanged_total = 0;
+    totals.nTimeShifted_total = 0;
 
     for (; narg < argc; narg++) {
 
@@ -209,329 +304,746 @@ int AssociatePhases(int argc, char** argv) {
         pchr0 = strstr(fn_hyp, ".hyp");
         if (pchr0 != NULL)
             *pchr0 = '\0';
-        istat = GetHypLoc(NULL, fn_hyp, &Hypo, Arrival, &NumArrivals, 1, &locgrid, 0);
+        narrivals = -1;
+        istat = GetHypLoc(NULL, fn_hyp, &Hypo, Arrival, &narrivals, 1, &locgrid, 0);
+        if (narrivals >= 0)
+            NumArrivals = narrivals;
 
         if (istat < 0) {
             nll_puterr2("ERROR: opening NLL hypocenter-phase file.", fn_hyp);
             continue;
         }
-        fprintf(stdout,
+
+        if (narrivals < 0 && nwindow > 0) {
+            // no PHASE block, arrivals of previous event are used, as for sequential processing previous events must be associated first
+            strcpy(map_proj_str, MapProjStr[0]);
+            ProcessAssocWindow(&cache, window, nwindow, &params, &totals);
+            nwindow = 0;
+            strcpy(MapProjStr[0], map_proj_str);
+        }
+
+        pevent = window + nwindow;
+        memset(pevent, 0, sizeof (AssocEvent));
+        strcpy(pevent->fn_hyp, fn_hyp);
+
+#ifdef NLL_HAVE_MEMSTREAM
+        if ((pevent->fp_msg = open_memstream(&pevent->msg, &pevent->msg_size)) == NULL) {
+            nll_puterr("ERROR: opening event message stream.");
+            return (-1);
+        }
+#else
+        pevent->fp_msg = stdout;
+#endif
+
+        fprintf(pevent->fp_msg,
                 "NLL hypocenter-phase file: %s\n", fn_hyp);
 
         nEventsRead++;
 
         if (0 && !IsPointInsideGrid(&locgrid, Hypo.x, Hypo.y, Hypo.z)) {
-            fprintf(stdout,
+            fprintf(pevent->fp_msg,
                     "Outside grid, ignoring event: %s\n", fn_hyp);
             nEventsOutside++;
+            nwindow++;
             continue;
         }
 
         if (isOnGridBoundary(Hypo.x, Hypo.y, Hypo.z, &locgrid, locgrid.dx, locgrid.dz, 0)) {
-            fprintf(stdout,
+            fprintf(pevent->fp_msg,
                     "WARNING: Event on grid boundary: %s\n", fn_hyp);
         }
 
-        if (CalcObsTravelTimes(Arrival, NumArrivals, &Hypo) < 0)
-            continue;
+        if (CalcObsTravelTimes(pevent->fp_msg, Arrival, NumArrivals, &Hypo) >= 0) {
+
+            pevent->associate = 1;
+            pevent->hypo = Hypo;
+            pevent->locgrid = locgrid;
+            strcpy(pevent->map_proj_str, MapProjStr[0]);
+            pevent->narrivals = NumArrivals;
+            pevent->arrivals = malloc((size_t) (NumArrivals > 0 ? NumArrivals : 1) * sizeof (ArrivalDesc));
+            pevent->grid_lists = calloc((size_t) (NumArrivals > 0 ? NumArrivals : 1), sizeof (AssocGridList *));
+            if (pevent->arrivals == NULL || pevent->grid_lists == NULL) {
+                nll_puterr("ERROR: allocating event arrivals.");
+                return (-1);
+            }
+            memcpy(pevent->arrivals, Arrival, (size_t) NumArrivals * sizeof (ArrivalDesc));
+
+            // check transform type
+            if (strstr(MapProjStr[0], "GLOBAL") != NULL && GeometryMode != MODE_GLOBAL) {
+                // events already in window are associated and written with current geometry mode
+                if (nwindow > 0) {
+                    ProcessAssocWindow(&cache, window, nwindow, &params, &totals);
+#ifdef NLL_HAVE_MEMSTREAM
+                    // message stream is bound to msg and msg_size of its slot, move messages to a stream on new slot
+                    fclose(pevent->fp_msg);
+                    char *msg = pevent->msg;
+#endif
+                    memcpy(window, pevent, sizeof (AssocEvent));
+                    pevent = window;
+#ifdef NLL_HAVE_MEMSTREAM
+                    pevent->msg = NULL;
+                    pevent->msg_size = 0;
+                    if ((pevent->fp_msg = open_memstream(&pevent->msg, &pevent->msg_size)) == NULL) {
+                        nll_puterr("ERROR: opening event message stream.");
+                        return (-1);
+                    }
+                    if (msg != NULL)
+                        fputs(msg, pevent->fp_msg);
+                    free(msg);
+#endif
+                    nwindow = 0;
+                    strcpy(MapProjStr[0], pevent->map_proj_str);
+                }
+                GeometryMode = MODE_GLOBAL;
+            }
 
-        // check transform type
-        if (strstr(MapProjStr[0], "GLOBAL") != NULL)
-            GeometryMode = MODE_GLOBAL;
+            // get candidate time grids for each arrival
+            for (nArr = 0; nArr < pevent->narrivals; nArr++) {
+                // check for fixed phase type (inst begins with '+') or no absolute timing (inst begins with '*')
+                // do not change arrival
+                if (pevent->arrivals[nArr].inst[0] == '+' || pevent->arrivals[nArr].inst[0] == '*')
+                    continue;
+                pevent->grid_lists[nArr] = GetAssocGridList(&cache, pevent->arrivals[nArr].label);
+            }
 
+        }
 
-        nPhaseIDChanged = 0;
-        nZeroWeight = 0;
-        nTimeShifted = 0;
-        for (nArr = 0; nArr < NumArrivals; nArr++) {
+        nwindow++;
+        if (nwindow == num_window) {
+            ProcessAssocWindow(&cache, window, nwindow, &params, &totals);
+            nwindow = 0;
+        }
 
-            //WriteArrival(stdout, Arrival + nArr, IO_ARRIVAL_ALL);
+    }
+    ProcessAssocWindow(&cache, window, nwindow, &params, &totals);
 
-            // check for fixed phase type (inst begins with '+')
-            // do not change arrival
-            if (Arrival[nArr].inst[0] == '+')
-                continue;
+    free(window);
+    FreeAssocGridCache(&cache);
 
-            // check for no absolute timing (inst begins with '*')
-            // do not change arrival
-            if (Arrival[nArr].inst[0] == '*')
-                continue;
+    // write message
+    fprintf(stdout,
+            "\n%d events read, %d outside grid, %d changed, %d phases changed, %d time shifted.\n",
+            nEventsRead, nEventsOutside, totals.nEventsChanged, totals.nPhaseIDChanged_total, totals.nTimeShifted_total);
 
-            //obs_travel_time = Arrival[nArr].obs_travel_time;
-            obs_travel_time = Arrival[nArr].obs_time - Hypo.time;
-            orig_residual = Arrival[nArr].residual;
-            best_residual = VERY_LARGE_RESIDUAL;
-            strcpy(prev_phase_id, Arrival[nArr].phase);
-            // store original phase name in inst if not set
-            if (strcmp(Arrival[nArr].inst, "?") == 0) {
-                strcpy(Arrival[nArr].inst, prev_phase_id);
-                strcpy(original_arrival_phase_id, prev_phase_id);
-            } else {
-                strcpy(original_arrival_phase_id, Arrival[nArr].inst);
-            }
-            strcpy(best_phase_id, Arrival[nArr].phase);
-            // remove zero weight phase tag
-            if (best_phase_id[0] == '*') {
-                strcpy(strtmp, best_phase_id + 1);
-                strcpy(best_phase_id, strtmp);
-                best_residual = VERY_LARGE_RESIDUAL;
-            }
+    return (totals.nEventsChanged);
 
-            // get list of time grid files for this station
-            numFiles1 = 0;
-            if (iTryStationGrids) {
-                sprintf(fn_loc_grids1, "%s.*.%s.time.buf", fn_loc_grids, Arrival[nArr].label);
-                if ((numFiles1 = ExpandWildCards(fn_loc_grids1,
-                        fn_loc_grids_list, MAX_NUM_INPUT_FILES)) < 0) {
-                    nll_puterr("ERROR: getting list of station specific time grid files.");
-                    numFiles1 = 0;
-                }
-            }
-            if (numFiles1 == 0) {
-                // if no station grid, get list of default time grid files
-                sprintf(fn_loc_grids2, "%s.*.DEFAULT.time.buf", fn_loc_grids);
-                if ((numFiles2 = ExpandWildCards(fn_loc_grids2,
-                        fn_loc_grids_list + numFiles1, MAX_NUM_INPUT_FILES - numFiles1)) < 0) {
+}
+
+/** function to compare station labels */
+
+int compareAssocStation(const void *p1, const void *p2) {
+
+    return (strcmp(((const AssocStation *) p1)->label, ((const AssocStation *) p2)->label));
+
+}
+
+/** function to expand wildcard time grid file name to list of time grids
+ *
+ *  returns list, NULL on error or if no grid files found
+ */
+
+AssocGridList *ExpandAssocGridList(AssocGridCache *pcache, char *fn_filter) {
+
+    int n, nfiles;
+    char **fileList;
+    char *pchr0, *pchr1;
+    char tmp_str[FILENAME_MAX];
+    AssocGridList *plist;
+    AssocTimeGrid *ptgrid;
+
+    if ((nfiles = ExpandWildCardsList(fn_filter, &fileList)) <= 0)
+        return (NULL);
+
+    if ((plist = calloc(1, sizeof (AssocGridList))) == NULL
+            || (plist->grids = calloc(nfiles, sizeof (AssocTimeGrid))) == NULL
+            || (pcache->lists = realloc(pcache->lists, (pcache->nlists + 1) * sizeof (AssocGridList *))) == NULL) {
+        nll_puterr("ERROR: allocating time grid list.");
+        FreeWildCardsList(fileList, nfiles);
+        exit(EXIT_ERROR_MEMORY);
+    }
+    pcache->lists[pcache->nlists++] = plist;
+
+    for (n = 0; n < nfiles; n++) {
+        ptgrid = plist->grids + n;
+        strcpy(ptgrid->fileroot, fileList[n]);
+        pchr0 = strstr(ptgrid->fileroot, ".buf");
+        if (pchr0 != NULL)
+            *pchr0 = '\0';
+        // phase id: <root>.<phase>.<station>.time
+        strcpy(tmp_str, ptgrid->fileroot);
+        if ((pchr1 = strrchr(tmp_str, '.')) != NULL)
+            *pchr1 = '\0';
+        if ((pchr1 = strrchr(tmp_str, '.')) != NULL)
+            *pchr1 = '\0';
+        pchr1 = strrchr(tmp_str, '.');
+        strcpy(ptgrid->phase_id, pchr1 != NULL ? pchr1 + 1 : tmp_str);
+        ptgrid->window = -1;
+    }
+    plist->ngrids = nfiles;
+
+    FreeWildCardsList(fileList, nfiles);
+
+    return (plist);
+
+}
+
+/** function to get list of candidate time grids for a station, list is expanded on first request for station
+ *
+ *  station specific time grids are used if available, otherwise DEFAULT time grids
+ */
+
+AssocGridList *GetAssocGridList(AssocGridCache *pcache, char *label) {
+
+    int n;
+    char fn_filter[FILENAME_MAX];
+    AssocStation key, *pstation;
+    AssocGridList *plist;
+
+    strcpy(key.label, label);
+    pstation = bsearch(&key, pcache->stations, pcache->nstations, sizeof (AssocStation), compareAssocStation);
+
+    if (pstation != NULL) {
+        plist = pstation->plist;
+    } else {
+        // get list of time grid files for this station
+        plist = NULL;
+        if (pcache->iTryStationGrids) {
+            snprintf(fn_filter, sizeof (fn_filter), "%s.*.%s.time.buf", pcache->fn_loc_grids, label);
+            if ((plist = ExpandAssocGridList(pcache, fn_filter)) == NULL)
+                nll_puterr2("ERROR: getting list of station specific time grid files for station", label);
+        }
+        if (plist == NULL) {
+            // if no station grid, get list of default time grid files
+            if (pcache->default_list == NULL) {
+                snprintf(fn_filter, sizeof (fn_filter), "%s.*.DEFAULT.time.buf", pcache->fn_loc_grids);
+                if ((pcache->default_list = ExpandAssocGridList(pcache, fn_filter)) == NULL) {
                     nll_puterr("ERROR: getting list of DEFAULT time grid files.");
-                    numFiles2 = 0;
+                    if ((pcache->default_list = calloc(1, sizeof (AssocGridList))) == NULL) {
+                        nll_puterr("ERROR: allocating time grid list.");
+                        exit(EXIT_ERROR_MEMORY);
+                    }
+                    pcache->lists = realloc(pcache->lists, (pcache->nlists + 1) * sizeof (AssocGridList *));
+                    pcache->lists[pcache->nlists++] = pcache->default_list;
                 }
-            } else {
-                numFiles2 = 0;
             }
-            if (numFiles1 + numFiles2 >= MAX_NUM_INPUT_FILES) {
-                sprintf(MsgStr, "WARNING: maximum number of travel-time files exceeded, only first %d will be processed.", MAX_NUM_INPUT_FILES);
-                nll_puterr(MsgStr);
+            plist = pcache->default_list;
+        }
+        // add station, keep sorted
+        if (pcache->nstations == pcache->max_stations) {
+            pcache->max_stations = pcache->max_stations > 0 ? 2 * pcache->max_stations : 256;
+            if ((pcache->stations = realloc(pcache->stations, pcache->max_stations * sizeof (AssocStation))) == NULL) {
+                nll_puterr("ERROR: allocating station list.");
+                exit(EXIT_ERROR_MEMORY);
             }
+        }
+        for (n = pcache->nstations; n > 0 && strcmp(pcache->stations[n - 1].label, label) > 0; n--)
+            pcache->stations[n] = pcache->stations[n - 1];
+        strcpy(pcache->stations[n].label, label);
+        pcache->stations[n].plist = plist;
+        pcache->nstations++;
+    }
 
-            best_pred_travel_time = -1.0;
-            best_time_shift = 0.0;
-            for (nTimeGrid = 0; nTimeGrid < numFiles1 + numFiles2; nTimeGrid++) {
-                // open next time grid file
-                pchr0 = strstr(fn_loc_grids_list[nTimeGrid], ".buf");
-                if (pchr0 != NULL)
-                    *pchr0 = '\0';
-                if ((istat = OpenGrid3dFile(fn_loc_grids_list[nTimeGrid], &fp_grid, &fp_hdr,
-                        &Grid, "time", &Srce, Grid.iSwapBytes)) < 0) {
-                    snprintf(MsgStr, sizeof(MsgStr), "%s.*", fn_loc_grids_list[nTimeGrid]);
-                    nll_puterr2("ERROR: opening grid file", MsgStr);
-                    continue;
-                }
-                if (Arrival[nArr].gdesc.type == GRID_TIME) {
-                    pred_travel_time = (double) ReadAbsInterpGrid3d(fp_grid, &Grid, Hypo.x, Hypo.y, Hypo.z, 0);
-                } else {
-                    yval_grid = GetEpiDist(&(Arrival[nArr].station), Hypo.x, Hypo.y);
-                    if (GeometryMode == MODE_GLOBAL)
-                        yval_grid *= KM2DEG;
-                    pred_travel_time = ReadAbsInterpGrid2d(fp_grid, &Grid, yval_grid, Hypo.z);
-                }
-                CloseGrid3dFile(&Grid, &fp_grid, &fp_hdr);
-                if (pred_travel_time < 0.0)
-                    continue;
-                // check for smallest residual so far, maybe time shift
-                pchr0 = fn_loc_grids_list[nTimeGrid];
-                pchr1 = strrchr(pchr0, '.');
-                strncpy(tmp_str, pchr0, pchr1 - pchr0);
-                pchr1 = strrchr(tmp_str, '.');
-                *pchr1 = '\0';
-                pchr1 = strrchr(tmp_str, '.');
-                strcpy(time_grid_phase_id, pchr1 + 1);
-                if (Arrival[nArr].phase[0] == '*') {
-                    strcpy(arrival_phase_id, Arrival[nArr].phase + 1);
-                } else {
-                    strcpy(arrival_phase_id, Arrival[nArr].phase);
-                }
+    // time grids read now, so that only read-only access is needed during association
+    for (n = 0; n < plist->ngrids; n++)
+        PrepareAssocGrid(pcache, plist->grids + n);
+
+    return (plist);
+
+}
+
+/** function to open time grid and read header, read grid into memory if small enough
+ *
+ *  returns 0, or -1 if grid cannot be used
+ */
+
+int PrepareAssocGrid(AssocGridCache *pcache, AssocTimeGrid *ptgrid) {
+
+    FILE *fp_grid, *fp_hdr;
+    SourceDesc Srce;
+    GridDesc *pgrid = &ptgrid->grid;
+    long grid_bytes;
+
+    ptgrid->window = pcache->window;
+    ptgrid->iSwapBytes = pcache->iSwapBytes;
+
+    if (ptgrid->status != 0)
+        return (ptgrid->status < 0 ? -1 : 0);
+
+    if (OpenGrid3dFile(ptgrid->fileroot, &fp_grid, &fp_hdr, pgrid, "time", &Srce, pcache->iSwapBytes) < 0) {
+        snprintf(MsgStr, sizeof (MsgStr), "%s.*", ptgrid->fileroot);
+        nll_puterr2("ERROR: opening grid file", MsgStr);
+        ptgrid->status = -1;
+        return (-1);
+    }
+    if (fp_grid == NULL) {
+        snprintf(MsgStr, sizeof (MsgStr), "%s.buf", ptgrid->fileroot);
+        nll_puterr2("ERROR: opening grid file", MsgStr);
+        CloseGrid3dFile(pgrid, &fp_grid, &fp_hdr);
+        ptgrid->status = -1;
+        return (-1);
+    }
+    ptgrid->status = 1;
+
+    grid_bytes = (long) pgrid->numx * (long) pgrid->numy * (long) pgrid->numz * (long) sizeof (GRID_FLOAT_TYPE);
+    if (grid_bytes <= ASSOC_GRID_MAX_RESIDENT_BYTES
+            && pcache->resident_bytes + grid_bytes <= ASSOC_GRID_MAX_TOTAL_RESIDENT_BYTES) {
+        // read grid into memory
+        if (AllocateGrid(pgrid) == NULL || CreateGridArray(pgrid) == NULL || ReadGrid3dBuf(pgrid, fp_grid) < 0) {
+            nll_puterr2("ERROR: reading grid file", ptgrid->fileroot);
+            DestroyGridArray(pgrid);
+            pgrid->array = NULL;
+            FreeGrid(pgrid);
+            ptgrid->status = -1;
+        } else {
+            ptgrid->status = 2;
+            ptgrid->resident_bytes = grid_bytes;
+            pcache->resident_bytes += grid_bytes;
+        }
+    } else if (isCascadingGrid(pgrid)) {
+        // grid values read from file, cascading grid index arrays needed to find values in file
+        AllocateGrid_Cascading(pgrid, 0);
+        CreateGridArray(pgrid);
+    }
+
+    CloseGrid3dFile(pgrid, &fp_grid, &fp_hdr);
+
+    return (ptgrid->status < 0 ? -1 : 0);
+
+}
+
+/** function to free grid memory, grid will be reopened if needed again */
+
+void ReleaseAssocGrid(AssocGridCache *pcache, AssocTimeGrid *ptgrid) {
+
+    if (ptgrid->status <= 0)
+        return;
+
+    DestroyGridArray(&ptgrid->grid);
+    ptgrid->grid.array = NULL;
+    FreeGrid(&ptgrid->grid);
+    pcache->resident_bytes -= ptgrid->resident_bytes;
+    ptgrid->resident_bytes = 0;
+    ptgrid->status = 0;
+
+}
+
+/** function to free grids not used by current window of events if grid memory more than half full */
+
+void EvictAssocGrids(AssocGridCache *pcache) {
+
+    int nlist, n;
+    AssocGridList *plist;
+
+    if (pcache->resident_bytes > ASSOC_GRID_MAX_TOTAL_RESIDENT_BYTES / 2) {
+        for (nlist = 0; nlist < pcache->nlists; nlist++) {
+            plist = pcache->lists[nlist];
+            for (n = 0; n < plist->ngrids; n++) {
+                if (plist->grids[n].window < pcache->window)
+                    ReleaseAssocGrid(pcache, plist->grids + n);
+            }
+        }
+    }
+
+    pcache->window++;
+
+}
+
+/** function to free all grids and lists */
+
+void FreeAssocGridCache(AssocGridCache *pcache) {
+
+    int nlist, n;
+    AssocGridList *plist;
+
+    for (nlist = 0; nlist < pcache->nlists; nlist++) {
+        plist = pcache->lists[nlist];
+        for (n = 0; n < plist->ngrids; n++)
+            ReleaseAssocGrid(pcache, plist->grids + n);
+        free(plist->grids);
+        free(plist);
+    }
+    free(pcache->lists);
+    free(pcache->stations);
+    memset(pcache, 0, sizeof (AssocGridCache));
+
+    // close grid files of grids not in memory
+    FreeGridFileCache();
+
+}
+
+/** function to get predicted travel time at hypocenter from time grid
+ *
+ *  reads from grid in memory, or from shared cached grid file (see nll_gridcache.h), so may be called in parallel
+ */
+
+double ReadAssocTravelTime(AssocTimeGrid *ptgrid, ArrivalDesc *parrival, HypoDesc *phypo) {
+
+    FILE *fp_grid = NULL;
+    GridFileHandle *phandle = NULL;
+    double yval_grid, pred_travel_time;
+
+    if (ptgrid->status == 1) {
+        // grid file opened once and kept open in grid file cache, reads from file are serialized by handle lock
+        if ((phandle = OpenCachedGrid3dFile(ptgrid->fileroot, "time", ptgrid->iSwapBytes)) == NULL)
+            return (-1.0);
+        LockCachedGrid3dFile(phandle);
+        if ((fp_grid = phandle->fp_grid) == NULL) {
+            UnlockCachedGrid3dFile(phandle);
+            CloseCachedGrid3dFile(phandle);
+            return (-1.0);
+        }
+    }
+
+    if (parrival->gdesc.type == GRID_TIME) {
+        pred_travel_time = (double) ReadAbsInterpGrid3d(fp_grid, &ptgrid->grid, phypo->x, phypo->y, phypo->z, 0);
+    } else {
+        yval_grid = GetEpiDist(&(parrival->station), phypo->x, phypo->y);
+        if (GeometryMode == MODE_GLOBAL)
+            yval_grid *= KM2DEG;
+        pred_travel_time = ReadAbsInterpGrid2d(fp_grid, &ptgrid->grid, yval_grid, phypo->z);
+    }
+
+    if (phandle != NULL) {
+        UnlockCachedGrid3dFile(phandle);
+        CloseCachedGrid3dFile(phandle);
+    }
+
+    return (pred_travel_time);
+
+}
+
+/** function to associate arrivals of an event with the phase of the time grid giving smallest residual */
+
+void AssociateEvent(AssocEvent *pevent, AssocParams *pparams) {
+
+    int nArr, nTimeGrid;
+    int nPhaseIDChanged, nZeroWeight;
+
+    char tmp_str[FILENAME_MAX];
+    char best_phase_id[PHASE_LABEL_LEN];
+    char strtmp[PHASE_LABEL_LEN];
+    char arrival_phase_id[PHASE_LABEL_LEN];
+    char original_arrival_phase_id[PHASE_LABEL_LEN];
+    char eval_phase[PHASE_LABEL_LEN];
+    char prev_phase_id[PHASE_LABEL_LEN];
+
+    double obs_travel_time, pred_travel_time, best_pred_travel_time;
+    double residual, orig_residual, best_residual;
+
+    // 20160930 AJL - support for "correcting" observed time by multiples of 60s, etc.
+    int i_same_phase;
+    double best_time_shift, time_shift;
+    double sign_residual;
+    int nTimeShifted;
+    char *time_grid_phase_id;
+
+    double residual_max = pparams->residual_max;
+    double max_time_shift_res = pparams->max_time_shift_res;
+    int i_shift_obs_time = pparams->i_shift_obs_time;
+
+    FILE *fp_msg = pevent->fp_msg;
+    ArrivalDesc *Arrival = pevent->arrivals; // hides global Arrival
+    HypoDesc *phypo = &pevent->hypo;
+    AssocGridList *plist;
+
+
+    nPhaseIDChanged = 0;
+    nZeroWeight = 0;
+    nTimeShifted = 0;
+    for (nArr = 0; nArr < pevent->narrivals; nArr++) {
+
+        //WriteArrival(stdout, Arrival + nArr, IO_ARRIVAL_ALL);
+
+        // arrivals with fixed phase type (inst begins with '+') or no absolute timing (inst begins with '*')
+        // have no grid list, do not change arrival
+        if ((plist = pevent->grid_lists[nArr]) == NULL)
+            continue;
+
+        //obs_travel_time = Arrival[nArr].obs_travel_time;
+        obs_travel_time = Arrival[nArr].obs_time - phypo->time;
+        orig_residual = Arrival[nArr].residual;
+        best_residual = VERY_LARGE_RESIDUAL;
+        strcpy(prev_phase_id, Arrival[nArr].phase);
+        // store original phase name in inst if not set
+        if (strcmp(Arrival[nArr].inst, "?") == 0) {
+            strcpy(Arrival[nArr].inst, prev_phase_id);
+            strcpy(original_arrival_phase_id, prev_phase_id);
+        } else {
+            strcpy(original_arrival_phase_id, Arrival[nArr].inst);
+        }
+        strcpy(best_phase_id, Arrival[nArr].phase);
+        // remove zero weight phase tag
+        if (best_phase_id[0] == '*') {
+            strcpy(strtmp, best_phase_id + 1);
+            strcpy(best_phase_id, strtmp);
+            best_residual = VERY_LARGE_RESIDUAL;
+        }
+
+        best_pred_travel_time = -1.0;
+        best_time_shift = 0.0;
+        for (nTimeGrid = 0; nTimeGrid < plist->ngrids; nTimeGrid++) {
+            // time grids that could not be opened were reported when grid list was prepared
+            if (plist->grids[nTimeGrid].status <= 0)
+                continue;
+            pred_travel_time = ReadAssocTravelTime(plist->grids + nTimeGrid, Arrival + nArr, phypo);
+            if (pred_travel_time < 0.0)
+                continue;
+            // check for smallest residual so far, maybe time shift
+            time_grid_phase_id = plist->grids[nTimeGrid].phase_id;
+            if (Arrival[nArr].phase[0] == '*') {
+                strcpy(arrival_phase_id, Arrival[nArr].phase + 1);
+            } else {
+                strcpy(arrival_phase_id, Arrival[nArr].phase);
+            }
 #define DEBUG_STATION "DJA"
-                // check if arrival phase is same as time grid phase
+            // check if arrival phase is same as time grid phase
+            i_same_phase = 0;
+            if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0) {
+                EvalPhaseID(eval_phase, arrival_phase_id);
+                fprintf(fp_msg, "DEBUG: %s %s %s %s sec=%f time_grid_phase_id %s arrival_phase_id %s eval_phase %s ",
+                        Arrival[nArr].label, Arrival[nArr].inst, Arrival[nArr].comp, prev_phase_id, Arrival[nArr].sec, time_grid_phase_id, arrival_phase_id, eval_phase);
+            }
+            if (strcmp(arrival_phase_id, time_grid_phase_id) == 0) {
+                i_same_phase = 1;
+                if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0)
+                    fprintf(fp_msg, "-> (strcmp(arrival_phase_id, time_grid_phase_id) == 0) -> i_same_phase");
+            } else {
+                // apply LOCPHASEID
+                // TODO: does nothing, because LOCPHASEID not available to PhsAssoc !
+                /*EvalPhaseID(eval_phase, arrival_phase_id);
+                if (strcmp(eval_phase, time_grid_phase_id) == 0) {
+                    i_same_phase = 1;
+                    if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0)
+                        fprintf(fp_msg, "-> (strcmp(eval_phase, time_grid_phase_id) == 0) -> i_same_phase");
+                } */
+                // CLUGE: add  a few obvious equivalences
+                /*if (strstr("P p Pn Pg P0 P1 Pb", arrival_phase_id) != NULL && strstr("P p Pn Pg P0 P1 Pb", time_grid_phase_id) != NULL)
+                    i_same_phase = 1;
+                else if (strstr("S s Sn Sg", arrival_phase_id) != NULL && strstr("S s Sn Sg", time_grid_phase_id) != NULL)
+                    i_same_phase = 1;*/
+            }
+            // check if arrival phase is also same as original phase
+            if (i_same_phase) {
                 i_same_phase = 0;
-                if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0) {
-                    EvalPhaseID(eval_phase, arrival_phase_id);
-                    fprintf(stdout, "DEBUG: %s %s %s %s sec=%f time_grid_phase_id %s arrival_phase_id %s eval_phase %s ",
-                            Arrival[nArr].label, Arrival[nArr].inst, Arrival[nArr].comp, prev_phase_id, Arrival[nArr].sec, time_grid_phase_id, arrival_phase_id, eval_phase);
-                }
-                if (strcmp(arrival_phase_id, time_grid_phase_id) == 0) {
+                if (strcmp(arrival_phase_id, original_arrival_phase_id) == 0) {
                     i_same_phase = 1;
                     if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0)
-                        fprintf(stdout, "-> (strcmp(arrival_phase_id, time_grid_phase_id) == 0) -> i_same_phase");
+                        fprintf(fp_msg, "-> (strcmp(arrival_phase_id, original_arrival_phase_id) == 0) -> i_same_phase");
                 } else {
                     // apply LOCPHASEID
                     // TODO: does nothing, because LOCPHASEID not available to PhsAssoc !
                     /*EvalPhaseID(eval_phase, arrival_phase_id);
-                    if (strcmp(eval_phase, time_grid_phase_id) == 0) {
+                    if (strcmp(eval_phase, original_arrival_phase_id) == 0) {
                         i_same_phase = 1;
                         if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0)
-                            fprintf(stdout, "-> (strcmp(eval_phase, time_grid_phase_id) == 0) -> i_same_phase");
+                            fprintf(fp_msg, "-> (strcmp(eval_phase, original_arrival_phase_id) == 0) -> i_same_phase");
                     } */
                     // CLUGE: add  a few obvious equivalences
-                    /*if (strstr("P p Pn Pg P0 P1 Pb", arrival_phase_id) != NULL && strstr("P p Pn Pg P0 P1 Pb", time_grid_phase_id) != NULL)
+                    if (strstr("P p Pn Pg P0 P1 Pb", arrival_phase_id) != NULL && strstr("P p Pn Pg P0 P1 Pb", original_arrival_phase_id) != NULL)
                         i_same_phase = 1;
-                    else if (strstr("S s Sn Sg", arrival_phase_id) != NULL && strstr("S s Sn Sg", time_grid_phase_id) != NULL)
-                        i_same_phase = 1;*/
-                }
-                // check if arrival phase is also same as original phase
-                if (i_same_phase) {
-                    i_same_phase = 0;
-                    if (strcmp(arrival_phase_id, original_arrival_phase_id) == 0) {
+                    else if (strstr("S s Sn Sg", arrival_phase_id) != NULL && strstr("S s Sn Sg", original_arrival_phase_id) != NULL)
                         i_same_phase = 1;
-                        if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0)
-                            fprintf(stdout, "-> (strcmp(arrival_phase_id, original_arrival_phase_id) == 0) -> i_same_phase");
-                    } else {
-                        // apply LOCPHASEID
-                        // TODO: does nothing, because LOCPHASEID not available to PhsAssoc !
-                        /*EvalPhaseID(eval_phase, arrival_phase_id);
-                        if (strcmp(eval_phase, original_arrival_phase_id) == 0) {
-                            i_same_phase = 1;
-                            if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0)
-                                fprintf(stdout, "-> (strcmp(eval_phase, original_arrival_phase_id) == 0) -> i_same_phase");
-                        } */
-                        // CLUGE: add  a few obvious equivalences
-                        if (strstr("P p Pn Pg P0 P1 Pb", arrival_phase_id) != NULL && strstr("P p Pn Pg P0 P1 Pb", original_arrival_phase_id) != NULL)
-                            i_same_phase = 1;
-                        else if (strstr("S s Sn Sg", arrival_phase_id) != NULL && strstr("S s Sn Sg", original_arrival_phase_id) != NULL)
-                            i_same_phase = 1;
-                    }
                 }
-                // set residual
-                residual = obs_travel_time - pred_travel_time;
-                if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0)
-                    fprintf(stdout, "\nDEBUG: %s %s %s %s sec=%f  obs_tt=%fs %s pred_tt=%f res=%fs\n",
-                        Arrival[nArr].label, Arrival[nArr].inst, Arrival[nArr].comp, prev_phase_id,
-                        Arrival[nArr].sec, obs_travel_time, time_grid_phase_id, pred_travel_time, residual);
-                sign_residual = residual >= 0.0 ? 1.0 : -1.0;
-                time_shift = 0.0;
+            }
+            // set residual
+            residual = obs_travel_time - pred_travel_time;
+            if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0)
+                fprintf(fp_msg, "\nDEBUG: %s %s %s %s sec=%f  obs_tt=%fs %s pred_tt=%f res=%fs\n",
+                    Arrival[nArr].label, Arrival[nArr].inst, Arrival[nArr].comp, prev_phase_id,
+                    Arrival[nArr].sec, obs_travel_time, time_grid_phase_id, pred_travel_time, residual);
+            sign_residual = residual >= 0.0 ? 1.0 : -1.0;
+            time_shift = 0.0;
 #define TIME_TOLERANCE 0.01     // sec
-                while (residual * sign_residual >= -residual_max) { // 20160930 AJL
-                    // check for case with smallest residual for this phase id
-                    if (fabs(residual) < fabs(best_residual) - TIME_TOLERANCE && fabs(residual) < residual_max) {
-                        best_residual = residual;
-                        best_pred_travel_time = pred_travel_time;
-                        best_time_shift = time_shift;
-                        strcpy(best_phase_id, time_grid_phase_id);
-                    }
-                    // tests for not allowing time shift
-                    if (fabs(residual) < 60.0 - max_time_shift_res || !i_shift_obs_time || !i_same_phase) {
-                        break;
-                    }
-                    // try correcting obs time by 60s shifting
-                    while (fabs(residual) > max_time_shift_res && residual * sign_residual - 60.0 >= -max_time_shift_res) { // 20160930 AJL
-                        if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0)
-                            fprintf(stdout, "DEBUG: %s time_shift=%f residual=%fs\n", Arrival[nArr].label, time_shift, residual);
-                        time_shift -= sign_residual * 60.0;
-                        residual -= sign_residual * 60.0;
-                    }
+            while (residual * sign_residual >= -residual_max) { // 20160930 AJL
+                // check for case with smallest residual for this phase id
+                if (fabs(residual) < fabs(best_residual) - TIME_TOLERANCE && fabs(residual) < residual_max) {
+                    best_residual = residual;
+                    best_pred_travel_time = pred_travel_time;
+                    best_time_shift = time_shift;
+                    strcpy(best_phase_id, time_grid_phase_id);
+                }
+                // tests for not allowing time shift
+                if (fabs(residual) < 60.0 - max_time_shift_res || !i_shift_obs_time || !i_same_phase) {
+                    break;
+                }
+                // try correcting obs time by 60s shifting
+                while (fabs(residual) > max_time_shift_res && residual * sign_residual - 60.0 >= -max_time_shift_res) { // 20160930 AJL
                     if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0)
-                        fprintf(stdout, "   -> %s time_shift=%f residual=%fs\n", Arrival[nArr].label, time_shift, residual);
-                    if (fabs(residual) > max_time_shift_res) {
-                        break;
-                    }
+                        fprintf(fp_msg, "DEBUG: %s time_shift=%f residual=%fs\n", Arrival[nArr].label, time_shift, residual);
+                    time_shift -= sign_residual * 60.0;
+                    residual -= sign_residual * 60.0;
+                }
+                if (strcmp(DEBUG_STATION, Arrival[nArr].label) == 0)
+                    fprintf(fp_msg, "   -> %s time_shift=%f residual=%fs\n", Arrival[nArr].label, time_shift, residual);
+                if (fabs(residual) > max_time_shift_res) {
+                    break;
                 }
             }
-            /*					fprintf(stdout, "!!! %s %s (%fs) -> %s  (%fs)\n",
-                                                            Arrival[nArr].label, prev_phase_id,
-                                                            orig_residual, best_phase_id, best_residual);
-             */
-            Arrival[nArr].residual = best_residual;
-            // check if best phase is different from original phase
-            if (strcmp(Arrival[nArr].phase, best_phase_id) != 0) {
-                // update arrival
-                strcpy(Arrival[nArr].phase, best_phase_id);
-                Arrival[nArr].pred_travel_time = best_pred_travel_time;
-                //Arrival[nArr].residual = best_residual;
-            }
-            // check residual
-            if (fabs(Arrival[nArr].residual) > residual_max) {
-                // set arrival to zero weight
-                sprintf(tmp_str, "*%s", Arrival[nArr].phase);
-                strcpy(Arrival[nArr].phase, tmp_str);
-                // cancel any time shift
-                best_time_shift = 0.0;
+        }
+        /*					fprintf(stdout, "!!! %s %s (%fs) -> %s  (%fs)\n",
+                                                        Arrival[nArr].label, prev_phase_id,
+                                                        orig_residual, best_phase_id, best_residual);
+         */
+        Arrival[nArr].residual = best_residual;
+        // check if best phase is different from original phase
+        if (strcmp(Arrival[nArr].phase, best_phase_id) != 0) {
+            // update arrival
+            strcpy(Arrival[nArr].phase, best_phase_id);
+            Arrival[nArr].pred_travel_time = best_pred_travel_time;
+            //Arrival[nArr].residual = best_residual;
+        }
+        // check residual
+        if (fabs(Arrival[nArr].residual) > residual_max) {
+            // set arrival to zero weight
+            sprintf(tmp_str, "*%s", Arrival[nArr].phase);
+            strcpy(Arrival[nArr].phase, tmp_str);
+            // cancel any time shift
+            best_time_shift = 0.0;
+        }
+        // check if phase ID changed
+        if (strcmp(prev_phase_id, Arrival[nArr].phase) != 0) {
+            nPhaseIDChanged++;
+            fprintf(fp_msg, "ID changed: %s %s %s %s (%fs)",
+                    Arrival[nArr].label, Arrival[nArr].inst, Arrival[nArr].comp, prev_phase_id, orig_residual);
+            //if (strcmp(Arrival[nArr].inst, "?") == 0) {
+            //    strcpy(Arrival[nArr].inst, prev_phase_id);
+            //}
+            if (Arrival[nArr].phase[0] == '*') {
+                // -> zero weight
+                nZeroWeight++;
+                fprintf(fp_msg, " -> %s (zero weight)", Arrival[nArr].phase);
+            } else {
+                fprintf(fp_msg, " -> %s  (%fs)", best_phase_id, best_residual);
             }
-            // check if phase ID changed
-            if (strcmp(prev_phase_id, Arrival[nArr].phase) != 0) {
-                nPhaseIDChanged++;
-                fprintf(stdout, "ID changed: %s %s %s %s (%fs)",
-                        Arrival[nArr].label, Arrival[nArr].inst, Arrival[nArr].comp, prev_phase_id, orig_residual);
-                //if (strcmp(Arrival[nArr].inst, "?") == 0) {
-                //    strcpy(Arrival[nArr].inst, prev_phase_id);
-                //}
-                if (Arrival[nArr].phase[0] == '*') {
-                    // -> zero weight
-                    nZeroWeight++;
-                    fprintf(stdout, " -> %s (zero weight)", Arrival[nArr].phase);
-                } else {
-                    fprintf(stdout, " -> %s  (%fs)", best_phase_id, best_residual);
-                }
-                fprintf(stdout, "\n");
+            fprintf(fp_msg, "\n");
 
+        }
+        // check if time shifted
+        if (fabs(best_time_shift) > FLT_MIN) {
+            nTimeShifted++;
+            fprintf(fp_msg, "Time shifted: %s %s %s %s sec=%f (%fs) -> %s sec=%f (%fs)",
+                    Arrival[nArr].label, Arrival[nArr].inst, Arrival[nArr].comp, prev_phase_id,
+                    Arrival[nArr].sec, orig_residual, best_phase_id, Arrival[nArr].sec + best_time_shift, best_residual);
+            Arrival[nArr].sec += best_time_shift;
+            // down-weight and save total time shift
+            if (strncmp(Arrival[nArr].comp, "TS", 2) != 0) {
+                //Arrival[nArr].error *= 2.0;
+                Arrival[nArr].apriori_weight *= 0.5;
+                sprintf(Arrival[nArr].comp, "TS%.0f", best_time_shift);
+            } else {
+                double total_time_shift;
+                sscanf(Arrival[nArr].comp, "TS%lf", &total_time_shift);
+                total_time_shift += best_time_shift;
+                sprintf(Arrival[nArr].comp, "TS%.0f", total_time_shift);
             }
-            // check if time shifted
-            if (fabs(best_time_shift) > FLT_MIN) {
-                nTimeShifted++;
-                fprintf(stdout, "Time shifted: %s %s %s %s sec=%f (%fs) -> %s sec=%f (%fs)",
-                        Arrival[nArr].label, Arrival[nArr].inst, Arrival[nArr].comp, prev_phase_id,
-                        Arrival[nArr].sec, orig_residual, best_phase_id, Arrival[nArr].sec + best_time_shift, best_residual);
-                Arrival[nArr].sec += best_time_shift;
-                // down-weight and save total time shift
-                if (strncmp(Arrival[nArr].comp, "TS", 2) != 0) {
-                    //Arrival[nArr].error *= 2.0;
-                    Arrival[nArr].apriori_weight *= 0.5;
-                    sprintf(Arrival[nArr].comp, "TS%.0f", best_time_shift);
-                } else {
-                    double total_time_shift;
-                    sscanf(Arrival[nArr].comp, "TS%lf", &total_time_shift);
-                    total_time_shift += best_time_shift;
-                    sprintf(Arrival[nArr].comp, "TS%.0f", total_time_shift);
-                }
-                fprintf(stdout, " comp=%s error=%fs", Arrival[nArr].comp, Arrival[nArr].error);
-                fprintf(stdout, "\n");
+            fprintf(fp_msg, " comp=%s error=%fs", Arrival[nArr].comp, Arrival[nArr].error);
+            fprintf(fp_msg, "\n");
 
-            }
+        }
 
 
-        }
+    }
+
+    pevent->nPhaseIDChanged = nPhaseIDChanged;
+    pevent->nZeroWeight = nZeroWeight;
+    pevent->nTimeShifted = nTimeShifted;
+
+}
+
+/** function to write associated event and messages, free event */
+
+void WriteAssocEvent(AssocEvent *pevent, AssocParams *pparams, AssocTotals *ptotals) {
 
+    char fn_hyp_out[FILENAME_MAX];
+    char *pchr0;
+    FILE *fp_hyp_out;
 
-        if (nPhaseIDChanged > 0 || nTimeShifted > 0)
-            nEventsChanged++;
+#ifdef NLL_HAVE_MEMSTREAM
+    fclose(pevent->fp_msg);
+    if (pevent->msg_size > 0)
+        fwrite(pevent->msg, 1, pevent->msg_size, stdout);
+    free(pevent->msg);
+    pevent->msg = NULL;
+#endif
+    pevent->fp_msg = NULL;
+
+    if (pevent->associate) {
+
+        if (pevent->nPhaseIDChanged > 0 || pevent->nTimeShifted > 0)
+            ptotals->nEventsChanged++;
 
         // write output location
-        if (iWriteAll || nPhaseIDChanged > 0 || nTimeShifted > 0) {
+        if (pparams->iWriteAll || pevent->nPhaseIDChanged > 0 || pevent->nTimeShifted > 0) {
             // open output NLL hypocenter file
-            strcpy(fn_hyp_out, fn_hyp);
+            strcpy(fn_hyp_out, pevent->fn_hyp);
             pchr0 = strstr(fn_hyp_out, ".hyp");
             if (pchr0 != NULL)
                 *pchr0 = '\0';
             strcat(fn_hyp_out, ".phs_assoc");
             if ((fp_hyp_out = fopen(fn_hyp_out, "w")) == NULL) {
                 nll_puterr2("ERROR: opening output NLL associated phase file", fn_hyp_out);
-                continue;
+                pevent->associate = 0;
+            } else {
+                strcpy(MapProjStr[0], pevent->map_proj_str);
+                WritePhases(fp_hyp_out, &pevent->hypo,
+                        pevent->arrivals, pevent->narrivals, NULL, 1, 0, 1, &pevent->locgrid, 0, IO_ARRIVAL_OBS);
+                fclose(fp_hyp_out);
             }
-            WritePhases(fp_hyp_out, &Hypo,
-                    Arrival, NumArrivals, NULL, 1, 0, 1, &locgrid, 0, IO_ARRIVAL_OBS);
-            fclose(fp_hyp_out);
         }
 
-        // write message
-        fprintf(stdout,
-                "%d phases read, %d IDs changed, %d given 0 weight, %d time shifted.\n",
-                NumArrivals, nPhaseIDChanged, nZeroWeight, nTimeShifted);
+        if (pevent->associate) {
+            // write message
+            fprintf(stdout,
+                    "%d phases read, %d IDs changed, %d given 0 weight, %d time shifted.\n",
+                    pevent->narrivals, pevent->nPhaseIDChanged, pevent->nZeroWeight, pevent->nTimeShifted);
 
-        nPhaseIDChanged_total += nPhaseIDChanged;
-        nTimeShifted_total += nTimeShifted;
+            ptotals->nPhaseIDChanged_total += pevent->nPhaseIDChanged;
+            ptotals->nTimeShifted_total += pevent->nTimeShifted;
+        }
 
     }
 
-    // write message
-    fprintf(stdout,
-            "\n%d events read, %d outside grid, %d changed, %d phases changed, %d time shifted.\n",
-            nEventsRead, nEventsOutside, nEventsChanged, nPhaseIDChanged_total, nTimeShifted_total);
+    free(pevent->arrivals);
+    pevent->arrivals = NULL;
+    free(pevent->grid_lists);
+    pevent->grid_lists = NULL;
+
+}
+
+/** function to associate a window of events in parallel, then write events in order
+ *
+ *  20261018 AJL - added
+ */
+
+void ProcessAssocWindow(AssocGridCache *pcache, AssocEvent *window, int nwindow, AssocParams *pparams, AssocTotals *ptotals) {
+
+    int n;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (n = 0; n < nwindow; n++) {
+        if (window[n].associate)
+            AssociateEvent(window + n, pparams);
+    }
+
+    // as for sequential processing, Arrival is left with associated arrivals of last event,
+    //    used by following event file with no PHASE block
+    if (nwindow > 0 && window[nwindow - 1].associate) {
+        NumArrivals = window[nwindow - 1].narrivals;
+        memcpy(Arrival, window[nwindow - 1].arrivals, (size_t) NumArrivals * sizeof (ArrivalDesc));
+    }
+
+    for (n = 0; n < nwindow; n++)
+        WriteAssocEvent(window + n, pparams, ptotals);
 
-    return (nEventsChanged);
+    EvictAssocGrids(pcache);
 
 }
 
 /*** function to complete and verify obs_travel_time of arrivals */
 
-int CalcObsTravelTimes(ArrivalDesc *arrival, int num_arrivals, HypoDesc* phypo) {
+int CalcObsTravelTimes(FILE *fp_msg, ArrivalDesc *arrival, int num_arrivals, HypoDesc* phypo) {
     int narr;
     int dofymin = 10000, yearmin = 10000;
 
@@ -550,7 +1062,7 @@ int CalcObsTravelTimes(ArrivalDesc *arrival, int num_arrivals, HypoDesc* phypo)
         if (arrival[narr].year < yearmin)
             yearmin = arrival[narr].year;
         if (arrival[narr].year != yearmin) {
-            printf("ERROR: arrivals cross year boundary, ignoring observation set.");
+            fprintf(fp_msg, "ERROR: arrivals cross year boundary, ignoring observation set.");
             return (-1);
         }
     }
@@ -594,7 +1106,7 @@ int CalcObsTravelTimes(ArrivalDesc *arrival, int num_arrivals, HypoDesc* phypo)
                 arrival[narr].pred_travel_time + arrival[narr].residual + arrival[narr].delay;
         if (fabs(arrival[narr].obs_travel_time) > TIME_TOLERANCE &&
                 fabs(arrival[narr].obs_travel_time - obs_travel_time) > TIME_TOLERANCE) {
-            printf("WARNING: %s %s arrival.obs_travel_time (%f) != obs_travel_time (%f)\n",
+            fprintf(fp_msg, "WARNING: %s %s arrival.obs_travel_time (%f) != obs_travel_time (%f)\n",
                     arrival[narr].label, arrival[narr].phase, arrival[narr].obs_travel_time, obs_travel_time);
             arrival[narr].obs_travel_time = obs_travel_time;
         }
@@ -607,7 +1119,7 @@ int CalcObsTravelTimes(ArrivalDesc *arrival, int num_arrivals, HypoDesc* phypo)
                     - arrival[narr].pred_travel_time - arrival[narr].delay;
             if (fabs(arrival[narr].residual) > TIME_TOLERANCE &&
                     fabs(arrival[narr].residual - residual) > TIME_TOLERANCE) {
-                printf("WARNING: %s %s arrival.residual (%f) != residual (%f)\n",
+                fprintf(fp_msg, "WARNING: %s %s arrival.residual (%f) != residual (%f)\n",
                         arrival[narr].label, arrival[narr].phase, arrival[narr].residual, residual);
                 arrival[narr].residual = residual;
             }
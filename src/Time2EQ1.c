@@ -35,6 +35,7 @@
         history:
 
         ver 01    25SEP1997  AJL  Original version
+        20261018  AJL  Random event generation (EQRANDOM) with resident time grids, events generated in parallel
 
 
 .........1.........2.........3.........4.........5.........6.........7.........8
@@ -48,6 +49,10 @@
 #include "GridLib.h"
 #include "ran1/ran1.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 
 /* defines */
 
@@ -81,6 +86,36 @@ char mech_str[MAXLINE];
 /* event */
 SourceDesc *Event;
 
+/* random events */
+// 20261018 AJL - added
+#define RANDOM_DIST_BOX  0
+#define RANDOM_DIST_GAUSS  1
+#define RANDOM_DIST_SOURCES  2
+#define RANDOM_EVENT_BLOCK  4096    // maximum number of random events generated before writing
+long NumRandomEvents = 0;
+int RandomEventDist;
+double RandomEventParams[6];
+
+/* mis-picks */
+// 20261018 AJL - added
+double ProbMisPickShift = 0.0;
+double MaxMisPickShift = 0.0;
+double ProbMisPickPhaseSwap = 0.0;
+
+typedef struct {
+    double time;
+    int nsta;
+    int ipolarity;
+    int iphase_swap;
+}
+RandomArrival;
+
+typedef struct {
+    double x, y, z, otime;
+    int narrivals;
+}
+RandomEvent;
+
 
 
 
@@ -92,12 +127,18 @@ int GetTime2EQ_Stations(char* in_line);
 int GetTime2EQ_Source(char*);
 int ReadTime2EQ_Input(FILE*);
 int GetTime2EQ_Files(char*);
+int GetTime2EQ_Random(char*);
+int GetTime2EQ_MisPick(char*);
 int get_vp_vs(char* line1);
 double CalcArrivalTime(FILE*, GridDesc*, SourceDesc*, StationDesc*);
 double AddNoise(double arrival_time, StationDesc* psta);
+double CalcNoise(StationDesc* psta, RandStream* pstream, double* perror);
+double AddMisPick(double arrival_time, RandStream* pstream, int* piphase_swap);
 int CalcFirstMotion(char *, GridDesc*, SourceDesc*, StationDesc*, int);
-int WritePhaseArrival(double, int, FILE*, FILE*, FILE*, FILE*, FILE*, FILE*, SourceDesc*,
+int WritePhaseArrival(double, int, int, FILE*, FILE*, FILE*, FILE*, FILE*, FILE*, SourceDesc*,
         StationDesc*, int);
+void SetPhaseArrival(ArrivalDesc*, double, int, int, SourceDesc*, StationDesc*);
+int GenRandomEvents();
 int get_mech(char*);
 double calc_rad(double, double, char);
 
@@ -113,7 +154,7 @@ int main(int argc, char *argv[]) {
     int istat;
     int nsta, nsource;
     double arrival_time;
-    int ipolarity;
+    int ipolarity, iphase_swap;
     int nsta_written;
 
     char filename[MAXLINE], filename_angle[MAXLINE];
@@ -182,6 +223,15 @@ int main(int argc, char *argv[]) {
         nll_puterr("ERROR: converting source location to x/y and lat/lon.");
 
 
+    /* generate random events */
+
+    if (NumRandomEvents > 0) {
+        if ((istat = GenRandomEvents()) < 0)
+            exit(istat);
+        exit(EXIT_NORMAL);
+    }
+
+
     /* open arrivals output file */
 
     if ((fp_eq_output = fopen(fn_eq_output, "w")) == NULL) {
@@ -331,8 +381,10 @@ int main(int argc, char *argv[]) {
                     continue;
             }
 
+            arrival_time = AddMisPick(arrival_time, NULL, &iphase_swap);
+
 
-            if ((istat = WritePhaseArrival(arrival_time, ipolarity,
+            if ((istat = WritePhaseArrival(arrival_time, ipolarity, iphase_swap,
                     fp_eq_output, fp_hypo_output, fp_simulps_output, fp_invc_output,
                     fp_gmt_output, fp_gmt_output_az,
                     Event, Station + nsta, nsta_written++)) < 0)
@@ -386,34 +438,69 @@ double CalcArrivalTime(FILE* fpgrid, GridDesc* ptgrid, SourceDesc* pevent, Stati
 
 }
 
-/*** function to calc arrival time from time grid file and add noise */
+/*** function to get random double between xmin and xmax from random number stream, or from global generator if stream is NULL */
 
-double AddNoise(double arrival_time, StationDesc* psta) {
+static double rand_double(RandStream* pstream, double xmin, double xmax) {
 
-    double noise = 0.0;
+    if (pstream != NULL)
+        return (rand_stream_double(pstream, xmin, xmax));
 
+    return (get_rand_double(xmin, xmax));
 
-    /* add noise */
+}
+
+/*** function to get normal deviate from random number stream, or from global generator if stream is NULL */
+
+static double rand_normal(RandStream* pstream) {
+
+    if (pstream != NULL)
+        return (rand_stream_normal(pstream));
+
+    return (normal_dist_deviate());
+
+}
+
+/*** function to calc noise for a station phase, random deviates from stream or from global generator if stream is NULL */
+
+double CalcNoise(StationDesc* psta, RandStream* pstream, double* perror) {
+
+    double noise = 0.0;
 
     double error = psta->phs[0].error;
     if (psta->phs[0].prob_outlier > 0.0) {
-        if (get_rand_double(0.0, 1.0) < psta->phs[0].prob_outlier) {
+        if (rand_double(pstream, 0.0, 1.0) < psta->phs[0].prob_outlier) {
             error *= psta->phs[0].outlier_err_factor;
         }
     }
 
     if (strcmp(psta->phs[0].error_type, "GAU") == 0)
-        noise = error * normal_dist_deviate();
+        noise = error * rand_normal(pstream);
     else if (strcmp(psta->phs[0].error_type, "BOX") == 0)
-        noise = get_rand_double(-error, error);
+        noise = rand_double(pstream, -error, error);
     else if (strcmp(psta->phs[0].error_type, "FIX") == 0)
         noise = error;
     else if (strcmp(psta->phs[0].error_type, "NONE") == 0)
         noise = 0.0;
-    else
+    else if (pstream == NULL)
         nll_puterr2("ERROR: unrecognized error type:", psta->phs[0].error_type);
 
-    sprintf(MsgStr, "Station %s  Phase %s  Error Type %s  Error %f  ->  Noise %f + ArrivalTime %f = Sum %f", psta->label, psta->phs[0].label, psta->phs[0].error_type, error, noise, arrival_time, noise + arrival_time
+    *perror = error;
+    return (noise);
+
+}
+
+/*** function to calc arrival time from time grid file and add noise */
+
+double AddNoise(double arrival_time, StationDesc* psta) {
+
+    double noise, error;
+
+
+    /* add noise */
+
+    noise = CalcNoise(psta, NULL, &error);
+
+    snprintf(MsgStr, sizeof (MsgStr), "Station %s  Phase %s  Error Type %s  Error %f  ->  Noise %f + ArrivalTime %f = Sum %f", psta->label, psta->phs[0].label, psta->phs[0].error_type, error, noise, arrival_time, noise + arrival_time
             );
     nll_putmsg(2, MsgStr);
 
@@ -421,10 +508,37 @@ double AddNoise(double arrival_time, StationDesc* psta) {
 
 }
 
+/*** function to add mis-pick (gross time error or P/S phase swap) to arrival time
+ *
+ *  random deviates from stream or from global generator if stream is NULL,
+ *  no random deviates are used if mis-picks are not enabled (EQMISPICK)
+ */
+
+double AddMisPick(double arrival_time, RandStream* pstream, int* piphase_swap) {
+
+    *piphase_swap = 0;
+
+    if (ProbMisPickShift > 0.0 && rand_double(pstream, 0.0, 1.0) < ProbMisPickShift)
+        arrival_time += rand_double(pstream, -MaxMisPickShift, MaxMisPickShift);
+    if (ProbMisPickPhaseSwap > 0.0 && rand_double(pstream, 0.0, 1.0) < ProbMisPickPhaseSwap)
+        *piphase_swap = 1;
+
+    return (arrival_time);
+
+}
+
 /*** function to calc first motion from angle grid file */
 
+static int calc_first_motion(char *filename, GridDesc* ptgrid, SourceDesc* pevent, StationDesc* psta, int isP, int iwrite_msg);
+
 int CalcFirstMotion(char *filename, GridDesc* ptgrid, SourceDesc* pevent, StationDesc* psta, int isP) {
 
+    return (calc_first_motion(filename, ptgrid, pevent, psta, isP, 1));
+
+}
+
+static int calc_first_motion(char *filename, GridDesc* ptgrid, SourceDesc* pevent, StationDesc* psta, int isP, int iwrite_msg) {
+
     double yval_grid, azim;
     double radamp = 0.0;
     int ipolarity = 0;
@@ -456,31 +570,23 @@ int CalcFirstMotion(char *filename, GridDesc* ptgrid, SourceDesc* pevent, Statio
         ipolarity = radamp < 0.0 ? -1 : 1;
     }
 
-    sprintf(MsgStr, "FM: Sta: %s  Pha: %s  ray_dip %.1lf  ray_azim %.1lf  radamp %.2le  ipol %d\n",
-            psta->label, psta->phs[0].label, ray_dip, ray_azim, radamp, ipolarity);
-    nll_putmsg(2, MsgStr);
+    if (iwrite_msg) {
+        sprintf(MsgStr, "FM: Sta: %s  Pha: %s  ray_dip %.1lf  ray_azim %.1lf  radamp %.2le  ipol %d\n",
+                psta->label, psta->phs[0].label, ray_dip, ray_azim, radamp, ipolarity);
+        nll_putmsg(2, MsgStr);
+    }
 
     return (ipolarity);
 
 }
 
-/*** function to calc arrival time from grid file and save to event file */
+/*** function to set phase arrival fields from arrival time */
 
-int WritePhaseArrival(double arrival_time, int ipolarity,
-        FILE* fpout, FILE* fpout_hypo, FILE* fpout_simulps, FILE* fpout_invc,
-        FILE* fpout_gmt, FILE* fpout_gmt_az,
-        SourceDesc* pevent, StationDesc* psta, int num_sta) {
+void SetPhaseArrival(ArrivalDesc* parr, double arrival_time, int ipolarity, int iphase_swap,
+        SourceDesc* pevent, StationDesc* psta) {
 
-    int iEOL;
-    int nhr = 0, nmin = 0;
-    int nlat = 0, nlon = 0;
     double osec = 0.0;
-    ArrivalDesc arr, *parr;
-    double az;
-
-    static ArrivalDesc lastarr;
 
-    parr = &arr;
 
     /* determine label */
 
@@ -493,6 +599,13 @@ int WritePhaseArrival(double arrival_time, int ipolarity,
     strcpy(parr->comp, "?"),
             strcpy(parr->onset, "?"),
             strcpy(parr->phase, psta->phs[0].label);
+    if (iphase_swap) {
+        // mis-pick, P labelled as S or S labelled as P
+        if (parr->phase[0] == 'P')
+            parr->phase[0] = 'S';
+        else if (parr->phase[0] == 'S')
+            parr->phase[0] = 'P';
+    }
     if (ipolarity == 1)
         strcpy(parr->first_mot, "U");
     else if (ipolarity == -1)
@@ -517,6 +630,28 @@ int WritePhaseArrival(double arrival_time, int ipolarity,
 
     parr->apriori_weight = 1.0; // 20110105 AJL - to support NLL_FORMAT_VER_2
 
+}
+
+/*** function to calc arrival time from grid file and save to event file */
+
+int WritePhaseArrival(double arrival_time, int ipolarity, int iphase_swap,
+        FILE* fpout, FILE* fpout_hypo, FILE* fpout_simulps, FILE* fpout_invc,
+        FILE* fpout_gmt, FILE* fpout_gmt_az,
+        SourceDesc* pevent, StationDesc* psta, int num_sta) {
+
+    int iEOL;
+    int nhr = 0, nmin = 0;
+    int nlat = 0, nlon = 0;
+    double osec = 0.0;
+    ArrivalDesc arr, *parr;
+    double az;
+
+    static ArrivalDesc lastarr;
+
+    parr = &arr;
+
+    SetPhaseArrival(parr, arrival_time, ipolarity, iphase_swap, pevent, psta);
+
     /* write arrival time to NLLoc output file */
 
     PhaseFormat = FORMAT_PHASE_2; // 20110105 AJL - to allow long station names
@@ -604,6 +739,311 @@ int WritePhaseArrival(double arrival_time, int ipolarity,
 
 }
 
+/*** function to set date of arrival time with hour > 23 (origin times of many random events), days counted from 1900-01-01 */
+
+static void set_arrival_date(ArrivalDesc* parr) {
+
+    int ndays, ndays_year;
+
+    ndays = parr->hour / 24;
+    parr->hour -= 24 * ndays;
+    parr->year = 1900;
+    while (ndays >= (ndays_year = DayOfYear(parr->year, 12, 31))) {
+        ndays -= ndays_year;
+        parr->year++;
+    }
+    MonthDay(parr->year, ndays + 1, &(parr->month), &(parr->day));
+
+}
+
+/*** function to read time grids of all station phases into memory, sets station coordinates from grid headers
+ *
+ *  returns number of grids read, sets *picascading if any grid is a cascading grid
+ */
+
+static int load_station_grids(GridDesc* sta_grid, int* grid_status, char (*fn_angle)[MAXLINE], int* picascading) {
+
+    int nsta, ngrids = 0, iuse_vpvs;
+    long grid_bytes = 0;
+    char filename[MAXLINE];
+    FILE *fp_grid, *fp_hdr;
+    SourceDesc srce;
+    StationDesc *psta;
+
+    *picascading = 0;
+    for (nsta = 0; nsta < NumStationPhases; nsta++) {
+        psta = Station + nsta;
+        grid_status[nsta] = 0;
+        snprintf(fn_angle[nsta], MAXLINE, "%s.%s.%s.angle", fn_eq_input, psta->phs[0].label, psta->label);
+        snprintf(filename, sizeof (filename), "%s.%s.%s.time", fn_eq_input, psta->phs[0].label, psta->label);
+        // S may be calculated from P with Vp/Vs, grid not required
+        iuse_vpvs = nsta > 0 && VpVsRatio > 0.0 && strcmp(psta->label, (psta - 1)->label) == 0
+                && strcmp(psta->phs[0].label, "S") == 0 && strcmp((psta - 1)->phs[0].label, "P") == 0;
+        if (OpenGrid3dFile(filename, &fp_grid, &fp_hdr, sta_grid + nsta, "time", &srce, 0) < 0) {
+            if (!iuse_vpvs)
+                nll_puterr2("ERROR: opening time grid files", filename);
+            continue;
+        }
+        if (fp_grid == NULL || AllocateGrid(sta_grid + nsta) == NULL || CreateGridArray(sta_grid + nsta) == NULL
+                || ReadGrid3dBuf(sta_grid + nsta, fp_grid) < 0) {
+            nll_puterr2("ERROR: reading time grid file", filename);
+            DestroyGridArray(sta_grid + nsta);
+            sta_grid[nsta].array = NULL;
+            FreeGrid(sta_grid + nsta);
+        } else {
+            grid_status[nsta] = 1;
+            psta->x = srce.x;
+            psta->y = srce.y;
+            psta->z = srce.z;
+            if (isCascadingGrid(sta_grid + nsta))
+                *picascading = 1;
+            grid_bytes += sta_grid[nsta].buffer_size;
+            ngrids++;
+        }
+        CloseGrid3dFile(sta_grid + nsta, &fp_grid, &fp_hdr);
+    }
+
+    sprintf(MsgStr, "Time2EQ: %d time grids read into memory (%.1f MB)", ngrids, (double) grid_bytes / 1048576.0);
+    nll_putmsg(1, MsgStr);
+
+    return (ngrids);
+
+}
+
+/*** function to generate random event and its arrivals, using random number stream nevent so that
+ *   events do not depend on the order in which they are generated
+ *
+ *  arrivals are calculated as for EQSRCE/EQEVENT sources in main()
+ *  returns number of arrivals not calculated (event outside time grid)
+ */
+
+static int gen_random_event(long nevent, RandomEvent* prevent, RandomArrival* parrivals,
+        GridDesc* sta_grid, int* grid_status, char (*fn_angle)[MAXLINE]) {
+
+    int nsta, nsta_last = -1, nsource, isP, iphase_swap, ipolarity, noutside = 0;
+    double arrival_time, last_arrival_time = -1.0, error;
+    SourceDesc event;
+    StationDesc *psta;
+    RandStream stream;
+    RandomArrival *parr;
+    double *params = RandomEventParams;
+
+    rand_stream_init(&stream, RandomNumSeed, nevent);
+
+    /* event location */
+
+    memset(&event, 0, sizeof (SourceDesc));
+    if (RandomEventDist == RANDOM_DIST_BOX) {
+        event.x = rand_double(&stream, params[0], params[1]);
+        event.y = rand_double(&stream, params[2], params[3]);
+        event.z = rand_double(&stream, params[4], params[5]);
+    } else if (RandomEventDist == RANDOM_DIST_GAUSS) {
+        event.x = params[0] + params[3] * rand_normal(&stream);
+        event.y = params[1] + params[4] * rand_normal(&stream);
+        event.z = params[2] + params[5] * rand_normal(&stream);
+    } else {
+        nsource = (int) rand_double(&stream, 0.0, (double) NumSources);
+        if (nsource >= NumSources)
+            nsource = NumSources - 1;
+        event.x = Source[nsource].x + params[0] * rand_normal(&stream);
+        event.y = Source[nsource].y + params[1] * rand_normal(&stream);
+        event.z = Source[nsource].z + params[2] * rand_normal(&stream);
+    }
+    event.otime = (double) nevent * otime_EQSRCE_step;
+
+    prevent->x = event.x;
+    prevent->y = event.y;
+    prevent->z = event.z;
+    prevent->otime = event.otime;
+    prevent->narrivals = 0;
+
+    /* arrivals */
+
+    for (nsta = 0; nsta < NumStationPhases; nsta++) {
+
+        psta = Station + nsta;
+
+        // check for S and valid VpVs
+        if (nsta_last >= 0 && strcmp(psta->label, Station[nsta_last].label) == 0
+                && strcmp(psta->phs[0].label, "S") == 0
+                && strcmp(Station[nsta_last].phs[0].label, "P") == 0
+                && VpVsRatio > 0.0 && last_arrival_time > 0.0) {
+            arrival_time = event.otime + VpVsRatio * (last_arrival_time - event.otime);
+        } else if (grid_status[nsta] > 0) {
+            arrival_time = CalcArrivalTime(NULL, sta_grid + nsta, &event, psta);
+        } else {
+            continue;
+        }
+        nsta_last = nsta;
+        last_arrival_time = arrival_time;
+
+        if (arrival_time < 0.0) {
+            noutside++;
+            continue;
+        }
+
+        ipolarity = 0;
+        if (imech == MECH_DOUBLE) {
+            isP = strncmp(psta->phs[0].label, "P", 1) == 0;
+            if (isP && grid_status[nsta] > 0)
+                ipolarity = calc_first_motion(fn_angle[nsta], sta_grid + nsta, &event, psta, isP, 0);
+        } else if (imech == MECH_ISOTROPIC) {
+            ipolarity = 1;
+        }
+        arrival_time += CalcNoise(psta, &stream, &error);
+
+        // check if active
+        if (psta->prob_active < 1.0) {
+            if (rand_double(&stream, 0.0, 1.0) > psta->prob_active)
+                continue;
+        }
+
+        arrival_time = AddMisPick(arrival_time, &stream, &iphase_swap);
+
+        parr = parrivals + prevent->narrivals++;
+        parr->time = arrival_time;
+        parr->nsta = nsta;
+        parr->ipolarity = ipolarity;
+        parr->iphase_swap = iphase_swap;
+    }
+
+    return (noutside);
+
+}
+
+/*** function to write random events and their arrivals to NLLOC_OBS file */
+
+static long write_random_events(FILE* fp_out, long nevent0, RandomEvent* events, int nevents,
+        RandomArrival* arrivals, int max_arrivals) {
+
+    int nev, narr;
+    long narrivals_written = 0;
+    SourceDesc event;
+    ArrivalDesc arr;
+    RandomArrival *parr;
+
+    PhaseFormat = FORMAT_PHASE_2; // 20110105 AJL - to allow long station names
+
+    memset(&event, 0, sizeof (SourceDesc));
+    for (nev = 0; nev < nevents; nev++) {
+        snprintf(event.label, sizeof (event.label), "RND%ld", nevent0 + nev);
+        event.x = events[nev].x;
+        event.y = events[nev].y;
+        event.z = events[nev].z;
+        event.otime = events[nev].otime;
+        fprintf(fp_out, "# EQEVENT:  Label: %s  Loc:  X %.2lf  Y %.2lf  Z %.2lf  OT %.2lf\n",
+                event.label, event.x, event.y, event.z, event.otime);
+        fprintf(fp_out, "PUBLIC_ID  %s\n", event.label);
+        for (narr = 0; narr < events[nev].narrivals; narr++) {
+            parr = arrivals + (long) nev * max_arrivals + narr;
+            SetPhaseArrival(&arr, parr->time, parr->ipolarity, parr->iphase_swap, &event, Station + parr->nsta);
+            set_arrival_date(&arr);
+            if (WriteArrival(fp_out, &arr, IO_ARRIVAL_OBS) < 0) {
+                nll_puterr("ERROR: writing arrival time to disk.\n");
+                return (-1);
+            }
+            narrivals_written++;
+        }
+        fprintf(fp_out, "#\n");
+    }
+
+    return (narrivals_written);
+
+}
+
+/*** function to generate random events (EQRANDOM) and write arrivals to NLLOC_OBS output file
+ *
+ *  time grids of all station phases are read into memory once, events are generated in parallel in blocks
+ *  and written in event order after each block
+ */
+
+int GenRandomEvents() {
+
+    int nsta, nblock_max, nblock, nev, icascading, istat = 0;
+    long nevent0, noutside = 0, narrivals = 0, nwritten;
+    GridDesc *sta_grid = NULL;
+    int *grid_status = NULL;
+    char (*fn_angle)[MAXLINE] = NULL;
+    RandomEvent *events = NULL;
+    RandomArrival *arrivals = NULL;
+    FILE *fp_eq_output;
+
+
+    nblock_max = 1048576 / (NumStationPhases > 0 ? NumStationPhases : 1);
+    if (nblock_max > RANDOM_EVENT_BLOCK)
+        nblock_max = RANDOM_EVENT_BLOCK;
+    if (nblock_max < 1)
+        nblock_max = 1;
+
+    if ((sta_grid = (GridDesc *) calloc(NumStationPhases, sizeof (GridDesc))) == NULL
+            || (grid_status = (int *) calloc(NumStationPhases, sizeof (int))) == NULL
+            || (fn_angle = calloc(NumStationPhases, sizeof (*fn_angle))) == NULL
+            || (events = (RandomEvent *) calloc(nblock_max, sizeof (RandomEvent))) == NULL
+            || (arrivals = (RandomArrival *) calloc((size_t) nblock_max * NumStationPhases, sizeof (RandomArrival))) == NULL) {
+        nll_puterr("ERROR: allocating memory for random events.");
+        istat = EXIT_ERROR_MEMORY;
+        goto cleanup;
+    }
+
+    if (load_station_grids(sta_grid, grid_status, fn_angle, &icascading) < 1) {
+        nll_puterr("ERROR: no time grids read for random events.");
+        istat = EXIT_ERROR_FILEIO;
+        goto cleanup;
+    }
+
+    if ((fp_eq_output = fopen(fn_eq_output, "w")) == NULL) {
+        nll_puterr("ERROR: opening eq times output file.");
+        istat = EXIT_ERROR_FILEIO;
+        goto cleanup;
+    }
+
+    for (nevent0 = 0; nevent0 < NumRandomEvents; nevent0 += nblock) {
+        nblock = NumRandomEvents - nevent0 < nblock_max ? (int) (NumRandomEvents - nevent0) : nblock_max;
+        // cascading grids read from memory use shared work arrays, generate serially
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16) reduction(+:noutside) if(!icascading)
+#endif
+        for (nev = 0; nev < nblock; nev++) {
+            noutside += gen_random_event(nevent0 + nev, events + nev, arrivals + (long) nev * NumStationPhases,
+                    sta_grid, grid_status, fn_angle);
+        }
+        if ((nwritten = write_random_events(fp_eq_output, nevent0, events, nblock, arrivals, NumStationPhases)) < 0) {
+            istat = EXIT_ERROR_FILEIO;
+            break;
+        }
+        narrivals += nwritten;
+        if (message_flag >= 2) {
+            sprintf(MsgStr, "Time2EQ: random events %ld to %ld written", nevent0, nevent0 + nblock - 1);
+            nll_putmsg(2, MsgStr);
+        }
+    }
+
+    fclose(fp_eq_output);
+
+    sprintf(MsgStr, "Time2EQ: %ld random events, %ld arrivals written, %ld arrivals not calculated (event outside time grid)",
+            NumRandomEvents, narrivals, noutside);
+    nll_putmsg(1, MsgStr);
+
+cleanup:
+    if (sta_grid != NULL && grid_status != NULL) {
+        for (nsta = 0; nsta < NumStationPhases; nsta++) {
+            if (grid_status[nsta] > 0) {
+                DestroyGridArray(sta_grid + nsta);
+                sta_grid[nsta].array = NULL;
+                FreeGrid(sta_grid + nsta);
+            }
+        }
+    }
+    free(sta_grid);
+    free(grid_status);
+    free(fn_angle);
+    free(events);
+    free(arrivals);
+
+    return (istat);
+
+}
+
 /*** function to read input file */
 
 int ReadTime2EQ_Input(FILE* fp_input) {
@@ -613,7 +1053,8 @@ int ReadTime2EQ_Input(FILE* fp_input) {
 
     int flag_control = 0, flag_outfile = 0, flag_stations = 0,
             flag_event = 0, flag_source = 0, flag_mode = 0,
-            flag_trans = 0, flag_qual2err = 0, flag_mech = 0, flag_vp_vs = 0;
+            flag_trans = 0, flag_qual2err = 0, flag_mech = 0, flag_vp_vs = 0,
+            flag_random = 0;
 
     int flag_include = 1;
 
@@ -741,6 +1182,24 @@ int ReadTime2EQ_Input(FILE* fp_input) {
         }
 
 
+        /* read random event params */
+
+        if (strcmp(param, "EQRANDOM") == 0) {
+            if ((istat = GetTime2EQ_Random(strchr(line, ' '))) < 0)
+                nll_puterr("ERROR: reading Time2EQ random event params.");
+            else
+                flag_random = 1;
+        }
+
+
+        /* read mis-pick params */
+
+        if (strcmp(param, "EQMISPICK") == 0) {
+            if ((istat = GetTime2EQ_MisPick(strchr(line, ' '))) < 0)
+                nll_puterr("ERROR: reading Time2EQ mis-pick params.");
+        }
+
+
         /* read station params */
 
         if (strncmp(param, "EQSTA", 5) == 0) {
@@ -783,9 +1242,13 @@ int ReadTime2EQ_Input(FILE* fp_input) {
     }
     if (!flag_outfile)
         nll_puterr("ERROR: no i/o file (EQFILES) params read.");
-    if (!flag_event && !flag_source)
+    if (!flag_event && !flag_source && !flag_random)
         nll_puterr(
-            "ERROR: no event (EQEVENT) or source (EQSRCE) params read.");
+            "ERROR: no event (EQEVENT), source (EQSRCE) or random event (EQRANDOM) params read.");
+    if (flag_random && RandomEventDist == RANDOM_DIST_SOURCES && !flag_event && !flag_source) {
+        nll_puterr("ERROR: EQRANDOM SOURCES requires event (EQEVENT) or source (EQSRCE) params.");
+        flag_random = 0;
+    }
     if (!flag_stations)
         nll_puterr("ERROR: no station (EQSTA) params read.");
     if (!flag_qual2err)
@@ -797,7 +1260,7 @@ int ReadTime2EQ_Input(FILE* fp_input) {
 
 
     return (flag_include * flag_control * flag_outfile * flag_qual2err *
-            (flag_event || flag_source) * flag_stations - 1);
+            (flag_event || flag_source || flag_random) * flag_stations - 1);
 }
 
 /*** function to read output file name ***/
@@ -813,6 +1276,92 @@ int GetTime2EQ_Files(char* line1) {
     return (0);
 }
 
+/*** function to read random event params ***/
+
+int GetTime2EQ_Random(char* line1) {
+
+    int istat, nparams, dist;
+    long num_events;
+    char str_dist[MAXLINE];
+    double params[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    double otime_step = otime_EQSRCE_step;
+
+
+    // 20261019 AJL - parameters set only if all are valid, otherwise no random events are generated
+    NumRandomEvents = 0;
+
+    istat = sscanf(line1, "%ld %s", &num_events, str_dist);
+    if (istat != 2)
+        return (-1);
+
+    if (strcmp(str_dist, "BOX") == 0) {
+        dist = RANDOM_DIST_BOX;
+        nparams = 6;
+    } else if (strcmp(str_dist, "GAUSS") == 0) {
+        dist = RANDOM_DIST_GAUSS;
+        nparams = 6;
+    } else if (strcmp(str_dist, "SOURCES") == 0) {
+        dist = RANDOM_DIST_SOURCES;
+        nparams = 3;
+    } else {
+        nll_puterr2("ERROR: unrecognized random event distribution:", str_dist);
+        return (-1);
+    }
+
+    if (nparams == 6)
+        istat = sscanf(line1, "%*d %*s %lf %lf %lf %lf %lf %lf %lf",
+            params, params + 1, params + 2, params + 3, params + 4, params + 5, &otime_step);
+    else
+        istat = sscanf(line1, "%*d %*s %lf %lf %lf %lf",
+            params, params + 1, params + 2, &otime_step);
+    if (istat < nparams)
+        return (-1);
+
+    sprintf(MsgStr, "Time2EQ EQRANDOM:  NumEvents: %ld  Dist: %s  Params: %lf %lf %lf %lf %lf %lf  OTimeStep: %lf",
+            num_events, str_dist, params[0], params[1], params[2], params[3], params[4], params[5], otime_step);
+    nll_putmsg(2, MsgStr);
+
+    if (num_events < 1 || otime_step < 0.0)
+        return (-1);
+
+    NumRandomEvents = num_events;
+    RandomEventDist = dist;
+    memcpy(RandomEventParams, params, sizeof (params));
+    otime_EQSRCE_step = otime_step;
+
+    return (0);
+
+}
+
+/*** function to read mis-pick params ***/
+
+int GetTime2EQ_MisPick(char* line1) {
+
+    int istat, ierr;
+
+    istat = sscanf(line1, "%lf %lf %lf", &ProbMisPickShift, &MaxMisPickShift, &ProbMisPickPhaseSwap);
+
+    sprintf(MsgStr, "Time2EQ EQMISPICK:  ProbTimeShift: %lf  MaxTimeShift: %lf  ProbPhaseSwap: %lf",
+            ProbMisPickShift, MaxMisPickShift, ProbMisPickPhaseSwap);
+    nll_putmsg(2, MsgStr);
+
+    ierr = 0;
+    if (checkRangeDouble("EQMISPICK", "ProbTimeShift", ProbMisPickShift, 1, 0.0, 1, 1.0) != 0)
+        ierr = -1;
+    if (checkRangeDouble("EQMISPICK", "MaxTimeShift", MaxMisPickShift, 1, 0.0, 0, 0.0) != 0)
+        ierr = -1;
+    if (checkRangeDouble("EQMISPICK", "ProbPhaseSwap", ProbMisPickPhaseSwap, 1, 0.0, 1, 1.0) != 0)
+        ierr = -1;
+
+    if (ierr < 0 || istat != 3) {
+        ProbMisPickShift = ProbMisPickPhaseSwap = 0.0;
+        return (-1);
+    }
+
+    return (0);
+
+}
+
 /*** function to read mode params ***/
 
 int GetTime2EQ_Mode(char* line1) {
@@ -31,8 +31,8 @@
 /*                          planes x (resp. z)=Ct, each plane consisting of   */
 /*                          a suite of y=Ct vectors when this program is      */
 /*                          called from a program written in C (resp.FORTRAN).*/
-/*                          hs and t are 3D pointers allocated in order       */
-/*                          to address points and cells straightforwardly.    */
+/*                          hs and t are addressed as flat arrays through     */
+/*                          macros HS_AT(x, y, z) and T_AT(x, y, z).          */
 /*                          Implicitly staggered grids are used: t[][][]      */
 /*                          represent arrival times at grid-points, whereas   */
 /*                          hs[][][] describe (constant) slownesses in cells. */
@@ -209,15 +209,25 @@ edge_diff(int, int, int, GRID_FLOAT_TYPE, GRID_FLOAT_TYPE, GRID_FLOAT_TYPE);
 static int
 nmesh_x, nmesh_y, nmesh_z; /* Model dimensions (cells) */
 static GRID_FLOAT_TYPE
-        ***hs, *hs_buf, /* 1D and 3D arrays */
+        *hs_buf, /* 1D array, addressed through HS_AT() */
         *hs_keep = (GRID_FLOAT_TYPE *) NULL; /* to save boundary values */
 
 /* TIMEFIELD */
 
 static int
-nx, ny, nz; /* Timefield dimensions (nodes) */
+nx, ny, nz, /* Timefield dimensions (nodes) */
+        nyz; /* x-plane stride (ny*nz) of the flat arrays */
 static GRID_FLOAT_TYPE
-***t, *t_buf; /* 1D and 3D arrays */
+*t_buf; /* 1D array, addressed through T_AT() */
+
+/* 20261018 - flat addressing of hs and t.
+ * hs and t were previously GRID_FLOAT_TYPE *** pointer arrays (one malloc per x plane)
+ * built over hs_buf/t_buf; every node access then cost two dependent pointer loads.
+ * The buffers are laid out x-plane, then y-vector, then z (see header), so a node
+ * is addressed directly by its flat offset.  Results are unchanged. */
+#define NODE_INDEX(x,y,z)   ((x)*nyz+(y)*nz+(z))
+#define HS_AT(x,y,z)        hs_buf[NODE_INDEX(x,y,z)]
+#define T_AT(x,y,z)         t_buf[NODE_INDEX(x,y,z)]
 
 /* SOURCE */
 
@@ -279,6 +289,20 @@ hs_eps_init; /* tolerance on homogeneity
 
 #define SMALLTALK        messages
 #define VERBOSE          messages==2
+/* 20261018 - parallel "a-causal" first pass of the *_side() functions.
+ * Only this first pass is parallel.  The scan_* sweeps are sequential and not tiled:
+ * their stencils read times just updated on the same side, and the update order
+ * decides head wave detection, so reordering them would change the time field. */
+#ifdef _OPENMP
+#include <omp.h>
+#define SIDE_COLORS      3      /* rows y, y+3, ... of a side never update common nodes */
+#else
+#define SIDE_COLORS      1      /* serial: original row order */
+#endif
+#ifndef SIDE_PARALLEL_MIN
+#define SIDE_PARALLEL_MIN    4096   /* minimum side size (nodes) for a parallel first pass */
+#endif
+
 /*------------------------------------------------Error flags---------------*/
 
 #define NO_ERROR         0
@@ -449,30 +473,12 @@ pre_init() {
     if (n1 == n0) n0 = max(ny, nz);
     n1 *= n0;
 
-    /* allocate pointers */
-    if (!(hs = (GRID_FLOAT_TYPE ***) malloc((unsigned) nx * sizeof (GRID_FLOAT_TYPE **))))
-        return (ERR_MALLOC);
-    if (!(t = (GRID_FLOAT_TYPE ***) malloc((unsigned) nx * sizeof (GRID_FLOAT_TYPE **)))) {
-        free((char *) hs);
-        return (ERR_MALLOC);
-    }
-    if (!(longflags = (int *) malloc((unsigned) n1 * sizeof (int)))) {
-        free((char *) t);
-        free((char *) hs);
+    nyz = np;
+
+    /* allocate headwave flags (hs and t are addressed flat, see HS_AT/T_AT) */
+    if (!(longflags = (int *) malloc((unsigned) n1 * sizeof (int))))
         return (ERR_MALLOC);
-    }/* size of the largest side of the model */
-    for (x = 0; x < nx; x++)
-        if (!(hs[x] = (GRID_FLOAT_TYPE **) malloc((unsigned) ny * sizeof (GRID_FLOAT_TYPE *)))
-                || !(t[x] = (GRID_FLOAT_TYPE **) malloc((unsigned) ny * sizeof (GRID_FLOAT_TYPE *)))
-                ) {
-            free_ptrs(x);
-            return (ERR_MALLOC);
-        }
-    for (x = 0; x < nx; x++)
-        for (y = 0; y < ny; y++) {
-            hs[x][y] = hs_buf + x * np + y*nz;
-            t[x][y] = t_buf + x * np + y*nz;
-        }
+    /* size of the largest side of the model */
 
     /* stop here if recursive call */
     if (init_stage) return (NO_ERROR);
@@ -491,18 +497,18 @@ pre_init() {
     pf = hs_keep;
     for (x = 0; x < nx; x++) {
         for (y = 0; y < ny; y++) {
-            *pf++ = hs[x][y][nmesh_z];
-            hs[x][y][nmesh_z] = INFINITY;
+            *pf++ = HS_AT(x, y, nmesh_z);
+            HS_AT(x, y, nmesh_z) = INFINITY;
         }
         for (z = 0; z < nmesh_z; z++) {
-            *pf++ = hs[x][nmesh_y][z];
-            hs[x][nmesh_y][z] = INFINITY;
+            *pf++ = HS_AT(x, nmesh_y, z);
+            HS_AT(x, nmesh_y, z) = INFINITY;
         }
     }
     for (y = 0; y < nmesh_y; y++)
         for (z = 0; z < nmesh_z; z++) {
-            *pf++ = hs[nmesh_x][y][z];
-            hs[nmesh_x][y][z] = INFINITY;
+            *pf++ = HS_AT(nmesh_x, y, z);
+            HS_AT(nmesh_x, y, z) = INFINITY;
         }
 
     /* test for negative slowness value */
@@ -539,8 +545,8 @@ init_point() {
         for (x = 0, min_t = INFINITY; x < nx; x++)
             for (y = 0; y < ny; y++)
                 for (z = 0; z < nz; z++)
-                    if (t[x][y][z] < min_t) {
-                        min_t = t[x][y][z];
+                    if (T_AT(x, y, z) < min_t) {
+                        min_t = T_AT(x, y, z);
                         xs = x;
                         ys = y;
                         zs = z;
@@ -567,29 +573,29 @@ init_point() {
     /* test relevance of slowness at the vicinity of the source */
     /* (not tested in the case of multiple source)              */
     if (source_at_node) {
-        hs0 = hs[xs][ys][zs];
-        if (ISINF(hs0) && zs) hs0 = hs[xs][ys][zs - 1];
-        if (ISINF(hs0) && ys) hs0 = hs[xs][ys - 1][zs];
-        if (ISINF(hs0) && xs) hs0 = hs[xs - 1][ys][zs];
-        if (ISINF(hs0) && zs && ys) hs0 = hs[xs][ys - 1][zs - 1];
-        if (ISINF(hs0) && zs && xs) hs0 = hs[xs - 1][ys][zs - 1];
-        if (ISINF(hs0) && ys && xs) hs0 = hs[xs - 1][ys - 1][zs];
-        if (ISINF(hs0) && zs && ys && xs) hs0 = hs[xs - 1][ys - 1][zs - 1];
+        hs0 = HS_AT(xs, ys, zs);
+        if (ISINF(hs0) && zs) hs0 = HS_AT(xs, ys, zs - 1);
+        if (ISINF(hs0) && ys) hs0 = HS_AT(xs, ys - 1, zs);
+        if (ISINF(hs0) && xs) hs0 = HS_AT(xs - 1, ys, zs);
+        if (ISINF(hs0) && zs && ys) hs0 = HS_AT(xs, ys - 1, zs - 1);
+        if (ISINF(hs0) && zs && xs) hs0 = HS_AT(xs - 1, ys, zs - 1);
+        if (ISINF(hs0) && ys && xs) hs0 = HS_AT(xs - 1, ys - 1, zs);
+        if (ISINF(hs0) && zs && ys && xs) hs0 = HS_AT(xs - 1, ys - 1, zs - 1);
     } else if (!mult) {
         x = (fxs < xs) ? xs - 1 : xs;
         y = (fys < ys) ? ys - 1 : ys;
         z = (fzs < zs) ? zs - 1 : zs;
-        hs0 = hs[x][y][z];
+        hs0 = HS_AT(x, y, z);
         if (ISINF(hs0) && fxs == xs && xs) {
-            hs0 = hs[x - 1][y][z];
-            if (ISINF(hs0) && fys == ys && ys) hs0 = hs[x - 1][y - 1][z];
-            if (ISINF(hs0) && fzs == zs && zs) hs0 = hs[x - 1][y][z - 1];
+            hs0 = HS_AT(x - 1, y, z);
+            if (ISINF(hs0) && fys == ys && ys) hs0 = HS_AT(x - 1, y - 1, z);
+            if (ISINF(hs0) && fzs == zs && zs) hs0 = HS_AT(x - 1, y, z - 1);
         }
         if (ISINF(hs0) && fys == ys && ys) {
-            hs0 = hs[x][y - 1][z];
-            if (ISINF(hs0) && fzs == zs && zs) hs0 = hs[x][y - 1][z - 1];
+            hs0 = HS_AT(x, y - 1, z);
+            if (ISINF(hs0) && fzs == zs && zs) hs0 = HS_AT(x, y - 1, z - 1);
         }
-        if (ISINF(hs0) && fzs == zs && zs) hs0 = hs[x][y][z - 1];
+        if (ISINF(hs0) && fzs == zs && zs) hs0 = HS_AT(x, y, z - 1);
     }
     if (ISINF(hs0)) return (ERR_INF);
 
@@ -630,7 +636,7 @@ init_point() {
             x = X0;
             for (y = Y0; y <= Y1 && y < nmesh_y && !t_X0; y++)
                 for (z = Z0; z <= Z1 && z < nmesh_z && !t_X0; z++)
-                    if (fabs(hs[x][y][z] - hs0) > allowed_delta_hs) t_X0 = 1;
+                    if (fabs(HS_AT(x, y, z) - hs0) > allowed_delta_hs) t_X0 = 1;
             if (!t_X0) X0--;
         }
         if (Y0 && !t_Y0) {
@@ -638,7 +644,7 @@ init_point() {
             y = Y0;
             for (x = X0; x <= X1 && x < nmesh_x && !t_Y0; x++)
                 for (z = Z0; z <= Z1 && z < nmesh_z && !t_Y0; z++)
-                    if (fabs(hs[x][y][z] - hs0) > allowed_delta_hs) t_Y0 = 1;
+                    if (fabs(HS_AT(x, y, z) - hs0) > allowed_delta_hs) t_Y0 = 1;
             if (!t_Y0) Y0--;
         }
         if (Z0 && !t_Z0) {
@@ -646,7 +652,7 @@ init_point() {
             z = Z0;
             for (x = X0; x <= X1 && x < nmesh_x && !t_Z0; x++)
                 for (y = Y0; y <= Y1 && y < nmesh_y && !t_Z0; y++)
-                    if (fabs(hs[x][y][z] - hs0) > allowed_delta_hs) t_Z0 = 1;
+                    if (fabs(HS_AT(x, y, z) - hs0) > allowed_delta_hs) t_Z0 = 1;
             if (!t_Z0) Z0--;
         }
         if (X1 < nmesh_x && !t_X1) {
@@ -655,7 +661,7 @@ init_point() {
             x = X1;
             for (y = Y0; y <= Y1 && y < nmesh_y && !t_X1; y++)
                 for (z = Z0; z <= Z1 && z < nmesh_z && !t_X1; z++)
-                    if (fabs(hs[x][y][z] - hs0) > allowed_delta_hs) t_X1 = 1;
+                    if (fabs(HS_AT(x, y, z) - hs0) > allowed_delta_hs) t_X1 = 1;
         }
         if (Y1 < nmesh_y && !t_Y1) {
             test++;
@@ -663,7 +669,7 @@ init_point() {
             y = Y1;
             for (x = X0; x <= X1 && x < nmesh_x && !t_Y1; x++)
                 for (z = Z0; z <= Z1 && z < nmesh_z && !t_Y1; z++)
-                    if (fabs(hs[x][y][z] - hs0) > allowed_delta_hs) t_Y1 = 1;
+                    if (fabs(HS_AT(x, y, z) - hs0) > allowed_delta_hs) t_Y1 = 1;
         }
         if (Z1 < nmesh_z && !t_Z1) {
             test++;
@@ -671,7 +677,7 @@ init_point() {
             z = Z1;
             for (x = X0; x <= X1 && x < nmesh_x && !t_Z1; x++)
                 for (y = Y0; y <= Y1 && y < nmesh_y && !t_Z1; y++)
-                    if (fabs(hs[x][y][z] - hs0) > allowed_delta_hs) t_Z1 = 1;
+                    if (fabs(HS_AT(x, y, z) - hs0) > allowed_delta_hs) t_Z1 = 1;
         }
     } while (test);
 
@@ -701,8 +707,8 @@ init_point() {
                         // 20250422 ALomax - only update if shorter time. TODO: is this safe?
                         //20250422 ALomax//t[x][y][z] = hs0 * sqrt(dist);
                         double time_test = hs0 * sqrt(dist);
-                        if (ISINF(t[x][y][z]) || time_test < t[x][y][z]) {
-                            t[x][y][z] = time_test;
+                        if (ISINF(T_AT(x, y, z)) || time_test < T_AT(x, y, z)) {
+                            T_AT(x, y, z) = time_test;
                         }
                     }
         if (SMALLTALK)
@@ -743,7 +749,7 @@ init_nearest()
     GRID_FLOAT_TYPE distx, disty, distz;
 
     if (source_at_node) {
-        t[xs][ys][zs] = 0.0;
+        T_AT(xs, ys, zs) = 0.0;
         return;
     }
     x = (fxs < xs) ? xs - 1 : xs;
@@ -801,21 +807,21 @@ init_cell(GRID_FLOAT_TYPE vx, GRID_FLOAT_TYPE vy, GRID_FLOAT_TYPE vz, int xl, in
 /* vx,vy,vz are distances from source to node xl,yl,zl (0<=vx<=1.0,...) */ {
     GRID_FLOAT_TYPE est;
     est = exact_delay(vx, vy, vz, xl, yl, zl);
-    if (est < t[xl][yl][zl]) t[xl][yl][zl] = est;
+    if (est < T_AT(xl, yl, zl)) T_AT(xl, yl, zl) = est;
     est = exact_delay(1.0 - vx, vy, vz, xl, yl, zl);
-    if (est < t[xl + 1][yl][zl]) t[xl + 1][yl][zl] = est;
+    if (est < T_AT(xl + 1, yl, zl)) T_AT(xl + 1, yl, zl) = est;
     est = exact_delay(vx, 1.0 - vy, vz, xl, yl, zl);
-    if (est < t[xl][yl + 1][zl]) t[xl][yl + 1][zl] = est;
+    if (est < T_AT(xl, yl + 1, zl)) T_AT(xl, yl + 1, zl) = est;
     est = exact_delay(vx, vy, 1.0 - vz, xl, yl, zl);
-    if (est < t[xl][yl][zl + 1]) t[xl][yl][zl + 1] = est;
+    if (est < T_AT(xl, yl, zl + 1)) T_AT(xl, yl, zl + 1) = est;
     est = exact_delay(1.0 - vx, 1.0 - vy, vz, xl, yl, zl);
-    if (est < t[xl + 1][yl + 1][zl]) t[xl + 1][yl + 1][zl] = est;
+    if (est < T_AT(xl + 1, yl + 1, zl)) T_AT(xl + 1, yl + 1, zl) = est;
     est = exact_delay(1.0 - vx, vy, 1.0 - vz, xl, yl, zl);
-    if (est < t[xl + 1][yl][zl + 1]) t[xl + 1][yl][zl + 1] = est;
+    if (est < T_AT(xl + 1, yl, zl + 1)) T_AT(xl + 1, yl, zl + 1) = est;
     est = exact_delay(vx, 1.0 - vy, 1.0 - vz, xl, yl, zl);
-    if (est < t[xl][yl + 1][zl + 1]) t[xl][yl + 1][zl + 1] = est;
+    if (est < T_AT(xl, yl + 1, zl + 1)) T_AT(xl, yl + 1, zl + 1) = est;
     est = exact_delay(1.0 - vx, 1.0 - vy, 1.0 - vz, xl, yl, zl);
-    if (est < t[xl + 1][yl + 1][zl + 1]) t[xl + 1][yl + 1][zl + 1] = est;
+    if (est < T_AT(xl + 1, yl + 1, zl + 1)) T_AT(xl + 1, yl + 1, zl + 1) = est;
 }
 
 /*------------------------------------------------Recursive_init()----------*/
@@ -841,7 +847,7 @@ recursive_init() {
     if (SMALLTALK)
         printf("\nRecursive initialization: level %d", init_stage);
 
-    /* free locally allocated pointers (GRID_FLOAT_TYPE ***) */
+    /* free locally allocated headwave flags */
     free_ptrs(nx);
 
     /* save static parameters at this stage */
@@ -1051,21 +1057,15 @@ int max_x;
     if (init_stage == 0 && hs_keep) {
         pf = hs_keep;
         for (x = 0; x < nx; x++) {
-            for (y = 0; y < ny; y++) hs[x][y][nmesh_z] = *pf++;
-            for (z = 0; z < nmesh_z; z++) hs[x][nmesh_y][z] = *pf++;
+            for (y = 0; y < ny; y++) HS_AT(x, y, nmesh_z) = *pf++;
+            for (z = 0; z < nmesh_z; z++) HS_AT(x, nmesh_y, z) = *pf++;
         }
         for (y = 0; y < nmesh_y; y++)
-            for (z = 0; z < nmesh_z; z++) hs[nmesh_x][y][z] = *pf++;
+            for (z = 0; z < nmesh_z; z++) HS_AT(nmesh_x, y, z) = *pf++;
         free((char *) hs_keep);
     }
 
     /* free pointers */
-    for (x = 0; x < max_x; x++) {
-        free((char *) hs[x]);
-        free((char *) t[x]);
-    }
-    free((char *) hs);
-    free((char *) t);
     free((char *) longflags);
 
 }
@@ -1095,7 +1095,7 @@ exact_delay(GRID_FLOAT_TYPE vx, GRID_FLOAT_TYPE vy, GRID_FLOAT_TYPE vz, int xm,
 
     if (xm < 0 || xm >= nmesh_x || ym < 0 || ym >= nmesh_y || zm < 0 || zm >= nmesh_z)
         return (INFINITY);
-    estimate = (vx * vx + vy * vy + vz * vz) * hs[xm][ym][zm] * hs[xm][ym][zm];
+    estimate = (vx * vx + vy * vy + vz * vz) * HS_AT(xm, ym, zm) * HS_AT(xm, ym, zm);
     return (sqrt(estimate));
 }
 
@@ -1106,8 +1106,8 @@ static int
 t_1d(int x, int y, int z, GRID_FLOAT_TYPE t0, GRID_FLOAT_TYPE hs0, GRID_FLOAT_TYPE hs1, GRID_FLOAT_TYPE hs2, GRID_FLOAT_TYPE hs3) {
     GRID_FLOAT_TYPE estimate;
     estimate = t0 + min4(hs0, hs1, hs2, hs3);
-    if (estimate < t[x][y][z]) {
-        t[x][y][z] = estimate;
+    if (estimate < T_AT(x, y, z)) {
+        T_AT(x, y, z) = estimate;
         return (1);
     }
     return (0);
@@ -1120,8 +1120,8 @@ static int
 diff_2d(int x, int y, int z, GRID_FLOAT_TYPE t0, GRID_FLOAT_TYPE hs0, GRID_FLOAT_TYPE hs1) {
     GRID_FLOAT_TYPE estimate;
     estimate = t0 + M_SQRT2 * min(hs0, hs1);
-    if (estimate < t[x][y][z]) {
-        t[x][y][z] = estimate;
+    if (estimate < T_AT(x, y, z)) {
+        T_AT(x, y, z) = estimate;
         return (1);
     }
     return (0);
@@ -1134,8 +1134,8 @@ static int
 point_diff(int x, int y, int z, GRID_FLOAT_TYPE t0, GRID_FLOAT_TYPE hs0) {
     GRID_FLOAT_TYPE estimate;
     estimate = t0 + hs0*M_SQRT3;
-    if (estimate < t[x][y][z]) {
-        t[x][y][z] = estimate;
+    if (estimate < T_AT(x, y, z)) {
+        T_AT(x, y, z) = estimate;
         return (1);
     }
     return (0);
@@ -1148,15 +1148,15 @@ static int
 t_2d(int x, int y, int z, GRID_FLOAT_TYPE t0, GRID_FLOAT_TYPE t1, GRID_FLOAT_TYPE hs0, GRID_FLOAT_TYPE hs1) {
     GRID_FLOAT_TYPE estimate, dt, hsm, test2, u2;
     dt = t1 - t0;
-    test2 = t[x][y][z] - t1;
+    test2 = T_AT(x, y, z) - t1;
     if (dt < 0.0 || test2 < 0.0) return (0);
     test2 *= test2;
     hsm = min(hs0, hs1);
     u2 = hsm * hsm - dt*dt;
     if (dt <= hsm / M_SQRT2 && u2 <= test2) {
         estimate = t1 + sqrt(u2);
-        if (estimate < t[x][y][z]) {
-            t[x][y][z] = estimate;
+        if (estimate < T_AT(x, y, z)) {
+            T_AT(x, y, z) = estimate;
             return (1);
         }
     }
@@ -1170,14 +1170,14 @@ static int
 edge_diff(int x, int y, int z, GRID_FLOAT_TYPE t0, GRID_FLOAT_TYPE t1, GRID_FLOAT_TYPE hs0) {
     GRID_FLOAT_TYPE estimate, u2, test2, dt;
     dt = t1 - t0;
-    test2 = t[x][y][z] - t1;
+    test2 = T_AT(x, y, z) - t1;
     if (dt < 0.0 || test2 < 0.0) return (0);
     test2 *= test2;
     u2 = hs0 * hs0 - dt*dt;
     if (dt <= hs0 / M_SQRT3 && 2.0 * u2 <= test2) {
         estimate = t1 + M_SQRT2 * sqrt(u2);
-        if (estimate < t[x][y][z]) {
-            t[x][y][z] = estimate;
+        if (estimate < T_AT(x, y, z)) {
+            T_AT(x, y, z) = estimate;
             return (1);
         }
     }
@@ -1209,21 +1209,21 @@ t_3d_(int x, int y, int z, GRID_FLOAT_TYPE t0, GRID_FLOAT_TYPE tl, GRID_FLOAT_TY
     dtb2 = dtb*dtb;
     if (dta >= 0.0 && dtb >= 0.0 && dta2 + dtb2 + dta * dtb >= 0.5 * hs0
             && 2.0 * dta2 + dtb2 <= hs0 && 2.0 * dtb2 + dta2 <= hs0) {
-        test2 = t[x][y][z] - tr - tl + t0;
+        test2 = T_AT(x, y, z) - tr - tl + t0;
         if (test2 >= 0.0) {
             test2 *= test2;
             r2 = hs0 - dta2 - dtb2;
             if (r2 < test2) {
                 estimate = tr + tl - t0 + sqrt(r2);
-                if (estimate < t[x][y][z]) {
-                    t[x][y][z] = estimate;
+                if (estimate < T_AT(x, y, z)) {
+                    T_AT(x, y, z) = estimate;
                     action++;
                 }
             }
         }
     }
 
-    test2 = t[x][y][z] - td;
+    test2 = T_AT(x, y, z) - td;
     if (test2 < 0.0) return (action);
     test2 *= test2;
     s2 = t2 = u2 = INFINITY;
@@ -1246,8 +1246,8 @@ t_3d_(int x, int y, int z, GRID_FLOAT_TYPE t0, GRID_FLOAT_TYPE tl, GRID_FLOAT_TY
     u2 = min3(s2, t2, u2);
     if (u2 < test2) {
         estimate = td + sqrt(u2);
-        if (estimate < t[x][y][z]) {
-            t[x][y][z] = estimate;
+        if (estimate < T_AT(x, y, z)) {
+            T_AT(x, y, z) = estimate;
             action++;
         }
     }
@@ -1265,7 +1265,7 @@ t_3d_part1(int x, int y, int z, GRID_FLOAT_TYPE t0, GRID_FLOAT_TYPE tl, GRID_FLO
     GRID_FLOAT_TYPE dtl, dtr, s2, u2, estimate, test2;
     dtl = t0 - tl;
     dtr = t0 - tr;
-    test2 = t[x][y][z] - t0;
+    test2 = T_AT(x, y, z) - t0;
     if (test2 < 0.0 || dtl < 0.0 || dtr < 0.0) return (0);
     test2 *= test2;
     hs0 *= hs0;
@@ -1275,8 +1275,8 @@ t_3d_part1(int x, int y, int z, GRID_FLOAT_TYPE t0, GRID_FLOAT_TYPE tl, GRID_FLO
     u2 = hs0 - s2;
     if (u2 < test2) {
         estimate = t0 + sqrt(u2);
-        if (estimate < t[x][y][z]) {
-            t[x][y][z] = estimate;
+        if (estimate < T_AT(x, y, z)) {
+            T_AT(x, y, z) = estimate;
             return (1);
         }
     }
@@ -1307,6 +1307,7 @@ int y_begin, y_end, z_begin, z_end, x, future;
             y, z, /* current point coordinate */
             sign_ff, sign_bf, sign_bb, sign_fb, /* sign flags for time differences */
             past, /* opposite to future ! */
+            color, /* row class for the parallel first pass */
             test;
     GRID_FLOAT_TYPE
     hs_ff, hs_bf, hs_bb, hs_fb; /* local slownesses */
@@ -1332,103 +1333,119 @@ int y_begin, y_end, z_begin, z_end, x, future;
     /* are diagnosed, according to the time pattern on side x0.    */
     /* Borders of zones to be scanned are computed.                */
     /* This part may be seen as the explicit part of the FD scheme.*/
+    /* 20261018 - The first pass only writes side x within one row of */
+    /* the source node row, so rows are processed in SIDE_COLORS       */
+    /* classes (y modulo SIDE_COLORS); rows in one class never touch   */
+    /* the same nodes and are timed concurrently (OpenMP). The result  */
+    /* does not depend on the number of threads, but some stencil      */
+    /* validity tests use the current time at the node, so with OpenMP */
+    /* times may differ from the serial row order by rounding (ulp).   */
+
+    for (color = 0; color < SIDE_COLORS; color++) {
+#ifdef _OPENMP
+#pragma omp parallel for private(z, hs_ff, hs_bf, hs_bb, hs_fb, sign_ff, sign_bf, sign_bb, sign_fb) \
+            reduction(+:updated) \
+            reduction(min:y_start_ff, y_start_fb, z_start_ff, z_start_bf) \
+            reduction(max:y_start_bf, y_start_bb, z_start_fb, z_start_bb, flag_ff, flag_bf, flag_bb, flag_fb) \
+            if ((y_end - y_begin + 1) * (z_end - z_begin + 1) >= SIDE_PARALLEL_MIN)
+#endif
+        for (y = y_begin + color; y <= y_end; y += SIDE_COLORS) {
+            for (z = z_begin; z <= z_end; z++) {
+
+                hs_ff = HS_AT(x_s, y, z);
+                if (y > 0) hs_bf = HS_AT(x_s, y - 1, z);
+                else hs_bf = INFINITY;
+                if (z > 0 && y > 0) hs_bb = HS_AT(x_s, y - 1, z - 1);
+                else hs_bb = INFINITY;
+                if (z > 0) hs_fb = HS_AT(x_s, y, z - 1);
+                else hs_fb = INFINITY;
+                sign_fb = sign_bf = sign_ff = sign_bb = 0;
+
+                /* illuminate first neighbours */
+                /* 1 1D transmission and 4 partial 3D transmission */
+                updated += t_1d(x, y, z, T_AT(x0, y, z), hs_ff, hs_bf, hs_bb, hs_fb);
+                if (y < y_end && z < z_end)
+                    updated += t_3d_part1(x, y, z,
+                        T_AT(x0, y, z), T_AT(x0, y + 1, z), T_AT(x0, y, z + 1), hs_ff);
+                if (y > y_begin && z < z_end)
+                    updated += t_3d_part1(x, y, z,
+                        T_AT(x0, y, z), T_AT(x0, y - 1, z), T_AT(x0, y, z + 1), hs_bf);
+                if (y > y_begin && z > z_begin)
+                    updated += t_3d_part1(x, y, z,
+                        T_AT(x0, y, z), T_AT(x0, y - 1, z), T_AT(x0, y, z - 1), hs_bb);
+                if (y < y_end && z > z_begin)
+                    updated += t_3d_part1(x, y, z,
+                        T_AT(x0, y, z), T_AT(x0, y + 1, z), T_AT(x0, y, z - 1), hs_fb);
+
+                /* illuminate second neighbours (if necessary)    */
+                /* 4 2D diffraction and 4 2D transmission */
+                if (y < y_end && T_AT(x0, y, z) <= T_AT(x0, y + 1, z)) {
+                    sign_fb++;
+                    sign_ff++;
+                    if (y < y_start_ff) y_start_ff = y;
+                    if (y < y_start_fb) y_start_fb = y;
+                    updated += diff_2d(x, y + 1, z, T_AT(x0, y, z), hs_ff, hs_fb);
+                    updated += t_2d(x, y + 1, z, T_AT(x0, y, z), T_AT(x0, y + 1, z), hs_ff, hs_fb);
+                }
+                if (y > y_begin && T_AT(x0, y, z) <= T_AT(x0, y - 1, z)) {
+                    sign_bb++;
+                    sign_bf++;
+                    if (y > y_start_bf) y_start_bf = y;
+                    if (y > y_start_bb) y_start_bb = y;
+                    updated += diff_2d(x, y - 1, z, T_AT(x0, y, z), hs_bf, hs_bb);
+                    updated += t_2d(x, y - 1, z, T_AT(x0, y, z), T_AT(x0, y - 1, z), hs_bf, hs_bb);
+                }
+                if (z < z_end && T_AT(x0, y, z) <= T_AT(x0, y, z + 1)) {
+                    sign_bf++;
+                    sign_ff++;
+                    if (z < z_start_ff) z_start_ff = z;
+                    if (z < z_start_bf) z_start_bf = z;
+                    updated += diff_2d(x, y, z + 1, T_AT(x0, y, z), hs_ff, hs_bf);
+                    updated += t_2d(x, y, z + 1, T_AT(x0, y, z), T_AT(x0, y, z + 1), hs_ff, hs_bf);
+                }
+                if (z > z_begin && T_AT(x0, y, z) <= T_AT(x0, y, z - 1)) {
+                    sign_bb++;
+                    sign_fb++;
+                    if (z > z_start_fb) z_start_fb = z;
+                    if (z > z_start_bb) z_start_bb = z;
+                    updated += diff_2d(x, y, z - 1, T_AT(x0, y, z), hs_bb, hs_fb);
+                    updated += t_2d(x, y, z - 1, T_AT(x0, y, z), T_AT(x0, y, z - 1), hs_bb, hs_fb);
+                }
 
-    for (y = y_begin; y <= y_end; y++) {
-        for (z = z_begin; z <= z_end; z++) {
-
-            hs_ff = hs[x_s][y][z];
-            if (y > 0) hs_bf = hs[x_s][y - 1][z];
-            else hs_bf = INFINITY;
-            if (z > 0 && y > 0) hs_bb = hs[x_s][y - 1][z - 1];
-            else hs_bb = INFINITY;
-            if (z > 0) hs_fb = hs[x_s][y][z - 1];
-            else hs_fb = INFINITY;
-            sign_fb = sign_bf = sign_ff = sign_bb = 0;
-
-            /* illuminate first neighbours */
-            /* 1 1D transmission and 4 partial 3D transmission */
-            updated += t_1d(x, y, z, t[x0][y][z], hs_ff, hs_bf, hs_bb, hs_fb);
-            if (y < y_end && z < z_end)
-                updated += t_3d_part1(x, y, z,
-                    t[x0][y][z], t[x0][y + 1][z], t[x0][y][z + 1], hs_ff);
-            if (y > y_begin && z < z_end)
-                updated += t_3d_part1(x, y, z,
-                    t[x0][y][z], t[x0][y - 1][z], t[x0][y][z + 1], hs_bf);
-            if (y > y_begin && z > z_begin)
-                updated += t_3d_part1(x, y, z,
-                    t[x0][y][z], t[x0][y - 1][z], t[x0][y][z - 1], hs_bb);
-            if (y < y_end && z > z_begin)
-                updated += t_3d_part1(x, y, z,
-                    t[x0][y][z], t[x0][y + 1][z], t[x0][y][z - 1], hs_fb);
-
-            /* illuminate second neighbours (if necessary)    */
-            /* 4 2D diffraction and 4 2D transmission */
-            if (y < y_end && t[x0][y][z] <= t[x0][y + 1][z]) {
-                sign_fb++;
-                sign_ff++;
-                if (y < y_start_ff) y_start_ff = y;
-                if (y < y_start_fb) y_start_fb = y;
-                updated += diff_2d(x, y + 1, z, t[x0][y][z], hs_ff, hs_fb);
-                updated += t_2d(x, y + 1, z, t[x0][y][z], t[x0][y + 1][z], hs_ff, hs_fb);
-            }
-            if (y > y_begin && t[x0][y][z] <= t[x0][y - 1][z]) {
-                sign_bb++;
-                sign_bf++;
-                if (y > y_start_bf) y_start_bf = y;
-                if (y > y_start_bb) y_start_bb = y;
-                updated += diff_2d(x, y - 1, z, t[x0][y][z], hs_bf, hs_bb);
-                updated += t_2d(x, y - 1, z, t[x0][y][z], t[x0][y - 1][z], hs_bf, hs_bb);
-            }
-            if (z < z_end && t[x0][y][z] <= t[x0][y][z + 1]) {
-                sign_bf++;
-                sign_ff++;
-                if (z < z_start_ff) z_start_ff = z;
-                if (z < z_start_bf) z_start_bf = z;
-                updated += diff_2d(x, y, z + 1, t[x0][y][z], hs_ff, hs_bf);
-                updated += t_2d(x, y, z + 1, t[x0][y][z], t[x0][y][z + 1], hs_ff, hs_bf);
-            }
-            if (z > z_begin && t[x0][y][z] <= t[x0][y][z - 1]) {
-                sign_bb++;
-                sign_fb++;
-                if (z > z_start_fb) z_start_fb = z;
-                if (z > z_start_bb) z_start_bb = z;
-                updated += diff_2d(x, y, z - 1, t[x0][y][z], hs_bb, hs_fb);
-                updated += t_2d(x, y, z - 1, t[x0][y][z], t[x0][y][z - 1], hs_bb, hs_fb);
-            }
-
-            /* illuminate third neighbours (if necessary) */
-            /* 4 3D point diffraction, 8 3D edge diffraction and 12 3D transmission */
-            if (sign_ff == 2) {
-                flag_ff = 1;
-                updated += point_diff(x, y + 1, z + 1, t[x0][y][z], hs_ff);
-                updated += edge_diff(x, y + 1, z + 1, t[x0][y][z], t[x0][y + 1][z], hs_ff);
-                updated += edge_diff(x, y + 1, z + 1, t[x0][y][z], t[x0][y][z + 1], hs_ff);
-                updated += t_3d_part2(x, y + 1, z + 1, t[x0][y][z],
-                        t[x0][y + 1][z], t[x0][y][z + 1], t[x0][y + 1][z + 1], hs_ff);
-            }
-            if (sign_bf == 2) {
-                flag_bf = 1;
-                updated += point_diff(x, y - 1, z + 1, t[x0][y][z], hs_bf);
-                updated += edge_diff(x, y - 1, z + 1, t[x0][y][z], t[x0][y - 1][z], hs_bf);
-                updated += edge_diff(x, y - 1, z + 1, t[x0][y][z], t[x0][y][z + 1], hs_bf);
-                updated += t_3d_part2(x, y - 1, z + 1, t[x0][y][z],
-                        t[x0][y - 1][z], t[x0][y][z + 1], t[x0][y - 1][z + 1], hs_bf);
-            }
-            if (sign_bb == 2) {
-                flag_bb = 1;
-                updated += point_diff(x, y - 1, z - 1, t[x0][y][z], hs_bb);
-                updated += edge_diff(x, y - 1, z - 1, t[x0][y][z], t[x0][y - 1][z], hs_bb);
-                updated += edge_diff(x, y - 1, z - 1, t[x0][y][z], t[x0][y][z - 1], hs_bb);
-                updated += t_3d_part2(x, y - 1, z - 1, t[x0][y][z],
-                        t[x0][y - 1][z], t[x0][y][z - 1], t[x0][y - 1][z - 1], hs_bb);
-            }
-            if (sign_fb == 2) {
-                flag_fb = 1;
-                updated += point_diff(x, y + 1, z - 1, t[x0][y][z], hs_fb);
-                updated += edge_diff(x, y + 1, z - 1, t[x0][y][z], t[x0][y + 1][z], hs_fb);
-                updated += edge_diff(x, y + 1, z - 1, t[x0][y][z], t[x0][y][z - 1], hs_fb);
-                updated += t_3d_part2(x, y + 1, z - 1, t[x0][y][z],
-                        t[x0][y + 1][z], t[x0][y][z - 1], t[x0][y + 1][z - 1], hs_fb);
+                /* illuminate third neighbours (if necessary) */
+                /* 4 3D point diffraction, 8 3D edge diffraction and 12 3D transmission */
+                if (sign_ff == 2) {
+                    flag_ff = 1;
+                    updated += point_diff(x, y + 1, z + 1, T_AT(x0, y, z), hs_ff);
+                    updated += edge_diff(x, y + 1, z + 1, T_AT(x0, y, z), T_AT(x0, y + 1, z), hs_ff);
+                    updated += edge_diff(x, y + 1, z + 1, T_AT(x0, y, z), T_AT(x0, y, z + 1), hs_ff);
+                    updated += t_3d_part2(x, y + 1, z + 1, T_AT(x0, y, z),
+                            T_AT(x0, y + 1, z), T_AT(x0, y, z + 1), T_AT(x0, y + 1, z + 1), hs_ff);
+                }
+                if (sign_bf == 2) {
+                    flag_bf = 1;
+                    updated += point_diff(x, y - 1, z + 1, T_AT(x0, y, z), hs_bf);
+                    updated += edge_diff(x, y - 1, z + 1, T_AT(x0, y, z), T_AT(x0, y - 1, z), hs_bf);
+                    updated += edge_diff(x, y - 1, z + 1, T_AT(x0, y, z), T_AT(x0, y, z + 1), hs_bf);
+                    updated += t_3d_part2(x, y - 1, z + 1, T_AT(x0, y, z),
+                            T_AT(x0, y - 1, z), T_AT(x0, y, z + 1), T_AT(x0, y - 1, z + 1), hs_bf);
+                }
+                if (sign_bb == 2) {
+                    flag_bb = 1;
+                    updated += point_diff(x, y - 1, z - 1, T_AT(x0, y, z), hs_bb);
+                    updated += edge_diff(x, y - 1, z - 1, T_AT(x0, y, z), T_AT(x0, y - 1, z), hs_bb);
+                    updated += edge_diff(x, y - 1, z - 1, T_AT(x0, y, z), T_AT(x0, y, z - 1), hs_bb);
+                    updated += t_3d_part2(x, y - 1, z - 1, T_AT(x0, y, z),
+                            T_AT(x0, y - 1, z), T_AT(x0, y, z - 1), T_AT(x0, y - 1, z - 1), hs_bb);
+                }
+                if (sign_fb == 2) {
+                    flag_fb = 1;
+                    updated += point_diff(x, y + 1, z - 1, T_AT(x0, y, z), hs_fb);
+                    updated += edge_diff(x, y + 1, z - 1, T_AT(x0, y, z), T_AT(x0, y + 1, z), hs_fb);
+                    updated += edge_diff(x, y + 1, z - 1, T_AT(x0, y, z), T_AT(x0, y, z - 1), hs_fb);
+                    updated += t_3d_part2(x, y + 1, z - 1, T_AT(x0, y, z),
+                            T_AT(x0, y + 1, z), T_AT(x0, y, z - 1), T_AT(x0, y + 1, z - 1), hs_fb);
+                }
             }
         }
     }
@@ -1548,14 +1565,14 @@ int y_start, y_end, z_start, z_end, x0, x, x_s;
     /* interface waves along y_side: 1 1D transmission and 1 2D transmission */
     hs_bb = hs_ubb = hs_ube = INFINITY;
     for (y = y_start, z = z_start; y < y_end; y++) {
-        hs_bf = hs[x_s][y][z];
-        if (z) hs_bb = hs[x_s][y][z - 1];
+        hs_bf = HS_AT(x_s, y, z);
+        if (z) hs_bb = HS_AT(x_s, y, z - 1);
         if (x_sf >= 0 && x_sf < nmesh_x) {
-            hs_ube = hs[x_sf][y][z];
-            if (z) hs_ubb = hs[x_sf][y][z - 1];
+            hs_ube = HS_AT(x_sf, y, z);
+            if (z) hs_ubb = HS_AT(x_sf, y, z - 1);
         }
-        alert1 = t_1d(x, y + 1, z, t[x][y][z], hs_bb, hs_bf, hs_ubb, hs_ube);
-        alert0 = t_2d(x, y + 1, z, t[x0][y][z], t[x][y][z], hs_bb, hs_bf);
+        alert1 = t_1d(x, y + 1, z, T_AT(x, y, z), hs_bb, hs_bf, hs_ubb, hs_ube);
+        alert0 = t_2d(x, y + 1, z, T_AT(x0, y, z), T_AT(x, y, z), hs_bb, hs_bf);
         updated += alert0 + alert1;
         if (alert1) longflags[y * nz + nz + z] = 1;
         if (alert0) longflags[y * nz + nz + z] = 0;
@@ -1564,14 +1581,14 @@ int y_start, y_end, z_start, z_end, x0, x, x_s;
     /* interface waves along z_side: 1 1D transmission and 1 2D transmission */
     hs_bb = hs_ubb = hs_ueb = INFINITY;
     for (y = y_start, z = z_start; z < z_end; z++) {
-        hs_fb = hs[x_s][y][z];
-        if (y) hs_bb = hs[x_s][y - 1][z];
+        hs_fb = HS_AT(x_s, y, z);
+        if (y) hs_bb = HS_AT(x_s, y - 1, z);
         if (x_sf >= 0 && x_sf < nmesh_x) {
-            hs_ueb = hs[x_sf][y][z];
-            if (y) hs_ubb = hs[x_sf][y - 1][z];
+            hs_ueb = HS_AT(x_sf, y, z);
+            if (y) hs_ubb = HS_AT(x_sf, y - 1, z);
         }
-        alert1 = t_1d(x, y, z + 1, t[x][y][z], hs_bb, hs_fb, hs_ubb, hs_ueb);
-        alert0 = t_2d(x, y, z + 1, t[x0][y][z], t[x][y][z], hs_bb, hs_fb);
+        alert1 = t_1d(x, y, z + 1, T_AT(x, y, z), hs_bb, hs_fb, hs_ubb, hs_ueb);
+        alert0 = t_2d(x, y, z + 1, T_AT(x0, y, z), T_AT(x, y, z), hs_bb, hs_fb);
         updated += alert0 + alert1;
         if (alert1) longflags[y * nz + z + 1] = 1;
         if (alert0) longflags[y * nz + z + 1] = 0;
@@ -1582,29 +1599,29 @@ int y_start, y_end, z_start, z_end, x0, x, x_s;
     for (y = y_start; y < y_end; y++) {
         for (z = z_start; z < z_end; z++) {
 
-            hs_bb = hs[x_s][y][z];
-            hs_bf = hs[x_s][y][z + 1];
-            hs_fb = hs[x_s][y + 1][z];
+            hs_bb = HS_AT(x_s, y, z);
+            hs_bf = HS_AT(x_s, y, z + 1);
+            hs_fb = HS_AT(x_s, y + 1, z);
             if (x_sf >= 0 && x_sf < nmesh_x) {
-                hs_ubb = hs[x_sf][y][z];
-                hs_ube = hs[x_sf][y][z + 1];
-                hs_ueb = hs[x_sf][y + 1][z];
+                hs_ubb = HS_AT(x_sf, y, z);
+                hs_ube = HS_AT(x_sf, y, z + 1);
+                hs_ueb = HS_AT(x_sf, y + 1, z);
             } else hs_ubb = hs_ube = hs_ueb = INFINITY;
 
             /* bulk waves: 1 3D edge diffraction and 2 (*4) 3D transmission */
-            alert0 = edge_diff(x, y + 1, z + 1, t[x0][y][z], t[x][y][z], hs_bb)
-                    + t_3d(x, y + 1, z + 1, t[x0][y][z],
-                    t[x0][y + 1][z], t[x][y][z], t[x][y + 1][z], hs_bb)
-                    + t_3d(x, y + 1, z + 1, t[x0][y][z],
-                    t[x0][y][z + 1], t[x][y][z], t[x][y][z + 1], hs_bb);
+            alert0 = edge_diff(x, y + 1, z + 1, T_AT(x0, y, z), T_AT(x, y, z), hs_bb)
+                    + t_3d(x, y + 1, z + 1, T_AT(x0, y, z),
+                    T_AT(x0, y + 1, z), T_AT(x, y, z), T_AT(x, y + 1, z), hs_bb)
+                    + t_3d(x, y + 1, z + 1, T_AT(x0, y, z),
+                    T_AT(x0, y, z + 1), T_AT(x, y, z), T_AT(x, y, z + 1), hs_bb);
             if (alert0) {
                 updated += alert0;
                 longflags[y * nz + nz + z + 1] = 0;
             }
 
             /* interface waves along y_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x, y + 1, z + 1, t[x][y][z + 1], hs_bb, hs_bf, hs_ubb, hs_ube);
-            alert0 = t_2d(x, y + 1, z + 1, t[x0][y][z + 1], t[x][y][z + 1], hs_bb, hs_bf);
+            alert1 = t_1d(x, y + 1, z + 1, T_AT(x, y, z + 1), hs_bb, hs_bf, hs_ubb, hs_ube);
+            alert0 = t_2d(x, y + 1, z + 1, T_AT(x0, y, z + 1), T_AT(x, y, z + 1), hs_bb, hs_bf);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_fb++; /* this scan must be (re-)examined */
@@ -1615,8 +1632,8 @@ int y_start, y_end, z_start, z_end, x0, x, x_s;
             }
 
             /* interface waves along z_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x, y + 1, z + 1, t[x][y + 1][z], hs_bb, hs_fb, hs_ubb, hs_ueb);
-            alert0 = t_2d(x, y + 1, z + 1, t[x0][y + 1][z], t[x][y + 1][z], hs_bb, hs_fb);
+            alert1 = t_1d(x, y + 1, z + 1, T_AT(x, y + 1, z), hs_bb, hs_fb, hs_ubb, hs_ueb);
+            alert0 = t_2d(x, y + 1, z + 1, T_AT(x0, y + 1, z), T_AT(x, y + 1, z), hs_bb, hs_fb);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_bf++; /* this scan must be (re-)examined */
@@ -1627,9 +1644,9 @@ int y_start, y_end, z_start, z_end, x0, x, x_s;
             }
 
             /* interface waves along x_side : 2 2D transmission and 1 2D diffraction */
-            alert1 = diff_2d(x, y + 1, z + 1, t[x][y][z], hs_bb, hs_ubb)
-                    + t_2d(x, y + 1, z + 1, t[x][y][z], t[x][y + 1][z], hs_bb, hs_ubb)
-                    + t_2d(x, y + 1, z + 1, t[x][y][z], t[x][y][z + 1], hs_bb, hs_ubb);
+            alert1 = diff_2d(x, y + 1, z + 1, T_AT(x, y, z), hs_bb, hs_ubb)
+                    + t_2d(x, y + 1, z + 1, T_AT(x, y, z), T_AT(x, y + 1, z), hs_bb, hs_ubb)
+                    + t_2d(x, y + 1, z + 1, T_AT(x, y, z), T_AT(x, y, z + 1), hs_bb, hs_ubb);
             if (alert1) {
                 updated += alert1;
                 longflags[y * nz + nz + z + 1] = 1;
@@ -1665,14 +1682,14 @@ int y_start, y_begin, z_start, z_end, x0, x, x_s;
 
     hs_fb = hs_uee = hs_ueb = INFINITY;
     for (y = y_start, z = z_start; y > y_begin; y--) {
-        hs_ff = hs[x_s][y - 1][z];
-        if (z) hs_fb = hs[x_s][y - 1][z - 1];
+        hs_ff = HS_AT(x_s, y - 1, z);
+        if (z) hs_fb = HS_AT(x_s, y - 1, z - 1);
         if (x_sf >= 0 && x_sf < nmesh_x) {
-            hs_uee = hs[x_sf][y - 1][z];
-            if (z) hs_ueb = hs[x_sf][y - 1][z - 1];
+            hs_uee = HS_AT(x_sf, y - 1, z);
+            if (z) hs_ueb = HS_AT(x_sf, y - 1, z - 1);
         }
-        alert1 = t_1d(x, y - 1, z, t[x][y][z], hs_fb, hs_ff, hs_ueb, hs_uee);
-        alert0 = t_2d(x, y - 1, z, t[x0][y][z], t[x][y][z], hs_fb, hs_ff);
+        alert1 = t_1d(x, y - 1, z, T_AT(x, y, z), hs_fb, hs_ff, hs_ueb, hs_uee);
+        alert0 = t_2d(x, y - 1, z, T_AT(x0, y, z), T_AT(x, y, z), hs_fb, hs_ff);
         updated += alert0 + alert1;
         if (alert1) longflags[y * nz - nz + z] = 1;
         if (alert0) longflags[y * nz - nz + z] = 0;
@@ -1680,14 +1697,14 @@ int y_start, y_begin, z_start, z_end, x0, x, x_s;
 
     hs_bb = hs_ubb = hs_ueb = INFINITY;
     for (y = y_start, z = z_start; z < z_end; z++) {
-        if (y) hs_bb = hs[x_s][y - 1][z];
-        hs_fb = hs[x_s][y][z];
+        if (y) hs_bb = HS_AT(x_s, y - 1, z);
+        hs_fb = HS_AT(x_s, y, z);
         if (x_sf >= 0 && x_sf < nmesh_x) {
-            if (y) hs_ubb = hs[x_sf][y - 1][z];
-            hs_ueb = hs[x_sf][y][z];
+            if (y) hs_ubb = HS_AT(x_sf, y - 1, z);
+            hs_ueb = HS_AT(x_sf, y, z);
         }
-        alert1 = t_1d(x, y, z + 1, t[x][y][z], hs_bb, hs_fb, hs_ubb, hs_ueb);
-        alert0 = t_2d(x, y, z + 1, t[x0][y][z], t[x][y][z], hs_bb, hs_fb);
+        alert1 = t_1d(x, y, z + 1, T_AT(x, y, z), hs_bb, hs_fb, hs_ubb, hs_ueb);
+        alert0 = t_2d(x, y, z + 1, T_AT(x0, y, z), T_AT(x, y, z), hs_bb, hs_fb);
         updated += alert0 + alert1;
         if (alert1) longflags[y * nz + z + 1] = 1;
         if (alert0) longflags[y * nz + z + 1] = 0;
@@ -1696,31 +1713,31 @@ int y_start, y_begin, z_start, z_end, x0, x, x_s;
     for (y = y_start; y > y_begin; y--) {
         for (z = z_start; z < z_end; z++) {
 
-            hs_ff = hs[x_s][y - 1][z + 1];
-            if (y > 1) hs_bb = hs[x_s][y - 2][z];
+            hs_ff = HS_AT(x_s, y - 1, z + 1);
+            if (y > 1) hs_bb = HS_AT(x_s, y - 2, z);
             else hs_bb = INFINITY;
-            hs_fb = hs[x_s][y - 1][z];
+            hs_fb = HS_AT(x_s, y - 1, z);
             if (x_sf >= 0 && x_sf < nmesh_x) {
-                hs_uee = hs[x_sf][y - 1][z + 1];
-                if (y > 1) hs_ubb = hs[x_sf][y - 2][z];
+                hs_uee = HS_AT(x_sf, y - 1, z + 1);
+                if (y > 1) hs_ubb = HS_AT(x_sf, y - 2, z);
                 else hs_ubb = INFINITY;
-                hs_ueb = hs[x_sf][y - 1][z];
+                hs_ueb = HS_AT(x_sf, y - 1, z);
             } else hs_ubb = hs_uee = hs_ueb = INFINITY;
 
             /* bulk waves: 1 3D edge diffraction and 2 (*4) 3D transmission */
-            alert0 = edge_diff(x, y - 1, z + 1, t[x0][y][z], t[x][y][z], hs_fb)
-                    + t_3d(x, y - 1, z + 1, t[x0][y][z],
-                    t[x0][y - 1][z], t[x][y][z], t[x][y - 1][z], hs_fb)
-                    + t_3d(x, y - 1, z + 1, t[x0][y][z],
-                    t[x0][y][z + 1], t[x][y][z], t[x][y][z + 1], hs_fb);
+            alert0 = edge_diff(x, y - 1, z + 1, T_AT(x0, y, z), T_AT(x, y, z), hs_fb)
+                    + t_3d(x, y - 1, z + 1, T_AT(x0, y, z),
+                    T_AT(x0, y - 1, z), T_AT(x, y, z), T_AT(x, y - 1, z), hs_fb)
+                    + t_3d(x, y - 1, z + 1, T_AT(x0, y, z),
+                    T_AT(x0, y, z + 1), T_AT(x, y, z), T_AT(x, y, z + 1), hs_fb);
             if (alert0) {
                 updated += alert0;
                 longflags[y * nz - nz + z + 1] = 0;
             }
 
             /* interface waves along y_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x, y - 1, z + 1, t[x][y][z + 1], hs_ff, hs_fb, hs_uee, hs_ueb);
-            alert0 = t_2d(x, y - 1, z + 1, t[x0][y][z + 1], t[x][y][z + 1], hs_ff, hs_fb);
+            alert1 = t_1d(x, y - 1, z + 1, T_AT(x, y, z + 1), hs_ff, hs_fb, hs_uee, hs_ueb);
+            alert0 = t_2d(x, y - 1, z + 1, T_AT(x0, y, z + 1), T_AT(x, y, z + 1), hs_ff, hs_fb);
             if (alert0 + alert1) {
                 // 20100204 AJL Satriano Bug Fix.
                 updated += alert0 + alert1;
@@ -1733,8 +1750,8 @@ int y_start, y_begin, z_start, z_end, x0, x, x_s;
             }
 
             /* interface waves along z_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x, y - 1, z + 1, t[x][y - 1][z], hs_bb, hs_fb, hs_ubb, hs_ueb);
-            alert0 = t_2d(x, y - 1, z + 1, t[x0][y - 1][z], t[x][y - 1][z], hs_bb, hs_fb);
+            alert1 = t_1d(x, y - 1, z + 1, T_AT(x, y - 1, z), hs_bb, hs_fb, hs_ubb, hs_ueb);
+            alert0 = t_2d(x, y - 1, z + 1, T_AT(x0, y - 1, z), T_AT(x, y - 1, z), hs_bb, hs_fb);
             if (alert0 + alert1) {
                 // 20100204 AJL Satriano Bug Fix.
                 updated += alert0 + alert1;
@@ -1747,9 +1764,9 @@ int y_start, y_begin, z_start, z_end, x0, x, x_s;
             }
 
             /* interface waves along x_side : 2 2D transmission and 1 2D diffraction */
-            alert1 = diff_2d(x, y - 1, z + 1, t[x][y][z], hs_fb, hs_ueb)
-                    + t_2d(x, y - 1, z + 1, t[x][y][z], t[x][y - 1][z], hs_fb, hs_ueb)
-                    + t_2d(x, y - 1, z + 1, t[x][y][z], t[x][y][z + 1], hs_fb, hs_ueb);
+            alert1 = diff_2d(x, y - 1, z + 1, T_AT(x, y, z), hs_fb, hs_ueb)
+                    + t_2d(x, y - 1, z + 1, T_AT(x, y, z), T_AT(x, y - 1, z), hs_fb, hs_ueb)
+                    + t_2d(x, y - 1, z + 1, T_AT(x, y, z), T_AT(x, y, z + 1), hs_fb, hs_ueb);
             if (alert1) {
                 updated += alert1;
                 longflags[y * nz - nz + z + 1] = 1;
@@ -1785,14 +1802,14 @@ int y_start, y_begin, z_begin, z_start, x0, x, x_s;
 
     hs_ff = hs_uee = hs_ueb = INFINITY;
     for (y = y_start, z = z_start; y > y_begin; y--) {
-        if (z) hs_ff = hs[x_s][y - 1][z - 1];
-        hs_fb = hs[x_s][y - 1][z];
+        if (z) hs_ff = HS_AT(x_s, y - 1, z - 1);
+        hs_fb = HS_AT(x_s, y - 1, z);
         if (x_sf >= 0 && x_sf < nmesh_x) {
-            if (z) hs_uee = hs[x_sf][y - 1][z - 1];
-            hs_ueb = hs[x_sf][y - 1][z];
+            if (z) hs_uee = HS_AT(x_sf, y - 1, z - 1);
+            hs_ueb = HS_AT(x_sf, y - 1, z);
         }
-        alert1 = t_1d(x, y - 1, z, t[x][y][z], hs_fb, hs_ff, hs_ueb, hs_uee);
-        alert0 = t_2d(x, y - 1, z, t[x0][y][z], t[x][y][z], hs_fb, hs_ff);
+        alert1 = t_1d(x, y - 1, z, T_AT(x, y, z), hs_fb, hs_ff, hs_ueb, hs_uee);
+        alert0 = t_2d(x, y - 1, z, T_AT(x0, y, z), T_AT(x, y, z), hs_fb, hs_ff);
         updated += alert0 + alert1;
         if (alert1) longflags[y * nz - nz + z] = 1;
         if (alert0) longflags[y * nz - nz + z] = 0;
@@ -1800,14 +1817,14 @@ int y_start, y_begin, z_begin, z_start, x0, x, x_s;
 
     hs_ff = hs_uee = hs_ube = INFINITY;
     for (y = y_start, z = z_start; z > z_begin; z--) {
-        if (y) hs_ff = hs[x_s][y - 1][z - 1];
-        hs_bf = hs[x_s][y][z - 1];
+        if (y) hs_ff = HS_AT(x_s, y - 1, z - 1);
+        hs_bf = HS_AT(x_s, y, z - 1);
         if (x_sf >= 0 && x_sf < nmesh_x) {
-            if (y) hs_uee = hs[x_sf][y - 1][z - 1];
-            hs_ube = hs[x_sf][y][z - 1];
+            if (y) hs_uee = HS_AT(x_sf, y - 1, z - 1);
+            hs_ube = HS_AT(x_sf, y, z - 1);
         }
-        alert1 = t_1d(x, y, z - 1, t[x][y][z], hs_bf, hs_ff, hs_ube, hs_uee);
-        alert0 = t_2d(x, y, z - 1, t[x0][y][z], t[x][y][z], hs_bf, hs_ff);
+        alert1 = t_1d(x, y, z - 1, T_AT(x, y, z), hs_bf, hs_ff, hs_ube, hs_uee);
+        alert0 = t_2d(x, y, z - 1, T_AT(x0, y, z), T_AT(x, y, z), hs_bf, hs_ff);
         updated += alert0 + alert1;
         if (alert1) longflags[y * nz + z - 1] = 1;
         if (alert0) longflags[y * nz + z - 1] = 0;
@@ -1816,33 +1833,33 @@ int y_start, y_begin, z_begin, z_start, x0, x, x_s;
     for (y = y_start; y > y_begin; y--) {
         for (z = z_start; z > z_begin; z--) {
 
-            hs_ff = hs[x_s][y - 1][z - 1];
-            if (y > 1) hs_bf = hs[x_s][y - 2][z - 1];
+            hs_ff = HS_AT(x_s, y - 1, z - 1);
+            if (y > 1) hs_bf = HS_AT(x_s, y - 2, z - 1);
             else hs_bf = INFINITY;
-            if (z > 1) hs_fb = hs[x_s][y - 1][z - 2];
+            if (z > 1) hs_fb = HS_AT(x_s, y - 1, z - 2);
             else hs_fb = INFINITY;
             if (x_sf >= 0 && x_sf < nmesh_x) {
-                hs_uee = hs[x_sf][y - 1][z - 1];
-                if (y > 1) hs_ube = hs[x_sf][y - 2][z - 1];
+                hs_uee = HS_AT(x_sf, y - 1, z - 1);
+                if (y > 1) hs_ube = HS_AT(x_sf, y - 2, z - 1);
                 else hs_ube = INFINITY;
-                if (z > 1) hs_ueb = hs[x_sf][y - 1][z - 2];
+                if (z > 1) hs_ueb = HS_AT(x_sf, y - 1, z - 2);
                 else hs_ueb = INFINITY;
             } else hs_uee = hs_ube = hs_ueb = INFINITY;
 
             /* bulk waves: 1 3D edge diffraction and 2 (*4) 3D transmission */
-            alert0 = edge_diff(x, y - 1, z - 1, t[x0][y][z], t[x][y][z], hs_ff)
-                    + t_3d(x, y - 1, z - 1, t[x0][y][z],
-                    t[x0][y - 1][z], t[x][y][z], t[x][y - 1][z], hs_ff)
-                    + t_3d(x, y - 1, z - 1, t[x0][y][z],
-                    t[x0][y][z - 1], t[x][y][z], t[x][y][z - 1], hs_ff);
+            alert0 = edge_diff(x, y - 1, z - 1, T_AT(x0, y, z), T_AT(x, y, z), hs_ff)
+                    + t_3d(x, y - 1, z - 1, T_AT(x0, y, z),
+                    T_AT(x0, y - 1, z), T_AT(x, y, z), T_AT(x, y - 1, z), hs_ff)
+                    + t_3d(x, y - 1, z - 1, T_AT(x0, y, z),
+                    T_AT(x0, y, z - 1), T_AT(x, y, z), T_AT(x, y, z - 1), hs_ff);
             if (alert0) {
                 updated += alert0;
                 longflags[y * nz - nz + z - 1] = 0;
             }
 
             /* interface waves along y_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x, y - 1, z - 1, t[x][y][z - 1], hs_ff, hs_fb, hs_uee, hs_ueb);
-            alert0 = t_2d(x, y - 1, z - 1, t[x0][y][z - 1], t[x][y][z - 1], hs_ff, hs_fb);
+            alert1 = t_1d(x, y - 1, z - 1, T_AT(x, y, z - 1), hs_ff, hs_fb, hs_uee, hs_ueb);
+            alert0 = t_2d(x, y - 1, z - 1, T_AT(x0, y, z - 1), T_AT(x, y, z - 1), hs_ff, hs_fb);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_bf++; /* this scan must be (re-)examined */
@@ -1853,8 +1870,8 @@ int y_start, y_begin, z_begin, z_start, x0, x, x_s;
             }
 
             /* interface waves along z_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x, y - 1, z - 1, t[x][y - 1][z], hs_ff, hs_bf, hs_uee, hs_ube);
-            alert0 = t_2d(x, y - 1, z - 1, t[x0][y - 1][z], t[x][y - 1][z], hs_ff, hs_bf);
+            alert1 = t_1d(x, y - 1, z - 1, T_AT(x, y - 1, z), hs_ff, hs_bf, hs_uee, hs_ube);
+            alert0 = t_2d(x, y - 1, z - 1, T_AT(x0, y - 1, z), T_AT(x, y - 1, z), hs_ff, hs_bf);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_fb++; /* this scan must be (re-)examined */
@@ -1865,9 +1882,9 @@ int y_start, y_begin, z_begin, z_start, x0, x, x_s;
             }
 
             /* interface waves along x_side : 2 2D transmission and 1 2D diffraction */
-            alert1 = diff_2d(x, y - 1, z - 1, t[x][y][z], hs_ff, hs_uee)
-                    + t_2d(x, y - 1, z - 1, t[x][y][z], t[x][y - 1][z], hs_ff, hs_uee)
-                    + t_2d(x, y - 1, z - 1, t[x][y][z], t[x][y][z - 1], hs_ff, hs_uee);
+            alert1 = diff_2d(x, y - 1, z - 1, T_AT(x, y, z), hs_ff, hs_uee)
+                    + t_2d(x, y - 1, z - 1, T_AT(x, y, z), T_AT(x, y - 1, z), hs_ff, hs_uee)
+                    + t_2d(x, y - 1, z - 1, T_AT(x, y, z), T_AT(x, y, z - 1), hs_ff, hs_uee);
             if (alert1) {
                 updated += alert1;
                 longflags[y * nz - nz + z - 1] = 1;
@@ -1903,14 +1920,14 @@ int y_start, y_end, z_begin, z_start, x0, x, x_s;
 
     hs_bf = hs_ubb = hs_ube = INFINITY;
     for (y = y_start, z = z_start; y < y_end; y++) {
-        if (z) hs_bf = hs[x_s][y][z - 1];
-        hs_bb = hs[x_s][y][z];
+        if (z) hs_bf = HS_AT(x_s, y, z - 1);
+        hs_bb = HS_AT(x_s, y, z);
         if (x_sf >= 0 && x_sf < nmesh_x) {
-            if (z) hs_ube = hs[x_sf][y][z - 1];
-            hs_ubb = hs[x_sf][y][z];
+            if (z) hs_ube = HS_AT(x_sf, y, z - 1);
+            hs_ubb = HS_AT(x_sf, y, z);
         }
-        alert1 = t_1d(x, y + 1, z, t[x][y][z], hs_bf, hs_bb, hs_ube, hs_ubb);
-        alert0 = t_2d(x, y + 1, z, t[x0][y][z], t[x][y][z], hs_bf, hs_bb);
+        alert1 = t_1d(x, y + 1, z, T_AT(x, y, z), hs_bf, hs_bb, hs_ube, hs_ubb);
+        alert0 = t_2d(x, y + 1, z, T_AT(x0, y, z), T_AT(x, y, z), hs_bf, hs_bb);
         updated += alert0 + alert1;
         if (alert1) longflags[y * nz + nz + z] = 1;
         if (alert0) longflags[y * nz + nz + z] = 0;
@@ -1918,14 +1935,14 @@ int y_start, y_end, z_begin, z_start, x0, x, x_s;
 
     hs_ff = hs_uee = hs_ube = INFINITY;
     for (y = y_start, z = z_start; z > z_begin; z--) {
-        if (y) hs_ff = hs[x_s][y - 1][z - 1];
-        hs_bf = hs[x_s][y][z - 1];
+        if (y) hs_ff = HS_AT(x_s, y - 1, z - 1);
+        hs_bf = HS_AT(x_s, y, z - 1);
         if (x_sf >= 0 && x_sf < nmesh_x) {
-            if (y) hs_uee = hs[x_sf][y - 1][z - 1];
-            hs_ube = hs[x_sf][y][z - 1];
+            if (y) hs_uee = HS_AT(x_sf, y - 1, z - 1);
+            hs_ube = HS_AT(x_sf, y, z - 1);
         }
-        alert1 = t_1d(x, y, z - 1, t[x][y][z], hs_bf, hs_ff, hs_ube, hs_uee);
-        alert0 = t_2d(x, y, z - 1, t[x0][y][z], t[x][y][z], hs_bf, hs_ff);
+        alert1 = t_1d(x, y, z - 1, T_AT(x, y, z), hs_bf, hs_ff, hs_ube, hs_uee);
+        alert0 = t_2d(x, y, z - 1, T_AT(x0, y, z), T_AT(x, y, z), hs_bf, hs_ff);
         updated += alert0 + alert1;
         if (alert1) longflags[y * nz + z - 1] = 1;
         if (alert0) longflags[y * nz + z - 1] = 0;
@@ -1934,31 +1951,31 @@ int y_start, y_end, z_begin, z_start, x0, x, x_s;
     for (y = y_start; y < y_end; y++) {
         for (z = z_start; z > z_begin; z--) {
 
-            hs_bf = hs[x_s][y][z - 1];
-            if (z > 1) hs_bb = hs[x_s][y][z - 2];
+            hs_bf = HS_AT(x_s, y, z - 1);
+            if (z > 1) hs_bb = HS_AT(x_s, y, z - 2);
             else hs_bb = INFINITY;
-            hs_ff = hs[x_s][y + 1][z - 1];
+            hs_ff = HS_AT(x_s, y + 1, z - 1);
             if (x_sf >= 0 && x_sf < nmesh_x) {
-                hs_ube = hs[x_sf][y][z - 1];
-                if (z > 1) hs_ubb = hs[x_sf][y][z - 2];
+                hs_ube = HS_AT(x_sf, y, z - 1);
+                if (z > 1) hs_ubb = HS_AT(x_sf, y, z - 2);
                 else hs_ubb = INFINITY;
-                hs_uee = hs[x_sf][y + 1][z - 1];
+                hs_uee = HS_AT(x_sf, y + 1, z - 1);
             } else hs_ubb = hs_ube = hs_uee = INFINITY;
 
             /* bulk waves: 1 3D edge diffraction and 2 (*4) 3D transmission */
-            alert0 = edge_diff(x, y + 1, z - 1, t[x0][y][z], t[x][y][z], hs_bf)
-                    + t_3d(x, y + 1, z - 1, t[x0][y][z],
-                    t[x0][y + 1][z], t[x][y][z], t[x][y + 1][z], hs_bf)
-                    + t_3d(x, y + 1, z - 1, t[x0][y][z],
-                    t[x0][y][z - 1], t[x][y][z], t[x][y][z - 1], hs_bf);
+            alert0 = edge_diff(x, y + 1, z - 1, T_AT(x0, y, z), T_AT(x, y, z), hs_bf)
+                    + t_3d(x, y + 1, z - 1, T_AT(x0, y, z),
+                    T_AT(x0, y + 1, z), T_AT(x, y, z), T_AT(x, y + 1, z), hs_bf)
+                    + t_3d(x, y + 1, z - 1, T_AT(x0, y, z),
+                    T_AT(x0, y, z - 1), T_AT(x, y, z), T_AT(x, y, z - 1), hs_bf);
             if (alert0) {
                 updated += alert0;
                 longflags[y * nz + nz + z - 1] = 0;
             }
 
             /* interface waves along y_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x, y + 1, z - 1, t[x][y][z - 1], hs_bb, hs_bf, hs_ubb, hs_ube);
-            alert0 = t_2d(x, y + 1, z - 1, t[x0][y][z - 1], t[x][y][z - 1], hs_bb, hs_bf);
+            alert1 = t_1d(x, y + 1, z - 1, T_AT(x, y, z - 1), hs_bb, hs_bf, hs_ubb, hs_ube);
+            alert0 = t_2d(x, y + 1, z - 1, T_AT(x0, y, z - 1), T_AT(x, y, z - 1), hs_bb, hs_bf);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_ff++; /* this scan must be (re-)examined */
@@ -1969,8 +1986,8 @@ int y_start, y_end, z_begin, z_start, x0, x, x_s;
             }
 
             /* interface waves along z_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x, y + 1, z - 1, t[x][y + 1][z], hs_ff, hs_bf, hs_uee, hs_ube);
-            alert0 = t_2d(x, y + 1, z - 1, t[x0][y + 1][z], t[x][y + 1][z], hs_ff, hs_bf);
+            alert1 = t_1d(x, y + 1, z - 1, T_AT(x, y + 1, z), hs_ff, hs_bf, hs_uee, hs_ube);
+            alert0 = t_2d(x, y + 1, z - 1, T_AT(x0, y + 1, z), T_AT(x, y + 1, z), hs_ff, hs_bf);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_bb++; /* this scan must be (re-)examined */
@@ -1981,9 +1998,9 @@ int y_start, y_end, z_begin, z_start, x0, x, x_s;
             }
 
             /* interface waves along x_side : 2 2D transmission and 1 2D diffraction */
-            alert1 = diff_2d(x, y + 1, z - 1, t[x][y][z], hs_bf, hs_ube)
-                    + t_2d(x, y + 1, z - 1, t[x][y][z], t[x][y + 1][z], hs_bf, hs_ube)
-                    + t_2d(x, y + 1, z - 1, t[x][y][z], t[x][y][z - 1], hs_bf, hs_ube);
+            alert1 = diff_2d(x, y + 1, z - 1, T_AT(x, y, z), hs_bf, hs_ube)
+                    + t_2d(x, y + 1, z - 1, T_AT(x, y, z), T_AT(x, y + 1, z), hs_bf, hs_ube)
+                    + t_2d(x, y + 1, z - 1, T_AT(x, y, z), T_AT(x, y, z - 1), hs_bf, hs_ube);
             if (alert1) {
                 updated++;
                 longflags[y * nz + nz + z - 1] = 1;
@@ -2024,7 +2041,8 @@ int x_begin, x_end, z_begin, z_end, y, future;
             x, z,
             sign_ff, sign_bf, sign_bb, sign_fb,
             test,
-            past;
+            past,
+            color;
     GRID_FLOAT_TYPE
     hs_ff, hs_bf, hs_bb, hs_fb;
 
@@ -2043,102 +2061,111 @@ int x_begin, x_end, z_begin, z_end, y, future;
 
     /* First Step: "a-causal" stencils */
 
-    for (x = x_begin; x <= x_end; x++) {
-        for (z = z_begin; z <= z_end; z++) {
-            hs_ff = hs[x][y_s][z];
-            if (x > 0) hs_bf = hs[x - 1][y_s][z];
-            else hs_bf = INFINITY;
-            if (x > 0 && z > 0) hs_bb = hs[x - 1][y_s][z - 1];
-            else hs_bb = INFINITY;
-            if (z > 0) hs_fb = hs[x][y_s][z - 1];
-            else hs_fb = INFINITY;
-
-            sign_ff = sign_bf = sign_bb = sign_fb = 0;
-
-            /* illuminate first neighbours */
-            /* 1 1D transmission and 4 partial 3D transmission */
-            updated += t_1d(x, y, z, t[x][y0][z], hs_ff, hs_bf, hs_bb, hs_fb);
-            if (x < x_end && z < z_end)
-                updated += t_3d_part1(x, y, z,
-                    t[x][y0][z], t[x + 1][y0][z], t[x][y0][z + 1], hs_ff);
-            if (x > x_begin && z < z_end)
-                updated += t_3d_part1(x, y, z,
-                    t[x][y0][z], t[x - 1][y0][z], t[x][y0][z + 1], hs_bf);
-            if (x > x_begin && z > z_begin)
-                updated += t_3d_part1(x, y, z,
-                    t[x][y0][z], t[x - 1][y0][z], t[x][y0][z - 1], hs_bb);
-            if (x < x_end && z > z_begin)
-                updated += t_3d_part1(x, y, z,
-                    t[x][y0][z], t[x + 1][y0][z], t[x][y0][z - 1], hs_fb);
-
-            /* illuminate second neighbours */
-            /* 4 2D diffraction and 4 2D transmission */
-            if (x < x_end && t[x][y0][z] <= t[x + 1][y0][z]) {
-                sign_fb++;
-                sign_ff++;
-                if (x < x_start_ff) x_start_ff = x;
-                if (x < x_start_fb) x_start_fb = x;
-                updated += diff_2d(x + 1, y, z, t[x][y0][z], hs_ff, hs_fb);
-                updated += t_2d(x + 1, y, z, t[x][y0][z], t[x + 1][y0][z], hs_ff, hs_fb);
-            }
-            if (x > x_begin && t[x][y0][z] <= t[x - 1][y0][z]) {
-                sign_bb++;
-                sign_bf++;
-                if (x > x_start_bf) x_start_bf = x;
-                if (x > x_start_bb) x_start_bb = x;
-                updated += diff_2d(x - 1, y, z, t[x][y0][z], hs_bf, hs_bb);
-                updated += t_2d(x - 1, y, z, t[x][y0][z], t[x - 1][y0][z], hs_bf, hs_bb);
-            }
-            if (z < z_end && t[x][y0][z] <= t[x][y0][z + 1]) {
-                sign_bf++;
-                sign_ff++;
-                if (z < z_start_ff) z_start_ff = z;
-                if (z < z_start_bf) z_start_bf = z;
-                updated += diff_2d(x, y, z + 1, t[x][y0][z], hs_ff, hs_bf);
-                updated += t_2d(x, y, z + 1, t[x][y0][z], t[x][y0][z + 1], hs_ff, hs_bf);
-            }
-            if (z > z_begin && t[x][y0][z] <= t[x][y0][z - 1]) {
-                sign_bb++;
-                sign_fb++;
-                if (z > z_start_fb) z_start_fb = z;
-                if (z > z_start_bb) z_start_bb = z;
-                updated += diff_2d(x, y, z - 1, t[x][y0][z], hs_bb, hs_fb);
-                updated += t_2d(x, y, z - 1, t[x][y0][z], t[x][y0][z - 1], hs_bb, hs_fb);
-            }
+    for (color = 0; color < SIDE_COLORS; color++) {
+#ifdef _OPENMP
+#pragma omp parallel for private(z, hs_ff, hs_bf, hs_bb, hs_fb, sign_ff, sign_bf, sign_bb, sign_fb) \
+            reduction(+:updated) \
+            reduction(min:x_start_ff, x_start_fb, z_start_ff, z_start_bf) \
+            reduction(max:x_start_bf, x_start_bb, z_start_fb, z_start_bb, flag_ff, flag_bf, flag_bb, flag_fb) \
+            if ((x_end - x_begin + 1) * (z_end - z_begin + 1) >= SIDE_PARALLEL_MIN)
+#endif
+        for (x = x_begin + color; x <= x_end; x += SIDE_COLORS) {
+            for (z = z_begin; z <= z_end; z++) {
+                hs_ff = HS_AT(x, y_s, z);
+                if (x > 0) hs_bf = HS_AT(x - 1, y_s, z);
+                else hs_bf = INFINITY;
+                if (x > 0 && z > 0) hs_bb = HS_AT(x - 1, y_s, z - 1);
+                else hs_bb = INFINITY;
+                if (z > 0) hs_fb = HS_AT(x, y_s, z - 1);
+                else hs_fb = INFINITY;
+
+                sign_ff = sign_bf = sign_bb = sign_fb = 0;
+
+                /* illuminate first neighbours */
+                /* 1 1D transmission and 4 partial 3D transmission */
+                updated += t_1d(x, y, z, T_AT(x, y0, z), hs_ff, hs_bf, hs_bb, hs_fb);
+                if (x < x_end && z < z_end)
+                    updated += t_3d_part1(x, y, z,
+                        T_AT(x, y0, z), T_AT(x + 1, y0, z), T_AT(x, y0, z + 1), hs_ff);
+                if (x > x_begin && z < z_end)
+                    updated += t_3d_part1(x, y, z,
+                        T_AT(x, y0, z), T_AT(x - 1, y0, z), T_AT(x, y0, z + 1), hs_bf);
+                if (x > x_begin && z > z_begin)
+                    updated += t_3d_part1(x, y, z,
+                        T_AT(x, y0, z), T_AT(x - 1, y0, z), T_AT(x, y0, z - 1), hs_bb);
+                if (x < x_end && z > z_begin)
+                    updated += t_3d_part1(x, y, z,
+                        T_AT(x, y0, z), T_AT(x + 1, y0, z), T_AT(x, y0, z - 1), hs_fb);
+
+                /* illuminate second neighbours */
+                /* 4 2D diffraction and 4 2D transmission */
+                if (x < x_end && T_AT(x, y0, z) <= T_AT(x + 1, y0, z)) {
+                    sign_fb++;
+                    sign_ff++;
+                    if (x < x_start_ff) x_start_ff = x;
+                    if (x < x_start_fb) x_start_fb = x;
+                    updated += diff_2d(x + 1, y, z, T_AT(x, y0, z), hs_ff, hs_fb);
+                    updated += t_2d(x + 1, y, z, T_AT(x, y0, z), T_AT(x + 1, y0, z), hs_ff, hs_fb);
+                }
+                if (x > x_begin && T_AT(x, y0, z) <= T_AT(x - 1, y0, z)) {
+                    sign_bb++;
+                    sign_bf++;
+                    if (x > x_start_bf) x_start_bf = x;
+                    if (x > x_start_bb) x_start_bb = x;
+                    updated += diff_2d(x - 1, y, z, T_AT(x, y0, z), hs_bf, hs_bb);
+                    updated += t_2d(x - 1, y, z, T_AT(x, y0, z), T_AT(x - 1, y0, z), hs_bf, hs_bb);
+                }
+                if (z < z_end && T_AT(x, y0, z) <= T_AT(x, y0, z + 1)) {
+                    sign_bf++;
+                    sign_ff++;
+                    if (z < z_start_ff) z_start_ff = z;
+                    if (z < z_start_bf) z_start_bf = z;
+                    updated += diff_2d(x, y, z + 1, T_AT(x, y0, z), hs_ff, hs_bf);
+                    updated += t_2d(x, y, z + 1, T_AT(x, y0, z), T_AT(x, y0, z + 1), hs_ff, hs_bf);
+                }
+                if (z > z_begin && T_AT(x, y0, z) <= T_AT(x, y0, z - 1)) {
+                    sign_bb++;
+                    sign_fb++;
+                    if (z > z_start_fb) z_start_fb = z;
+                    if (z > z_start_bb) z_start_bb = z;
+                    updated += diff_2d(x, y, z - 1, T_AT(x, y0, z), hs_bb, hs_fb);
+                    updated += t_2d(x, y, z - 1, T_AT(x, y0, z), T_AT(x, y0, z - 1), hs_bb, hs_fb);
+                }
 
-            /* illuminate third neighbours */
-            /* 4 3D point diffraction, 8 3D edge diffraction and 12 3D transmission */
-            if (sign_ff == 2) {
-                flag_ff = 1;
-                updated += point_diff(x + 1, y, z + 1, t[x][y0][z], hs_ff)
-                        + edge_diff(x + 1, y, z + 1, t[x][y0][z], t[x + 1][y0][z], hs_ff)
-                        + edge_diff(x + 1, y, z + 1, t[x][y0][z], t[x][y0][z + 1], hs_ff)
-                        + t_3d_part2(x + 1, y, z + 1, t[x][y0][z], t[x + 1][y0][z],
-                        t[x][y0][z + 1], t[x + 1][y0][z + 1], hs_ff);
-            }
-            if (sign_bf == 2) {
-                flag_bf = 1;
-                updated += point_diff(x - 1, y, z + 1, t[x][y0][z], hs_bf)
-                        + edge_diff(x - 1, y, z + 1, t[x][y0][z], t[x - 1][y0][z], hs_bf)
-                        + edge_diff(x - 1, y, z + 1, t[x][y0][z], t[x][y0][z + 1], hs_bf)
-                        + t_3d_part2(x - 1, y, z + 1, t[x][y0][z], t[x - 1][y0][z],
-                        t[x][y0][z + 1], t[x - 1][y0][z + 1], hs_bf);
-            }
-            if (sign_bb == 2) {
-                flag_bb = 1;
-                updated += point_diff(x - 1, y, z - 1, t[x][y0][z], hs_bb)
-                        + edge_diff(x - 1, y, z - 1, t[x][y0][z], t[x - 1][y0][z], hs_bb)
-                        + edge_diff(x - 1, y, z - 1, t[x][y0][z], t[x][y0][z - 1], hs_bb)
-                        + t_3d_part2(x - 1, y, z - 1, t[x][y0][z], t[x - 1][y0][z],
-                        t[x][y0][z - 1], t[x - 1][y0][z - 1], hs_bb);
-            }
-            if (sign_fb == 2) {
-                flag_fb = 1;
-                updated += point_diff(x + 1, y, z - 1, t[x][y0][z], hs_fb)
-                        + edge_diff(x + 1, y, z - 1, t[x][y0][z], t[x + 1][y0][z], hs_fb)
-                        + edge_diff(x + 1, y, z - 1, t[x][y0][z], t[x][y0][z - 1], hs_fb)
-                        + t_3d_part2(x + 1, y, z - 1, t[x][y0][z], t[x + 1][y0][z],
-                        t[x][y0][z - 1], t[x + 1][y0][z - 1], hs_fb);
+                /* illuminate third neighbours */
+                /* 4 3D point diffraction, 8 3D edge diffraction and 12 3D transmission */
+                if (sign_ff == 2) {
+                    flag_ff = 1;
+                    updated += point_diff(x + 1, y, z + 1, T_AT(x, y0, z), hs_ff)
+                            + edge_diff(x + 1, y, z + 1, T_AT(x, y0, z), T_AT(x + 1, y0, z), hs_ff)
+                            + edge_diff(x + 1, y, z + 1, T_AT(x, y0, z), T_AT(x, y0, z + 1), hs_ff)
+                            + t_3d_part2(x + 1, y, z + 1, T_AT(x, y0, z), T_AT(x + 1, y0, z),
+                            T_AT(x, y0, z + 1), T_AT(x + 1, y0, z + 1), hs_ff);
+                }
+                if (sign_bf == 2) {
+                    flag_bf = 1;
+                    updated += point_diff(x - 1, y, z + 1, T_AT(x, y0, z), hs_bf)
+                            + edge_diff(x - 1, y, z + 1, T_AT(x, y0, z), T_AT(x - 1, y0, z), hs_bf)
+                            + edge_diff(x - 1, y, z + 1, T_AT(x, y0, z), T_AT(x, y0, z + 1), hs_bf)
+                            + t_3d_part2(x - 1, y, z + 1, T_AT(x, y0, z), T_AT(x - 1, y0, z),
+                            T_AT(x, y0, z + 1), T_AT(x - 1, y0, z + 1), hs_bf);
+                }
+                if (sign_bb == 2) {
+                    flag_bb = 1;
+                    updated += point_diff(x - 1, y, z - 1, T_AT(x, y0, z), hs_bb)
+                            + edge_diff(x - 1, y, z - 1, T_AT(x, y0, z), T_AT(x - 1, y0, z), hs_bb)
+                            + edge_diff(x - 1, y, z - 1, T_AT(x, y0, z), T_AT(x, y0, z - 1), hs_bb)
+                            + t_3d_part2(x - 1, y, z - 1, T_AT(x, y0, z), T_AT(x - 1, y0, z),
+                            T_AT(x, y0, z - 1), T_AT(x - 1, y0, z - 1), hs_bb);
+                }
+                if (sign_fb == 2) {
+                    flag_fb = 1;
+                    updated += point_diff(x + 1, y, z - 1, T_AT(x, y0, z), hs_fb)
+                            + edge_diff(x + 1, y, z - 1, T_AT(x, y0, z), T_AT(x + 1, y0, z), hs_fb)
+                            + edge_diff(x + 1, y, z - 1, T_AT(x, y0, z), T_AT(x, y0, z - 1), hs_fb)
+                            + t_3d_part2(x + 1, y, z - 1, T_AT(x, y0, z), T_AT(x + 1, y0, z),
+                            T_AT(x, y0, z - 1), T_AT(x + 1, y0, z - 1), hs_fb);
+                }
             }
         }
     }
@@ -2227,14 +2254,14 @@ int x_start, x_end, z_start, z_end, y0, y, y_s;
 
     hs_bb = hs_ubb = hs_ube = INFINITY;
     for (x = x_start, z = z_start; x < x_end; x++) {
-        hs_bf = hs[x][y_s][z];
-        if (z) hs_bb = hs[x][y_s][z - 1];
+        hs_bf = HS_AT(x, y_s, z);
+        if (z) hs_bb = HS_AT(x, y_s, z - 1);
         if (y_sf >= 0 && y_sf < nmesh_y) {
-            hs_ube = hs[x][y_sf][z];
-            if (z) hs_ubb = hs[x][y_sf][z - 1];
+            hs_ube = HS_AT(x, y_sf, z);
+            if (z) hs_ubb = HS_AT(x, y_sf, z - 1);
         }
-        alert1 = t_1d(x + 1, y, z, t[x][y][z], hs_bb, hs_bf, hs_ubb, hs_ube);
-        alert0 = t_2d(x + 1, y, z, t[x][y0][z], t[x][y][z], hs_bb, hs_bf);
+        alert1 = t_1d(x + 1, y, z, T_AT(x, y, z), hs_bb, hs_bf, hs_ubb, hs_ube);
+        alert0 = t_2d(x + 1, y, z, T_AT(x, y0, z), T_AT(x, y, z), hs_bb, hs_bf);
         updated += alert0 + alert1;
         if (alert1) longflags[x * nz + nz + z] = 1;
         if (alert0) longflags[x * nz + nz + z] = 0;
@@ -2242,14 +2269,14 @@ int x_start, x_end, z_start, z_end, y0, y, y_s;
 
     hs_bb = hs_ubb = hs_ueb = INFINITY;
     for (x = x_start, z = z_start; z < z_end; z++) {
-        hs_fb = hs[x][y_s][z];
-        if (x) hs_bb = hs[x - 1][y_s][z];
+        hs_fb = HS_AT(x, y_s, z);
+        if (x) hs_bb = HS_AT(x - 1, y_s, z);
         if (y_sf >= 0 && y_sf < nmesh_y) {
-            hs_ueb = hs[x][y_sf][z];
-            if (x) hs_ubb = hs[x - 1][y_sf][z];
+            hs_ueb = HS_AT(x, y_sf, z);
+            if (x) hs_ubb = HS_AT(x - 1, y_sf, z);
         }
-        alert1 = t_1d(x, y, z + 1, t[x][y][z], hs_bb, hs_fb, hs_ubb, hs_ueb);
-        alert0 = t_2d(x, y, z + 1, t[x][y0][z], t[x][y][z], hs_bb, hs_fb);
+        alert1 = t_1d(x, y, z + 1, T_AT(x, y, z), hs_bb, hs_fb, hs_ubb, hs_ueb);
+        alert0 = t_2d(x, y, z + 1, T_AT(x, y0, z), T_AT(x, y, z), hs_bb, hs_fb);
         updated += alert0 + alert1;
         if (alert1) longflags[x * nz + z + 1] = 1;
         if (alert0) longflags[x * nz + z + 1] = 0;
@@ -2257,29 +2284,29 @@ int x_start, x_end, z_start, z_end, y0, y, y_s;
 
     for (x = x_start; x < x_end; x++) {
         for (z = z_start; z < z_end; z++) {
-            hs_bb = hs[x][y_s][z];
-            hs_bf = hs[x][y_s][z + 1];
-            hs_fb = hs[x + 1][y_s][z];
+            hs_bb = HS_AT(x, y_s, z);
+            hs_bf = HS_AT(x, y_s, z + 1);
+            hs_fb = HS_AT(x + 1, y_s, z);
             if (y_sf >= 0 && y_sf < nmesh_y) {
-                hs_ubb = hs[x][y_sf][z];
-                hs_ube = hs[x][y_sf][z + 1];
-                hs_ueb = hs[x + 1][y_sf][z];
+                hs_ubb = HS_AT(x, y_sf, z);
+                hs_ube = HS_AT(x, y_sf, z + 1);
+                hs_ueb = HS_AT(x + 1, y_sf, z);
             } else hs_ubb = hs_ube = hs_ueb = INFINITY;
 
             /* bulk waves: 1 3D edge diffraction and 2 (*4) 3D transmission */
-            alert0 = edge_diff(x + 1, y, z + 1, t[x][y0][z], t[x][y][z], hs_bb)
-                    + t_3d(x + 1, y, z + 1, t[x][y0][z],
-                    t[x + 1][y0][z], t[x][y][z], t[x + 1][y][z], hs_bb)
-                    + t_3d(x + 1, y, z + 1, t[x][y0][z],
-                    t[x][y0][z + 1], t[x][y][z], t[x][y][z + 1], hs_bb);
+            alert0 = edge_diff(x + 1, y, z + 1, T_AT(x, y0, z), T_AT(x, y, z), hs_bb)
+                    + t_3d(x + 1, y, z + 1, T_AT(x, y0, z),
+                    T_AT(x + 1, y0, z), T_AT(x, y, z), T_AT(x + 1, y, z), hs_bb)
+                    + t_3d(x + 1, y, z + 1, T_AT(x, y0, z),
+                    T_AT(x, y0, z + 1), T_AT(x, y, z), T_AT(x, y, z + 1), hs_bb);
             if (alert0) {
                 updated++;
                 longflags[x * nz + nz + z + 1] = 0;
             }
 
             /* interface waves along x_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x + 1, y, z + 1, t[x][y][z + 1], hs_bb, hs_bf, hs_ubb, hs_ube);
-            alert0 = t_2d(x + 1, y, z + 1, t[x][y0][z + 1], t[x][y][z + 1], hs_bb, hs_bf);
+            alert1 = t_1d(x + 1, y, z + 1, T_AT(x, y, z + 1), hs_bb, hs_bf, hs_ubb, hs_ube);
+            alert0 = t_2d(x + 1, y, z + 1, T_AT(x, y0, z + 1), T_AT(x, y, z + 1), hs_bb, hs_bf);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_fb++; /* this scan must be (re-)examined */
@@ -2290,8 +2317,8 @@ int x_start, x_end, z_start, z_end, y0, y, y_s;
             }
 
             /* interface waves along z_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x + 1, y, z + 1, t[x + 1][y][z], hs_bb, hs_fb, hs_ubb, hs_ueb);
-            alert0 = t_2d(x + 1, y, z + 1, t[x + 1][y0][z], t[x + 1][y][z], hs_bb, hs_fb);
+            alert1 = t_1d(x + 1, y, z + 1, T_AT(x + 1, y, z), hs_bb, hs_fb, hs_ubb, hs_ueb);
+            alert0 = t_2d(x + 1, y, z + 1, T_AT(x + 1, y0, z), T_AT(x + 1, y, z), hs_bb, hs_fb);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_bf++; /* this scan must be (re-)examined */
@@ -2302,9 +2329,9 @@ int x_start, x_end, z_start, z_end, y0, y, y_s;
             }
 
             /* interface waves along y_side : 2 2D transmission and 1 2D diffraction */
-            alert1 = diff_2d(x + 1, y, z + 1, t[x][y][z], hs_bb, hs_ubb)
-                    + t_2d(x + 1, y, z + 1, t[x][y][z], t[x + 1][y][z], hs_bb, hs_ubb)
-                    + t_2d(x + 1, y, z + 1, t[x][y][z], t[x][y][z + 1], hs_bb, hs_ubb);
+            alert1 = diff_2d(x + 1, y, z + 1, T_AT(x, y, z), hs_bb, hs_ubb)
+                    + t_2d(x + 1, y, z + 1, T_AT(x, y, z), T_AT(x + 1, y, z), hs_bb, hs_ubb)
+                    + t_2d(x + 1, y, z + 1, T_AT(x, y, z), T_AT(x, y, z + 1), hs_bb, hs_ubb);
             if (alert1) {
                 updated += alert1;
                 longflags[x * nz + nz + z + 1] = 1;
@@ -2339,14 +2366,14 @@ int x_start, x_begin, z_start, z_end, y0, y, y_s;
 
     hs_fb = hs_uee = hs_ueb = INFINITY;
     for (x = x_start, z = z_start; x > x_begin; x--) {
-        hs_ff = hs[x - 1][y_s][z];
-        if (z) hs_fb = hs[x - 1][y_s][z - 1];
+        hs_ff = HS_AT(x - 1, y_s, z);
+        if (z) hs_fb = HS_AT(x - 1, y_s, z - 1);
         if (y_sf >= 0 && y_sf < nmesh_y) {
-            hs_uee = hs[x - 1][y_sf][z];
-            if (z) hs_ueb = hs[x - 1][y_sf][z - 1];
+            hs_uee = HS_AT(x - 1, y_sf, z);
+            if (z) hs_ueb = HS_AT(x - 1, y_sf, z - 1);
         }
-        alert1 = t_1d(x - 1, y, z, t[x][y][z], hs_fb, hs_ff, hs_ueb, hs_uee);
-        alert0 = t_2d(x - 1, y, z, t[x][y0][z], t[x][y][z], hs_fb, hs_ff);
+        alert1 = t_1d(x - 1, y, z, T_AT(x, y, z), hs_fb, hs_ff, hs_ueb, hs_uee);
+        alert0 = t_2d(x - 1, y, z, T_AT(x, y0, z), T_AT(x, y, z), hs_fb, hs_ff);
         updated += alert0 + alert1;
         if (alert1) longflags[x * nz - nz + z] = 1;
         if (alert0) longflags[x * nz - nz + z] = 0;
@@ -2354,14 +2381,14 @@ int x_start, x_begin, z_start, z_end, y0, y, y_s;
 
     hs_bb = hs_ubb = hs_ueb = INFINITY;
     for (x = x_start, z = z_start; z < z_end; z++) {
-        if (x) hs_bb = hs[x - 1][y_s][z];
-        hs_fb = hs[x][y_s][z];
+        if (x) hs_bb = HS_AT(x - 1, y_s, z);
+        hs_fb = HS_AT(x, y_s, z);
         if (y_sf >= 0 && y_sf < nmesh_y) {
-            if (x) hs_ubb = hs[x - 1][y_sf][z];
-            hs_ueb = hs[x][y_sf][z];
+            if (x) hs_ubb = HS_AT(x - 1, y_sf, z);
+            hs_ueb = HS_AT(x, y_sf, z);
         }
-        alert1 = t_1d(x, y, z + 1, t[x][y][z], hs_bb, hs_fb, hs_ubb, hs_ueb);
-        alert0 = t_2d(x, y, z + 1, t[x][y0][z], t[x][y][z], hs_bb, hs_fb);
+        alert1 = t_1d(x, y, z + 1, T_AT(x, y, z), hs_bb, hs_fb, hs_ubb, hs_ueb);
+        alert0 = t_2d(x, y, z + 1, T_AT(x, y0, z), T_AT(x, y, z), hs_bb, hs_fb);
         updated += alert0 + alert1;
         if (alert1) longflags[x * nz + z + 1] = 1;
         if (alert0) longflags[x * nz + z + 1] = 0;
@@ -2370,31 +2397,31 @@ int x_start, x_begin, z_start, z_end, y0, y, y_s;
     for (x = x_start; x > x_begin; x--) {
         for (z = z_start; z < z_end; z++) {
 
-            hs_ff = hs[x - 1][y_s][z + 1];
-            if (x > 1) hs_bb = hs[x - 2][y_s][z];
+            hs_ff = HS_AT(x - 1, y_s, z + 1);
+            if (x > 1) hs_bb = HS_AT(x - 2, y_s, z);
             else hs_bb = INFINITY;
-            hs_fb = hs[x - 1][y_s][z];
+            hs_fb = HS_AT(x - 1, y_s, z);
             if (y_sf >= 0 && y_sf < nmesh_y) {
-                hs_uee = hs[x - 1][y_sf][z + 1];
-                if (x > 1) hs_ubb = hs[x - 2][y_sf][z];
+                hs_uee = HS_AT(x - 1, y_sf, z + 1);
+                if (x > 1) hs_ubb = HS_AT(x - 2, y_sf, z);
                 else hs_ubb = INFINITY;
-                hs_ueb = hs[x - 1][y_sf][z];
+                hs_ueb = HS_AT(x - 1, y_sf, z);
             } else hs_ubb = hs_uee = hs_ueb = INFINITY;
 
             /* bulk waves: 1 3D edge diffraction and 2 (*4) 3D transmission */
-            alert0 = edge_diff(x - 1, y, z + 1, t[x][y0][z], t[x][y][z], hs_fb)
-                    + t_3d(x - 1, y, z + 1, t[x][y0][z],
-                    t[x - 1][y0][z], t[x][y][z], t[x - 1][y][z], hs_fb)
-                    + t_3d(x - 1, y, z + 1, t[x][y0][z],
-                    t[x][y0][z + 1], t[x][y][z], t[x][y][z + 1], hs_fb);
+            alert0 = edge_diff(x - 1, y, z + 1, T_AT(x, y0, z), T_AT(x, y, z), hs_fb)
+                    + t_3d(x - 1, y, z + 1, T_AT(x, y0, z),
+                    T_AT(x - 1, y0, z), T_AT(x, y, z), T_AT(x - 1, y, z), hs_fb)
+                    + t_3d(x - 1, y, z + 1, T_AT(x, y0, z),
+                    T_AT(x, y0, z + 1), T_AT(x, y, z), T_AT(x, y, z + 1), hs_fb);
             if (alert0) {
                 updated += alert0;
                 longflags[x * nz - nz + z + 1] = 0;
             }
 
             /* interface waves along x_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x - 1, y, z + 1, t[x][y][z + 1], hs_ff, hs_fb, hs_uee, hs_ueb);
-            alert0 = t_2d(x - 1, y, z + 1, t[x][y0][z + 1], t[x][y][z + 1], hs_ff, hs_fb);
+            alert1 = t_1d(x - 1, y, z + 1, T_AT(x, y, z + 1), hs_ff, hs_fb, hs_uee, hs_ueb);
+            alert0 = t_2d(x - 1, y, z + 1, T_AT(x, y0, z + 1), T_AT(x, y, z + 1), hs_ff, hs_fb);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_bb++; /* this scan must be (re-)examined */
@@ -2405,8 +2432,8 @@ int x_start, x_begin, z_start, z_end, y0, y, y_s;
             }
 
             /* interface waves along z_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x - 1, y, z + 1, t[x - 1][y][z], hs_bb, hs_fb, hs_ubb, hs_ueb);
-            alert0 = t_2d(x - 1, y, z + 1, t[x - 1][y0][z], t[x - 1][y][z], hs_bb, hs_fb);
+            alert1 = t_1d(x - 1, y, z + 1, T_AT(x - 1, y, z), hs_bb, hs_fb, hs_ubb, hs_ueb);
+            alert0 = t_2d(x - 1, y, z + 1, T_AT(x - 1, y0, z), T_AT(x - 1, y, z), hs_bb, hs_fb);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_ff++; /* this scan must be (re-)examined */
@@ -2417,9 +2444,9 @@ int x_start, x_begin, z_start, z_end, y0, y, y_s;
             }
 
             /* interface waves along y_side : 2 2D transmission and 1 2D diffraction */
-            alert1 = diff_2d(x - 1, y, z + 1, t[x][y][z], hs_fb, hs_ueb)
-                    + t_2d(x - 1, y, z + 1, t[x][y][z], t[x - 1][y][z], hs_fb, hs_ueb)
-                    + t_2d(x - 1, y, z + 1, t[x][y][z], t[x][y][z + 1], hs_fb, hs_ueb);
+            alert1 = diff_2d(x - 1, y, z + 1, T_AT(x, y, z), hs_fb, hs_ueb)
+                    + t_2d(x - 1, y, z + 1, T_AT(x, y, z), T_AT(x - 1, y, z), hs_fb, hs_ueb)
+                    + t_2d(x - 1, y, z + 1, T_AT(x, y, z), T_AT(x, y, z + 1), hs_fb, hs_ueb);
             if (alert1) {
                 updated += alert1;
                 longflags[x * nz - nz + z + 1] = 1;
@@ -2454,14 +2481,14 @@ int x_start, x_begin, z_begin, z_start, y0, y, y_s;
 
     hs_ff = hs_uee = hs_ueb = INFINITY;
     for (x = x_start, z = z_start; x > x_begin; x--) {
-        if (z) hs_ff = hs[x - 1][y_s][z - 1];
-        hs_fb = hs[x - 1][y_s][z];
+        if (z) hs_ff = HS_AT(x - 1, y_s, z - 1);
+        hs_fb = HS_AT(x - 1, y_s, z);
         if (y_sf >= 0 && y_sf < nmesh_y) {
-            if (z) hs_uee = hs[x - 1][y_sf][z - 1];
-            hs_ueb = hs[x - 1][y_sf][z];
+            if (z) hs_uee = HS_AT(x - 1, y_sf, z - 1);
+            hs_ueb = HS_AT(x - 1, y_sf, z);
         }
-        alert1 = t_1d(x - 1, y, z, t[x][y][z], hs_fb, hs_ff, hs_ueb, hs_uee);
-        alert0 = t_2d(x - 1, y, z, t[x][y0][z], t[x][y][z], hs_fb, hs_ff);
+        alert1 = t_1d(x - 1, y, z, T_AT(x, y, z), hs_fb, hs_ff, hs_ueb, hs_uee);
+        alert0 = t_2d(x - 1, y, z, T_AT(x, y0, z), T_AT(x, y, z), hs_fb, hs_ff);
         updated += alert0 + alert1;
         if (alert1) longflags[x * nz - nz + z] = 1;
         if (alert0) longflags[x * nz - nz + z] = 0;
@@ -2469,14 +2496,14 @@ int x_start, x_begin, z_begin, z_start, y0, y, y_s;
 
     hs_ff = hs_uee = hs_ube = INFINITY;
     for (x = x_start, z = z_start; z > z_begin; z--) {
-        if (x) hs_ff = hs[x - 1][y_s][z - 1];
-        hs_bf = hs[x][y_s][z - 1];
+        if (x) hs_ff = HS_AT(x - 1, y_s, z - 1);
+        hs_bf = HS_AT(x, y_s, z - 1);
         if (y_sf >= 0 && y_sf < nmesh_y) {
-            if (x) hs_uee = hs[x - 1][y_sf][z - 1];
-            hs_ube = hs[x][y_sf][z - 1];
+            if (x) hs_uee = HS_AT(x - 1, y_sf, z - 1);
+            hs_ube = HS_AT(x, y_sf, z - 1);
         }
-        alert1 = t_1d(x, y, z - 1, t[x][y][z], hs_bf, hs_ff, hs_ube, hs_uee);
-        alert0 = t_2d(x, y, z - 1, t[x][y0][z], t[x][y][z], hs_bf, hs_ff);
+        alert1 = t_1d(x, y, z - 1, T_AT(x, y, z), hs_bf, hs_ff, hs_ube, hs_uee);
+        alert0 = t_2d(x, y, z - 1, T_AT(x, y0, z), T_AT(x, y, z), hs_bf, hs_ff);
         updated += alert0 + alert1;
         if (alert1) longflags[x * nz + z - 1] = 1;
         if (alert0) longflags[x * nz + z - 1] = 0;
@@ -2485,33 +2512,33 @@ int x_start, x_begin, z_begin, z_start, y0, y, y_s;
     for (x = x_start; x > x_begin; x--) {
         for (z = z_start; z > z_begin; z--) {
 
-            hs_ff = hs[x - 1][y_s][z - 1];
-            if (x > 1) hs_bf = hs[x - 2][y_s][z - 1];
+            hs_ff = HS_AT(x - 1, y_s, z - 1);
+            if (x > 1) hs_bf = HS_AT(x - 2, y_s, z - 1);
             else hs_bf = INFINITY;
-            if (z > 1) hs_fb = hs[x - 1][y_s][z - 2];
+            if (z > 1) hs_fb = HS_AT(x - 1, y_s, z - 2);
             else hs_fb = INFINITY;
             if (y_sf >= 0 && y_sf < nmesh_y) {
-                hs_uee = hs[x - 1][y_sf][z - 1];
-                if (x > 1) hs_ube = hs[x - 2][y_sf][z - 1];
+                hs_uee = HS_AT(x - 1, y_sf, z - 1);
+                if (x > 1) hs_ube = HS_AT(x - 2, y_sf, z - 1);
                 else hs_ube = INFINITY;
-                if (z > 1) hs_ueb = hs[x - 1][y_sf][z - 2];
+                if (z > 1) hs_ueb = HS_AT(x - 1, y_sf, z - 2);
                 else hs_ueb = INFINITY;
             } else hs_uee = hs_ube = hs_ueb = INFINITY;
 
             /* bulk waves: 1 3D edge diffraction and 2 (*4) 3D transmission */
-            alert0 = edge_diff(x - 1, y, z - 1, t[x][y0][z], t[x][y][z], hs_ff)
-                    + t_3d(x - 1, y, z - 1, t[x][y0][z],
-                    t[x - 1][y0][z], t[x][y][z], t[x - 1][y][z], hs_ff)
-                    + t_3d(x - 1, y, z - 1, t[x][y0][z],
-                    t[x][y0][z - 1], t[x][y][z], t[x][y][z - 1], hs_ff);
+            alert0 = edge_diff(x - 1, y, z - 1, T_AT(x, y0, z), T_AT(x, y, z), hs_ff)
+                    + t_3d(x - 1, y, z - 1, T_AT(x, y0, z),
+                    T_AT(x - 1, y0, z), T_AT(x, y, z), T_AT(x - 1, y, z), hs_ff)
+                    + t_3d(x - 1, y, z - 1, T_AT(x, y0, z),
+                    T_AT(x, y0, z - 1), T_AT(x, y, z), T_AT(x, y, z - 1), hs_ff);
             if (alert0) {
                 updated += alert0;
                 longflags[x * nz - nz + z - 1] = 0;
             }
 
             /* interface waves along x_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x - 1, y, z - 1, t[x][y][z - 1], hs_ff, hs_fb, hs_uee, hs_ueb);
-            alert0 = t_2d(x - 1, y, z - 1, t[x][y0][z - 1], t[x][y][z - 1], hs_ff, hs_fb);
+            alert1 = t_1d(x - 1, y, z - 1, T_AT(x, y, z - 1), hs_ff, hs_fb, hs_uee, hs_ueb);
+            alert0 = t_2d(x - 1, y, z - 1, T_AT(x, y0, z - 1), T_AT(x, y, z - 1), hs_ff, hs_fb);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_bf++; /* this scan must be (re-)examined */
@@ -2522,8 +2549,8 @@ int x_start, x_begin, z_begin, z_start, y0, y, y_s;
             }
 
             /* interface waves along z_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x - 1, y, z - 1, t[x - 1][y][z], hs_ff, hs_bf, hs_uee, hs_ube);
-            alert0 = t_2d(x - 1, y, z - 1, t[x - 1][y0][z], t[x - 1][y][z], hs_ff, hs_bf);
+            alert1 = t_1d(x - 1, y, z - 1, T_AT(x - 1, y, z), hs_ff, hs_bf, hs_uee, hs_ube);
+            alert0 = t_2d(x - 1, y, z - 1, T_AT(x - 1, y0, z), T_AT(x - 1, y, z), hs_ff, hs_bf);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_fb++; /* this scan must be (re-)examined */
@@ -2534,9 +2561,9 @@ int x_start, x_begin, z_begin, z_start, y0, y, y_s;
             }
 
             /* interface waves along y_side : 2 2D transmission and 1 2D diffraction */
-            alert1 = diff_2d(x - 1, y, z - 1, t[x][y][z], hs_ff, hs_uee)
-                    + t_2d(x - 1, y, z - 1, t[x][y][z], t[x - 1][y][z], hs_ff, hs_uee)
-                    + t_2d(x - 1, y, z - 1, t[x][y][z], t[x][y][z - 1], hs_ff, hs_uee);
+            alert1 = diff_2d(x - 1, y, z - 1, T_AT(x, y, z), hs_ff, hs_uee)
+                    + t_2d(x - 1, y, z - 1, T_AT(x, y, z), T_AT(x - 1, y, z), hs_ff, hs_uee)
+                    + t_2d(x - 1, y, z - 1, T_AT(x, y, z), T_AT(x, y, z - 1), hs_ff, hs_uee);
             if (alert1) {
                 updated += alert1;
                 longflags[x * nz - nz + z - 1] = 1;
@@ -2571,14 +2598,14 @@ int x_start, x_end, z_begin, z_start, y0, y, y_s;
 
     hs_bf = hs_ubb = hs_ube = INFINITY;
     for (x = x_start, z = z_start; x < x_end; x++) {
-        if (z) hs_bf = hs[x][y_s][z - 1];
-        hs_bb = hs[x][y_s][z];
+        if (z) hs_bf = HS_AT(x, y_s, z - 1);
+        hs_bb = HS_AT(x, y_s, z);
         if (y_sf >= 0 && y_sf < nmesh_y) {
-            if (z) hs_ube = hs[x][y_sf][z - 1];
-            hs_ubb = hs[x][y_sf][z];
+            if (z) hs_ube = HS_AT(x, y_sf, z - 1);
+            hs_ubb = HS_AT(x, y_sf, z);
         }
-        alert1 = t_1d(x + 1, y, z, t[x][y][z], hs_bf, hs_bb, hs_ube, hs_ubb);
-        alert0 = t_2d(x + 1, y, z, t[x][y0][z], t[x][y][z], hs_bf, hs_bb);
+        alert1 = t_1d(x + 1, y, z, T_AT(x, y, z), hs_bf, hs_bb, hs_ube, hs_ubb);
+        alert0 = t_2d(x + 1, y, z, T_AT(x, y0, z), T_AT(x, y, z), hs_bf, hs_bb);
         updated += alert0 + alert1;
         if (alert1) longflags[x * nz + nz + z] = 1;
         if (alert0) longflags[x * nz + nz + z] = 0;
@@ -2586,14 +2613,14 @@ int x_start, x_end, z_begin, z_start, y0, y, y_s;
 
     hs_ff = hs_uee = hs_ube = INFINITY;
     for (x = x_start, z = z_start; z > z_begin; z--) {
-        if (x) hs_ff = hs[x - 1][y_s][z - 1];
-        hs_bf = hs[x][y_s][z - 1];
+        if (x) hs_ff = HS_AT(x - 1, y_s, z - 1);
+        hs_bf = HS_AT(x, y_s, z - 1);
         if (y_sf >= 0 && y_sf < nmesh_y) {
-            if (x) hs_uee = hs[x - 1][y_sf][z - 1];
-            hs_ube = hs[x][y_sf][z - 1];
+            if (x) hs_uee = HS_AT(x - 1, y_sf, z - 1);
+            hs_ube = HS_AT(x, y_sf, z - 1);
         }
-        alert1 = t_1d(x, y, z - 1, t[x][y][z], hs_bf, hs_ff, hs_ube, hs_uee);
-        alert0 = t_2d(x, y, z - 1, t[x][y0][z], t[x][y][z], hs_bf, hs_ff);
+        alert1 = t_1d(x, y, z - 1, T_AT(x, y, z), hs_bf, hs_ff, hs_ube, hs_uee);
+        alert0 = t_2d(x, y, z - 1, T_AT(x, y0, z), T_AT(x, y, z), hs_bf, hs_ff);
         updated += alert0 + alert1;
         if (alert1) longflags[x * nz + z - 1] = 1;
         if (alert0) longflags[x * nz + z - 1] = 0;
@@ -2602,31 +2629,31 @@ int x_start, x_end, z_begin, z_start, y0, y, y_s;
     for (x = x_start; x < x_end; x++) {
         for (z = z_start; z > z_begin; z--) {
 
-            hs_bf = hs[x][y_s][z - 1];
-            if (z > 1) hs_bb = hs[x][y_s][z - 2];
+            hs_bf = HS_AT(x, y_s, z - 1);
+            if (z > 1) hs_bb = HS_AT(x, y_s, z - 2);
             else hs_bb = INFINITY;
-            hs_ff = hs[x + 1][y_s][z - 1];
+            hs_ff = HS_AT(x + 1, y_s, z - 1);
             if (y_sf >= 0 && y_sf < nmesh_y) {
-                hs_ube = hs[x][y_sf][z - 1];
-                if (z > 1) hs_ubb = hs[x][y_sf][z - 2];
+                hs_ube = HS_AT(x, y_sf, z - 1);
+                if (z > 1) hs_ubb = HS_AT(x, y_sf, z - 2);
                 else hs_ubb = INFINITY;
-                hs_uee = hs[x + 1][y_sf][z - 1];
+                hs_uee = HS_AT(x + 1, y_sf, z - 1);
             } else hs_ubb = hs_ube = hs_uee = INFINITY;
 
             /* bulk waves: 1 3D edge diffraction and 2 (*4) 3D transmission */
-            alert0 = edge_diff(x + 1, y, z - 1, t[x][y0][z], t[x][y][z], hs_bf)
-                    + t_3d(x + 1, y, z - 1, t[x][y0][z],
-                    t[x + 1][y0][z], t[x][y][z], t[x + 1][y][z], hs_bf)
-                    + t_3d(x + 1, y, z - 1, t[x][y0][z],
-                    t[x][y0][z - 1], t[x][y][z], t[x][y][z - 1], hs_bf);
+            alert0 = edge_diff(x + 1, y, z - 1, T_AT(x, y0, z), T_AT(x, y, z), hs_bf)
+                    + t_3d(x + 1, y, z - 1, T_AT(x, y0, z),
+                    T_AT(x + 1, y0, z), T_AT(x, y, z), T_AT(x + 1, y, z), hs_bf)
+                    + t_3d(x + 1, y, z - 1, T_AT(x, y0, z),
+                    T_AT(x, y0, z - 1), T_AT(x, y, z), T_AT(x, y, z - 1), hs_bf);
             if (alert0) {
                 updated += alert0;
                 longflags[x * nz + nz + z - 1] = 0;
             }
 
             /* interface waves along x_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x + 1, y, z - 1, t[x][y][z - 1], hs_bb, hs_bf, hs_ubb, hs_ube);
-            alert0 = t_2d(x + 1, y, z - 1, t[x][y0][z - 1], t[x][y][z - 1], hs_bb, hs_bf);
+            alert1 = t_1d(x + 1, y, z - 1, T_AT(x, y, z - 1), hs_bb, hs_bf, hs_ubb, hs_ube);
+            alert0 = t_2d(x + 1, y, z - 1, T_AT(x, y0, z - 1), T_AT(x, y, z - 1), hs_bb, hs_bf);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_ff++; /* this scan must be (re-)examined */
@@ -2637,8 +2664,8 @@ int x_start, x_end, z_begin, z_start, y0, y, y_s;
             }
 
             /* interface waves along z_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x + 1, y, z - 1, t[x + 1][y][z], hs_ff, hs_bf, hs_uee, hs_ube);
-            alert0 = t_2d(x + 1, y, z - 1, t[x + 1][y0][z], t[x + 1][y][z], hs_ff, hs_bf);
+            alert1 = t_1d(x + 1, y, z - 1, T_AT(x + 1, y, z), hs_ff, hs_bf, hs_uee, hs_ube);
+            alert0 = t_2d(x + 1, y, z - 1, T_AT(x + 1, y0, z), T_AT(x + 1, y, z), hs_ff, hs_bf);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_bb++; /* this scan must be (re-)examined */
@@ -2649,9 +2676,9 @@ int x_start, x_end, z_begin, z_start, y0, y, y_s;
             }
 
             /* interface waves along y_side : 2 2D transmission and 1 2D diffraction */
-            alert1 = diff_2d(x + 1, y, z - 1, t[x][y][z], hs_bf, hs_ube)
-                    + t_2d(x + 1, y, z - 1, t[x][y][z], t[x + 1][y][z], hs_bf, hs_ube)
-                    + t_2d(x + 1, y, z - 1, t[x][y][z], t[x][y][z - 1], hs_bf, hs_ube);
+            alert1 = diff_2d(x + 1, y, z - 1, T_AT(x, y, z), hs_bf, hs_ube)
+                    + t_2d(x + 1, y, z - 1, T_AT(x, y, z), T_AT(x + 1, y, z), hs_bf, hs_ube)
+                    + t_2d(x + 1, y, z - 1, T_AT(x, y, z), T_AT(x, y, z - 1), hs_bf, hs_ube);
             if (alert1) {
                 updated += alert1;
                 longflags[x * nz + nz + z - 1] = 1;
@@ -2692,7 +2719,8 @@ int x_begin, x_end, y_begin, y_end, z, future;
             x, y,
             sign_ff, sign_bf, sign_bb, sign_fb,
             test,
-            past;
+            past,
+            color;
     GRID_FLOAT_TYPE
     hs_ff, hs_bf, hs_bb, hs_fb;
 
@@ -2711,102 +2739,111 @@ int x_begin, x_end, y_begin, y_end, z, future;
 
     /* First Step: "a-causal" stencils */
 
-    for (x = x_begin; x <= x_end; x++) {
-        for (y = y_begin; y <= y_end; y++) {
-
-            hs_ff = hs[x][y][z_s];
-            if (x > 0) hs_bf = hs[x - 1][y][z_s];
-            else hs_bf = INFINITY;
-            if (x > 0 && y > 0) hs_bb = hs[x - 1][y - 1][z_s];
-            else hs_bb = INFINITY;
-            if (y > 0) hs_fb = hs[x][y - 1][z_s];
-            else hs_fb = INFINITY;
-            sign_ff = sign_bf = sign_bb = sign_fb = 0;
-
-            /* illuminate first neighbours */
-            /* 1 1D transmission and 4 partial 3D transmission */
-            updated += t_1d(x, y, z, t[x][y][z0], hs_ff, hs_bf, hs_bb, hs_fb);
-            if (x < x_end && y < y_end)
-                updated += t_3d_part1(x, y, z, t[x][y][z0],
-                    t[x + 1][y][z0], t[x][y + 1][z0], hs_ff);
-            if (x > x_begin && y < y_end)
-                updated += t_3d_part1(x, y, z, t[x][y][z0],
-                    t[x - 1][y][z0], t[x][y + 1][z0], hs_bf);
-            if (x > x_begin && y > y_begin)
-                updated += t_3d_part1(x, y, z, t[x][y][z0],
-                    t[x - 1][y][z0], t[x][y - 1][z0], hs_bb);
-            if (x < x_end && y > y_begin)
-                updated += t_3d_part1(x, y, z, t[x][y][z0],
-                    t[x + 1][y][z0], t[x][y - 1][z0], hs_fb);
-
-            /* illuminate second neighbours */
-            /* 4 2D diffraction and 4 2D transmission */
-            if (x < x_end && t[x][y][z0] <= t[x + 1][y][z0]) {
-                sign_fb++;
-                sign_ff++;
-                if (x < x_start_ff) x_start_ff = x;
-                if (x < x_start_fb) x_start_fb = x;
-                updated += diff_2d(x + 1, y, z, t[x][y][z0], hs_ff, hs_fb);
-                updated += t_2d(x + 1, y, z, t[x][y][z0], t[x + 1][y][z0], hs_ff, hs_fb);
-            }
-            if (x > x_begin && t[x][y][z0] <= t[x - 1][y][z0]) {
-                sign_bb++;
-                sign_bf++;
-                if (x > x_start_bf) x_start_bf = x;
-                if (x > x_start_bb) x_start_bb = x;
-                updated += diff_2d(x - 1, y, z, t[x][y][z0], hs_bf, hs_bb);
-                updated += t_2d(x - 1, y, z, t[x][y][z0], t[x - 1][y][z0], hs_bf, hs_bb);
-            }
-            if (y < y_end && t[x][y][z0] <= t[x][y + 1][z0]) {
-                sign_bf++;
-                sign_ff++;
-                if (y < y_start_ff) y_start_ff = y;
-                if (y < y_start_bf) y_start_bf = y;
-                updated += diff_2d(x, y + 1, z, t[x][y][z0], hs_ff, hs_bf);
-                updated += t_2d(x, y + 1, z, t[x][y][z0], t[x][y + 1][z0], hs_ff, hs_bf);
-            }
-            if (y > y_begin && t[x][y][z0] <= t[x][y - 1][z0]) {
-                sign_bb++;
-                sign_fb++;
-                if (y > y_start_fb) y_start_fb = y;
-                if (y > y_start_bb) y_start_bb = y;
-                updated += diff_2d(x, y - 1, z, t[x][y][z0], hs_bb, hs_fb);
-                updated += t_2d(x, y - 1, z, t[x][y][z0], t[x][y - 1][z0], hs_bb, hs_fb);
-            }
+    for (color = 0; color < SIDE_COLORS; color++) {
+#ifdef _OPENMP
+#pragma omp parallel for private(y, hs_ff, hs_bf, hs_bb, hs_fb, sign_ff, sign_bf, sign_bb, sign_fb) \
+            reduction(+:updated) \
+            reduction(min:x_start_ff, x_start_fb, y_start_ff, y_start_bf) \
+            reduction(max:x_start_bf, x_start_bb, y_start_fb, y_start_bb, flag_ff, flag_bf, flag_bb, flag_fb) \
+            if ((x_end - x_begin + 1) * (y_end - y_begin + 1) >= SIDE_PARALLEL_MIN)
+#endif
+        for (x = x_begin + color; x <= x_end; x += SIDE_COLORS) {
+            for (y = y_begin; y <= y_end; y++) {
+
+                hs_ff = HS_AT(x, y, z_s);
+                if (x > 0) hs_bf = HS_AT(x - 1, y, z_s);
+                else hs_bf = INFINITY;
+                if (x > 0 && y > 0) hs_bb = HS_AT(x - 1, y - 1, z_s);
+                else hs_bb = INFINITY;
+                if (y > 0) hs_fb = HS_AT(x, y - 1, z_s);
+                else hs_fb = INFINITY;
+                sign_ff = sign_bf = sign_bb = sign_fb = 0;
+
+                /* illuminate first neighbours */
+                /* 1 1D transmission and 4 partial 3D transmission */
+                updated += t_1d(x, y, z, T_AT(x, y, z0), hs_ff, hs_bf, hs_bb, hs_fb);
+                if (x < x_end && y < y_end)
+                    updated += t_3d_part1(x, y, z, T_AT(x, y, z0),
+                        T_AT(x + 1, y, z0), T_AT(x, y + 1, z0), hs_ff);
+                if (x > x_begin && y < y_end)
+                    updated += t_3d_part1(x, y, z, T_AT(x, y, z0),
+                        T_AT(x - 1, y, z0), T_AT(x, y + 1, z0), hs_bf);
+                if (x > x_begin && y > y_begin)
+                    updated += t_3d_part1(x, y, z, T_AT(x, y, z0),
+                        T_AT(x - 1, y, z0), T_AT(x, y - 1, z0), hs_bb);
+                if (x < x_end && y > y_begin)
+                    updated += t_3d_part1(x, y, z, T_AT(x, y, z0),
+                        T_AT(x + 1, y, z0), T_AT(x, y - 1, z0), hs_fb);
+
+                /* illuminate second neighbours */
+                /* 4 2D diffraction and 4 2D transmission */
+                if (x < x_end && T_AT(x, y, z0) <= T_AT(x + 1, y, z0)) {
+                    sign_fb++;
+                    sign_ff++;
+                    if (x < x_start_ff) x_start_ff = x;
+                    if (x < x_start_fb) x_start_fb = x;
+                    updated += diff_2d(x + 1, y, z, T_AT(x, y, z0), hs_ff, hs_fb);
+                    updated += t_2d(x + 1, y, z, T_AT(x, y, z0), T_AT(x + 1, y, z0), hs_ff, hs_fb);
+                }
+                if (x > x_begin && T_AT(x, y, z0) <= T_AT(x - 1, y, z0)) {
+                    sign_bb++;
+                    sign_bf++;
+                    if (x > x_start_bf) x_start_bf = x;
+                    if (x > x_start_bb) x_start_bb = x;
+                    updated += diff_2d(x - 1, y, z, T_AT(x, y, z0), hs_bf, hs_bb);
+                    updated += t_2d(x - 1, y, z, T_AT(x, y, z0), T_AT(x - 1, y, z0), hs_bf, hs_bb);
+                }
+                if (y < y_end && T_AT(x, y, z0) <= T_AT(x, y + 1, z0)) {
+                    sign_bf++;
+                    sign_ff++;
+                    if (y < y_start_ff) y_start_ff = y;
+                    if (y < y_start_bf) y_start_bf = y;
+                    updated += diff_2d(x, y + 1, z, T_AT(x, y, z0), hs_ff, hs_bf);
+                    updated += t_2d(x, y + 1, z, T_AT(x, y, z0), T_AT(x, y + 1, z0), hs_ff, hs_bf);
+                }
+                if (y > y_begin && T_AT(x, y, z0) <= T_AT(x, y - 1, z0)) {
+                    sign_bb++;
+                    sign_fb++;
+                    if (y > y_start_fb) y_start_fb = y;
+                    if (y > y_start_bb) y_start_bb = y;
+                    updated += diff_2d(x, y - 1, z, T_AT(x, y, z0), hs_bb, hs_fb);
+                    updated += t_2d(x, y - 1, z, T_AT(x, y, z0), T_AT(x, y - 1, z0), hs_bb, hs_fb);
+                }
 
-            /* illuminate third neighbours */
-            /* 4 3D point diffraction, 8 3D edge diffraction and 12 3D transmission */
-            if (sign_ff == 2) {
-                flag_ff = 1;
-                updated += point_diff(x + 1, y + 1, z, t[x][y][z0], hs_ff)
-                        + edge_diff(x + 1, y + 1, z, t[x][y][z0], t[x + 1][y][z0], hs_ff)
-                        + edge_diff(x + 1, y + 1, z, t[x][y][z0], t[x][y + 1][z0], hs_ff)
-                        + t_3d_part2(x + 1, y + 1, z, t[x][y][z0], t[x + 1][y][z0],
-                        t[x][y + 1][z0], t[x + 1][y + 1][z0], hs_ff);
-            }
-            if (sign_bf == 2) {
-                flag_bf = 1;
-                updated += point_diff(x - 1, y + 1, z, t[x][y][z0], hs_bf)
-                        + edge_diff(x - 1, y + 1, z, t[x][y][z0], t[x - 1][y][z0], hs_bf)
-                        + edge_diff(x - 1, y + 1, z, t[x][y][z0], t[x][y + 1][z0], hs_bf)
-                        + t_3d_part2(x - 1, y + 1, z, t[x][y][z0], t[x - 1][y][z0],
-                        t[x][y + 1][z0], t[x - 1][y + 1][z0], hs_bf);
-            }
-            if (sign_bb == 2) {
-                flag_bb = 1;
-                updated += point_diff(x - 1, y - 1, z, t[x][y][z0], hs_bb)
-                        + edge_diff(x - 1, y - 1, z, t[x][y][z0], t[x - 1][y][z0], hs_bb)
-                        + edge_diff(x - 1, y - 1, z, t[x][y][z0], t[x][y - 1][z0], hs_bb)
-                        + t_3d_part2(x - 1, y - 1, z, t[x][y][z0], t[x - 1][y][z0],
-                        t[x][y - 1][z0], t[x - 1][y - 1][z0], hs_bb);
-            }
-            if (sign_fb == 2) {
-                flag_fb = 1;
-                updated += point_diff(x + 1, y - 1, z, t[x][y][z0], hs_fb)
-                        + edge_diff(x + 1, y - 1, z, t[x][y][z0], t[x + 1][y][z0], hs_fb)
-                        + edge_diff(x + 1, y - 1, z, t[x][y][z0], t[x][y - 1][z0], hs_fb)
-                        + t_3d_part2(x + 1, y - 1, z, t[x][y][z0], t[x + 1][y][z0],
-                        t[x][y - 1][z0], t[x + 1][y - 1][z0], hs_fb);
+                /* illuminate third neighbours */
+                /* 4 3D point diffraction, 8 3D edge diffraction and 12 3D transmission */
+                if (sign_ff == 2) {
+                    flag_ff = 1;
+                    updated += point_diff(x + 1, y + 1, z, T_AT(x, y, z0), hs_ff)
+                            + edge_diff(x + 1, y + 1, z, T_AT(x, y, z0), T_AT(x + 1, y, z0), hs_ff)
+                            + edge_diff(x + 1, y + 1, z, T_AT(x, y, z0), T_AT(x, y + 1, z0), hs_ff)
+                            + t_3d_part2(x + 1, y + 1, z, T_AT(x, y, z0), T_AT(x + 1, y, z0),
+                            T_AT(x, y + 1, z0), T_AT(x + 1, y + 1, z0), hs_ff);
+                }
+                if (sign_bf == 2) {
+                    flag_bf = 1;
+                    updated += point_diff(x - 1, y + 1, z, T_AT(x, y, z0), hs_bf)
+                            + edge_diff(x - 1, y + 1, z, T_AT(x, y, z0), T_AT(x - 1, y, z0), hs_bf)
+                            + edge_diff(x - 1, y + 1, z, T_AT(x, y, z0), T_AT(x, y + 1, z0), hs_bf)
+                            + t_3d_part2(x - 1, y + 1, z, T_AT(x, y, z0), T_AT(x - 1, y, z0),
+                            T_AT(x, y + 1, z0), T_AT(x - 1, y + 1, z0), hs_bf);
+                }
+                if (sign_bb == 2) {
+                    flag_bb = 1;
+                    updated += point_diff(x - 1, y - 1, z, T_AT(x, y, z0), hs_bb)
+                            + edge_diff(x - 1, y - 1, z, T_AT(x, y, z0), T_AT(x - 1, y, z0), hs_bb)
+                            + edge_diff(x - 1, y - 1, z, T_AT(x, y, z0), T_AT(x, y - 1, z0), hs_bb)
+                            + t_3d_part2(x - 1, y - 1, z, T_AT(x, y, z0), T_AT(x - 1, y, z0),
+                            T_AT(x, y - 1, z0), T_AT(x - 1, y - 1, z0), hs_bb);
+                }
+                if (sign_fb == 2) {
+                    flag_fb = 1;
+                    updated += point_diff(x + 1, y - 1, z, T_AT(x, y, z0), hs_fb)
+                            + edge_diff(x + 1, y - 1, z, T_AT(x, y, z0), T_AT(x + 1, y, z0), hs_fb)
+                            + edge_diff(x + 1, y - 1, z, T_AT(x, y, z0), T_AT(x, y - 1, z0), hs_fb)
+                            + t_3d_part2(x + 1, y - 1, z, T_AT(x, y, z0), T_AT(x + 1, y, z0),
+                            T_AT(x, y - 1, z0), T_AT(x + 1, y - 1, z0), hs_fb);
+                }
             }
         }
     }
@@ -2894,28 +2931,28 @@ int x_start, x_end, y_start, y_end, z0, z, z_s;
 
     hs_bb = hs_ubb = hs_ube = INFINITY;
     for (x = x_start, y = y_start; x < x_end; x++) {
-        hs_bf = hs[x][y][z_s];
-        if (y) hs_bb = hs[x][y - 1][z_s];
+        hs_bf = HS_AT(x, y, z_s);
+        if (y) hs_bb = HS_AT(x, y - 1, z_s);
         if (z_sf >= 0 && z_sf < nmesh_z) {
-            hs_ube = hs[x][y][z_sf];
-            if (y) hs_ubb = hs[x][y - 1][z_sf];
+            hs_ube = HS_AT(x, y, z_sf);
+            if (y) hs_ubb = HS_AT(x, y - 1, z_sf);
         }
-        alert1 = t_1d(x + 1, y, z, t[x][y][z], hs_bb, hs_bf, hs_ubb, hs_ube);
-        alert0 = t_2d(x + 1, y, z, t[x][y][z0], t[x][y][z], hs_bb, hs_bf);
+        alert1 = t_1d(x + 1, y, z, T_AT(x, y, z), hs_bb, hs_bf, hs_ubb, hs_ube);
+        alert0 = t_2d(x + 1, y, z, T_AT(x, y, z0), T_AT(x, y, z), hs_bb, hs_bf);
         if (alert1) longflags[x * ny + ny + y] = 1;
         if (alert0) longflags[x * ny + ny + y] = 0;
     }
 
     hs_bb = hs_ubb = hs_ueb = INFINITY;
     for (x = x_start, y = y_start; y < y_end; y++) {
-        hs_fb = hs[x][y][z_s];
-        if (x) hs_bb = hs[x - 1][y][z_s];
+        hs_fb = HS_AT(x, y, z_s);
+        if (x) hs_bb = HS_AT(x - 1, y, z_s);
         if (z_sf >= 0 && z_sf < nmesh_z) {
-            hs_ueb = hs[x][y][z_sf];
-            if (x) hs_ubb = hs[x - 1][y][z_sf];
+            hs_ueb = HS_AT(x, y, z_sf);
+            if (x) hs_ubb = HS_AT(x - 1, y, z_sf);
         }
-        alert1 = t_1d(x, y + 1, z, t[x][y][z], hs_bb, hs_fb, hs_ubb, hs_ueb);
-        alert0 = t_2d(x, y + 1, z, t[x][y][z0], t[x][y][z], hs_bb, hs_fb);
+        alert1 = t_1d(x, y + 1, z, T_AT(x, y, z), hs_bb, hs_fb, hs_ubb, hs_ueb);
+        alert0 = t_2d(x, y + 1, z, T_AT(x, y, z0), T_AT(x, y, z), hs_bb, hs_fb);
         if (alert1) longflags[x * ny + y + 1] = 1;
         if (alert0) longflags[x * ny + y + 1] = 0;
     }
@@ -2923,29 +2960,29 @@ int x_start, x_end, y_start, y_end, z0, z, z_s;
     for (x = x_start; x < x_end; x++) {
         for (y = y_start; y < y_end; y++) {
 
-            hs_bb = hs[x][y][z_s];
-            hs_bf = hs[x][y + 1][z_s];
-            hs_fb = hs[x + 1][y][z_s];
+            hs_bb = HS_AT(x, y, z_s);
+            hs_bf = HS_AT(x, y + 1, z_s);
+            hs_fb = HS_AT(x + 1, y, z_s);
             if (z_sf >= 0 && z_sf < nmesh_z) {
-                hs_ubb = hs[x][y][z_sf];
-                hs_ube = hs[x][y + 1][z_sf];
-                hs_ueb = hs[x + 1][y][z_sf];
+                hs_ubb = HS_AT(x, y, z_sf);
+                hs_ube = HS_AT(x, y + 1, z_sf);
+                hs_ueb = HS_AT(x + 1, y, z_sf);
             } else hs_ubb = hs_ube = hs_ueb = INFINITY;
 
             /* bulk waves: 1 3D edge diffraction and 2 (*4) 3D transmission */
-            alert0 = edge_diff(x + 1, y + 1, z, t[x][y][z0], t[x][y][z], hs_bb)
-                    + t_3d(x + 1, y + 1, z, t[x][y][z0],
-                    t[x + 1][y][z0], t[x][y][z], t[x + 1][y][z], hs_bb)
-                    + t_3d(x + 1, y + 1, z, t[x][y][z0],
-                    t[x][y + 1][z0], t[x][y][z], t[x][y + 1][z], hs_bb);
+            alert0 = edge_diff(x + 1, y + 1, z, T_AT(x, y, z0), T_AT(x, y, z), hs_bb)
+                    + t_3d(x + 1, y + 1, z, T_AT(x, y, z0),
+                    T_AT(x + 1, y, z0), T_AT(x, y, z), T_AT(x + 1, y, z), hs_bb)
+                    + t_3d(x + 1, y + 1, z, T_AT(x, y, z0),
+                    T_AT(x, y + 1, z0), T_AT(x, y, z), T_AT(x, y + 1, z), hs_bb);
             if (alert0) {
                 updated += alert0;
                 longflags[x * ny + ny + y + 1] = 0;
             }
 
             /* interface waves along x_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x + 1, y + 1, z, t[x][y + 1][z], hs_bb, hs_bf, hs_ubb, hs_ube);
-            alert0 = t_2d(x + 1, y + 1, z, t[x][y + 1][z0], t[x][y + 1][z], hs_bb, hs_bf);
+            alert1 = t_1d(x + 1, y + 1, z, T_AT(x, y + 1, z), hs_bb, hs_bf, hs_ubb, hs_ube);
+            alert0 = t_2d(x + 1, y + 1, z, T_AT(x, y + 1, z0), T_AT(x, y + 1, z), hs_bb, hs_bf);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_fb++; /* this scan must be (re-)examined */
@@ -2956,8 +2993,8 @@ int x_start, x_end, y_start, y_end, z0, z, z_s;
             }
 
             /* interface waves along y_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x + 1, y + 1, z, t[x + 1][y][z], hs_bb, hs_fb, hs_ubb, hs_ueb);
-            alert0 = t_2d(x + 1, y + 1, z, t[x + 1][y][z0], t[x + 1][y][z], hs_bb, hs_fb);
+            alert1 = t_1d(x + 1, y + 1, z, T_AT(x + 1, y, z), hs_bb, hs_fb, hs_ubb, hs_ueb);
+            alert0 = t_2d(x + 1, y + 1, z, T_AT(x + 1, y, z0), T_AT(x + 1, y, z), hs_bb, hs_fb);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_bf++; /* this scan must be (re-)examined */
@@ -2968,9 +3005,9 @@ int x_start, x_end, y_start, y_end, z0, z, z_s;
             }
 
             /* interface waves along z_side : 2 2D transmission and 1 2D diffraction */
-            alert1 = diff_2d(x + 1, y + 1, z, t[x][y][z], hs_bb, hs_ubb)
-                    + t_2d(x + 1, y + 1, z, t[x][y][z], t[x + 1][y][z], hs_bb, hs_ubb)
-                    + t_2d(x + 1, y + 1, z, t[x][y][z], t[x][y + 1][z], hs_bb, hs_ubb);
+            alert1 = diff_2d(x + 1, y + 1, z, T_AT(x, y, z), hs_bb, hs_ubb)
+                    + t_2d(x + 1, y + 1, z, T_AT(x, y, z), T_AT(x + 1, y, z), hs_bb, hs_ubb)
+                    + t_2d(x + 1, y + 1, z, T_AT(x, y, z), T_AT(x, y + 1, z), hs_bb, hs_ubb);
             if (alert1) {
                 updated += alert1;
                 longflags[x * ny + ny + y + 1] = 1;
@@ -3004,28 +3041,28 @@ int x_start, x_begin, y_start, y_end, z0, z, z_s;
 
     hs_fb = hs_uee = hs_ueb = INFINITY;
     for (x = x_start, y = y_start; x > x_begin; x--) {
-        hs_ff = hs[x - 1][y][z_s];
-        if (y) hs_fb = hs[x - 1][y - 1][z_s];
+        hs_ff = HS_AT(x - 1, y, z_s);
+        if (y) hs_fb = HS_AT(x - 1, y - 1, z_s);
         if (z_sf >= 0 && z_sf < nmesh_z) {
-            hs_uee = hs[x - 1][y][z_sf];
-            if (y) hs_ueb = hs[x - 1][y - 1][z_sf];
+            hs_uee = HS_AT(x - 1, y, z_sf);
+            if (y) hs_ueb = HS_AT(x - 1, y - 1, z_sf);
         }
-        alert1 = t_1d(x - 1, y, z, t[x][y][z], hs_fb, hs_ff, hs_ueb, hs_uee);
-        alert0 = t_2d(x - 1, y, z, t[x][y][z0], t[x][y][z], hs_fb, hs_ff);
+        alert1 = t_1d(x - 1, y, z, T_AT(x, y, z), hs_fb, hs_ff, hs_ueb, hs_uee);
+        alert0 = t_2d(x - 1, y, z, T_AT(x, y, z0), T_AT(x, y, z), hs_fb, hs_ff);
         if (alert1) longflags[x * ny - ny + y] = 1;
         if (alert0) longflags[x * ny - ny + y] = 0;
     }
 
     hs_bb = hs_ubb = hs_ueb = INFINITY;
     for (x = x_start, y = y_start; y < y_end; y++) {
-        if (x) hs_bb = hs[x - 1][y][z_s];
-        hs_fb = hs[x][y][z_s];
+        if (x) hs_bb = HS_AT(x - 1, y, z_s);
+        hs_fb = HS_AT(x, y, z_s);
         if (z_sf >= 0 && z_sf < nmesh_z) {
-            if (x) hs_ubb = hs[x - 1][y][z_sf];
-            hs_ueb = hs[x][y][z_sf];
+            if (x) hs_ubb = HS_AT(x - 1, y, z_sf);
+            hs_ueb = HS_AT(x, y, z_sf);
         }
-        alert1 = t_1d(x, y + 1, z, t[x][y][z], hs_bb, hs_fb, hs_ubb, hs_ueb);
-        alert0 = t_2d(x, y + 1, z, t[x][y][z0], t[x][y][z], hs_bb, hs_fb);
+        alert1 = t_1d(x, y + 1, z, T_AT(x, y, z), hs_bb, hs_fb, hs_ubb, hs_ueb);
+        alert0 = t_2d(x, y + 1, z, T_AT(x, y, z0), T_AT(x, y, z), hs_bb, hs_fb);
         if (alert1) longflags[x * ny + y + 1] = 1;
         if (alert0) longflags[x * ny + y + 1] = 0;
     }
@@ -3033,31 +3070,31 @@ int x_start, x_begin, y_start, y_end, z0, z, z_s;
     for (x = x_start; x > x_begin; x--) {
         for (y = y_start; y < y_end; y++) {
 
-            hs_ff = hs[x - 1][y + 1][z_s];
-            if (x > 1) hs_bb = hs[x - 2][y][z_s];
+            hs_ff = HS_AT(x - 1, y + 1, z_s);
+            if (x > 1) hs_bb = HS_AT(x - 2, y, z_s);
             else hs_bb = INFINITY;
-            hs_fb = hs[x - 1][y][z_s];
+            hs_fb = HS_AT(x - 1, y, z_s);
             if (z_sf >= 0 && z_sf < nmesh_z) {
-                hs_uee = hs[x - 1][y + 1][z_sf];
-                if (x > 1) hs_ubb = hs[x - 2][y][z_sf];
+                hs_uee = HS_AT(x - 1, y + 1, z_sf);
+                if (x > 1) hs_ubb = HS_AT(x - 2, y, z_sf);
                 else hs_ubb = INFINITY;
-                hs_ueb = hs[x - 1][y][z_sf];
+                hs_ueb = HS_AT(x - 1, y, z_sf);
             } else hs_ubb = hs_uee = hs_ueb = INFINITY;
 
             /* bulk waves: 1 3D edge diffraction and 2 (*4) 3D transmission */
-            alert0 = edge_diff(x - 1, y + 1, z, t[x][y][z0], t[x][y][z], hs_fb)
-                    + t_3d(x - 1, y + 1, z, t[x][y][z0],
-                    t[x - 1][y][z0], t[x][y][z], t[x - 1][y][z], hs_fb)
-                    + t_3d(x - 1, y + 1, z, t[x][y][z0],
-                    t[x][y + 1][z0], t[x][y][z], t[x][y + 1][z], hs_fb);
+            alert0 = edge_diff(x - 1, y + 1, z, T_AT(x, y, z0), T_AT(x, y, z), hs_fb)
+                    + t_3d(x - 1, y + 1, z, T_AT(x, y, z0),
+                    T_AT(x - 1, y, z0), T_AT(x, y, z), T_AT(x - 1, y, z), hs_fb)
+                    + t_3d(x - 1, y + 1, z, T_AT(x, y, z0),
+                    T_AT(x, y + 1, z0), T_AT(x, y, z), T_AT(x, y + 1, z), hs_fb);
             if (alert0) {
                 updated += alert0;
                 longflags[x * ny - ny + y + 1] = 0;
             }
 
             /* interface waves along x_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x - 1, y + 1, z, t[x][y + 1][z], hs_ff, hs_fb, hs_uee, hs_ueb);
-            alert0 = t_2d(x - 1, y + 1, z, t[x][y + 1][z0], t[x][y + 1][z], hs_ff, hs_fb);
+            alert1 = t_1d(x - 1, y + 1, z, T_AT(x, y + 1, z), hs_ff, hs_fb, hs_uee, hs_ueb);
+            alert0 = t_2d(x - 1, y + 1, z, T_AT(x, y + 1, z0), T_AT(x, y + 1, z), hs_ff, hs_fb);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_bb++; /* this scan must be (re-)examined */
@@ -3068,8 +3105,8 @@ int x_start, x_begin, y_start, y_end, z0, z, z_s;
             }
 
             /* interface waves along y_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x - 1, y + 1, z, t[x - 1][y][z], hs_bb, hs_fb, hs_ubb, hs_ueb);
-            alert0 = t_2d(x - 1, y + 1, z, t[x - 1][y][z0], t[x - 1][y][z], hs_bb, hs_fb);
+            alert1 = t_1d(x - 1, y + 1, z, T_AT(x - 1, y, z), hs_bb, hs_fb, hs_ubb, hs_ueb);
+            alert0 = t_2d(x - 1, y + 1, z, T_AT(x - 1, y, z0), T_AT(x - 1, y, z), hs_bb, hs_fb);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_ff++; /* this scan must be (re-)examined */
@@ -3080,9 +3117,9 @@ int x_start, x_begin, y_start, y_end, z0, z, z_s;
             }
 
             /* interface waves along z_side : 2 2D transmission and 1 2D diffraction */
-            alert1 = diff_2d(x - 1, y + 1, z, t[x][y][z], hs_fb, hs_ueb)
-                    + t_2d(x - 1, y + 1, z, t[x][y][z], t[x - 1][y][z], hs_fb, hs_ueb)
-                    + t_2d(x - 1, y + 1, z, t[x][y][z], t[x][y + 1][z], hs_fb, hs_ueb);
+            alert1 = diff_2d(x - 1, y + 1, z, T_AT(x, y, z), hs_fb, hs_ueb)
+                    + t_2d(x - 1, y + 1, z, T_AT(x, y, z), T_AT(x - 1, y, z), hs_fb, hs_ueb)
+                    + t_2d(x - 1, y + 1, z, T_AT(x, y, z), T_AT(x, y + 1, z), hs_fb, hs_ueb);
             if (alert1) {
                 updated += alert1;
                 longflags[x * ny - ny + y + 1] = 1;
@@ -3116,28 +3153,28 @@ int x_start, x_begin, y_begin, y_start, z0, z, z_s;
 
     hs_ff = hs_uee = hs_ueb = INFINITY;
     for (x = x_start, y = y_start; x > x_begin; x--) {
-        if (y) hs_ff = hs[x - 1][y - 1][z_s];
-        hs_fb = hs[x - 1][y][z_s];
+        if (y) hs_ff = HS_AT(x - 1, y - 1, z_s);
+        hs_fb = HS_AT(x - 1, y, z_s);
         if (z_sf >= 0 && z_sf < nmesh_z) {
-            if (y) hs_uee = hs[x - 1][y - 1][z_sf];
-            hs_ueb = hs[x - 1][y][z_sf];
+            if (y) hs_uee = HS_AT(x - 1, y - 1, z_sf);
+            hs_ueb = HS_AT(x - 1, y, z_sf);
         }
-        alert1 = t_1d(x - 1, y, z, t[x][y][z], hs_fb, hs_ff, hs_ueb, hs_uee);
-        alert0 = t_2d(x - 1, y, z, t[x][y][z0], t[x][y][z], hs_fb, hs_ff);
+        alert1 = t_1d(x - 1, y, z, T_AT(x, y, z), hs_fb, hs_ff, hs_ueb, hs_uee);
+        alert0 = t_2d(x - 1, y, z, T_AT(x, y, z0), T_AT(x, y, z), hs_fb, hs_ff);
         if (alert1) longflags[x * ny - ny + y] = 1;
         if (alert0) longflags[x * ny - ny + y] = 0;
     }
 
     hs_ff = hs_uee = hs_ube = INFINITY;
     for (x = x_start, y = y_start; y > y_begin; y--) {
-        if (x) hs_ff = hs[x - 1][y - 1][z_s];
-        hs_bf = hs[x][y - 1][z_s];
+        if (x) hs_ff = HS_AT(x - 1, y - 1, z_s);
+        hs_bf = HS_AT(x, y - 1, z_s);
         if (z_sf >= 0 && z_sf < nmesh_z) {
-            if (x) hs_uee = hs[x - 1][y - 1][z_sf];
-            hs_ube = hs[x][y - 1][z_sf];
+            if (x) hs_uee = HS_AT(x - 1, y - 1, z_sf);
+            hs_ube = HS_AT(x, y - 1, z_sf);
         }
-        alert1 = t_1d(x, y - 1, z, t[x][y][z], hs_bf, hs_ff, hs_ube, hs_uee);
-        alert0 = t_2d(x, y - 1, z, t[x][y][z0], t[x][y][z], hs_bf, hs_ff);
+        alert1 = t_1d(x, y - 1, z, T_AT(x, y, z), hs_bf, hs_ff, hs_ube, hs_uee);
+        alert0 = t_2d(x, y - 1, z, T_AT(x, y, z0), T_AT(x, y, z), hs_bf, hs_ff);
         if (alert1) longflags[x * ny + y - 1] = 1;
         if (alert0) longflags[x * ny + y - 1] = 0;
     }
@@ -3145,33 +3182,33 @@ int x_start, x_begin, y_begin, y_start, z0, z, z_s;
     for (x = x_start; x > x_begin; x--) {
         for (y = y_start; y > y_begin; y--) {
 
-            hs_ff = hs[x - 1][y - 1][z_s];
-            if (x > 1) hs_bf = hs[x - 2][y - 1][z_s];
+            hs_ff = HS_AT(x - 1, y - 1, z_s);
+            if (x > 1) hs_bf = HS_AT(x - 2, y - 1, z_s);
             else hs_bf = INFINITY;
-            if (y > 1) hs_fb = hs[x - 1][y - 2][z_s];
+            if (y > 1) hs_fb = HS_AT(x - 1, y - 2, z_s);
             else hs_fb = INFINITY;
             if (z_sf >= 0 && z_sf < nmesh_z) {
-                hs_uee = hs[x - 1][y - 1][z_sf];
-                if (x > 1) hs_ube = hs[x - 2][y - 1][z_sf];
+                hs_uee = HS_AT(x - 1, y - 1, z_sf);
+                if (x > 1) hs_ube = HS_AT(x - 2, y - 1, z_sf);
                 else hs_ube = INFINITY;
-                if (y > 1) hs_ueb = hs[x - 1][y - 2][z_sf];
+                if (y > 1) hs_ueb = HS_AT(x - 1, y - 2, z_sf);
                 else hs_ueb = INFINITY;
             } else hs_uee = hs_ube = hs_ueb = INFINITY;
 
             /* bulk waves: 1 3D edge diffraction and 2 (*4) 3D transmission */
-            alert0 = edge_diff(x - 1, y - 1, z, t[x][y][z0], t[x][y][z], hs_ff)
-                    + t_3d(x - 1, y - 1, z, t[x][y][z0],
-                    t[x - 1][y][z0], t[x][y][z], t[x - 1][y][z], hs_ff)
-                    + t_3d(x - 1, y - 1, z, t[x][y][z0],
-                    t[x][y - 1][z0], t[x][y][z], t[x][y - 1][z], hs_ff);
+            alert0 = edge_diff(x - 1, y - 1, z, T_AT(x, y, z0), T_AT(x, y, z), hs_ff)
+                    + t_3d(x - 1, y - 1, z, T_AT(x, y, z0),
+                    T_AT(x - 1, y, z0), T_AT(x, y, z), T_AT(x - 1, y, z), hs_ff)
+                    + t_3d(x - 1, y - 1, z, T_AT(x, y, z0),
+                    T_AT(x, y - 1, z0), T_AT(x, y, z), T_AT(x, y - 1, z), hs_ff);
             if (alert0) {
                 updated += alert0;
                 longflags[x * ny - ny + y - 1] = 0;
             }
 
             /* interface waves along x_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x - 1, y - 1, z, t[x][y - 1][z], hs_ff, hs_fb, hs_uee, hs_ueb);
-            alert0 = t_2d(x - 1, y - 1, z, t[x][y - 1][z0], t[x][y - 1][z], hs_ff, hs_fb);
+            alert1 = t_1d(x - 1, y - 1, z, T_AT(x, y - 1, z), hs_ff, hs_fb, hs_uee, hs_ueb);
+            alert0 = t_2d(x - 1, y - 1, z, T_AT(x, y - 1, z0), T_AT(x, y - 1, z), hs_ff, hs_fb);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_bf++; /* this scan must be (re-)examined */
@@ -3182,8 +3219,8 @@ int x_start, x_begin, y_begin, y_start, z0, z, z_s;
             }
 
             /* interface waves along y_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x - 1, y - 1, z, t[x - 1][y][z], hs_ff, hs_bf, hs_uee, hs_ube);
-            alert0 = t_2d(x - 1, y - 1, z, t[x - 1][y][z0], t[x - 1][y][z], hs_ff, hs_bf);
+            alert1 = t_1d(x - 1, y - 1, z, T_AT(x - 1, y, z), hs_ff, hs_bf, hs_uee, hs_ube);
+            alert0 = t_2d(x - 1, y - 1, z, T_AT(x - 1, y, z0), T_AT(x - 1, y, z), hs_ff, hs_bf);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_fb++; /* this scan must be (re-)examined */
@@ -3194,9 +3231,9 @@ int x_start, x_begin, y_begin, y_start, z0, z, z_s;
             }
 
             /* interface waves along z_side : 2 2D transmission and 1 2D diffraction */
-            alert1 = diff_2d(x - 1, y - 1, z, t[x][y][z], hs_ff, hs_uee)
-                    + t_2d(x - 1, y - 1, z, t[x][y][z], t[x - 1][y][z], hs_ff, hs_uee)
-                    + t_2d(x - 1, y - 1, z, t[x][y][z], t[x][y - 1][z], hs_ff, hs_uee);
+            alert1 = diff_2d(x - 1, y - 1, z, T_AT(x, y, z), hs_ff, hs_uee)
+                    + t_2d(x - 1, y - 1, z, T_AT(x, y, z), T_AT(x - 1, y, z), hs_ff, hs_uee)
+                    + t_2d(x - 1, y - 1, z, T_AT(x, y, z), T_AT(x, y - 1, z), hs_ff, hs_uee);
             if (alert1) {
                 updated += alert1;
                 longflags[x * ny - ny + y - 1] = 1;
@@ -3230,28 +3267,28 @@ int x_start, x_end, y_begin, y_start, z0, z, z_s;
 
     hs_bf = hs_ubb = hs_ube = INFINITY;
     for (x = x_start, y = y_start; x < x_end; x++) {
-        if (y) hs_bf = hs[x][y - 1][z_s];
-        hs_bb = hs[x][y][z_s];
+        if (y) hs_bf = HS_AT(x, y - 1, z_s);
+        hs_bb = HS_AT(x, y, z_s);
         if (z_sf >= 0 && z_sf < nmesh_z) {
-            if (y) hs_ube = hs[x][y - 1][z_sf];
-            hs_ubb = hs[x][y][z_sf];
+            if (y) hs_ube = HS_AT(x, y - 1, z_sf);
+            hs_ubb = HS_AT(x, y, z_sf);
         }
-        alert1 = t_1d(x + 1, y, z, t[x][y][z], hs_bf, hs_bb, hs_ube, hs_ubb);
-        alert0 = t_2d(x + 1, y, z, t[x][y][z0], t[x][y][z], hs_bf, hs_bb);
+        alert1 = t_1d(x + 1, y, z, T_AT(x, y, z), hs_bf, hs_bb, hs_ube, hs_ubb);
+        alert0 = t_2d(x + 1, y, z, T_AT(x, y, z0), T_AT(x, y, z), hs_bf, hs_bb);
         if (alert1) longflags[x * ny + ny + y] = 1;
         if (alert0) longflags[x * ny + ny + y] = 0;
     }
 
     hs_ff = hs_uee = hs_ube = INFINITY;
     for (x = x_start, y = y_start; y > y_begin; y--) {
-        if (x) hs_ff = hs[x - 1][y - 1][z_s];
-        hs_bf = hs[x][y - 1][z_s];
+        if (x) hs_ff = HS_AT(x - 1, y - 1, z_s);
+        hs_bf = HS_AT(x, y - 1, z_s);
         if (z_sf >= 0 && z_sf < nmesh_z) {
-            if (x) hs_uee = hs[x - 1][y - 1][z_sf];
-            hs_ube = hs[x][y - 1][z_sf];
+            if (x) hs_uee = HS_AT(x - 1, y - 1, z_sf);
+            hs_ube = HS_AT(x, y - 1, z_sf);
         }
-        alert1 = t_1d(x, y - 1, z, t[x][y][z], hs_bf, hs_ff, hs_ube, hs_uee);
-        alert0 = t_2d(x, y - 1, z, t[x][y][z0], t[x][y][z], hs_bf, hs_ff);
+        alert1 = t_1d(x, y - 1, z, T_AT(x, y, z), hs_bf, hs_ff, hs_ube, hs_uee);
+        alert0 = t_2d(x, y - 1, z, T_AT(x, y, z0), T_AT(x, y, z), hs_bf, hs_ff);
         if (alert1) longflags[x * ny + y - 1] = 1;
         if (alert0) longflags[x * ny + y - 1] = 0;
     }
@@ -3259,31 +3296,31 @@ int x_start, x_end, y_begin, y_start, z0, z, z_s;
     for (x = x_start; x < x_end; x++) {
         for (y = y_start; y > y_begin; y--) {
 
-            hs_bf = hs[x][y - 1][z_s];
-            if (y > 1) hs_bb = hs[x][y - 2][z_s];
+            hs_bf = HS_AT(x, y - 1, z_s);
+            if (y > 1) hs_bb = HS_AT(x, y - 2, z_s);
             else hs_bb = INFINITY;
-            hs_ff = hs[x + 1][y - 1][z_s];
+            hs_ff = HS_AT(x + 1, y - 1, z_s);
             if (z_sf >= 0 && z_sf < nmesh_z) {
-                hs_ube = hs[x][y - 1][z_sf];
-                if (y > 1) hs_ubb = hs[x][y - 2][z_sf];
+                hs_ube = HS_AT(x, y - 1, z_sf);
+                if (y > 1) hs_ubb = HS_AT(x, y - 2, z_sf);
                 else hs_ubb = INFINITY;
-                hs_uee = hs[x + 1][y - 1][z_sf];
+                hs_uee = HS_AT(x + 1, y - 1, z_sf);
             } else hs_ubb = hs_ube = hs_uee = INFINITY;
 
             /* bulk waves: 1 3D edge diffraction and 2 (*4) 3D transmission */
-            alert0 = edge_diff(x + 1, y - 1, z, t[x][y][z0], t[x][y][z], hs_bf)
-                    + t_3d(x + 1, y - 1, z, t[x][y][z0],
-                    t[x + 1][y][z0], t[x][y][z], t[x + 1][y][z], hs_bf)
-                    + t_3d(x + 1, y - 1, z, t[x][y][z0],
-                    t[x][y - 1][z0], t[x][y][z], t[x][y - 1][z], hs_bf);
+            alert0 = edge_diff(x + 1, y - 1, z, T_AT(x, y, z0), T_AT(x, y, z), hs_bf)
+                    + t_3d(x + 1, y - 1, z, T_AT(x, y, z0),
+                    T_AT(x + 1, y, z0), T_AT(x, y, z), T_AT(x + 1, y, z), hs_bf)
+                    + t_3d(x + 1, y - 1, z, T_AT(x, y, z0),
+                    T_AT(x, y - 1, z0), T_AT(x, y, z), T_AT(x, y - 1, z), hs_bf);
             if (alert0) {
                 updated += alert0;
                 longflags[x * ny + ny + y - 1] = 0;
             }
 
             /* interface waves along x_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x + 1, y - 1, z, t[x][y - 1][z], hs_bb, hs_bf, hs_ubb, hs_ube);
-            alert0 = t_2d(x + 1, y - 1, z, t[x][y - 1][z0], t[x][y - 1][z], hs_bb, hs_bf);
+            alert1 = t_1d(x + 1, y - 1, z, T_AT(x, y - 1, z), hs_bb, hs_bf, hs_ubb, hs_ube);
+            alert0 = t_2d(x + 1, y - 1, z, T_AT(x, y - 1, z0), T_AT(x, y - 1, z), hs_bb, hs_bf);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_ff++; /* this scan must be (re-)examined */
@@ -3294,8 +3331,8 @@ int x_start, x_end, y_begin, y_start, z0, z, z_s;
             }
 
             /* interface waves along y_side: 1 1D transmission and 1 2D transmission */
-            alert1 = t_1d(x + 1, y - 1, z, t[x + 1][y][z], hs_ff, hs_bf, hs_uee, hs_ube);
-            alert0 = t_2d(x + 1, y - 1, z, t[x + 1][y][z0], t[x + 1][y][z], hs_ff, hs_bf);
+            alert1 = t_1d(x + 1, y - 1, z, T_AT(x + 1, y, z), hs_ff, hs_bf, hs_uee, hs_ube);
+            alert0 = t_2d(x + 1, y - 1, z, T_AT(x + 1, y, z0), T_AT(x + 1, y, z), hs_ff, hs_bf);
             if (alert0 + alert1) {
                 updated += alert0 + alert1;
                 flag_bb++; /* this scan must be (re-)examined */
@@ -3306,9 +3343,9 @@ int x_start, x_end, y_begin, y_start, z0, z, z_s;
             }
 
             /* interface waves along z_side : 2 2D transmission and 1 2D diffraction */
-            alert1 = diff_2d(x + 1, y - 1, z, t[x][y][z], hs_bf, hs_ube)
-                    + t_2d(x + 1, y - 1, z, t[x][y][z], t[x + 1][y][z], hs_bf, hs_ube)
-                    + t_2d(x + 1, y - 1, z, t[x][y][z], t[x][y - 1][z], hs_bf, hs_ube);
+            alert1 = diff_2d(x + 1, y - 1, z, T_AT(x, y, z), hs_bf, hs_ube)
+                    + t_2d(x + 1, y - 1, z, T_AT(x, y, z), T_AT(x + 1, y, z), hs_bf, hs_ube)
+                    + t_2d(x + 1, y - 1, z, T_AT(x, y, z), T_AT(x, y - 1, z), hs_bf, hs_ube);
             if (alert1) {
                 updated += alert1;
                 longflags[x * ny + ny + y - 1] = 1;
@@ -122,6 +122,10 @@ int main(int argc, char *argv[])
 	/* determine model coordinates mode - rect or latlon */
 	SetModelCoordsMode(num_surfaces);
 
+	/* 20261018 AJL - spatial index of polygon and solid model elements */
+	if (init_vel_model_index() < 0)
+		nll_puterr("WARNING: allocating memory for model element index, model elements will not be indexed.");
+
 
 	/* initialize 3D grid */
 
@@ -385,13 +389,14 @@ int VelModToGrid3d(GridDesc* grid, char *waveType)
 {
 
 	int ix, iy, iz;
-	int imodel;
+	int imodel, istat = 0;
 	char cWaveType;
 	double xval, yval, xloc, yloc, zdepth;
 	double vel, den, vel1;
+	double *xval_array;
 
 	double dlat, dlon;
-	FILE *fpfile;
+	FILE *fpfile = NULL;
 
 
 	/* check wavetype */
@@ -414,9 +419,26 @@ int VelModToGrid3d(GridDesc* grid, char *waveType)
 	/* generate grid values */
 	/* Note:  staggered grid assumed, thus vel lookup is shifted +dx/2, etc. */
 
+	/* 20261018 AJL - x values set first, x sheets are calculated in parallel if OpenMP available */
+	if ((xval_array = (double *) malloc(grid->numx * sizeof(double))) == NULL) {
+		nll_puterr("ERROR: allocating memory for x values.");
+		return(-1);
+	}
 	xval = grid->origx + grid->dx / 2.0;
+	for (ix = 0; ix <  grid->numx; ix++) {
+		xval_array[ix] = xval;
+		xval += grid->dx;
+	}
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) private(iy, iz, imodel, xval, yval, xloc, yloc, zdepth, vel, den, vel1, dlat, dlon) \
+		reduction(min:istat) if (!DUMP_LAT_LON_TO_FILE)
+#endif
 	for (ix = 0; ix <  grid->numx; ix++) {
 
+		if (istat < 0)
+			continue;
+		xval = xval_array[ix];
 		yval = grid->origy + grid->dy / 2.0;
 		for (iy = 0; iy <  grid->numy; iy++) {
 
@@ -457,7 +479,8 @@ printf("xloc %lf yloc %lf zdepth %lf cWaveType %c imodel %d vel %lg\n", xloc, yl
 
 				if (vel < 0.0) {
 					nll_puterr("ERROR: vel < 0.0, cannot get velocity.");
-					return(-1);
+					istat = -1;
+					break;
 				}
 
 				switch (grid->type) {
@@ -485,22 +508,30 @@ printf("xloc %lf yloc %lf zdepth %lf cWaveType %c imodel %d vel %lg\n", xloc, yl
 
 				default:
 				    nll_puterr("ERROR: unrecognized grid type.");
-					return(-1);
+					istat = -1;
 
 				}
+				if (istat < 0)
+					break;
 
 
 				zdepth += grid->dz;
 			}
+			if (istat < 0)
+				break;
 			yval += grid->dy;
 		}
-		xval += grid->dx;
 	}
 
+	free(xval_array);
+
 	if (DUMP_LAT_LON_TO_FILE) {
 		fclose(fpfile);
 	}
 
+	if (istat < 0)
+		return(-1);
+
 
 	return (0);
 
@@ -105,6 +105,7 @@ typedef struct {
     float *deltay; /* array with y coords of nodes (km) */
     float *deltaz; /* array with z coords of nodes (km) */
     int type; /* type of velocity model [TYPESIMUL/TYPEFDTOMO] */
+    int increasing_x, increasing_y, increasing_z; /* 1 if node coords are non-decreasing, allows binary search of nodes */
 } VelModel;
 
 #define TYPESIMUL  0
@@ -139,6 +140,12 @@ int VelModToGrid3d(VelModel*, GridDesc*, char *);
 int AllocateVelModel(VelModel*);
 void FreeVelModel(VelModel*);
 int VelModToFMM(VelModel* vel_model, GridDesc* grid, FILE* fp_fmmVgridFile, FILE* fp_fmmPropGridFile, FILE* fp_fmmInterfacesFile, char *waveType);
+float get3Dvel(VelModel* vel_model, float posx, float posy, float posz);
+float get3DvelAtIndex(VelModel* vel_model, int i, int j, int k, float t, float u, float v);
+float clipVel(float vel);
+void setAxisInterp(float *delta, int numdelta, int increasing, double orig, double d, int num, int *index, float *weight);
+int locateNode(float *delta, int numdelta, float pos, int increasing);
+int isNonDecreasing(float *delta, int numdelta);
 
 /*** program to generate  3-D vel/slowness grid */
 
@@ -166,6 +173,7 @@ int main(int argc, char *argv[]) {
     vel_model.buffer = NULL;
     vel_model.array = NULL;
     vel_model.deltax = vel_model.deltay = vel_model.deltaz = NULL;
+    vel_model.increasing_x = vel_model.increasing_y = vel_model.increasing_z = 0;
 
 
     /* set program name */
@@ -218,6 +226,11 @@ int main(int argc, char *argv[]) {
         /*	nll_puterr("ERROR: reading Velocity Model input file."); */
         exit(EXIT_ERROR_FILEIO);
     }
+    if (vel_model.type != TYPEALBERTO) {
+        vel_model.increasing_x = isNonDecreasing(vel_model.deltax, vel_model.numx);
+        vel_model.increasing_y = isNonDecreasing(vel_model.deltay, vel_model.numy);
+        vel_model.increasing_z = isNonDecreasing(vel_model.deltaz, vel_model.numz);
+    }
 
     /* initialize 3D grid */
 
@@ -520,24 +533,16 @@ float bilinearAtZ(VelModel* vel_model, int i, int j, int k, int t, int u) {
 /*** returns the velocity in a definite point of the space ***/
 
 float get3Dvel(VelModel* vel_model, float posx, float posy, float posz) {
-    float vel;
     int i, j, k;
     float t, u, v;
 
     //printf("get3Dvel(vel_model, xval %f, yval %f, zdepth %f\n", posx, posy, posz);
 
-#ifdef ZHANG_FORMAT_COORDS_POSX
-    for (i = 0; (i < vel_model->numx) && (vel_model->deltax[i] < posx); i++);
-#else
-#ifdef COORDS_POS_EAST
-    for (i = 0; (i < vel_model->numx) && (vel_model->deltax[i] < posx); i++);
-#else
     // 20241023 ALomax = Bug fix? #for (i = 0; (i < vel_model->numx) && (vel_model->deltax[i] > posx); i++);
-    for (i = 0; (i < vel_model->numx) && (vel_model->deltax[i] < posx); i++); // 20241023 ALomax = Bug fix?
-#endif
-#endif
-    for (j = 0; (j < vel_model->numy) && (vel_model->deltay[j] < posy); j++);
-    for (k = 0; (k < vel_model->numz) && (vel_model->deltaz[k] < posz); k++);
+    // 20261018 AJL - search for first node with coord >= pos moved to locateNode()
+    i = locateNode(vel_model->deltax, vel_model->numx, posx, vel_model->increasing_x);
+    j = locateNode(vel_model->deltay, vel_model->numy, posy, vel_model->increasing_y);
+    k = locateNode(vel_model->deltaz, vel_model->numz, posz, vel_model->increasing_z);
 
     if (i == 0) {
         t = 0;
@@ -568,6 +573,17 @@ float get3Dvel(VelModel* vel_model, float posx, float posy, float posz) {
 
     //printf("get3Dvel(vel_model, i %d, j %d, k %d, t %f, u %f, v %f\n", i, j, k, t, u, v);
 
+    return (get3DvelAtIndex(vel_model, i, j, k, t, u, v));
+}
+
+/*** returns the velocity for upper node indices i,j,k and interpolation factors t,u,v
+ *
+ * 20261018 AJL - separated from get3Dvel()
+ */
+
+float get3DvelAtIndex(VelModel* vel_model, int i, int j, int k, float t, float u, float v) {
+    float vel;
+
     // vel unset
     vel = -1.0;
 
@@ -602,7 +618,13 @@ float get3Dvel(VelModel* vel_model, float posx, float posy, float posz) {
                 vel_model->array[i - 1][j][k]*(1 - t)*(u)*(v);
     }
 
-    // clip velocity on low/high check
+    return (clipVel(vel));
+}
+
+/*** clip velocity on low/high check ***/
+
+float clipVel(float vel) {
+
     if (clip_method == CLIP_METHOD_LOW_HIGH) {
         if (vel < vel_clip_low)
             vel = vel_clip_low;
@@ -615,6 +637,72 @@ float get3Dvel(VelModel* vel_model, float posx, float posy, float posz) {
     return (vel);
 }
 
+/*** returns index of first node with coord >= pos, or numdelta if none
+ *
+ * 20261018 AJL - binary search if node coords are non-decreasing, otherwise linear search
+ */
+
+int locateNode(float *delta, int numdelta, float pos, int increasing) {
+    int i, ilow, ihigh;
+
+    if (!increasing) {
+        for (i = 0; (i < numdelta) && (delta[i] < pos); i++);
+        return (i);
+    }
+
+    ilow = 0;
+    ihigh = numdelta;
+    while (ilow < ihigh) {
+        i = (ilow + ihigh) / 2;
+        if (delta[i] < pos)
+            ilow = i + 1;
+        else
+            ihigh = i;
+    }
+
+    return (ilow);
+}
+
+/*** returns 1 if node coords are non-decreasing, 0 otherwise */
+
+int isNonDecreasing(float *delta, int numdelta) {
+    int i;
+
+    for (i = 1; i < numdelta; i++)
+        if (!(delta[i] >= delta[i - 1]))
+            return (0);
+
+    return (1);
+}
+
+/*** sets upper model node index and interpolation factor for each node of a regular output grid axis
+ *
+ * 20261018 AJL - same node positions, bracketing search and factors as used by VelModToGrid3d() and get3Dvel()
+ */
+
+void setAxisInterp(float *delta, int numdelta, int increasing, double orig, double d, int num, int *index, float *weight) {
+    int n, i;
+    float pos;
+    double val;
+
+    val = orig + d / 2.0;
+    for (n = 0; n < num; n++) {
+        pos = val;
+        i = locateNode(delta, numdelta, pos, increasing);
+        if (i == 0) {
+            weight[n] = 0;
+            i++;
+        } else if (i == numdelta) {
+            weight[n] = 1;
+            i--;
+        } else
+            weight[n] = (pos - delta[i - 1]) / (delta[i] - delta[i - 1]);
+        index[n] = i;
+        val += d;
+    }
+
+}
+
 /*** function to read output file name ***/
 
 int get_vg_outfile(char* line1) {
@@ -890,11 +978,14 @@ int ReadVel2Grid3DInput(FILE* fp_input, VelModel * vel_model) {
 
 int VelModToGrid3d(VelModel* vel_model, GridDesc* grid, char *waveType) {
 
-    int ix, iy, iz;
+    int ix, iy, iz, i, j, k, istat = 0;
     //int imodel;
     //char cWaveType;
-    double xval, yval, xloc, yloc, zdepth;
+    float t, u, v, fvel;
     double vel;
+    int *index_x = NULL, *index_y = NULL, *index_z = NULL;
+    float *weight_x = NULL, *weight_y = NULL, *weight_z = NULL;
+    float *column;
 
 
     /* check wavetype */
@@ -910,26 +1001,79 @@ int VelModToGrid3d(VelModel* vel_model, GridDesc* grid, char *waveType) {
         //return (-1);
     }
 
+    if (grid->type != GRID_VELOCITY && grid->type != GRID_VELOCITY_METERS
+            && grid->type != GRID_SLOW_LEN && grid->type != GRID_SLOW2_METERS) {
+        nll_puterr("ERROR: unrecognized grid type.");
+        return (-1);
+    }
+
 
     /* generate grid values */
     /* Note:  staggered grid assumed, thus vel lookup is shifted +dx/2, etc. */
 
-    xval = grid->origx + grid->dx / 2.0;
+    /* 20261018 AJL - output grid axes are regular, so bracketing model nodes and interpolation factors
+     *  are set once for each axis. For each output column, the model is interpolated in x,y at all model z nodes,
+     *  then in z for each output node; x sheets are calculated in parallel if OpenMP available.
+     *  Values are identical to those from get3Dvel() for each node. */
+    if (vel_model->type != TYPEALBERTO) {
+        index_x = (int *) malloc(grid->numx * sizeof (int));
+        index_y = (int *) malloc(grid->numy * sizeof (int));
+        index_z = (int *) malloc(grid->numz * sizeof (int));
+        weight_x = (float *) malloc(grid->numx * sizeof (float));
+        weight_y = (float *) malloc(grid->numy * sizeof (float));
+        weight_z = (float *) malloc(grid->numz * sizeof (float));
+        if (index_x == NULL || index_y == NULL || index_z == NULL
+                || weight_x == NULL || weight_y == NULL || weight_z == NULL) {
+            nll_puterr("ERROR: allocating memory for interpolation tables.");
+            return (-1);
+        }
+        setAxisInterp(vel_model->deltax, vel_model->numx, vel_model->increasing_x, grid->origx, grid->dx, grid->numx, index_x, weight_x);
+        setAxisInterp(vel_model->deltay, vel_model->numy, vel_model->increasing_y, grid->origy, grid->dy, grid->numy, index_y, weight_y);
+        setAxisInterp(vel_model->deltaz, vel_model->numz, vel_model->increasing_z, grid->origz, grid->dz, grid->numz, index_z, weight_z);
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) private(iy, iz, i, j, k, t, u, v, fvel, vel, column) reduction(min:istat)
+#endif
     for (ix = 0; ix < grid->numx; ix++) {
-        yval = grid->origy + grid->dy / 2.0;
+        if (istat < 0)
+            continue;
+        /* model values interpolated in x,y at model z nodes, for each of the 4 x,y corners */
+        column = NULL;
+        if (vel_model->type != TYPEALBERTO && clip_method != CLIP_METHOD_CHECK_BELOW_FOR_MOHO
+                && (column = (float *) malloc(4 * vel_model->numz * sizeof (float))) == NULL) {
+            nll_puterr("ERROR: allocating memory for model column.");
+            istat = -1;
+            continue;
+        }
         for (iy = 0; iy < grid->numy; iy++) {
-            if (ModelCoordsMode == COORDS_LATLON) {
-                rect2latlon(0, xval, yval, &yloc, &xloc);
-            } else {
-                xloc = xval;
-                yloc = yval;
+            if (column != NULL) {
+                i = index_x[ix];
+                t = weight_x[ix];
+                j = index_y[iy];
+                u = weight_y[iy];
+                for (k = 0; k < vel_model->numz; k++) {
+                    column[4 * k] = vel_model->array[i - 1][j - 1][k]*(1 - t)*(1 - u);
+                    column[4 * k + 1] = vel_model->array[i][j - 1][k]*(t)*(1 - u);
+                    column[4 * k + 2] = vel_model->array[i][j][k]*(t)*(u);
+                    column[4 * k + 3] = vel_model->array[i - 1][j][k]*(1 - t)*(u);
+                }
             }
-            zdepth = grid->origz + grid->dz / 2.0;
             for (iz = 0; iz < grid->numz; iz++) {
                 if (vel_model->type == TYPEALBERTO) {
                     vel = vel_model->array[ix][iy][iz];
+                } else if (column != NULL) {
+                    // same terms and order of operations as get3DvelAtIndex()
+                    k = index_z[iz];
+                    v = weight_z[iz];
+                    fvel = column[4 * (k - 1)]*(1 - v) + column[4 * (k - 1) + 1]*(1 - v)
+                            + column[4 * (k - 1) + 2]*(1 - v) + column[4 * (k - 1) + 3]*(1 - v)
+                            + column[4 * k]*(v) + column[4 * k + 1]*(v)
+                            + column[4 * k + 2]*(v) + column[4 * k + 3]*(v);
+                    vel = clipVel(fvel);
                 } else {
-                    vel = get3Dvel(vel_model, xval, yval, zdepth);
+                    vel = get3DvelAtIndex(vel_model, index_x[ix], index_y[iy], index_z[iz],
+                            weight_x[ix], weight_y[iy], weight_z[iz]);
                     /*if (imodel >= LAYEROFFSET || imodel < 0) {
                         // check for surface
                         vel1 = get_surface_vel(
@@ -938,12 +1082,12 @@ int VelModToGrid3d(VelModel* vel_model, GridDesc* grid, char *waveType) {
                                 num_surfaces, &den, 0);
                         vel = vel1 > 0.0 ? vel1 : vel;
                     }*/
-                    //printf("get3Dvel(vel_model, xval %f, yval %f, zdepth %f, vel %f\n", xval, yval, zdepth, vel);
                 }
 
                 if (vel < 0.0) {
                     nll_puterr("ERROR: cannot get velocity.");
-                    return (-1);
+                    istat = -1;
+                    break;
                 }
 
                 switch (grid->type) {
@@ -965,22 +1109,23 @@ int VelModToGrid3d(VelModel* vel_model, GridDesc* grid, char *waveType) {
                                 (1.0e-3 / vel) * (1.0e-3 / vel);
                         break;
 
-                    default:
-                        nll_puterr("ERROR: unrecognized grid type.");
-
-                        return (-1);
-
                 }
 
-                zdepth += grid->dz;
             }
-            yval += grid->dy;
+            if (istat < 0)
+                break;
         }
-        xval += grid->dx;
+        free(column);
     }
 
+    free(index_x);
+    free(index_y);
+    free(index_z);
+    free(weight_x);
+    free(weight_y);
+    free(weight_z);
 
-    return (0);
+    return (istat < 0 ? -1 : 0);
 
 }
 
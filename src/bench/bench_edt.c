@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2026 Anthony Lomax <anthony@alomax.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+/*   bench_edt.c
+
+        Benchmark of the EDT likelihood (CalcSolutionQuality_EDT) evaluated by NLLoc at each
+        search node, for LOCMETH EDT_OT_WT and EDT_OT_WT_ML (maximum likelihood origin time at each node).
+
+        Synthetic stations and arrival times are generated for a fixed hypocenter, predicted
+        travel times are computed for a homogeneous velocity at pseudo-random nodes and the
+        likelihood is evaluated at each node, one result line per number of arrivals is written
+        to stdout (see bench_util.h).
+
+ */
+
+
+/*
+        history:
+
+        ver 01    20261018  AJL  Original version
+
+
+.........1.........2.........3.........4.........5.........6.........7.........8
+
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "GridLib.h"
+#include "ran1/ran1.h"
+#include "velmod.h"
+#include "GridMemLib.h"
+#include "calc_crust_corr.h"
+#include "phaseloclist.h"
+#include "otime_limit.h"
+#include "NLLocLib.h"
+#include "bench_util.h"
+
+
+#define PNAME  "bench_edt"
+
+#define VELOCITY 6.0
+
+static HypoDesc hypo;
+
+/** next pseudo-random value in [0,1) */
+
+static double next_random(unsigned int *pseed) {
+
+    *pseed = *pseed * 1103515245u + 12345u;
+    return ((double) (*pseed >> 8) / 16777216.0);
+}
+
+static double travel_time(SourceDesc *psta, double x, double y, double z) {
+
+    double dx = psta->x - x;
+    double dy = psta->y - y;
+    double dz = psta->z - z;
+
+    return (sqrt(dx * dx + dy * dy + dz * dz) / VELOCITY);
+}
+
+/** evaluate EDT likelihood at num_nodes nodes for num_arr arrivals, write result line */
+
+static int run_case(char *case_name, int otime_weight, int num_arr, long num_nodes) {
+
+    int narr;
+    long n;
+    unsigned int seed = 12345;
+    double x, y, z, misfit, value, checksum, t_start, t_elapsed;
+    ArrivalDesc *arrival;
+    GaussLocParams gauss;
+
+    if ((arrival = (ArrivalDesc *) calloc(num_arr, sizeof (ArrivalDesc))) == NULL) {
+        fprintf(stderr, "%s: ERROR: allocating arrivals.\n", PNAME);
+        return (-1);
+    }
+
+    // stations on surface, P arrivals from hypocenter at (50,50,10) with origin time 10 s
+    for (narr = 0; narr < num_arr; narr++) {
+        sprintf(arrival[narr].label, "S%03d", narr);
+        strcpy(arrival[narr].inst, "?");
+        strcpy(arrival[narr].phase, "P");
+        arrival[narr].station.x = 100.0 * next_random(&seed);
+        arrival[narr].station.y = 100.0 * next_random(&seed);
+        arrival[narr].station.z = 0.0;
+        arrival[narr].error = 0.1;
+        arrival[narr].abs_time = 1;
+        arrival[narr].station_weight = 1.0;
+        arrival[narr].obs_time = 10.0L + (long double) travel_time(&(arrival[narr].station), 50.0, 50.0, 10.0)
+                + 0.05L * (long double) (next_random(&seed) - 0.5);
+    }
+
+    memset(&gauss, 0, sizeof (GaussLocParams));
+    gauss.SigmaT = 0.1;
+    gauss.CorrLen = 0.0;
+    if (ConstWeightMatrix(num_arr, arrival, &gauss) < 0) {
+        fprintf(stderr, "%s: ERROR: constructing weight matrix.\n", PNAME);
+        free(arrival);
+        return (-1);
+    }
+    CalcCenteredTimesObs(num_arr, arrival, &gauss, &hypo);
+
+    EDT_use_otime_weight = otime_weight;
+    checksum = 0.0;
+    t_start = bench_wall_time();
+    for (n = 0; n < num_nodes; n++) {
+        x = 100.0 * next_random(&seed);
+        y = 100.0 * next_random(&seed);
+        z = 30.0 * next_random(&seed);
+        for (narr = 0; narr < num_arr; narr++)
+            arrival[narr].pred_travel_time = travel_time(&(arrival[narr].station), x, y, z);
+        value = CalcSolutionQuality_EDT(num_arr, arrival, &gauss, GRID_PROB_DENSITY, &misfit, NULL, NULL, 0.0, 0);
+        checksum += value;
+    }
+    t_elapsed = bench_wall_time() - t_start;
+
+    fprintf(stdout, "%s case=%s arrivals=%d nodes=%ld seconds=%.4f ns_per_op=%.2f peak_rss_kb=%ld checksum=%.9e\n",
+            PNAME, case_name, num_arr, num_nodes, t_elapsed, 1.0e9 * t_elapsed / (double) num_nodes, bench_peak_rss_kb(RUSAGE_SELF), checksum);
+
+    free(arrival);
+
+    return (0);
+
+}
+
+int main(int argc, char *argv[]) {
+
+    long num_nodes = 20000;
+
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [<num_nodes>]\n", PNAME);
+        return (-1);
+    }
+    if (argc > 1)
+        num_nodes = atol(argv[1]);
+
+    GeometryMode = MODE_RECT;
+    LocMethod = METH_EDT;
+    iUseGauss2 = 0;
+    FixOriginTimeFlag = 0;
+
+    if (run_case("edt_ot_wt", 1, 20, num_nodes) < 0 || run_case("edt_ot_wt", 1, 100, num_nodes / 10) < 0)
+        return (-1);
+    if (run_case("edt_ot_wt_ml", 2, 20, num_nodes) < 0 || run_case("edt_ot_wt_ml", 2, 100, num_nodes / 10) < 0
+            || run_case("edt_ot_wt_ml", 2, 400, num_nodes / 100) < 0)
+        return (-1);
+
+    return (0);
+
+}
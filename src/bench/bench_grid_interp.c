@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2026 Anthony Lomax <anthony@alomax.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+/*   bench_grid_interp.c
+
+        Benchmark of in-memory 3D grid interpolation (ReadAbsInterpGrid3d) for a regular
+        grid and for a cascading grid (ReadGrid3dValue_Cascading_Interp), as used for
+        travel times at each search node by NLLoc.
+
+        Grids are filled with synthetic travel times from a point source and interpolated at
+        pseudo-random points, one result line per case is written to stdout (see bench_util.h).
+
+ */
+
+
+/*
+        history:
+
+        ver 01    20261018  AJL  Original version
+
+
+.........1.........2.........3.........4.........5.........6.........7.........8
+
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "GridLib.h"
+#include "bench_util.h"
+
+
+#define PNAME  "bench_grid_interp"
+
+#define NUM_CASC_DEPTHS 3
+static double casc_depths[NUM_CASC_DEPTHS] = {10.0, 30.0, 60.0};
+
+/** initialize grid description and memory, fill with travel times from a point source */
+
+static int init_grid(GridDesc *pgrid, int nx, int ny, int nz, int cascading) {
+
+    int ix, iy, iz;
+    long n;
+    double x, y, z;
+    GRID_FLOAT_TYPE ***array;
+
+    memset(pgrid, 0, sizeof (GridDesc));
+    pgrid->numx = nx;
+    pgrid->numy = ny;
+    pgrid->numz = nz;
+    pgrid->origx = pgrid->origy = 0.0;
+    pgrid->origz = -2.0;
+    pgrid->dx = pgrid->dy = pgrid->dz = 1.0;
+    pgrid->type = GRID_TIME;
+    strcpy(pgrid->chr_type, "TIME");
+    strcpy(pgrid->title, PNAME);
+    pgrid->flagGridCascading = IS_NOT_CASCADING;
+    if (cascading) {
+        setCascadingGrid(pgrid);
+        pgrid->gridDesc_Cascading.num_z_merge_depths = NUM_CASC_DEPTHS;
+        for (n = 0; n < NUM_CASC_DEPTHS; n++)
+            pgrid->gridDesc_Cascading.z_merge_depths[n] = casc_depths[n];
+    }
+
+    if (AllocateGrid(pgrid) == NULL)
+        return (-1);
+    if ((pgrid->array = CreateGridArray(pgrid)) == NULL)
+        return (-1);
+    array = (GRID_FLOAT_TYPE ***) pgrid->array;
+
+    if (!cascading) {
+        for (ix = 0; ix < nx; ix++) {
+            x = pgrid->origx + pgrid->dx * (double) ix - 0.41 * (double) nx;
+            for (iy = 0; iy < ny; iy++) {
+                y = pgrid->origy + pgrid->dy * (double) iy - 0.57 * (double) ny;
+                for (iz = 0; iz < nz; iz++) {
+                    z = pgrid->origz + pgrid->dz * (double) iz;
+                    array[ix][iy][iz] = (GRID_FLOAT_TYPE) (sqrt(x * x + y * y + z * z) / 6.0);
+                }
+            }
+        }
+    } else {
+        // cascading grid array is not regular in x and y, fill buffer directly with positive values
+        GRID_FLOAT_TYPE *pbuf = (GRID_FLOAT_TYPE *) pgrid->buffer;
+        long nbuf = pgrid->buffer_size / sizeof (GRID_FLOAT_TYPE);
+        for (n = 0; n < nbuf; n++)
+            pbuf[n] = (GRID_FLOAT_TYPE) (1.0 + 1.0e-4 * (double) (n % 100003));
+    }
+
+    return (0);
+}
+
+/** interpolate grid at num_points pseudo-random points, write result line */
+
+static void run_case(char *case_name, GridDesc *pgrid, long num_points) {
+
+    long n;
+    unsigned int seed = 12345;
+    double x, y, z, xrange, yrange, zrange, value, checksum, t_start, t_elapsed;
+
+    xrange = pgrid->dx * (double) (pgrid->numx - 1);
+    yrange = pgrid->dy * (double) (pgrid->numy - 1);
+    zrange = pgrid->dz * (double) (pgrid->numz - 1);
+
+    checksum = 0.0;
+    t_start = bench_wall_time();
+    for (n = 0; n < num_points; n++) {
+        seed = seed * 1103515245u + 12345u;
+        x = pgrid->origx + xrange * (double) (seed >> 8) / 16777216.0;
+        seed = seed * 1103515245u + 12345u;
+        y = pgrid->origy + yrange * (double) (seed >> 8) / 16777216.0;
+        seed = seed * 1103515245u + 12345u;
+        z = pgrid->origz + zrange * (double) (seed >> 8) / 16777216.0;
+        value = ReadAbsInterpGrid3d(NULL, pgrid, x, y, z, 0);
+        if (value > 0.0)
+            checksum += value;
+    }
+    t_elapsed = bench_wall_time() - t_start;
+
+    fprintf(stdout, "%s case=%s nx=%d ny=%d nz=%d points=%ld seconds=%.4f ns_per_op=%.2f peak_rss_kb=%ld checksum=%.9e\n",
+            PNAME, case_name, pgrid->numx, pgrid->numy, pgrid->numz, num_points,
+            t_elapsed, 1.0e9 * t_elapsed / (double) num_points, bench_peak_rss_kb(RUSAGE_SELF), checksum);
+
+}
+
+int main(int argc, char *argv[]) {
+
+    int nx = 201, ny = 201, nz = 101;
+    long num_points = 5000000;
+    GridDesc grid;
+
+    if (argc > 1 && argc != 2 && argc != 5) {
+        fprintf(stderr, "Usage: %s [<num_points> [<nx> <ny> <nz>]]\n", PNAME);
+        return (-1);
+    }
+    if (argc > 1)
+        num_points = atol(argv[1]);
+    if (argc == 5) {
+        nx = atoi(argv[2]);
+        ny = atoi(argv[3]);
+        nz = atoi(argv[4]);
+    }
+
+    if (init_grid(&grid, nx, ny, nz, 0) < 0) {
+        fprintf(stderr, "%s: ERROR: allocating regular grid.\n", PNAME);
+        return (-1);
+    }
+    run_case("regular", &grid, num_points);
+    DestroyGridArray(&grid);
+    FreeGrid(&grid);
+
+    if (init_grid(&grid, nx, ny, nz, 1) < 0) {
+        fprintf(stderr, "%s: ERROR: allocating cascading grid.\n", PNAME);
+        return (-1);
+    }
+    run_case("cascading", &grid, num_points);
+    DestroyGridArray(&grid);
+    FreeGrid(&grid);
+
+    return (0);
+
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2026 Anthony Lomax <anthony@alomax.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+/*   bench_octtree.c
+
+        Benchmark of the oct-tree importance sampling bookkeeping used by NLLoc LOCSEARCH OCT:
+        result tree insertion (addResult), search for the highest value leaf (getHighestLeafValue)
+        and node subdivision.
+
+        The location probability is replaced by an analytic Gaussian log-pdf so that only the
+        oct-tree and result tree costs are measured, one result line is written to stdout
+        (see bench_util.h).
+
+ */
+
+
+/*
+        history:
+
+        ver 01    20261018  AJL  Original version
+
+
+.........1.........2.........3.........4.........5.........6.........7.........8
+
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "GridLib.h"
+#include "bench_util.h"
+
+
+#define PNAME  "bench_octtree"
+
+/** analytic log-pdf at node center */
+
+static double log_pdf(OctNode *pnode) {
+
+    double dx = pnode->center.x - 13.3;
+    double dy = pnode->center.y - 27.1;
+    double dz = pnode->center.z - 11.7;
+
+    return (-0.5 * (dx * dx + dy * dy + dz * dz) / (2.0 * 2.0));
+}
+
+/** evaluate node and add to result tree */
+
+static ResultTreeNode* add_node(ResultTreeNode *proot, OctNode *pnode) {
+
+    double volume = pnode->ds.x * pnode->ds.y * pnode->ds.z;
+
+    pnode->value = log_pdf(pnode);
+
+    return (addResult(proot, pnode->value + log(volume), volume, pnode));
+}
+
+int main(int argc, char *argv[]) {
+
+    int ix, iy, iz, nx = 20, ny = 20, nz = 10;
+    long nsamples = 0, max_samples = 200000;
+    double checksum, t_start, t_elapsed;
+    Tree3D *tree;
+    ResultTreeNode *proot = NULL, *presult;
+    OctNode *pnode;
+
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [<max_num_nodes>]\n", PNAME);
+        return (-1);
+    }
+    if (argc > 1)
+        max_samples = atol(argv[1]);
+
+    t_start = bench_wall_time();
+
+    tree = newTree3D(0, nx, ny, nz, 0.0, 0.0, 0.0, 5.0, 5.0, 5.0, -VERY_LARGE_DOUBLE, 0.0, NULL);
+    if (tree == NULL) {
+        fprintf(stderr, "%s: ERROR: creating oct-tree.\n", PNAME);
+        return (-1);
+    }
+    for (ix = 0; ix < nx; ix++) {
+        for (iy = 0; iy < ny; iy++) {
+            for (iz = 0; iz < nz; iz++) {
+                proot = add_node(proot, tree->nodeArray[ix][iy][iz]);
+                nsamples++;
+            }
+        }
+    }
+
+    checksum = 0.0;
+    while (nsamples < max_samples) {
+        presult = getHighestLeafValue(proot);
+        if (presult == NULL)
+            break;
+        checksum += presult->value;
+        pnode = presult->pnode;
+        subdivide(pnode, -VERY_LARGE_DOUBLE, NULL);
+        for (ix = 0; ix < 2; ix++) {
+            for (iy = 0; iy < 2; iy++) {
+                for (iz = 0; iz < 2; iz++) {
+                    proot = add_node(proot, pnode->child[ix][iy][iz]);
+                    nsamples++;
+                }
+            }
+        }
+    }
+
+    t_elapsed = bench_wall_time() - t_start;
+
+    fprintf(stdout, "%s case=gaussian nodes=%ld seconds=%.4f ns_per_op=%.2f peak_rss_kb=%ld checksum=%.9e\n",
+            PNAME, nsamples, t_elapsed, 1.0e9 * t_elapsed / (double) nsamples, bench_peak_rss_kb(RUSAGE_SELF), checksum);
+
+    freeResultTree(proot);
+    freeTree3D(tree, 0);
+
+    return (0);
+
+}
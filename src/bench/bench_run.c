@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 Anthony Lomax <anthony@alomax.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+/*   bench_run.c
+
+        Runs a command (e.g. an NLLoc program on a benchmark scenario) and writes the wall clock
+        time, events per second and peak memory of the command as a single line to stdout
+        (see bench_util.h), used by run_bench.bash for end-to-end benchmarks.
+
+        stdout and stderr of the command are written to a log file.
+        The exit status of bench_run is the exit status of the command.
+
+ */
+
+
+/*
+        history:
+
+        ver 01    20261018  AJL  Original version
+
+
+.........1.........2.........3.........4.........5.........6.........7.........8
+
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "bench_util.h"
+
+
+#define PNAME  "bench_run"
+
+int main(int argc, char *argv[]) {
+
+    int status, exit_status;
+    long num_events;
+    pid_t pid;
+    double t_start, t_elapsed;
+
+    if (argc < 5) {
+        fprintf(stderr, "Usage: %s <case name> <num events> <log file> <command> [<args>...]\n", PNAME);
+        return (-1);
+    }
+    num_events = atol(argv[2]);
+
+    t_start = bench_wall_time();
+    pid = fork();
+    if (pid < 0) {
+        perror(PNAME ": fork");
+        return (-1);
+    }
+    if (pid == 0) {
+        if (freopen(argv[3], "w", stdout) == NULL || dup2(fileno(stdout), fileno(stderr)) < 0) {
+            perror(PNAME ": opening log file");
+            _exit(127);
+        }
+        execvp(argv[4], argv + 4);
+        perror(PNAME ": exec");
+        _exit(127);
+    }
+    if (waitpid(pid, &status, 0) < 0) {
+        perror(PNAME ": waitpid");
+        return (-1);
+    }
+    t_elapsed = bench_wall_time() - t_start;
+    exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+
+    fprintf(stdout, "%s case=%s events=%ld seconds=%.4f events_per_sec=%.4f peak_rss_kb=%ld status=%d\n",
+            PNAME, argv[1], num_events, t_elapsed, t_elapsed > 0.0 ? (double) num_events / t_elapsed : 0.0,
+            bench_peak_rss_kb(RUSAGE_CHILDREN), exit_status);
+
+    return (exit_status);
+
+}
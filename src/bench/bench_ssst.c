@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 Anthony Lomax <anthony@alomax.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+/*   bench_ssst.c
+
+        Benchmark of the SSST correction (get_ssst_value) evaluated by Loc2ssst at each
+        node of a station/phase correction grid.
+
+        Loc2ssst.c is compiled into this benchmark without its main(). Synthetic event locations
+        and residuals are generated for one station/phase and the correction is evaluated at
+        pseudo-random nodes, one result line per case is written to stdout (see bench_util.h).
+
+ */
+
+
+/*
+        history:
+
+        ver 01    20261019  AJL  Original version
+
+
+.........1.........2.........3.........4.........5.........6.........7.........8
+
+ */
+
+
+
+#define LOC2SSST_NO_MAIN
+#include "../Loc2ssst.c"
+
+#include "bench_util.h"
+
+
+#undef PNAME
+#define PNAME  "bench_ssst"
+
+/** next pseudo-random value in [0,1) */
+
+static double next_random(unsigned int *pseed) {
+
+    *pseed = *pseed * 1103515245u + 12345u;
+    return ((double) (*pseed >> 8) / 16777216.0);
+}
+
+/** evaluate SSST correction at num_nodes nodes for num_obs event observations, write result line
+ *
+ *  events and nodes are in a 100 x 100 x 30 km volume, or in a 1 x 1 deg x 30 km volume for global mode
+ */
+
+static int run_case(char *case_name, int geometry_mode, int num_obs, long num_nodes) {
+
+    int nobs;
+    long n;
+    unsigned int seed = 12345;
+    double xscale, yscale, xorig, yorig, x, y, z, checksum, t_start, t_elapsed;
+    SSSTObs *obs_array;
+    LS_Params params;
+
+    if ((obs_array = (SSSTObs *) calloc(num_obs, sizeof (SSSTObs))) == NULL) {
+        fprintf(stderr, "%s: ERROR: allocating observations.\n", PNAME);
+        return (-1);
+    }
+
+    GeometryMode = geometry_mode;
+    if (geometry_mode == MODE_GLOBAL) {
+        xorig = -150.0;
+        yorig = 61.0;
+        xscale = yscale = 1.0;
+    } else {
+        xorig = yorig = 0.0;
+        xscale = yscale = 100.0;
+    }
+
+    for (nobs = 0; nobs < num_obs; nobs++) {
+        obs_array[nobs].x = xorig + xscale * next_random(&seed);
+        obs_array[nobs].y = yorig + yscale * next_random(&seed);
+        obs_array[nobs].z = 30.0 * next_random(&seed);
+        obs_array[nobs].corr = next_random(&seed) - 0.5;
+    }
+
+    memset(&params, 0, sizeof (LS_Params));
+    params.char_dist = 10.0;
+    params.weight_floor = 0.001;
+
+    checksum = 0.0;
+    t_start = bench_wall_time();
+    for (n = 0; n < num_nodes; n++) {
+        x = xorig + xscale * next_random(&seed);
+        y = yorig + yscale * next_random(&seed);
+        z = 30.0 * next_random(&seed);
+        checksum += get_ssst_value(x, y, z, obs_array, num_obs, &params);
+    }
+    t_elapsed = bench_wall_time() - t_start;
+
+    fprintf(stdout, "%s case=%s observations=%d nodes=%ld seconds=%.4f ns_per_op=%.2f peak_rss_kb=%ld checksum=%.9e\n",
+            PNAME, case_name, num_obs, num_nodes, t_elapsed, 1.0e9 * t_elapsed / (double) num_nodes, bench_peak_rss_kb(RUSAGE_SELF), checksum);
+
+    free(obs_array);
+
+    return (0);
+
+}
+
+int main(int argc, char *argv[]) {
+
+    long num_nodes = 100000;
+
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [<num_nodes>]\n", PNAME);
+        return (-1);
+    }
+    if (argc > 1)
+        num_nodes = atol(argv[1]);
+
+    if (run_case("rect", MODE_RECT, 100, num_nodes) < 0 || run_case("rect", MODE_RECT, 1000, num_nodes / 10) < 0
+            || run_case("rect", MODE_RECT, 10000, num_nodes / 100) < 0)
+        return (-1);
+    if (run_case("global", MODE_GLOBAL, 1000, num_nodes / 100) < 0)
+        return (-1);
+
+    return (0);
+
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026 Anthony Lomax <anthony@alomax.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+/*   bench_time_3d.c
+
+        Benchmark of the Podvin-Lecomte finite-difference solver (Time_3d_NLL_multiSource.c)
+        used by Grid2Time.
+
+        A model with a linear velocity gradient in z is timed from a point source and the
+        wall clock time, cost per node, peak memory and a checksum of the time field are written as a
+        single line to stdout (see bench_util.h), solver messages are written to stderr.
+        Compare the checksum between runs (e.g. OMP_NUM_THREADS=1 and OMP_NUM_THREADS=8)
+        to verify that multithreading does not change the solution.
+
+ */
+
+
+/*
+        history:
+
+        ver 01    20261018  AJL  Original version
+        ver 02    20261018  AJL  Use bench_util.h, added peak_rss_kb
+        ver 03    20261019  AJL  Solver messages to stderr, result line on stdout only
+
+
+.........1.........2.........3.........4.........5.........6.........7.........8
+
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_util.h"
+
+#ifdef GRID_FLOAT_TYPE_DOUBLE
+#define GRID_FLOAT_TYPE double
+#else
+#define GRID_FLOAT_TYPE float
+#endif
+
+int time_3d_ms(GRID_FLOAT_TYPE *HS, GRID_FLOAT_TYPE *T, int NX, int NY, int NZ,
+        GRID_FLOAT_TYPE *XS, GRID_FLOAT_TYPE *YS, GRID_FLOAT_TYPE *ZS, int NUM_SOURCE,
+        GRID_FLOAT_TYPE HS_EPS_INIT, int MSG);
+
+
+#define PNAME  "bench_time_3d"
+
+int main(int argc, char *argv[]) {
+
+    int nx = 201, ny = 201, nz = 101;
+    int ix, iy, iz, istat, nthreads;
+    long n, nnodes;
+    double hs0 = 0.2; // slowness * node spacing at z = 0
+    double checksum, t_start, t_elapsed;
+    GRID_FLOAT_TYPE *hs_buf, *t_buf;
+    GRID_FLOAT_TYPE xs, ys, zs;
+    FILE *fp_results;
+
+    if (argc > 1 && argc != 4) {
+        fprintf(stderr, "Usage: %s [<nx> <ny> <nz>]\n", PNAME);
+        return (-1);
+    }
+    if (argc == 4) {
+        nx = atoi(argv[1]);
+        ny = atoi(argv[2]);
+        nz = atoi(argv[3]);
+    }
+    nnodes = (long) nx * (long) ny * (long) nz;
+
+    // time_3d_ms() writes DEBUG lines to stdout
+    fp_results = bench_results_stream();
+
+    hs_buf = (GRID_FLOAT_TYPE *) malloc(nnodes * sizeof (GRID_FLOAT_TYPE));
+    t_buf = (GRID_FLOAT_TYPE *) malloc(nnodes * sizeof (GRID_FLOAT_TYPE));
+    if (hs_buf == NULL || t_buf == NULL) {
+        fprintf(stderr, "%s: ERROR: allocating grids of %ld nodes.\n", PNAME, nnodes);
+        return (-1);
+    }
+    // velocity increases linearly with depth, so that the exact homogeneous initialization
+    //    is limited to the source neighborhood and the FD sweeps dominate
+    n = 0;
+    for (ix = 0; ix < nx; ix++)
+        for (iy = 0; iy < ny; iy++)
+            for (iz = 0; iz < nz; iz++)
+                hs_buf[n++] = (GRID_FLOAT_TYPE) (hs0 / (1.0 + 0.02 * (double) iz));
+
+    // off-node source, away from grid center so that all sides are scanned asymmetrically
+    xs = 0.37 * (GRID_FLOAT_TYPE) (nx - 1);
+    ys = 0.61 * (GRID_FLOAT_TYPE) (ny - 1);
+    zs = 0.23 * (GRID_FLOAT_TYPE) (nz - 1);
+
+    nthreads = bench_num_threads();
+
+    t_start = bench_wall_time();
+    istat = time_3d_ms(hs_buf, t_buf, nx, ny, nz, &xs, &ys, &zs, 1, 1.0e-3, 0);
+    t_elapsed = bench_wall_time() - t_start;
+    if (istat != 0) {
+        fprintf(stderr, "%s: ERROR: time_3d_ms returned %d\n", PNAME, istat);
+        return (-1);
+    }
+
+    checksum = 0.0;
+    for (n = 0; n < nnodes; n++)
+        checksum += t_buf[n];
+
+    fprintf(fp_results, "%s case=point_source nx=%d ny=%d nz=%d threads=%d seconds=%.4f ns_per_node=%.2f peak_rss_kb=%ld checksum=%.9e\n",
+            PNAME, nx, ny, nz, nthreads, t_elapsed, 1.0e9 * t_elapsed / (double) nnodes, bench_peak_rss_kb(RUSAGE_SELF), checksum);
+
+    fclose(fp_results);
+    free(hs_buf);
+    free(t_buf);
+
+    return (0);
+
+}
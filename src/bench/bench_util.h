@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 Anthony Lomax <anthony@alomax.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+/*   bench_util.h
+
+        Timing and memory helpers shared by the benchmarks in bench/.
+
+        Each benchmark writes one line per case to stdout:
+            <bench name> case=<case name> <key>=<value> ...
+        with at least seconds=, ns_per_op= (or ns_per_node=), peak_rss_kb= and checksum=,
+        so that results can be collected with grep/awk and compared between builds.
+        Benchmarks of code that writes messages to stdout write results to bench_results_stream().
+
+ */
+
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/** wall clock time in seconds */
+
+static inline double bench_wall_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double) ts.tv_sec + 1.0e-9 * (double) ts.tv_nsec);
+}
+
+/** peak resident set size in kB of this process (who = RUSAGE_SELF) or of terminated children (who = RUSAGE_CHILDREN) */
+
+static inline long bench_peak_rss_kb(int who) {
+    struct rusage usage;
+    if (getrusage(who, &usage) != 0)
+        return (-1);
+    return (usage.ru_maxrss); // kB on Linux
+}
+
+/** number of OpenMP threads, 1 if not compiled with OpenMP */
+
+static inline int bench_num_threads() {
+#ifdef _OPENMP
+    return (omp_get_max_threads());
+#else
+    return (1);
+#endif
+}
+
+/** stream for result lines on original stdout, stdout of this process is redirected to stderr
+ *  so that messages written to stdout by benchmarked code are not mixed with results;
+ *  call before anything is written to stdout */
+
+static inline FILE *bench_results_stream() {
+    int fd;
+    FILE *fp;
+    fflush(stdout);
+    if ((fd = dup(STDOUT_FILENO)) < 0)
+        return (stdout);
+    if ((fp = fdopen(fd, "w")) == NULL) {
+        close(fd);
+        return (stdout);
+    }
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    return (fp);
+}
+
+#endif // BENCH_UTIL_H
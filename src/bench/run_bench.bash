@@ -0,0 +1,115 @@
+#!/bin/bash
+
+# End-to-end benchmark scenarios for NonLinLoc programs.
+#
+# Usage: run_bench.bash <bin dir> <nlloc_sample dir> <work dir> [<num events> [<global sample dir>]]
+#
+# Synthetic events are generated with Time2EQ from the nlloc_sample (Alaska) model and stations,
+# then located with NLLoc (2D and 3D time grids, oct-tree and Metropolis search) and relocated
+# with Loc2ddct + NLDiffLoc.
+# NLDiffLoc allocates X_MAX_NUM_STATIONS_DIFF * MAX_NUM_ARRIVALS_STA arrivals at start-up (many GB),
+# the nldiffloc scenario fails with status 255 on hosts without sufficient memory.
+# The global scenario locates the nlloc_global_sample NEIC events and is run only if the TauP
+# DEFAULT time grids (taup/ak135/ak135.P.DEFAULT.time.*) have been created in <global sample dir>.
+#
+# One line per scenario is written to stdout by bench_run:
+#    bench_run case=<scenario> events=<n> seconds=<s> events_per_sec=<r> peak_rss_kb=<kB> status=<exit status>
+# Program output for each scenario is written to <work dir>/<scenario>.log
+#
+# 20261018 AJL - Original version
+
+if [ $# -lt 3 ]; then
+	echo "Usage: $0 <bin dir> <nlloc_sample dir> <work dir> [<num events> [<global sample dir>]]"
+	exit 1
+fi
+
+BIN_DIR=$(cd $1 && pwd)
+SAMPLE_DIR=$(cd $2 && pwd)
+WORK_DIR=$3
+NUM_EVENTS=${4:-50}
+GLOBAL_SAMPLE_DIR=$5
+
+BENCH_RUN=${BIN_DIR}/bench_run
+export PATH=${BIN_DIR}:${PATH}
+
+mkdir -p ${WORK_DIR}
+WORK_DIR=$(cd ${WORK_DIR} && pwd)
+cd ${WORK_DIR}
+rm -rf local global
+mkdir -p local/model local/time local/time3d local/obs_synth local/loc local/loc_met local/loc3d local/loc_dd
+cp -p ${SAMPLE_DIR}/run/nlloc_sample.in local/
+cp -pr ${SAMPLE_DIR}/obs local/
+cd local
+
+# control files
+#   synthetic events at pseudo-random locations within the station network, replace sample source
+grep -v "^EQSRCE" nlloc_sample.in > bench.in
+awk -v n=${NUM_EVENTS} 'BEGIN {
+	seed = 12345;
+	for (i = 1; i <= n; i++) {
+		seed = (seed * 1103515245 + 12345) % 2147483648; lat = 60.7 + 1.2 * seed / 2147483648;
+		seed = (seed * 1103515245 + 12345) % 2147483648; lon = -151.0 + 2.0 * seed / 2147483648;
+		seed = (seed * 1103515245 + 12345) % 2147483648; dep = 2.0 + 58.0 * seed / 2147483648;
+		printf("EQSRCE  Bench%04d  LATLON  %.5f %.5f %.3f 0.0\n", i, lat, lon, dep);
+	}
+}' >> bench.in
+sed -e "s#^LOCFILES.*#LOCFILES ./obs_synth/synth.obs NLLOC_OBS ./time/layer ./loc/bench#" bench.in > bench_oct.in
+sed -e "s#^LOCFILES.*#LOCFILES ./obs_synth/synth.obs NLLOC_OBS ./time/layer ./loc_met/bench#" \
+	-e "s#^LOCSEARCH.*#LOCSEARCH MET 10000 1000 4000 5000 5 -1 0.01 8.0 1.0e-10#" bench.in > bench_met.in
+#   3D model and time grids, 2 km node spacing, enclosing the location search grid
+sed -e "s#^VGOUT.*#VGOUT ./model/layer3d#" \
+	-e "s#^VGGRID.*#VGGRID  111 111 56  -110.0 -110.0 -6.0  2.0 2.0 2.0  SLOW_LEN#" \
+	-e "s#^GTFILES.*#GTFILES  ./model/layer3d  ./time3d/layer P#" \
+	-e "s#^GTMODE.*#GTMODE GRID3D ANGLES_NO#" \
+	-e "s#^LOCFILES.*#LOCFILES ./obs_synth/synth.obs NLLOC_OBS ./time3d/layer ./loc3d/bench#" bench.in > bench_3d.in
+#   NLDiffLoc
+cat > bench_dd.in << END
+CONTROL 1 54321
+$(grep "^TRANS" bench.in)
+DLOC_HYPFILE ./loc/bench.sum.grid0.loc.hyp NLLOC_SUM -1 -1
+DLOC_SEARCH MET 20000 10000 20 0.005 6.0 5.0 10.0
+LOCFILES ./loc_dd/bench.ct HYPODD_CT ./time/layer ./loc_dd/bench
+LOCQUAL2ERR 0.02 0.05
+LOCMETH GAU_ANALYTIC 9999.0 6 -1 -1 1.68 -1 -1.0
+$(grep "^LOCGRID" bench.in)
+LOCHYPOUT SAVE_NLLOC_ALL
+LOCGAU 0.1 0.0
+$(grep "^LOCPHASEID" bench.in)
+LOCPHSTAT 9999.0 -1 9999.0 1.5 2.5
+LOCANGLES ANGLES_NO 0
+END
+
+# 1D model, 2D time grids, synthetic arrivals
+${BENCH_RUN} vel2grid 0 ../vel2grid.log Vel2Grid bench.in
+${BENCH_RUN} grid2time_2d 0 ../grid2time_2d.log Grid2Time bench.in
+${BENCH_RUN} time2eq ${NUM_EVENTS} ../time2eq.log Time2EQ bench.in
+
+# local, 2D time grids, oct-tree and Metropolis search
+${BENCH_RUN} local_2d_octree ${NUM_EVENTS} ../local_2d_octree.log NLLoc bench_oct.in
+${BENCH_RUN} local_2d_metropolis ${NUM_EVENTS} ../local_2d_metropolis.log NLLoc bench_met.in
+
+# local, 3D time grids, oct-tree search
+${BENCH_RUN} vel2grid_3d 0 ../vel2grid_3d.log Vel2Grid bench_3d.in
+${BENCH_RUN} grid2time_3d 0 ../grid2time_3d.log Grid2Time bench_3d.in
+${BENCH_RUN} local_3d_octree ${NUM_EVENTS} ../local_3d_octree.log NLLoc bench_3d.in
+
+# differential location of oct-tree locations
+${BENCH_RUN} loc2ddct ${NUM_EVENTS} ../loc2ddct.log Loc2ddct "loc/bench.*.*.grid0.loc" loc_dd/bench 50.0 0.0
+${BENCH_RUN} nldiffloc ${NUM_EVENTS} ../nldiffloc.log NLDiffLoc bench_dd.in
+
+cd ..
+
+# global, TauP 2D time grids
+if [ -n "${GLOBAL_SAMPLE_DIR}" ] && [ -f ${GLOBAL_SAMPLE_DIR}/taup/ak135/ak135.P.DEFAULT.time.buf ]; then
+	GLOBAL_SAMPLE_DIR=$(cd ${GLOBAL_SAMPLE_DIR} && pwd)
+	mkdir -p global/loc
+	cd global
+	ln -s ${GLOBAL_SAMPLE_DIR}/obs obs
+	ln -s ${GLOBAL_SAMPLE_DIR}/run run
+	ln -s ${GLOBAL_SAMPLE_DIR}/taup taup
+	NUM_GLOBAL_EVENTS=$(ls obs/*.neic | wc -l)
+	${BENCH_RUN} global_2d_octree ${NUM_GLOBAL_EVENTS} ../global_2d_octree.log NLLoc run/neic_global.in
+	cd ..
+else
+	echo "bench_run case=global_2d_octree events=0 seconds=0 events_per_sec=0 peak_rss_kb=0 status=skipped"
+fi
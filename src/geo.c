@@ -26,6 +26,16 @@ double GCDistance(double lat1, double lon1, double lat2, double lon2) {
     return (AVG_ERAD * acos(d));
 }
 
+// 20261018 AJL - added, same as GCDistance() for points that do not coincide, using precomputed sin and cos of latitudes
+//    and longitudes in radians, allows trig of fixed points (e.g. stations) to be evaluated once
+
+double GCDistanceSinCos(double sin_lat1, double cos_lat1, double lon1_rad, double sin_lat2, double cos_lat2, double lon2_rad) {
+    double d;
+
+    d = sin_lat1 * sin_lat2 + cos_lat1 * cos_lat2 * cos(lon1_rad - lon2_rad);
+    return (AVG_ERAD * acos(d));
+}
+
 double GCAzimuth(double lat1, double lon1, double lat2, double lon2) {
 
     double lonA = lon1 * DE2RA;
@@ -219,6 +219,9 @@ extern int nll_mode;
 /* SH found comment line in UUSS format; starts with 'c' */
 #define OBS_IS_COMMENT_LINE                     -55222
 
+// 20261018 AJL - added: stdio buffer size for observation files
+#define OBS_FILE_BUFFER_SIZE (1024 * 1024)
+
 #define SMALLEST_EVENT_YEAR 1800
 #define LARGEST_EVENT_YEAR 2100
 
@@ -248,12 +251,26 @@ extern int nll_mode;
 #define IS_CASCADING -243310898   // want value that is extremely unlikely to be in uninitialized int
 #define MAX_NUM_Z_MERGE_DEPTHS 100 // set very large, should typically be +-3
 
+// 20261018 AJL - added, interpolation parameters for each regular grid z index, set once when cascading grid indices are allocated
+
+typedef struct {
+    int xyz_scale; // scale value at this z index (same as GridDesc_Cascading.xyz_scale)
+    int xy_scale_use; // x,y interpolation cell size in regular grid index units, doubled if scale changes in next cascading grid level
+    int irescale; // 1 if scale changes in next cascading grid level
+    int iz0_casc, iz1_casc; // upper and lower cascading grid z index of interpolation cell
+    int iz_top; // first regular grid z index in cascading grid z level
+    int ixmax_up, iymax_up, ixmax_dn, iymax_dn; // maximum cascading grid x,y index in upper and lower level, used if irescale
+    int lastx, lasty; // regular grid index of end of last full cascading grid cell of size xy_scale_use
+}
+CascadingZLevel;
+
 typedef struct {
     int num_z_merge_depths; // array of (approx) increasing depths in km at which cells will be oct-merged by factor 2 (8 cells become 1 cell, cell side doubled)
     double z_merge_depths[MAX_NUM_Z_MERGE_DEPTHS]; // array of (approx) increasing depths in km at which cells will be oct-merged by factor 2 (8 cells become 1 cell)
     int *zindex; // array (size=numz) of cascading grid z index values for given regular grid z index (0, GridDesc.numz-1))
     int *xyz_scale; // array (size=numz) of scale values to convert given regular grid x,y index (e.g. 0, GridDesc.numx-1) to cascading grid x,y index;
     // cascading grid x,y index = regular grid x,y index / (double) xyz_scale
+    CascadingZLevel *zlevel; // array (size=numz) of interpolation parameters for given regular grid z index
     //double num_z_cascading; // number of cascading grid z levels
 }
 GridDesc_Cascading;
@@ -440,6 +457,9 @@ typedef struct {
 						= nphase or -1 for none */
     double tfact; /* factor to multiply by time grid values
 						= 1.0 or 1/VpVs */
+    int n_recip; /* reciprocity (LOCRECIP) source-side grid set for times
+						= index in RecipPhase or -1 for none */
+    int n_recip_sta; /* station index in RecipPhase[n_recip] station cache */
     char fileroot[FILENAME_MAX]; /* root name for grid file */
     FILE* fpgrid; /* 3D travel time grid file */
     FILE* fphdr; /* 3D grid file header */
@@ -462,6 +482,14 @@ typedef struct {
     int dd_event_index_1, dd_event_index_2; /* HypoDesc index of event 1, event 2 */
     double dd_dtime; /* Differential time (s) between event 1 and event 2 at station. DT = T1-T2. */
 
+    // 20261018 AJL - added, per event travel time geometry, set in setArrivalTravelTimeGeometry() before search
+    double sta_sin_lat, sta_cos_lat, sta_lon_rad; // sin and cos of station latitude, station longitude in radians (MODE_GLOBAL)
+    char crust_corr_phase; // 'P', 'S' or '\0' for crustal correction
+    double crust_corr_sta; // station (receiver) crustal correction
+    int n_dist_dup; // previous arrival with same 2D time grid and station location, = narr or -1 for none
+    double dist_grid; // epicentral distance in 2D time grid units at current search node
+    double tt_grid; // 2D time grid travel time at current search node
+
 }
 ArrivalDesc;
 
@@ -797,7 +825,7 @@ int ReadGrid3dHdr_grid_description(FILE *fpio, GridDesc* pgrid, char *fname);
 int ReadGrid3dBufSheet(GRID_FLOAT_TYPE *, GridDesc*, FILE*, int);
 GRID_FLOAT_TYPE ReadAbsGrid3dValue(FILE*, GridDesc*, double, double,
         double, int);
-int SwapBytes(float *buffer, long int bufsize);
+int swapBytes(GRID_FLOAT_TYPE *buffer, long bufsize);
 int OpenGrid3dFile(char *, FILE **, FILE **, GridDesc*,
         char*, SourceDesc*, int);
 // 20170207 AJL - GridDesc needed for cleaning up cascading grid header data
@@ -811,6 +839,9 @@ float InterpCubeAngles(DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE,
         DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE);
 GRID_FLOAT_TYPE ReadAbsInterpGrid3d(FILE *, GridDesc*, double, double,
         double, int clean_casc_allocs);
+void GetInterpGrid3dSheetIndex(GridDesc* pgrid, double xloc, int *pix0, int *pix1);
+GRID_FLOAT_TYPE ReadAbsInterpGrid3dSheets(GRID_FLOAT_TYPE *sheet0, GRID_FLOAT_TYPE *sheet1, GridDesc* pgrid,
+        double xloc, double yloc, double zloc);
 DOUBLE InterpSquareLagrange(DOUBLE, DOUBLE,
         DOUBLE, DOUBLE, DOUBLE, DOUBLE);
 DOUBLE ReadAbsInterpGrid2d(FILE *, GridDesc*,
@@ -862,6 +893,7 @@ int Err2Qual(ArrivalDesc *);
 int GetQuality2Err(char*);
 int IsPhaseID(char *phase_in, char *phase_check);
 int EvalPhaseID(char *, char *);
+void ClearPhaseIDCache(void);
 void removeSpace(char *str);
 
 /* strucutre utility functions */
@@ -889,6 +921,8 @@ char* CurrTimeStr(void);
 
 /* file list functions */
 int ExpandWildCards(char*, char[][FILENAME_MAX], int);
+int ExpandWildCardsList(char* fileFilter, char ***pfileList);
+void FreeWildCardsList(char **fileList, int nfiles);
 int fnmatch_wrapper(const struct dirent* entry);
 extern char ExpandWildCards_pattern[FILENAME_MAX];
 
@@ -917,7 +951,11 @@ void SetAnglesFloat(TakeOffAngles*, float);
 int GetTakeOffAngles(TakeOffAngles *, double *, double *, int *);
 int ReadTakeOffAnglesFile(char *, double, double, double,
         double *, double *, int *, double, int);
+int ReadTakeOffAnglesTimeGrid(char *, double, double, double,
+        double *, double *, int *, double, int);
+GRID_FLOAT_TYPE ReadAbsInterpGridAngles(FILE *fpgrid, GridDesc* ptgrid, double xloc, double yloc, double zloc);
 int CalcAnglesGradient(GridDesc* ptgrid, GridDesc* pagrid, int angle_mode, int grid_mode);
+int CalcAnglesGradientSheet(GridDesc* ptgrid, GRID_FLOAT_TYPE* sheet, int ix, int angle_mode, int grid_mode);
 TakeOffAngles GetGradientAngles(double vcent, double xlow, double xhigh,
         double ylow, double yhigh, double zlow, double zhigh,
         double dx, double dy, double dz, int iflag2D,
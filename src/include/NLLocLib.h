@@ -213,6 +213,19 @@ SearchPdfGridDesc;
 
 
 
+/* reciprocity: station travel times from source-side (event centroid) time grids (LOCRECIP) */
+// 20261018 AJL - added
+typedef struct {
+    char phase[PHASE_LABEL_LEN]; /* phase of centroid time grids */
+    int num_centroid; /* number of centroid grids, 0 if grids could not be opened for this phase */
+    GridDesc *gdesc; /* [num_centroid] centroid time grids, read into memory */
+    SourceDesc *centroid; /* [num_centroid] centroid locations (from time grid headers) */
+    char *sta_done; /* [NumSources] 1 if station terms calculated */
+    double *sta_time; /* [NumSources * num_centroid] travel time centroid -> station, < 0.0 if undefined */
+    double *sta_grad; /* [NumSources * num_centroid * 3] gradient at centroid of travel time to station */
+}
+RecipPhaseDesc;
+
 /*------------------------------------------------------------*/
 /* globals  */
 
@@ -316,6 +329,10 @@ extern FILE *pSumFileHypoInv[MAX_NUM_LOCATION_GRIDS];
 extern FILE *pSumFileHypoInvY2K[MAX_NUM_LOCATION_GRIDS];
 extern FILE *pSumFileAlberto4[MAX_NUM_LOCATION_GRIDS];
 extern FILE *pSumFileFmamp[MAX_NUM_LOCATION_GRIDS];
+extern FILE *pSumFileProf, *pSumFileProfJSON;
+extern FILE *pBatchFileHyp[MAX_NUM_LOCATION_GRIDS];
+extern FILE *pBatchFileScat[MAX_NUM_LOCATION_GRIDS];
+extern FILE *pBatchFileIndex[MAX_NUM_LOCATION_GRIDS];
 
 
 /* related flags */
@@ -336,6 +353,15 @@ extern int iSaveNLLocEvent, iSaveNLLocSum, iSaveNLLocOctree,
 extern int iSaveNLLocExpectation;
 // 20220131 AJL - added to support JSON output of location results
 extern int iSaveNLLocEvent_JSON;
+// 20261018 AJL - added to support per event profile output (compiled with NLL_PROFILE)
+extern int iSaveNLLocProf, iSaveNLLocProfJSON;
+// 20261018 AJL - added to support batched event output and optional last.* files
+extern int iSaveNLLocBatch;
+extern int iSaveNLLocScatCompressed;
+#define SAVE_LAST_COPY 0
+#define SAVE_LAST_SYMLINK 1
+#define SAVE_LAST_NONE 2
+extern int iSaveLast;
 
 
 // Arrival prior weighting flag (NLL_FORMAT_VER_2)
@@ -393,6 +419,15 @@ extern int NumLocInclude;
 extern TimeDelayDesc TimeDelay[MAX_NUM_STA_DELAYS];
 extern int NumTimeDelays;
 
+/* reciprocity, source-side (event centroid) time grids */
+#define MAX_NUM_RECIP_CENTROIDS 1000
+#define MAX_NUM_RECIP_PHASES 10
+extern char RecipGridRoot[FILENAME_MAX];
+extern char RecipCentroidLabel[MAX_NUM_RECIP_CENTROIDS][ARRIVAL_LABEL_LEN];
+extern int NumRecipCentroids;
+extern RecipPhaseDesc RecipPhase[MAX_NUM_RECIP_PHASES];
+extern int NumRecipPhases;
+
 extern char TimeDelaySurfacePhase[MAX_SURFACES][PHASE_LABEL_LEN];
 extern double TimeDelaySurfaceMultiplier[MAX_SURFACES];
 extern int NumTimeDelaySurface;
@@ -442,10 +477,11 @@ extern ResultTreeNode* resultTreeRoot; /* Octtree likelihood*volume results tree
 
 
 /* take-off angles */
-extern int angleMode; /* angle mode - ANGLE_MODE_NO, ANGLE_MODE_YES */
+extern int angleMode; /* angle mode - ANGLE_MODE_NO, ANGLE_MODE_YES, ANGLE_MODE_TIME */
 extern int iAngleQualityMin; /* minimum quality for angles to be used */
 #define ANGLE_MODE_NO 0
 #define ANGLE_MODE_YES 1
+#define ANGLE_MODE_TIME 3 // 20261018 AJL - added, take-off angles from gradient of time grid, angle grids not used
 #define ANGLE_MODE_UNDEF -1
 
 
@@ -528,6 +564,7 @@ int GetNLLoc_Gaussian(char*);
 int GetNLLoc_Gaussian2(char*);
 int GetNLLoc_PhaseStats(char*);
 int GetNLLoc_Angles(char*);
+int ReadTakeOffAngles(char *, double, double, double, double *, double *, int *, double, int);
 int GetNLLoc_Magnitude(char*);
 int GetNLLoc_Files(char*);
 int GetNLLoc_Method(char*);
@@ -551,6 +588,12 @@ int WriteHypoFmamp(FILE *fpio, HypoDesc* phypo, ArrivalDesc* parrivals, int narr
 int WriteHypoFmampSearchPosterior(SearchPdfGridDesc *searchPdfGrid, FILE *fpio, HypoDesc* phypo, char* filename, int write_header);
 int OpenSummaryFiles(char *, char *);
 int CloseSummaryFiles();
+void WriteProfile(char *fnout);
+void SaveLastFile(char *fname, char *lastname);
+char *WriteLocationToBuffer(HypoDesc* hypo, ArrivalDesc* parrivals, int narrivals, char *filename, int isave_phases,
+        int ngrid, size_t *psize);
+int SaveScatterBatch(int ngrid, HypoDesc* phypo, float *fdata);
+int SaveLocationBatch(HypoDesc* hypo, int ngrid, char *fname, char *fnout, int numArrivalsReject, int isave_phases);
 
 int GetCompDesc(char*);
 int GetLocAlias(char*);
@@ -629,7 +672,14 @@ double Calc_MD_FMAG(double coda_dur, double dist, double depth, double sta_corr,
 
 int setStationDistributionWeights(SourceDesc *stations, int numStations, ArrivalDesc *arrival, int nArrivals);
 
+void setArrivalTravelTimeGeometry(ArrivalDesc *arrival, int num_arr_loc);
 int getTravelTimes(ArrivalDesc *arrival, int num_arr_loc, double xval, double yval, double zval);
+int GetNLLoc_Recip(char* line1);
+int GetRecipPhase(char *phase);
+int CalcRecipStationTerms(GridDesc *pgrid, SourceDesc *centroid, SourceDesc *station, double *ptime, double *pgrad);
+int SetupRecipArrival(ArrivalDesc *arrival, char *arrival_phase);
+double RecipTravelTime(ArrivalDesc *arrival, double xval, double yval, double zval);
+void FreeRecipGrids();
 double applyCrustElevCorrection(ArrivalDesc* parrival, double xval, double yval, double zval);
 int isAboveTopo(double xval, double yval, double zval);
 
@@ -35,6 +35,8 @@
 
 double GCDistance(double lat1, double lon1, double lat2, double lon2);
 
+double GCDistanceSinCos(double sin_lat1, double cos_lat1, double lon1_rad, double sin_lat2, double cos_lat2, double lon2_rad);
+
 double ApproxDistance(double lat1, double lon1, double lat2, double lon2);
 
 double EllipsoidDistance(double lat1, double lon1, double lat2, double lon2);
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 1999-2026 Anthony Lomax <anthony@alomax.net, http://www.alomax.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+
+ * You should have received a copy of the GNU Lesser Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+/* nll_gridcache.h
+
+   Process-wide cache of grid file handles for reading single values from grid files on disk.
+
+   A cached handle holds the grid description and source read from the .hdr file, and the open .buf file.
+   Headers are read once, grid files that cannot be opened are remembered.
+   Handles are reference counted, .buf files of unreferenced handles are closed (and reopened on next use)
+   when more than GRID_FILE_CACHE_MAX_OPEN are open.
+   Handles are keyed on the modification time and size of the .hdr and .buf files: after a call to
+   RecheckGridFileCache() (e.g. at the start of each event), an unreferenced handle is checked once on its next use
+   and re-read if either file has changed on disk (or has appeared, for grid files that could not be opened).
+   Handles are not checked between RecheckGridFileCache() calls, so there is no file system access on cache hits.
+   Changes within the modification time resolution of the file system that do not change the file size are not
+   detected, call FreeGridFileCache() to flush the cache after rewriting grid files in place.
+
+   The cached grid description must not be modified, read values with a copy of the grid description.
+   Reads from the .buf file of a handle must be enclosed by LockCachedGrid3dFile() / UnlockCachedGrid3dFile()
+   if handles may be used by more than one thread.
+
+ */
+
+/*	history:
+
+	20261018 AJL - Original version
+	20261019 AJL - Handles re-read when grid files change on disk, checked once per RecheckGridFileCache() call
+*/
+
+
+#ifndef _NLL_GRIDCACHE_H
+#define	_NLL_GRIDCACHE_H
+
+#include <stdio.h>
+#include <time.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// GridLib.h must be included before this file
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+
+#define GRID_FILE_CACHE_MAX_OPEN 128        // maximum number of open .buf files of unreferenced handles
+#define GRID_FILE_CACHE_MAX_HANDLES 8192    // maximum number of cached handles
+
+typedef struct GridFileHandle {
+    char fname[FILENAME_MAX]; // grid file root name (no .buf or .hdr)
+    char file_type[16]; // grid file type (e.g. "time" or "angle")
+    int iSwapBytes;
+    int status; // 0 = ok, -1 = cannot open grid file
+    GridDesc grid; // grid description from header, read only
+    SourceDesc srce; // source from header (time and angle grids)
+    FILE *fp_grid; // open .buf file, or NULL if closed or not available
+    int buf_available; // 0 if .buf file could not be opened
+    int refcount;
+    unsigned long last_use;
+    time_t hdr_mtime, buf_mtime; // modification times of .hdr and .buf files when handle was opened, -1 if not found
+    long long hdr_size, buf_size; // sizes of .hdr and .buf files when handle was opened, -1 if not found
+    unsigned long generation; // cache generation when grid files were last checked
+    struct GridFileHandle *next; // hash chain
+#ifdef _OPENMP
+    omp_lock_t lock;
+#endif
+}
+GridFileHandle;
+
+
+GridFileHandle *OpenCachedGrid3dFile(char *fname, char *file_type, int iSwapBytes);
+void CloseCachedGrid3dFile(GridFileHandle *phandle);
+void LockCachedGrid3dFile(GridFileHandle *phandle);
+void UnlockCachedGrid3dFile(GridFileHandle *phandle);
+void RecheckGridFileCache(void);
+void FreeGridFileCache(void);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _NLL_GRIDCACHE_H */
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 1999-2026 Anthony Lomax <anthony@alomax.net, http://www.alomax.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+
+ * You should have received a copy of the GNU Lesser Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+/* nll_prof.h
+
+   Timing and counter instrumentation of NonLinLoc hot paths.
+
+   Compiled in only if NLL_PROFILE is defined (cmake -DNLL_PROFILE=ON),
+   otherwise all NLL_PROF_* macros expand to nothing and there is no run-time cost.
+
+   Timers accumulate wall-clock seconds and number of calls, counters accumulate counts.
+   Each thread accumulates into its own slot, slots are summed when a profile is written,
+   so timers for code run in parallel regions give total thread seconds.
+   Slots are given to threads in order of first use, at most NLL_PROF_MAX_THREADS - 1 threads
+   have their own slot; any further threads share the last slot, which is updated atomically.
+   Thread slots are thread-local through OpenMP threadprivate; without OpenMP all threads use slot 0,
+   so profiles are only reliable for single-threaded runs.
+
+ */
+
+/*	history:
+
+	20261018 AJL - Original version
+	20261019 AJL - Shared slot for threads beyond NLL_PROF_MAX_THREADS - 1
+*/
+
+
+#ifndef _NLL_PROF_H
+#define	_NLL_PROF_H
+
+#include <stdio.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+
+/* timers */
+enum NllProfTimer {
+    PROF_T_EVENT = 0, // total per event: read observations, locate, save
+    PROF_T_GRID_OPEN, // OpenGrid3dFile()
+    PROF_T_GRID_READ, // ReadGrid3dBuf() (called by NLL_ReadGrid3dBuf())
+    PROF_T_TRAVEL_TIME, // getTravelTimes()
+    PROF_T_LIKELIHOOD, // CalcSolutionQuality() during search
+    PROF_T_OCTTREE, // oct-tree leaf search, subdivision and result tree insertion
+    PROF_T_SAVE_LOCATION, // SaveLocation()
+    PROF_NUM_TIMERS
+};
+
+/* counters */
+enum NllProfCounter {
+    PROF_C_INTERP = 0, // ReadAbsInterpGrid3d() and ReadAbsInterpGrid2d() interpolations
+    PROF_C_GRIDMEM_HIT, // NLL_AllocateGrid() grid found in GridMemList
+    PROF_C_GRIDMEM_MISS, // NLL_AllocateGrid() grid not in GridMemList
+    PROF_C_BYTES_READ, // bytes read from grid buffer files
+    PROF_C_SEARCH_NODES, // search samples evaluated
+    PROF_NUM_COUNTERS
+};
+
+
+#ifdef NLL_PROFILE
+
+#define NLL_PROF_MAX_THREADS 256 // number of accumulation slots
+#define NLL_PROF_SHARED_SLOT (NLL_PROF_MAX_THREADS - 1) // slot shared by threads beyond NLL_PROF_MAX_THREADS - 1
+
+typedef struct {
+    double seconds[PROF_NUM_TIMERS];
+    long long calls[PROF_NUM_TIMERS];
+    long long count[PROF_NUM_COUNTERS];
+    char pad[64]; // keep thread slots on separate cache lines
+}
+NllProfSlot;
+
+extern NllProfSlot NllProfSlots[NLL_PROF_MAX_THREADS];
+
+double nll_prof_time(void);
+int nll_prof_thread_slot(void);
+void nll_prof_add_time(int timer, double seconds);
+void nll_prof_add_count(int counter, long long n);
+void nll_prof_reset(void);
+void nll_prof_write(FILE *fpio, char *event_name);
+void nll_prof_write_json(FILE *fpio, char *event_name);
+
+#define NLL_PROF_START(t0) double t0 = nll_prof_time()
+#define NLL_PROF_STOP(timer, t0) nll_prof_add_time(timer, nll_prof_time() - t0)
+#define NLL_PROF_COUNT(counter, n) nll_prof_add_count(counter, n)
+#define NLL_PROF_RESET() nll_prof_reset()
+
+#else
+
+#define NLL_PROF_START(t0)
+#define NLL_PROF_STOP(timer, t0)
+#define NLL_PROF_COUNT(counter, n)
+#define NLL_PROF_RESET()
+
+#endif
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _NLL_PROF_H */
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 1999-2026 Anthony Lomax <anthony@alomax.net, http://www.alomax.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+
+ * You should have received a copy of the GNU Lesser Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+/* nll_scat.h
+
+   Block reading and writing of event scatter sample files.
+
+   Scatter samples are float x, y, z, value (4 floats per sample).
+
+   Two file formats are read:
+
+   .scat - raw scatter file:
+        int nsamples, float probmax, 2 floats unused, nsamples * (float x, y, z, value)
+
+   .scatz - compressed scatter container:
+        header: char magic[8] "NLLSCATZ", int version, int nsamples, float probmax, int nblocks, 2 ints unused
+        nblocks * block:
+            block header: int nsamples (<= SCAT_BLOCK_NSAMPLES), int nbytes,
+                double xref, yref, zref, double quantum
+            nbytes of encoded samples, for each sample:
+                x, y, z quantized to integer multiples of quantum relative to xref, yref, zref,
+                and the 32 bit pattern of float value,
+                each as zig-zag, variable length (7 bits per byte) integer difference from the previous sample in the block
+        Each block is self contained, so blocks can be copied between containers without decoding.
+        Coordinates are lossy to quantum / 2, values are exact.
+
+   Integers and floats are in native byte order in both formats.
+
+ */
+
+/*	history:
+
+	20261018 AJL - Original version
+*/
+
+
+#ifndef _NLL_SCAT_H
+#define	_NLL_SCAT_H
+
+#include <stdio.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+
+#define SCAT_BLOCK_NSAMPLES 4096    // maximum samples per block, fdata buffers for block reads must hold 4 * SCAT_BLOCK_NSAMPLES floats
+#define SCATZ_QUANTUM_KM 0.001      // default quantum for rectangular (km) coordinates
+#define SCATZ_QUANTUM_DEG 0.00001   // default quantum for global (deg) coordinates
+
+typedef struct {
+    FILE *fp;
+    int compressed; // 1 if .scatz container, 0 if raw .scat
+    int nsamples; // number of samples in file
+    float probmax; // probmax from file header
+    int nsamples_read; // samples read so far
+    // last block read from container
+    int block_nsamples;
+    int block_nbytes;
+    double block_ref[3];
+    double block_quantum;
+    unsigned char *block_data;
+}
+ScatterReader;
+
+typedef struct {
+    FILE *fp;
+    int nsamples;
+    int nblocks;
+    double ref[3];
+    double quantum;
+    float *pending; // samples waiting to be encoded as a block
+    int npending;
+    unsigned char *block_data;
+}
+ScatterWriter;
+
+typedef struct {
+    unsigned char *data; // encoded blocks, each with block header, as in .scatz container
+    size_t nbytes, size;
+    int nsamples;
+    int nblocks;
+}
+ScatterBlockList;
+
+
+ScatterReader *OpenScatterReader(char *fname);
+ScatterReader *OpenEventScatterReader(char *fileroot, char *fname);
+int ReadScatterBlock(ScatterReader *preader, float *fdata);
+void CloseScatterReader(ScatterReader *preader);
+
+ScatterWriter *OpenScatterWriter(char *fname, double xref, double yref, double zref, double quantum);
+int SetScatterWriterRef(ScatterWriter *pwriter, double xref, double yref, double zref, double quantum);
+int WriteScatterSamples(ScatterWriter *pwriter, float *fdata, int nsamples);
+int SaveScatterBlock(ScatterBlockList *plist, ScatterReader *preader);
+int CopyScatterBlocks(ScatterWriter *pwriter, ScatterBlockList *plist);
+void FreeScatterBlockList(ScatterBlockList *plist);
+int CloseScatterWriter(ScatterWriter *pwriter, float probmax);
+int WriteScatterCompressed(char *fname, float *fdata, int nsamples, float probmax,
+        double xref, double yref, double zref, double quantum);
+
+void ScatterConvertCoordsRect(int proj_index_from, int proj_index_to, float *fdata, int nsamples);
+void ScatterRect2LatLon(int n_proj, float *fdata, int nsamples, double *dlat, double *dlong);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _NLL_SCAT_H */
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 1999-2026 Anthony Lomax <anthony@alomax.net, http://www.alomax.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+
+ * You should have received a copy of the GNU Lesser Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+/* nll_staindex.h
+
+   Spatial index (k-d tree) of station positions for neighbour queries by epicentral distance.
+
+   The index holds the stations of a station list that are not ignored and have known location (x > -LARGE_DOUBLE),
+   and must be rebuilt with BuildStationIndex() when the ignored flags or the station list change.
+   For GeometryMode MODE_GLOBAL stations are indexed by position on the sphere of radius AVG_ERAD,
+   chord distance does not exceed great-circle distance, so queries return all stations within a great-circle distance.
+   Station indices returned by queries are positions in the indexed station list.
+
+ */
+
+/*	history:
+
+	20261018 AJL - Original version
+*/
+
+
+#ifndef _NLL_STAINDEX_H
+#define	_NLL_STAINDEX_H
+
+// GridLib.h must be included before this file
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+
+typedef struct {
+    double pos[3]; // rectangular: x, y, 0; global: position on sphere (km)
+    int nsta; // index in station list
+    int axis; // split axis of k-d tree node
+}
+StationIndexNode;
+
+typedef struct {
+    int num_nodes;
+    int max_num_nodes; // allocated size of node array
+    StationIndexNode *node; // k-d tree, node of sub-range [lo, hi) is at (lo + hi) / 2
+}
+StationIndex;
+
+
+int BuildStationIndex(StationIndex *pindex, SourceDesc *stations, int numStations);
+int FindStationsInRadius(StationIndex *pindex, double xval, double yval, double radius, int *nsta_found);
+double GetMinStationHypoDist(StationIndex *pindex, SourceDesc *stations, double xval, double yval, double zval);
+void FreeStationIndex(StationIndex *pindex);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _NLL_STAINDEX_H */
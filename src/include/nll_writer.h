@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 1999-2026 Anthony Lomax <anthony@alomax.net, http://www.alomax.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+
+ * You should have received a copy of the GNU Lesser Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+/* nll_writer.h
+
+   Queued output writer: blocks of bytes are appended to open output files in the order queued.
+
+   If compiled with NLL_USE_PTHREADS, writes are done by a background thread,
+   otherwise each block is written immediately by the calling thread.
+   A file that is written through a writer must not be written directly until the writer is closed.
+
+ */
+
+/*	history:
+
+	20261018 AJL - Original version
+*/
+
+
+#ifndef _NLL_WRITER_H
+#define	_NLL_WRITER_H
+
+#include <stdio.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+
+typedef struct NllWriter NllWriter;
+
+/** create writer, max_queued_bytes limits memory of blocks waiting to be written (0 = default, 64MB) */
+NllWriter *new_NllWriter(size_t max_queued_bytes);
+
+/** queue block buf of size bytes to be appended to fpout, writer takes ownership of malloc'ed buf,
+ *  returns 0, or -1 if an earlier write failed */
+int NllWriter_write(NllWriter *pwriter, FILE *fpout, char *buf, size_t size);
+
+/** wait for all queued blocks to be written, stop writer and free it,
+ *  returns 0, or -1 if any write failed */
+int free_NllWriter(NllWriter *pwriter);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _NLL_WRITER_H */
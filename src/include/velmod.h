@@ -428,6 +428,8 @@ double get_poly_vel(double, double, char, double*,
 double get_poly_vel_2D3D(double, double, double, char,
         double*, int, int*);
 double get_solid_vel(double xpos, double ypos, double zpos, char wavetype, double *density, int iden);
+int init_vel_model_index();
+void free_vel_model_index();
 double get_rough_z(int nrough, double x);
 double get_rough_vel(double xpos, double zpos, char wavetype, struct rough_bndry *pr, int nrough, double *density, int iden);
 double get_surface_vel(double, double, double, char,
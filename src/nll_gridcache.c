@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 1999-2026 Anthony Lomax <anthony@alomax.net, http://www.alomax.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+
+ * You should have received a copy of the GNU Lesser Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+/* nll_gridcache.c
+
+   Process-wide cache of grid file handles, see nll_gridcache.h
+
+ */
+
+/*	history:
+
+	20261018 AJL - Original version
+	20261019 AJL - Handles re-read when grid files change on disk, checked once per RecheckGridFileCache() call
+*/
+
+
+#include <sys/stat.h>
+
+#include "GridLib.h"
+#include "nll_gridcache.h"
+
+
+#define GRID_FILE_CACHE_NBUCKETS 1024
+
+static GridFileHandle *GridFileCache[GRID_FILE_CACHE_NBUCKETS];
+static int GridFileCacheNumHandles = 0;
+static int GridFileCacheNumOpen = 0;
+static unsigned long GridFileCacheUseCount = 0;
+static unsigned long GridFileCacheGeneration = 0; // handles checked for changed grid files once per generation
+
+
+/** function to get hash bucket of grid file name */
+
+static unsigned int grid_file_hash(char *fname, char *file_type, int iSwapBytes) {
+
+    unsigned int hash = 2166136261u;
+    unsigned char *pchr;
+
+    for (pchr = (unsigned char *) fname; *pchr != '\0'; pchr++)
+        hash = (hash ^ *pchr) * 16777619u;
+    for (pchr = (unsigned char *) file_type; *pchr != '\0'; pchr++)
+        hash = (hash ^ *pchr) * 16777619u;
+    hash = (hash ^ (unsigned int) iSwapBytes) * 16777619u;
+
+    return (hash % GRID_FILE_CACHE_NBUCKETS);
+
+}
+
+/** function to get modification time and size of grid file fname.ext, -1 if file not found */
+
+static void grid_file_stat(char *fname, char *ext, time_t *pmtime, long long *psize) {
+
+    char fn_grid[FILENAME_MAX];
+    struct stat stat_buf;
+
+    snprintf(fn_grid, sizeof (fn_grid), "%s.%s", fname, ext);
+    if (stat(fn_grid, &stat_buf) != 0) {
+        *pmtime = (time_t) -1;
+        *psize = -1;
+        return;
+    }
+    *pmtime = stat_buf.st_mtime;
+    *psize = (long long) stat_buf.st_size;
+
+}
+
+/** function to check if .hdr or .buf file of grid file handle changed on disk since handle was opened */
+
+static int grid_file_changed(GridFileHandle *phandle) {
+
+    time_t mtime;
+    long long size;
+
+    grid_file_stat(phandle->fname, "hdr", &mtime, &size);
+    if (mtime != phandle->hdr_mtime || size != phandle->hdr_size)
+        return (1);
+    grid_file_stat(phandle->fname, "buf", &mtime, &size);
+    if (mtime != phandle->buf_mtime || size != phandle->buf_size)
+        return (1);
+
+    return (0);
+
+}
+
+/** function to close .buf file of grid file handle */
+
+static void close_grid_file_buf(GridFileHandle *phandle) {
+
+    if (phandle->fp_grid != NULL) {
+        fclose(phandle->fp_grid);
+        phandle->fp_grid = NULL;
+        NumGridBufFilesOpen--;
+        NumFilesOpen--;
+        GridFileCacheNumOpen--;
+    }
+
+}
+
+/** function to free grid file handle */
+
+static void free_grid_file_handle(GridFileHandle *phandle) {
+
+    close_grid_file_buf(phandle);
+    if (phandle->status == 0) {
+        DestroyGridArray(&phandle->grid);
+        phandle->grid.array = NULL;
+        FreeGrid(&phandle->grid);
+    }
+#ifdef _OPENMP
+    omp_destroy_lock(&phandle->lock);
+#endif
+    free(phandle);
+
+}
+
+/** function to close .buf files of least recently used, unreferenced handles while more than nmax_open are open */
+
+static void close_unused_grid_files(int nmax_open) {
+
+    int nbucket;
+    GridFileHandle *phandle, *plru;
+
+    while (GridFileCacheNumOpen > nmax_open) {
+        plru = NULL;
+        for (nbucket = 0; nbucket < GRID_FILE_CACHE_NBUCKETS; nbucket++) {
+            for (phandle = GridFileCache[nbucket]; phandle != NULL; phandle = phandle->next) {
+                if (phandle->fp_grid != NULL && phandle->refcount == 0
+                        && (plru == NULL || phandle->last_use < plru->last_use))
+                    plru = phandle;
+            }
+        }
+        if (plru == NULL) // all open files in use
+            return;
+        close_grid_file_buf(plru);
+    }
+
+}
+
+/** function to remove least recently used, unreferenced handle from cache */
+
+static void remove_unused_grid_file_handle() {
+
+    int nbucket;
+    GridFileHandle *phandle, **pplink, **pplink_lru = NULL;
+
+    for (nbucket = 0; nbucket < GRID_FILE_CACHE_NBUCKETS; nbucket++) {
+        for (pplink = GridFileCache + nbucket; (phandle = *pplink) != NULL; pplink = &phandle->next) {
+            if (phandle->refcount == 0 && (pplink_lru == NULL || phandle->last_use < (*pplink_lru)->last_use))
+                pplink_lru = pplink;
+        }
+    }
+    if (pplink_lru == NULL) // all handles in use
+        return;
+
+    phandle = *pplink_lru;
+    *pplink_lru = phandle->next;
+    free_grid_file_handle(phandle);
+    GridFileCacheNumHandles--;
+
+}
+
+/** function to find or open grid file handle, must be called within critical section nll_grid_file_cache */
+
+static GridFileHandle *get_grid_file_handle(char *fname, char *file_type, int iSwapBytes) {
+
+    unsigned int nbucket;
+    GridFileHandle *phandle, **pplink;
+    FILE *fp_hdr;
+    char fn_grid[FILENAME_MAX];
+
+    nbucket = grid_file_hash(fname, file_type, iSwapBytes);
+    for (pplink = GridFileCache + nbucket; (phandle = *pplink) != NULL; pplink = &phandle->next) {
+        if (phandle->iSwapBytes == iSwapBytes && strcmp(phandle->fname, fname) == 0
+                && strcmp(phandle->file_type, file_type) == 0)
+            break;
+    }
+
+    // grid files changed on disk, remove handle and read header again, handles in use are kept until released
+    if (phandle != NULL && phandle->refcount == 0 && phandle->generation != GridFileCacheGeneration) {
+        phandle->generation = GridFileCacheGeneration;
+        if (grid_file_changed(phandle)) {
+            *pplink = phandle->next;
+            free_grid_file_handle(phandle);
+            GridFileCacheNumHandles--;
+            phandle = NULL;
+        }
+    }
+
+    if (phandle == NULL) {
+
+        // new handle, read header once
+        if (GridFileCacheNumHandles >= GRID_FILE_CACHE_MAX_HANDLES)
+            remove_unused_grid_file_handle();
+        if ((phandle = (GridFileHandle *) calloc(1, sizeof (GridFileHandle))) == NULL) {
+            nll_puterr("ERROR: allocating memory for grid file handle.");
+            return (NULL);
+        }
+        snprintf(phandle->fname, sizeof (phandle->fname), "%s", fname);
+        snprintf(phandle->file_type, sizeof (phandle->file_type), "%s", file_type);
+        phandle->iSwapBytes = iSwapBytes;
+        phandle->generation = GridFileCacheGeneration;
+#ifdef _OPENMP
+        omp_init_lock(&phandle->lock);
+#endif
+        // file state before opening, so that a change while reading is detected on next use
+        grid_file_stat(fname, "hdr", &phandle->hdr_mtime, &phandle->hdr_size);
+        grid_file_stat(fname, "buf", &phandle->buf_mtime, &phandle->buf_size);
+        close_unused_grid_files(GRID_FILE_CACHE_MAX_OPEN - 1);
+        if (OpenGrid3dFile(fname, &phandle->fp_grid, &fp_hdr, &phandle->grid, file_type, &phandle->srce, iSwapBytes) < 0) {
+            phandle->status = -1; // remember that grid file cannot be opened
+        } else {
+            fclose(fp_hdr);
+            NumGridHdrFilesOpen--;
+            NumFilesOpen--;
+            phandle->buf_available = phandle->fp_grid != NULL;
+            if (phandle->fp_grid != NULL)
+                GridFileCacheNumOpen++;
+            if (phandle->buf_available && isCascadingGrid(&phandle->grid)) {
+                // grid values read from file, cascading grid index arrays needed to find values in file
+                AllocateGrid_Cascading(&phandle->grid, 0);
+                CreateGridArray(&phandle->grid);
+            }
+        }
+        phandle->next = GridFileCache[nbucket];
+        GridFileCache[nbucket] = phandle;
+        GridFileCacheNumHandles++;
+
+    } else if (phandle->status == 0 && phandle->fp_grid == NULL && phandle->buf_available) {
+
+        // .buf file was closed to limit number of open files, reopen
+        close_unused_grid_files(GRID_FILE_CACHE_MAX_OPEN - 1);
+        snprintf(fn_grid, sizeof (fn_grid), "%s.buf", fname);
+        if ((phandle->fp_grid = fopen(fn_grid, "r")) == NULL) {
+            sprintf(MsgStr, "WARNING: cannot reopen grid buffer file: %s", fn_grid);
+            nll_putmsg(1, MsgStr);
+        } else {
+            NumGridBufFilesOpen++;
+            NumFilesOpen++;
+            GridFileCacheNumOpen++;
+        }
+
+    }
+
+    if (phandle->status < 0)
+        return (NULL);
+
+    phandle->refcount++;
+    phandle->last_use = ++GridFileCacheUseCount;
+
+    return (phandle);
+
+}
+
+/** function to get cached handle for grid file, opens grid file and reads header on first use
+ *
+ *  returns handle, or NULL if grid file cannot be opened
+ *  handle must be released with CloseCachedGrid3dFile()
+ */
+
+GridFileHandle *OpenCachedGrid3dFile(char *fname, char *file_type, int iSwapBytes) {
+
+    GridFileHandle *phandle;
+
+#ifdef _OPENMP
+#pragma omp critical(nll_grid_file_cache)
+#endif
+    {
+        phandle = get_grid_file_handle(fname, file_type, iSwapBytes);
+    }
+
+    return (phandle);
+
+}
+
+/** function to release cached grid file handle, grid file remains open in cache */
+
+void CloseCachedGrid3dFile(GridFileHandle *phandle) {
+
+    if (phandle == NULL)
+        return;
+
+#ifdef _OPENMP
+#pragma omp critical(nll_grid_file_cache)
+#endif
+    {
+        phandle->refcount--;
+        close_unused_grid_files(GRID_FILE_CACHE_MAX_OPEN);
+    }
+
+}
+
+/** function to lock cached grid file handle for reading from .buf file */
+
+void LockCachedGrid3dFile(GridFileHandle *phandle) {
+
+#ifdef _OPENMP
+    omp_set_lock(&phandle->lock);
+#else
+    (void) phandle;
+#endif
+
+}
+
+/** function to unlock cached grid file handle */
+
+void UnlockCachedGrid3dFile(GridFileHandle *phandle) {
+
+#ifdef _OPENMP
+    omp_unset_lock(&phandle->lock);
+#else
+    (void) phandle;
+#endif
+
+}
+
+/** function to have cached handles checked for changed grid files on disk on their next use
+ *
+ *  call e.g. once per event, handles are not checked otherwise
+ */
+
+void RecheckGridFileCache() {
+
+#ifdef _OPENMP
+#pragma omp critical(nll_grid_file_cache)
+#endif
+    {
+        GridFileCacheGeneration++;
+    }
+
+}
+
+/** function to close all cached grid files and free cache, no handles may be in use
+ *
+ *  also use to flush the cache so that all grid files are read again on next use
+ */
+
+void FreeGridFileCache() {
+
+    int nbucket;
+    GridFileHandle *phandle, *pnext;
+
+#ifdef _OPENMP
+#pragma omp critical(nll_grid_file_cache)
+#endif
+    {
+        for (nbucket = 0; nbucket < GRID_FILE_CACHE_NBUCKETS; nbucket++) {
+            for (phandle = GridFileCache[nbucket]; phandle != NULL; phandle = pnext) {
+                pnext = phandle->next;
+                free_grid_file_handle(phandle);
+            }
+            GridFileCache[nbucket] = NULL;
+        }
+        GridFileCacheNumHandles = 0;
+        GridFileCacheNumOpen = 0;
+    }
+
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 1999-2026 Anthony Lomax <anthony@alomax.net, http://www.alomax.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+
+ * You should have received a copy of the GNU Lesser Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+/* nll_prof.c
+
+   Timing and counter instrumentation of NonLinLoc hot paths, see nll_prof.h
+
+ */
+
+/*	history:
+
+	20261018 AJL - Original version
+	20261019 AJL - Slots given to threads in order of first use, shared slot for threads beyond NLL_PROF_MAX_THREADS - 1 updated atomically
+*/
+
+
+#include <string.h>
+#include <time.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "nll_prof.h"
+
+
+#ifdef NLL_PROFILE
+
+NllProfSlot NllProfSlots[NLL_PROF_MAX_THREADS];
+
+static const char *timer_names[PROF_NUM_TIMERS] = {
+    "event", "grid_open", "grid_read", "travel_time", "likelihood", "octtree", "save_location"
+};
+
+static const char *counter_names[PROF_NUM_COUNTERS] = {
+    "interp", "gridmem_hit", "gridmem_miss", "bytes_read", "search_nodes"
+};
+
+
+/** return monotonic wall-clock time in seconds */
+
+double nll_prof_time(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((double) ts.tv_sec + 1.0e-9 * (double) ts.tv_nsec);
+
+}
+
+/** accumulation slot of calling thread, -1 until first use */
+
+static int prof_thread_slot = -1;
+#ifdef _OPENMP
+#pragma omp threadprivate(prof_thread_slot)
+#endif
+
+static int prof_num_thread_slots = 0;
+
+/** return accumulation slot for calling thread
+ *
+ *  slots are given to threads in order of first use, OpenMP team threads and other threads (e.g. nll_writer)
+ *  alike; threads beyond NLL_PROF_MAX_THREADS - 1 share slot NLL_PROF_SHARED_SLOT
+ */
+
+int nll_prof_thread_slot(void) {
+
+    int nslot;
+
+    if (prof_thread_slot < 0) {
+#ifdef _OPENMP
+#pragma omp atomic capture
+#endif
+        nslot = prof_num_thread_slots++;
+        prof_thread_slot = nslot < NLL_PROF_SHARED_SLOT ? nslot : NLL_PROF_SHARED_SLOT;
+    }
+
+    return (prof_thread_slot);
+
+}
+
+/** add elapsed seconds and one call to timer of calling thread */
+
+void nll_prof_add_time(int timer, double seconds) {
+
+    int nslot = nll_prof_thread_slot();
+
+    if (nslot == NLL_PROF_SHARED_SLOT) {
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        NllProfSlots[nslot].seconds[timer] += seconds;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        NllProfSlots[nslot].calls[timer]++;
+    } else {
+        NllProfSlots[nslot].seconds[timer] += seconds;
+        NllProfSlots[nslot].calls[timer]++;
+    }
+
+}
+
+/** add n to counter of calling thread */
+
+void nll_prof_add_count(int counter, long long n) {
+
+    int nslot = nll_prof_thread_slot();
+
+    if (nslot == NLL_PROF_SHARED_SLOT) {
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        NllProfSlots[nslot].count[counter] += n;
+    } else {
+        NllProfSlots[nslot].count[counter] += n;
+    }
+
+}
+
+/** reset all timers and counters, e.g. at start of each event */
+
+void nll_prof_reset(void) {
+
+    memset(NllProfSlots, 0, sizeof (NllProfSlots));
+
+}
+
+/** sum thread slots */
+
+static void nll_prof_sum(NllProfSlot *psum) {
+
+    int n, i;
+
+    memset(psum, 0, sizeof (NllProfSlot));
+    for (n = 0; n < NLL_PROF_MAX_THREADS; n++) {
+        for (i = 0; i < PROF_NUM_TIMERS; i++) {
+            psum->seconds[i] += NllProfSlots[n].seconds[i];
+            psum->calls[i] += NllProfSlots[n].calls[i];
+        }
+        for (i = 0; i < PROF_NUM_COUNTERS; i++)
+            psum->count[i] += NllProfSlots[n].count[i];
+    }
+
+}
+
+/** write profile as a single line of name=value pairs:
+ *  PROF <event_name> <timer>_s=<seconds> <timer>_n=<calls> ... <counter>=<count> ...
+ */
+
+void nll_prof_write(FILE *fpio, char *event_name) {
+
+    int i;
+    NllProfSlot sum;
+
+    nll_prof_sum(&sum);
+
+    fprintf(fpio, "PROF %s", event_name);
+    for (i = 0; i < PROF_NUM_TIMERS; i++)
+        fprintf(fpio, " %s_s=%.6f %s_n=%lld", timer_names[i], sum.seconds[i], timer_names[i], sum.calls[i]);
+    for (i = 0; i < PROF_NUM_COUNTERS; i++)
+        fprintf(fpio, " %s=%lld", counter_names[i], sum.count[i]);
+    fprintf(fpio, "\n");
+
+}
+
+/** write profile as a single line JSON record:
+ *  {"event": "<event_name>", "timers": {"<timer>": {"s": <seconds>, "n": <calls>}, ...}, "counters": {"<counter>": <count>, ...}}
+ */
+
+void nll_prof_write_json(FILE *fpio, char *event_name) {
+
+    int i;
+    NllProfSlot sum;
+
+    nll_prof_sum(&sum);
+
+    fprintf(fpio, "{\"event\": \"%s\", \"timers\": {", event_name);
+    for (i = 0; i < PROF_NUM_TIMERS; i++)
+        fprintf(fpio, "%s\"%s\": {\"s\": %.6f, \"n\": %lld}", i > 0 ? ", " : "", timer_names[i], sum.seconds[i], sum.calls[i]);
+    fprintf(fpio, "}, \"counters\": {");
+    for (i = 0; i < PROF_NUM_COUNTERS; i++)
+        fprintf(fpio, "%s\"%s\": %lld", i > 0 ? ", " : "", counter_names[i], sum.count[i]);
+    fprintf(fpio, "}}\n");
+
+}
+
+#endif
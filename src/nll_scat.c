@@ -0,0 +1,508 @@
+/*
+ * Copyright (C) 1999-2026 Anthony Lomax <anthony@alomax.net, http://www.alomax.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+
+ * You should have received a copy of the GNU Lesser Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+/* nll_scat.c
+
+   Block reading and writing of event scatter sample files, see nll_scat.h
+
+ */
+
+/*	history:
+
+	20261018 AJL - Original version
+*/
+
+
+#include <unistd.h>
+
+#include "GridLib.h"
+#include "nll_scat.h"
+
+
+#define SCATZ_MAGIC "NLLSCATZ"
+#define SCATZ_VERSION 1
+#define SCATZ_MAX_BYTES_PER_SAMPLE (4 * 5)  // 4 variable length 32 bit integers
+#define SCATZ_MAX_QUANTA 1073741823  // quantized coordinates limited so that differences fit in 32 bits
+
+typedef struct {
+    char magic[8];
+    int version;
+    int nsamples;
+    float probmax;
+    int nblocks;
+    int unused[2];
+}
+ScatzHeader;
+
+typedef struct {
+    int nsamples;
+    int nbytes;
+    double ref[3];
+    double quantum;
+}
+ScatzBlockHeader;
+
+
+/** function to write signed integer difference as zig-zag, variable length (7 bits per byte) integer */
+
+static unsigned char *put_varint(unsigned char *pdata, int idiff) {
+
+    unsigned int uval = ((unsigned int) idiff << 1) ^ (unsigned int) (idiff >> 31);
+    while (uval >= 0x80) {
+        *pdata++ = (unsigned char) (uval | 0x80);
+        uval >>= 7;
+    }
+    *pdata++ = (unsigned char) uval;
+
+    return (pdata);
+
+}
+
+/** function to read zig-zag, variable length integer, returns NULL if data ends or integer too long */
+
+static unsigned char *get_varint(unsigned char *pdata, unsigned char *pend, int *pidiff) {
+
+    unsigned int uval = 0;
+    int shift = 0;
+    do {
+        if (pdata >= pend || shift > 28)
+            return (NULL);
+        uval |= (unsigned int) (*pdata & 0x7f) << shift;
+        shift += 7;
+    } while (*pdata++ & 0x80);
+    *pidiff = (int) (uval >> 1) ^ -(int) (uval & 1);
+
+    return (pdata);
+
+}
+
+
+/** function to open raw .scat or compressed .scatz scatter file for reading, format is detected from file contents */
+
+ScatterReader *OpenScatterReader(char *fname) {
+
+    ScatterReader *preader;
+    ScatzHeader header;
+    FILE *fp;
+
+    if ((fp = fopen(fname, "rb")) == NULL)
+        return (NULL);
+
+    if ((preader = calloc(1, sizeof (ScatterReader))) == NULL) {
+        fclose(fp);
+        return (NULL);
+    }
+    preader->fp = fp;
+
+    if (fread(&header, sizeof (ScatzHeader), 1, fp) == 1 && strncmp(header.magic, SCATZ_MAGIC, 8) == 0) {
+        if (header.version != SCATZ_VERSION) {
+            nll_puterr2("ERROR: unsupported compressed scatter file version", fname);
+            CloseScatterReader(preader);
+            return (NULL);
+        }
+        preader->compressed = 1;
+        preader->nsamples = header.nsamples;
+        preader->probmax = header.probmax;
+        if ((preader->block_data = malloc(SCAT_BLOCK_NSAMPLES * SCATZ_MAX_BYTES_PER_SAMPLE)) == NULL) {
+            CloseScatterReader(preader);
+            return (NULL);
+        }
+    } else {
+        /* raw scatter file header record */
+        fseek(fp, 0, SEEK_SET);
+        if (fread(&preader->nsamples, sizeof (int), 1, fp) != 1 || fread(&preader->probmax, sizeof (float), 1, fp) != 1) {
+            CloseScatterReader(preader);
+            return (NULL);
+        }
+        fseek(fp, 4 * sizeof (float), SEEK_SET);
+    }
+    if (preader->nsamples < 0)
+        preader->nsamples = 0;
+
+    return (preader);
+
+}
+
+/** function to open event scatter file <fileroot>.scat, or if not found, <fileroot>.scatz
+ *
+ *  fname is set to name of file opened, or to <fileroot>.scat if no file found
+ */
+
+ScatterReader *OpenEventScatterReader(char *fileroot, char *fname) {
+
+    sprintf(fname, "%s.scat", fileroot);
+    if (access(fname, F_OK) != 0) {
+        sprintf(fname, "%s.scatz", fileroot);
+        if (access(fname, F_OK) != 0)
+            sprintf(fname, "%s.scat", fileroot);
+    }
+
+    return (OpenScatterReader(fname));
+
+}
+
+/** function to read next block of up to SCAT_BLOCK_NSAMPLES scatter samples into fdata
+ *
+ *  if fdata is NULL, a compressed block is read but not decoded
+ *  the encoded last block read from a compressed container may be kept for copying with SaveScatterBlock()
+ *
+ *  returns number of samples read, 0 at end of file, -1 on error
+ */
+
+int ReadScatterBlock(ScatterReader *preader, float *fdata) {
+
+    int n, nsamples;
+
+    nsamples = preader->nsamples - preader->nsamples_read;
+    if (nsamples <= 0)
+        return (0);
+
+    if (!preader->compressed) {
+        if (fdata == NULL)
+            return (-1);
+        if (nsamples > SCAT_BLOCK_NSAMPLES)
+            nsamples = SCAT_BLOCK_NSAMPLES;
+        if (fread(fdata, 4 * sizeof (float), nsamples, preader->fp) != (size_t) nsamples)
+            return (-1);
+        preader->nsamples_read += nsamples;
+        return (nsamples);
+    }
+
+    ScatzBlockHeader block_header;
+    if (fread(&block_header, sizeof (ScatzBlockHeader), 1, preader->fp) != 1)
+        return (-1);
+    if (block_header.nsamples < 0 || block_header.nsamples > SCAT_BLOCK_NSAMPLES || block_header.nsamples > nsamples
+            || block_header.nbytes < 0 || block_header.nbytes > block_header.nsamples * SCATZ_MAX_BYTES_PER_SAMPLE)
+        return (-1);
+    if (fread(preader->block_data, 1, block_header.nbytes, preader->fp) != (size_t) block_header.nbytes)
+        return (-1);
+    preader->block_nsamples = block_header.nsamples;
+    preader->block_nbytes = block_header.nbytes;
+    preader->block_ref[0] = block_header.ref[0];
+    preader->block_ref[1] = block_header.ref[1];
+    preader->block_ref[2] = block_header.ref[2];
+    preader->block_quantum = block_header.quantum;
+
+    if (fdata == NULL) {
+        preader->nsamples_read += block_header.nsamples;
+        return (block_header.nsamples);
+    }
+
+    /* decode samples */
+    unsigned char *pdata = preader->block_data;
+    unsigned char *pend = preader->block_data + block_header.nbytes;
+    int iq[3] = {0, 0, 0};
+    unsigned int value_bits = 0;
+    int idiff;
+    for (n = 0; n < block_header.nsamples; n++) {
+        for (int i = 0; i < 3; i++) {
+            if ((pdata = get_varint(pdata, pend, &idiff)) == NULL)
+                return (-1);
+            iq[i] += idiff;
+            fdata[i] = (float) (block_header.ref[i] + (double) iq[i] * block_header.quantum);
+        }
+        if ((pdata = get_varint(pdata, pend, &idiff)) == NULL)
+            return (-1);
+        value_bits += (unsigned int) idiff;
+        memcpy(fdata + 3, &value_bits, sizeof (float));
+        fdata += 4;
+    }
+
+    preader->nsamples_read += block_header.nsamples;
+
+    return (block_header.nsamples);
+
+}
+
+/** function to close scatter file and free reader */
+
+void CloseScatterReader(ScatterReader *preader) {
+
+    if (preader == NULL)
+        return;
+    if (preader->fp != NULL)
+        fclose(preader->fp);
+    free(preader->block_data);
+    free(preader);
+
+}
+
+
+
+/** function to open compressed scatter container for writing
+ *
+ *  samples are quantized to quantum relative to reference point xref, yref, zref (e.g. hypocenter)
+ */
+
+ScatterWriter *OpenScatterWriter(char *fname, double xref, double yref, double zref, double quantum) {
+
+    ScatterWriter *pwriter;
+    ScatzHeader header;
+
+    if ((pwriter = calloc(1, sizeof (ScatterWriter))) == NULL)
+        return (NULL);
+    pwriter->ref[0] = xref;
+    pwriter->ref[1] = yref;
+    pwriter->ref[2] = zref;
+    pwriter->quantum = quantum > 0.0 ? quantum : SCATZ_QUANTUM_KM;
+    if ((pwriter->pending = malloc(4 * SCAT_BLOCK_NSAMPLES * sizeof (float))) == NULL
+            || (pwriter->block_data = malloc(SCAT_BLOCK_NSAMPLES * SCATZ_MAX_BYTES_PER_SAMPLE)) == NULL
+            || (pwriter->fp = fopen(fname, "wb")) == NULL) {
+        free(pwriter->pending);
+        free(pwriter->block_data);
+        free(pwriter);
+        return (NULL);
+    }
+
+    /* header record, completed in CloseScatterWriter() */
+    memset(&header, 0, sizeof (ScatzHeader));
+    if (fwrite(&header, sizeof (ScatzHeader), 1, pwriter->fp) != 1) {
+        fclose(pwriter->fp);
+        free(pwriter->pending);
+        free(pwriter->block_data);
+        free(pwriter);
+        return (NULL);
+    }
+
+    return (pwriter);
+
+}
+
+/** function to encode and write pending samples as a block */
+
+static int flush_scatter_block(ScatterWriter *pwriter) {
+
+    ScatzBlockHeader block_header;
+    unsigned char *pdata = pwriter->block_data;
+    float *fdata = pwriter->pending;
+    int n, i;
+
+    if (pwriter->npending < 1)
+        return (0);
+
+    int iq_last[3] = {0, 0, 0};
+    unsigned int value_bits, value_bits_last = 0;
+    for (n = 0; n < pwriter->npending; n++) {
+        for (i = 0; i < 3; i++) {
+            double xq = floor(((double) fdata[i] - pwriter->ref[i]) / pwriter->quantum + 0.5);
+            if (!(xq > -SCATZ_MAX_QUANTA)) // also catches NaN
+                xq = -SCATZ_MAX_QUANTA;
+            else if (xq > SCATZ_MAX_QUANTA)
+                xq = SCATZ_MAX_QUANTA;
+            int iq = (int) xq;
+            pdata = put_varint(pdata, iq - iq_last[i]);
+            iq_last[i] = iq;
+        }
+        // value is exact, difference of float bit patterns is small for samples with similar values
+        memcpy(&value_bits, fdata + 3, sizeof (float));
+        pdata = put_varint(pdata, (int) (value_bits - value_bits_last));
+        value_bits_last = value_bits;
+        fdata += 4;
+    }
+
+    block_header.nsamples = pwriter->npending;
+    block_header.nbytes = (int) (pdata - pwriter->block_data);
+    block_header.ref[0] = pwriter->ref[0];
+    block_header.ref[1] = pwriter->ref[1];
+    block_header.ref[2] = pwriter->ref[2];
+    block_header.quantum = pwriter->quantum;
+    if (fwrite(&block_header, sizeof (ScatzBlockHeader), 1, pwriter->fp) != 1
+            || fwrite(pwriter->block_data, 1, block_header.nbytes, pwriter->fp) != (size_t) block_header.nbytes)
+        return (-1);
+
+    pwriter->nsamples += pwriter->npending;
+    pwriter->nblocks++;
+    pwriter->npending = 0;
+
+    return (0);
+
+}
+
+/** function to set reference point and quantum (if > 0.0) for following samples, e.g. hypocenter of next event */
+
+int SetScatterWriterRef(ScatterWriter *pwriter, double xref, double yref, double zref, double quantum) {
+
+    if (flush_scatter_block(pwriter) < 0)
+        return (-1);
+    pwriter->ref[0] = xref;
+    pwriter->ref[1] = yref;
+    pwriter->ref[2] = zref;
+    if (quantum > 0.0)
+        pwriter->quantum = quantum;
+
+    return (0);
+
+}
+
+/** function to append samples to compressed scatter container */
+
+int WriteScatterSamples(ScatterWriter *pwriter, float *fdata, int nsamples) {
+
+    int n;
+
+    while (nsamples > 0) {
+        n = SCAT_BLOCK_NSAMPLES - pwriter->npending;
+        if (n > nsamples)
+            n = nsamples;
+        memcpy(pwriter->pending + 4 * pwriter->npending, fdata, (size_t) n * 4 * sizeof (float));
+        pwriter->npending += n;
+        fdata += 4 * n;
+        nsamples -= n;
+        if (pwriter->npending == SCAT_BLOCK_NSAMPLES && flush_scatter_block(pwriter) < 0)
+            return (-1);
+    }
+
+    return (0);
+
+}
+
+/** function to keep last block read from a compressed scatter container, encoded, for copying with CopyScatterBlocks() */
+
+int SaveScatterBlock(ScatterBlockList *plist, ScatterReader *preader) {
+
+    ScatzBlockHeader block_header;
+    size_t nbytes;
+
+    if (!preader->compressed || preader->block_nsamples < 1)
+        return (-1);
+
+    nbytes = sizeof (ScatzBlockHeader) + (size_t) preader->block_nbytes;
+    if (plist->size - plist->nbytes < nbytes) {
+        size_t size = plist->size > 0 ? 2 * plist->size : 4 * nbytes;
+        while (size - plist->nbytes < nbytes)
+            size *= 2;
+        unsigned char *data = realloc(plist->data, size);
+        if (data == NULL)
+            return (-1);
+        plist->data = data;
+        plist->size = size;
+    }
+
+    block_header.nsamples = preader->block_nsamples;
+    block_header.nbytes = preader->block_nbytes;
+    block_header.ref[0] = preader->block_ref[0];
+    block_header.ref[1] = preader->block_ref[1];
+    block_header.ref[2] = preader->block_ref[2];
+    block_header.quantum = preader->block_quantum;
+    memcpy(plist->data + plist->nbytes, &block_header, sizeof (ScatzBlockHeader));
+    memcpy(plist->data + plist->nbytes + sizeof (ScatzBlockHeader), preader->block_data, (size_t) preader->block_nbytes);
+    plist->nbytes += nbytes;
+    plist->nsamples += preader->block_nsamples;
+    plist->nblocks++;
+
+    return (0);
+
+}
+
+/** function to append kept compressed blocks to compressed scatter container without decoding and re-encoding */
+
+int CopyScatterBlocks(ScatterWriter *pwriter, ScatterBlockList *plist) {
+
+    if (flush_scatter_block(pwriter) < 0)
+        return (-1);
+    if (plist->nbytes > 0 && fwrite(plist->data, 1, plist->nbytes, pwriter->fp) != plist->nbytes)
+        return (-1);
+
+    pwriter->nsamples += plist->nsamples;
+    pwriter->nblocks += plist->nblocks;
+
+    return (0);
+
+}
+
+/** function to free kept compressed blocks */
+
+void FreeScatterBlockList(ScatterBlockList *plist) {
+
+    free(plist->data);
+    memset(plist, 0, sizeof (ScatterBlockList));
+
+}
+
+/** function to write remaining samples and header record, close file and free writer */
+
+int CloseScatterWriter(ScatterWriter *pwriter, float probmax) {
+
+    ScatzHeader header;
+    int istat = 0;
+
+    if (flush_scatter_block(pwriter) < 0)
+        istat = -1;
+
+    memset(&header, 0, sizeof (ScatzHeader));
+    memcpy(header.magic, SCATZ_MAGIC, 8);
+    header.version = SCATZ_VERSION;
+    header.nsamples = pwriter->nsamples;
+    header.probmax = probmax;
+    header.nblocks = pwriter->nblocks;
+    fseek(pwriter->fp, 0, SEEK_SET);
+    if (fwrite(&header, sizeof (ScatzHeader), 1, pwriter->fp) != 1)
+        istat = -1;
+    if (fclose(pwriter->fp) != 0)
+        istat = -1;
+
+    free(pwriter->pending);
+    free(pwriter->block_data);
+    free(pwriter);
+
+    return (istat);
+
+}
+
+/** function to write samples to a new compressed scatter container */
+
+int WriteScatterCompressed(char *fname, float *fdata, int nsamples, float probmax,
+        double xref, double yref, double zref, double quantum) {
+
+    ScatterWriter *pwriter;
+
+    if ((pwriter = OpenScatterWriter(fname, xref, yref, zref, quantum)) == NULL)
+        return (-1);
+    int istat = nsamples > 0 ? WriteScatterSamples(pwriter, fdata, nsamples) : 0;
+    if (CloseScatterWriter(pwriter, probmax) < 0)
+        istat = -1;
+
+    return (istat);
+
+}
+
+
+
+/** function to convert x, y of a block of scatter samples between rectangular coordinate systems */
+
+void ScatterConvertCoordsRect(int proj_index_from, int proj_index_to, float *fdata, int nsamples) {
+
+    double xnew, ynew;
+
+    for (int n = 0; n < nsamples; n++, fdata += 4) {
+        convertCoordsRect(proj_index_from, proj_index_to, fdata[0], fdata[1], &xnew, &ynew);
+        fdata[0] = xnew;
+        fdata[1] = ynew;
+    }
+
+}
+
+/** function to convert x, y of a block of scatter samples to latitude and longitude */
+
+void ScatterRect2LatLon(int n_proj, float *fdata, int nsamples, double *dlat, double *dlong) {
+
+    for (int n = 0; n < nsamples; n++, fdata += 4)
+        rect2latlon(n_proj, fdata[0], fdata[1], dlat + n, dlong + n);
+
+}
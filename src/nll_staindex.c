@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 1999-2026 Anthony Lomax <anthony@alomax.net, http://www.alomax.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+
+ * You should have received a copy of the GNU Lesser Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+/* nll_staindex.c
+
+   Spatial index (k-d tree) of station positions, see nll_staindex.h
+
+ */
+
+/*	history:
+
+	20261018 AJL - Original version
+*/
+
+
+#include "GridLib.h"
+#include "nll_staindex.h"
+
+
+// tolerance added to query distances to cover rounding of GetEpiDist(), in particular acos() of GCDistance() for close points
+#define STATION_INDEX_TOL_REL 1.0e-6
+#define STATION_INDEX_TOL_ABS 1.0e-3    // km
+
+
+/** function to get index position of an x-y location */
+
+static void station_index_pos(double xval, double yval, double *pos) {
+
+    double lat, lon;
+
+    if (GeometryMode == MODE_GLOBAL) {
+        lat = yval * DE2RA;
+        lon = xval * DE2RA;
+        pos[0] = AVG_ERAD * cos(lat) * cos(lon);
+        pos[1] = AVG_ERAD * cos(lat) * sin(lon);
+        pos[2] = AVG_ERAD * sin(lat);
+    } else {
+        pos[0] = xval;
+        pos[1] = yval;
+        pos[2] = 0.0;
+    }
+
+}
+
+/** function to partially sort nodes [lo, hi) on axis so that node k is in sorted position */
+
+static void station_index_select(StationIndexNode *node, int lo, int hi, int k, int axis) {
+
+    int i, j;
+    double pivot;
+    StationIndexNode tmp;
+
+    hi--;
+    while (lo < hi) {
+        pivot = node[(lo + hi) / 2].pos[axis];
+        i = lo;
+        j = hi;
+        while (i <= j) {
+            while (node[i].pos[axis] < pivot)
+                i++;
+            while (node[j].pos[axis] > pivot)
+                j--;
+            if (i <= j) {
+                tmp = node[i];
+                node[i] = node[j];
+                node[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+        if (k <= j)
+            hi = j;
+        else if (k >= i)
+            lo = i;
+        else
+            return;
+    }
+
+}
+
+/** function to build k-d tree on nodes [lo, hi), splitting on axis of largest extent */
+
+static void station_index_build(StationIndexNode *node, int lo, int hi) {
+
+    int n, axis, mid;
+    double pmin[3], pmax[3], extent;
+
+    if (hi - lo < 1)
+        return;
+
+    for (axis = 0; axis < 3; axis++)
+        pmin[axis] = pmax[axis] = node[lo].pos[axis];
+    for (n = lo + 1; n < hi; n++) {
+        for (axis = 0; axis < 3; axis++) {
+            if (node[n].pos[axis] < pmin[axis])
+                pmin[axis] = node[n].pos[axis];
+            else if (node[n].pos[axis] > pmax[axis])
+                pmax[axis] = node[n].pos[axis];
+        }
+    }
+    mid = 0;
+    extent = -1.0;
+    for (axis = 0; axis < 3; axis++) {
+        if (pmax[axis] - pmin[axis] > extent) {
+            extent = pmax[axis] - pmin[axis];
+            mid = axis;
+        }
+    }
+    axis = mid;
+
+    mid = (lo + hi) / 2;
+    station_index_select(node, lo, hi, mid, axis);
+    node[mid].axis = axis;
+    station_index_build(node, lo, mid);
+    station_index_build(node, mid + 1, hi);
+
+}
+
+/** function to build index of stations that are not ignored and have known location
+ *
+ *  returns number of stations indexed, or -1 on allocation error
+ */
+
+int BuildStationIndex(StationIndex *pindex, SourceDesc *stations, int numStations) {
+
+    int n;
+    StationIndexNode *pnode;
+
+    if (numStations > pindex->max_num_nodes) {
+        free(pindex->node);
+        pindex->num_nodes = pindex->max_num_nodes = 0;
+        if ((pindex->node = (StationIndexNode *) malloc((size_t) numStations * sizeof (StationIndexNode))) == NULL) {
+            nll_puterr("ERROR: allocating memory for station index.");
+            return (-1);
+        }
+        pindex->max_num_nodes = numStations;
+    }
+
+    pindex->num_nodes = 0;
+    for (n = 0; n < numStations; n++) {
+        if ((stations + n)->ignored || (stations + n)->x <= -LARGE_DOUBLE)
+            continue;
+        pnode = pindex->node + pindex->num_nodes++;
+        station_index_pos((stations + n)->x, (stations + n)->y, pnode->pos);
+        pnode->nsta = n;
+    }
+
+    station_index_build(pindex->node, 0, pindex->num_nodes);
+
+    return (pindex->num_nodes);
+
+}
+
+/** function to collect stations of nodes [lo, hi) within distance sqrt(radius2) of pos */
+
+static void station_index_radius(StationIndexNode *node, int lo, int hi, double *pos, double radius, double radius2,
+        int *nsta_found, int *pnfound) {
+
+    int mid;
+    double dx, dy, dz, dsplit;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        dx = node[mid].pos[0] - pos[0];
+        dy = node[mid].pos[1] - pos[1];
+        dz = node[mid].pos[2] - pos[2];
+        if (dx * dx + dy * dy + dz * dz <= radius2)
+            nsta_found[(*pnfound)++] = node[mid].nsta;
+        dsplit = pos[node[mid].axis] - node[mid].pos[node[mid].axis];
+        if (dsplit <= radius && dsplit >= -radius) {
+            station_index_radius(node, lo, mid, pos, radius, radius2, nsta_found, pnfound);
+            lo = mid + 1;
+        } else if (dsplit < 0.0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+}
+
+/** function to compare station indices for qsort */
+
+static int compare_int(const void *pa, const void *pb) {
+    return (*((int *) pa) - *((int *) pb));
+}
+
+/** function to find indexed stations that may be within epicentral distance radius of an x-y location
+ *
+ *  nsta_found must have space for all indexed stations, station indices are returned in ascending order
+ *  the stations found include all stations with GetEpiDist() <= radius, and may include some stations slightly farther
+ *
+ *  returns number of stations found
+ */
+
+int FindStationsInRadius(StationIndex *pindex, double xval, double yval, double radius, int *nsta_found) {
+
+    int nfound = 0;
+    double pos[3];
+
+    station_index_pos(xval, yval, pos);
+    radius = radius * (1.0 + STATION_INDEX_TOL_REL) + STATION_INDEX_TOL_ABS;
+    station_index_radius(pindex->node, 0, pindex->num_nodes, pos, radius, radius * radius, nsta_found, &nfound);
+
+    qsort(nsta_found, nfound, sizeof (int), compare_int);
+
+    return (nfound);
+
+}
+
+/** function to find minimum hypocentral distance from position to stations of nodes [lo, hi) */
+
+static void station_index_min_hypo(StationIndexNode *node, int lo, int hi, double *pos, SourceDesc *stations,
+        double xval, double yval, double zval, double *phypo_dist_min) {
+
+    int mid;
+    double epi_dist, depth_diff, hypo_dist, dsplit;
+    SourceDesc *station;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        // same calculation as for all stations in getOctTreeStationDensityWeight()
+        station = stations + node[mid].nsta;
+        epi_dist = GetEpiDist(station, xval, yval);
+        depth_diff = zval - station->z;
+        hypo_dist = sqrt(epi_dist * epi_dist + depth_diff * depth_diff);
+        *phypo_dist_min = hypo_dist < *phypo_dist_min ? hypo_dist : *phypo_dist_min;
+        // search near side first, far side only if it may contain a closer station
+        dsplit = pos[node[mid].axis] - node[mid].pos[node[mid].axis];
+        if (dsplit < 0.0) {
+            station_index_min_hypo(node, lo, mid, pos, stations, xval, yval, zval, phypo_dist_min);
+            if (-dsplit > *phypo_dist_min * (1.0 + STATION_INDEX_TOL_REL) + STATION_INDEX_TOL_ABS)
+                return;
+            lo = mid + 1;
+        } else {
+            station_index_min_hypo(node, mid + 1, hi, pos, stations, xval, yval, zval, phypo_dist_min);
+            if (dsplit > *phypo_dist_min * (1.0 + STATION_INDEX_TOL_REL) + STATION_INDEX_TOL_ABS)
+                return;
+            hi = mid;
+        }
+    }
+
+}
+
+/** function to get minimum hypocentral distance from an x-y-z location to the indexed stations
+ *
+ *  returns VERY_LARGE_DOUBLE if no stations indexed
+ */
+
+double GetMinStationHypoDist(StationIndex *pindex, SourceDesc *stations, double xval, double yval, double zval) {
+
+    double pos[3], hypo_dist_min = VERY_LARGE_DOUBLE;
+
+    station_index_pos(xval, yval, pos);
+    station_index_min_hypo(pindex->node, 0, pindex->num_nodes, pos, stations, xval, yval, zval, &hypo_dist_min);
+
+    return (hypo_dist_min);
+
+}
+
+/** function to free station index */
+
+void FreeStationIndex(StationIndex *pindex) {
+
+    free(pindex->node);
+    pindex->node = NULL;
+    pindex->num_nodes = pindex->max_num_nodes = 0;
+
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 1999-2026 Anthony Lomax <anthony@alomax.net, http://www.alomax.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser Public License for more details.
+
+ * You should have received a copy of the GNU Lesser Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+/* nll_writer.c
+
+   Queued output writer, see nll_writer.h
+
+ */
+
+/*	history:
+
+	20261018 AJL - Original version
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef NLL_USE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "nll_writer.h"
+
+
+#define DEFAULT_MAX_QUEUED_BYTES (64 * 1024 * 1024)
+
+typedef struct NllWriterBlock {
+    FILE *fpout;
+    char *buf;
+    size_t size;
+    struct NllWriterBlock *next;
+}
+NllWriterBlock;
+
+struct NllWriter {
+    NllWriterBlock *head, *tail; // queue of blocks to write, in order
+    size_t queued_bytes;
+    size_t max_queued_bytes;
+    int nerror;
+#ifdef NLL_USE_PTHREADS
+    int stop;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_queued; // signalled when block queued or stop requested
+    pthread_cond_t cond_written; // signalled when block written
+#endif
+};
+
+
+/** write one block, flush file if no more blocks are waiting */
+
+static int write_block(NllWriterBlock *pblock, int flush) {
+
+    int istat = 0;
+
+    if (pblock->size > 0 && fwrite(pblock->buf, pblock->size, 1, pblock->fpout) != 1)
+        istat = -1;
+    if (flush && fflush(pblock->fpout) != 0)
+        istat = -1;
+    free(pblock->buf);
+    free(pblock);
+
+    return (istat);
+
+}
+
+
+#ifdef NLL_USE_PTHREADS
+
+/** background writer thread, writes queued blocks until stop requested and queue empty */
+
+static void *writer_thread(void *arg) {
+
+    NllWriter *pwriter = (NllWriter *) arg;
+    NllWriterBlock *pblock;
+    size_t size;
+    int flush, istat;
+
+    pthread_mutex_lock(&pwriter->mutex);
+    while (1) {
+        while (pwriter->head == NULL && !pwriter->stop)
+            pthread_cond_wait(&pwriter->cond_queued, &pwriter->mutex);
+        if (pwriter->head == NULL) // stop requested and nothing left to write
+            break;
+        pblock = pwriter->head;
+        pwriter->head = pblock->next;
+        if (pwriter->head == NULL)
+            pwriter->tail = NULL;
+        size = pblock->size;
+        flush = pwriter->head == NULL || pwriter->head->fpout != pblock->fpout;
+        pthread_mutex_unlock(&pwriter->mutex);
+        istat = write_block(pblock, flush);
+        pthread_mutex_lock(&pwriter->mutex);
+        if (istat < 0)
+            pwriter->nerror++;
+        pwriter->queued_bytes -= size;
+        pthread_cond_broadcast(&pwriter->cond_written);
+    }
+    pthread_mutex_unlock(&pwriter->mutex);
+
+    return (NULL);
+
+}
+
+#endif
+
+
+/** create writer */
+
+NllWriter *new_NllWriter(size_t max_queued_bytes) {
+
+    NllWriter *pwriter = calloc(1, sizeof (NllWriter));
+    if (pwriter == NULL)
+        return (NULL);
+
+    pwriter->max_queued_bytes = max_queued_bytes > 0 ? max_queued_bytes : DEFAULT_MAX_QUEUED_BYTES;
+
+#ifdef NLL_USE_PTHREADS
+    pthread_mutex_init(&pwriter->mutex, NULL);
+    pthread_cond_init(&pwriter->cond_queued, NULL);
+    pthread_cond_init(&pwriter->cond_written, NULL);
+    if (pthread_create(&pwriter->thread, NULL, writer_thread, pwriter) != 0) {
+        pthread_mutex_destroy(&pwriter->mutex);
+        pthread_cond_destroy(&pwriter->cond_queued);
+        pthread_cond_destroy(&pwriter->cond_written);
+        free(pwriter);
+        return (NULL);
+    }
+#endif
+
+    return (pwriter);
+
+}
+
+/** queue block to be appended to file */
+
+int NllWriter_write(NllWriter *pwriter, FILE *fpout, char *buf, size_t size) {
+
+    NllWriterBlock *pblock = malloc(sizeof (NllWriterBlock));
+    if (pblock == NULL) {
+        free(buf);
+        return (-1);
+    }
+    pblock->fpout = fpout;
+    pblock->buf = buf;
+    pblock->size = size;
+    pblock->next = NULL;
+
+#ifdef NLL_USE_PTHREADS
+
+    int istat;
+
+    pthread_mutex_lock(&pwriter->mutex);
+    // limit memory used by blocks waiting to be written, a single large block is always accepted
+    while (pwriter->queued_bytes > 0 && pwriter->queued_bytes + size > pwriter->max_queued_bytes)
+        pthread_cond_wait(&pwriter->cond_written, &pwriter->mutex);
+    if (pwriter->tail == NULL)
+        pwriter->head = pblock;
+    else
+        pwriter->tail->next = pblock;
+    pwriter->tail = pblock;
+    pwriter->queued_bytes += size;
+    istat = pwriter->nerror ? -1 : 0;
+    pthread_cond_signal(&pwriter->cond_queued);
+    pthread_mutex_unlock(&pwriter->mutex);
+
+    return (istat);
+
+#else
+
+    if (write_block(pblock, 0) < 0)
+        pwriter->nerror++;
+
+    return (pwriter->nerror ? -1 : 0);
+
+#endif
+
+}
+
+/** write all queued blocks and free writer */
+
+int free_NllWriter(NllWriter *pwriter) {
+
+    int istat;
+
+    if (pwriter == NULL)
+        return (0);
+
+#ifdef NLL_USE_PTHREADS
+    pthread_mutex_lock(&pwriter->mutex);
+    pwriter->stop = 1;
+    pthread_cond_signal(&pwriter->cond_queued);
+    pthread_mutex_unlock(&pwriter->mutex);
+    pthread_join(pwriter->thread, NULL);
+    pthread_mutex_destroy(&pwriter->mutex);
+    pthread_cond_destroy(&pwriter->cond_queued);
+    pthread_cond_destroy(&pwriter->cond_written);
+#endif
+
+    istat = pwriter->nerror ? -1 : 0;
+    free(pwriter);
+
+    return (istat);
+
+}
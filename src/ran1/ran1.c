@@ -2,6 +2,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 #include "ran1.h"
 
 
@@ -232,3 +233,93 @@ void rinit(int ijkl)
 }
 
 
+
+
+
+
+/*//////// random number streams */
+
+
+/*** function to get next splitmix64 value, used to seed streams */
+
+static unsigned long long splitmix64(unsigned long long *px)
+{
+	unsigned long long z;
+
+	z = (*px += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return( z ^ (z >> 31) );
+}
+
+
+/*** function to initialize random number stream nstream for seed */
+
+void rand_stream_init(RandStream *pstream, long seed, long nstream)
+{
+	unsigned long long x;
+	int n;
+
+	x = (unsigned long long) seed;
+	x = splitmix64(&x) ^ (unsigned long long) nstream;
+	for (n = 0; n < 4; n++)
+		pstream->state[n] = splitmix64(&x);
+	pstream->iset_normal = 0;
+	pstream->gset_normal = 0.0;
+}
+
+
+/*** function to get next 64 bit value of random number stream (xoshiro256**) */
+
+static unsigned long long rand_stream_next(RandStream *pstream)
+{
+	unsigned long long *s = pstream->state;
+	unsigned long long result, t;
+
+	result = s[1] * 5;
+	result = ((result << 7) | (result >> 57)) * 9;
+	t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = (s[3] << 45) | (s[3] >> 19);
+
+	return(result);
+}
+
+
+/*** function to get random double between xmin and xmax from random number stream */
+
+double rand_stream_double(RandStream *pstream, const double xmin, const double xmax)
+{
+
+	return( xmin + (double) (rand_stream_next(pstream) >> 11) * (1.0 / 9007199254740992.0)
+		* (xmax - xmin) );
+}
+
+
+/*** function to get normal deviate with zero mean and unit variance from random number stream
+	(polar Box-Muller as normal_dist_deviate()) */
+
+double rand_stream_normal(RandStream *pstream)
+{
+	double fac, r, v1, v2;
+
+	if (pstream->iset_normal) {
+		pstream->iset_normal = 0;
+		return(pstream->gset_normal);
+	}
+
+	do {
+		v1 = rand_stream_double(pstream, -1.0, 1.0);
+		v2 = rand_stream_double(pstream, -1.0, 1.0);
+		r = v1 * v1 + v2 * v2;
+	} while (r >= 1.0 || r == 0.0);
+	fac = sqrt(-2.0 * log(r) / r);
+	pstream->gset_normal = v1 * fac;
+	pstream->iset_normal = 1;
+
+	return(v2 * fac);
+}
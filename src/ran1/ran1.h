@@ -64,4 +64,21 @@ void rstart(int i, int j, int k, int l);
 void rinit(int ijkl);
 
 
+
+/*//////// random number streams */
+
+/* 20261018 AJL - reentrant generator (xoshiro256**) with independent streams, for reproducible random
+   sequences generated in parallel; each stream is seeded with splitmix64 from a seed and a stream index */
+
+typedef struct {
+	unsigned long long state[4];
+	int iset_normal;	/* normal deviate pair: 1 = second deviate saved in gset_normal */
+	double gset_normal;
+} RandStream;
+
+void rand_stream_init(RandStream *pstream, long seed, long nstream);
+double rand_stream_double(RandStream *pstream, const double xmin, const double xmax);
+double rand_stream_normal(RandStream *pstream);
+
+
 #endif
@@ -42,6 +42,7 @@ tel: +33(0)493752502  e-mail: anthony@alomax.net  web: http://www.alomax.net
 
 
 #include "GridLib.h"
+#include "nll_scat.h"
 
 
 /* defines */
@@ -111,16 +112,19 @@ int ConvertScat(int argc, char** argv) {
 
     int istat;
     int num_decim;
-    int n, npt, npoints;
+    int n, npt, npoints, nblock, nsamples_block, nconvert;
     long num_points_tot = 0L, num_points_read = 0L, num_points_written = 0L;
 
     char *pchr;
     char filename[FILENAME_MAX];
     char fn_scatter[FILENAME_MAX];
     char fn_root_out[FILENAME_MAX], fn_hypos_in[FILENAME_MAX], fn_scat_out[FILENAME_MAX];
-    FILE *fp_hypo, *fp_scat_out, *fp_scat_in;
-    float fdata[4], probmax = -VERY_LARGE_FLOAT;
-    double dlat, dlon;
+    FILE *fp_hypo, *fp_scat_out;
+    float probmax = -VERY_LARGE_FLOAT;
+    // 20261018 AJL - scatter samples read and converted in blocks, compressed scatter containers (.scatz) supported
+    ScatterReader *scat_reader;
+    static float fblock[4 * SCAT_BLOCK_NSAMPLES];
+    static double dlat[SCAT_BLOCK_NSAMPLES], dlon[SCAT_BLOCK_NSAMPLES];
 
     int nFile, numFiles, nLocAccepted;
     // make fn_hyp_in_list static to avoid stack overflow problem (F Tilmann) //
@@ -239,9 +243,8 @@ int ConvertScat(int argc, char** argv) {
                 pchr = strstr(fn_scatter, test_str);
                 if (pchr != NULL)
                     *pchr = '\0';
-                strcat(fn_scatter, ".scat\0");
-                if ((fp_scat_in = fopen(fn_scatter, "r")) == NULL) {
-                    nll_puterr2("ERROR: opening scatter file", fn_scatter);
+                if ((scat_reader = OpenEventScatterReader(fn_scatter, filename)) == NULL) {
+                    nll_puterr2("ERROR: opening scatter file", filename);
                     continue;
                 }
 
@@ -249,37 +252,42 @@ int ConvertScat(int argc, char** argv) {
 
 
                 // read header record
-                fseek(fp_scat_in, 0, SEEK_SET);
-                fread(&npoints, sizeof (int), 1, fp_scat_in);
+                npoints = scat_reader->nsamples;
 
-                // skip header record
-                fseek(fp_scat_in, 4 * sizeof (float), SEEK_SET);
-
-                // copy date records
+                // copy date records, every num_decim'th sample
                 /*fprintf(stdout, "  Summing %d samples...\n", npoints);*/
-                for (npt = 0; npt < npoints; npt += num_decim) {
-
-                    if ((istat = fread(fdata, sizeof (float), 4, fp_scat_in)) != 4) {
-                        sprintf(MsgStr, "ERROR: freed = %d != 4!!! (%d/%d)", istat, npt, npoints);
-                        nll_puterr(MsgStr);
+                npt = 0;
+                while ((nsamples_block = ReadScatterBlock(scat_reader, fblock)) > 0) {
+
+                    // decimated samples packed at start of block for conversion
+                    nconvert = 0;
+                    for (nblock = (num_decim - npt % num_decim) % num_decim; nblock < nsamples_block; nblock += num_decim) {
+                        memmove(fblock + 4 * nconvert, fblock + 4 * nblock, 4 * sizeof (float));
+                        nconvert++;
                     }
-                    num_points_read++;
-                    fseek(fp_scat_in, (num_decim - 1) * 4 * sizeof (float),
-                            SEEK_CUR);
+                    npt += nsamples_block;
+                    num_points_read += nconvert;
 
-                    if (fdata[3] > probmax)
-                        probmax = fdata[3];
+                    ScatterRect2LatLon(n_proj, fblock, nconvert, dlat, dlon);
 
-                    istat = rect2latlon(n_proj, fdata[0], fdata[1], &dlat, &dlon);
-                    //fprintf(fp_scat_out, "%9.4lf %9.4lf %9.4lf  0 %9.2le\n", dlat, dlon, fdata[2], fdata[3]);
-                    fprintf(fp_scat_out, "%f %f %f  0.001  %e\n", dlat, dlon, fdata[2], fdata[3]);
+                    for (n = 0; n < nconvert; n++) {
+                        float *fdata = fblock + 4 * n;
+                        if (fdata[3] > probmax)
+                            probmax = fdata[3];
+                        //fprintf(fp_scat_out, "%9.4lf %9.4lf %9.4lf  0 %9.2le\n", dlat[n], dlon[n], fdata[2], fdata[3]);
+                        fprintf(fp_scat_out, "%f %f %f  0.001  %e\n", dlat[n], dlon[n], fdata[2], fdata[3]);
+                    }
 
-                    num_points_written++;
+                    num_points_written += nconvert;
+                }
+                if (nsamples_block < 0) {
+                    sprintf(MsgStr, "ERROR: reading scatter file: %s (%d/%d)", filename, npt, npoints);
+                    nll_puterr(MsgStr);
                 }
 
                 num_points_tot += npoints;
 
-                fclose(fp_scat_in);
+                CloseScatterReader(scat_reader);
             }
 
 
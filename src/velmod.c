@@ -90,6 +90,8 @@ char vfile_name[MAXFILE]; /* vgrid file name */
 double vmodel_vmean;
 
 int Get2Dto3DTrans(char* input_line);
+static double poly_elem_vel(struct polygon *addr, double zpos, char wavetype, double* density, int iden, int *imodel);
+static double solid_elem_vel(struct solid *addr, double zpos, char wavetype, double *density, int iden);
 
 /*** function to read velocity model input */
 
@@ -2008,6 +2010,267 @@ int set_solid_limits(struct solid *addr) {
 
 }
 
+/*------------------------------------------------------------------------*/
+/* 20261018 AJL - spatial index of polygon and solid model elements
+
+        Elements are binned by their x and y limits (x only for 2D polygons) in a uniform
+        grid of cells over the limits of all elements. For a model column (fixed x, y) the
+        elements whose x and y limits contain the column are gathered once from the cell
+        containing the column and are reused for successive z values along the column
+        (e.g. the inner z loop of Vel2Grid). Candidates are kept in list order, so the
+        element found is the same as with a scan of the full element list.
+ */
+
+#define MAX_INDEX_CELLS_1D 4096
+
+struct elem_index {
+    int num_elem; /* number of elements indexed, 0 = no index */
+    void **elem; /* elements in list order */
+    double *limits; /* xmin, xmax, ymin, ymax of each element */
+    int use_y; /* 0 = index on x only */
+    int nx, ny;
+    double xmin, ymin, dx, dy;
+    int *cell_start; /* elements of cell n are cell_elem[cell_start[n]] to cell_elem[cell_start[n + 1] - 1] */
+    int *cell_elem;
+    int id; /* changes each time an index is built */
+};
+
+struct elem_column {
+    int id; /* id of index used to gather column */
+    double x, y;
+    int num, size;
+    int *elem; /* indices of elements with x and y limits containing column */
+};
+
+static struct elem_index solid_index, poly_index;
+static int elem_index_id;
+static struct elem_column solid_column, poly_column;
+#ifdef _OPENMP
+#pragma omp threadprivate(solid_column, poly_column)
+#endif
+
+static int elem_index_cell(double val, double vmin, double dval, int nval) {
+
+    int ival;
+
+    ival = (int) floor((val - vmin) / dval);
+    if (ival < 0)
+        ival = 0;
+    else if (ival >= nval)
+        ival = nval - 1;
+
+    return (ival);
+}
+
+static void free_elem_index(struct elem_index *pindex) {
+
+    free(pindex->elem);
+    free(pindex->limits);
+    free(pindex->cell_start);
+    free(pindex->cell_elem);
+    memset(pindex, 0, sizeof (struct elem_index));
+
+}
+
+/** function to bin elements in a uniform grid of cells, elem and limits are taken over by the index */
+
+static int build_elem_index(struct elem_index *pindex, void **elem, double *limits, int num_elem, int use_y) {
+
+    int n, ix, iy, ix0, ix1, iy0, iy1, ncell, nfill, *fill;
+    double xmax, ymax;
+
+    free_elem_index(pindex);
+    pindex->elem = elem;
+    pindex->limits = limits;
+    pindex->use_y = use_y;
+
+    pindex->xmin = pindex->ymin = REAL_MAX;
+    xmax = ymax = -REAL_MAX;
+    for (n = 0; n < num_elem; n++) {
+        if (limits[4 * n] < pindex->xmin)
+            pindex->xmin = limits[4 * n];
+        if (limits[4 * n + 1] > xmax)
+            xmax = limits[4 * n + 1];
+        if (limits[4 * n + 2] < pindex->ymin)
+            pindex->ymin = limits[4 * n + 2];
+        if (limits[4 * n + 3] > ymax)
+            ymax = limits[4 * n + 3];
+    }
+
+    /* about one element per cell */
+    if (use_y) {
+        pindex->nx = pindex->ny = (int) ceil(sqrt((double) num_elem));
+        if (pindex->nx > MAX_INDEX_CELLS_1D / 4)
+            pindex->nx = pindex->ny = MAX_INDEX_CELLS_1D / 4;
+    } else {
+        pindex->nx = num_elem < MAX_INDEX_CELLS_1D ? num_elem : MAX_INDEX_CELLS_1D;
+        pindex->ny = 1;
+    }
+    if ((pindex->dx = (xmax - pindex->xmin) / (double) pindex->nx) <= 0.0) {
+        pindex->nx = 1;
+        pindex->dx = 1.0;
+    }
+    if (!use_y || (pindex->dy = (ymax - pindex->ymin) / (double) pindex->ny) <= 0.0) {
+        pindex->ny = 1;
+        pindex->dy = 1.0;
+    }
+    ncell = pindex->nx * pindex->ny;
+
+    /* count elements in each cell, then fill cells in element (list) order */
+    if ((pindex->cell_start = (int *) calloc(ncell + 1, sizeof (int))) == NULL
+            || (fill = (int *) calloc(ncell, sizeof (int))) == NULL)
+        return (-1);
+    for (nfill = 0; nfill < 2; nfill++) {
+        for (n = 0; n < num_elem; n++) {
+            ix0 = elem_index_cell(limits[4 * n], pindex->xmin, pindex->dx, pindex->nx);
+            ix1 = elem_index_cell(limits[4 * n + 1], pindex->xmin, pindex->dx, pindex->nx);
+            iy0 = iy1 = 0;
+            if (pindex->ny > 1) {
+                iy0 = elem_index_cell(limits[4 * n + 2], pindex->ymin, pindex->dy, pindex->ny);
+                iy1 = elem_index_cell(limits[4 * n + 3], pindex->ymin, pindex->dy, pindex->ny);
+            }
+            for (ix = ix0; ix <= ix1; ix++) {
+                for (iy = iy0; iy <= iy1; iy++) {
+                    if (nfill == 0)
+                        pindex->cell_start[ix * pindex->ny + iy + 1]++;
+                    else
+                        pindex->cell_elem[pindex->cell_start[ix * pindex->ny + iy] + fill[ix * pindex->ny + iy]++] = n;
+                }
+            }
+        }
+        if (nfill == 0) {
+            for (n = 0; n < ncell; n++)
+                pindex->cell_start[n + 1] += pindex->cell_start[n];
+            if ((pindex->cell_elem = (int *) malloc((pindex->cell_start[ncell] + 1) * sizeof (int))) == NULL) {
+                free(fill);
+                return (-1);
+            }
+        }
+    }
+    free(fill);
+
+    pindex->num_elem = num_elem;
+    pindex->id = ++elem_index_id;
+
+    return (0);
+
+}
+
+/** function to get the elements with x and y limits containing a model column, returns NULL on memory error */
+
+static struct elem_column *get_elem_column(struct elem_index *pindex, struct elem_column *pcol, double x, double y) {
+
+    int n, ncell, *pelem, *pelem_end;
+    double *plim;
+
+    if (pcol->id == pindex->id && pcol->x == x && pcol->y == y)
+        return (pcol);
+
+    if (pcol->size < pindex->num_elem) {
+        free(pcol->elem);
+        pcol->size = 0;
+        if ((pcol->elem = (int *) malloc(pindex->num_elem * sizeof (int))) == NULL)
+            return (NULL);
+        pcol->size = pindex->num_elem;
+    }
+
+    ncell = elem_index_cell(x, pindex->xmin, pindex->dx, pindex->nx) * pindex->ny;
+    if (pindex->ny > 1)
+        ncell += elem_index_cell(y, pindex->ymin, pindex->dy, pindex->ny);
+    pcol->num = 0;
+    pelem_end = pindex->cell_elem + pindex->cell_start[ncell + 1];
+    for (pelem = pindex->cell_elem + pindex->cell_start[ncell]; pelem < pelem_end; pelem++) {
+        n = *pelem;
+        plim = pindex->limits + 4 * n;
+        if (x >= plim[0] && x <= plim[1]
+                && (!pindex->use_y || (y >= plim[2] && y <= plim[3])))
+            pcol->elem[pcol->num++] = n;
+    }
+
+    pcol->id = pindex->id;
+    pcol->x = x;
+    pcol->y = y;
+
+    return (pcol);
+
+}
+
+/** function to build spatial indexes of the polygon and solid models
+ *
+ *  call once after the model is read, get_poly_vel() and get_solid_vel() use the indexes if present
+ *  returns 0 on success, -1 on memory error (model elements are then scanned without index)
+ */
+
+int init_vel_model_index() {
+
+    int n, istat = 0;
+    void **elem;
+    double *limits;
+    struct solid *saddr;
+    struct polygon *paddr;
+
+    free_vel_model_index();
+
+    if (prog_mode_3d && num_solid > 0 && (saddr = solid_head) != NULL) {
+        elem = (void **) malloc(num_solid * sizeof (void *));
+        limits = (double *) malloc(4 * num_solid * sizeof (double));
+        if (elem == NULL || limits == NULL) {
+            free(elem);
+            free(limits);
+            return (-1);
+        }
+        n = 0;
+        do {
+            elem[n] = saddr;
+            limits[4 * n] = saddr->xmin;
+            limits[4 * n + 1] = saddr->xmax;
+            limits[4 * n + 2] = saddr->ymin;
+            limits[4 * n + 3] = saddr->ymax;
+            n++;
+        } while ((saddr = saddr->next) != solid_head && n < num_solid);
+        if (build_elem_index(&solid_index, elem, limits, n, 1) < 0) {
+            free_elem_index(&solid_index);
+            istat = -1;
+        }
+    }
+
+    // polygons are used in 2D mode or for a 2D model in 3D mode
+    if ((!prog_mode_3d || prog_mode_Mod2D3D) && num_poly > 0 && (paddr = poly_head) != NULL) {
+        elem = (void **) malloc(num_poly * sizeof (void *));
+        limits = (double *) malloc(4 * num_poly * sizeof (double));
+        if (elem == NULL || limits == NULL) {
+            free(elem);
+            free(limits);
+            return (-1);
+        }
+        n = 0;
+        do {
+            elem[n] = paddr;
+            limits[4 * n] = paddr->xmin;
+            limits[4 * n + 1] = paddr->xmax;
+            limits[4 * n + 2] = paddr->ymin;
+            limits[4 * n + 3] = paddr->ymax;
+            n++;
+        } while ((paddr = paddr->next) != poly_head && n < num_poly);
+        if (build_elem_index(&poly_index, elem, limits, n, 0) < 0) {
+            free_elem_index(&poly_index);
+            istat = -1;
+        }
+    }
+
+    return (istat);
+
+}
+
+/** function to free spatial indexes of the polygon and solid models */
+
+void free_vel_model_index() {
+
+    free_elem_index(&solid_index);
+    free_elem_index(&poly_index);
+
+}
+
 /*** function to calculate velocity from  polygon model for 2D to 3D case */
 
 double get_poly_vel_2D3D(double xpos, double ypos, double zpos, char wavetype,
@@ -2030,43 +2293,59 @@ double get_poly_vel_2D3D(double xpos, double ypos, double zpos, char wavetype,
 
 double get_poly_vel(double xpos, double zpos, char wavetype, double* density,
         int iden, int *imodel) {
-    double vel;
+    int n;
     struct polygon *addr;
+    struct elem_column *pcol;
 
 
     if ((addr = poly_head) == NULL) {
         return (-1.0);
     }
 
-
+    // 20261018 AJL - use spatial index if available
+    if (poly_index.num_elem > 0 && (pcol = get_elem_column(&poly_index, &poly_column, xpos, 0.0)) != NULL) {
+        for (n = 0; n < pcol->num; n++) {
+            addr = (struct polygon *) poly_index.elem[pcol->elem[n]];
+            if (zpos >= addr->zmin && zpos <= addr->zmax && inside_poly(xpos, zpos, addr))
+                return (poly_elem_vel(addr, zpos, wavetype, density, iden, imodel));
+        }
+        return (-1.0);
+    }
 
     do {
         if (xpos >= addr->xmin && xpos <= addr->xmax &&
                 zpos >= addr->zmin && zpos <= addr->zmax) {
 
-            if (inside_poly(xpos, zpos, addr)) {
+            if (inside_poly(xpos, zpos, addr))
+                return (poly_elem_vel(addr, zpos, wavetype, density, iden, imodel));
+        }
+    } while ((addr = addr->next) != poly_head);
+
+    return (-1.0);
+}
+
+/*** function to calculate velocity in a polygon */
 
-                if (wavetype == 'P')
-                    vel = addr->vpref +
-                        addr->vpgrad * (zpos - addr->ref);
-                else
-                    vel = addr->vsref +
-                        addr->vsgrad * (zpos - addr->ref);
+static double poly_elem_vel(struct polygon *addr, double zpos, char wavetype, double* density,
+        int iden, int *imodel) {
+    double vel;
 
-                if (iden == 1)
-                    *density = addr->denref +
-                        addr->dengrad * (zpos - addr->ref);
+    if (wavetype == 'P')
+        vel = addr->vpref +
+            addr->vpgrad * (zpos - addr->ref);
+    else
+        vel = addr->vsref +
+            addr->vsgrad * (zpos - addr->ref);
 
-                /* set model element code */
+    if (iden == 1)
+        *density = addr->denref +
+            addr->dengrad * (zpos - addr->ref);
 
-                *imodel = POLYOFFSET + addr->id_poly;
+    /* set model element code */
 
-                return (vel);
-            }
-        }
-    } while ((addr = addr->next) != poly_head);
+    *imodel = POLYOFFSET + addr->id_poly;
 
-    return (-1.0);
+    return (vel);
 }
 
 /*** function to determine if a point is inside a simple polygon */
@@ -2093,36 +2372,55 @@ struct polygon *addr;*/ {
 /*** function to calculate velocity from polygon model */
 
 double get_solid_vel(double xpos, double ypos, double zpos, char wavetype, double *density, int iden) {
-    double vel;
+    int n;
     struct solid *addr;
+    struct elem_column *pcol;
 
 
     if ((addr = solid_head) == NULL) {
         return (-1.0);
     }
 
+    // 20261018 AJL - use spatial index if available
+    if (solid_index.num_elem > 0 && (pcol = get_elem_column(&solid_index, &solid_column, xpos, ypos)) != NULL) {
+        for (n = 0; n < pcol->num; n++) {
+            addr = (struct solid *) solid_index.elem[pcol->elem[n]];
+            if (zpos >= addr->zmin && zpos <= addr->zmax && inside_solid(xpos, ypos, zpos, addr))
+                return (solid_elem_vel(addr, zpos, wavetype, density, iden));
+        }
+        return (-1.0);
+    }
+
     do {
         if (xpos >= addr->xmin && xpos <= addr->xmax &&
                 ypos >= addr->ymin && ypos <= addr->ymax &&
                 zpos >= addr->zmin && zpos <= addr->zmax) {
-            if (inside_solid(xpos, ypos, zpos, addr)) {
-                if (wavetype == 'P')
-                    vel = addr->vpref +
-                        addr->vpgrad * (zpos - addr->ref);
-                else
-                    vel = addr->vsref +
-                        addr->vsgrad * (zpos - addr->ref);
-                if (iden == 1)
-                    *density = addr->denref +
-                        addr->dengrad * (zpos - addr->ref);
-                return (vel);
-            }
+            if (inside_solid(xpos, ypos, zpos, addr))
+                return (solid_elem_vel(addr, zpos, wavetype, density, iden));
         }
     } while ((addr = addr->next) != solid_head);
 
     return (-1.0);
 }
 
+/*** function to calculate velocity in a solid */
+
+static double solid_elem_vel(struct solid *addr, double zpos, char wavetype, double *density, int iden) {
+    double vel;
+
+    if (wavetype == 'P')
+        vel = addr->vpref +
+            addr->vpgrad * (zpos - addr->ref);
+    else
+        vel = addr->vsref +
+            addr->vsgrad * (zpos - addr->ref);
+    if (iden == 1)
+        *density = addr->denref +
+            addr->dengrad * (zpos - addr->ref);
+
+    return (vel);
+}
+
 /*** function to determine if a point is inside a simple solid */
 
 int inside_solid(double xpt, double ypt, double zpt, struct solid *addr)